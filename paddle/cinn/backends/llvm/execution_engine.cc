@@ -15,6 +15,7 @@
 #include "paddle/cinn/backends/llvm/execution_engine.h"
 
 #include <absl/strings/string_view.h>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/ADT/Triple.h>
 #include <llvm/AsmParser/Parser.h>
 #include <llvm/Config/llvm-config.h>
@@ -34,8 +35,12 @@
 #include <llvm/PassRegistry.h>
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Host.h>
 #include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA1.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/TargetRegistry.h>
 #include <llvm/Support/TargetSelect.h>
@@ -48,6 +53,8 @@
 #include <llvm/Transforms/Scalar/Reassociate.h>
 #include <llvm/Transforms/Scalar/SimplifyCFG.h>
 
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <cmath>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -64,6 +71,10 @@
 #include "paddle/cinn/ir/ir_printer.h"
 #include "paddle/cinn/runtime/intrinsic.h"
 #include "paddle/cinn/utils/profiler.h"
+#include "paddle/common/flags.h"
+
+PD_DECLARE_string(cinn_llvm_object_cache_dir);
+PD_DECLARE_int64(cinn_llvm_object_cache_max_mb);
 
 namespace cinn::backends {
 namespace {
@@ -87,26 +98,212 @@ void InitializeLLVMPasses() {
   // llvm::initializeCodeGenPreparePass(registry);
 }
 }  // namespace
+ObjectCacheStats &ObjectCacheStats::Global() {
+  static ObjectCacheStats stats;
+  return stats;
+}
+
+NaiveObjectCache::NaiveObjectCache(const std::string &cache_dir,
+                                   int64_t max_disk_bytes)
+    : cache_dir_(cache_dir), max_disk_bytes_(max_disk_bytes) {
+  if (cache_dir_.empty()) return;
+  if (auto ec = llvm::sys::fs::create_directories(cache_dir_)) {
+    LOG(WARNING) << "Failed to create llvm object cache directory "
+                 << cache_dir_ << ": " << ec.message()
+                 << ", the disk cache is disabled.";
+    cache_dir_.clear();
+  }
+}
+
+std::string NaiveObjectCache::TargetKey(const llvm::TargetMachine &machine,
+                                        int ir_opt_level) {
+  return machine.getTargetTriple().str() + ";" +
+         machine.getTargetCPU().str() + ";" +
+         machine.getTargetFeatureString().str() + ";O" +
+         std::to_string(ir_opt_level) + ";CG" +
+         std::to_string(static_cast<int>(machine.getOptLevel()));
+}
+
+std::string NaiveObjectCache::ObjectKey(const llvm::Module *m,
+                                        const std::string &target_key) const {
+  // modules generated by CINN share the same identifier, so objects are
+  // keyed by the content of the module
+  std::string content;
+  llvm::raw_string_ostream os(content);
+  m->print(os, nullptr);
+  os << target_key << LLVM_VERSION_STRING;
+  os.flush();
+  return llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(content)),
+                     /*LowerCase=*/true);
+}
+
+std::string NaiveObjectCache::ObjectPath(const std::string &key) const {
+  llvm::SmallString<256> path(cache_dir_);
+  llvm::sys::path::append(path, key + ".o");
+  return std::string(path.str());
+}
+
+void NaiveObjectCache::notifyObjectCompiled(const llvm::Module *m,
+                                            llvm::MemoryBufferRef obj_buffer) {
+  notifyObjectCompiled(m, target_key_, obj_buffer);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(
+    const llvm::Module *m) {
+  return getObject(m, target_key_);
+}
+
 void NaiveObjectCache::notifyObjectCompiled(const llvm::Module *m,
+                                            const std::string &target_key,
                                             llvm::MemoryBufferRef obj_buffer) {
-  cached_objects_[m->getModuleIdentifier()] =
+  std::lock_guard<std::mutex> lock(mu_);
+  std::string key;
+  auto it = module_keys_.find(m);
+  if (it != module_keys_.end()) {
+    key = std::move(it->second);
+    module_keys_.erase(it);
+  } else {
+    key = ObjectKey(m, target_key);
+  }
+  cached_objects_[key] =
       llvm::MemoryBuffer::getMemBufferCopy(obj_buffer.getBuffer(),
                                            obj_buffer.getBufferIdentifier());
+  if (disk_cache_enabled()) {
+    SaveToDisk(key, obj_buffer);
+    EvictIfNeeded();
+  }
 }
 
 std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(
-    const llvm::Module *m) {
-  auto it = cached_objects_.find(m->getModuleIdentifier());
-  if (it == cached_objects_.end()) {
-    VLOG(1) << "No object for " << m->getModuleIdentifier()
-            << " in cache. Compiling.";
+    const llvm::Module *m, const std::string &target_key) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto &stats = ObjectCacheStats::Global();
+  // the key is computed for every lookup, a module at the address of a
+  // finished one never takes its key
+  std::string key = ObjectKey(m, target_key);
+  module_keys_.erase(m);
+  auto it = cached_objects_.find(key);
+  if (it != cached_objects_.end()) {
+    ++stats.memory_hits;
+    VLOG(3) << "Object for " << m->getModuleIdentifier()
+            << " loaded from cache.";
+    return llvm::MemoryBuffer::getMemBuffer(it->second->getMemBufferRef());
+  }
+
+  if (disk_cache_enabled()) {
+    auto obj = LoadFromDisk(key);
+    if (obj) {
+      ++stats.disk_hits;
+      VLOG(3) << "Object for " << m->getModuleIdentifier()
+              << " loaded from disk cache " << ObjectPath(key);
+      auto obj_ref = obj->getMemBufferRef();
+      cached_objects_[key] = std::move(obj);
+      return llvm::MemoryBuffer::getMemBuffer(obj_ref);
+    }
+  }
+
+  ++stats.misses;
+  module_keys_[m] = std::move(key);
+  VLOG(1) << "No object for " << m->getModuleIdentifier()
+          << " in cache. Compiling.";
+  return nullptr;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::LoadFromDisk(
+    const std::string &key) {
+  std::string path = ObjectPath(key);
+  auto obj = llvm::MemoryBuffer::getFile(path, /*FileSize=*/-1,
+                                         /*RequiresNullTerminator=*/false);
+  if (!obj) {
     return nullptr;
   }
+  // refresh the modification time, it's the LRU order of the eviction
+  int fd;
+  if (!llvm::sys::fs::openFileForWrite(
+          path, fd, llvm::sys::fs::CD_OpenExisting, llvm::sys::fs::OF_Append)) {
+    llvm::sys::fs::setLastAccessAndModificationTime(
+        fd, std::chrono::system_clock::now());
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+  }
+  return std::move(obj.get());
+}
+
+void NaiveObjectCache::SaveToDisk(const std::string &key,
+                                  llvm::MemoryBufferRef obj_buffer) {
+  std::string path = ObjectPath(key);
+  // write to a temporary file and rename it, so that concurrent processes
+  // never read a partial object
+  std::string tmp_path =
+      path + ".tmp." + std::to_string(llvm::sys::Process::getProcessId());
+  {
+    std::error_code ec;
+    llvm::raw_fd_ostream os(tmp_path, ec, llvm::sys::fs::OF_None);
+    if (ec) {
+      LOG(WARNING) << "Failed to write llvm object cache " << tmp_path << ": "
+                   << ec.message();
+      return;
+    }
+    os << obj_buffer.getBuffer();
+    os.close();
+    if (os.has_error()) {
+      os.clear_error();
+      llvm::sys::fs::remove(tmp_path);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(tmp_path, path)) {
+    llvm::sys::fs::remove(tmp_path);
+  }
+}
 
-  VLOG(3) << "Object for " << m->getModuleIdentifier() << " loaded from cache.";
-  return llvm::MemoryBuffer::getMemBuffer(it->second->getMemBufferRef());
+void NaiveObjectCache::EvictIfNeeded() {
+  if (max_disk_bytes_ <= 0) return;
+  struct CacheFile {
+    std::string path;
+    uint64_t size;
+    llvm::sys::TimePoint<> mtime;
+  };
+  std::vector<CacheFile> files;
+  uint64_t total_bytes = 0;
+  std::error_code ec;
+  for (llvm::sys::fs::directory_iterator it(cache_dir_, ec), end;
+       it != end && !ec;
+       it.increment(ec)) {
+    if (llvm::sys::path::extension(it->path()) != ".o") continue;
+    llvm::sys::fs::file_status status;
+    if (llvm::sys::fs::status(it->path(), status)) continue;
+    files.push_back(
+        {it->path(), status.getSize(), status.getLastModificationTime()});
+    total_bytes += status.getSize();
+  }
+  if (total_bytes <= static_cast<uint64_t>(max_disk_bytes_)) return;
+
+  std::sort(files.begin(),
+            files.end(),
+            [](const CacheFile &a, const CacheFile &b) {
+              return a.mtime < b.mtime;
+            });
+  // evict to 90% of the limit to avoid scanning the directory on every insert
+  uint64_t target_bytes = static_cast<uint64_t>(max_disk_bytes_) / 10 * 9;
+  for (auto &file : files) {
+    if (total_bytes <= target_bytes) break;
+    if (!llvm::sys::fs::remove(file.path)) {
+      total_bytes -= file.size;
+      ++ObjectCacheStats::Global().evictions;
+      VLOG(3) << "Evict llvm object cache " << file.path;
+    }
+  }
 }
 
+ExecutionEngine::ExecutionEngine(bool enable_object_cache,
+                                 RuntimeSymbols &&module_symbols)
+    : cache_(enable_object_cache
+                 ? std::make_unique<NaiveObjectCache>(
+                       FLAGS_cinn_llvm_object_cache_dir,
+                       FLAGS_cinn_llvm_object_cache_max_mb * 1024 * 1024)
+                 : std::make_unique<NaiveObjectCache>()),
+      module_symbols_(std::move(module_symbols)) {}
+
 /*static*/ std::unique_ptr<ExecutionEngine> ExecutionEngine::Create(
     const ExecutionOptions &config) {
   return Create(config, {});
@@ -125,15 +322,24 @@ std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(
 
   auto engine = std::make_unique<ExecutionEngine>(/*enable_object_cache=*/true,
                                                   std::move(module_symbols));
+  engine->opt_level_ = config.opt_level;
+  engine->link_machine_ = llvm::cantFail(
+      llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost())
+          .createTargetMachine());
+  engine->link_target_key_ =
+      NaiveObjectCache::TargetKey(*engine->link_machine_, engine->opt_level_);
 
   auto compile_layer_creator =
-      [&engine](llvm::orc::JITTargetMachineBuilder jtmb)
+      [&engine, &config](llvm::orc::JITTargetMachineBuilder jtmb)
       -> llvm::Expected<
           std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
     auto machine = llvm::cantFail(jtmb.createTargetMachine());
     VLOG(1) << "create llvm compile layer";
     VLOG(1) << "Target Name: " << machine->getTarget().getName();
     VLOG(1) << "Target CPU: " << machine->getTargetCPU().str() << std::endl;
+    // the modules added to the jit are compiled without ir optimization
+    engine->cache_->SetTargetKey(
+        NaiveObjectCache::TargetKey(*machine, /*ir_opt_level=*/0));
     return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(
         std::move(machine), engine->cache_.get());
   };
@@ -183,24 +389,38 @@ void ExecutionEngine::Link(const ir::Module &module) {
   VLOG(3) << "ir_emitter->Compile(module) Succeed!";
   CHECK(!llvm::verifyModule(*m, &llvm::errs())) << "Invalid module found";
 
-  auto machine = std::move(llvm::cantFail(
-      llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost())
-          .createTargetMachine()));
-  LLVMModuleOptimizer optimize(machine.get(), 3, {}, true);
-  optimize(m.get());
-  CHECK(!llvm::verifyModule(*m, &llvm::errs()))
-      << "Invalid optimized module detected";
-  for (auto &f : *m) {
-    VLOG(5) << "function: " << DumpToString(f);
-  }
+  // The object is looked up by the unoptimized module, so that a cached
+  // object skips both the optimization and the codegen. It's added to the jit
+  // directly, the module is never compiled twice.
+  m->setDataLayout(jit_->getDataLayout());
+  auto obj = cache_->getObject(m.get(), link_target_key_);
+  if (!obj) {
+    llvm::TargetMachine *machine = link_machine_.get();
+    LLVMModuleOptimizer optimize(machine, opt_level_, {}, true);
+    optimize(m.get());
+    CHECK(!llvm::verifyModule(*m, &llvm::errs()))
+        << "Invalid optimized module detected";
+    for (auto &f : *m) {
+      VLOG(5) << "function: " << DumpToString(f);
+    }
 
-  llvm::raw_svector_ostream rawstream(buffer_);
-  llvm::legacy::PassManager pass_manager;
-  machine->addPassesToEmitFile(
-      pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
-  pass_manager.run(*m);
+    buffer_.clear();
+    llvm::raw_svector_ostream rawstream(buffer_);
+    llvm::legacy::PassManager pass_manager;
+    machine->addPassesToEmitFile(
+        pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
+    pass_manager.run(*m);
+    llvm::MemoryBufferRef obj_ref(
+        llvm::StringRef(buffer_.data(), buffer_.size()),
+        m->getModuleIdentifier());
+    cache_->notifyObjectCompiled(m.get(), link_target_key_, obj_ref);
+    obj = llvm::MemoryBuffer::getMemBufferCopy(obj_ref.getBuffer(),
+                                               obj_ref.getBufferIdentifier());
+  } else {
+    buffer_.assign(obj->getBufferStart(), obj->getBufferEnd());
+  }
 
-  CHECK(AddModule(std::move(m), std::move(ctx)));
+  llvm::cantFail(jit_->addObjectFile(std::move(obj)));
 
   if (VLOG_IS_ON(5)) {
     VLOG(5) << "======= dump jit execution session ======";
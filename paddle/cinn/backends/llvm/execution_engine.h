@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
@@ -35,7 +36,9 @@
 #include <llvm/Support/SmallVectorMemoryBuffer.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -50,14 +53,70 @@
 
 namespace cinn::backends {
 
+struct ObjectCacheStats {
+  std::atomic<int64_t> memory_hits{0};
+  std::atomic<int64_t> disk_hits{0};
+  std::atomic<int64_t> misses{0};
+  std::atomic<int64_t> evictions{0};
+
+  // Statistics accumulated by all the object caches of the process.
+  static ObjectCacheStats &Global();
+};
+
+/**
+ * Object cache of the ExecutionEngine. Compiled objects are always kept in
+ * memory. If `cache_dir` is not empty, they are also persisted on disk,
+ * content-addressed by the module IR, the target machine, the LLVM version
+ * and the optimization options, so that a restarted process can skip the
+ * LLVM codegen. The disk cache is bounded by `max_disk_bytes`, least recently
+ * used objects are evicted first.
+ */
 class NaiveObjectCache : public llvm::ObjectCache {
  public:
+  NaiveObjectCache() = default;
+  NaiveObjectCache(const std::string &cache_dir, int64_t max_disk_bytes);
+
+  // The objects compiled by the jit, keyed by the target key set.
   void notifyObjectCompiled(const llvm::Module *,
                             llvm::MemoryBufferRef) override;
   std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *) override;
 
+  // The objects compiled with another target machine or optimization than
+  // the jit, keyed by target_key.
+  void notifyObjectCompiled(const llvm::Module *m,
+                            const std::string &target_key,
+                            llvm::MemoryBufferRef obj_buffer);
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *m,
+                                                const std::string &target_key);
+
+  // Describes the target machine and options the objects of the jit are
+  // generated for, it's part of the disk cache key.
+  void SetTargetKey(const std::string &target_key) { target_key_ = target_key; }
+
+  // The target key of the objects generated by machine from the modules
+  // optimized at ir_opt_level.
+  static std::string TargetKey(const llvm::TargetMachine &machine,
+                               int ir_opt_level);
+
+  bool disk_cache_enabled() const { return !cache_dir_.empty(); }
+
  private:
+  std::string ObjectKey(const llvm::Module *m,
+                        const std::string &target_key) const;
+  std::string ObjectPath(const std::string &key) const;
+  std::unique_ptr<llvm::MemoryBuffer> LoadFromDisk(const std::string &key);
+  void SaveToDisk(const std::string &key, llvm::MemoryBufferRef obj_buffer);
+  void EvictIfNeeded();
+
+  std::mutex mu_;
+  std::string cache_dir_;
+  int64_t max_disk_bytes_{0};
+  std::string target_key_;
   llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> cached_objects_;
+  // The keys of the modules looked up but not compiled yet, the codegen may
+  // change a module before it's notified. An entry is set by every miss of
+  // getObject and erased by the hit or the notification of the module.
+  llvm::DenseMap<const llvm::Module *, std::string> module_keys_;
 };
 
 struct ExecutionOptions {
@@ -88,9 +147,7 @@ class ExecutionEngine {
 
  protected:
   explicit ExecutionEngine(bool enable_object_cache,
-                           RuntimeSymbols &&module_symbols)
-      : cache_(std::make_unique<NaiveObjectCache>()),
-        module_symbols_(std::move(module_symbols)) {}
+                           RuntimeSymbols &&module_symbols);
 
   void RegisterRuntimeSymbols();
 
@@ -106,6 +163,11 @@ class ExecutionEngine {
   std::unique_ptr<llvm::orc::LLJIT> jit_;
   std::unique_ptr<NaiveObjectCache> cache_;
   RuntimeSymbols module_symbols_;
+  // The optimization level, the target machine and the object cache key of
+  // the modules of Link.
+  int opt_level_{3};
+  std::unique_ptr<llvm::TargetMachine> link_machine_;
+  std::string link_target_key_;
 };
 
 }  // namespace cinn::backends
@@ -0,0 +1,142 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/FileSystem.h>
+
+#include <memory>
+#include <string>
+
+#include "paddle/cinn/backends/llvm/execution_engine.h"
+
+namespace cinn {
+namespace backends {
+
+namespace {
+std::unique_ptr<llvm::Module> CreateModule(llvm::LLVMContext *ctx,
+                                           int return_value) {
+  auto m = std::make_unique<llvm::Module>("object_cache_test", *ctx);
+  auto *fn_type = llvm::FunctionType::get(llvm::Type::getInt32Ty(*ctx), false);
+  auto *fn = llvm::Function::Create(
+      fn_type, llvm::Function::ExternalLinkage, "fn", m.get());
+  llvm::IRBuilder<> builder(llvm::BasicBlock::Create(*ctx, "entry", fn));
+  builder.CreateRet(builder.getInt32(return_value));
+  return m;
+}
+
+std::string CreateCacheDir(const std::string &name) {
+  llvm::SmallString<128> dir;
+  llvm::sys::fs::createUniqueDirectory(name, dir);
+  return std::string(dir.str());
+}
+}  // namespace
+
+TEST(NaiveObjectCache, memory) {
+  llvm::LLVMContext ctx;
+  auto m0 = CreateModule(&ctx, 0);
+  auto m1 = CreateModule(&ctx, 1);
+
+  NaiveObjectCache cache;
+  ASSERT_FALSE(cache.disk_cache_enabled());
+  ASSERT_EQ(cache.getObject(m0.get()), nullptr);
+  cache.notifyObjectCompiled(
+      m0.get(), llvm::MemoryBufferRef("object0", "object_cache_test"));
+
+  auto obj = cache.getObject(m0.get());
+  ASSERT_NE(obj, nullptr);
+  ASSERT_EQ(obj->getBuffer().str(), "object0");
+  // same identifier with different content must not hit
+  ASSERT_EQ(cache.getObject(m1.get()), nullptr);
+}
+
+TEST(NaiveObjectCache, target_key) {
+  llvm::LLVMContext ctx;
+  auto m0 = CreateModule(&ctx, 0);
+
+  NaiveObjectCache cache;
+  ASSERT_EQ(cache.getObject(m0.get(), "x86_64;O3"), nullptr);
+  cache.notifyObjectCompiled(
+      m0.get(), "x86_64;O3", llvm::MemoryBufferRef("object0", "test"));
+  ASSERT_NE(cache.getObject(m0.get(), "x86_64;O3"), nullptr);
+  // the objects of another target key, e.g. of the jit, are not reused
+  ASSERT_EQ(cache.getObject(m0.get(), "x86_64;O0"), nullptr);
+  ASSERT_EQ(cache.getObject(m0.get()), nullptr);
+}
+
+TEST(NaiveObjectCache, disk) {
+  std::string cache_dir = CreateCacheDir("cinn_object_cache_test");
+  llvm::LLVMContext ctx;
+  auto m0 = CreateModule(&ctx, 0);
+
+  int64_t disk_hits = ObjectCacheStats::Global().disk_hits;
+  {
+    NaiveObjectCache cache(cache_dir, 1024 * 1024);
+    cache.SetTargetKey("x86_64;O3");
+    ASSERT_TRUE(cache.disk_cache_enabled());
+    ASSERT_EQ(cache.getObject(m0.get()), nullptr);
+    cache.notifyObjectCompiled(
+        m0.get(), llvm::MemoryBufferRef("object0", "object_cache_test"));
+  }
+  {
+    // a new cache, e.g. in a restarted process, loads the object from disk
+    NaiveObjectCache cache(cache_dir, 1024 * 1024);
+    cache.SetTargetKey("x86_64;O3");
+    auto obj = cache.getObject(m0.get());
+    ASSERT_NE(obj, nullptr);
+    ASSERT_EQ(obj->getBuffer().str(), "object0");
+    ASSERT_EQ(ObjectCacheStats::Global().disk_hits, disk_hits + 1);
+  }
+  {
+    // objects compiled for another target are not reused
+    NaiveObjectCache cache(cache_dir, 1024 * 1024);
+    cache.SetTargetKey("x86_64;O2");
+    ASSERT_EQ(cache.getObject(m0.get()), nullptr);
+  }
+  llvm::sys::fs::remove_directories(cache_dir);
+}
+
+TEST(NaiveObjectCache, eviction) {
+  std::string cache_dir = CreateCacheDir("cinn_object_cache_test");
+  llvm::LLVMContext ctx;
+  std::string object(1024, 'x');
+
+  int64_t evictions = ObjectCacheStats::Global().evictions;
+  NaiveObjectCache cache(cache_dir, 4 * 1024);
+  for (int i = 0; i < 8; ++i) {
+    auto m = CreateModule(&ctx, i);
+    ASSERT_EQ(cache.getObject(m.get()), nullptr);
+    cache.notifyObjectCompiled(
+        m.get(), llvm::MemoryBufferRef(object, "object_cache_test"));
+  }
+  ASSERT_GT(ObjectCacheStats::Global().evictions, evictions);
+
+  uint64_t total_bytes = 0;
+  std::error_code ec;
+  for (llvm::sys::fs::directory_iterator it(cache_dir, ec), end;
+       it != end && !ec;
+       it.increment(ec)) {
+    llvm::sys::fs::file_status status;
+    ASSERT_FALSE(llvm::sys::fs::status(it->path(), status));
+    total_bytes += status.getSize();
+  }
+  ASSERT_LE(total_bytes, static_cast<uint64_t>(4 * 1024));
+  llvm::sys::fs::remove_directories(cache_dir);
+}
+
+}  // namespace backends
+}  // namespace cinn
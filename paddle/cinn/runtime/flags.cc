@@ -199,6 +199,18 @@ PD_DEFINE_string(cinn_pass_visualize_dir,
                  "Specify the directory path of pass visualize file of graph, "
                  "which is used for debug.");
 
+PD_DEFINE_string(cinn_llvm_object_cache_dir,
+                 StringFromEnv("FLAGS_cinn_llvm_object_cache_dir", ""),
+                 "Specify the directory to persist the objects compiled by the "
+                 "llvm execution engine, so that a restarted process can skip "
+                 "the codegen. Empty means only cache objects in memory.");
+
+PD_DEFINE_int64(cinn_llvm_object_cache_max_mb,
+                Int64FromEnv("FLAGS_cinn_llvm_object_cache_max_mb", 1024L),
+                "The max disk size in MB of the llvm object cache, least "
+                "recently used objects are evicted beyond it. A value <= 0 "
+                "means unlimited.");
+
 PD_DEFINE_bool(enable_auto_tuner,
                BoolFromEnv("FLAGS_enable_auto_tuner", false),
                "Whether enable auto tuner.");
@@ -374,6 +374,36 @@ PHI_DEFINE_EXPORTED_int32(dist_threadpool_size,
                           0,
                           "number of threads used for distributed executed.");
 
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_gloo_allreduce_channels
+ * Since Version: 3.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_gloo_allreduce_channels=4
+ * Note: The number of extra gloo contexts created by ProcessGroupGloo, each
+ *       with its own connections and thread. It is off by default, so every
+ *       AllReduce runs as a single gloo op. When it is set, a large
+ *       AllReduce is split into segments which run on the contexts in
+ *       parallel. Read when the group is created.
+ */
+PHI_DEFINE_EXPORTED_int32(gloo_allreduce_channels,
+                          0,
+                          "number of gloo contexts to run the segments of a "
+                          "large allreduce in parallel.");
+
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_gloo_allreduce_segment_size
+ * Since Version: 3.0.0
+ * Value Range: int64, default=4194304
+ * Example: FLAGS_gloo_allreduce_segment_size=1048576
+ * Note: The bytes of a segment of the AllReduce of ProcessGroupGloo. Tensors
+ *       no larger than this are reduced by a single gloo op.
+ */
+PHI_DEFINE_EXPORTED_int64(gloo_allreduce_segment_size,
+                          4 << 20,
+                          "bytes of a segment of a gloo allreduce.");
+
 /**
  * Garbage collector related FLAG
  * Name: FLAGS_eager_delete_tensor_gb
@@ -725,6 +755,42 @@ PHI_DEFINE_EXPORTED_int32(
     "less FLAGS_max_inplace_grad_add, than it will be use several grad_add"
     "instead of sum. Default is 0.");
 
+/**
+ * Performance related FLAG
+ * Name: eager_backward_threads
+ * Since Version: 3.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_eager_backward_threads=8
+ * Note: The number of threads, including the calling thread, which run the
+ *       grad nodes of a backward of the eager mode on CPU. 0 and 1 run the
+ *       nodes one by one on the calling thread. The gradients are the same
+ *       as the ones of the sequential backward. The grad nodes with hooks,
+ *       of PyLayer, to_static, custom ops, SyncBatchNorm and reshard, and
+ *       the accumulation of the leaf tensors run on the calling thread in
+ *       the order of the sequential backward. Other collectives may run in
+ *       any order, so it is meant for single process training.
+ */
+PHI_DEFINE_EXPORTED_int32(eager_backward_threads,
+                          0,
+                          "number of threads which run the grad nodes of a "
+                          "backward of the eager mode on CPU.");
+
+/**
+ * Performance related FLAG
+ * Name: use_jit_softmax_gelu
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_use_jit_softmax_gelu=true
+ * Note: Run the float32 softmax and log_softmax over the last axis, and gelu
+ *       on CPU by the AVX jit kernels. The erf form of gelu uses an
+ *       approximation of erf with max error 1.5e-7, so the outputs may
+ *       differ slightly from the default Eigen/MKL kernels.
+ */
+PHI_DEFINE_EXPORTED_bool(use_jit_softmax_gelu,
+                         false,
+                         "run the float32 softmax, log_softmax and gelu on "
+                         "CPU by the jit kernels.");
+
 /**
  * Tensor.numpy() has a hack, and this flag can close this hack
  * [true]: set 0D Tensor to 1D Numpy
@@ -1145,6 +1211,15 @@ PD_DEFINE_bool(enable_slotrecord_reset_shrink,  // NOLINT
 PD_DEFINE_bool(enable_ins_parser_file,  // NOLINT
                false,
                "enable parser ins file, default false");
+PD_DEFINE_int32(slotpool_lock_free_channel_capacity,
+                0,
+                "if > 0, the slot record pool receives the released records "
+                "through a lock-free channel of this capacity, the records "
+                "released while it is full are freed directly, default 0");
+PD_DEFINE_bool(enable_lock_free_data_feed_queue,  // NOLINT
+               false,
+               "use a lock-free channel as the queue of PrivateQueueDataFeed, "
+               "default false");
 PHI_DEFINE_EXPORTED_bool(
     gpugraph_enable_hbm_table_collision_stat,
     false,
@@ -1345,6 +1420,21 @@ PHI_DEFINE_EXPORTED_bool(use_shm_cache,
                          false,
                          "Use shm cache in mmap_allocator.");
 
+/**
+ * load_combine related FLAG
+ * Name: load_combine_use_mmap
+ * Since Version: 3.0.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: If True, load_combine maps the params file on CPU instead of reading
+ * it, and the tensors whose data is aligned in the file alias the mapping, so
+ * that the processes loading the same model share the memory of the weights.
+ * Use paddle.base.core.align_combined_params_file to align a params file.
+ */
+PHI_DEFINE_EXPORTED_bool(load_combine_use_mmap,
+                         false,
+                         "Memory map the params file in load_combine.");
+
 /**
  * Tensor operants related FLAG
  * Name: tensor_operants_mode
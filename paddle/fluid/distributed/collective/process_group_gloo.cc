@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <iostream>
 
 #ifdef _WIN32
@@ -25,12 +26,18 @@
 #endif
 
 #include <gloo/reduce.h>
+#include <gloo/rendezvous/prefix_store.h>
 
+#include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/collective/common.h"
 #include "paddle/fluid/distributed/collective/process_group_gloo.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/phi/api/lib/data_transform.h"
 #include "paddle/phi/core/distributed/comm_context_manager.h"
+#include "paddle/phi/core/distributed/utils.h"
+
+COMMON_DECLARE_int32(gloo_allreduce_channels);
+COMMON_DECLARE_int64(gloo_allreduce_segment_size);
 
 namespace paddle {
 namespace distributed {
@@ -164,6 +171,17 @@ ProcessGroupGloo::ProcessGroupGloo(
       _store(new GlooStore(store)) {
   _context = std::make_shared<gloo::rendezvous::Context>(rank, world_size);
   _context->connectFullMesh(*_store, options->device);
+  if (world_size > 1) {
+    for (int i = 0; i < FLAGS_gloo_allreduce_channels; ++i) {
+      auto channel_store = std::make_shared<gloo::rendezvous::PrefixStore>(
+          "gloo_channel_" + std::to_string(gid) + "_" + std::to_string(i),
+          *_store);
+      _channels.emplace_back(
+          std::make_unique<phi::distributed::GlooCommContext>(
+              rank, world_size, channel_store, options->device));
+      _channel_threads.emplace_back(std::make_unique<::ThreadPool>(1));
+    }
+  }
 }
 
 class BroadcastGlooTask : public ProcessGroupGloo::GlooTask {
@@ -351,6 +369,85 @@ class AllreduceGlooTask : public ProcessGroupGloo::GlooTask {
   }
 };
 
+// Splits the tensor into segments of segment_numel elements, segment i is
+// reduced on channel i % channels.size() by the thread of the channel. The
+// segments on different channels run in parallel, those on the same channel
+// one after another in the order of the calls, which is the same on every
+// rank.
+class SegmentedAllreduceGlooTask : public ProcessGroupGloo::GlooTask {
+ public:
+  SegmentedAllreduceGlooTask(
+      int rank,
+      const std::vector<std::unique_ptr<phi::distributed::GlooCommContext>>&
+          channels,
+      const std::vector<std::unique_ptr<::ThreadPool>>& channel_threads,
+      std::vector<phi::DenseTensor>& inputs,   // NOLINT
+      std::vector<phi::DenseTensor>& outputs,  // NOLINT
+      ReduceOp reduce_op,
+      int64_t segment_numel,
+      uint32_t tag)
+      : ProcessGroupGloo::GlooTask(rank, inputs, CommType::ALLREDUCE),
+        _channels(channels),
+        _channel_threads(channel_threads),
+        _inputs(inputs),
+        _outputs(outputs),
+        _reduce_op(reduce_op),
+        _segment_numel(segment_numel),
+        _tag(tag) {}
+
+  void Run() override {
+    const int64_t numel = _inputs[0].numel();
+    const int reduce_type = static_cast<int>(_reduce_op);
+    const uint32_t tag = _tag;
+    size_t i = 0;
+    for (int64_t offset = 0; offset < numel; offset += _segment_numel, ++i) {
+      int64_t segment_numel = std::min(_segment_numel, numel - offset);
+      auto in = phi::distributed::GetPartialTensor(
+          _inputs[0], offset, segment_numel);
+      auto out = phi::distributed::GetPartialTensor(
+          _outputs[0], offset, segment_numel);
+      auto* channel = _channels[i % _channels.size()].get();
+      _futures.emplace_back(
+          _channel_threads[i % _channels.size()]->enqueue(
+              [channel, in, out, reduce_type, tag]() mutable {
+                channel->AllReduce(&out, in, reduce_type, tag);
+              }));
+    }
+  }
+
+  bool Wait(std::chrono::milliseconds timeout) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // get() rethrows the error of a segment
+    for (auto& future : _futures) {
+      future.get();
+    }
+    _futures.clear();
+    return true;
+  }
+
+  bool IsCompleted() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& future : _futures) {
+      if (future.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  const std::vector<std::unique_ptr<phi::distributed::GlooCommContext>>&
+      _channels;
+  const std::vector<std::unique_ptr<::ThreadPool>>& _channel_threads;
+  std::vector<phi::DenseTensor> _inputs;
+  std::vector<phi::DenseTensor> _outputs;
+  const ReduceOp _reduce_op;
+  const int64_t _segment_numel;
+  uint32_t _tag;
+  std::vector<std::future<void>> _futures;
+};
+
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
     phi::DenseTensor* out_tensor,
     const phi::DenseTensor& in_tensor,
@@ -358,7 +455,7 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
     bool sync_op) {
   std::vector<phi::DenseTensor> in_wrapper{in_tensor};
   std::vector<phi::DenseTensor> out_wrapper{*out_tensor};
-  return AllReduce(in_wrapper, out_wrapper, opts, true);
+  return AllReduce(in_wrapper, out_wrapper, opts, sync_op);
 }
 
 std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
@@ -377,6 +474,25 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllReduce(
       paddle::experimental::CheckAndTrans2NewContiguousTensor(inputs);
   auto tag = next_tag();
   std::shared_ptr<GlooTask> task;
+  const int64_t element_size = phi::SizeOf(tensor_tmp[0].dtype());
+  const int64_t segment_size = FLAGS_gloo_allreduce_segment_size;
+  if (!_channels.empty() && segment_size >= element_size &&
+      tensor_tmp[0].numel() * element_size > segment_size) {
+    task = std::make_shared<SegmentedAllreduceGlooTask>(
+        rank_,
+        _channels,
+        _channel_threads,
+        tensor_tmp,
+        outputs,
+        opts.reduce_op,
+        segment_size / element_size,
+        tag);
+    task->Run();
+    if (sync_op) {
+      task->Wait(kWaitTimeout);
+    }
+    return task;
+  }
   auto comm_context = this->GetCommContext();
   task = std::make_shared<AllreduceGlooTask>(
       rank_, comm_context, tensor_tmp, outputs, opts.reduce_op, tag);
@@ -592,6 +708,130 @@ std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::Scatter(
   return Scatter(&out_tensors[0], in_tensors[0], opts, true);
 }
 
+class ReduceScatterGlooTask : public ProcessGroupGloo::GlooTask {
+ public:
+  ReduceScatterGlooTask(int rank,
+                        phi::distributed::GlooCommContext* comm_context,
+                        std::vector<phi::DenseTensor>& inputs,   // NOLINT
+                        std::vector<phi::DenseTensor>& outputs,  // NOLINT
+                        ReduceOp reduce_op,
+                        uint32_t tag)
+      : ProcessGroupGloo::GlooTask(rank, inputs, CommType::REDUCE_SCATTER),
+        _comm_context(comm_context),
+        _inputs(inputs),
+        _outputs(outputs),
+        _reduce_op(reduce_op),
+        _tag(tag) {}
+
+  void Run() override { _do_reduce_scatter(_inputs, _outputs); }
+
+ private:
+  phi::distributed::GlooCommContext* _comm_context;
+  std::vector<phi::DenseTensor> _inputs;
+  std::vector<phi::DenseTensor> _outputs;
+  const ReduceOp _reduce_op;
+  uint32_t _tag;
+
+  void _do_reduce_scatter(std::vector<phi::DenseTensor>& ins,     // NOLINT
+                          std::vector<phi::DenseTensor>& outs) {  // NOLINT
+    _comm_context->ReduceScatter(
+        &(outs[0]), ins[0], static_cast<int>(_reduce_op), _tag);
+  }
+};
+
+std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::ReduceScatter(
+    phi::DenseTensor* out_tensor,
+    const phi::DenseTensor& in_tensor,
+    const ReduceScatterOptions& opts,
+    bool sync_op) {
+  auto tensor_tmp =
+      paddle::experimental::CheckAndTrans2NewContiguousTensor(in_tensor);
+  std::shared_ptr<ReduceScatterGlooTask> task;
+  auto tag = next_tag();
+  auto comm_context = this->GetCommContext();
+  std::vector<phi::DenseTensor> in_wrapper{tensor_tmp};
+  std::vector<phi::DenseTensor> out_wrapper{*out_tensor};
+  task = std::make_shared<ReduceScatterGlooTask>(
+      rank_, comm_context, in_wrapper, out_wrapper, opts.reduce_op, tag);
+  task->Run();
+  return task;
+}
+
+class AllToAllGlooTask : public ProcessGroupGloo::GlooTask {
+ public:
+  AllToAllGlooTask(int rank,
+                   phi::distributed::GlooCommContext* comm_context,
+                   std::vector<phi::DenseTensor>& inputs,   // NOLINT
+                   std::vector<phi::DenseTensor>& outputs,  // NOLINT
+                   const std::vector<int64_t>& out_numel_each_rank,
+                   const std::vector<int64_t>& in_numel_each_rank,
+                   uint32_t tag)
+      : ProcessGroupGloo::GlooTask(rank, inputs, CommType::ALLTOALL),
+        _comm_context(comm_context),
+        _inputs(inputs),
+        _outputs(outputs),
+        _out_numel_each_rank(out_numel_each_rank),
+        _in_numel_each_rank(in_numel_each_rank),
+        _tag(tag) {}
+
+  void Run() override { _do_all_to_all(_inputs, _outputs); }
+
+ private:
+  phi::distributed::GlooCommContext* _comm_context;
+  std::vector<phi::DenseTensor> _inputs;
+  std::vector<phi::DenseTensor> _outputs;
+  std::vector<int64_t> _out_numel_each_rank;
+  std::vector<int64_t> _in_numel_each_rank;
+  uint32_t _tag;
+
+  void _do_all_to_all(std::vector<phi::DenseTensor>& ins,     // NOLINT
+                      std::vector<phi::DenseTensor>& outs) {  // NOLINT
+    _comm_context->AllToAll(&(outs[0]),
+                            ins[0],
+                            _out_numel_each_rank,
+                            _in_numel_each_rank,
+                            _tag);
+  }
+};
+
+std::shared_ptr<ProcessGroup::Task> ProcessGroupGloo::AllToAll(
+    phi::DenseTensor* out_tensor,
+    const phi::DenseTensor& in_tensor,
+    const std::vector<int64_t>& out_size_each_rank,
+    const std::vector<int64_t>& in_size_each_rank,
+    bool sync_op) {
+  auto tensor_tmp =
+      paddle::experimental::CheckAndTrans2NewContiguousTensor(in_tensor);
+  const phi::DDim& out_dim = out_tensor->dims();
+  const phi::DDim& in_dim = tensor_tmp.dims();
+  phi::distributed::CheckSizeOnEachRank(out_dim, out_size_each_rank, size_);
+  phi::distributed::CheckSizeOnEachRank(in_dim, in_size_each_rank, size_);
+
+  // the sizes are the rows of dim[0], gloo takes the elements
+  int64_t out_row_size = out_dim[0] == 0 ? 0 : out_tensor->numel() / out_dim[0];
+  int64_t in_row_size = in_dim[0] == 0 ? 0 : tensor_tmp.numel() / in_dim[0];
+  std::vector<int64_t> out_numel_each_rank(size_), in_numel_each_rank(size_);
+  for (int i = 0; i < size_; ++i) {
+    out_numel_each_rank[i] = out_size_each_rank[i] * out_row_size;
+    in_numel_each_rank[i] = in_size_each_rank[i] * in_row_size;
+  }
+
+  std::shared_ptr<AllToAllGlooTask> task;
+  auto tag = next_tag();
+  auto comm_context = this->GetCommContext();
+  std::vector<phi::DenseTensor> in_wrapper{tensor_tmp};
+  std::vector<phi::DenseTensor> out_wrapper{*out_tensor};
+  task = std::make_shared<AllToAllGlooTask>(rank_,
+                                            comm_context,
+                                            in_wrapper,
+                                            out_wrapper,
+                                            out_numel_each_rank,
+                                            in_numel_each_rank,
+                                            tag);
+  task->Run();
+  return task;
+}
+
 class GatherGlooTask : public ProcessGroupGloo::GlooTask {
  public:
   GatherGlooTask(int rank,
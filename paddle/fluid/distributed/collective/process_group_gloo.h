@@ -14,9 +14,12 @@
 
 #pragma once
 
+#include <ThreadPool.h>
+
 #include <future>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "paddle/fluid/distributed/collective/process_group.h"
 #include "paddle/fluid/distributed/collective/process_group_without_stream.h"
@@ -127,6 +130,13 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
       const AllreduceOptions& opts,
       bool sync_op) override;
 
+  std::shared_ptr<ProcessGroup::Task> AllToAll(
+      phi::DenseTensor* out_tensor,
+      const phi::DenseTensor& in_tensor,
+      const std::vector<int64_t>& out_size_each_rank,
+      const std::vector<int64_t>& in_size_each_rank,
+      bool sync_op) override;
+
   std::shared_ptr<ProcessGroup::Task> Broadcast(
       phi::DenseTensor* out_tensor,
       const phi::DenseTensor& in_tensor,
@@ -146,6 +156,12 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
                                              const ReduceOptions& opts,
                                              bool sync_op) override;
 
+  std::shared_ptr<ProcessGroup::Task> ReduceScatter(
+      phi::DenseTensor* out_tensor,
+      const phi::DenseTensor& in_tensor,
+      const ReduceScatterOptions& opts,
+      bool sync_op) override;
+
   std::shared_ptr<ProcessGroup::Task> Scatter(phi::DenseTensor* out_tensor,
                                               const phi::DenseTensor& in_tensor,
                                               const ScatterOptions& opts,
@@ -239,6 +255,11 @@ class ProcessGroupGloo : public ProcessGroupWithoutStream {
   uint32_t _tag;
   std::shared_ptr<gloo::rendezvous::Context> _context;
   std::shared_ptr<::gloo::rendezvous::Store> _store;
+  // Extra contexts to run the segments of a large AllReduce in parallel,
+  // channel i is used by _channel_threads[i] only, see
+  // FLAGS_gloo_allreduce_channels.
+  std::vector<std::unique_ptr<phi::distributed::GlooCommContext>> _channels;
+  std::vector<std::unique_ptr<::ThreadPool>> _channel_threads;
 };
 
 }  // namespace distributed
@@ -14,10 +14,13 @@
 
 #include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <sstream>
 #include <string>
 
+#include "bvar/bvar.h"
 #include "paddle/fluid/distributed/ps/service/coordinator_client.h"
 #include "paddle/fluid/framework/archive.h"
 #include "paddle/fluid/string/split.h"
@@ -82,6 +85,11 @@ PD_DEFINE_int32(pserver_sparse_table_shard_num,
                 1000,
                 "sparse table shard for save & load");
 
+// bytes of the pushed gradients before and after TableParameter.push_compress
+static bvar::Adder<int64_t> g_push_raw_bytes("pserver_client_push_raw_bytes");
+static bvar::Adder<int64_t> g_push_wire_bytes(
+    "pserver_client_push_wire_bytes");
+
 inline size_t get_sparse_shard(uint32_t shard_num,
                                uint32_t server_num,
                                uint64_t key) {
@@ -348,6 +356,33 @@ int32_t BrpcPsClient::Initialize() {
     }
   }
 
+  // 梯度压缩, 仅支持MemorySparseTable, MemorySparseCompactTable, SSDSparseTable
+  // 与MemoryDenseTable
+  const auto &server_param = _config.server_param().downpour_server_param();
+  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = server_param.downpour_table_param(i);
+    if (table_param.push_compress().type() == PUSH_COMPRESS_NONE) {
+      continue;
+    }
+    const auto &table_class = table_param.table_class();
+    bool is_dense = table_class == "MemoryDenseTable";
+    if (!is_dense && table_class != "MemorySparseTable" &&
+        table_class != "MemorySparseCompactTable" &&
+        table_class != "SSDSparseTable") {
+      LOG(WARNING) << "push_compress is not supported by " << table_class
+                   << ", the pushes of table " << table_param.table_id()
+                   << " are not compressed";
+      continue;
+    }
+    if (!is_dense && table_param.push_compress().type() == PUSH_COMPRESS_TOPK) {
+      LOG(WARNING) << "PUSH_COMPRESS_TOPK is for dense tables only, the "
+                   << "pushes of table " << table_param.table_id()
+                   << " are not compressed";
+      continue;
+    }
+    _push_compress_tables[table_param.table_id()] = table_param;
+  }
+
   auto &profiler = CostProfiler::instance();
   profiler.register_profiler("pserver_client_pull_dense");
   profiler.register_profiler("pserver_client_pull_sparse");
@@ -1009,7 +1044,6 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     const float **update_values,
     size_t num,
     void *done) {
-  auto *accessor = GetTableAccessor(table_id);
   // 发送RPC请求
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
@@ -1043,7 +1077,6 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     auto value_ptr = value_ptrs[shard_idx];
 
     size_t kv_size = kvs.size();
-    uint32_t value_size = accessor->GetAccessorInfo().update_size;
 
     // 发送RPC请求
     auto *push_request = closure->request(shard_idx);
@@ -1051,16 +1084,8 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradient(
     push_request->set_table_id(table_id);
     push_request->set_client_id(_client_id);
     push_request->add_params((char *)&kv_size, sizeof(uint32_t));  // NOLINT
-    auto *push_data = push_request->mutable_data();
-    push_data->resize(kv_size * (sizeof(uint64_t) + value_size));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, kvs.data(), kv_size * sizeof(uint64_t));
-    push_data_ptr += kv_size * sizeof(uint64_t);
-
-    for (size_t i = 0; i < kv_size; ++i) {
-      memcpy(push_data_ptr, value_ptr[i], value_size);
-      push_data_ptr += value_size;
-    }
+    SerializeSparsePush(
+        table_id, kvs.data(), value_ptr.data(), kv_size, push_request);
     PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
     closure->cntl(shard_idx)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -1089,14 +1114,11 @@ std::future<int32_t> BrpcPsClient::PushDenseRawGradient(
     closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
     closure->request(i)->set_table_id(table_id);
     closure->request(i)->set_client_id(_client_id);
-    auto *push_data = closure->request(i)->mutable_data();
-    push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard,
-           num_per_shard * sizeof(float));
+    SerializeDensePush(table_id,
+                       i,
+                       total_send_data + i * num_per_shard,
+                       num_per_shard,
+                       closure->request(i));
     // closure->cntl(i)->set_request_compress_type(
     //     (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     PsService_Stub rpc_stub(GetDenseChannel(i));
@@ -1376,6 +1398,67 @@ std::future<int32_t> BrpcPsClient::PullSparseParam(float **select_values,
   return fut;
 }
 
+std::future<int32_t> BrpcPsClient::PrefetchSparse(size_t table_id,
+                                                  const uint64_t *keys,
+                                                  size_t num) {
+  size_t request_call_num = _server_channels.size();
+  const auto &server_param = _config.server_param().downpour_server_param();
+  uint64_t shard_num = FLAGS_pserver_sparse_table_shard_num;
+  for (int i = 0; i < server_param.downpour_table_param_size(); ++i) {
+    const auto &table_param = server_param.downpour_table_param(i);
+    if (table_param.table_id() == table_id) {
+      shard_num = table_param.shard_num();
+      break;
+    }
+  }
+  std::vector<std::vector<uint64_t>> shard_keys(request_call_num);
+  for (size_t i = 0; i < num; ++i) {
+    size_t shard_id = get_sparse_shard(shard_num, request_call_num, keys[i]);
+    shard_keys[shard_id].push_back(keys[i]);
+  }
+
+  DownpourBrpcClosure *closure =
+      new DownpourBrpcClosure(request_call_num, [request_call_num](void *done) {
+        int ret = 0;
+        auto *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
+        for (size_t i = 0; i < request_call_num; ++i) {
+          if (closure->check_response(i, PS_PREFETCH_SPARSE_TABLE) != 0) {
+            ret = -1;
+            break;
+          }
+        }
+        closure->set_promise_value(ret);
+      });
+  auto promise = std::make_shared<std::promise<int32_t>>();
+  closure->add_promise(promise);
+  std::future<int> fut = promise->get_future();
+
+  for (size_t i = 0; i < request_call_num; ++i) {
+    auto &keys_of_shard = shard_keys[i];
+    if (keys_of_shard.empty()) {
+      closure->Run();
+      continue;
+    }
+    std::sort(keys_of_shard.begin(), keys_of_shard.end());
+    keys_of_shard.erase(
+        std::unique(keys_of_shard.begin(), keys_of_shard.end()),
+        keys_of_shard.end());
+    uint32_t key_num = keys_of_shard.size();
+    closure->request(i)->set_cmd_id(PS_PREFETCH_SPARSE_TABLE);
+    closure->request(i)->set_table_id(table_id);
+    closure->request(i)->set_client_id(_client_id);
+    closure->request(i)->add_params((char *)&key_num,  // NOLINT
+                                    sizeof(uint32_t));
+    closure->cntl(i)->request_attachment().append(
+        keys_of_shard.data(), key_num * sizeof(uint64_t));
+    PsService_Stub rpc_stub(GetCmdChannel(i));
+    closure->cntl(i)->set_log_id(butil::gettimeofday_ms());
+    rpc_stub.service(
+        closure->cntl(i), closure->request(i), closure->response(i), closure);
+  }
+  return fut;
+}
+
 std::future<int32_t> BrpcPsClient::SendClient2ClientMsg(
     int msg_type, int to_client_id, const std::string &msg) {
   auto promise = std::make_shared<std::promise<int32_t>>();
@@ -1409,8 +1492,6 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradientPartial(
     uint32_t num,
     void *done,
     int pserver_idx) {
-  auto *accessor = GetTableAccessor(table_id);
-  size_t value_size = accessor->GetAccessorInfo().update_size;
   DownpourBrpcClosure *closure = reinterpret_cast<DownpourBrpcClosure *>(done);
   auto promise = std::make_shared<std::promise<int32_t>>();
   closure->add_promise(promise);
@@ -1422,15 +1503,7 @@ std::future<int32_t> BrpcPsClient::PushSparseRawGradientPartial(
   push_request->set_table_id(table_id);
   push_request->set_client_id(_client_id);
   push_request->add_params((char *)&num, sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
-  push_data->resize(num * (sizeof(uint64_t) + value_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr, keys, num * sizeof(uint64_t));
-  push_data_ptr += num * sizeof(uint64_t);
-  for (uint32_t i = 0; i < num; ++i) {
-    memcpy(push_data_ptr, update_values[i], value_size);
-    push_data_ptr += value_size;
-  }
+  SerializeSparsePush(table_id, keys, update_values, num, push_request);
   PsService_Stub rpc_stub(GetSparseChannel(pserver_idx));
   closure->cntl(0)->set_request_compress_type(
       (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -1858,22 +1931,16 @@ int BrpcPsClient::PushSparseAsyncShardPush(
   push_request->set_client_id(_client_id);
   push_request->add_params(reinterpret_cast<char *>(&merged_kv_count),
                            sizeof(uint32_t));  // NOLINT
-  auto *push_data = push_request->mutable_data();
-  int update_size = accessor->GetAccessorInfo().update_size;
-  push_data->resize(merged_kv_count * (sizeof(uint64_t) + update_size));
-  char *push_data_ptr = const_cast<char *>(push_data->data());
-  memcpy(push_data_ptr,
-         merged_key_list.data(),
-         merged_kv_count * sizeof(uint64_t));
-  push_data_ptr += merged_kv_count * sizeof(uint64_t);
+  std::vector<const float *> value_ptrs(merged_kv_count);
   for (size_t i = 0; i < merged_kv_count; ++i) {
-    const char *task_data_ptr = merged_value_list[i].data();
-
-    memcpy(push_data_ptr,
-           (float *)(task_data_ptr),  // NOLINT
-           update_size);
-    push_data_ptr += update_size;
+    value_ptrs[i] =
+        reinterpret_cast<const float *>(merged_value_list[i].data());
   }
+  SerializeSparsePush(table_id,
+                      merged_key_list.data(),
+                      value_ptrs.data(),
+                      merged_kv_count,
+                      push_request);
   PsService_Stub rpc_stub(GetSparseChannel(shard_idx));
   closure->cntl(shard_idx)->set_request_compress_type(
       (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
@@ -2052,14 +2119,11 @@ void BrpcPsClient::PushDenseRawGradient(std::shared_ptr<DenseAsyncTask> &task,
     closure->request(i)->set_cmd_id(PS_PUSH_DENSE_TABLE);
     closure->request(i)->set_table_id(task->table_id());
     closure->request(i)->set_client_id(_client_id);
-    auto *push_data = closure->request(i)->mutable_data();
-    push_data->clear();
-    push_data->resize(sizeof(uint32_t) + num_per_shard * sizeof(float));
-    char *push_data_ptr = const_cast<char *>(push_data->data());
-    memcpy(push_data_ptr, &num_per_shard, sizeof(uint32_t));
-    memcpy(push_data_ptr + sizeof(uint32_t),
-           total_send_data + i * num_per_shard,
-           num_per_shard * sizeof(float));
+    SerializeDensePush(task->table_id(),
+                       i,
+                       total_send_data + i * num_per_shard,
+                       num_per_shard,
+                       closure->request(i));
     closure->cntl(i)->set_request_compress_type(
         (brpc::CompressType)FLAGS_pserver_communicate_compress_type);
     PsService_Stub rpc_stub(GetDenseChannel(i));
@@ -2068,5 +2132,108 @@ void BrpcPsClient::PushDenseRawGradient(std::shared_ptr<DenseAsyncTask> &task,
   }
 }
 
+int64_t BrpcPsClient::PushRawBytes() { return g_push_raw_bytes.get_value(); }
+
+int64_t BrpcPsClient::PushWireBytes() {
+  return g_push_wire_bytes.get_value();
+}
+
+void BrpcPsClient::SerializeSparsePush(size_t table_id,
+                                       const uint64_t *keys,
+                                       const float *const *values,
+                                       size_t kv_size,
+                                       PsRequestMessage *request) {
+  auto *accessor = GetTableAccessor(table_id);
+  size_t value_size = accessor->GetAccessorInfo().update_size;
+  uint32_t update_dim = accessor->GetAccessorInfo().update_dim;
+  PushCompressHeader header = {PUSH_COMPRESS_NONE, 0, 0, update_dim};
+  auto iter = _push_compress_tables.find(table_id);
+  if (iter != _push_compress_tables.end()) {
+    header = MakePushCompressHeader(iter->second, update_dim);
+  }
+  size_t row_size = value_size;
+  if (header.type != PUSH_COMPRESS_NONE) {
+    row_size = PushCompressRowBytes(header);
+    request->add_params(reinterpret_cast<const char *>(&header),
+                        sizeof(PushCompressHeader));
+  }
+
+  /*
+  Push Content:
+  |---keysData---|---valuesData---|
+  |---8*{num}B---|----------------|
+  */
+  auto *push_data = request->mutable_data();
+  push_data->resize(kv_size * (sizeof(uint64_t) + row_size));
+  char *push_data_ptr = const_cast<char *>(push_data->data());
+  memcpy(push_data_ptr, keys, kv_size * sizeof(uint64_t));
+  push_data_ptr += kv_size * sizeof(uint64_t);
+  for (size_t i = 0; i < kv_size; ++i) {
+    if (header.type == PUSH_COMPRESS_NONE) {
+      memcpy(push_data_ptr, values[i], value_size);
+      push_data_ptr += value_size;
+    } else {
+      push_data_ptr = PushCompressEncodeRow(header, values[i], push_data_ptr);
+    }
+  }
+  g_push_raw_bytes << kv_size * (sizeof(uint64_t) + value_size);
+  g_push_wire_bytes << push_data->size();
+}
+
+void BrpcPsClient::SerializeDensePush(size_t table_id,
+                                      size_t shard_idx,
+                                      const float *values,
+                                      uint32_t num,
+                                      PsRequestMessage *request) {
+  PushCompressHeader header = {PUSH_COMPRESS_NONE, 0, 0, num};
+  size_t topk = 0;
+  auto iter = _push_compress_tables.find(table_id);
+  if (iter != _push_compress_tables.end()) {
+    header = MakePushCompressHeader(iter->second, num);
+    topk = static_cast<size_t>(
+        std::ceil(iter->second.push_compress().topk_ratio() * num));
+    topk = std::max<size_t>(std::min<size_t>(topk, num), 1);
+  }
+
+  /*
+  Push Content:
+  |--num--|---valuesData---|
+  |--4B---|----------------|
+  */
+  auto *push_data = request->mutable_data();
+  push_data->clear();
+  if (header.type == PUSH_COMPRESS_NONE) {
+    push_data->resize(sizeof(uint32_t) + num * sizeof(float));
+  } else if (header.type == PUSH_COMPRESS_TOPK) {
+    push_data->resize(sizeof(uint32_t) + PushCompressTopKBytes(topk));
+  } else {
+    push_data->resize(sizeof(uint32_t) + PushCompressRowBytes(header));
+  }
+  char *push_data_ptr = const_cast<char *>(push_data->data());
+  memcpy(push_data_ptr, &num, sizeof(uint32_t));
+  push_data_ptr += sizeof(uint32_t);
+  if (header.type == PUSH_COMPRESS_NONE) {
+    memcpy(push_data_ptr, values, num * sizeof(float));
+  } else if (header.type == PUSH_COMPRESS_TOPK) {
+    // the residual of every shard of the table, cleared by the values sent
+    std::lock_guard<std::mutex> lock(_push_dense_residual_mutex);
+    auto &residuals = _push_dense_residuals[table_id];
+    if (residuals.size() <= shard_idx) {
+      residuals.resize(shard_idx + 1);
+    }
+    residuals[shard_idx].resize(num, 0);
+    PushCompressEncodeTopK(
+        values, num, topk, residuals[shard_idx].data(), push_data_ptr);
+  } else {
+    PushCompressEncodeRow(header, values, push_data_ptr);
+  }
+  if (header.type != PUSH_COMPRESS_NONE) {
+    request->add_params(reinterpret_cast<const char *>(&header),
+                        sizeof(PushCompressHeader));
+  }
+  g_push_raw_bytes << sizeof(uint32_t) + num * sizeof(float);
+  g_push_wire_bytes << push_data->size();
+}
+
 }  // namespace distributed
 }  // namespace paddle
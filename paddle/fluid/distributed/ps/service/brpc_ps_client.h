@@ -17,7 +17,9 @@
 #include <ThreadPool.h>
 
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "brpc/channel.h"
@@ -27,6 +29,7 @@
 #include "paddle/fluid/distributed/ps/service/brpc_utils.h"
 #include "paddle/fluid/distributed/ps/service/ps_client.h"
 #include "paddle/fluid/distributed/ps/service/sendrecv.pb.h"
+#include "paddle/fluid/distributed/ps/table/depends/push_compress.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
@@ -266,6 +269,9 @@ class BrpcPsClient : public PSClient {
                                                const uint64_t *keys,
                                                size_t num,
                                                bool is_training);
+  std::future<int32_t> PrefetchSparse(size_t table_id,
+                                      const uint64_t *keys,
+                                      size_t num) override;
 
   virtual std::future<int32_t> PrintTableStat(uint32_t table_id);
 
@@ -323,6 +329,12 @@ class BrpcPsClient : public PSClient {
   }
   int32_t Initialize() override;
 
+  // The bytes of the gradients pushed by all the clients of the process,
+  // before and after TableParameter.push_compress, also exposed as the bvars
+  // pserver_client_push_raw_bytes and pserver_client_push_wire_bytes.
+  static int64_t PushRawBytes();
+  static int64_t PushWireBytes();
+
   // for fl
  public:
   virtual int32_t InitializeFlWorker(const std::string &self_endpoint);
@@ -378,7 +390,28 @@ class BrpcPsClient : public PSClient {
       DownpourBrpcClosure *closure,
       ValueAccessor *accessor);
 
+  // Writes the keys and the values of a sparse push to request, encoded as
+  // TableParameter.push_compress of the table.
+  void SerializeSparsePush(size_t table_id,
+                           const uint64_t *keys,
+                           const float *const *values,
+                           size_t kv_size,
+                           PsRequestMessage *request);
+  // Writes the num values of a dense push to shard shard_idx to request,
+  // encoded as TableParameter.push_compress of the table.
+  void SerializeDensePush(size_t table_id,
+                          size_t shard_idx,
+                          const float *values,
+                          uint32_t num,
+                          PsRequestMessage *request);
+
   SparseTaskPool _sparse_task_pool;
+  // the tables of push_compress, by table id
+  std::unordered_map<uint32_t, TableParameter> _push_compress_tables;
+  // the residuals of the shards of the dense tables of PUSH_COMPRESS_TOPK
+  std::unordered_map<uint32_t, std::vector<std::vector<float>>>
+      _push_dense_residuals;
+  std::mutex _push_dense_residual_mutex;
 
   std::vector<std::shared_ptr<brpc::Channel>>
       _client_channels;  // client2client
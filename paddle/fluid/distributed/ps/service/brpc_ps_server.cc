@@ -218,6 +218,8 @@ int32_t BrpcPsService::Initialize() {
   _service_handler_map[PS_REVERT] = &BrpcPsService::Revert;
   _service_handler_map[PS_CHECK_SAVE_PRE_PATCH_DONE] =
       &BrpcPsService::CheckSavePrePatchDone;
+  _service_handler_map[PS_PREFETCH_SPARSE_TABLE] =
+      &BrpcPsService::PrefetchSparse;
 
   auto &profiler = CostProfiler::instance();
   profiler.register_profiler("pserver_server_pull_dense");
@@ -365,6 +367,27 @@ int32_t BrpcPsService::PushDenseParam(Table *table,
   return 0;
 }
 
+// Sets the values of table_context to the encoded values of a push if
+// request.params(header_idx) holds a PushCompressHeader, see
+// TableParameter.push_compress.
+static void SetCompressedPushValues(const PsRequestMessage &request,
+                                    int header_idx,
+                                    const char *values,
+                                    size_t size,
+                                    TableContext *table_context) {
+  if (request.params_size() <= header_idx ||
+      request.params(header_idx).size() != sizeof(PushCompressHeader)) {
+    return;
+  }
+  auto &push_context = table_context->push_context;
+  memcpy(&push_context.compress_header,
+         request.params(header_idx).data(),
+         sizeof(PushCompressHeader));
+  push_context.compressed_values = values;
+  push_context.compressed_size = size;
+  push_context.values = nullptr;
+}
+
 int32_t BrpcPsService::PushDense(Table *table,
                                  const PsRequestMessage &request,
                                  PsResponseMessage &response,
@@ -390,6 +413,11 @@ int32_t BrpcPsService::PushDense(Table *table,
   table_context.push_context.values =
       (const float *)(request.data().data() + sizeof(uint32_t));
   table_context.num = num;
+  SetCompressedPushValues(request,
+                          0,
+                          request.data().data() + sizeof(uint32_t),
+                          req_buffer_size - sizeof(uint32_t),
+                          &table_context);
   // const float *values = (const float *)(request.data().data() +
   // sizeof(uint32_t));
   if (table->Push(table_context) != 0) {
@@ -550,6 +578,34 @@ int32_t BrpcPsService::PullSparse(Table *table,
   return 0;
 }
 
+int32_t BrpcPsService::PrefetchSparse(Table *table,
+                                      const PsRequestMessage &request,
+                                      PsResponseMessage &response,
+                                      brpc::Controller *cntl) {
+  platform::RecordEvent record_event(
+      "PsService->PrefetchSparse", platform::TracerEventType::Communication, 1);
+  CHECK_TABLE_EXIST(table, request, response)
+  if (request.params_size() < 1) {
+    set_response_code(response,
+                      -1,
+                      "PsRequestMessage.params is requeired at "
+                      "least 1 for num of sparse_key");
+    return 0;
+  }
+  const uint32_t num =
+      *(reinterpret_cast<const uint32_t *>(request.params(0).c_str()));
+  auto &req_io_buffer = cntl->request_attachment();
+  if (req_io_buffer.size() != num * sizeof(uint64_t)) {
+    set_response_code(response, -1, "req attachment is not in format");
+    return 0;
+  }
+  std::vector<uint64_t> keys(num);
+  req_io_buffer.copy_to(keys.data(), num * sizeof(uint64_t));
+  // 预取在table的分片线程上异步执行, 不等待完成
+  table->Prefetch(keys.data(), keys.size());
+  return 0;
+}
+
 int32_t BrpcPsService::PushSparse(Table *table,
                                   const PsRequestMessage &request,
                                   PsResponseMessage &response,
@@ -583,6 +639,15 @@ int32_t BrpcPsService::PushSparse(Table *table,
   table_context.push_context.values =
       (const float *)(push_data.data() + sizeof(uint64_t) * num);
   table_context.num = num;
+  if (push_data.size() < sizeof(uint64_t) * num) {
+    set_response_code(response, -1, "PushSparse data is less than the keys");
+    return 0;
+  }
+  SetCompressedPushValues(request,
+                          1,
+                          push_data.data() + sizeof(uint64_t) * num,
+                          push_data.size() - sizeof(uint64_t) * num,
+                          &table_context);
   // const uint64_t *keys = (const uint64_t *)push_data.data();
   // const float *values = (const float *)(push_data.data() + sizeof(uint64_t) *
   // num);
@@ -197,6 +197,11 @@ class BrpcPsService : public PsBaseService {
                                 PsResponseMessage &response,  // NOLINT
                                 brpc::Controller *cntl);
 
+  int32_t PrefetchSparse(Table *table,
+                         const PsRequestMessage &request,
+                         PsResponseMessage &response,  // NOLINT
+                         brpc::Controller *cntl);
+
   bool _is_initialize_shard_info;
   std::mutex _initialize_shard_mutex;
   std::unordered_map<int32_t, serviceHandlerFunc> _service_handler_map;
@@ -350,6 +350,18 @@ class PSClient {
     promise.set_value(-1);
     return fut;
   }
+
+  // 通知server预取下一个batch的sparse keys, future在server收到请求后
+  // 即完成, 不等待预取完成
+  virtual std::future<int32_t> PrefetchSparse(size_t table_id UNUSED,
+                                              const uint64_t *keys UNUSED,
+                                              size_t num UNUSED) {
+    VLOG(0) << "Did not implement";
+    std::promise<int32_t> promise;
+    std::future<int> fut = promise.get_future();
+    promise.set_value(-1);
+    return fut;
+  }
   // add
   virtual std::shared_ptr<SparseShardValues> TakePassSparseReferedValues(
       const size_t &table_id UNUSED,
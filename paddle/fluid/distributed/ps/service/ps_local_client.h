@@ -89,6 +89,10 @@ class PsLocalClient : public PSClient {
 
   virtual ::std::future<int32_t> PrintTableStat(uint32_t table_id);
 
+  virtual ::std::future<int32_t> PrefetchSparse(size_t table_id,
+                                                const uint64_t* keys,
+                                                size_t num);
+
   virtual ::std::future<int32_t> SaveCacheTable(uint32_t table_id,
                                                 uint16_t pass_id,
                                                 size_t threshold);
@@ -118,8 +118,11 @@ class ValueAccessor {
   // 判断该value是否在save阶段dump,
   // param作为参数用于标识save阶段，如downpour的xbox与batch_model
   virtual bool Save(float* value, int param) = 0;
-  // update delta_score and unseen_days after save
-  virtual void UpdateStatAfterSave(float* value UNUSED, int param UNUSED) {}
+  // update delta_score and unseen_days after save, returns whether the value
+  // is changed
+  virtual bool UpdateStatAfterSave(float* value UNUSED, int param UNUSED) {
+    return false;
+  }
   // 判断该value是否保存到ssd
   virtual bool SaveSSD(float* value) = 0;
   // 判断热启时是否过滤slot对应的feasign
@@ -181,6 +184,10 @@ class ValueAccessor {
   virtual float GetField(float* value UNUSED, const std::string& name UNUSED) {
     return 0.0;
   }
+  // 用于ssd表按热度决定value的准入与淘汰，默认按show排序
+  virtual float GetShowClickScore(float* value) {
+    return GetField(value, "show");
+  }
   virtual robin_hood::unordered_set<float>* GetFilteredSlots() {
     return nullptr;
   }
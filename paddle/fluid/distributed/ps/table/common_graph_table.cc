@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <limits>
 #include <set>
 #include <sstream>
 #include <tuple>
@@ -55,6 +56,14 @@ PHI_DEFINE_EXPORTED_int32(graph_edges_debug_node_id, 0, "graph debug node id");
 PHI_DEFINE_EXPORTED_int32(graph_edges_debug_node_num,
                           2,
                           "graph debug node num");
+PHI_DEFINE_EXPORTED_bool(graph_pack_edges,
+                         false,
+                         "pack the neighbors of every edge shard in the CSR "
+                         "format after the edges are loaded");
+PHI_DEFINE_EXPORTED_string(graph_packed_edges_dir,
+                           "",
+                           "if not empty, the packed edges are saved to this "
+                           "directory and mapped from the files");
 
 namespace paddle {
 namespace distributed {
@@ -891,11 +900,10 @@ int32_t GraphTable::make_complementary_graph(int idx, int64_t byte_size) {
     int64_t res = load_graph_to_memory_from_ssd(idx, buffer);
     byte_size -= res;
   }
-  std::string sample_type = "random";
   for (auto &shard : edge_shards[idx]) {
     auto bucket = shard->get_bucket();
     for (size_t i = 0; i < bucket.size(); i++) {
-      bucket[i]->build_sampler(sample_type);
+      bucket[i]->build_sampler(sample_type_);
     }
   }
 
@@ -1773,6 +1781,7 @@ void GraphShard::clear() {
   }
   bucket.clear();
   node_location.clear();
+  csr_edges.clear();
 }
 
 GraphShard::~GraphShard() { clear(); }
@@ -1828,6 +1837,27 @@ void GraphShard::add_neighbor(uint64_t id, uint64_t dst_id, float weight) {
   find_node(id)->add_edge(dst_id, weight);
 }
 
+void GraphShard::pack_edges(bool with_weight,
+                            const std::string &sample_type,
+                            const std::string &path) {
+  PADDLE_ENFORCE_LE(bucket.size(),
+                    std::numeric_limits<uint32_t>::max(),
+                    ::paddle::platform::errors::OutOfRange(
+                        "Too many nodes (%d) in a graph shard to pack.",
+                        bucket.size()));
+  std::unique_ptr<GraphCsrEdges> packed(new GraphCsrEdges());
+  packed->build(bucket, with_weight);
+  packed->set_sample_type(sample_type);
+  if (!path.empty()) {
+    packed->map_to_file(path);
+  }
+  for (size_t i = 0; i < bucket.size(); i++) {
+    bucket[i]->pack_edges(packed.get(), i);
+  }
+  csr_edges.clear();
+  csr_edges.push_back(std::move(packed));
+}
+
 Node *GraphShard::find_node(uint64_t id) {
   auto iter = node_location.find(id);
   return iter == node_location.end() ? nullptr : bucket[iter->second];
@@ -2468,7 +2498,45 @@ int32_t GraphTable::build_sampler(int idx, std::string sample_type) {
     for (auto item : bucket) {
       item->build_sampler(sample_type);
     }
+    for (auto &edges : shard->csr_edges) {
+      edges->set_sample_type(sample_type);
+    }
+  }
+  return 0;
+}
+
+int32_t GraphTable::pack_edges(int idx, const std::string &sample_type) {
+  auto &shards = edge_shards[idx];
+  std::vector<std::future<int>> tasks;
+  for (size_t i = 0; i < shards.size(); i++) {
+    tasks.push_back(
+        load_node_edge_task_pool->enqueue([&, i, this]() -> int {
+          std::string path;
+          if (!FLAGS_graph_packed_edges_dir.empty()) {
+            path = FLAGS_graph_packed_edges_dir + "/edge_" +
+                   std::to_string(idx) + "_part_" +
+                   std::to_string(shard_start + i) + ".csr";
+          }
+          shards[i]->pack_edges(is_weighted_, sample_type, path);
+          return 0;
+        }));
+  }
+  for (auto &task : tasks) task.get();
+
+  size_t node_num = 0, edge_num = 0, memory_size = 0;
+  for (auto &shard : shards) {
+    for (auto &edges : shard->csr_edges) {
+      node_num += edges->node_num();
+      edge_num += edges->edge_num();
+      memory_size += edges->memory_size();
+    }
   }
+  VLOG(0) << "packed " << edge_num << " edges of " << node_num
+          << " nodes of edge_type[" << idx << "] into " << memory_size
+          << " bytes"
+          << (FLAGS_graph_packed_edges_dir.empty()
+                  ? ""
+                  : " mapped from " + FLAGS_graph_packed_edges_dir);
   return 0;
 }
 
@@ -2615,18 +2683,21 @@ int32_t GraphTable::load_edges(const std::string &path,
   }
 #endif
 
-  if (!build_sampler_on_cpu) {
+  if (FLAGS_graph_pack_edges) {
+    // The packed edges are sampled directly, no sampler is built per node.
+    VLOG(0) << "pack edges ... ";
+    pack_edges(idx, sample_type_);
+  } else if (!build_sampler_on_cpu) {
     // To reduce memory overhead, CPU samplers won't be created in gpugraph.
     // In order not to affect the sampler function of other scenario,
     // this optimization is only performed in load_edges function.
     VLOG(0) << "run in gpugraph mode!";
   } else {
-    std::string sample_type = "random";
-    VLOG(0) << "build sampler ... ";
+    VLOG(0) << "build " << sample_type_ << " sampler ... ";
     for (auto &shard : edge_shards[idx]) {
       auto bucket = shard->get_bucket();
       for (auto item : bucket) {
-        item->build_sampler(sample_type);
+        item->build_sampler(sample_type_);
       }
     }
   }
@@ -2795,6 +2866,7 @@ int32_t GraphTable::random_sample_neighbors(
       size_t index = 0;
       std::vector<SampleResult> sample_res;
       std::vector<SampleKey> sample_keys;
+      std::vector<int> res;
       auto &rng = _shards_task_rng_pool[i];
       for (size_t k = 0; k < id_list[i].size(); k++) {
         if (index < r.size() &&
@@ -2826,7 +2898,8 @@ int32_t GraphTable::random_sample_neighbors(
             continue;
           }
           std::shared_ptr<char> &buffer = buffers[idy];
-          std::vector<int> res = node->sample_k(sample_size, rng);
+          res.clear();
+          node->append_sample_k(sample_size, rng, &res);
           actual_size =
               res.size() * (need_weight ? (Node::id_size + Node::weight_size)
                                         : Node::id_size);
@@ -3413,6 +3486,14 @@ void GraphTable::load_node_weight(int type_id, int idx, std::string path) {
 int32_t GraphTable::Initialize(const GraphParameter &graph) {
   task_pool_size_ = graph.task_pool_size();
   build_sampler_on_cpu = graph.build_sampler_on_cpu();
+  sample_type_ = graph.sample_type();
+  PADDLE_ENFORCE_EQ(sample_type_ == "random" || sample_type_ == "weighted" ||
+                        sample_type_ == "alias",
+                    true,
+                    ::paddle::platform::errors::InvalidArgument(
+                        "The sample_type of a graph table should be random, "
+                        "weighted or alias, but got %s.",
+                        sample_type_));
 
 #ifdef PADDLE_WITH_GPU_GRAPH
   _db = NULL;
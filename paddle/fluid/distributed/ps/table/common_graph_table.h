@@ -129,6 +129,12 @@ class GraphShard {
   void delete_node(uint64_t id);
   void clear();
   void add_neighbor(uint64_t id, uint64_t dst_id, float weight);
+  // Packs the neighbors of all the nodes into a GraphCsrEdges, which is
+  // mapped from path if path is not empty. The nodes read their neighbors
+  // from it until they are modified.
+  void pack_edges(bool with_weight,
+                  const std::string &sample_type,
+                  const std::string &path);
   std::unordered_map<uint64_t, int> &get_node_location() {
     return node_location;
   }
@@ -149,6 +155,9 @@ class GraphShard {
         bucket.push_back(shard->bucket[i]);
       }
     }
+    for (auto &edges : shard->csr_edges) {
+      csr_edges.push_back(std::move(edges));
+    }
     shard->node_location.clear();
     shard->bucket.clear();
     delete shard;
@@ -158,6 +167,9 @@ class GraphShard {
  public:
   std::unordered_map<uint64_t, int> node_location;
   std::vector<Node *> bucket;
+  // The packed neighbors referred by the nodes, more than one after merging
+  // packed shards.
+  std::vector<std::unique_ptr<GraphCsrEdges>> csr_edges;
 };
 
 enum LRUResponse { ok = 0, blocked = 1, err = 2 };
@@ -769,6 +781,8 @@ class GraphTable : public Table {
 #endif
   virtual int32_t add_comm_edge(int idx, uint64_t src_id, uint64_t dst_id);
   virtual int32_t build_sampler(int idx, std::string sample_type = "random");
+  // Packs the neighbors of every shard of edge type idx in the CSR format.
+  int32_t pack_edges(int idx, const std::string &sample_type = "random");
   void set_slot_feature_separator(const std::string &ch);
   void set_feature_separator(const std::string &ch);
 
@@ -833,6 +847,8 @@ class GraphTable : public Table {
   int cache_ttl;
   mutable std::mutex mutex_;
   bool build_sampler_on_cpu;
+  // random, weighted or alias
+  std::string sample_type_ = "random";
   bool is_load_reverse_edge = false;
   std::shared_ptr<pthread_rwlock_t> rw_lock;
 #ifdef PADDLE_WITH_HETERPS
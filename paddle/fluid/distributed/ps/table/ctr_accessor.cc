@@ -142,7 +142,7 @@ bool CtrCommonAccessor::Save(float* value, int param) {
   }
 }
 
-void CtrCommonAccessor::UpdateStatAfterSave(float* value, int param) {
+bool CtrCommonAccessor::UpdateStatAfterSave(float* value, int param) {
   auto base_threshold = _config.ctr_accessor_param().base_threshold();
   auto delta_threshold = _config.ctr_accessor_param().delta_threshold();
   auto delta_keep_days = _config.ctr_accessor_param().delta_keep_days();
@@ -156,15 +156,16 @@ void CtrCommonAccessor::UpdateStatAfterSave(float* value, int param) {
           common_feature_value.DeltaScore(value) >= delta_threshold &&
           common_feature_value.UnseenDays(value) <= delta_keep_days) {
         common_feature_value.DeltaScore(value) = 0;
+        return true;
       }
     }
-      return;
+      return false;
     case 3: {
       common_feature_value.UnseenDays(value)++;
     }
-      return;
+      return true;
     default:
-      return;
+      return false;
   }
 }
 
@@ -155,7 +155,7 @@ class CtrCommonAccessor : public ValueAccessor {
                  double global_cache_threshold) override;
   bool SaveSSD(float* value) override;
   // update delta_score and unseen_days after save
-  void UpdateStatAfterSave(float* value, int param) override;
+  bool UpdateStatAfterSave(float* value, int param) override;
   // keys不存在时，为values生成随机值
   // 要求value的内存由外部调用者分配完毕
   virtual int32_t Create(float** value, size_t num);
@@ -187,6 +187,11 @@ class CtrCommonAccessor : public ValueAccessor {
     return 0.0;
   }
 
+  float GetShowClickScore(float* value) override {
+    return ShowClickScore(common_feature_value.Show(value),
+                          common_feature_value.Click(value));
+  }
+
  private:
   // float ShowClickScore(float show, float click);
 
@@ -140,7 +140,7 @@ bool CtrDoubleAccessor::Save(float* value, int param) {
   }
 }
 
-void CtrDoubleAccessor::UpdateStatAfterSave(float* value, int param) {
+bool CtrDoubleAccessor::UpdateStatAfterSave(float* value, int param) {
   auto base_threshold = _config.ctr_accessor_param().base_threshold();
   auto delta_threshold = _config.ctr_accessor_param().delta_threshold();
   auto delta_keep_days = _config.ctr_accessor_param().delta_keep_days();
@@ -155,15 +155,16 @@ void CtrDoubleAccessor::UpdateStatAfterSave(float* value, int param) {
           CtrDoubleFeatureValue::DeltaScore(value) >= delta_threshold &&
           CtrDoubleFeatureValue::UnseenDays(value) <= delta_keep_days) {
         CtrDoubleFeatureValue::DeltaScore(value) = 0;
+        return true;
       }
     }
-      return;
+      return false;
     case 3: {
       CtrDoubleFeatureValue::UnseenDays(value)++;
     }
-      return;
+      return true;
     default:
-      return;
+      return false;
   }
 }
 
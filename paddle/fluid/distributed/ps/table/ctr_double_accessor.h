@@ -175,7 +175,7 @@ class CtrDoubleAccessor : public ValueAccessor {
                  int param,
                  double global_cache_threshold) override;
   // update delta_score and unseen_days after save
-  void UpdateStatAfterSave(float* value, int param) override;
+  bool UpdateStatAfterSave(float* value, int param) override;
   // 判断该value是否保存到ssd
   virtual bool SaveSSD(float* value);
   // virtual bool save_cache(float* value, int param, double
@@ -212,7 +212,7 @@ class CtrDymfAccessor : public ValueAccessor {
   bool FilterSlot(float* value);
   bool SaveFilterSlot(float* value) override;
   // update delta_score and unseen_days after save
-  void UpdateStatAfterSave(float* value, int param) override;
+  bool UpdateStatAfterSave(float* value, int param) override;
   // keys不存在时，为values生成随机值
   // 要求value的内存由外部调用者分配完毕
   virtual int32_t Create(float** value, size_t num);
@@ -244,6 +244,11 @@ class CtrDymfAccessor : public ValueAccessor {
     return 0.0;
   }
 
+  float GetShowClickScore(float* value) override {
+    return ShowClickScore(common_feature_value.Show(value),
+                          common_feature_value.Click(value));
+  }
+
   robin_hood::unordered_set<float>* GetFilteredSlots() override {
     return &_filtered_slots;
   }
@@ -0,0 +1,359 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+// The value of a key of CompactSparseTableShard, stored in the record of the
+// key right after the key. The floats are inline up to the capacity of the
+// shard, a larger value, e.g. of a larger mf_dim of the dymf accessor, moves
+// to an overflow block on the heap whose address takes the inline floats.
+//
+// It has the interface of FixedFeatureValue used by the tables, but lives in
+// the slab of the shard and can not be copied.
+class CompactFeatureValue {
+ public:
+  explicit CompactFeatureValue(uint32_t capacity)
+      : _size(0), _capacity(capacity), _epoch(0) {}
+  ~CompactFeatureValue() {
+    if (overflowed()) {
+      delete[] overflow_data();
+    }
+  }
+  CompactFeatureValue(const CompactFeatureValue&) = delete;
+  CompactFeatureValue& operator=(const CompactFeatureValue&) = delete;
+
+  float* data() { return overflowed() ? overflow_data() : inline_data(); }
+  size_t size() { return _size; }
+  // the new floats are zero as the ones of std::vector
+  void resize(size_t size) {
+    if (size == _size) {
+      return;
+    }
+    float* old_data = data();
+    bool old_overflowed = overflowed();
+    size_t kept = std::min<size_t>(size, _size);
+    if (size <= _capacity) {
+      if (old_overflowed) {
+        memcpy(inline_data(), old_data, kept * sizeof(float));
+        delete[] old_data;
+      }
+      std::fill(inline_data() + kept, inline_data() + size, 0.0f);
+    } else {
+      float* block = new float[size];
+      memcpy(block, old_data, kept * sizeof(float));
+      std::fill(block + kept, block + size, 0.0f);
+      if (old_overflowed) {
+        delete[] old_data;
+      }
+      memcpy(inline_data(), &block, sizeof(block));
+    }
+    _size = static_cast<uint32_t>(size);
+  }
+  void shrink_to_fit() {}
+  bool overflowed() const { return _size > _capacity; }
+  uint32_t epoch() const { return _epoch; }
+  void set_epoch(uint32_t epoch) { _epoch = epoch; }
+
+ private:
+  float* inline_data() { return reinterpret_cast<float*>(this + 1); }
+  float* overflow_data() {
+    float* block;
+    memcpy(&block, inline_data(), sizeof(block));
+    return block;
+  }
+
+  uint32_t _size;
+  uint32_t _capacity;
+  uint32_t _epoch;
+};
+
+// A shard of the interface of SparseTableShard<KEY, FixedFeatureValue> which
+// stores the keys and the values in place:
+//
+// - the records {key, CompactFeatureValue, floats} of a fixed size are
+//   allocated from slabs of kSlabRecords records and never move, so that
+//   the value pointers stay valid until the key is erased;
+// - the index is an open-addressed array with linear probing of
+//   {hash tag, record id}, 8 bytes per slot.
+//
+// Compared with a closed_hash_map bucket entry, a ChunkAllocator node of
+// std::vector<float> and the heap block of the vector per key, a key takes
+// the 20 bytes of its record header and 11 to 22 bytes of index at the
+// default max load factor. set_value_dim must be called while the shard is
+// empty, the values larger than it go to the overflow blocks.
+template <class KEY>
+class alignas(64) CompactSparseTableShard {
+ public:
+  typedef CompactFeatureValue value_type;
+  static constexpr size_t kSlabRecordsBits = 12;
+  static constexpr size_t kSlabRecords = static_cast<size_t>(1)
+                                         << kSlabRecordsBits;
+
+  struct iterator {
+    CompactSparseTableShard* shard;
+    size_t pos;
+    friend bool operator==(const iterator& a, const iterator& b) {
+      return a.pos == b.pos;
+    }
+    friend bool operator!=(const iterator& a, const iterator& b) {
+      return a.pos != b.pos;
+    }
+    const KEY& key() const { return shard->record_key(shard->_index[pos].id); }
+    CompactFeatureValue& value() const { return *value_ptr(); }
+    CompactFeatureValue* value_ptr() const {
+      return shard->record_value(shard->_index[pos].id);
+    }
+    iterator& operator++() {
+      pos = shard->next_used(pos + 1);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator ret = *this;
+      ++*this;
+      return ret;
+    }
+  };
+
+  explicit CompactSparseTableShard(size_t value_dim = 2) {
+    set_value_dim(value_dim);
+  }
+  ~CompactSparseTableShard() { clear(); }
+  CompactSparseTableShard(const CompactSparseTableShard&) = delete;
+  CompactSparseTableShard& operator=(const CompactSparseTableShard&) = delete;
+
+  // the number of floats stored inline, at least 2 for the address of an
+  // overflow block
+  void set_value_dim(size_t value_dim) {
+    PADDLE_ENFORCE_EQ(
+        _size + _slabs.size(),
+        0,
+        paddle::platform::errors::PreconditionNotMet(
+            "The value dim of CompactSparseTableShard must be set while it "
+            "holds no record."));
+    _value_dim = std::max<size_t>(value_dim, 2);
+    size_t bytes = sizeof(KEY) + sizeof(CompactFeatureValue) +
+                   _value_dim * sizeof(float);
+    _record_size = (bytes + alignof(KEY) - 1) / alignof(KEY) * alignof(KEY);
+  }
+  size_t value_dim() const { return _value_dim; }
+
+  bool empty() { return _size == 0; }
+  size_t size() { return _size; }
+  void set_max_load_factor(float x) { _max_load_factor = x; }
+  // the bytes of the index and of the slabs, not counting the overflow blocks
+  size_t memory_size() const {
+    return _index.capacity() * sizeof(Slot) +
+           _slabs.size() * kSlabRecords * _record_size +
+           _free_records.capacity() * sizeof(uint32_t);
+  }
+
+  void clear() {
+    for (auto it = begin(); it != end(); ++it) {
+      it.value_ptr()->~CompactFeatureValue();
+    }
+    std::vector<Slot>().swap(_index);
+    std::vector<std::unique_ptr<char[]>>().swap(_slabs);
+    std::vector<uint32_t>().swap(_free_records);
+    _size = 0;
+    _tombstones = 0;
+    _record_num = 0;
+  }
+  iterator begin() { return {this, next_used(0)}; }
+  iterator end() { return {this, _index.size()}; }
+  iterator find(const KEY& key) {
+    if (_index.empty()) {
+      return end();
+    }
+    size_t hash = hash_key(key);
+    uint32_t tag = static_cast<uint32_t>(hash >> 32);
+    size_t mask = _index.size() - 1;
+    for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+      const Slot& slot = _index[pos];
+      if (slot.id == kEmpty) {
+        return end();
+      }
+      if (slot.id != kTombstone && slot.tag == tag &&
+          record_key(slot.id) == key) {
+        return {this, pos};
+      }
+    }
+  }
+  CompactFeatureValue& operator[](const KEY& key) {
+    return emplace(key).first.value();
+  }
+  std::pair<iterator, bool> emplace(const KEY& key) {
+    if ((_size + _tombstones + 1) > _max_load_factor * _index.size()) {
+      // grow if the live keys need it, otherwise clear the tombstones
+      size_t capacity = std::max<size_t>(_index.size(), 16);
+      while ((_size + 1) * 2 > _max_load_factor * capacity) {
+        capacity *= 2;
+      }
+      rehash(capacity);
+    }
+    size_t hash = hash_key(key);
+    uint32_t tag = static_cast<uint32_t>(hash >> 32);
+    size_t mask = _index.size() - 1;
+    size_t insert_pos = _index.size();
+    size_t pos = hash & mask;
+    for (;; pos = (pos + 1) & mask) {
+      const Slot& slot = _index[pos];
+      if (slot.id == kEmpty) {
+        break;
+      }
+      if (slot.id == kTombstone) {
+        insert_pos = std::min(insert_pos, pos);
+      } else if (slot.tag == tag && record_key(slot.id) == key) {
+        return {{this, pos}, false};
+      }
+    }
+    if (insert_pos == _index.size()) {
+      insert_pos = pos;
+    } else {
+      --_tombstones;
+    }
+    uint32_t id = acquire_record(key);
+    _index[insert_pos] = {tag, id};
+    ++_size;
+    return {{this, insert_pos}, true};
+  }
+  iterator erase(iterator it) {
+    quick_erase(it);
+    return {this, next_used(it.pos + 1)};
+  }
+  void quick_erase(iterator it) {
+    Slot& slot = _index[it.pos];
+    release_record(slot.id);
+    slot.id = kTombstone;
+    --_size;
+    ++_tombstones;
+  }
+  size_t erase(const KEY& key) {
+    auto it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    quick_erase(it);
+    return 1;
+  }
+
+ private:
+  struct Slot {
+    uint32_t tag;
+    uint32_t id;  // the record id + 1, or kEmpty, kTombstone
+  };
+  static constexpr uint32_t kEmpty = 0;
+  static constexpr uint32_t kTombstone = UINT32_MAX;
+
+  static size_t hash_key(const KEY& key) {
+    // the keys of a shard share the remainders of the shard num, mix the
+    // bits before they are masked, as the finalizer of MurmurHash3
+    uint64_t h = std::hash<KEY>()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  char* record(uint32_t id) {
+    size_t i = id - 1;
+    return _slabs[i >> kSlabRecordsBits].get() +
+           (i & (kSlabRecords - 1)) * _record_size;
+  }
+  const KEY& record_key(uint32_t id) {
+    return *reinterpret_cast<KEY*>(record(id));
+  }
+  CompactFeatureValue* record_value(uint32_t id) {
+    return reinterpret_cast<CompactFeatureValue*>(record(id) + sizeof(KEY));
+  }
+
+  uint32_t acquire_record(const KEY& key) {
+    uint32_t id;
+    if (!_free_records.empty()) {
+      id = _free_records.back();
+      _free_records.pop_back();
+    } else {
+      PADDLE_ENFORCE_LT(
+          _record_num,
+          static_cast<size_t>(kTombstone) - 1,
+          paddle::platform::errors::ResourceExhausted(
+              "CompactSparseTableShard holds at most %d records.",
+              kTombstone - 1));
+      if (_record_num == _slabs.size() * kSlabRecords) {
+        _slabs.emplace_back(new char[kSlabRecords * _record_size]);
+      }
+      id = static_cast<uint32_t>(++_record_num);
+    }
+    new (record(id)) KEY(key);
+    new (record_value(id)) CompactFeatureValue(_value_dim);
+    return id;
+  }
+  void release_record(uint32_t id) {
+    record_value(id)->~CompactFeatureValue();
+    _free_records.push_back(id);
+  }
+
+  size_t next_used(size_t pos) {
+    while (pos < _index.size() &&
+           (_index[pos].id == kEmpty || _index[pos].id == kTombstone)) {
+      ++pos;
+    }
+    return pos;
+  }
+
+  void rehash(size_t capacity) {
+    std::vector<Slot> index(capacity, Slot{0, kEmpty});
+    size_t mask = capacity - 1;
+    for (const Slot& slot : _index) {
+      if (slot.id == kEmpty || slot.id == kTombstone) {
+        continue;
+      }
+      size_t pos = hash_key(record_key(slot.id)) & mask;
+      while (index[pos].id != kEmpty) {
+        pos = (pos + 1) & mask;
+      }
+      index[pos] = slot;
+    }
+    _index.swap(index);
+    _tombstones = 0;
+  }
+
+  std::vector<Slot> _index;
+  std::vector<std::unique_ptr<char[]>> _slabs;
+  std::vector<uint32_t> _free_records;
+  size_t _value_dim = 2;
+  size_t _record_size = 0;
+  size_t _record_num = 0;
+  size_t _size = 0;
+  size_t _tombstones = 0;
+  float _max_load_factor = 0.75;
+};
+
+}  // namespace distributed
+}  // namespace paddle
@@ -36,9 +36,14 @@ class FixedFeatureValue {
   size_t size() { return _data.size(); }
   void resize(size_t size) { _data.resize(size); }
   void shrink_to_fit() { _data.shrink_to_fit(); }
+  // the save epoch of the last update, for the delta checkpoints of
+  // MemorySparseTable
+  uint32_t epoch() const { return _epoch; }
+  void set_epoch(uint32_t epoch) { _epoch = epoch; }
 
  private:
   std::vector<float> _data;
+  uint32_t _epoch = 0;
 };
 
 template <class KEY, class VALUE>
@@ -46,6 +51,7 @@ struct alignas(64) SparseTableShard {
  public:
   typedef typename mct::closed_hash_map<KEY, mct::Pointer, std::hash<KEY>>
       map_type;
+  typedef VALUE value_type;
   struct iterator {
     typename map_type::iterator it;
     size_t bucket;
@@ -0,0 +1,293 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle {
+namespace distributed {
+
+// Encoding of the gradients pushed by BrpcPsClient, configured per table by
+// TableParameter.push_compress. The header is sent as a param of the
+// request and the server decodes the values before they reach the table.
+//
+// A push holds row_num rows of row_dim floats, one row per key for a sparse
+// push and a single row for a dense push. The first raw_dim floats of a row,
+// e.g. slot, show and click, stay fp32 and the rest are encoded by type:
+//
+//   fp16 / bf16: 2 bytes per value
+//   int8:        per block of block_size values, the float scale
+//                max(|v|) / 127 followed by the int8 values
+//   top-k:       uint32_t k, k uint32_t indices and k floats, dense only
+//
+// The encoded values are not aligned, they are read and written by memcpy.
+struct PushCompressHeader {
+  uint32_t type;
+  uint32_t block_size;
+  uint32_t raw_dim;
+  uint32_t row_dim;
+};
+
+static_assert(sizeof(PushCompressHeader) == 16,
+              "PushCompressHeader is sent as is and must not be padded");
+
+// The header of the pushes of row_dim floats to table, the type is
+// PUSH_COMPRESS_NONE if the pushes of the table are not compressed.
+inline PushCompressHeader MakePushCompressHeader(const TableParameter &table,
+                                                 uint32_t row_dim) {
+  PushCompressHeader header = {PUSH_COMPRESS_NONE, 0, 0, row_dim};
+  if (!table.has_push_compress()) {
+    return header;
+  }
+  const auto &param = table.push_compress();
+  header.type = param.type();
+  header.block_size = std::max<uint32_t>(param.int8_block_size(), 1);
+  if (table.type() == PS_DENSE_TABLE) {
+    header.raw_dim = 0;
+  } else if (param.has_raw_dim()) {
+    header.raw_dim = param.raw_dim();
+  } else if (table.accessor().accessor_class() == "CtrDymfAccessor") {
+    header.raw_dim = 4;  // slot, show, click, mf_dim
+  } else if (table.accessor().accessor_class() == "CommMergeAccessor") {
+    header.raw_dim = 0;
+  } else {
+    header.raw_dim = 3;  // slot, show, click
+  }
+  header.raw_dim = std::min(header.raw_dim, row_dim);
+  return header;
+}
+
+// Bytes of n values encoded by type, for all the types but top-k.
+inline size_t PushCompressValueBytes(uint32_t type,
+                                     uint32_t block_size,
+                                     size_t n) {
+  switch (type) {
+    case PUSH_COMPRESS_FP16:
+    case PUSH_COMPRESS_BF16:
+      return n * sizeof(uint16_t);
+    case PUSH_COMPRESS_INT8:
+      return (n + block_size - 1) / block_size * sizeof(float) + n;
+    default:
+      return n * sizeof(float);
+  }
+}
+
+// Bytes of a row encoded as header, for all the types but top-k.
+inline size_t PushCompressRowBytes(const PushCompressHeader &header) {
+  return header.raw_dim * sizeof(float) +
+         PushCompressValueBytes(header.type,
+                                header.block_size,
+                                header.row_dim - header.raw_dim);
+}
+
+inline size_t PushCompressTopKBytes(size_t k) {
+  return sizeof(uint32_t) + k * (sizeof(uint32_t) + sizeof(float));
+}
+
+// Encodes n values to out, returns the end of the encoded values.
+inline char *PushCompressEncodeValues(uint32_t type,
+                                      uint32_t block_size,
+                                      const float *values,
+                                      size_t n,
+                                      char *out) {
+  switch (type) {
+    case PUSH_COMPRESS_FP16:
+      for (size_t i = 0; i < n; ++i) {
+        phi::dtype::float16 v(values[i]);
+        memcpy(out + i * sizeof(uint16_t), &v.x, sizeof(uint16_t));
+      }
+      return out + n * sizeof(uint16_t);
+    case PUSH_COMPRESS_BF16:
+      for (size_t i = 0; i < n; ++i) {
+        phi::dtype::bfloat16 v(values[i]);
+        memcpy(out + i * sizeof(uint16_t), &v.x, sizeof(uint16_t));
+      }
+      return out + n * sizeof(uint16_t);
+    case PUSH_COMPRESS_INT8:
+      for (size_t begin = 0; begin < n; begin += block_size) {
+        size_t end = std::min<size_t>(begin + block_size, n);
+        float max_abs = 0;
+        for (size_t i = begin; i < end; ++i) {
+          max_abs = std::max(max_abs, std::fabs(values[i]));
+        }
+        float scale = max_abs / 127;
+        memcpy(out, &scale, sizeof(float));
+        out += sizeof(float);
+        float inv_scale = scale > 0 ? 1 / scale : 0;
+        for (size_t i = begin; i < end; ++i) {
+          float q = std::round(values[i] * inv_scale);
+          *out++ = static_cast<char>(std::min(std::max(q, -127.0f), 127.0f));
+        }
+      }
+      return out;
+    default:
+      memcpy(out, values, n * sizeof(float));
+      return out + n * sizeof(float);
+  }
+}
+
+// Decodes n values from in, returns the end of the encoded values.
+inline const char *PushCompressDecodeValues(uint32_t type,
+                                            uint32_t block_size,
+                                            const char *in,
+                                            size_t n,
+                                            float *values) {
+  switch (type) {
+    case PUSH_COMPRESS_FP16:
+      for (size_t i = 0; i < n; ++i) {
+        phi::dtype::float16 v;
+        memcpy(&v.x, in + i * sizeof(uint16_t), sizeof(uint16_t));
+        values[i] = static_cast<float>(v);
+      }
+      return in + n * sizeof(uint16_t);
+    case PUSH_COMPRESS_BF16:
+      for (size_t i = 0; i < n; ++i) {
+        phi::dtype::bfloat16 v;
+        memcpy(&v.x, in + i * sizeof(uint16_t), sizeof(uint16_t));
+        values[i] = static_cast<float>(v);
+      }
+      return in + n * sizeof(uint16_t);
+    case PUSH_COMPRESS_INT8:
+      for (size_t begin = 0; begin < n; begin += block_size) {
+        size_t end = std::min<size_t>(begin + block_size, n);
+        float scale;
+        memcpy(&scale, in, sizeof(float));
+        in += sizeof(float);
+        for (size_t i = begin; i < end; ++i) {
+          values[i] = static_cast<int8_t>(*in++) * scale;
+        }
+      }
+      return in;
+    default:
+      memcpy(values, in, n * sizeof(float));
+      return in + n * sizeof(float);
+  }
+}
+
+inline char *PushCompressEncodeRow(const PushCompressHeader &header,
+                                   const float *row,
+                                   char *out) {
+  memcpy(out, row, header.raw_dim * sizeof(float));
+  out += header.raw_dim * sizeof(float);
+  return PushCompressEncodeValues(header.type,
+                                  header.block_size,
+                                  row + header.raw_dim,
+                                  header.row_dim - header.raw_dim,
+                                  out);
+}
+
+inline const char *PushCompressDecodeRow(const PushCompressHeader &header,
+                                         const char *in,
+                                         float *row) {
+  memcpy(row, in, header.raw_dim * sizeof(float));
+  in += header.raw_dim * sizeof(float);
+  return PushCompressDecodeValues(header.type,
+                                  header.block_size,
+                                  in,
+                                  header.row_dim - header.raw_dim,
+                                  row + header.raw_dim);
+}
+
+// Top-k with error feedback: adds the n values to residual, then writes the
+// k entries of the largest magnitude of residual to out and clears them
+// from residual, so that the dropped parts are sent by the later pushes.
+// Returns the end of the encoded values.
+inline char *PushCompressEncodeTopK(
+    const float *values, size_t n, size_t k, float *residual, char *out) {
+  k = std::min(k, n);
+  thread_local std::vector<uint32_t> index;
+  index.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    residual[i] += values[i];
+  }
+  std::iota(index.begin(), index.end(), 0);
+  if (k < n) {
+    std::nth_element(index.begin(),
+                     index.begin() + k,
+                     index.end(),
+                     [residual](uint32_t a, uint32_t b) {
+                       return std::fabs(residual[a]) > std::fabs(residual[b]);
+                     });
+  }
+  std::sort(index.begin(), index.begin() + k);
+
+  uint32_t k32 = static_cast<uint32_t>(k);
+  memcpy(out, &k32, sizeof(uint32_t));
+  out += sizeof(uint32_t);
+  memcpy(out, index.data(), k * sizeof(uint32_t));
+  out += k * sizeof(uint32_t);
+  for (size_t i = 0; i < k; ++i) {
+    memcpy(out, &residual[index[i]], sizeof(float));
+    out += sizeof(float);
+    residual[index[i]] = 0;
+  }
+  return out;
+}
+
+// Decodes the row_num rows of size bytes encoded as header to values.
+// Returns false if size does not match the rows, e.g. for a malformed
+// request, in which case values are undefined.
+inline bool PushCompressDecode(const PushCompressHeader &header,
+                               const char *in,
+                               size_t size,
+                               size_t row_num,
+                               std::vector<float> *values) {
+  if (header.raw_dim > header.row_dim || header.block_size == 0) {
+    return false;
+  }
+  values->resize(row_num * header.row_dim);
+  float *out = values->data();
+  if (header.type == PUSH_COMPRESS_TOPK) {
+    uint32_t k = 0;
+    if (row_num != 1 || size < sizeof(uint32_t)) {
+      return false;
+    }
+    memcpy(&k, in, sizeof(uint32_t));
+    if (k > header.row_dim || size != PushCompressTopKBytes(k)) {
+      return false;
+    }
+    const char *index = in + sizeof(uint32_t);
+    const char *data = index + k * sizeof(uint32_t);
+    std::fill(out, out + header.row_dim, 0.0f);
+    for (uint32_t i = 0; i < k; ++i) {
+      uint32_t pos;
+      memcpy(&pos, index + i * sizeof(uint32_t), sizeof(uint32_t));
+      if (pos >= header.row_dim) {
+        return false;
+      }
+      memcpy(out + pos, data + i * sizeof(float), sizeof(float));
+    }
+    return true;
+  }
+  if (size != row_num * PushCompressRowBytes(header)) {
+    return false;
+  }
+  for (size_t i = 0; i < row_num; ++i) {
+    in = PushCompressDecodeRow(header, in, out + i * header.row_dim);
+  }
+  return true;
+}
+
+}  // namespace distributed
+}  // namespace paddle
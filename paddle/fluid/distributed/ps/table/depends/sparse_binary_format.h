@@ -0,0 +1,396 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/distributed/common/afs_warpper.h"
+#include "paddle/fluid/distributed/ps/table/accessor.h"
+#include "paddle/fluid/framework/io/fs.h"
+
+#define PSERVER_BINARY_SAVE_SUFFIX ".bin"
+
+namespace paddle {
+namespace distributed {
+
+// Binary shard layout of a sparse table:
+//
+//   SparseShardBinaryHeader | record 0 | record 1 | ... | record n-1
+//
+// every record has the same width `record_size`:
+//
+//   uint64_t key | uint32_t value_size | uint32_t reserved | float[value_dim]
+//
+// value_dim is the full accessor dim, value_size is the number of valid
+// floats (a feasign without mf only fills the head of the block). Fixed width
+// records allow the loader to map the file and walk it without any parsing.
+//
+// The delta checkpoints of MemorySparseTable use the same layout, with the
+// sequence of the delta (or of the last delta merged into a base) in
+// reserved[0] of the header and a record of value_size 0 for an erased key.
+static const uint32_t kSparseShardBinaryMagic = 0x54425350;  // "PSBT"
+static const uint32_t kSparseShardBinaryVersion = 1;
+static const size_t kSparseShardBinaryBufferSize = 8 * 1024 * 1024;
+
+struct SparseShardBinaryHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t value_dim;
+  uint32_t record_size;
+  uint64_t reserved[2];
+};
+
+static_assert(sizeof(SparseShardBinaryHeader) == 32,
+              "SparseShardBinaryHeader must be 32 bytes");
+
+inline uint32_t SparseShardBinaryRecordSize(uint32_t value_dim) {
+  // key + value_size + reserved, keep every record 8 bytes aligned
+  size_t size = sizeof(uint64_t) + 2 * sizeof(uint32_t) +
+                static_cast<size_t>(value_dim) * sizeof(float);
+  return static_cast<uint32_t>((size + 7) & ~static_cast<size_t>(7));
+}
+
+inline bool IsSparseShardBinaryFile(const std::string& path) {
+  const std::string suffix(PSERVER_BINARY_SAVE_SUFFIX);
+  return path.size() >= suffix.size() &&
+         path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Buffers records and flushes them to the channel with large sequential
+// writes.
+class SparseShardBinaryWriter {
+ public:
+  SparseShardBinaryWriter(std::shared_ptr<FsWriteChannel> channel,
+                          uint32_t value_dim,
+                          size_t buffer_size = kSparseShardBinaryBufferSize)
+      : _channel(channel),
+        _value_dim(value_dim),
+        _record_size(SparseShardBinaryRecordSize(value_dim)) {
+    size_t record_num = buffer_size / _record_size;
+    _buffer.resize((record_num > 0 ? record_num : 1) * _record_size);
+  }
+
+  int WriteHeader(uint64_t sequence = 0) {
+    SparseShardBinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kSparseShardBinaryMagic;
+    header.version = kSparseShardBinaryVersion;
+    header.value_dim = _value_dim;
+    header.record_size = _record_size;
+    header.reserved[0] = sequence;
+    return _channel->write(reinterpret_cast<const char*>(&header),
+                           sizeof(header)) == 0
+               ? 0
+               : -1;
+  }
+
+  int Append(uint64_t key, const float* value, size_t value_size) {
+    if (value_size > _value_dim) {
+      LOG(ERROR) << "SparseShardBinaryWriter value size " << value_size
+                 << " exceeds value dim " << _value_dim << ", key: " << key;
+      return -1;
+    }
+    if (_offset + _record_size > _buffer.size() && Flush() != 0) {
+      return -1;
+    }
+    char* record = _buffer.data() + _offset;
+    memset(record, 0, _record_size);
+    uint32_t size = static_cast<uint32_t>(value_size);
+    memcpy(record, &key, sizeof(uint64_t));
+    memcpy(record + sizeof(uint64_t), &size, sizeof(uint32_t));
+    if (value_size > 0) {
+      memcpy(record + sizeof(uint64_t) + 2 * sizeof(uint32_t),
+             value,
+             value_size * sizeof(float));
+    }
+    _offset += _record_size;
+    ++_record_num;
+    return 0;
+  }
+
+  // the record of a key erased since the previous delta
+  int AppendErased(uint64_t key) { return Append(key, nullptr, 0); }
+
+  int Flush() {
+    if (_offset == 0) {
+      return 0;
+    }
+    int ret = _channel->write(_buffer.data(), _offset) == 0 ? 0 : -1;
+    _offset = 0;
+    return ret;
+  }
+
+  size_t RecordNum() const { return _record_num; }
+
+ private:
+  std::shared_ptr<FsWriteChannel> _channel;
+  uint32_t _value_dim;
+  uint32_t _record_size;
+  std::vector<char> _buffer;
+  size_t _offset = 0;
+  size_t _record_num = 0;
+};
+
+// Reads a binary shard. Local files without deconverter are mapped
+// read-only, everything else (afs/hdfs, piped converters) is streamed in
+// large chunks through the FsReadChannel.
+class SparseShardBinaryReader {
+ public:
+  SparseShardBinaryReader() {}
+  ~SparseShardBinaryReader() { Close(); }
+  SparseShardBinaryReader(const SparseShardBinaryReader&) = delete;
+  SparseShardBinaryReader& operator=(const SparseShardBinaryReader&) = delete;
+
+  int Open(AfsClient* afs_client,
+           const FsChannelConfig& config,
+           uint32_t expect_value_dim,
+           int* err_no) {
+    Close();
+    _path = config.path;
+    if (config.deconverter.empty() &&
+        paddle::framework::fs_select_internal(config.path) == 0 &&
+        OpenMmap() == 0) {
+      return CheckHeader(
+          *reinterpret_cast<const SparseShardBinaryHeader*>(_mmap_data),
+          expect_value_dim);
+    }
+    _channel = afs_client->open_r(config, 0, err_no);
+    SparseShardBinaryHeader header;
+    if (_channel->read(reinterpret_cast<char*>(&header), sizeof(header)) !=
+        static_cast<int>(sizeof(header))) {
+      LOG(ERROR) << "SparseShardBinaryReader read header failed, path: "
+                 << _path;
+      return -1;
+    }
+    return CheckHeader(header, expect_value_dim);
+  }
+
+  // Calls func(key, value, value_size) for every record, returns the number
+  // of records or -1 on a truncated / corrupted file.
+  template <class Func>
+  int64_t ForEach(Func&& func) {
+    int64_t record_num = 0;
+    if (_mmap_data != nullptr) {
+      size_t body_size = _mmap_size - sizeof(SparseShardBinaryHeader);
+      if (body_size % _record_size != 0) {
+        LOG(ERROR) << "SparseShardBinaryReader truncated file, path: " << _path;
+        return -1;
+      }
+      const char* record = _mmap_data + sizeof(SparseShardBinaryHeader);
+      const char* end = _mmap_data + _mmap_size;
+      for (; record < end; record += _record_size, ++record_num) {
+        if (VisitRecord(record, func) != 0) {
+          return -1;
+        }
+      }
+      return record_num;
+    }
+    size_t record_per_read = kSparseShardBinaryBufferSize / _record_size;
+    record_per_read = record_per_read > 0 ? record_per_read : 1;
+    std::vector<char> buffer(record_per_read * _record_size);
+    size_t remain = 0;
+    while (true) {
+      int read_size = _channel->read(buffer.data() + remain,
+                                     buffer.size() - remain);
+      if (read_size <= 0) {
+        break;
+      }
+      size_t valid = remain + read_size;
+      size_t offset = 0;
+      for (; offset + _record_size <= valid;
+           offset += _record_size, ++record_num) {
+        if (VisitRecord(buffer.data() + offset, func) != 0) {
+          return -1;
+        }
+      }
+      remain = valid - offset;
+      if (remain > 0) {
+        memmove(buffer.data(), buffer.data() + offset, remain);
+      }
+    }
+    if (remain != 0) {
+      LOG(ERROR) << "SparseShardBinaryReader truncated file, path: " << _path;
+      return -1;
+    }
+    return record_num;
+  }
+
+  void Close() {
+    if (_mmap_data != nullptr) {
+      munmap(const_cast<char*>(_mmap_data), _mmap_size);
+      _mmap_data = nullptr;
+      _mmap_size = 0;
+    }
+    if (_channel != nullptr) {
+      _channel->close();
+      _channel.reset();
+    }
+  }
+
+  uint32_t ValueDim() const { return _value_dim; }
+  uint64_t Sequence() const { return _sequence; }
+
+ private:
+  int OpenMmap() {
+    int fd = open(_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(SparseShardBinaryHeader)) {
+      ::close(fd);
+      return -1;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return -1;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    _mmap_data = reinterpret_cast<const char*>(data);
+    _mmap_size = st.st_size;
+    return 0;
+  }
+
+  int CheckHeader(const SparseShardBinaryHeader& header,
+                  uint32_t expect_value_dim) {
+    if (header.magic != kSparseShardBinaryMagic ||
+        header.version != kSparseShardBinaryVersion) {
+      LOG(ERROR) << "SparseShardBinaryReader bad magic or version, path: "
+                 << _path << " magic: " << header.magic
+                 << " version: " << header.version;
+      return -1;
+    }
+    if (header.value_dim != expect_value_dim ||
+        header.record_size != SparseShardBinaryRecordSize(header.value_dim)) {
+      LOG(ERROR) << "SparseShardBinaryReader value dim mismatch, path: "
+                 << _path << " file value_dim: " << header.value_dim
+                 << " accessor value_dim: " << expect_value_dim;
+      return -1;
+    }
+    _value_dim = header.value_dim;
+    _record_size = header.record_size;
+    _sequence = header.reserved[0];
+    return 0;
+  }
+
+  template <class Func>
+  int VisitRecord(const char* record, Func&& func) {
+    uint64_t key;
+    uint32_t value_size;
+    memcpy(&key, record, sizeof(uint64_t));
+    memcpy(&value_size, record + sizeof(uint64_t), sizeof(uint32_t));
+    if (value_size > _value_dim) {
+      LOG(ERROR) << "SparseShardBinaryReader bad value size " << value_size
+                 << ", path: " << _path;
+      return -1;
+    }
+    func(key,
+         reinterpret_cast<const float*>(record + sizeof(uint64_t) +
+                                        2 * sizeof(uint32_t)),
+         value_size);
+    return 0;
+  }
+
+  std::string _path;
+  uint32_t _value_dim = 0;
+  uint32_t _record_size = 0;
+  uint64_t _sequence = 0;
+  const char* _mmap_data = nullptr;
+  size_t _mmap_size = 0;
+  std::shared_ptr<FsReadChannel> _channel;
+};
+
+// Converts a text shard ("key value_string" per line) to the binary layout.
+// Returns the number of converted feasigns, or -1 on failure.
+inline int64_t ConvertSparseShardTextToBinary(
+    AfsClient* afs_client,
+    ValueAccessor* accessor,
+    const FsChannelConfig& text_config,
+    const FsChannelConfig& binary_config) {
+  uint32_t value_dim = accessor->GetAccessorInfo().size / sizeof(float);
+  int err_no = 0;
+  auto read_channel = afs_client->open_r(text_config, 0, &err_no);
+  auto write_channel = afs_client->open_w(binary_config, 0, &err_no);
+  SparseShardBinaryWriter writer(write_channel, value_dim);
+  if (writer.WriteHeader() != 0) {
+    return -1;
+  }
+  std::vector<float> value(value_dim);
+  std::string line_data;
+  char* end = nullptr;
+  while (read_channel->read_line(line_data) == 0 && line_data.size() > 1) {
+    uint64_t key = std::strtoul(line_data.data(), &end, 10);
+    int parse_size = accessor->ParseFromString(++end, value.data());
+    if (writer.Append(key, value.data(), parse_size) != 0) {
+      return -1;
+    }
+  }
+  int ret = writer.Flush();
+  read_channel->close();
+  write_channel->close();
+  if (ret != 0 || err_no == -1) {
+    return -1;
+  }
+  return static_cast<int64_t>(writer.RecordNum());
+}
+
+// Converts a binary shard back to the text layout written by
+// MemorySparseTable::Save. Returns the number of converted feasigns, or -1
+// on failure.
+inline int64_t ConvertSparseShardBinaryToText(
+    AfsClient* afs_client,
+    ValueAccessor* accessor,
+    const FsChannelConfig& binary_config,
+    const FsChannelConfig& text_config) {
+  uint32_t value_dim = accessor->GetAccessorInfo().size / sizeof(float);
+  int err_no = 0;
+  SparseShardBinaryReader reader;
+  if (reader.Open(afs_client, binary_config, value_dim, &err_no) != 0) {
+    return -1;
+  }
+  auto write_channel = afs_client->open_w(text_config, 0, &err_no);
+  bool is_write_failed = false;
+  int64_t record_num = reader.ForEach(
+      [&](uint64_t key, const float* value, uint32_t value_size) {
+        if (is_write_failed) {
+          return;
+        }
+        std::string format_value =
+            accessor->ParseToString(value, static_cast<int>(value_size));
+        if (0 != write_channel->write_line(::paddle::string::format_string(
+                     "%lu %s", key, format_value.c_str()))) {
+          is_write_failed = true;
+        }
+      });
+  write_channel->close();
+  if (record_num < 0 || is_write_failed || err_no == -1) {
+    return -1;
+  }
+  return record_num;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,282 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_edges.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+#include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
+#include "paddle/fluid/platform/enforce.h"
+namespace paddle {
+namespace distributed {
+
+namespace {
+// "PDGCSR01", followed by node_num, edge_num and has_weight as uint64_t.
+constexpr uint64_t kGraphCsrMagic = 0x3130525343474450ULL;
+constexpr size_t kGraphCsrHeaderSize = 4 * sizeof(uint64_t);
+// Rows with at most this many neighbors are sampled by a partial shuffle of
+// a thread local permutation, larger rows by the sparse swap map.
+constexpr int kDenseShuffleLimit = 4096;
+}  // namespace
+
+GraphCsrEdges::~GraphCsrEdges() { unmap(); }
+
+void GraphCsrEdges::build(const std::vector<Node *> &nodes,
+                          bool with_weight) {
+  // Read everything before releasing the current arrays, the nodes may be
+  // packed into this object already.
+  std::vector<uint64_t> offsets(nodes.size() + 1, 0);
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    offsets[i + 1] = offsets[i] + nodes[i]->get_neighbor_size();
+  }
+  std::vector<uint64_t> ids(offsets.back());
+  std::vector<phi::dtype::float16> weights(with_weight ? ids.size() : 0);
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    size_t degree = offsets[i + 1] - offsets[i];
+    uint64_t *row_ids = ids.data() + offsets[i];
+    for (size_t j = 0; j < degree; ++j) {
+      row_ids[j] = nodes[i]->get_neighbor_id(j);
+    }
+    if (with_weight) {
+      phi::dtype::float16 *row_weights = weights.data() + offsets[i];
+      for (size_t j = 0; j < degree; ++j) {
+        float weight = nodes[i]->get_neighbor_weight(j);
+        row_weights[j] = static_cast<phi::dtype::float16>(weight);
+      }
+    }
+  }
+
+  unmap();
+  offset_buf_.swap(offsets);
+  id_buf_.swap(ids);
+  weight_buf_.swap(weights);
+  node_num_ = nodes.size();
+  edge_num_ = id_buf_.size();
+  reset_pointers();
+  if (!with_weight) {
+    weights_ = nullptr;
+  }
+  build_alias_tables();
+}
+
+void GraphCsrEdges::set_sample_type(const std::string &sample_type) {
+  sample_type_ = sample_type;
+  weighted_sample_ = sample_type == "weighted" || sample_type == "alias";
+  build_alias_tables();
+}
+
+void GraphCsrEdges::build_alias_tables() {
+  if (sample_type_ != "alias" || !has_weight()) {
+    std::vector<float>().swap(alias_prob_);
+    std::vector<int>().swap(alias_);
+    return;
+  }
+  alias_prob_.resize(edge_num_);
+  alias_.resize(edge_num_);
+  std::vector<float> weights;
+  for (size_t row = 0; row < node_num_; ++row) {
+    size_t n = degree(row);
+    weights.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      weights[i] = neighbor_weight(row, i);
+    }
+    build_alias_table(weights.data(),
+                      static_cast<int>(n),
+                      alias_prob_.data() + offsets_[row],
+                      alias_.data() + offsets_[row]);
+  }
+}
+
+void GraphCsrEdges::map_to_file(const std::string &path) {
+  uint64_t header[4] = {kGraphCsrMagic,
+                        static_cast<uint64_t>(node_num_),
+                        static_cast<uint64_t>(edge_num_),
+                        static_cast<uint64_t>(has_weight())};
+  size_t offsets_size = (node_num_ + 1) * sizeof(uint64_t);
+  size_t ids_size = edge_num_ * sizeof(uint64_t);
+  size_t weights_size =
+      has_weight() ? edge_num_ * sizeof(phi::dtype::float16) : 0;
+  size_t file_size = kGraphCsrHeaderSize + offsets_size + ids_size +
+                     weights_size;
+
+  // Write a new file and rename it, so that the file mapped by this object
+  // is never truncated under the mapping.
+  std::string tmp_path = path + ".tmp";
+  std::ofstream fout(tmp_path, std::ios::binary | std::ios::trunc);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fout),
+                    true,
+                    paddle::platform::errors::Unavailable(
+                        "Cannot open %s to save the graph edges.", tmp_path));
+  fout.write(reinterpret_cast<const char *>(header), kGraphCsrHeaderSize);
+  fout.write(reinterpret_cast<const char *>(offsets_), offsets_size);
+  fout.write(reinterpret_cast<const char *>(ids_), ids_size);
+  if (weights_size > 0) {
+    fout.write(reinterpret_cast<const char *>(weights_), weights_size);
+  }
+  fout.close();
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fout),
+                    true,
+                    paddle::platform::errors::Unavailable(
+                        "Failed to save the graph edges to %s.", tmp_path));
+  PADDLE_ENFORCE_EQ(
+      std::rename(tmp_path.c_str(), path.c_str()),
+      0,
+      paddle::platform::errors::Unavailable(
+          "Failed to rename %s to %s.", tmp_path, path));
+
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(fd,
+                    0,
+                    paddle::platform::errors::Unavailable(
+                        "Cannot open %s to map the graph edges.", path));
+  void *data = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(data,
+                    MAP_FAILED,
+                    paddle::platform::errors::Unavailable(
+                        "Failed to map %s of %d bytes.", path, file_size));
+
+  bool with_weight = has_weight();
+  unmap();
+  std::vector<uint64_t>().swap(offset_buf_);
+  std::vector<uint64_t>().swap(id_buf_);
+  std::vector<phi::dtype::float16>().swap(weight_buf_);
+  mapped_ = data;
+  mapped_size_ = file_size;
+  reset_pointers();
+  if (!with_weight) {
+    weights_ = nullptr;
+  }
+}
+
+void GraphCsrEdges::reset_pointers() {
+  if (mapped_ != nullptr) {
+    const char *data = static_cast<const char *>(mapped_);
+    offsets_ = reinterpret_cast<const uint64_t *>(data + kGraphCsrHeaderSize);
+    ids_ = offsets_ + node_num_ + 1;
+    weights_ = reinterpret_cast<const phi::dtype::float16 *>(ids_ + edge_num_);
+  } else {
+    offsets_ = offset_buf_.data();
+    ids_ = id_buf_.data();
+    weights_ = weight_buf_.data();
+  }
+}
+
+void GraphCsrEdges::unmap() {
+  if (mapped_ != nullptr) {
+    munmap(mapped_, mapped_size_);
+    mapped_ = nullptr;
+    mapped_size_ = 0;
+  }
+}
+
+size_t GraphCsrEdges::memory_size() const {
+  if (offsets_ == nullptr) {
+    return 0;
+  }
+  return (node_num_ + 1) * sizeof(uint64_t) + edge_num_ * sizeof(uint64_t) +
+         (has_weight() ? edge_num_ * sizeof(phi::dtype::float16) : 0) +
+         alias_prob_.size() * sizeof(float) + alias_.size() * sizeof(int);
+}
+
+std::vector<int> GraphCsrEdges::sample_k(
+    size_t row, int k, const std::shared_ptr<std::mt19937_64> rng) const {
+  std::vector<int> sample_result;
+  append_sample_k(row, k, rng, &sample_result);
+  return sample_result;
+}
+
+void GraphCsrEdges::append_sample_k(size_t row,
+                                    int k,
+                                    const std::shared_ptr<std::mt19937_64> rng,
+                                    std::vector<int> *result) const {
+  int n = static_cast<int>(degree(row));
+  if (k >= n) {
+    for (int i = 0; i < n; ++i) {
+      result->push_back(i);
+    }
+    return;
+  }
+  if (k <= 0) {
+    return;
+  }
+  result->reserve(result->size() + k);
+
+  if (has_weight() && weighted_sample_) {
+    const phi::dtype::float16 *weights = weights_ + offsets_[row];
+    auto weight = [weights](int i) -> float {
+      return static_cast<float>(weights[i]);
+    };
+    if (!alias_.empty()) {
+      alias_sample_k(alias_prob_.data() + offsets_[row],
+                     alias_.data() + offsets_[row],
+                     n,
+                     k,
+                     weight,
+                     rng.get(),
+                     result);
+    } else {
+      weighted_sample_k_by_keys(
+          n, k, weight, rng.get(), result->size(), result);
+    }
+    return;
+  }
+
+  if (n <= kDenseShuffleLimit) {
+    thread_local std::vector<int> perm;
+    perm.resize(n);
+    std::iota(perm.begin(), perm.end(), 0);
+    for (int i = 0; i < k; ++i) {
+      std::uniform_int_distribution<int> distrib(i, n - 1);
+      std::swap(perm[i], perm[distrib(*rng)]);
+      result->push_back(perm[i]);
+    }
+    return;
+  }
+
+  // The same as RandomSampler, a partial Fisher-Yates shuffle which records
+  // the swapped positions only.
+  std::unordered_map<int, int> replace_map;
+  while (k--) {
+    std::uniform_int_distribution<int> distrib(0, n - 1);
+    int rand_int = distrib(*rng);
+    auto iter = replace_map.find(rand_int);
+    if (iter == replace_map.end()) {
+      result->push_back(rand_int);
+    } else {
+      result->push_back(iter->second);
+    }
+
+    iter = replace_map.find(n - 1);
+    if (iter == replace_map.end()) {
+      replace_map[rand_int] = n - 1;
+    } else {
+      replace_map[rand_int] = iter->second;
+    }
+    --n;
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,110 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/phi/common/float16.h"
+namespace paddle {
+namespace distributed {
+
+class Node;
+
+// The neighbors of the nodes of a GraphShard packed in the CSR format: the
+// neighbors of row i are ids[offsets[i], offsets[i + 1]), with the optional
+// weights stored as fp16 in the same order. Compared with a GraphEdgeBlob
+// per node, this takes three allocations per shard instead of two or three
+// per node, and the neighbors of a node are contiguous with its siblings.
+//
+// The arrays are immutable once built. They can be moved to a file and
+// mapped back, so that the pages can be shared and evicted by the kernel.
+class GraphCsrEdges {
+ public:
+  GraphCsrEdges() {}
+  ~GraphCsrEdges();
+  GraphCsrEdges(const GraphCsrEdges &) = delete;
+  GraphCsrEdges &operator=(const GraphCsrEdges &) = delete;
+
+  // Packs the neighbors of nodes, row i holds the neighbors of nodes[i].
+  void build(const std::vector<Node *> &nodes, bool with_weight);
+  // Writes the arrays to path and maps the file back in place of them.
+  void map_to_file(const std::string &path);
+
+  size_t node_num() const { return node_num_; }
+  size_t edge_num() const { return edge_num_; }
+  bool has_weight() const { return weights_ != nullptr; }
+  bool is_mapped() const { return mapped_ != nullptr; }
+  // The bytes of the arrays, either in the heap or mapped from the file.
+  size_t memory_size() const;
+
+  size_t degree(size_t row) const {
+    return offsets_[row + 1] - offsets_[row];
+  }
+  uint64_t neighbor_id(size_t row, size_t i) const {
+    return ids_[offsets_[row] + i];
+  }
+  float neighbor_weight(size_t row, size_t i) const {
+    return weights_ == nullptr
+               ? 1.0f
+               : static_cast<float>(weights_[offsets_[row] + i]);
+  }
+
+  // Samples min(k, degree) distinct neighbors of row, uniformly for the
+  // "random" sample type, or with the probabilities proportional to the
+  // weights for "weighted" and "alias". Returns the positions of the
+  // neighbors in the row.
+  std::vector<int> sample_k(size_t row,
+                            int k,
+                            const std::shared_ptr<std::mt19937_64> rng) const;
+  // The same as sample_k, but appends the positions to result.
+  void append_sample_k(size_t row,
+                       int k,
+                       const std::shared_ptr<std::mt19937_64> rng,
+                       std::vector<int> *result) const;
+  // "alias" builds the alias tables of all the rows, which take 8 bytes per
+  // edge in the heap even if the arrays are mapped.
+  void set_sample_type(const std::string &sample_type);
+  const std::string &sample_type() const { return sample_type_; }
+
+ private:
+  void reset_pointers();
+  void unmap();
+  void build_alias_tables();
+
+  std::vector<uint64_t> offset_buf_;
+  std::vector<uint64_t> id_buf_;
+  std::vector<phi::dtype::float16> weight_buf_;
+
+  const uint64_t *offsets_ = nullptr;
+  const uint64_t *ids_ = nullptr;
+  const phi::dtype::float16 *weights_ = nullptr;
+  size_t node_num_ = 0;
+  size_t edge_num_ = 0;
+  std::string sample_type_ = "random";
+  bool weighted_sample_ = false;
+  // the alias tables of the rows, indexed as the ids
+  std::vector<float> alias_prob_;
+  std::vector<int> alias_;
+
+  void *mapped_ = nullptr;
+  size_t mapped_size_ = 0;
+};
+
+}  // namespace distributed
+}  // namespace paddle
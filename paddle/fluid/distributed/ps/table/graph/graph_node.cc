@@ -57,6 +57,9 @@ int FeatureNode::get_size(bool need_feature) {
 }
 
 void GraphNode::build_edges(bool is_weighted) {
+  if (csr_edges != nullptr) {
+    unpack_edges();
+  }
   if (edges == nullptr) {
     if (is_weighted == true) {
       edges = new WeightedGraphEdgeBlob();
@@ -66,16 +69,60 @@ void GraphNode::build_edges(bool is_weighted) {
   }
 }
 void GraphNode::build_sampler(std::string sample_type) {
-  if (sampler != nullptr) {
+  if (sampler != nullptr || csr_edges != nullptr) {
     return;
   }
   if (sample_type == "random") {
     sampler = new RandomSampler();
   } else if (sample_type == "weighted") {
     sampler = new WeightedSampler();
+  } else if (sample_type == "alias") {
+    sampler = new AliasSampler();
   }
   sampler->build(edges);
 }
+void GraphNode::pack_edges(const GraphCsrEdges* csr_edges, uint32_t row) {
+  if (sampler != nullptr) {
+    delete sampler;
+    sampler = nullptr;
+  }
+  if (edges != nullptr) {
+    delete edges;
+    edges = nullptr;
+  }
+  this->csr_edges = csr_edges;
+  this->csr_row = row;
+}
+void GraphNode::unpack_edges() {
+  const GraphCsrEdges* packed = csr_edges;
+  size_t degree = packed->degree(csr_row);
+  if (packed->has_weight()) {
+    edges = new WeightedGraphEdgeBlob();
+  } else {
+    edges = new GraphEdgeBlob();
+  }
+  for (size_t i = 0; i < degree; ++i) {
+    edges->add_edge(packed->neighbor_id(csr_row, i),
+                    packed->neighbor_weight(csr_row, i));
+  }
+  csr_edges = nullptr;
+  build_sampler(packed->sample_type());
+}
+void sample_k_batch(const std::vector<Node*>& nodes,
+                    int k,
+                    const std::shared_ptr<std::mt19937_64> rng,
+                    std::vector<int>* result,
+                    std::vector<size_t>* offsets) {
+  result->clear();
+  offsets->resize(nodes.size() + 1);
+  (*offsets)[0] = 0;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (nodes[i] != nullptr) {
+      nodes[i]->append_sample_k(k, rng, result);
+    }
+    (*offsets)[i + 1] = result->size();
+  }
+}
 void FeatureNode::to_buffer(char* buffer, bool need_feature) {
   memcpy(buffer, &id, id_size);
   buffer += id_size;
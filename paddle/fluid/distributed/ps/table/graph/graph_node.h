@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "glog/logging.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_csr_edges.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_weighted_sampler.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/string/string_helper.h"
@@ -44,10 +45,19 @@ class Node {
   virtual void build_edges(bool is_weighted UNUSED) {}
   virtual void build_sampler(std::string sample_type UNUSED) {}
   virtual void add_edge(uint64_t id UNUSED, float weight UNUSED) {}
+  virtual void pack_edges(const GraphCsrEdges *csr_edges UNUSED,
+                          uint32_t row UNUSED) {}
   virtual std::vector<int> sample_k(
       int k UNUSED, const std::shared_ptr<std::mt19937_64> rng UNUSED) {
     return std::vector<int>();
   }
+  // The same as sample_k, but appends the samples to result.
+  virtual void append_sample_k(int k,
+                               const std::shared_ptr<std::mt19937_64> rng,
+                               std::vector<int> *result) {
+    std::vector<int> res = sample_k(k, rng);
+    result->insert(result->end(), res.begin(), res.end());
+  }
   virtual uint64_t get_neighbor_id(int idx UNUSED) { return 0; }
 #ifdef PADDLE_WITH_CUDA
   virtual half get_neighbor_weight(int idx UNUSED) { return 1.; }
@@ -98,23 +108,67 @@ class GraphNode : public Node {
   virtual void build_edges(bool is_weighted);
   virtual void build_sampler(std::string sample_type);
   virtual void add_edge(uint64_t id, float weight) {
+    if (csr_edges != nullptr) {
+      unpack_edges();
+    }
     edges->add_edge(id, weight);
   }
+  // Reads the neighbors from row of csr_edges from now on, the edge blob and
+  // the sampler of the node are released.
+  virtual void pack_edges(const GraphCsrEdges *csr_edges, uint32_t row);
   virtual std::vector<int> sample_k(
       int k, const std::shared_ptr<std::mt19937_64> rng) {
+    if (csr_edges != nullptr) {
+      return csr_edges->sample_k(csr_row, k, rng);
+    }
     return sampler->sample_k(k, rng);
   }
-  virtual uint64_t get_neighbor_id(int idx) { return edges->get_id(idx); }
+  virtual void append_sample_k(int k,
+                               const std::shared_ptr<std::mt19937_64> rng,
+                               std::vector<int> *result) {
+    if (csr_edges != nullptr) {
+      csr_edges->append_sample_k(csr_row, k, rng, result);
+    } else {
+      sampler->append_sample_k(k, rng, result);
+    }
+  }
+  virtual uint64_t get_neighbor_id(int idx) {
+    if (csr_edges != nullptr) {
+      return csr_edges->neighbor_id(csr_row, idx);
+    }
+    return edges->get_id(idx);
+  }
 #ifdef PADDLE_WITH_CUDA
-  virtual half get_neighbor_weight(int idx) { return edges->get_weight(idx); }
+  virtual half get_neighbor_weight(int idx) {
+    if (csr_edges != nullptr) {
+      return (half)(csr_edges->neighbor_weight(csr_row, idx));
+    }
+    return edges->get_weight(idx);
+  }
 #else
-  virtual float get_neighbor_weight(int idx) { return edges->get_weight(idx); }
+  virtual float get_neighbor_weight(int idx) {
+    if (csr_edges != nullptr) {
+      return csr_edges->neighbor_weight(csr_row, idx);
+    }
+    return edges->get_weight(idx);
+  }
 #endif
-  virtual size_t get_neighbor_size() { return edges->size(); }
+  virtual size_t get_neighbor_size() {
+    if (csr_edges != nullptr) {
+      return csr_edges->degree(csr_row);
+    }
+    return edges->size();
+  }
+  bool is_packed() const { return csr_edges != nullptr; }
 
  protected:
+  // Copies the packed neighbors back to an edge blob before modifying them.
+  void unpack_edges();
+
   Sampler *sampler;
   GraphEdgeBlob *edges;
+  const GraphCsrEdges *csr_edges = nullptr;
+  uint32_t csr_row = 0;
 };
 
 class FeatureNode : public Node {
@@ -548,5 +602,14 @@ class FloatFeatureNode : public FeatureNode {
   uint8_t float_feature_start_idx = 0;
 };
 
+// Samples k neighbors of every node at once into result, the positions
+// sampled in the neighbors of nodes[i] are result[offsets[i], offsets[i + 1]).
+// A null node has no sample.
+void sample_k_batch(const std::vector<Node *> &nodes,
+                    int k,
+                    const std::shared_ptr<std::mt19937_64> rng,
+                    std::vector<int> *result,
+                    std::vector<size_t> *offsets);
+
 }  // namespace distributed
 }  // namespace paddle
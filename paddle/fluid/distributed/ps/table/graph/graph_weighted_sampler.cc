@@ -161,5 +161,83 @@ int WeightedSampler::sample(
   subtract_count_map[this]++;
   return return_idx;
 }
+
+void build_alias_table(const float *weights, int n, float *prob, int *alias) {
+  double sum = 0;
+  for (int i = 0; i < n; i++) {
+    if (weights[i] > 0) sum += weights[i];
+  }
+  if (sum <= 0) {
+    for (int i = 0; i < n; i++) {
+      prob[i] = 1.0;
+      alias[i] = i;
+    }
+    return;
+  }
+  // scaled[i] is the weight of item i relative to the mean weight
+  std::vector<double> scaled(n);
+  std::vector<int> small, large;
+  for (int i = 0; i < n; i++) {
+    scaled[i] = weights[i] > 0 ? weights[i] * n / sum : 0;
+    if (scaled[i] < 1.0) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+  while (!small.empty() && !large.empty()) {
+    int less = small.back();
+    int more = large.back();
+    small.pop_back();
+    prob[less] = scaled[less];
+    alias[less] = more;
+    scaled[more] = scaled[more] + scaled[less] - 1.0;
+    if (scaled[more] < 1.0) {
+      large.pop_back();
+      small.push_back(more);
+    }
+  }
+  // the rest are 1 up to the rounding errors
+  for (int i : large) {
+    prob[i] = 1.0;
+    alias[i] = i;
+  }
+  for (int i : small) {
+    prob[i] = 1.0;
+    alias[i] = i;
+  }
+}
+
+void AliasSampler::build(GraphEdgeBlob *edges) {
+  this->edges = edges;
+  int n = edges->size();
+  std::vector<float> weights(n);
+  for (int i = 0; i < n; i++) {
+    weights[i] = edges->get_weight(i);
+  }
+  prob.resize(n);
+  alias.resize(n);
+  build_alias_table(weights.data(), n, prob.data(), alias.data());
+}
+
+std::vector<int> AliasSampler::sample_k(
+    int k, const std::shared_ptr<std::mt19937_64> rng) {
+  std::vector<int> sample_result;
+  append_sample_k(k, rng, &sample_result);
+  return sample_result;
+}
+
+void AliasSampler::append_sample_k(int k,
+                                   const std::shared_ptr<std::mt19937_64> rng,
+                                   std::vector<int> *result) {
+  alias_sample_k(
+      prob.data(),
+      alias.data(),
+      static_cast<int>(prob.size()),
+      k,
+      [this](int i) -> float { return edges->get_weight(i); },
+      rng.get(),
+      result);
+}
 }  // namespace distributed
 }  // namespace paddle
@@ -13,10 +13,14 @@
 // limitations under the License.
 
 #pragma once
+#include <algorithm>
 #include <ctime>
+#include <limits>
 #include <memory>
 #include <random>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/distributed/ps/table/graph/graph_edge.h"
@@ -29,6 +33,14 @@ class Sampler {
   virtual void build(GraphEdgeBlob *edges) = 0;
   virtual std::vector<int> sample_k(
       int k, const std::shared_ptr<std::mt19937_64> rng) = 0;
+  // The same as sample_k, but appends the samples to result, so that the
+  // caller can reuse result for many nodes.
+  virtual void append_sample_k(int k,
+                               const std::shared_ptr<std::mt19937_64> rng,
+                               std::vector<int> *result) {
+    std::vector<int> res = sample_k(k, rng);
+    result->insert(result->end(), res.begin(), res.end());
+  }
 };
 
 class RandomSampler : public Sampler {
@@ -62,5 +74,123 @@ class WeightedSampler : public Sampler {
       std::unordered_map<WeightedSampler *, int> &subtract_count_map,  // NOLINT
       float &subtract);                                                // NOLINT
 };
+
+// Vose's alias method. Builds the tables of n items from weights, so that an
+// item is sampled by alias_sample in O(1). The items of weight 0 are never
+// sampled, unless all the weights are 0 and the items are sampled uniformly.
+void build_alias_table(const float *weights, int n, float *prob, int *alias);
+
+inline int alias_sample(const float *prob,
+                        const int *alias,
+                        int n,
+                        std::mt19937_64 *rng) {
+  std::uniform_int_distribution<int> column(0, n - 1);
+  std::uniform_real_distribution<float> coin(0, 1.0);
+  int i = column(*rng);
+  return coin(*rng) < prob[i] ? i : alias[i];
+}
+
+// Appends k of the n items to result, sampled without replacement with the
+// probabilities proportional to weight(i), and skipping the items already in
+// result[begin, result->size()). This keeps the k smallest of exp(1) /
+// weight, which takes O(n) time.
+template <typename WeightFunc>
+void weighted_sample_k_by_keys(int n,
+                               int k,
+                               WeightFunc weight,
+                               std::mt19937_64 *rng,
+                               size_t begin,
+                               std::vector<int> *result) {
+  thread_local std::vector<std::pair<float, int>> keys;
+  thread_local std::vector<char> sampled;
+  sampled.assign(n, 0);
+  for (size_t i = begin; i < result->size(); i++) {
+    sampled[(*result)[i]] = 1;
+  }
+  keys.clear();
+  std::exponential_distribution<float> distrib(1.0f);
+  for (int i = 0; i < n; i++) {
+    if (sampled[i]) continue;
+    float w = weight(i);
+    keys.emplace_back(w > 0 ? distrib(*rng) / w
+                            : std::numeric_limits<float>::infinity(),
+                      i);
+  }
+  k = std::min(k, static_cast<int>(keys.size()));
+  std::nth_element(keys.begin(), keys.begin() + k, keys.end());
+  for (int i = 0; i < k; i++) {
+    result->push_back(keys[i].second);
+  }
+}
+
+// Appends min(k, n) distinct items to result, sampled without replacement
+// with the probabilities proportional to weight(i). The items are drawn from
+// the alias tables and redrawn if sampled already, which has the same
+// distribution as removing the sampled items. When the redraws are too many,
+// e.g. for k close to n or a few dominant weights, the rest of the items are
+// sampled by weighted_sample_k_by_keys.
+template <typename WeightFunc>
+void alias_sample_k(const float *prob,
+                    const int *alias,
+                    int n,
+                    int k,
+                    WeightFunc weight,
+                    std::mt19937_64 *rng,
+                    std::vector<int> *result) {
+  size_t begin = result->size();
+  if (k >= n) {
+    for (int i = 0; i < n; i++) {
+      result->push_back(i);
+    }
+    return;
+  }
+  if (k <= 0) {
+    return;
+  }
+  int redraws = 0;
+  int max_redraws = 4 * k + 16;
+  if (2 * k <= n) {
+    // a linear search is faster than hashing for the usual small k
+    thread_local std::unordered_set<int> sampled;
+    bool use_set = k > 64;
+    sampled.clear();
+    while (static_cast<int>(result->size() - begin) < k &&
+           redraws < max_redraws) {
+      int x = alias_sample(prob, alias, n, rng);
+      bool exists =
+          use_set ? !sampled.insert(x).second
+                  : std::find(result->begin() + begin, result->end(), x) !=
+                        result->end();
+      if (exists) {
+        ++redraws;
+      } else {
+        result->push_back(x);
+      }
+    }
+  }
+  int rest = k - static_cast<int>(result->size() - begin);
+  if (rest > 0) {
+    weighted_sample_k_by_keys(n, rest, weight, rng, begin, result);
+  }
+}
+
+// Samples the neighbors by the alias method, taking O(k) time for k much
+// less than the degree and 8 bytes more per neighbor than RandomSampler.
+class AliasSampler : public Sampler {
+ public:
+  AliasSampler() : edges(nullptr) {}
+  virtual ~AliasSampler() {}
+  virtual void build(GraphEdgeBlob *edges);
+  virtual std::vector<int> sample_k(int k,
+                                    const std::shared_ptr<std::mt19937_64> rng);
+  virtual void append_sample_k(int k,
+                               const std::shared_ptr<std::mt19937_64> rng,
+                               std::vector<int> *result);
+  GraphEdgeBlob *edges;
+
+ private:
+  std::vector<float> prob;
+  std::vector<int> alias;
+};
 }  // namespace distributed
 }  // namespace paddle
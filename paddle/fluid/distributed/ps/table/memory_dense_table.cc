@@ -138,6 +138,20 @@ int32_t MemoryDenseTable::Pull(TableContext &context) {
 
 int32_t MemoryDenseTable::Push(TableContext &context) {
   CHECK(context.value_type == Dense);
+  if (context.push_context.compressed_values != nullptr) {
+    thread_local std::vector<float> values;
+    if (context.push_context.compress_header.row_dim != context.num ||
+        !PushCompressDecode(context.push_context.compress_header,
+                            context.push_context.compressed_values,
+                            context.push_context.compressed_size,
+                            1,
+                            &values)) {
+      LOG(ERROR) << "malformed compressed push of " << context.num
+                 << " values to table " << _config.table_id();
+      return -1;
+    }
+    return PushDense(values.data(), context.num);
+  }
   if (context.push_context.values != nullptr) {
     if (!context.push_context.is_param) {
       return PushDense(context.push_context.values, context.num);
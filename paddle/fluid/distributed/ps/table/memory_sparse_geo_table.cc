@@ -139,6 +139,9 @@ int32_t MemorySparseGeoTable::Initialize() {
   }
 
   _local_shards.reset(new shard_type[_task_pool_size]);  // NOLINT
+  for (int i = 0; i < _task_pool_size; ++i) {
+    _local_shards[i].set_value_dim(_dim);
+  }
   return 0;
 }
 
@@ -26,7 +26,7 @@
 
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
-#include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
+#include "paddle/fluid/distributed/ps/table/depends/compact_feature_value.h"
 #include "paddle/fluid/distributed/ps/table/depends/geo_recorder.h"
 #include "paddle/fluid/string/string_helper.h"
 
@@ -37,7 +37,8 @@ class GeoRecorder;
 
 class MemorySparseGeoTable : public Table {
  public:
-  typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+  // the values are of _dim floats, which are kept in the records of the keys
+  typedef CompactSparseTableShard<uint64_t> shard_type;
   MemorySparseGeoTable() { _geo_recorder = nullptr; }
   virtual ~MemorySparseGeoTable() {}
 
@@ -13,12 +13,17 @@
 // limitations under the License.
 
 #include <omp.h>
+
+#include <algorithm>
+#include <map>
 #include <sstream>
+#include <type_traits>
 
 #include "glog/logging.h"
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/common/local_random.h"
 #include "paddle/fluid/distributed/common/topk_calculator.h"
+#include "paddle/fluid/distributed/ps/table/depends/sparse_binary_format.h"
 #include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
 #include "paddle/fluid/framework/archive.h"
 #include "paddle/fluid/framework/io/fs.h"
@@ -42,7 +47,29 @@ PD_DEFINE_int32(pserver_table_save_max_retry,
 namespace paddle {
 namespace distributed {
 
-int32_t MemorySparseTable::Initialize() {
+template <class KEY, class VALUE>
+static void SetShardValueDim(SparseTableShard<KEY, VALUE> *, size_t) {}
+
+// the values of the accessor size are kept inline, a larger value, e.g. of a
+// larger mf_dim of the dymf accessor, goes to an overflow block
+template <class KEY>
+static void SetShardValueDim(CompactSparseTableShard<KEY> *shard,
+                             size_t value_dim) {
+  shard->set_value_dim(value_dim);
+}
+
+template <class SHARD>
+std::unique_ptr<SHARD[]> MemorySparseTableBase<SHARD>::CreateShards(int num) {
+  std::unique_ptr<shard_type[]> shards(new shard_type[num]);  // NOLINT
+  size_t value_dim = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  for (int i = 0; i < num; ++i) {
+    SetShardValueDim(&shards[i], value_dim);
+  }
+  return shards;
+}
+
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::Initialize() {
   auto &profiler = CostProfiler::instance();
   profiler.register_profiler("pserver_sparse_update_all");
   profiler.register_profiler("pserver_sparse_select_all");
@@ -55,7 +82,8 @@ int32_t MemorySparseTable::Initialize() {
   return 0;
 }
 
-int32_t MemorySparseTable::InitializeValue() {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::InitializeValue() {
   _sparse_table_shard_num = static_cast<int>(_config.shard_num());
   _avg_local_shard_num =
       sparse_local_shard_num(_sparse_table_shard_num, _shard_num);
@@ -75,7 +103,11 @@ int32_t MemorySparseTable::InitializeValue() {
           << " _real_local_shard_num: " << _real_local_shard_num
           << " _task_pool_size:" << _task_pool_size;
 
-  _local_shards.reset(new shard_type[_real_local_shard_num]);
+  _local_shards = CreateShards(_real_local_shard_num);
+  _enable_delta_save = _config.enable_delta_save();
+  if (_enable_delta_save) {
+    _delta_erased_keys.resize(_real_local_shard_num);
+  }
 
   if (_config.enable_revert()) {
     // calculate merged shard number based on config param;
@@ -99,13 +131,22 @@ int32_t MemorySparseTable::InitializeValue() {
     LOG(INFO) << "merged shard info: [" << _m_sparse_table_shard_num << "|"
               << _m_avg_local_shard_num << "|" << _m_real_local_shard_num
               << "]";
-    _local_shards_new.reset(new shard_type[_real_local_shard_num]);  // NOLINT
+    _local_shards_new = CreateShards(_real_local_shard_num);
   }
   return 0;
 }
 
-int32_t MemorySparseTable::Load(const std::string &path,
-                                const std::string &param) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::Load(const std::string &path,
+                                           const std::string &param) {
+  // delta checkpoint
+  if (atoi(param.c_str()) == 6) {
+    return LoadDelta(path);
+  }
+  // the next delta save writes a new base
+  ClearDeltaKeys();
+  _delta_table_path.clear();
+
   std::string table_path = TableDir(path);
   auto file_list = _afs_client.list(table_path);
 
@@ -152,9 +193,13 @@ int32_t MemorySparseTable::Load(const std::string &path,
     channel_config.path = file_list[file_start_idx + i];
     VLOG(1) << "MemorySparseTable::load begin load " << channel_config.path
             << " into local shard " << i;
-    channel_config.converter = _value_accessor->Converter(load_param).converter;
-    channel_config.deconverter =
-        _value_accessor->Converter(load_param).deconverter;
+    bool is_binary_file = IsSparseShardBinaryFile(channel_config.path);
+    if (!is_binary_file) {
+      channel_config.converter =
+          _value_accessor->Converter(load_param).converter;
+      channel_config.deconverter =
+          _value_accessor->Converter(load_param).deconverter;
+    }
 
     bool is_read_failed = false;
     int retry_num = 0;
@@ -162,21 +207,27 @@ int32_t MemorySparseTable::Load(const std::string &path,
     do {
       is_read_failed = false;
       err_no = 0;
-      std::string line_data;
-      auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
-      char *end = NULL;
       auto &shard = _local_shards[i];
       try {
-        while (read_channel->read_line(line_data) == 0 &&
-               line_data.size() > 1) {
-          uint64_t key = std::strtoul(line_data.data(), &end, 10);
-          auto &value = shard[key];
-          value.resize(feature_value_size);
-          int parse_size =
-              _value_accessor->ParseFromString(++end, value.data());
-          value.resize(parse_size);
+        if (is_binary_file) {
+          if (LoadShardBinary(channel_config, &shard, &err_no) < 0) {
+            err_no = -1;
+          }
+        } else {
+          std::string line_data;
+          auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
+          char *end = NULL;
+          while (read_channel->read_line(line_data) == 0 &&
+                 line_data.size() > 1) {
+            uint64_t key = std::strtoul(line_data.data(), &end, 10);
+            auto &value = shard[key];
+            value.resize(feature_value_size);
+            int parse_size =
+                _value_accessor->ParseFromString(++end, value.data());
+            value.resize(parse_size);
+          }
+          read_channel->close();
         }
-        read_channel->close();
         if (err_no == -1) {
           ++retry_num;
           is_read_failed = true;
@@ -202,8 +253,47 @@ int32_t MemorySparseTable::Load(const std::string &path,
   return 0;
 }
 
-int32_t MemorySparseTable::LoadPatch(const std::vector<std::string> &file_list,
-                                     int load_param) {
+template <class SHARD>
+int64_t MemorySparseTableBase<SHARD>::LoadShardBinary(
+    const FsChannelConfig &channel_config, shard_type *shard, int *err_no) {
+  uint32_t value_dim = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  SparseShardBinaryReader reader;
+  if (reader.Open(&_afs_client, channel_config, value_dim, err_no) != 0) {
+    return -1;
+  }
+  return reader.ForEach(
+      [shard](uint64_t key, const float *data, uint32_t value_size) {
+        auto &value = (*shard)[key];
+        value.resize(value_size);
+        memcpy(value.data(), data, value_size * sizeof(float));
+      });
+}
+
+template <class SHARD>
+int64_t MemorySparseTableBase<SHARD>::SaveShardBinary(
+    shard_type *shard,
+    std::shared_ptr<FsWriteChannel> write_channel,
+    int save_param) {
+  uint32_t value_dim = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  SparseShardBinaryWriter writer(write_channel, value_dim);
+  if (writer.WriteHeader() != 0) {
+    return -1;
+  }
+  for (auto it = shard->begin(); it != shard->end(); ++it) {
+    if (_value_accessor->Save(it.value().data(), save_param) &&
+        writer.Append(it.key(), it.value().data(), it.value().size()) != 0) {
+      return -1;
+    }
+  }
+  if (writer.Flush() != 0) {
+    return -1;
+  }
+  return static_cast<int64_t>(writer.RecordNum());
+}
+
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::LoadPatch(
+    const std::vector<std::string> &file_list, int load_param) {
   if (!_config.enable_revert()) {
     LOG(INFO) << "MemorySparseTable should be enabled revert.";
     return 0;
@@ -302,18 +392,21 @@ int32_t MemorySparseTable::LoadPatch(const std::vector<std::string> &file_list,
   return 0;
 }
 
-void MemorySparseTable::Revert() {
+template <class SHARD>
+void MemorySparseTableBase<SHARD>::Revert() {
   for (int i = 0; i < _real_local_shard_num; ++i) {
     _local_shards_new[i].clear();
   }
 }
 
-void MemorySparseTable::CheckSavePrePatchDone() {
+template <class SHARD>
+void MemorySparseTableBase<SHARD>::CheckSavePrePatchDone() {
   _save_patch_model_thread.join();
 }
 
-int32_t MemorySparseTable::Save(const std::string &dirname,
-                                const std::string &param) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::Save(const std::string &dirname,
+                                           const std::string &param) {
   if (_real_local_shard_num == 0) {
     _local_show_threshold = -1;
     return 0;
@@ -326,12 +419,20 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
   // patch model
   if (save_param == 5) {
     _local_shards_patch_model.reset(_local_shards_new.release());
-    _local_shards_new.reset(new shard_type[_real_local_shard_num]);  // NOLINT
-    _save_patch_model_thread = std::thread(std::bind(
-        &MemorySparseTable::SavePatch, this, std::string(dirname), save_param));
+    _local_shards_new = CreateShards(_real_local_shard_num);
+    _save_patch_model_thread =
+        std::thread(std::bind(&MemorySparseTableBase<SHARD>::SavePatch,
+                              this,
+                              std::string(dirname),
+                              save_param));
     return 0;
   }
 
+  // delta checkpoint
+  if (save_param == 6) {
+    return SaveDelta(dirname);
+  }
+
   // cache model
   int64_t tk_size = LocalSize() * _config.sparse_table_cache_rate();
   TopkCalculator tk(_real_local_shard_num, tk_size);
@@ -342,6 +443,10 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
   std::atomic<uint32_t> feasign_size_all{0};
 
   size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  // binary shards are only written for checkpoint and batch model, xbox
+  // models keep the text format for downstream consumers
+  bool save_binary =
+      _config.save_binary() && (save_param == 0 || save_param == 3);
 
 #ifdef PADDLE_WITH_HETERPS
   int thread_num = _real_local_shard_num;
@@ -352,7 +457,15 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
 #pragma omp parallel for schedule(dynamic)
   for (int i = 0; i < _real_local_shard_num; ++i) {
     FsChannelConfig channel_config;
-    if (_config.compress_in_save() && (save_param == 0 || save_param == 3)) {
+    if (save_binary) {
+      channel_config.path =
+          ::paddle::string::format_string("%s/part-%03d-%05d%s",
+                                          table_path.c_str(),
+                                          _shard_idx,
+                                          file_start_idx + i,
+                                          PSERVER_BINARY_SAVE_SUFFIX);
+    } else if (_config.compress_in_save() &&
+               (save_param == 0 || save_param == 3)) {
       channel_config.path =
           ::paddle::string::format_string("%s/part-%03d-%05d.gz",
                                           table_path.c_str(),
@@ -364,9 +477,12 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
                                                             _shard_idx,
                                                             file_start_idx + i);
     }
-    channel_config.converter = _value_accessor->Converter(save_param).converter;
-    channel_config.deconverter =
-        _value_accessor->Converter(save_param).deconverter;
+    if (!save_binary) {
+      channel_config.converter =
+          _value_accessor->Converter(save_param).converter;
+      channel_config.deconverter =
+          _value_accessor->Converter(save_param).deconverter;
+    }
     bool is_write_failed = false;
     int feasign_size = 0;
     int retry_num = 0;
@@ -375,9 +491,7 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
 #ifdef PADDLE_WITH_GPU_GRAPH
     // for incremental training, batch_model increase unseenday before save
     if (save_param == 3) {
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-      }
+      UpdateShardStatAfterSave(i, save_param);
     }
 #endif
     do {
@@ -386,27 +500,40 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
       is_write_failed = false;
       auto write_channel =
           _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        if (_config.enable_sparse_table_cache() &&
-            (save_param == 1 || save_param == 2) &&
-            _value_accessor->Save(it.value().data(), 4)) {
-          CostTimer timer10("sprase table top push");
-          tk.push(i, _value_accessor->GetField(it.value().data(), "show"));
+      if (save_binary) {
+        int64_t save_size = SaveShardBinary(&shard, write_channel, save_param);
+        if (save_size < 0) {
+          ++retry_num;
+          is_write_failed = true;
+          LOG(ERROR)
+              << "MemorySparseTable save binary failed, retry it! path:"
+              << channel_config.path << " , retry_num=" << retry_num;
+        } else {
+          feasign_size = static_cast<int>(save_size);
         }
+      } else {
+        for (auto it = shard.begin(); it != shard.end(); ++it) {
+          if (_config.enable_sparse_table_cache() &&
+              (save_param == 1 || save_param == 2) &&
+              _value_accessor->Save(it.value().data(), 4)) {
+            CostTimer timer10("sprase table top push");
+            tk.push(i, _value_accessor->GetField(it.value().data(), "show"));
+          }
 
-        if (_value_accessor->Save(it.value().data(), save_param)) {
-          std::string format_value = _value_accessor->ParseToString(
-              it.value().data(), it.value().size());
-          if (0 != write_channel->write_line(::paddle::string::format_string(
-                       "%lu %s", it.key(), format_value.c_str()))) {
-            ++retry_num;
-            is_write_failed = true;
-            LOG(ERROR)
-                << "MemorySparseTable save prefix failed, retry it! path:"
-                << channel_config.path << " , retry_num=" << retry_num;
-            break;
+          if (_value_accessor->Save(it.value().data(), save_param)) {
+            std::string format_value = _value_accessor->ParseToString(
+                it.value().data(), it.value().size());
+            if (0 != write_channel->write_line(::paddle::string::format_string(
+                         "%lu %s", it.key(), format_value.c_str()))) {
+              ++retry_num;
+              is_write_failed = true;
+              LOG(ERROR)
+                  << "MemorySparseTable save prefix failed, retry it! path:"
+                  << channel_config.path << " , retry_num=" << retry_num;
+              break;
+            }
+            ++feasign_size;
           }
-          ++feasign_size;
         }
       }
       write_channel->close();
@@ -427,27 +554,31 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
     } while (is_write_failed);
     feasign_size_all += feasign_size;
 #ifndef PADDLE_WITH_GPU_GRAPH
-    for (auto it = shard.begin(); it != shard.end(); ++it) {
-      _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-    }
+    UpdateShardStatAfterSave(i, save_param);
 #else
     if (save_param != 3) {
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-      }
+      UpdateShardStatAfterSave(i, save_param);
     }
 #endif
     LOG(INFO) << "MemorySparseTable save prefix success, path: "
               << channel_config.path << " feasign_size: " << feasign_size;
   }
   _local_show_threshold = tk.top();
+  // a full save drops the keys tracked for the delta checkpoints, so that
+  // they do not pile up without delta saves, the next delta save writes a new
+  // base
+  if (save_param == 0 || save_param == 3) {
+    ClearDeltaKeys();
+    _delta_table_path.clear();
+  }
   // int32 may overflow need to change return value
   return 0;
 }
 
 #ifdef PADDLE_WITH_GPU_GRAPH
-int32_t MemorySparseTable::Save_v2(const std::string &dirname,
-                                   const std::string &param) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::Save_v2(const std::string &dirname,
+                                              const std::string &param) {
   auto *save_filtered_slots = _value_accessor->GetSaveFilteredSlots();
   if (save_filtered_slots == nullptr || (save_filtered_slots->size()) <= 0) {
     return Save(dirname, param);
@@ -465,12 +596,20 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
   // patch model
   if (save_param == 5) {
     _local_shards_patch_model.reset(_local_shards_new.release());
-    _local_shards_new.reset(new shard_type[_real_local_shard_num]);
-    _save_patch_model_thread = std::thread(std::bind(
-        &MemorySparseTable::SavePatch, this, std::string(dirname), save_param));
+    _local_shards_new = CreateShards(_real_local_shard_num);
+    _save_patch_model_thread =
+        std::thread(std::bind(&MemorySparseTableBase<SHARD>::SavePatch,
+                              this,
+                              std::string(dirname),
+                              save_param));
     return 0;
   }
 
+  // delta checkpoint
+  if (save_param == 6) {
+    return SaveDelta(dirname);
+  }
+
   // cache model
   int64_t tk_size = LocalSize() * _config.sparse_table_cache_rate();
   TopkCalculator tk(_real_local_shard_num, tk_size);
@@ -540,9 +679,7 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
 #ifdef PADDLE_WITH_GPU_GRAPH
     // for incremental training, batch_model increase unseenday before save
     if (save_param == 3) {
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-      }
+      UpdateShardStatAfterSave(i, save_param);
     }
 #endif
     do {
@@ -633,14 +770,10 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
     feasign_size_all += feasign_size;
     feasign_size_all_for_slot_feature += feasign_size_for_slot_feature;
 #ifndef PADDLE_WITH_GPU_GRAPH
-    for (auto it = shard.begin(); it != shard.end(); ++it) {
-      _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-    }
+    UpdateShardStatAfterSave(i, save_param);
 #else
     if (save_param != 3) {
-      for (auto it = shard.begin(); it != shard.end(); ++it) {
-        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
-      }
+      UpdateShardStatAfterSave(i, save_param);
     }
 #endif
     LOG(INFO) << "MemorySparseTable save prefix&feature success, path: "
@@ -649,12 +782,21 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
               << ", feature feasign size:" << feasign_size_for_slot_feature;
   }
   _local_show_threshold = tk.top();
+  // a full save drops the keys tracked for the delta checkpoints, so that
+  // they do not pile up without delta saves, the next delta save writes a new
+  // base
+  if (save_param == 0 || save_param == 3) {
+    ClearDeltaKeys();
+    _delta_table_path.clear();
+  }
   // int32 may overflow need to change return value
   return 0;
 }
 #endif
 
-int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::SavePatch(const std::string &path,
+                                                int save_param) {
   if (!_config.enable_revert()) {
     LOG(INFO) << "MemorySparseTable should be enabled revert.";
     return 0;
@@ -743,7 +885,378 @@ int32_t MemorySparseTable::SavePatch(const std::string &path, int save_param) {
   return 0;
 }
 
-int64_t MemorySparseTable::CacheShuffle(
+static std::string DeltaBasePath(const std::string &table_path,
+                                 int server_idx,
+                                 size_t file_idx) {
+  return ::paddle::string::format_string("%s/part-%03d-%05d%s",
+                                         table_path.c_str(),
+                                         server_idx,
+                                         file_idx,
+                                         PSERVER_BINARY_SAVE_SUFFIX);
+}
+
+static std::string DeltaShardPath(const std::string &table_path,
+                                  int server_idx,
+                                  size_t file_idx,
+                                  uint64_t seq) {
+  return ::paddle::string::format_string("%s/delta/part-%03d-%05d-%06lu%s",
+                                         table_path.c_str(),
+                                         server_idx,
+                                         file_idx,
+                                         seq,
+                                         PSERVER_BINARY_SAVE_SUFFIX);
+}
+
+// the base merged by CompactDelta before it replaces the old one
+static std::string DeltaMergedBasePath(const std::string &table_path,
+                                       int server_idx,
+                                       size_t file_idx) {
+  return ::paddle::string::format_string("%s/delta/part-%03d-%05d.base",
+                                         table_path.c_str(),
+                                         server_idx,
+                                         file_idx);
+}
+
+template <class SHARD>
+void MemorySparseTableBase<SHARD>::ClearDeltaKeys() {
+  // the values stamped with the old epoch are no longer saved
+  ++_delta_epoch;
+  for (auto &keys : _delta_erased_keys) {
+    keys.clear();
+  }
+}
+
+template <class SHARD>
+void MemorySparseTableBase<SHARD>::CheckDeltaCompactDone() {
+  if (_delta_compact_thread.joinable()) {
+    _delta_compact_thread.join();
+  }
+}
+
+template <class SHARD>
+void MemorySparseTableBase<SHARD>::UpdateShardStatAfterSave(int shard_id,
+                                                            int save_param) {
+  auto &shard = _local_shards[shard_id];
+  for (auto it = shard.begin(); it != shard.end(); ++it) {
+    // the values changed here are saved by the next delta
+    if (_value_accessor->UpdateStatAfterSave(it.value().data(), save_param)) {
+      MarkDeltaUpdated(it.value_ptr());
+    }
+  }
+}
+
+template <class SHARD>
+int64_t MemorySparseTableBase<SHARD>::SaveShardDelta(
+    int shard_id,
+    std::shared_ptr<FsWriteChannel> write_channel,
+    uint64_t seq) {
+  uint32_t value_dim = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  SparseShardBinaryWriter writer(write_channel, value_dim);
+  if (writer.WriteHeader(seq) != 0) {
+    return -1;
+  }
+  auto &shard = _local_shards[shard_id];
+  for (auto it = shard.begin(); it != shard.end(); ++it) {
+    if (it.value().epoch() == _delta_epoch &&
+        writer.Append(it.key(), it.value().data(), it.value().size()) != 0) {
+      return -1;
+    }
+  }
+  // a key erased and pushed again is only saved with its new value
+  auto &erased_keys = _delta_erased_keys[shard_id];
+  std::sort(erased_keys.begin(), erased_keys.end());
+  erased_keys.erase(std::unique(erased_keys.begin(), erased_keys.end()),
+                    erased_keys.end());
+  for (uint64_t key : erased_keys) {
+    auto it = shard.find(key);
+    if ((it == shard.end() || it.value().epoch() != _delta_epoch) &&
+        writer.AppendErased(key) != 0) {
+      return -1;
+    }
+  }
+  if (writer.Flush() != 0) {
+    return -1;
+  }
+  return static_cast<int64_t>(writer.RecordNum());
+}
+
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::SaveDelta(const std::string &dirname) {
+  if (!_enable_delta_save) {
+    LOG(ERROR) << "MemorySparseTable delta save needs enable_delta_save, "
+               << "table_id: " << _config.table_id();
+    return -1;
+  }
+  CheckDeltaCompactDone();
+  std::string table_path = TableDir(dirname);
+  // a save to a new path starts a new base, as does a save after pulls by
+  // pointer, which may update any of the values pulled
+  bool save_base =
+      _delta_pulled_by_ptr.exchange(false) || table_path != _delta_table_path;
+  uint64_t seq = save_base ? 0 : _delta_seq + 1;
+  if (save_base) {
+    _afs_client.remove(::paddle::string::format_string(
+        "%s/part-%03d-*", table_path.c_str(), _shard_idx));
+    _afs_client.remove(::paddle::string::format_string(
+        "%s/delta/part-%03d-*", table_path.c_str(), _shard_idx));
+  }
+  size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  std::atomic<uint64_t> record_num_all{0};
+
+  int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    FsChannelConfig channel_config;
+    channel_config.path =
+        save_base
+            ? DeltaBasePath(table_path, _shard_idx, file_start_idx + i)
+            : DeltaShardPath(table_path, _shard_idx, file_start_idx + i, seq);
+    int64_t record_num = -1;
+    int retry_num = 0;
+    while (record_num < 0) {
+      int err_no = 0;
+      auto write_channel =
+          _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
+      record_num = save_base
+                       ? SaveShardBinary(&_local_shards[i], write_channel, 0)
+                       : SaveShardDelta(i, write_channel, seq);
+      write_channel->close();
+      if (record_num < 0 || err_no == -1) {
+        record_num = -1;
+        ++retry_num;
+        _afs_client.remove(channel_config.path);
+        LOG(ERROR) << "MemorySparseTable save delta failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num;
+        if (retry_num > FLAGS_pserver_table_save_max_retry) {
+          LOG(ERROR) << "MemorySparseTable save delta failed reach max limit!";
+          exit(-1);
+        }
+      }
+    }
+    record_num_all += record_num;
+  }
+  ClearDeltaKeys();
+  _delta_table_path = table_path;
+  _delta_seq = seq;
+  if (save_base) {
+    _delta_compacted_seq = 0;
+  }
+  LOG(INFO) << "MemorySparseTable save " << (save_base ? "delta base" : "delta")
+            << " success, path: " << table_path << " seq: " << seq
+            << " record_num: " << record_num_all;
+
+  uint32_t compact_num = _config.delta_compact_num();
+  if (compact_num > 0 && _delta_seq - _delta_compacted_seq >= compact_num) {
+    _delta_compacted_seq = _delta_seq;
+    _delta_compact_thread =
+        std::thread(&MemorySparseTableBase<SHARD>::CompactDelta,
+                    this,
+                    table_path,
+                    _delta_seq);
+  }
+  return 0;
+}
+
+// Merges the deltas up to seq into the base shards, it only reads the files
+// of the table so that training goes on meanwhile. The merged base is written
+// beside the deltas and then replaces the old one, LoadDelta falls back to it
+// if the old base is already removed.
+template <class SHARD>
+void MemorySparseTableBase<SHARD>::CompactDelta(const std::string &table_path,
+                                                uint64_t seq) {
+  uint32_t value_dim = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+  int64_t record_num_all = 0;
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    size_t file_idx = file_start_idx + i;
+    std::string base_path = DeltaBasePath(table_path, _shard_idx, file_idx);
+    std::string merged_path =
+        DeltaMergedBasePath(table_path, _shard_idx, file_idx);
+    FsChannelConfig base_config;
+    base_config.path = base_path;
+    SparseShardBinaryReader base_reader;
+    int err_no = 0;
+    if (base_reader.Open(&_afs_client, base_config, value_dim, &err_no) != 0) {
+      LOG(ERROR) << "MemorySparseTable compact delta failed to open base, "
+                 << "path: " << base_path;
+      return;
+    }
+    uint64_t base_seq = base_reader.Sequence();
+    // the values of the deltas after the base, empty for an erased key
+    std::unordered_map<uint64_t, std::vector<float>> changes;
+    for (uint64_t s = base_seq + 1; s <= seq; ++s) {
+      FsChannelConfig delta_config;
+      delta_config.path = DeltaShardPath(table_path, _shard_idx, file_idx, s);
+      SparseShardBinaryReader delta_reader;
+      if (delta_reader.Open(&_afs_client, delta_config, value_dim, &err_no) !=
+              0 ||
+          delta_reader.ForEach([&changes](uint64_t key,
+                                          const float *data,
+                                          uint32_t value_size) {
+            changes[key].assign(data, data + value_size);
+          }) < 0) {
+        LOG(ERROR) << "MemorySparseTable compact delta failed to read delta, "
+                   << "path: " << delta_config.path;
+        return;
+      }
+    }
+
+    FsChannelConfig merged_config;
+    merged_config.path = merged_path;
+    err_no = 0;
+    auto write_channel =
+        _afs_client.open_w(merged_config, 1024 * 1024 * 40, &err_no);
+    SparseShardBinaryWriter writer(write_channel, value_dim);
+    bool is_failed = writer.WriteHeader(seq) != 0;
+    int64_t read_num = base_reader.ForEach(
+        [&](uint64_t key, const float *data, uint32_t value_size) {
+          auto it = changes.find(key);
+          if (it == changes.end()) {
+            is_failed |= writer.Append(key, data, value_size) != 0;
+            return;
+          }
+          auto &value = it->second;
+          if (!value.empty()) {
+            is_failed |= writer.Append(key, value.data(), value.size()) != 0;
+          }
+          changes.erase(it);
+        });
+    // the keys created after the base
+    for (auto &item : changes) {
+      auto &value = item.second;
+      if (!value.empty()) {
+        is_failed |= writer.Append(item.first, value.data(), value.size()) != 0;
+      }
+    }
+    is_failed = is_failed || read_num < 0 || writer.Flush() != 0;
+    write_channel->close();
+    base_reader.Close();
+    if (is_failed || err_no == -1) {
+      LOG(ERROR) << "MemorySparseTable compact delta failed to write, path: "
+                 << merged_path;
+      _afs_client.remove(merged_path);
+      return;
+    }
+    _afs_client.remove(base_path);
+    paddle::framework::fs_mv(merged_path, base_path);
+    for (uint64_t s = base_seq + 1; s <= seq; ++s) {
+      _afs_client.remove(DeltaShardPath(table_path, _shard_idx, file_idx, s));
+    }
+    record_num_all += static_cast<int64_t>(writer.RecordNum());
+  }
+  LOG(INFO) << "MemorySparseTable compact delta success, path: " << table_path
+            << " seq: " << seq << " record_num: " << record_num_all;
+}
+
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::LoadDelta(const std::string &path) {
+  if (!_enable_delta_save) {
+    LOG(ERROR) << "MemorySparseTable delta load needs enable_delta_save, "
+               << "table_id: " << _config.table_id();
+    return -1;
+  }
+  CheckDeltaCompactDone();
+  if (_real_local_shard_num == 0) {
+    return 0;
+  }
+  std::string table_path = TableDir(path);
+  uint32_t value_dim = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+
+  // the deltas of every local shard by seq
+  std::vector<std::map<uint64_t, std::string>> shard_deltas(
+      _real_local_shard_num);
+  for (auto &file : _afs_client.list(table_path + "/delta")) {
+    std::string name = file.substr(file.rfind('/') + 1);
+    int server_idx = 0;
+    size_t file_idx = 0;
+    uint64_t seq = 0;
+    if (sscanf(name.c_str(),  // NOLINT
+               "part-%d-%zu-%lu",
+               &server_idx,
+               &file_idx,
+               &seq) == 3 &&
+        server_idx == static_cast<int>(_shard_idx) &&
+        file_idx >= file_start_idx &&
+        file_idx < file_start_idx + _real_local_shard_num) {
+      shard_deltas[file_idx - file_start_idx][seq] = file;
+    }
+  }
+
+  std::atomic<int> failed_num{0};
+  std::vector<uint64_t> base_seq(_real_local_shard_num, 0);
+  std::vector<uint64_t> last_seq(_real_local_shard_num, 0);
+  int thread_num = _real_local_shard_num < 15 ? _real_local_shard_num : 15;
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    auto &shard = _local_shards[i];
+    size_t file_idx = file_start_idx + i;
+    FsChannelConfig channel_config;
+    channel_config.path = DeltaBasePath(table_path, _shard_idx, file_idx);
+    if (!_afs_client.exist(channel_config.path)) {
+      // CompactDelta was stopped between the removal and the move of the base
+      channel_config.path =
+          DeltaMergedBasePath(table_path, _shard_idx, file_idx);
+    }
+    SparseShardBinaryReader reader;
+    int err_no = 0;
+    if (reader.Open(&_afs_client, channel_config, value_dim, &err_no) != 0 ||
+        reader.ForEach([&shard](uint64_t key,
+                                const float *data,
+                                uint32_t value_size) {
+          auto &value = shard[key];
+          value.resize(value_size);
+          memcpy(value.data(), data, value_size * sizeof(float));
+        }) < 0) {
+      LOG(ERROR) << "MemorySparseTable load delta base failed, path: "
+                 << channel_config.path;
+      ++failed_num;
+      continue;
+    }
+    base_seq[i] = last_seq[i] = reader.Sequence();
+    for (auto &delta : shard_deltas[i]) {
+      // merged into the base
+      if (delta.first <= base_seq[i]) {
+        continue;
+      }
+      channel_config.path = delta.second;
+      if (reader.Open(&_afs_client, channel_config, value_dim, &err_no) != 0 ||
+          reader.ForEach([&shard](uint64_t key,
+                                  const float *data,
+                                  uint32_t value_size) {
+            if (value_size == 0) {
+              shard.erase(key);
+              return;
+            }
+            auto &value = shard[key];
+            value.resize(value_size);
+            memcpy(value.data(), data, value_size * sizeof(float));
+          }) < 0) {
+        LOG(ERROR) << "MemorySparseTable load delta failed, path: "
+                   << channel_config.path;
+        ++failed_num;
+        break;
+      }
+      last_seq[i] = delta.first;
+    }
+  }
+  if (failed_num > 0) {
+    return -1;
+  }
+  ClearDeltaKeys();
+  // the later delta saves to the same path go on with the sequence
+  _delta_table_path = table_path;
+  _delta_seq = *std::max_element(last_seq.begin(), last_seq.end());
+  _delta_compacted_seq = *std::min_element(base_seq.begin(), base_seq.end());
+  LOG(INFO) << "MemorySparseTable load delta success, path: " << table_path
+            << " seq: " << _delta_seq << " local size: " << LocalSize();
+  return 0;
+}
+
+template <class SHARD>
+int64_t MemorySparseTableBase<SHARD>::CacheShuffle(
     const std::string &path,
     const std::string &param,
     double cache_threshold,
@@ -856,7 +1369,8 @@ int64_t MemorySparseTable::CacheShuffle(
   return 0;
 }
 
-int32_t MemorySparseTable::SaveCache(
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::SaveCache(
     const std::string &path,
     const std::string &param,
     ::paddle::framework::Channel<std::pair<uint64_t, std::string>>
@@ -905,7 +1419,8 @@ int32_t MemorySparseTable::SaveCache(
   return feasign_size;
 }
 
-int64_t MemorySparseTable::LocalSize() {
+template <class SHARD>
+int64_t MemorySparseTableBase<SHARD>::LocalSize() {
   int64_t local_size = 0;
   for (int i = 0; i < _real_local_shard_num; ++i) {
     local_size += _local_shards[i].size();
@@ -913,7 +1428,8 @@ int64_t MemorySparseTable::LocalSize() {
   return local_size;
 }
 
-int64_t MemorySparseTable::LocalMFSize() {
+template <class SHARD>
+int64_t MemorySparseTableBase<SHARD>::LocalMFSize() {
   std::vector<int64_t> size_arr(_real_local_shard_num, 0);
   std::vector<std::future<int>> tasks(_real_local_shard_num);
   int64_t ret_size = 0;
@@ -940,13 +1456,15 @@ int64_t MemorySparseTable::LocalMFSize() {
   return ret_size;
 }
 
-std::pair<int64_t, int64_t> MemorySparseTable::PrintTableStat() {
+template <class SHARD>
+std::pair<int64_t, int64_t> MemorySparseTableBase<SHARD>::PrintTableStat() {
   int64_t feasign_size = LocalSize();
   int64_t mf_size = LocalMFSize();
   return {feasign_size, mf_size};
 }
 
-int32_t MemorySparseTable::Pull(TableContext &context) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::Pull(TableContext &context) {
   CHECK(context.value_type == Sparse);
   if (context.use_ptr) {
     char **pull_values = context.pull_context.ptr_values;
@@ -960,8 +1478,35 @@ int32_t MemorySparseTable::Pull(TableContext &context) {
   }
 }
 
-int32_t MemorySparseTable::Push(TableContext &context) {
+template <class SHARD>
+const float *MemorySparseTableBase<SHARD>::DecodePushValues(
+    const TableContext &context) {
+  const auto &push_context = context.push_context;
+  size_t update_dim = _value_accessor->GetAccessorInfo().update_dim;
+  thread_local std::vector<float> values;
+  if (push_context.compress_header.row_dim != update_dim ||
+      !PushCompressDecode(push_context.compress_header,
+                          push_context.compressed_values,
+                          push_context.compressed_size,
+                          context.num,
+                          &values)) {
+    LOG(ERROR) << "malformed compressed push of " << context.num
+               << " keys to table " << _config.table_id();
+    return nullptr;
+  }
+  return values.data();
+}
+
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::Push(TableContext &context) {
   CHECK(context.value_type == Sparse);
+  if (context.push_context.compressed_values != nullptr) {
+    const float *values = DecodePushValues(context);
+    if (values == nullptr) {
+      return -1;
+    }
+    return PushSparse(context.push_context.keys, values, context.num);
+  }
   if (!context.use_ptr) {
     return PushSparse(
         context.push_context.keys, context.push_context.values, context.num);
@@ -972,8 +1517,9 @@ int32_t MemorySparseTable::Push(TableContext &context) {
   }
 }
 
-int32_t MemorySparseTable::PullSparse(float *pull_values,
-                                      const PullSparseValue &pull_value) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::PullSparse(
+    float *pull_values, const PullSparseValue &pull_value) {
   CostTimer timer("pserver_sparse_select_all");
   std::vector<std::future<int>> tasks(_real_local_shard_num);
 
@@ -1049,12 +1595,24 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
   return 0;
 }
 
-int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
-                                         char **pull_values,
-                                         const uint64_t *keys,
-                                         size_t num,
-                                         uint16_t pass_id) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::PullSparsePtr(int shard_id,  // fake num
+                                                    char **pull_values,
+                                                    const uint64_t *keys,
+                                                    size_t num,
+                                                    uint16_t pass_id) {
   CostTimer timer("pscore_sparse_select_all");
+  // the callers read the pointers as FixedFeatureValue
+  if (!std::is_same<typename shard_type::value_type,
+                    FixedFeatureValue>::value) {
+    LOG(ERROR) << "PullSparsePtr is not supported by the compact shards";
+    return -1;
+  }
+  // the values are updated through the pointers, out of sight of the delta
+  // checkpoints
+  if (_enable_delta_save) {
+    _delta_pulled_by_ptr = true;
+  }
   size_t value_size = _value_accessor->GetAccessorInfo().size / sizeof(float);
   size_t mf_value_size =
       _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
@@ -1084,7 +1642,7 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
                 uint64_t key = item.first;
                 auto itr = local_shard.find(key);
                 size_t data_size = value_size - mf_value_size;
-                FixedFeatureValue *ret = NULL;
+                typename shard_type::value_type *ret = NULL;
                 if (itr == local_shard.end()) {
                   // ++missed_keys;
                   auto &feature_value = local_shard[key];
@@ -1108,9 +1666,10 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
   return 0;
 }
 
-int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
-                                      const float *values,
-                                      size_t num) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::PushSparse(const uint64_t *keys,
+                                                 const float *values,
+                                                 size_t num) {
   CostTimer timer("pserver_sparse_update_all");
   std::vector<std::future<int>> tasks(_real_local_shard_num);
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
@@ -1180,8 +1739,9 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
               }
               memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
             }
+            MarkDeltaUpdated(&feature_value);
             if (_config.enable_revert()) {
-              FixedFeatureValue *feature_value_new = &(local_shard_new[key]);
+              auto *feature_value_new = &(local_shard_new[key]);
               auto new_size = feature_value.size();
               feature_value_new->resize(new_size);
               memcpy(feature_value_new->data(),
@@ -1199,9 +1759,10 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
   return 0;
 }
 
-int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
-                                      const float **values,
-                                      size_t num) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::PushSparse(const uint64_t *keys,
+                                                 const float **values,
+                                                 size_t num) {
   std::vector<std::future<int>> tasks(_real_local_shard_num);
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
       _real_local_shard_num);
@@ -1264,6 +1825,7 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
               }
               memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
             }
+            MarkDeltaUpdated(&feature_value);
           }
           return 0;
         });
@@ -1275,9 +1837,11 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
   return 0;
 }
 
-int32_t MemorySparseTable::Flush() { return 0; }
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::Flush() { return 0; }
 
-int32_t MemorySparseTable::Shrink(const std::string &param) {
+template <class SHARD>
+int32_t MemorySparseTableBase<SHARD>::Shrink(const std::string &param) {
   VLOG(0) << "MemorySparseTable::Shrink";
   std::atomic<uint32_t> shrink_size_all{0};
   int thread_num = _real_local_shard_num;
@@ -1289,9 +1853,14 @@ int32_t MemorySparseTable::Shrink(const std::string &param) {
     auto &shard = _local_shards[shard_id];
     for (auto it = shard.begin(); it != shard.end();) {
       if (_value_accessor->Shrink(it.value().data())) {
+        if (_enable_delta_save) {
+          _delta_erased_keys[shard_id].push_back(it.key());
+        }
         it = shard.erase(it);
         ++feasign_size;
       } else {
+        // the accessor decays the show and click of the values it keeps
+        MarkDeltaUpdated(it.value_ptr());
         ++it;
       }
     }
@@ -1302,7 +1871,12 @@ int32_t MemorySparseTable::Shrink(const std::string &param) {
   return 0;
 }
 
-void MemorySparseTable::Clear() { VLOG(0) << "clear coming soon"; }
+template <class SHARD>
+void MemorySparseTableBase<SHARD>::Clear() { VLOG(0) << "clear coming soon"; }
+
+template class MemorySparseTableBase<
+    SparseTableShard<uint64_t, FixedFeatureValue>>;
+template class MemorySparseTableBase<CompactSparseTableShard<uint64_t>>;
 
 }  // namespace distributed
 }  // namespace paddle
@@ -18,6 +18,7 @@
 #include <assert.h>
 #include <pthread.h>
 
+#include <atomic>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
@@ -28,6 +29,7 @@
 #include "Eigen/Dense"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
+#include "paddle/fluid/distributed/ps/table/depends/compact_feature_value.h"
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
 #include "paddle/fluid/string/string_helper.h"
 
@@ -36,11 +38,14 @@
 namespace paddle {
 namespace distributed {
 
-class MemorySparseTable : public Table {
+// The sparse table in memory on the shards of type SHARD, it is instantiated
+// for SparseTableShard and CompactSparseTableShard in memory_sparse_table.cc.
+template <class SHARD>
+class MemorySparseTableBase : public Table {
  public:
-  typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
-  MemorySparseTable() {}
-  virtual ~MemorySparseTable() {}
+  typedef SHARD shard_type;
+  MemorySparseTableBase() {}
+  virtual ~MemorySparseTableBase() { CheckDeltaCompactDone(); }
 
   // unused method end
   static int32_t sparse_local_shard_num(uint32_t shard_num,
@@ -93,6 +98,8 @@ class MemorySparseTable : public Table {
   std::pair<int64_t, int64_t> PrintTableStat() override;
   int32_t PullSparse(float* values, const PullSparseValue& pull_value);
 
+  // the pointers of the values are FixedFeatureValue*, it is not supported by
+  // the compact shards
   int32_t PullSparsePtr(int shard_id,
                         char** pull_values,
                         const uint64_t* keys,
@@ -113,11 +120,48 @@ class MemorySparseTable : public Table {
 
   virtual void Revert();
   virtual void CheckSavePrePatchDone();
+  // waits for the merge of the deltas started by the last delta save
+  void CheckDeltaCompactDone();
 
  protected:
+  std::unique_ptr<shard_type[]> CreateShards(int num);
+  // The values of a push encoded as TablePushContext.compress_header, in a
+  // thread local buffer, or nullptr if they are malformed.
+  const float* DecodePushValues(const TableContext& context);
   virtual int32_t SavePatch(const std::string& path, int save_param);
   virtual int32_t LoadPatch(const std::vector<std::string>& file_list,
                             int save_param);
+  // binary shard format, see depends/sparse_binary_format.h
+  int64_t LoadShardBinary(const FsChannelConfig& channel_config,
+                          shard_type* shard,
+                          int* err_no);
+  int64_t SaveShardBinary(shard_type* shard,
+                          std::shared_ptr<FsWriteChannel> write_channel,
+                          int save_param);
+
+  // Delta checkpoints (save/load param 6). The first save to a path writes
+  // the binary base shards part-SSS-NNNNN.bin, every later save to the same
+  // path writes delta/part-SSS-NNNNN-<seq>.bin with the values updated since
+  // the previous save and the erased keys. A value is updated by a push, by
+  // Shrink and by UpdateStatAfterSave of the accessor, which stamp it with
+  // the current save epoch. Every delta_compact_num deltas are merged into
+  // the base in the background. A checkpoint or batch model save (param 0 or
+  // 3) drops the tracked keys, the next delta save writes a new base, as it
+  // does after PullSparsePtr, whose values are updated through the pointers.
+  virtual int32_t SaveDelta(const std::string& path);
+  virtual int32_t LoadDelta(const std::string& path);
+  int64_t SaveShardDelta(int shard_id,
+                         std::shared_ptr<FsWriteChannel> write_channel,
+                         uint64_t seq);
+  void CompactDelta(const std::string& table_path, uint64_t seq);
+  void MarkDeltaUpdated(typename shard_type::value_type* value) {
+    if (_enable_delta_save) {
+      value->set_epoch(_delta_epoch);
+    }
+  }
+  void ClearDeltaKeys();
+  // calls UpdateStatAfterSave of the accessor on the values of a shard
+  void UpdateShardStatAfterSave(int shard_id, int save_param);
 
   int _task_pool_size = 24;
   int _avg_local_shard_num;
@@ -136,7 +180,31 @@ class MemorySparseTable : public Table {
   std::unique_ptr<shard_type[]> _local_shards_new;
   std::unique_ptr<shard_type[]> _local_shards_patch_model;
   std::thread _save_patch_model_thread;
+
+  // for delta checkpoint, the erased keys of a local shard are only touched
+  // by its task pool thread
+  bool _enable_delta_save{false};
+  uint32_t _delta_epoch{1};  // the values updated since the last save
+  std::vector<std::vector<uint64_t>> _delta_erased_keys;
+  std::atomic<bool> _delta_pulled_by_ptr{false};
+  std::string _delta_table_path;  // the dir of the base of the deltas
+  uint64_t _delta_seq{0};
+  uint64_t _delta_compacted_seq{0};
+  std::thread _delta_compact_thread;
 };
 
+// Keeps a key in a closed_hash_map entry and its values in a ChunkAllocator
+// node, SSDSparseTable relies on the closed_hash_map of the shards.
+class MemorySparseTable
+    : public MemorySparseTableBase<
+          SparseTableShard<uint64_t, FixedFeatureValue>> {};
+
+// Keeps the keys and the values in the fixed-size records of
+// CompactSparseTableShard, which takes less memory per key. It is chosen by
+// the table_class of the table config, the pointer pull of GPU PS is not
+// supported.
+class MemorySparseCompactTable
+    : public MemorySparseTableBase<CompactSparseTableShard<uint64_t>> {};
+
 }  // namespace distributed
 }  // namespace paddle
@@ -115,7 +115,7 @@ bool SparseAccessor::Save(float* value, int param) {
   }
 }
 
-void SparseAccessor::UpdateStatAfterSave(float* value, int param) {
+bool SparseAccessor::UpdateStatAfterSave(float* value, int param) {
   auto base_threshold = _config.ctr_accessor_param().base_threshold();
   auto delta_threshold = _config.ctr_accessor_param().delta_threshold();
   auto delta_keep_days = _config.ctr_accessor_param().delta_keep_days();
@@ -129,15 +129,16 @@ void SparseAccessor::UpdateStatAfterSave(float* value, int param) {
           sparse_feature_value.DeltaScore(value) >= delta_threshold &&
           sparse_feature_value.UnseenDays(value) <= delta_keep_days) {
         sparse_feature_value.DeltaScore(value) = 0;
+        return true;
       }
     }
-      return;
+      return false;
     case 3: {
       sparse_feature_value.UnseenDays(value)++;
     }
-      return;
+      return true;
     default:
-      return;
+      return false;
   }
 }
 
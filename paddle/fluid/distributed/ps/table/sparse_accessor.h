@@ -143,7 +143,7 @@ class SparseAccessor : public ValueAccessor {
   }
   bool SaveSSD(float* value) { return false; }
   // update delta_score and unseen_days after save
-  void UpdateStatAfterSave(float* value, int param) override;
+  bool UpdateStatAfterSave(float* value, int param) override;
   // keys不存在时，为values生成随机值
   // 要求value的内存由外部调用者分配完毕
   virtual int32_t Create(float** value, size_t num);
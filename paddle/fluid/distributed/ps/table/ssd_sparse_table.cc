@@ -28,6 +28,16 @@ PD_DEFINE_int32(pserver_load_batch_size, 5000, "load batch size for ssd");
 PADDLE_DEFINE_EXPORTED_string(rocksdb_path,
                               "database",
                               "path of sparse table rocksdb file");
+PD_DEFINE_int64(pserver_ssd_mem_budget_per_shard,
+                0,
+                "max number of values kept in memory by every shard of ssd "
+                "table, the coldest values are evicted to rocksdb by prefetch "
+                "beyond it, 0 means unlimited. It must be 0 if the values are "
+                "pulled by pointer");
+PD_DEFINE_double(pserver_ssd_prefetch_admit_score,
+                 0.0,
+                 "min show click score of the values prefetched from rocksdb "
+                 "when a shard of ssd table is over its memory budget");
 
 namespace paddle {
 namespace distributed {
@@ -36,6 +46,7 @@ int32_t SSDSparseTable::Initialize() {
   MemorySparseTable::Initialize();
   _db = ::paddle::distributed::RocksDBHandler::GetInstance();
   _db->initialize(FLAGS_rocksdb_path, _real_local_shard_num);
+  _shard_mutex.reset(new std::mutex[_real_local_shard_num]);
   VLOG(0) << "initialize SSDSparseTable succ";
   VLOG(0) << "SSD FLAGS_pserver_print_missed_key_num_every_push:"
           << FLAGS_pserver_print_missed_key_num_every_push;
@@ -60,6 +71,13 @@ int32_t SSDSparseTable::Pull(TableContext& context) {
 
 int32_t SSDSparseTable::Push(TableContext& context) {
   CHECK(context.value_type == Sparse);
+  if (context.push_context.compressed_values != nullptr) {
+    const float* values = DecodePushValues(context);
+    if (values == nullptr) {
+      return -1;
+    }
+    return PushSparse(context.push_context.keys, values, context.num);
+  }
   if (context.use_ptr) {
     return PushSparse(context.push_context.keys,
                       context.push_context.ptr_values,
@@ -108,6 +126,9 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                 auto& local_shard = _local_shards[shard_id];
                 float data_buffer[value_size];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                uint64_t mem_hit_num = 0;
+                uint64_t ssd_read_num = 0;
+                uint64_t stall_us = 0;
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   auto itr = local_shard.find(key);
@@ -115,10 +136,14 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                   if (itr == local_shard.end()) {
                     // pull rocksdb
                     std::string tmp_string("");
-                    if (_db->get(shard_id,
-                                 reinterpret_cast<char*>(&key),
-                                 sizeof(uint64_t),
-                                 tmp_string) > 0) {
+                    uint64_t read_begin = butil::gettimeofday_us();
+                    int db_ret = _db->get(shard_id,
+                                          reinterpret_cast<char*>(&key),
+                                          sizeof(uint64_t),
+                                          tmp_string);
+                    stall_us += butil::gettimeofday_us() - read_begin;
+                    ++ssd_read_num;
+                    if (db_ret > 0) {
                       ++missed_keys;
                       if (FLAGS_pserver_create_value_when_push) {
                         memset(data_buffer, 0, sizeof(float) * data_size);
@@ -148,6 +173,7 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                                     sizeof(uint64_t));
                     }
                   } else {
+                    ++mem_hit_num;
                     data_size = itr.value().size();
                     memcpy(data_buffer_ptr,
                            itr.value().data(),
@@ -163,6 +189,13 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                   _value_accessor->Select(
                       &select_data, (const float**)&data_buffer_ptr, 1);
                 }
+                _pull_key_num.fetch_add(keys.size(),
+                                        std::memory_order_relaxed);
+                _pull_mem_hit_num.fetch_add(mem_hit_num,
+                                            std::memory_order_relaxed);
+                _pull_ssd_read_num.fetch_add(ssd_read_num,
+                                             std::memory_order_relaxed);
+                _pull_stall_us.fetch_add(stall_us, std::memory_order_relaxed);
                 return 0;
               });
     }
@@ -186,6 +219,18 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
   size_t value_size = _value_accessor->GetAccessorInfo().size / sizeof(float);
   size_t mf_value_size =
       _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
+  // 淘汰会使已返回的value指针失效
+  PADDLE_ENFORCE_EQ(
+      FLAGS_pserver_ssd_mem_budget_per_shard,
+      0,
+      paddle::platform::errors::PreconditionNotMet(
+          "The values of SSDSparseTable can not be pulled by pointer when "
+          "pserver_ssd_mem_budget_per_shard is set, because eviction "
+          "invalidates the pointers, but the budget is %d.",
+          FLAGS_pserver_ssd_mem_budget_per_shard));
+  _pulled_by_ptr.store(true, std::memory_order_relaxed);
+  // 分片在当前线程上修改, 与同一分片的预取互斥
+  std::lock_guard<std::mutex> shard_guard(_shard_mutex[shard_id]);
 
   {  // 从table取值 or create
     RocksDBCtx context;
@@ -196,6 +241,8 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
     auto& local_shard = _local_shards[shard_id];
     float data_buffer[value_size];  // NOLINT
     float* data_buffer_ptr = data_buffer;
+    uint64_t mem_hit_num = 0;
+    uint64_t stall_us = 0;
 
     for (size_t i = 0; i < num; ++i) {
       uint64_t key = pull_keys[i];
@@ -219,7 +266,9 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                   });
           cur_ctx = context.switch_item();
           for (size_t x = 0; x < tasks.size(); ++x) {
+            uint64_t wait_begin = butil::gettimeofday_us();
             tasks[x].wait();
+            stall_us += butil::gettimeofday_us() - wait_begin;
             for (size_t idx = 0; idx < cur_ctx->status.size(); idx++) {
               uint64_t cur_key = *(reinterpret_cast<uint64_t*>(
                   const_cast<char*>(cur_ctx->batch_keys[idx].data())));
@@ -257,6 +306,7 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
           tasks.push_back(std::move(fut));
         }
       } else {
+        ++mem_hit_num;
         ret = itr.value_ptr();
         // int pull_data_idx = keys[i].second;
         _value_accessor->UpdatePassId(ret->data(), pass_id);
@@ -278,9 +328,15 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
               });
       tasks.push_back(std::move(fut));
     }
+    uint64_t wait_begin = butil::gettimeofday_us();
     for (size_t x = 0; x < tasks.size(); ++x) {
       tasks[x].wait();
     }
+    stall_us += butil::gettimeofday_us() - wait_begin;
+    _pull_key_num.fetch_add(num, std::memory_order_relaxed);
+    _pull_mem_hit_num.fetch_add(mem_hit_num, std::memory_order_relaxed);
+    _pull_ssd_read_num.fetch_add(num - mem_hit_num, std::memory_order_relaxed);
+    _pull_stall_us.fetch_add(stall_us, std::memory_order_relaxed);
     for (size_t x = 0; x < 2; x++) {
       cur_ctx = context.switch_item();
       for (size_t idx = 0; idx < cur_ctx->status.size(); idx++) {
@@ -356,6 +412,11 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                   const float* update_data =
                       values + push_data_idx * update_value_col;
                   auto itr = local_shard.find(key);
+                  if (itr == local_shard.end() &&
+                      FLAGS_pserver_ssd_mem_budget_per_shard > 0 &&
+                      LoadEvictedValue(shard_id, key)) {
+                    itr = local_shard.find(key);
+                  }
                   if (itr == local_shard.end()) {
                     if (FLAGS_pserver_enable_create_feasign_randomly &&
                         !_value_accessor->CreateValue(1, update_data)) {
@@ -461,6 +522,11 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                   uint64_t push_data_idx = keys[i].second;
                   const float* update_data = values[push_data_idx];
                   auto itr = local_shard.find(key);
+                  if (itr == local_shard.end() &&
+                      FLAGS_pserver_ssd_mem_budget_per_shard > 0 &&
+                      LoadEvictedValue(shard_id, key)) {
+                    itr = local_shard.find(key);
+                  }
                   if (itr == local_shard.end()) {
                     if (FLAGS_pserver_enable_create_feasign_randomly &&
                         !_value_accessor->CreateValue(1, update_data)) {
@@ -2912,9 +2978,216 @@ int32_t SSDSparseTable::LoadWithBinary(const std::string& path, int param) {
 
 std::pair<int64_t, int64_t> SSDSparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
+  PrintCacheStat();
   return {feasign_size, -1};
 }
 
+void SSDSparseTable::PrintCacheStat() {
+  uint64_t pull_key_num = _pull_key_num.load(std::memory_order_relaxed);
+  uint64_t mem_hit_num = _pull_mem_hit_num.load(std::memory_order_relaxed);
+  uint64_t prefetch_key_num =
+      _prefetch_key_num.load(std::memory_order_relaxed);
+  LOG(INFO) << "SSDSparseTable cache stat: pull keys:" << pull_key_num
+            << " mem hit rate:"
+            << (pull_key_num > 0 ? 1.0 * mem_hit_num / pull_key_num : 0.0)
+            << " ssd reads:" << _pull_ssd_read_num.load()
+            << " pull stall ms:" << _pull_stall_us.load() / 1000
+            << " prefetch keys:" << prefetch_key_num
+            << " prefetch loads:" << _prefetch_load_num.load()
+            << " prefetch rejects:" << _prefetch_reject_num.load()
+            << " prefetch skips:" << _prefetch_skip_num.load()
+            << " prefetch ms:" << _prefetch_us.load() / 1000
+            << " evicted:" << _evict_num.load();
+}
+
+SSDSparseTable::CacheStat SSDSparseTable::GetCacheStat() const {
+  CacheStat stat;
+  stat.pull_key_num = _pull_key_num.load(std::memory_order_relaxed);
+  stat.pull_mem_hit_num = _pull_mem_hit_num.load(std::memory_order_relaxed);
+  stat.pull_ssd_read_num = _pull_ssd_read_num.load(std::memory_order_relaxed);
+  stat.prefetch_key_num = _prefetch_key_num.load(std::memory_order_relaxed);
+  stat.prefetch_load_num = _prefetch_load_num.load(std::memory_order_relaxed);
+  stat.prefetch_reject_num =
+      _prefetch_reject_num.load(std::memory_order_relaxed);
+  stat.prefetch_skip_num = _prefetch_skip_num.load(std::memory_order_relaxed);
+  stat.evict_num = _evict_num.load(std::memory_order_relaxed);
+  return stat;
+}
+
+int32_t SSDSparseTable::Prefetch(const uint64_t* keys, size_t num) {
+  // 淘汰会使PullSparsePtr已返回的value指针失效
+  PADDLE_ENFORCE_EQ(
+      FLAGS_pserver_ssd_mem_budget_per_shard > 0 &&
+          _pulled_by_ptr.load(std::memory_order_relaxed),
+      false,
+      paddle::platform::errors::PreconditionNotMet(
+          "SSDSparseTable can not evict values by prefetch, because its "
+          "values have been pulled by pointer. Set "
+          "pserver_ssd_mem_budget_per_shard to 0."));
+  auto task_keys =
+      std::make_shared<std::vector<std::vector<uint64_t>>>(
+          _real_local_shard_num);
+  for (size_t i = 0; i < num; ++i) {
+    int shard_id = (keys[i] % _sparse_table_shard_num) % _avg_local_shard_num;
+    (*task_keys)[shard_id].push_back(keys[i]);
+  }
+  _prefetch_key_num.fetch_add(num, std::memory_order_relaxed);
+  // 分片的任务按提交顺序执行, 之后的pull/push会在预取完成后执行,
+  // 因此不需要等待
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    if ((*task_keys)[shard_id].empty()) {
+      continue;
+    }
+    _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+        [this, shard_id, task_keys]() -> int {
+          PrefetchShard(shard_id, &(*task_keys)[shard_id]);
+          return 0;
+        });
+  }
+  return 0;
+}
+
+void SSDSparseTable::PrefetchShard(int shard_id, std::vector<uint64_t>* keys) {
+  // PullSparsePtr持有分片锁时会等待本线程池上的rocksdb读取任务,
+  // 因此不阻塞等锁, 直接放弃这次预取
+  std::unique_lock<std::mutex> shard_lock(_shard_mutex[shard_id],
+                                          std::try_to_lock);
+  if (!shard_lock.owns_lock()) {
+    _prefetch_skip_num.fetch_add(keys->size(), std::memory_order_relaxed);
+    return;
+  }
+  uint64_t begin = butil::gettimeofday_us();
+  auto& local_shard = _local_shards[shard_id];
+  std::sort(keys->begin(), keys->end());
+  keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+  std::vector<uint64_t> missed_keys;
+  for (auto key : *keys) {
+    if (local_shard.find(key) == local_shard.end()) {
+      missed_keys.push_back(key);
+    }
+  }
+
+  int64_t budget = FLAGS_pserver_ssd_mem_budget_per_shard;
+  uint64_t load_num = 0;
+  uint64_t reject_num = 0;
+  const size_t batch_size = 1024;
+  std::vector<rocksdb::Slice> batch_keys;
+  std::vector<rocksdb::PinnableSlice> batch_values(batch_size);
+  std::vector<rocksdb::Status> status(batch_size);
+  for (size_t begin_idx = 0; begin_idx < missed_keys.size();
+       begin_idx += batch_size) {
+    size_t end_idx = std::min(begin_idx + batch_size, missed_keys.size());
+    batch_keys.clear();
+    for (size_t i = begin_idx; i < end_idx; ++i) {
+      batch_keys.emplace_back(reinterpret_cast<const char*>(&missed_keys[i]),
+                              sizeof(uint64_t));
+    }
+    // keys已排序
+    _db->multi_get(shard_id,
+                   batch_keys.size(),
+                   batch_keys.data(),
+                   batch_values.data(),
+                   status.data());
+    bool over_budget =
+        budget > 0 && local_shard.size() >= static_cast<size_t>(budget);
+    for (size_t i = 0; i < batch_keys.size(); ++i) {
+      // 不存在的key由pull创建
+      if (!status[i].ok()) {
+        batch_values[i].Reset();
+        continue;
+      }
+      float* value = const_cast<float*>(
+          ::paddle::string::str_to_float(batch_values[i].data()));
+      // 超过预算时冷的value留在rocksdb, 由pull同步读取
+      if (over_budget && _value_accessor->GetShowClickScore(value) <
+                             FLAGS_pserver_ssd_prefetch_admit_score) {
+        ++reject_num;
+        batch_values[i].Reset();
+        continue;
+      }
+      uint64_t key = missed_keys[begin_idx + i];
+      size_t data_size = batch_values[i].size() / sizeof(float);
+      auto& feature_value = local_shard[key];
+      feature_value.resize(data_size);
+      memcpy(feature_value.data(),
+             value,
+             data_size * sizeof(float));
+      _db->del_data(shard_id, reinterpret_cast<char*>(&key), sizeof(uint64_t));
+      batch_values[i].Reset();
+      ++load_num;
+    }
+  }
+  if (budget > 0 && local_shard.size() > static_cast<size_t>(budget)) {
+    EvictColdValues(shard_id, *keys);
+  }
+  _prefetch_load_num.fetch_add(load_num, std::memory_order_relaxed);
+  _prefetch_reject_num.fetch_add(reject_num, std::memory_order_relaxed);
+  _prefetch_us.fetch_add(butil::gettimeofday_us() - begin,
+                         std::memory_order_relaxed);
+}
+
+void SSDSparseTable::EvictColdValues(int shard_id,
+                                     const std::vector<uint64_t>& keep_keys) {
+  // 淘汰到预算的90%, 避免每次预取都触发淘汰
+  auto& local_shard = _local_shards[shard_id];
+  size_t low_water = FLAGS_pserver_ssd_mem_budget_per_shard * 9 / 10;
+  if (local_shard.size() <= low_water) {
+    return;
+  }
+  size_t evict_num = local_shard.size() - low_water;
+  std::vector<std::pair<float, uint64_t>> candidates;
+  candidates.reserve(local_shard.size());
+  for (auto it = local_shard.begin(); it != local_shard.end(); ++it) {
+    if (std::binary_search(keep_keys.begin(), keep_keys.end(), it.key())) {
+      continue;
+    }
+    candidates.emplace_back(
+        _value_accessor->GetShowClickScore(it.value().data()), it.key());
+  }
+  evict_num = std::min(evict_num, candidates.size());
+  if (evict_num == 0) {
+    return;
+  }
+  std::nth_element(candidates.begin(),
+                   candidates.begin() + evict_num - 1,
+                   candidates.end());
+  std::vector<std::pair<char*, int>> ssd_keys;
+  std::vector<std::pair<char*, int>> ssd_values;
+  ssd_keys.reserve(evict_num);
+  ssd_values.reserve(evict_num);
+  for (size_t i = 0; i < evict_num; ++i) {
+    auto itr = local_shard.find(candidates[i].second);
+    ssd_keys.emplace_back(reinterpret_cast<char*>(&candidates[i].second),
+                          sizeof(uint64_t));
+    ssd_values.emplace_back(reinterpret_cast<char*>(itr.value().data()),
+                            itr.value().size() * sizeof(float));
+  }
+  _db->put_batch(shard_id, ssd_keys, ssd_values, ssd_keys.size());
+  for (size_t i = 0; i < evict_num; ++i) {
+    local_shard.erase(candidates[i].second);
+  }
+  _evict_num.fetch_add(evict_num, std::memory_order_relaxed);
+  VLOG(1) << "SSDSparseTable evict " << evict_num << " values of shard "
+          << shard_id << ", mem size:" << local_shard.size();
+}
+
+bool SSDSparseTable::LoadEvictedValue(int shard_id, uint64_t key) {
+  std::string value;
+  if (_db->get(shard_id,
+               reinterpret_cast<char*>(&key),
+               sizeof(uint64_t),
+               value) > 0) {
+    return false;
+  }
+  auto& feature_value = _local_shards[shard_id][key];
+  feature_value.resize(value.size() / sizeof(float));
+  memcpy(feature_value.data(),
+         ::paddle::string::str_to_float(value),
+         value.size());
+  _db->del_data(shard_id, reinterpret_cast<char*>(&key), sizeof(uint64_t));
+  return true;
+}
+
 int32_t SSDSparseTable::CacheTable(uint16_t pass_id) {
   std::lock_guard<std::mutex> guard(_table_mutex);
   VLOG(0) << "cache_table";
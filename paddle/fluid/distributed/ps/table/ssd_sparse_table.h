@@ -14,6 +14,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/ps/table/depends/rocksdb_warpper.h"
 #include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
@@ -128,12 +133,54 @@ class SSDSparseTable : public MemorySparseTable {
 
   int32_t CacheTable(uint16_t pass_id) override;
 
+  // 将keys中不在内存的value从rocksdb异步加载到内存, 在各分片的线程上执行,
+  // 先于之后同一分片上的pull完成. 内存超过预算时, 只准入show click
+  // score不低于FLAGS_pserver_ssd_prefetch_admit_score的value, 并把score
+  // 最低的value淘汰到rocksdb
+  int32_t Prefetch(const uint64_t* keys, size_t num) override;
+
+  // pull命中内存的比例, 以及预取和淘汰的统计
+  struct CacheStat {
+    uint64_t pull_key_num{0};
+    uint64_t pull_mem_hit_num{0};
+    uint64_t pull_ssd_read_num{0};
+    uint64_t prefetch_key_num{0};
+    uint64_t prefetch_load_num{0};
+    uint64_t prefetch_reject_num{0};
+    uint64_t prefetch_skip_num{0};
+    uint64_t evict_num{0};
+  };
+  CacheStat GetCacheStat() const;
+
  private:
+  void PrefetchShard(int shard_id, std::vector<uint64_t>* keys);
+  // 淘汰不在keep_keys中score最低的value, 直到分片大小降到预算的低水位
+  void EvictColdValues(int shard_id, const std::vector<uint64_t>& keep_keys);
+  // push时内存中没有的key可能已被淘汰, 从rocksdb加载
+  bool LoadEvictedValue(int shard_id, uint64_t key);
+  void PrintCacheStat();
+
   RocksDBHandler* _db;
   int64_t _cache_tk_size;
   double _local_show_threshold{0.0};
   std::vector<paddle::framework::Channel<std::string>> _fs_channel;
   std::mutex _table_mutex;
+  // PullSparsePtr在调用方线程上修改分片, 预取修改同一分片前要持有此锁
+  std::unique_ptr<std::mutex[]> _shard_mutex;
+  // value被PullSparsePtr按指针取出后不能再淘汰
+  std::atomic<bool> _pulled_by_ptr{false};
+
+  // pull命中内存的比例和同步读rocksdb的耗时, 以及预取和淘汰的统计
+  std::atomic<uint64_t> _pull_key_num{0};
+  std::atomic<uint64_t> _pull_mem_hit_num{0};
+  std::atomic<uint64_t> _pull_ssd_read_num{0};
+  std::atomic<uint64_t> _pull_stall_us{0};
+  std::atomic<uint64_t> _prefetch_key_num{0};
+  std::atomic<uint64_t> _prefetch_load_num{0};
+  std::atomic<uint64_t> _prefetch_reject_num{0};
+  std::atomic<uint64_t> _prefetch_skip_num{0};
+  std::atomic<uint64_t> _prefetch_us{0};
+  std::atomic<uint64_t> _evict_num{0};
 };
 
 }  // namespace distributed
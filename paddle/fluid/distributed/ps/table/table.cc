@@ -36,6 +36,7 @@ REGISTER_PSCORE_CLASS(Table, BarrierTable);
 // REGISTER_PSCORE_CLASS(Table, DenseTensorTable);
 // REGISTER_PSCORE_CLASS(Table, GlobalStepTable);
 REGISTER_PSCORE_CLASS(Table, MemorySparseTable);
+REGISTER_PSCORE_CLASS(Table, MemorySparseCompactTable);
 REGISTER_PSCORE_CLASS(Table, SSDSparseTable);
 REGISTER_PSCORE_CLASS(Table, MemorySparseGeoTable);
 
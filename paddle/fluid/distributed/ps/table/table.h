@@ -25,6 +25,7 @@
 #include "paddle/common/macros.h"
 #include "paddle/fluid/distributed/common/afs_warpper.h"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
+#include "paddle/fluid/distributed/ps/table/depends/push_compress.h"
 #include "paddle/fluid/distributed/ps/table/depends/sparse_utils.h"
 #include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
 #include "paddle/fluid/framework/channel.h"
@@ -54,6 +55,11 @@ struct TablePushContext {
   const float **ptr_values = nullptr;
   const int64_t *push_steps = nullptr;  // for global step
   bool is_param = false;  // true: push param, false: push gradient
+  // values encoded as compress_header, decoded by the table in place of
+  // values, see TableParameter.push_compress
+  const char *compressed_values = nullptr;
+  size_t compressed_size = 0;
+  PushCompressHeader compress_header;
 };
 
 struct TableContext {
@@ -158,6 +164,10 @@ class Table {
   virtual void *GetShard(size_t shard_idx) = 0;
   virtual std::pair<int64_t, int64_t> PrintTableStat() { return {0, 0}; }
   virtual int32_t CacheTable(uint16_t pass_id UNUSED) { return 0; }
+  // 异步预取下一个batch的keys, 返回时预取不一定完成
+  virtual int32_t Prefetch(const uint64_t *keys UNUSED, size_t num UNUSED) {
+    return 0;
+  }
 
   // for patch model
   virtual void Revert() {}
@@ -732,6 +732,17 @@ void FleetWrapper::RecvAndSaveTable(const uint64_t table_id,
   }
 }
 
+void FleetWrapper::PrefetchSparse(
+    const uint64_t table_id,
+    const std::vector<uint64_t>& keys,
+    std::vector<std::future<int32_t>>* prefetch_status) {
+  if (keys.empty()) {
+    return;
+  }
+  prefetch_status->push_back(
+      worker_ptr_->PrefetchSparse(table_id, keys.data(), keys.size()));
+}
+
 void FleetWrapper::PrintTableStat(const uint64_t table_id) {
   auto ret = worker_ptr_->PrintTableStat(table_id);
   ret.wait();
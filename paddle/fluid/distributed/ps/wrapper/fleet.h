@@ -119,6 +119,14 @@ class FleetWrapper {
       std::vector<const phi::DenseTensor*>* inputs,  // NOLINT
       std::vector<phi::DenseTensor*>* outputs);      // NOLINT
 
+  // Ask the servers to warm the values of the next minibatch, usually called
+  // with the keys of the next batch while the current batch is trained. It
+  // does not wait for the values to be loaded, the status of the request is
+  // appended to prefetch_status to be checked later.
+  void PrefetchSparse(const uint64_t table_id,
+                      const std::vector<uint64_t>& keys,
+                      std::vector<std::future<int32_t>>* prefetch_status);
+
   // pull dense variables from server in sync mod
   // Param<in>: scope, table_id, var_names
   // Param<out>: void
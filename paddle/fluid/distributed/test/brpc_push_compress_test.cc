@@ -0,0 +1,451 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_client.h"
+#include "paddle/fluid/distributed/ps/service/brpc_ps_server.h"
+#include "paddle/fluid/distributed/ps/table/depends/push_compress.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace framework = paddle::framework;
+namespace distributed = paddle::distributed;
+
+static std::vector<float> RandomValues(size_t n, int seed) {
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> dist(0, 1);
+  std::vector<float> values(n);
+  for (auto& v : values) {
+    v = dist(gen);
+  }
+  return values;
+}
+
+static std::vector<float> RoundTrip(const distributed::PushCompressHeader& h,
+                                    const std::vector<float>& values,
+                                    size_t row_num) {
+  std::vector<char> buf(row_num * distributed::PushCompressRowBytes(h));
+  char* end = buf.data();
+  for (size_t i = 0; i < row_num; ++i) {
+    end = distributed::PushCompressEncodeRow(
+        h, values.data() + i * h.row_dim, end);
+  }
+  EXPECT_EQ(end, buf.data() + buf.size());
+  std::vector<float> decoded;
+  EXPECT_TRUE(distributed::PushCompressDecode(
+      h, buf.data(), buf.size(), row_num, &decoded));
+  return decoded;
+}
+
+TEST(PushCompress, half) {
+  const size_t row_num = 100, row_dim = 13;
+  auto values = RandomValues(row_num * row_dim, 0);
+  for (auto type : {distributed::PUSH_COMPRESS_FP16,
+                    distributed::PUSH_COMPRESS_BF16}) {
+    distributed::PushCompressHeader h = {
+        static_cast<uint32_t>(type), 64, 3, row_dim};
+    EXPECT_EQ(distributed::PushCompressRowBytes(h), 3 * 4 + 10 * 2UL);
+    auto decoded = RoundTrip(h, values, row_num);
+    // within an ulp of 10 and 7 bits of mantissa, the conversion of
+    // phi::dtype::float16 may truncate
+    float eps = type == distributed::PUSH_COMPRESS_FP16 ? 1.0f / 1024
+                                                        : 1.0f / 128;
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (i % row_dim < 3) {
+        ASSERT_EQ(decoded[i], values[i]);
+      } else {
+        ASSERT_NEAR(decoded[i],
+                    values[i],
+                    std::max(std::fabs(values[i]) * eps, 1e-7f));
+      }
+    }
+  }
+}
+
+TEST(PushCompress, int8) {
+  const size_t row_num = 100, row_dim = 100;
+  auto values = RandomValues(row_num * row_dim, 1);
+  values[5] = 0;
+  distributed::PushCompressHeader h = {
+      distributed::PUSH_COMPRESS_INT8, 16, 4, row_dim};
+  // 96 values in 6 blocks, which never cross the rows
+  EXPECT_EQ(distributed::PushCompressRowBytes(h), 4 * 4 + 6 * 4 + 96UL);
+  auto decoded = RoundTrip(h, values, row_num);
+  for (size_t row = 0; row < row_num; ++row) {
+    for (size_t begin = 4; begin < row_dim; begin += 16) {
+      size_t end = std::min<size_t>(begin + 16, row_dim);
+      float max_abs = 0;
+      for (size_t i = begin; i < end; ++i) {
+        max_abs = std::max(max_abs, std::fabs(values[row * row_dim + i]));
+      }
+      for (size_t i = begin; i < end; ++i) {
+        size_t idx = row * row_dim + i;
+        ASSERT_NEAR(decoded[idx], values[idx], max_abs / 127 / 2 * 1.001);
+      }
+    }
+  }
+  ASSERT_EQ(decoded[5], 0);
+
+  // a block of zeros
+  std::vector<float> zeros(row_dim, 0);
+  decoded = RoundTrip(h, zeros, 1);
+  ASSERT_EQ(decoded, zeros);
+}
+
+TEST(PushCompress, topk) {
+  const size_t n = 1000, k = 10, rounds = 50;
+  std::vector<float> residual(n, 0), sent(n, 0), pushed(n, 0);
+  distributed::PushCompressHeader h = {
+      distributed::PUSH_COMPRESS_TOPK, 64, 0, n};
+  std::vector<char> buf(distributed::PushCompressTopKBytes(k));
+  std::vector<float> decoded;
+  for (size_t r = 0; r < rounds; ++r) {
+    auto values = RandomValues(n, r);
+    char* end = distributed::PushCompressEncodeTopK(
+        values.data(), n, k, residual.data(), buf.data());
+    ASSERT_EQ(end, buf.data() + buf.size());
+    ASSERT_TRUE(distributed::PushCompressDecode(
+        h, buf.data(), buf.size(), 1, &decoded));
+    size_t nonzero = 0;
+    for (size_t i = 0; i < n; ++i) {
+      nonzero += decoded[i] != 0;
+      sent[i] += decoded[i];
+      pushed[i] += values[i];
+    }
+    ASSERT_EQ(nonzero, k);
+  }
+  // nothing is lost, the values not sent yet are in the residual
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_NEAR(sent[i] + residual[i], pushed[i], 1e-3);
+  }
+}
+
+TEST(PushCompress, malformed) {
+  distributed::PushCompressHeader h = {
+      distributed::PUSH_COMPRESS_INT8, 64, 3, 13};
+  std::vector<char> buf(2 * distributed::PushCompressRowBytes(h), 0);
+  std::vector<float> values;
+  ASSERT_TRUE(
+      distributed::PushCompressDecode(h, buf.data(), buf.size(), 2, &values));
+  ASSERT_FALSE(distributed::PushCompressDecode(
+      h, buf.data(), buf.size() - 1, 2, &values));
+  ASSERT_FALSE(
+      distributed::PushCompressDecode(h, buf.data(), buf.size(), 3, &values));
+  h.raw_dim = 14;
+  ASSERT_FALSE(
+      distributed::PushCompressDecode(h, buf.data(), buf.size(), 2, &values));
+
+  h = {distributed::PUSH_COMPRESS_TOPK, 64, 0, 13};
+  uint32_t topk[3] = {1, 13, 0};
+  ASSERT_FALSE(distributed::PushCompressDecode(
+      h, reinterpret_cast<char*>(topk), sizeof(topk), 1, &values));
+  topk[1] = 12;
+  ASSERT_TRUE(distributed::PushCompressDecode(
+      h, reinterpret_cast<char*>(topk), sizeof(topk), 1, &values));
+}
+
+/*-------------------------------------------------------------------------*/
+
+const char* ip_ = "127.0.0.1";
+uint32_t port_ = 4217;
+const uint32_t kDenseDim = 1 << 20;
+const uint32_t kSparseKeyNum = 10000;
+// dense tables 0 - 3 and sparse tables 4 - 7 push by these types
+const std::vector<distributed::PushCompressType> kDenseTypes = {
+    distributed::PUSH_COMPRESS_NONE,
+    distributed::PUSH_COMPRESS_FP16,
+    distributed::PUSH_COMPRESS_INT8,
+    distributed::PUSH_COMPRESS_TOPK};
+const std::vector<distributed::PushCompressType> kSparseTypes = {
+    distributed::PUSH_COMPRESS_NONE,
+    distributed::PUSH_COMPRESS_FP16,
+    distributed::PUSH_COMPRESS_BF16,
+    distributed::PUSH_COMPRESS_INT8};
+
+std::vector<std::string> host_sign_list_;
+std::shared_ptr<distributed::PSServer> pserver_ptr_;
+std::shared_ptr<distributed::PSClient> worker_ptr_;
+
+void GetDenseTableProto(uint32_t table_id,
+                        distributed::PushCompressType type,
+                        distributed::TableParameter* table_proto) {
+  table_proto->set_table_id(table_id);
+  table_proto->set_table_class("MemoryDenseTable");
+  table_proto->set_shard_num(256);
+  table_proto->set_type(distributed::PS_DENSE_TABLE);
+  table_proto->mutable_push_compress()->set_type(type);
+  table_proto->mutable_push_compress()->set_topk_ratio(0.01);
+  auto* accessor_proto = table_proto->mutable_accessor();
+  accessor_proto->set_accessor_class("CommMergeAccessor");
+  accessor_proto->set_fea_dim(kDenseDim);
+  accessor_proto->set_embedx_dim(1);
+
+  auto* common_proto = table_proto->mutable_common();
+  common_proto->set_name("sgd");
+  common_proto->set_table_name("MergedDense");
+  common_proto->set_trainer_num(1);
+  common_proto->set_sync(false);
+  common_proto->add_params("Param");
+  common_proto->add_dims(kDenseDim);
+  common_proto->add_initializers("fill_constant&0.0");
+  common_proto->add_params("LearningRate");
+  common_proto->add_dims(1);
+  common_proto->add_initializers("fill_constant&1.0");
+}
+
+void GetSparseTableProto(uint32_t table_id,
+                         distributed::PushCompressType type,
+                         distributed::TableParameter* table_proto) {
+  table_proto->set_table_id(table_id);
+  table_proto->set_table_class("MemorySparseTable");
+  table_proto->set_shard_num(10);
+  table_proto->set_type(distributed::PS_SPARSE_TABLE);
+  table_proto->mutable_push_compress()->set_type(type);
+  auto* accessor_config = table_proto->mutable_accessor();
+  accessor_config->set_accessor_class("SparseAccessor");
+  accessor_config->set_fea_dim(10);
+  accessor_config->set_embedx_dim(9);
+  accessor_config->set_embedx_threshold(0);
+  auto* ctr_param = accessor_config->mutable_ctr_accessor_param();
+  ctr_param->set_nonclk_coeff(0.2);
+  ctr_param->set_click_coeff(1);
+  ctr_param->set_base_threshold(0.5);
+  ctr_param->set_delta_threshold(0.2);
+  ctr_param->set_delta_keep_days(16);
+  ctr_param->set_show_click_decay_rate(0.99);
+  for (auto* sgd_param : {accessor_config->mutable_embed_sgd_param(),
+                          accessor_config->mutable_embedx_sgd_param()}) {
+    sgd_param->set_name("SparseNaiveSGDRule");
+    auto* naive_param = sgd_param->mutable_naive();
+    naive_param->set_learning_rate(1.0);
+    // all the tables start from 0 to be comparable
+    naive_param->set_initial_range(0);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+  }
+}
+
+void AddTables(distributed::DownpourServerParameter* server_proto) {
+  for (size_t i = 0; i < kDenseTypes.size(); ++i) {
+    GetDenseTableProto(
+        i, kDenseTypes[i], server_proto->add_downpour_table_param());
+  }
+  for (size_t i = 0; i < kSparseTypes.size(); ++i) {
+    GetSparseTableProto(kDenseTypes.size() + i,
+                        kSparseTypes[i],
+                        server_proto->add_downpour_table_param());
+  }
+}
+
+void SetServiceProto(distributed::DownpourServerParameter* server_proto) {
+  auto* server_service_proto = server_proto->mutable_service_param();
+  server_service_proto->set_service_class("BrpcPsService");
+  server_service_proto->set_server_class("BrpcPsServer");
+  server_service_proto->set_client_class("BrpcPsClient");
+  server_service_proto->set_start_server_port(0);
+  server_service_proto->set_server_thread_num(12);
+}
+
+distributed::PSParameter GetServerProto() {
+  distributed::PSParameter server_fleet_desc;
+  auto* server_proto =
+      server_fleet_desc.mutable_server_param()->mutable_downpour_server_param();
+  SetServiceProto(server_proto);
+  AddTables(server_proto);
+  return server_fleet_desc;
+}
+
+distributed::PSParameter GetWorkerProto() {
+  distributed::PSParameter worker_fleet_desc;
+  auto* worker_proto = worker_fleet_desc.mutable_worker_param()
+                           ->mutable_downpour_worker_param();
+  for (size_t i = 0; i < kDenseTypes.size(); ++i) {
+    GetDenseTableProto(
+        i, kDenseTypes[i], worker_proto->add_downpour_table_param());
+  }
+  for (size_t i = 0; i < kSparseTypes.size(); ++i) {
+    GetSparseTableProto(kDenseTypes.size() + i,
+                        kSparseTypes[i],
+                        worker_proto->add_downpour_table_param());
+  }
+  auto* server_proto =
+      worker_fleet_desc.mutable_server_param()->mutable_downpour_server_param();
+  SetServiceProto(server_proto);
+  AddTables(server_proto);
+  return worker_fleet_desc;
+}
+
+void RunServer() {
+  distributed::PSParameter server_proto = GetServerProto();
+  auto _ps_env = distributed::PaddlePSEnvironment();
+  _ps_env.SetPsServers(&host_sign_list_, 1);
+  pserver_ptr_ = std::shared_ptr<distributed::PSServer>(
+      distributed::PSServerFactory::Create(server_proto));
+  std::vector<framework::ProgramDesc> empty_vec;
+  framework::ProgramDesc empty_prog;
+  empty_vec.push_back(empty_prog);
+  pserver_ptr_->Configure(server_proto, _ps_env, 0, empty_vec);
+  pserver_ptr_->Start(ip_, port_);
+}
+
+void RunClient() {
+  distributed::PSParameter worker_proto = GetWorkerProto();
+  distributed::PaddlePSEnvironment _ps_env;
+  _ps_env.SetPsServers(&host_sign_list_, host_sign_list_.size());
+  worker_ptr_ = std::shared_ptr<distributed::PSClient>(
+      distributed::PSClientFactory::Create(worker_proto));
+  std::map<uint64_t, std::vector<distributed::Region>> dense_regions;
+  for (size_t i = 0; i < kDenseTypes.size(); ++i) {
+    dense_regions[i] = {};
+  }
+  worker_ptr_->Configure(worker_proto, dense_regions, _ps_env, 0);
+}
+
+distributed::DownpourBrpcClosure* MakeClosure(int cmd_id) {
+  return new distributed::DownpourBrpcClosure(1, [cmd_id](void* done) {
+    auto* closure = reinterpret_cast<distributed::DownpourBrpcClosure*>(done);
+    closure->set_promise_value(closure->check_response(0, cmd_id) != 0 ? -1
+                                                                       : 0);
+  });
+}
+
+// Pushes the same gradients to the tables of every type and compares the
+// time, the bytes on the wire and the parameters pulled back.
+void RunBrpcPushCompress() {
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+  auto ph_host = distributed::PSHost(ip_, port_, 0);
+  host_sign_list_.push_back(ph_host.SerializeToString());
+  std::thread server_thread(RunServer);
+  sleep(1);
+  RunClient();
+
+  const int rounds = 20;
+  // the dense values of a single server are padded by one
+  auto grad = RandomValues(kDenseDim + 1, 0);
+  std::vector<float> param(kDenseDim);
+  for (size_t i = 0; i < kDenseTypes.size(); ++i) {
+    int64_t wire_bytes = distributed::BrpcPsClient::PushWireBytes();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+      worker_ptr_
+          ->PushDenseRawGradient(i,
+                                 grad.data(),
+                                 grad.size(),
+                                 MakeClosure(distributed::PS_PUSH_DENSE_TABLE))
+          .wait();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    wire_bytes = distributed::BrpcPsClient::PushWireBytes() - wire_bytes;
+
+    distributed::Region region(param.data(), param.size());
+    worker_ptr_->PullDense(&region, 1, i).wait();
+    double err = 0, norm = 0;
+    for (size_t j = 0; j < kDenseDim; ++j) {
+      double expected = -rounds * grad[j];
+      err += (param[j] - expected) * (param[j] - expected);
+      norm += expected * expected;
+    }
+    err = std::sqrt(err / norm);
+    LOG(INFO) << "dense push of " << kDenseDim << " floats by type "
+              << kDenseTypes[i] << ": " << seconds / rounds * 1000
+              << " ms, " << wire_bytes / rounds << " bytes on wire, "
+              << "relative error " << err;
+    if (kDenseTypes[i] == distributed::PUSH_COMPRESS_NONE) {
+      ASSERT_LT(err, 1e-6);
+    } else if (kDenseTypes[i] == distributed::PUSH_COMPRESS_TOPK) {
+      ASSERT_LT(wire_bytes, rounds * kDenseDim * 4 / 40);
+    } else {
+      ASSERT_LT(err, 0.01);
+      ASSERT_LT(wire_bytes, rounds * kDenseDim * 4 / 3 * 2);
+    }
+  }
+
+  // slot, show, click, embed_g and 9 embedx_g per key
+  const size_t update_dim = 13, select_dim = 10;
+  std::vector<uint64_t> keys(kSparseKeyNum);
+  auto sparse_grad = RandomValues(kSparseKeyNum * update_dim, 1);
+  std::vector<const float*> grad_ptrs(kSparseKeyNum);
+  for (size_t j = 0; j < kSparseKeyNum; ++j) {
+    keys[j] = j;
+    sparse_grad[j * update_dim] = 1;
+    sparse_grad[j * update_dim + 1] = 1;
+    sparse_grad[j * update_dim + 2] = j % 2;
+    grad_ptrs[j] = sparse_grad.data() + j * update_dim;
+  }
+  std::vector<std::vector<float>> pulled(kSparseTypes.size());
+  for (size_t i = 0; i < kSparseTypes.size(); ++i) {
+    size_t table_id = kDenseTypes.size() + i;
+    std::vector<float> values(kSparseKeyNum * select_dim);
+    std::vector<float*> value_ptrs(kSparseKeyNum);
+    for (size_t j = 0; j < kSparseKeyNum; ++j) {
+      value_ptrs[j] = values.data() + j * select_dim;
+    }
+    worker_ptr_
+        ->PullSparse(
+            value_ptrs.data(), table_id, keys.data(), keys.size(), true)
+        .wait();
+
+    int64_t wire_bytes = distributed::BrpcPsClient::PushWireBytes();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+      worker_ptr_
+          ->PushSparseRawGradient(
+              table_id,
+              keys.data(),
+              grad_ptrs.data(),
+              keys.size(),
+              MakeClosure(distributed::PS_PUSH_SPARSE_TABLE))
+          .wait();
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    wire_bytes = distributed::BrpcPsClient::PushWireBytes() - wire_bytes;
+
+    worker_ptr_
+        ->PullSparse(
+            value_ptrs.data(), table_id, keys.data(), keys.size(), true)
+        .wait();
+    pulled[i] = values;
+    LOG(INFO) << "sparse push of " << kSparseKeyNum << " keys by type "
+              << kSparseTypes[i] << ": " << seconds / rounds * 1000
+              << " ms, " << wire_bytes / rounds << " bytes on wire";
+    if (kSparseTypes[i] != distributed::PUSH_COMPRESS_NONE) {
+      ASSERT_LT(wire_bytes, rounds * kSparseKeyNum * (8 + update_dim * 4));
+      double err = 0, norm = 0;
+      for (size_t j = 0; j < pulled[i].size(); ++j) {
+        err += (pulled[i][j] - pulled[0][j]) * (pulled[i][j] - pulled[0][j]);
+        norm += pulled[0][j] * pulled[0][j];
+      }
+      ASSERT_LT(std::sqrt(err / norm), 0.02);
+    }
+  }
+
+  worker_ptr_->StopServer();
+  worker_ptr_->FinalizeWorker();
+  server_thread.join();
+}
+
+TEST(RunBrpcPushCompress, Run) { RunBrpcPushCompress(); }
@@ -14,9 +14,18 @@ limitations under the License. */
 
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <string>
 #include <vector>
 
+#include "glog/logging.h"
 #include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/depends/compact_feature_value.h"
 
 namespace paddle {
 namespace distributed {
@@ -46,5 +55,158 @@ TEST(BENCHMARK, LargeScaleKV) {
   ASSERT_FLOAT_EQ(value_data[3], 0.3);
 }
 
+TEST(CompactSparseTableShard, insert_find_erase) {
+  CompactSparseTableShard<uint64_t> shard(4);
+  const uint64_t num = 10000;
+  std::vector<float*> data(num);
+  for (uint64_t key = 0; key < num; ++key) {
+    auto& value = shard[key * 1000];
+    value.resize(4);
+    for (int i = 0; i < 4; ++i) {
+      value.data()[i] = key + i;
+    }
+    data[key] = value.data();
+  }
+  ASSERT_EQ(shard.size(), num);
+  // the values do not move when the index grows
+  for (uint64_t key = 0; key < num; ++key) {
+    auto it = shard.find(key * 1000);
+    ASSERT_TRUE(it != shard.end());
+    ASSERT_EQ(it.key(), key * 1000);
+    ASSERT_EQ(it.value().size(), 4UL);
+    ASSERT_EQ(it.value().data(), data[key]);
+    ASSERT_FLOAT_EQ(it.value().data()[3], key + 3);
+  }
+  ASSERT_TRUE(shard.find(1) == shard.end());
+
+  // erase the odd keys while iterating, then insert them again
+  size_t visited = 0;
+  for (auto it = shard.begin(); it != shard.end();) {
+    ++visited;
+    if (it.key() / 1000 % 2 == 1) {
+      it = shard.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  ASSERT_EQ(visited, num);
+  ASSERT_EQ(shard.size(), num / 2);
+  ASSERT_TRUE(shard.find(1000) == shard.end());
+  ASSERT_EQ(shard.erase(2000), 1UL);
+  ASSERT_EQ(shard.erase(2000), 0UL);
+  for (uint64_t key = 1; key < num; key += 2) {
+    auto res = shard.emplace(key * 1000);
+    ASSERT_TRUE(res.second);
+    ASSERT_EQ(res.first.value().size(), 0UL);
+  }
+  ASSERT_EQ(shard.size(), num - 1);
+  shard.clear();
+  ASSERT_TRUE(shard.empty());
+  ASSERT_TRUE(shard.begin() == shard.end());
+}
+
+TEST(CompactSparseTableShard, overflow) {
+  CompactSparseTableShard<uint64_t> shard(4);
+  auto& value = shard[7];
+  value.resize(3);
+  float* inline_data = value.data();
+  for (int i = 0; i < 3; ++i) {
+    inline_data[i] = i + 1;
+  }
+  // a larger value, e.g. of a larger mf_dim, goes to the overflow block
+  value.resize(10);
+  ASSERT_TRUE(value.overflowed());
+  ASSERT_NE(value.data(), inline_data);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_FLOAT_EQ(value.data()[i], i < 3 ? i + 1 : 0);
+  }
+  value.data()[9] = 10;
+  value.resize(12);
+  ASSERT_FLOAT_EQ(value.data()[9], 10);
+  ASSERT_FLOAT_EQ(value.data()[11], 0);
+  value.resize(2);
+  ASSERT_FALSE(value.overflowed());
+  ASSERT_EQ(value.data(), inline_data);
+  ASSERT_FLOAT_EQ(value.data()[0], 1);
+  ASSERT_FLOAT_EQ(value.data()[1], 2);
+  value.resize(20);
+  ASSERT_EQ(shard.erase(7), 1UL);
+}
+
+static size_t ResidentBytes() {
+  size_t pages = 0, resident = 0;
+  std::ifstream statm("/proc/self/statm");
+  statm >> pages >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Inserts 1M keys of 12 floats, then pulls and pushes them by key, with
+// CompactSparseTableShard and SparseTableShard.
+template <class Shard>
+void BenchmarkShard(const std::string& name,
+                    Shard* shard,
+                    double* bytes_per_key) {
+  const size_t num = 1 << 20;
+  const int dim = 12;
+  std::vector<uint64_t> keys(num);
+  for (size_t i = 0; i < num; ++i) {
+    keys[i] = i * 1000 + 7;
+  }
+  std::vector<float> values(dim, 0.5), out(dim);
+
+  size_t start_bytes = ResidentBytes();
+  auto start = std::chrono::steady_clock::now();
+  for (auto key : keys) {
+    auto& value = (*shard)[key];
+    value.resize(dim);
+    memcpy(value.data(), values.data(), dim * sizeof(float));
+  }
+  auto insert_end = std::chrono::steady_clock::now();
+  size_t bytes = ResidentBytes() - start_bytes;
+  std::shuffle(keys.begin(), keys.end(), std::mt19937_64(0));
+  auto pull_start = std::chrono::steady_clock::now();
+  for (auto key : keys) {
+    auto it = shard->find(key);
+    memcpy(out.data(), it.value().data(), dim * sizeof(float));
+  }
+  auto push_start = std::chrono::steady_clock::now();
+  for (auto key : keys) {
+    float* data = shard->find(key).value().data();
+    for (int i = 0; i < dim; ++i) {
+      data[i] += values[i];
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  auto ns = [num](std::chrono::steady_clock::time_point a,
+                  std::chrono::steady_clock::time_point b) {
+    return std::chrono::duration<double, std::nano>(b - a).count() / num;
+  };
+  EXPECT_EQ(shard->size(), num);
+  *bytes_per_key = static_cast<double>(bytes) / num;
+  LOG(INFO) << name << ": " << *bytes_per_key << " resident bytes per key of "
+            << dim << " floats, insert " << ns(start, insert_end)
+            << " ns, pull " << ns(pull_start, push_start) << " ns, push "
+            << ns(push_start, end) << " ns per key";
+}
+
+TEST(CompactSparseTableShard, benchmark) {
+  // the compact shard first, its slabs and index are returned to the system
+  // when freed, while the small blocks of SparseTableShard may stay in the
+  // heap and be reused
+  double compact_bytes = 0, shard_bytes = 0;
+  {
+    CompactSparseTableShard<uint64_t> shard(12);
+    BenchmarkShard("CompactSparseTableShard", &shard, &compact_bytes);
+    LOG(INFO) << "CompactSparseTableShard memory_size per key: "
+              << static_cast<double>(shard.memory_size()) / shard.size();
+  }
+  {
+    SparseTableShard<uint64_t, FixedFeatureValue> shard;
+    BenchmarkShard("SparseTableShard", &shard, &shard_bytes);
+  }
+  EXPECT_GT(compact_bytes, 0);
+  EXPECT_LT(compact_bytes, shard_bytes);
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,86 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Not a unit test: compares the sampling throughput of WeightedSampler,
+// AliasSampler and the alias tables of the packed edges. The weights and the
+// samples are seeded, only the times depend on the machine.
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+
+namespace paddle {
+namespace distributed {
+
+// Samples 20 of the 10k weighted neighbors of 200 nodes by the tree of
+// WeightedSampler, by AliasSampler and by the alias tables of the packed
+// edges.
+TEST(AliasSampler, Benchmark) {
+  const int node_num = 200, degree = 10000, k = 20, rounds = 10;
+  std::mt19937_64 gen(0);
+  std::vector<std::unique_ptr<GraphNode>> weighted_nodes, alias_nodes;
+  std::vector<Node *> nodes;
+  for (int i = 0; i < node_num; i++) {
+    weighted_nodes.emplace_back(new GraphNode(i));
+    alias_nodes.emplace_back(new GraphNode(i));
+    weighted_nodes[i]->build_edges(true);
+    alias_nodes[i]->build_edges(true);
+    for (int j = 0; j < degree; j++) {
+      float weight = 0.1 + gen() % 1000 / 100.0;
+      weighted_nodes[i]->add_edge(j, weight);
+      alias_nodes[i]->add_edge(j, weight);
+    }
+    weighted_nodes[i]->build_sampler("weighted");
+    alias_nodes[i]->build_sampler("alias");
+    nodes.push_back(alias_nodes[i].get());
+  }
+
+  auto rng = std::make_shared<std::mt19937_64>(1);
+  auto run = [&](const std::vector<std::unique_ptr<GraphNode>> &samplers) {
+    std::vector<int> result;
+    size_t sample_num = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+      for (auto &node : samplers) {
+        result.clear();
+        node->append_sample_k(k, rng, &result);
+        sample_num += result.size();
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(sample_num, static_cast<size_t>(rounds) * node_num * k);
+    return sample_num / std::chrono::duration<double>(end - start).count();
+  };
+
+  double weighted_speed = run(weighted_nodes);
+  double alias_speed = run(alias_nodes);
+  GraphCsrEdges csr_edges;
+  csr_edges.build(nodes, true);
+  csr_edges.set_sample_type("alias");
+  for (int i = 0; i < node_num; i++) {
+    alias_nodes[i]->pack_edges(&csr_edges, i);
+  }
+  double packed_speed = run(alias_nodes);
+  LOG(INFO) << "samples per second of " << node_num << " nodes of degree "
+            << degree << ", k = " << k << ": weighted " << weighted_speed
+            << ", alias " << alias_speed << ", packed alias " << packed_speed;
+}
+
+}  // namespace distributed
+}  // namespace paddle
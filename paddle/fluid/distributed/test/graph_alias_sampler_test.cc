@@ -0,0 +1,131 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/graph/graph_node.h"
+
+namespace paddle {
+namespace distributed {
+
+static const std::vector<float> kWeights = {1, 2, 3, 4, 0};
+
+static void CheckDistribution(Node *node) {
+  auto rng = std::make_shared<std::mt19937_64>(1);
+  const int times = 100000;
+  std::vector<int> count1(kWeights.size(), 0), count2(kWeights.size(), 0);
+  for (int t = 0; t < times; t++) {
+    auto res = node->sample_k(1, rng);
+    ASSERT_EQ(res.size(), 1UL);
+    count1[res[0]]++;
+    res = node->sample_k(2, rng);
+    ASSERT_EQ(res.size(), 2UL);
+    ASSERT_NE(res[0], res[1]);
+    count2[res[0]]++;
+    count2[res[1]]++;
+  }
+  // the probability of i in the samples of k = 2, sampled one after another
+  // without replacement, is p_i + sum(p_j * p_i / (1 - p_j)) for j != i
+  float sum = 10;
+  for (size_t i = 0; i < kWeights.size(); i++) {
+    float p = kWeights[i] / sum;
+    float p2 = p;
+    for (size_t j = 0; j < kWeights.size(); j++) {
+      if (j != i && kWeights[j] > 0) {
+        p2 += kWeights[j] / sum * p / (1 - kWeights[j] / sum);
+      }
+    }
+    EXPECT_NEAR(static_cast<float>(count1[i]) / times, p, 0.01);
+    EXPECT_NEAR(static_cast<float>(count2[i]) / times, p2, 0.01);
+  }
+
+  // the neighbors of weight 0 are sampled last
+  auto res = node->sample_k(4, rng);
+  ASSERT_EQ(std::set<int>(res.begin(), res.end()),
+            std::set<int>({0, 1, 2, 3}));
+  ASSERT_EQ(node->sample_k(10, rng).size(), kWeights.size());
+}
+
+TEST(AliasSampler, distribution) {
+  GraphNode node(0);
+  node.build_edges(true);
+  for (size_t i = 0; i < kWeights.size(); i++) {
+    node.add_edge(100 + i, kWeights[i]);
+  }
+  node.build_sampler("alias");
+  CheckDistribution(&node);
+
+  // the same for the alias tables of the packed edges
+  GraphCsrEdges csr_edges;
+  std::vector<Node *> nodes = {&node};
+  csr_edges.build(nodes, true);
+  csr_edges.set_sample_type("alias");
+  node.pack_edges(&csr_edges, 0);
+  CheckDistribution(&node);
+}
+
+TEST(AliasSampler, dominant_weight) {
+  GraphNode node(0);
+  node.build_edges(true);
+  node.add_edge(0, 10000);
+  for (int i = 1; i < 100; i++) {
+    node.add_edge(i, 1);
+  }
+  node.build_sampler("alias");
+  auto rng = std::make_shared<std::mt19937_64>(1);
+  // most of the redraws hit the dominant neighbor
+  auto res = node.sample_k(30, rng);
+  ASSERT_EQ(res.size(), 30UL);
+  ASSERT_EQ(std::set<int>(res.begin(), res.end()).size(), 30UL);
+  ASSERT_EQ(res[0], 0);
+}
+
+TEST(AliasSampler, sample_k_batch) {
+  std::vector<std::unique_ptr<GraphNode>> nodes;
+  std::vector<Node *> batch;
+  for (int i = 0; i < 10; i++) {
+    nodes.emplace_back(new GraphNode(i));
+    nodes[i]->build_edges(true);
+    for (int j = 0; j < i; j++) {
+      nodes[i]->add_edge(j, j + 1);
+    }
+    nodes[i]->build_sampler("alias");
+    batch.push_back(nodes[i].get());
+  }
+  batch.push_back(nullptr);
+
+  auto rng = std::make_shared<std::mt19937_64>(1);
+  std::vector<int> result;
+  std::vector<size_t> offsets;
+  sample_k_batch(batch, 3, rng, &result, &offsets);
+  ASSERT_EQ(offsets.size(), batch.size() + 1);
+  for (int i = 0; i < 10; i++) {
+    ASSERT_EQ(offsets[i + 1] - offsets[i], std::min<size_t>(i, 3));
+    std::set<int> samples(result.begin() + offsets[i],
+                          result.begin() + offsets[i + 1]);
+    ASSERT_EQ(samples.size(), offsets[i + 1] - offsets[i]);
+    for (int x : samples) {
+      ASSERT_LT(x, i);
+    }
+  }
+  ASSERT_EQ(offsets[11], offsets[10]);
+}
+
+}  // namespace distributed
+}  // namespace paddle
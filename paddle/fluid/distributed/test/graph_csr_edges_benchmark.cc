@@ -0,0 +1,95 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Not a unit test: compares the memory and the sampling throughput of the
+// edges of a shard in the node layout and in the packed CSR layout. The
+// shard and the samples are seeded, so the byte counts it logs are the same
+// on every run and only the times depend on the machine.
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+
+namespace paddle {
+namespace distributed {
+
+// Adds nodes of skewed degrees to shard, every 100th node is a hub.
+static std::vector<std::vector<uint64_t>> BuildShard(GraphShard *shard,
+                                                     int node_num,
+                                                     int hub_degree) {
+  std::mt19937_64 gen(0);
+  std::vector<std::vector<uint64_t>> neighbors(node_num);
+  for (int i = 0; i < node_num; i++) {
+    auto node = shard->add_graph_node(i);
+    node->build_edges(true);
+    int degree = i % 100 == 0 ? hub_degree : 1 + gen() % 40;
+    for (int j = 0; j < degree; j++) {
+      uint64_t dst = gen() % 1000000;
+      node->add_edge(dst, 0.5 + j % 4);
+      neighbors[i].push_back(dst);
+    }
+    node->build_sampler("random");
+  }
+  return neighbors;
+}
+
+// 100k nodes, the hubs have 5000 neighbors and the others 1 to 40. The
+// number of edges is logged with the results.
+TEST(GraphCsrEdges, Benchmark) {
+  GraphShard shard;
+  auto neighbors = BuildShard(&shard, 100000, 5000);
+  size_t edge_num = 0;
+  for (auto &row : neighbors) {
+    edge_num += row.size();
+  }
+
+  auto run = [&]() {
+    auto rng = std::make_shared<std::mt19937_64>(1);
+    auto start = std::chrono::steady_clock::now();
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < neighbors.size(); i++) {
+      Node *node = shard.find_node(i);
+      for (int x : node->sample_k(10, rng)) {
+        checksum += node->get_neighbor_id(x);
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    VLOG(0) << "checksum " << checksum;
+    return std::chrono::duration<double>(end - start).count();
+  };
+
+  double node_time = run();
+  // the lower bound of the node layout, without the unused capacity of the
+  // vectors and the overhead of the allocator
+  size_t node_bytes =
+      neighbors.size() *
+          (sizeof(WeightedGraphEdgeBlob) + sizeof(RandomSampler)) +
+      edge_num * (sizeof(uint64_t) + sizeof(float));
+  shard.pack_edges(true, "random", "");
+  double csr_time = run();
+  size_t csr_bytes = shard.csr_edges[0]->memory_size();
+
+  LOG(INFO) << "sample 10 neighbors of " << neighbors.size() << " nodes, "
+            << edge_num << " edges: node layout " << node_time * 1000
+            << " ms, at least " << node_bytes << " bytes; csr layout "
+            << csr_time * 1000 << " ms, " << csr_bytes << " bytes";
+  ASSERT_LT(csr_bytes, node_bytes);
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,132 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <set>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/common_graph_table.h"
+
+namespace paddle {
+namespace distributed {
+
+// Adds nodes of skewed degrees to shard, every 100th node is a hub.
+static std::vector<std::vector<uint64_t>> BuildShard(GraphShard *shard,
+                                                     int node_num,
+                                                     int hub_degree) {
+  std::mt19937_64 gen(0);
+  std::vector<std::vector<uint64_t>> neighbors(node_num);
+  for (int i = 0; i < node_num; i++) {
+    auto node = shard->add_graph_node(i);
+    node->build_edges(true);
+    int degree = i % 100 == 0 ? hub_degree : 1 + gen() % 40;
+    for (int j = 0; j < degree; j++) {
+      uint64_t dst = gen() % 1000000;
+      node->add_edge(dst, 0.5 + j % 4);
+      neighbors[i].push_back(dst);
+    }
+    node->build_sampler("random");
+  }
+  return neighbors;
+}
+
+static void CheckShard(GraphShard *shard,
+                       const std::vector<std::vector<uint64_t>> &neighbors) {
+  auto rng = std::make_shared<std::mt19937_64>(1);
+  for (size_t i = 0; i < neighbors.size(); i++) {
+    Node *node = shard->find_node(i);
+    ASSERT_EQ(node->get_neighbor_size(), neighbors[i].size());
+    for (size_t j = 0; j < neighbors[i].size(); j++) {
+      ASSERT_EQ(node->get_neighbor_id(j), neighbors[i][j]);
+    }
+    auto res = node->sample_k(10, rng);
+    std::set<int> unique_res(res.begin(), res.end());
+    ASSERT_EQ(res.size(), std::min<size_t>(10, neighbors[i].size()));
+    ASSERT_EQ(unique_res.size(), res.size());
+    for (int x : res) {
+      ASSERT_GE(x, 0);
+      ASSERT_LT(x, static_cast<int>(neighbors[i].size()));
+    }
+  }
+}
+
+TEST(GraphCsrEdges, pack) {
+  GraphShard shard;
+  auto neighbors = BuildShard(&shard, 1000, 500);
+  shard.pack_edges(true, "random", "");
+  ASSERT_EQ(shard.csr_edges.size(), 1UL);
+  auto &edges = shard.csr_edges[0];
+  ASSERT_EQ(edges->node_num(), 1000UL);
+  ASSERT_TRUE(edges->has_weight());
+  ASSERT_FALSE(edges->is_mapped());
+  CheckShard(&shard, neighbors);
+  ASSERT_FLOAT_EQ(shard.find_node(1)->get_neighbor_weight(1), 1.5);
+
+  // a packed node is unpacked when it is modified
+  auto node = shard.add_graph_node(7);
+  node->build_edges(true);
+  ASSERT_FALSE(node->is_packed());
+  node->add_edge(42, 1.0);
+  neighbors[7].push_back(42);
+  shard.add_neighbor(8, 43, 1.0);
+  neighbors[8].push_back(43);
+  CheckShard(&shard, neighbors);
+
+  // packing again includes the modified nodes
+  shard.pack_edges(false, "random", "");
+  ASSERT_FALSE(shard.csr_edges[0]->has_weight());
+  ASSERT_TRUE(reinterpret_cast<GraphNode *>(shard.find_node(7))->is_packed());
+  CheckShard(&shard, neighbors);
+}
+
+TEST(GraphCsrEdges, mmap) {
+  GraphShard shard;
+  auto neighbors = BuildShard(&shard, 1000, 500);
+  shard.pack_edges(true, "random", "graph_csr_edges_test.csr");
+  ASSERT_TRUE(shard.csr_edges[0]->is_mapped());
+  CheckShard(&shard, neighbors);
+  // map again while the file is mapped
+  shard.pack_edges(true, "random", "graph_csr_edges_test.csr");
+  CheckShard(&shard, neighbors);
+  shard.clear();
+  ASSERT_TRUE(shard.csr_edges.empty());
+}
+
+TEST(GraphCsrEdges, weighted_sample) {
+  GraphShard shard;
+  auto node = shard.add_graph_node(static_cast<uint64_t>(0));
+  node->build_edges(true);
+  node->add_edge(1, 0);
+  node->add_edge(2, 1);
+  node->add_edge(3, 3);
+  shard.pack_edges(true, "weighted", "");
+
+  auto rng = std::make_shared<std::mt19937_64>(1);
+  std::vector<int> count(3, 0);
+  for (int i = 0; i < 4000; i++) {
+    auto res = node->sample_k(1, rng);
+    ASSERT_EQ(res.size(), 1UL);
+    count[res[0]]++;
+  }
+  // the neighbor of weight 0 is never sampled before the others
+  ASSERT_EQ(count[0], 0);
+  ASSERT_GT(count[2], count[1] * 2);
+  auto res = node->sample_k(2, rng);
+  ASSERT_EQ(std::set<int>(res.begin(), res.end()), std::set<int>({1, 2}));
+}
+
+}  // namespace distributed
+}  // namespace paddle
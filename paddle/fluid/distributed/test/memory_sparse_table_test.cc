@@ -17,11 +17,14 @@ limitations under the License. */
 #include <ThreadPool.h>
 #include <unistd.h>
 
+#include <chrono>
+#include <fstream>
 #include <string>
 #include <thread>  // NOLINT
 
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/depends/sparse_binary_format.h"
 #include "paddle/fluid/distributed/ps/table/table.h"
 #include "paddle/fluid/distributed/the_one_ps.pb.h"
 
@@ -152,5 +155,475 @@ TEST(MemorySparseTable, SGD) {
   }
 }
 
+TEST(MemorySparseTable, BinarySaveLoad) {
+  int emb_dim = 8;
+  std::string model_dir = "./memory_sparse_table_binary_test";
+
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(10);
+  table_config.set_save_binary(true);
+  FsClientParameter fs_config;
+
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto *naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  ASSERT_EQ(table->Initialize(table_config, fs_config), 0);
+
+  // push twice so that part of the keys extend mf
+  std::vector<uint64_t> keys = {0, 1, 2, 3, 4, 15, 27, 1000};
+  std::vector<float> gradients;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    for (int k = 0; k < emb_dim + 4; ++k) {
+      gradients.push_back(k == 1 ? 10.0 * (i % 2) : 0.1 * k);
+    }
+  }
+  for (int round = 0; round < 2; ++round) {
+    TableContext push_context;
+    push_context.value_type = Sparse;
+    push_context.push_context.keys = keys.data();
+    push_context.push_context.values = gradients.data();
+    push_context.num = keys.size();
+    ASSERT_EQ(table->Push(push_context), 0);
+  }
+  ASSERT_EQ(table->Save(model_dir, "0"), 0);
+
+  Table *loaded_table = new MemorySparseTable();
+  loaded_table->SetShard(0, 1);
+  ASSERT_EQ(loaded_table->Initialize(table_config, fs_config), 0);
+  ASSERT_EQ(loaded_table->Load(model_dir, "0"), 0);
+
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto pull_value = PullSparseValue(keys, fres, emb_dim);
+  std::vector<float> values(keys.size() * (emb_dim + 3));
+  std::vector<float> loaded_values(keys.size() * (emb_dim + 3));
+  TableContext pull_context;
+  pull_context.value_type = Sparse;
+  pull_context.pull_context.pull_value = pull_value;
+  pull_context.pull_context.values = values.data();
+  table->Pull(pull_context);
+  pull_context.pull_context.values = loaded_values.data();
+  loaded_table->Pull(pull_context);
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    ASSERT_FLOAT_EQ(values[i], loaded_values[i]);
+  }
+  ASSERT_EQ(dynamic_cast<MemorySparseTable *>(table)->LocalSize(),
+            dynamic_cast<MemorySparseTable *>(loaded_table)->LocalSize());
+}
+
+TEST(MemorySparseTable, DeltaSaveLoad) {
+  int emb_dim = 8;
+  std::string model_dir = "./memory_sparse_table_delta_test";
+
+  TableParameter table_config;
+  table_config.set_table_class("MemorySparseTable");
+  table_config.set_shard_num(10);
+  table_config.set_enable_delta_save(true);
+  table_config.set_delta_compact_num(2);
+  FsClientParameter fs_config;
+
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  accessor_config->mutable_ctr_accessor_param()->set_delete_threshold(0.5);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto *naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.3);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  ASSERT_EQ(table->Initialize(table_config, fs_config), 0);
+
+  // the keys of odd index have shows and survive the shrink
+  auto push = [table, emb_dim](const std::vector<uint64_t> &keys) {
+    std::vector<float> gradients;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      for (int k = 0; k < emb_dim + 4; ++k) {
+        gradients.push_back(k == 1 ? 10.0 * (keys[i] % 2) : 0.1 * k);
+      }
+    }
+    TableContext push_context;
+    push_context.value_type = Sparse;
+    push_context.push_context.keys = keys.data();
+    push_context.push_context.values = gradients.data();
+    push_context.num = keys.size();
+    return table->Push(push_context);
+  };
+  // base, then deltas 1 to 3, the first two are merged into the base after
+  // delta 2
+  ASSERT_EQ(push({0, 1, 2, 3, 4, 15, 27, 1000}), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  ASSERT_EQ(push({1, 2, 33, 1001}), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  ASSERT_EQ(table->Shrink(""), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  dynamic_cast<MemorySparseTable *>(table)->CheckDeltaCompactDone();
+  ASSERT_EQ(push({2, 3, 44, 45}), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  std::string delta_dir = model_dir + "/000//delta/";
+  ASSERT_NE(access((delta_dir + "part-000-00000-000001.bin").c_str(), F_OK),
+            0);
+  ASSERT_EQ(access((delta_dir + "part-000-00000-000003.bin").c_str(), F_OK),
+            0);
+
+  Table *loaded_table = new MemorySparseTable();
+  loaded_table->SetShard(0, 1);
+  ASSERT_EQ(loaded_table->Initialize(table_config, fs_config), 0);
+  ASSERT_EQ(loaded_table->Load(model_dir, "6"), 0);
+
+  std::vector<uint64_t> keys = {
+      0, 1, 2, 3, 4, 15, 27, 33, 44, 45, 1000, 1001};
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto pull_value = PullSparseValue(keys, fres, emb_dim);
+  std::vector<float> values(keys.size() * (emb_dim + 3));
+  std::vector<float> loaded_values(keys.size() * (emb_dim + 3));
+  TableContext pull_context;
+  pull_context.value_type = Sparse;
+  pull_context.pull_context.pull_value = pull_value;
+  pull_context.pull_context.values = values.data();
+  table->Pull(pull_context);
+  pull_context.pull_context.values = loaded_values.data();
+  loaded_table->Pull(pull_context);
+
+  for (size_t i = 0; i < values.size(); ++i) {
+    ASSERT_FLOAT_EQ(values[i], loaded_values[i]);
+  }
+  // 0, 2, 4 and 1000 are shrunk, then 2 is pushed again
+  ASSERT_EQ(dynamic_cast<MemorySparseTable *>(table)->LocalSize(), 9);
+  ASSERT_EQ(dynamic_cast<MemorySparseTable *>(loaded_table)->LocalSize(), 9);
+}
+
+// The config of the tables compared below, the values are initialized to zero
+// so that the tables of different shards hold the same values.
+static TableParameter ZeroInitTableConfig(const std::string &table_class) {
+  TableParameter table_config;
+  table_config.set_table_class(table_class);
+  table_config.set_shard_num(10);
+  table_config.set_save_binary(true);
+  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CtrCommonAccessor");
+  accessor_config->set_fea_dim(11);
+  accessor_config->set_embedx_dim(8);
+  accessor_config->set_embedx_threshold(5);
+  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+      0.99);
+  accessor_config->mutable_ctr_accessor_param()->set_delete_threshold(0.5);
+  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+  auto *naive_param =
+      accessor_config->mutable_embed_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.0);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
+  naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
+  naive_param->set_learning_rate(0.1);
+  naive_param->set_initial_range(0.0);
+  naive_param->add_weight_bounds(-10.0);
+  naive_param->add_weight_bounds(10.0);
+  return table_config;
+}
+
+static int32_t InitializeTable(Table *table, const std::string &table_class) {
+  FsClientParameter fs_config;
+  table->SetShard(0, 1);
+  return table->Initialize(ZeroInitTableConfig(table_class), fs_config);
+}
+
+// the keys of odd index have shows, they extend mf on the third push
+static int32_t PushKeys(Table *table,
+                        const std::vector<uint64_t> &keys,
+                        int emb_dim) {
+  std::vector<float> gradients;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    for (int k = 0; k < emb_dim + 4; ++k) {
+      gradients.push_back(k == 1 ? 10.0 * (i % 2) : 0.1 * k);
+    }
+  }
+  TableContext push_context;
+  push_context.value_type = Sparse;
+  push_context.push_context.keys = keys.data();
+  push_context.push_context.values = gradients.data();
+  push_context.num = keys.size();
+  return table->Push(push_context);
+}
+
+static std::vector<float> PullKeys(Table *table,
+                                   std::vector<uint64_t> &keys,  // NOLINT
+                                   int emb_dim) {
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto pull_value = PullSparseValue(keys, fres, emb_dim);
+  std::vector<float> values(keys.size() * (emb_dim + 3));
+  TableContext pull_context;
+  pull_context.value_type = Sparse;
+  pull_context.pull_context.pull_value = pull_value;
+  pull_context.pull_context.values = values.data();
+  table->Pull(pull_context);
+  return values;
+}
+
+TEST(MemorySparseCompactTable, SameAsMemorySparseTable) {
+  int emb_dim = 8;
+  std::string model_dir = "./memory_sparse_compact_table_test";
+  auto *table = new MemorySparseTable();
+  auto *compact_table = new MemorySparseCompactTable();
+  ASSERT_EQ(InitializeTable(table, "MemorySparseTable"), 0);
+  ASSERT_EQ(InitializeTable(compact_table, "MemorySparseCompactTable"), 0);
+
+  std::vector<uint64_t> keys;
+  for (uint64_t key = 0; key < 1000; ++key) {
+    keys.push_back(key * 7919);
+  }
+  for (int round = 0; round < 3; ++round) {
+    ASSERT_EQ(PushKeys(table, keys, emb_dim), 0);
+    ASSERT_EQ(PushKeys(compact_table, keys, emb_dim), 0);
+  }
+  ASSERT_EQ(compact_table->LocalSize(), 1000);
+  ASSERT_EQ(compact_table->LocalMFSize(), 500);
+  ASSERT_EQ(table->LocalMFSize(), 500);
+  auto values = PullKeys(table, keys, emb_dim);
+  auto compact_values = PullKeys(compact_table, keys, emb_dim);
+  for (size_t i = 0; i < values.size(); ++i) {
+    ASSERT_FLOAT_EQ(values[i], compact_values[i]);
+  }
+
+  // the keys without shows are erased
+  ASSERT_EQ(table->Shrink(""), 0);
+  ASSERT_EQ(compact_table->Shrink(""), 0);
+  ASSERT_EQ(table->LocalSize(), 500);
+  ASSERT_EQ(compact_table->LocalSize(), 500);
+
+  // the saved files are the same as those of MemorySparseTable
+  ASSERT_EQ(compact_table->Save(model_dir, "0"), 0);
+  auto *loaded_table = new MemorySparseTable();
+  ASSERT_EQ(InitializeTable(loaded_table, "MemorySparseTable"), 0);
+  ASSERT_EQ(loaded_table->Load(model_dir, "0"), 0);
+  ASSERT_EQ(loaded_table->LocalSize(), compact_table->LocalSize());
+  std::vector<uint64_t> kept_keys;
+  for (size_t i = 1; i < keys.size(); i += 2) {
+    kept_keys.push_back(keys[i]);
+  }
+  auto loaded_values = PullKeys(loaded_table, kept_keys, emb_dim);
+  compact_values = PullKeys(compact_table, kept_keys, emb_dim);
+  for (size_t i = 0; i < loaded_values.size(); ++i) {
+    ASSERT_FLOAT_EQ(loaded_values[i], compact_values[i]);
+  }
+
+  // the pointers of the values are not FixedFeatureValue
+  std::vector<char *> ptr_values(kept_keys.size());
+  TableContext ptr_context;
+  ptr_context.value_type = Sparse;
+  ptr_context.use_ptr = true;
+  ptr_context.pull_context.ptr_values = ptr_values.data();
+  ptr_context.pull_context.keys = kept_keys.data();
+  ptr_context.num = kept_keys.size();
+  ASSERT_EQ(compact_table->Pull(ptr_context), -1);
+}
+
+static size_t ResidentBytes() {
+  size_t pages = 0, resident = 0;
+  std::ifstream statm("/proc/self/statm");
+  statm >> pages >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Logs the resident bytes per key and the latency of the pushes and pulls of
+// both tables, with 256K keys of which half extend mf.
+template <class TableType>
+void BenchmarkTable(const std::string &table_class, double *bytes_per_key) {
+  int emb_dim = 8;
+  std::vector<uint64_t> keys(1 << 18);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = i * 7919;
+  }
+  size_t start_bytes = ResidentBytes();
+  auto *table = new TableType();
+  ASSERT_EQ(InitializeTable(table, table_class), 0);
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < 3; ++round) {
+    ASSERT_EQ(PushKeys(table, keys, emb_dim), 0);
+  }
+  auto pull_start = std::chrono::steady_clock::now();
+  PullKeys(table, keys, emb_dim);
+  auto end = std::chrono::steady_clock::now();
+  size_t bytes = ResidentBytes() - start_bytes;
+  ASSERT_EQ(table->LocalSize(), static_cast<int64_t>(keys.size()));
+  auto ns = [&keys](std::chrono::steady_clock::time_point a,
+                    std::chrono::steady_clock::time_point b) {
+    return std::chrono::duration<double, std::nano>(b - a).count() /
+           keys.size();
+  };
+  *bytes_per_key = static_cast<double>(bytes) / keys.size();
+  LOG(INFO) << table_class << ": " << *bytes_per_key
+            << " resident bytes per key, push " << ns(start, pull_start) / 3
+            << " ns, pull " << ns(pull_start, end) << " ns per key";
+  delete table;
+}
+
+TEST(MemorySparseCompactTable, Benchmark) {
+  // the compact table first, the small blocks of SparseTableShard may stay in
+  // the heap when freed and be reused
+  double compact_bytes = 0, shard_bytes = 0;
+  BenchmarkTable<MemorySparseCompactTable>("MemorySparseCompactTable",
+                                           &compact_bytes);
+  BenchmarkTable<MemorySparseTable>("MemorySparseTable", &shard_bytes);
+  EXPECT_GT(compact_bytes, 0);
+  EXPECT_LT(compact_bytes, shard_bytes);
+}
+
+TEST(MemorySparseTable, DeltaSaveAfterFullSave) {
+  int emb_dim = 8;
+  std::string model_dir = "./memory_sparse_table_delta_full_test";
+  std::string checkpoint_dir = "./memory_sparse_table_delta_full_checkpoint";
+  auto table_config = ZeroInitTableConfig("MemorySparseTable");
+  table_config.set_enable_delta_save(true);
+  table_config.set_delta_compact_num(0);
+  FsClientParameter fs_config;
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  ASSERT_EQ(table->Initialize(table_config, fs_config), 0);
+
+  ASSERT_EQ(PushKeys(table, {0, 1, 2, 3, 4}, emb_dim), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  ASSERT_EQ(PushKeys(table, {1, 2}, emb_dim), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  std::string delta_dir = model_dir + "/000//delta/";
+  ASSERT_EQ(access((delta_dir + "part-000-00000-000001.bin").c_str(), F_OK),
+            0);
+
+  // the full save drops the tracked keys, then the delta save writes a new
+  // base with the keys pushed before it
+  ASSERT_EQ(PushKeys(table, {3, 5}, emb_dim), 0);
+  ASSERT_EQ(table->Save(checkpoint_dir, "0"), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  ASSERT_NE(access((delta_dir + "part-000-00000-000001.bin").c_str(), F_OK),
+            0);
+  ASSERT_NE(access((delta_dir + "part-000-00000-000002.bin").c_str(), F_OK),
+            0);
+
+  Table *loaded_table = new MemorySparseTable();
+  loaded_table->SetShard(0, 1);
+  ASSERT_EQ(loaded_table->Initialize(table_config, fs_config), 0);
+  ASSERT_EQ(loaded_table->Load(model_dir, "6"), 0);
+  ASSERT_EQ(dynamic_cast<MemorySparseTable *>(loaded_table)->LocalSize(), 6);
+  std::vector<uint64_t> keys = {0, 1, 2, 3, 4, 5};
+  auto values = PullKeys(table, keys, emb_dim);
+  auto loaded_values = PullKeys(loaded_table, keys, emb_dim);
+  for (size_t i = 0; i < values.size(); ++i) {
+    ASSERT_FLOAT_EQ(values[i], loaded_values[i]);
+  }
+}
+
+// The number of records of the delta seq of the 10 shards of table 0.
+static size_t DeltaRecordNum(const std::string &model_dir, uint64_t seq) {
+  size_t record_num = 0;
+  for (int i = 0; i < 10; ++i) {
+    std::ifstream file(::paddle::string::format_string(
+                           "%s/000/delta/part-000-%05d-%06lu%s",
+                           model_dir.c_str(),
+                           i,
+                           seq,
+                           PSERVER_BINARY_SAVE_SUFFIX),
+                       std::ios::binary | std::ios::ate);
+    EXPECT_TRUE(file.good());
+    size_t size = file.tellg();
+    file.seekg(0);
+    SparseShardBinaryHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    record_num += (size - sizeof(header)) / header.record_size;
+  }
+  return record_num;
+}
+
+// A delta holds the keys pushed since the previous save but not the keys
+// only pulled, and a pull by pointer makes the next delta save a new base.
+TEST(MemorySparseTable, DeltaSaveOnlyUpdatedKeys) {
+  int emb_dim = 8;
+  std::string model_dir = "./memory_sparse_table_delta_updated_test";
+  auto table_config = ZeroInitTableConfig("MemorySparseTable");
+  table_config.set_enable_delta_save(true);
+  table_config.set_delta_compact_num(0);
+  FsClientParameter fs_config;
+  Table *table = new MemorySparseTable();
+  table->SetShard(0, 1);
+  ASSERT_EQ(table->Initialize(table_config, fs_config), 0);
+
+  std::vector<uint64_t> keys = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  ASSERT_EQ(PushKeys(table, keys, emb_dim), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  std::vector<uint64_t> pulled_keys = {1, 2, 100};
+  PullKeys(table, pulled_keys, emb_dim);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  ASSERT_EQ(DeltaRecordNum(model_dir, 1), 0UL);
+  ASSERT_EQ(PushKeys(table, {3, 100}, emb_dim), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  ASSERT_EQ(DeltaRecordNum(model_dir, 2), 2UL);
+
+  std::vector<char *> ptr_values(pulled_keys.size());
+  TableContext ptr_context;
+  ptr_context.value_type = Sparse;
+  ptr_context.use_ptr = true;
+  ptr_context.pull_context.ptr_values = ptr_values.data();
+  ptr_context.pull_context.keys = pulled_keys.data();
+  ptr_context.num = pulled_keys.size();
+  ASSERT_EQ(table->Pull(ptr_context), 0);
+  ASSERT_EQ(table->Save(model_dir, "6"), 0);
+  std::string delta_dir = model_dir + "/000//delta/";
+  ASSERT_NE(access((delta_dir + "part-000-00000-000002.bin").c_str(), F_OK),
+            0);
+  ASSERT_NE(access((delta_dir + "part-000-00000-000003.bin").c_str(), F_OK),
+            0);
+}
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,229 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/ssd_sparse_table.h"
+
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps/table/table.h"
+#include "paddle/fluid/distributed/the_one_ps.pb.h"
+
+PD_DECLARE_string(rocksdb_path);
+PD_DECLARE_int64(pserver_ssd_mem_budget_per_shard);
+PD_DECLARE_double(pserver_ssd_prefetch_admit_score);
+
+namespace paddle {
+namespace distributed {
+
+static const int kEmbDim = 8;
+static const int kShardNum = 10;
+
+// rocksdb can only be opened once by a process, so all the cases share the
+// table.
+static SSDSparseTable *GetTable() {
+  static SSDSparseTable *table = []() {
+    FLAGS_rocksdb_path = "./ssd_sparse_table_test_db";
+    TableParameter table_config;
+    table_config.set_table_class("SSDSparseTable");
+    table_config.set_shard_num(kShardNum);
+    FsClientParameter fs_config;
+
+    TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+    accessor_config->set_accessor_class("CtrCommonAccessor");
+    accessor_config->set_fea_dim(11);
+    accessor_config->set_embedx_dim(kEmbDim);
+    accessor_config->set_embedx_threshold(5);
+    accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
+    accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
+    accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
+    accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
+    accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
+    accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
+        0.99);
+    accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
+    auto *naive_param =
+        accessor_config->mutable_embed_sgd_param()->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+    accessor_config->mutable_embedx_sgd_param()->set_name(
+        "SparseNaiveSGDRule");
+    naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
+    naive_param->set_learning_rate(0.1);
+    naive_param->set_initial_range(0.3);
+    naive_param->add_weight_bounds(-10.0);
+    naive_param->add_weight_bounds(10.0);
+
+    auto *table = new SSDSparseTable();
+    table->SetShard(0, 1);
+    EXPECT_EQ(table->Initialize(table_config, fs_config), 0);
+    return table;
+  }();
+  return table;
+}
+
+static std::vector<uint64_t> RangeKeys(uint64_t begin, uint64_t end) {
+  std::vector<uint64_t> keys(end - begin);
+  std::iota(keys.begin(), keys.end(), begin);
+  return keys;
+}
+
+// every push adds one show and no click
+static void Push(Table *table, const std::vector<uint64_t> &keys) {
+  std::vector<float> gradients;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    for (int k = 0; k < kEmbDim + 4; ++k) {
+      gradients.push_back(k == 1 ? 1.0 : 0.1 * k);
+    }
+  }
+  TableContext push_context;
+  push_context.value_type = Sparse;
+  push_context.push_context.keys = keys.data();
+  push_context.push_context.values = gradients.data();
+  push_context.num = keys.size();
+  ASSERT_EQ(table->Push(push_context), 0);
+}
+
+// The tasks of a shard run in order, so a pull also waits for the prefetch
+// queued before it.
+static std::vector<float> Pull(Table *table,
+                               const std::vector<uint64_t> &keys) {
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto pull_value = PullSparseValue(keys, fres, kEmbDim);
+  std::vector<float> values(keys.size() * (kEmbDim + 3));
+  TableContext pull_context;
+  pull_context.value_type = Sparse;
+  pull_context.pull_context.pull_value = pull_value;
+  pull_context.pull_context.values = values.data();
+  table->Pull(pull_context);
+  return values;
+}
+
+TEST(SSDSparseTable, PrefetchAndEvict) {
+  auto *table = GetTable();
+  // 100 values in every shard
+  auto all_keys = RangeKeys(0, 100 * kShardNum);
+  Push(table, all_keys);
+  ASSERT_EQ(table->LocalSize(), 100 * kShardNum);
+  auto values = Pull(table, all_keys);
+
+  // a shard over the budget is evicted to 90% of it, the keys being
+  // prefetched are kept
+  FLAGS_pserver_ssd_mem_budget_per_shard = 20;
+  auto stat = table->GetCacheStat();
+  auto hot_keys = RangeKeys(0, kShardNum);
+  table->Prefetch(hot_keys.data(), hot_keys.size());
+  Pull(table, hot_keys);
+  auto evicted_stat = table->GetCacheStat();
+  ASSERT_EQ(table->LocalSize(), 18 * kShardNum);
+  ASSERT_EQ(evicted_stat.evict_num - stat.evict_num, 82UL * kShardNum);
+  ASSERT_EQ(evicted_stat.prefetch_key_num - stat.prefetch_key_num,
+            hot_keys.size());
+  ASSERT_EQ(evicted_stat.pull_mem_hit_num - stat.pull_mem_hit_num,
+            hot_keys.size());
+
+  // the evicted values are loaded back by prefetch, so the pull after it
+  // hits the memory and reads the same values
+  auto next_keys = RangeKeys(100, 100 + 10 * kShardNum);
+  table->Prefetch(next_keys.data(), next_keys.size());
+  auto next_values = Pull(table, next_keys);
+  auto loaded_stat = table->GetCacheStat();
+  ASSERT_GT(loaded_stat.prefetch_load_num, evicted_stat.prefetch_load_num);
+  ASSERT_EQ(loaded_stat.pull_mem_hit_num - evicted_stat.pull_mem_hit_num,
+            next_keys.size());
+  ASSERT_EQ(loaded_stat.pull_ssd_read_num, evicted_stat.pull_ssd_read_num);
+  for (size_t i = 0; i < next_values.size(); ++i) {
+    ASSERT_FLOAT_EQ(next_values[i], values[100 * (kEmbDim + 3) + i]);
+  }
+  ASSERT_LE(table->LocalSize(), 20 * kShardNum);
+  ASSERT_EQ(loaded_stat.prefetch_skip_num, 0UL);
+  FLAGS_pserver_ssd_mem_budget_per_shard = 0;
+}
+
+TEST(SSDSparseTable, PrefetchAdmission) {
+  auto *table = GetTable();
+  auto all_keys = RangeKeys(1000, 1000 + 100 * kShardNum);
+  Push(table, all_keys);
+  auto values = Pull(table, all_keys);
+  // the cold keys score lower than the other new keys, so they are evicted
+  auto cold_keys = RangeKeys(1500, 1500 + kShardNum);
+  std::vector<uint64_t> warm_keys;
+  for (auto key : all_keys) {
+    if (key < cold_keys.front() || key > cold_keys.back()) {
+      warm_keys.push_back(key);
+    }
+  }
+  Push(table, warm_keys);
+
+  // evict most values, then keep every shard over the budget
+  FLAGS_pserver_ssd_mem_budget_per_shard = 20;
+  auto hot_keys = RangeKeys(1000, 1000 + kShardNum);
+  table->Prefetch(hot_keys.data(), hot_keys.size());
+  Pull(table, hot_keys);
+  FLAGS_pserver_ssd_mem_budget_per_shard = 1;
+
+  // values scoring under the admit score stay in rocksdb, and the pull reads
+  // them from there
+  FLAGS_pserver_ssd_prefetch_admit_score = 1.0;
+  auto stat = table->GetCacheStat();
+  table->Prefetch(cold_keys.data(), cold_keys.size());
+  auto cold_values = Pull(table, cold_keys);
+  auto rejected_stat = table->GetCacheStat();
+  ASSERT_EQ(rejected_stat.prefetch_reject_num - stat.prefetch_reject_num,
+            cold_keys.size());
+  ASSERT_EQ(rejected_stat.prefetch_load_num, stat.prefetch_load_num);
+  ASSERT_EQ(rejected_stat.pull_ssd_read_num - stat.pull_ssd_read_num,
+            cold_keys.size());
+  for (size_t i = 0; i < cold_values.size(); ++i) {
+    ASSERT_FLOAT_EQ(cold_values[i], values[500 * (kEmbDim + 3) + i]);
+  }
+  FLAGS_pserver_ssd_prefetch_admit_score = 0.0;
+  FLAGS_pserver_ssd_mem_budget_per_shard = 0;
+}
+
+// pulling by pointer and evicting can not be mixed, so this case runs last
+TEST(SSDSparseTable, NoEvictionAfterPullByPointer) {
+  auto *table = GetTable();
+  // the keys of shard 0
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 10; ++i) {
+    keys.push_back(5000 + i * kShardNum);
+  }
+  std::vector<char *> ptr_values(keys.size());
+  TableContext pull_context;
+  pull_context.value_type = Sparse;
+  pull_context.use_ptr = true;
+  pull_context.shard_id = 0;
+  pull_context.pass_id = 0;
+  pull_context.pull_context.keys = keys.data();
+  pull_context.pull_context.ptr_values = ptr_values.data();
+  pull_context.num = keys.size();
+
+  FLAGS_pserver_ssd_mem_budget_per_shard = 20;
+  ASSERT_ANY_THROW(table->Pull(pull_context));
+  FLAGS_pserver_ssd_mem_budget_per_shard = 0;
+  ASSERT_EQ(table->Pull(pull_context), 0);
+  // the pointers pulled would be invalidated by eviction
+  FLAGS_pserver_ssd_mem_budget_per_shard = 20;
+  ASSERT_ANY_THROW(table->Prefetch(keys.data(), keys.size()));
+  FLAGS_pserver_ssd_mem_budget_per_shard = 0;
+  ASSERT_EQ(table->Prefetch(keys.data(), keys.size()), 0);
+}
+
+}  // namespace distributed
+}  // namespace paddle
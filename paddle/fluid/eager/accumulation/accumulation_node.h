@@ -47,6 +47,9 @@ class TEST_API GradNodeAccumulation : public GradNodeBase {
 
   void ClearTensorWrappers() override { VLOG(5) << "Do nothing here now"; }
 
+  // runs the hooks of the leaf tensor, in order on the calling thread
+  bool CanRunInParallel() const override { return false; }
+
   std::string name() override { return "GradNodeAccumulation"; }
 
   /**
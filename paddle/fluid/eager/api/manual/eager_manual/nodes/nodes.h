@@ -326,6 +326,7 @@ class SyncBatchNormGradNode : public egr::GradNodeBase {
              bool create_graph = false,
              bool is_new_grad = false) override;
   std::string name() override { return "SyncBatchNormGradNode"; }
+  bool CanRunInParallel() const override { return false; }
 
   void ClearTensorWrappers() override {
     x_.clear();
@@ -423,6 +424,7 @@ class ReshardGradNode : public egr::GradNodeBase {
   }
 
   std::string name() override { return "ReshardGradNode"; }
+  bool CanRunInParallel() const override { return false; }
 
   std::shared_ptr<GradNodeBase> Copy() const override {
     {
@@ -458,6 +460,7 @@ class SyncBatchNormGradNode : public egr::GradNodeBase {
              bool create_graph = false,
              bool is_new_grad = false) override;
   std::string name() override { return "SyncBatchNormGradNode"; }
+  bool CanRunInParallel() const override { return false; }
 
   void ClearTensorWrappers() override {
     x_.clear();
@@ -14,10 +14,20 @@
 
 #include "paddle/fluid/eager/backward.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <queue>
+
+#include "paddle/common/flags.h"
 #include "paddle/fluid/eager/general_grad.h"
+#include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/memory/stats.h"
 #include "paddle/phi/kernels/autotune/switch_autotune.h"
 
+COMMON_DECLARE_int32(eager_backward_threads);
+
 namespace egr {
 
 std::unordered_map<GradNodeBase*, int> getInDegreeMap(
@@ -100,6 +110,364 @@ void DuplicateCheck(const std::vector<paddle::Tensor>& inputs, bool is_input) {
   }
 }
 
+// The order in which the sequential backward runs the nodes reachable from
+// the startup nodes in queue, if every node produces all of its grads.
+std::vector<GradNodeBase*> getSequentialOrder(
+    const std::deque<GradNodeBase*>& init_queue,
+    std::unordered_map<GradNodeBase*, int> node_in_degree_map) {
+  std::vector<GradNodeBase*> order;
+  std::deque<GradNodeBase*> queue = init_queue;
+  while (!queue.empty()) {
+    GradNodeBase* node = queue.front();
+    queue.pop_front();
+    order.push_back(node);
+    for (const auto& meta_list : node->OutputMeta()) {
+      for (const GradSlotMeta& meta : meta_list) {
+        const Edge& edge = meta.GetEdge();
+        GradNodeBase* next_node = edge.GetMutableGradNode().get();
+        if (!edge.IsInitialized() || !next_node) continue;
+        if (--node_in_degree_map[next_node] == 0) {
+          if (dynamic_cast<egr::GradNodeAccumulation*>(next_node)) {
+            queue.push_front(next_node);
+          } else {
+            queue.push_back(next_node);
+          }
+        }
+      }
+    }
+  }
+  return order;
+}
+
+// The grad nodes of a backward run by the calling thread and the workers of
+// RunParallelBackward.
+//
+// A node is ready when all of its producers have run, and its grads are
+// summed in the order of the sequential backward, i.e. by the position of
+// the producers in getSequentialOrder, so the results do not depend on the
+// scheduling. The nodes which cannot run in parallel, or have gradient
+// hooks, run on the calling thread in the sequential order as well.
+class ParallelBackward {
+ public:
+  ParallelBackward(const std::vector<GradNodeBase*>& order,
+                   const std::unordered_map<GradNodeBase*, int>& in_degrees,
+                   bool retain_graph)
+      : retain_graph_(retain_graph),
+        tracer_(egr::Controller::Instance().GetCurrentTracer()),
+        has_grad_(egr::Controller::Instance().HasGrad()),
+        place_(egr::Controller::Instance().GetExpectedPlace()) {
+    for (size_t i = 0; i < order.size(); ++i) {
+      auto& state = nodes_[order[i]];
+      state.seq = i;
+      auto iter = in_degrees.find(order[i]);
+      state.in_degree = iter == in_degrees.end() ? 0 : iter->second;
+      state.on_caller = !order[i]->CanRunInParallel() ||
+                        order[i]->GradientHooksRegistered();
+      if (state.on_caller) {
+        caller_nodes_.push_back(order[i]);
+      }
+    }
+  }
+
+  // Takes the input buffer of a startup node.
+  void AddStartupNode(GradNodeBase* node,
+                      std::unique_ptr<GradTensorHolder> buffer) {
+    auto& state = nodes_[node];
+    state.buffer = std::move(buffer);
+    SetReady(node, &state);
+  }
+
+  // Runs the nodes on the calling thread and num_workers threads of pool,
+  // returns when all the nodes have run. Rethrows the first exception of the
+  // nodes after the running ones finish.
+  static void Run(std::shared_ptr<ParallelBackward> self,
+                  paddle::framework::ThreadPool* pool,
+                  int num_workers) {
+    for (int i = 0; i < num_workers; ++i) {
+      pool->Run([self]() { self->WorkerLoop(); });
+    }
+    self->CallerLoop();
+  }
+
+ private:
+  struct Contribution {
+    size_t producer_seq;
+    size_t slot;
+    size_t rank;
+    paddle::Tensor tensor;
+  };
+  struct NodeState {
+    size_t seq = 0;
+    int in_degree = 0;
+    bool on_caller = false;
+    bool ready = false;
+    bool done = false;
+    // a producer did not produce the grads of the node, which never runs
+    // then, as in the sequential backward
+    bool skipped = false;
+    std::unique_ptr<GradTensorHolder> buffer;
+    std::vector<Contribution> contributions;
+  };
+
+  bool Finished() const { return finished_ == nodes_.size(); }
+
+  // Called with mutex_ held, or before the workers start.
+  void SetReady(GradNodeBase* node, NodeState* state) {
+    if (state->skipped) {
+      Finish(state);
+      for (const auto& meta_list : node->OutputMeta()) {
+        for (const GradSlotMeta& meta : meta_list) {
+          const Edge& edge = meta.GetEdge();
+          GradNodeBase* next_node = edge.GetMutableGradNode().get();
+          if (!edge.IsInitialized() || !next_node) continue;
+          auto& next_state = nodes_[next_node];
+          next_state.skipped = true;
+          if (--next_state.in_degree == 0) {
+            SetReady(next_node, &next_state);
+          }
+        }
+      }
+      return;
+    }
+    state->ready = true;
+    if (!state->on_caller) {
+      worker_queue_.emplace(state->seq, node);
+    }
+    cv_.notify_all();
+  }
+
+  void Finish(NodeState* state) {
+    state->done = true;
+    ++finished_;
+    if (Finished()) {
+      cv_.notify_all();
+    }
+  }
+
+  void WorkerLoop() {
+    egr::Controller::Instance().SetCurrentTracer(tracer_);
+    egr::Controller::Instance().SetHasGrad(has_grad_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [this] {
+        return error_ != nullptr || Finished() || !worker_queue_.empty();
+      });
+      if (error_ != nullptr || Finished()) {
+        return;
+      }
+      GradNodeBase* node = worker_queue_.top().second;
+      worker_queue_.pop();
+      RunNode(node, &lock);
+    }
+  }
+
+  // Runs the nodes of caller_nodes_ in order, and the ready nodes of the
+  // workers while waiting for them.
+  void CallerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      while (next_caller_ < caller_nodes_.size() &&
+             nodes_[caller_nodes_[next_caller_]].done) {
+        ++next_caller_;
+      }
+      GradNodeBase* caller_node = next_caller_ < caller_nodes_.size()
+                                      ? caller_nodes_[next_caller_]
+                                      : nullptr;
+      if (error_ != nullptr || Finished()) {
+        break;
+      }
+      if (caller_node != nullptr && nodes_[caller_node].ready) {
+        RunNode(caller_node, &lock);
+      } else if (!worker_queue_.empty()) {
+        GradNodeBase* node = worker_queue_.top().second;
+        worker_queue_.pop();
+        RunNode(node, &lock);
+      } else {
+        cv_.wait(lock);
+      }
+    }
+    cv_.wait(lock, [this] { return running_ == 0; });
+    if (error_ != nullptr) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  // Runs a ready node with lock held, which is released while the node runs.
+  void RunNode(GradNodeBase* node, std::unique_lock<std::mutex>* lock) {
+    auto& state = nodes_[node];
+    state.ready = false;
+    std::unique_ptr<GradTensorHolder> buffer = std::move(state.buffer);
+    std::vector<Contribution> contributions = std::move(state.contributions);
+    ++running_;
+    lock->unlock();
+
+    paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
+        grad_output_tensors;
+    std::exception_ptr error;
+    try {
+      VLOG(3) << "Preparing GradNode:" << node->name() << " addr:" << node;
+      paddle::platform::RecordEvent node_record_event(
+          std::string((*node).name()),
+          paddle::platform::TracerEventType::Operator,
+          1);
+      if (!buffer) {
+        buffer = std::make_unique<GradTensorHolder>(node->InputMeta());
+      }
+      // the grads of a producer are in the order of its edges already
+      std::stable_sort(contributions.begin(),
+                       contributions.end(),
+                       [](const Contribution& a, const Contribution& b) {
+                         return a.producer_seq < b.producer_seq;
+                       });
+      for (auto& contribution : contributions) {
+        buffer->add(contribution.slot, contribution.rank, contribution.tensor);
+      }
+      contributions.clear();
+
+      EnforceGradNodeHasInput(node);
+      grad_output_tensors = (*node)(buffer->Buffers(), false, false);
+      if (!retain_graph_) {
+        node->ClearTensorWrappers();
+      }
+      buffer.reset();
+      paddle::memory::LogDeviceMemoryStats(place_, std::string(node->name()));
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock->lock();
+    --running_;
+    if (error != nullptr) {
+      if (error_ == nullptr) {
+        error_ = error;
+      }
+      cv_.notify_all();
+      return;
+    }
+    try {
+      AddGrads(node, &grad_output_tensors);
+    } catch (...) {
+      if (error_ == nullptr) {
+        error_ = std::current_exception();
+      }
+    }
+    Finish(&state);
+    cv_.notify_all();
+  }
+
+  // Passes the grads produced by node to the next nodes, with mutex_ held.
+  void AddGrads(GradNodeBase* node,
+                paddle::small_vector<std::vector<paddle::Tensor>,
+                                     kSlotSmallVectorSize>* grads) {
+    size_t seq = nodes_[node].seq;
+    const auto& metas = node->OutputMeta();
+    PADDLE_ENFORCE(metas.size() == grads->size() || metas.empty(),
+                   paddle::platform::errors::Fatal(
+                       "Number of edges should be either empty ( for leaf node "
+                       ") or the same as number of output grad tensors, but we "
+                       "got edges size is: %d, grad_output size is: %d",
+                       metas.size(),
+                       grads->size()));
+    for (size_t i = 0; i < metas.size(); i++) {
+      for (size_t j = 0; j < metas[i].size(); j++) {
+        const Edge& edge = metas[i][j].GetEdge();
+        GradNodeBase* next_node = edge.GetMutableGradNode().get();
+        if (!edge.IsInitialized() || !next_node) {
+          continue;
+        }
+        auto& next_state = nodes_[next_node];
+        if ((*grads)[i].empty()) {
+          next_state.skipped = true;
+        } else {
+          PADDLE_ENFORCE_LT(
+              j,
+              (*grads)[i].size(),
+              paddle::platform::errors::Fatal(
+                  "Rank of grad_output_tensors should be less than "
+                  "grad_output_tensors[i].size(), which is: %d. This error "
+                  "may indicate autoprune or autograd api error. ",
+                  grads->size()));
+          auto edge_rank = edge.GetEdgeRankInfo();
+          next_state.contributions.push_back(
+              {seq, edge_rank.first, edge_rank.second, (*grads)[i][j]});
+        }
+        PADDLE_ENFORCE(
+            next_state.in_degree > 0,
+            paddle::platform::errors::Fatal(
+                "Detected in-degree value smaller than zero. For Node: %s"
+                "Node's in-degree cannot be negative.",
+                next_node->name()));
+        if (--next_state.in_degree == 0) {
+          SetReady(next_node, &next_state);
+        }
+      }
+    }
+  }
+
+  bool retain_graph_;
+  std::shared_ptr<paddle::imperative::Tracer> tracer_;
+  bool has_grad_;
+  paddle::platform::Place place_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<GradNodeBase*, NodeState> nodes_;
+  // the ready nodes of the workers, the first in the sequential order first
+  std::priority_queue<std::pair<size_t, GradNodeBase*>,
+                      std::vector<std::pair<size_t, GradNodeBase*>>,
+                      std::greater<std::pair<size_t, GradNodeBase*>>>
+      worker_queue_;
+  std::vector<GradNodeBase*> caller_nodes_;
+  size_t next_caller_ = 0;
+  size_t finished_ = 0;
+  int running_ = 0;
+  std::exception_ptr error_;
+};
+
+// The workers of the parallel backward, shared by all the backward calls. A
+// larger pool replaces the cached one when more threads are asked for, the
+// backward calls still running keep the old pool alive by their reference.
+std::shared_ptr<paddle::framework::ThreadPool> getBackwardThreadPool(
+    int num_threads) {
+  static std::mutex mutex;
+  static std::shared_ptr<paddle::framework::ThreadPool> pool;
+  static int pool_threads = 0;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (pool_threads < num_threads) {
+    pool = std::make_shared<paddle::framework::ThreadPool>(num_threads);
+    pool_threads = num_threads;
+  }
+  return pool;
+}
+
+void RunParallelBackward(
+    const std::deque<GradNodeBase*>& queue,
+    const std::unordered_map<GradNodeBase*, int>& node_in_degree_map,
+    std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+        node_input_buffers_dict,
+    bool retain_graph) {
+  auto order = getSequentialOrder(queue, node_in_degree_map);
+  VLOG(3) << "Run " << order.size() << " grad nodes by "
+          << FLAGS_eager_backward_threads << " threads";
+  auto backward = std::make_shared<ParallelBackward>(
+      order, node_in_degree_map, retain_graph);
+  for (GradNodeBase* node : queue) {
+    auto iter = node_input_buffers_dict->find(node);
+    PADDLE_ENFORCE_NE(
+        iter,
+        node_input_buffers_dict->end(),
+        paddle::platform::errors::Fatal(
+            "Unable to find next node in the GradTensorHolder \n"
+            "Trying to run Node without configuring its GradTensorHolder."));
+    backward->AddStartupNode(node, std::move(iter->second));
+  }
+  node_input_buffers_dict->clear();
+  int num_workers = std::min<int>(FLAGS_eager_backward_threads - 1,
+                                  static_cast<int>(order.size()) - 1);
+  auto pool = getBackwardThreadPool(num_workers);
+  ParallelBackward::Run(backward, pool.get(), num_workers);
+}
+
 GeneralGrad* GeneralGrad::general_grad_ = new GeneralGrad();
 
 std::vector<paddle::Tensor> RunBackward(
@@ -243,6 +611,20 @@ std::vector<paddle::Tensor> RunBackward(
 
   VLOG(5) << "Startup_ops's size is " << queue.size();
 
+  // Run the nodes in parallel if the backward is on CPU and does not need
+  // the features of the sequential one below.
+  bool run_parallel = FLAGS_eager_backward_threads > 1 && !is_general_grad &&
+                      !create_graph && force_sequential_nodes_set.empty() &&
+                      paddle::platform::is_cpu_place(place);
+  for (GradNodeBase* node : queue) {
+    run_parallel = run_parallel && node_in_degree_map[node] == 0;
+  }
+  if (run_parallel) {
+    RunParallelBackward(
+        queue, node_in_degree_map, &node_input_buffers_dict, retain_graph);
+    queue.clear();
+  }
+
   /* --- Topological Visit --- */
   // 1. Pop queue
   // 2. Run node
@@ -74,6 +74,8 @@ class RunCustomOpNode : public GradNodeBase {
     grads2grad_in_map.clear();
   }
 
+  bool CanRunInParallel() const override { return false; }
+
   void SetAttrs(const std::vector<paddle::any>& attr) { attrs_ = attr; }
 
   std::shared_ptr<GradNodeBase> Copy() const override {
@@ -145,6 +147,8 @@ class RunCustomOpDoubleGradNode : public GradNodeBase {
     grads2grad_in_map.clear();
   }
 
+  bool CanRunInParallel() const override { return false; }
+
   void SetAttrs(const std::vector<paddle::any>& attr) { attrs_ = attr; }
 
   std::shared_ptr<GradNodeBase> Copy() const override {
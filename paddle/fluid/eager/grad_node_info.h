@@ -220,6 +220,14 @@ class GradNodeBase {
 
   virtual void ClearTensorWrappers() = 0;
 
+  /**
+   * Whether the node can run on a worker thread of the parallel backward,
+   * see FLAGS_eager_backward_threads. Nodes which call Python, run
+   * collectives or have side effects in order return false and run on the
+   * calling thread in the order of the sequential backward.
+   * **/
+  virtual bool CanRunInParallel() const { return true; }
+
   /**
    * Self-Copy interface designed for use in DoubleGrad
    * **/
@@ -58,6 +58,8 @@ class GradNodePyLayer : public GradNodeBase {
 
   void ClearTensorWrappers() override { VLOG(6) << "Do nothing here now"; }
 
+  bool CanRunInParallel() const override { return false; }
+
   std::string name() override { return name_; }
 
   void SaveForwardOutputsMeta(
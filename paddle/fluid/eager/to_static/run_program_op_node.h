@@ -1290,6 +1290,8 @@ class GradNodeRunProgram : public egr::GradNodeBase {
     SetIsTensorWrappersCleared(true);
   }
 
+  bool CanRunInParallel() const override { return false; }
+
   // SetAttrMap
   void SetAttrMap(const paddle::framework::AttributeMap &attrs) {
     attrs_ = attrs;
@@ -1476,6 +1478,8 @@ class PirGradNodeRunProgram : public egr::GradNodeBase {
     SetIsTensorWrappersCleared(true);
   }
 
+  bool CanRunInParallel() const override { return false; }
+
   // SetAttrMap
   void SetAttrMap(const paddle::framework::AttributeMap &attrs) {
     attrs_ = attrs;
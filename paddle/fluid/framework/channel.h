@@ -22,11 +22,14 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
+#include <cstdint>
 #include <deque>
 #include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -35,6 +38,242 @@
 namespace paddle {
 namespace framework {
 
+// A bounded multi-producer multi-consumer ring buffer. Every cell carries a
+// sequence number telling whether it is ready to be written or read for a
+// position, so producers and consumers only contend on one atomic position
+// per batch. A batch of n items is claimed with a single compare-and-swap and
+// then the cells are filled or drained one by one.
+//
+// Threads only sleep on the condition variables when the ring stays empty or
+// full after spinning for a while, the fast path takes no lock.
+template <class T>
+class ChannelRing {
+ public:
+  explicit ChannelRing(size_t capacity)
+      : capacity_((std::max)(capacity, static_cast<size_t>(1))) {
+    size_t size = 1;
+    while (size < capacity_) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  size_t Capacity() const { return capacity_; }
+
+  bool Closed() const { return closed_.load(std::memory_order_acquire); }
+
+  void SetClosed(bool closed) {
+    closed_.store(closed, std::memory_order_seq_cst);
+    std::lock_guard<std::mutex> lock(mutex_);
+    empty_cond_.notify_all();
+    full_cond_.notify_all();
+  }
+
+  size_t Size() const {
+    uint64_t head = dequeue_pos_.load(std::memory_order_seq_cst);
+    uint64_t tail = enqueue_pos_.load(std::memory_order_seq_cst);
+    return tail > head ? static_cast<size_t>(tail - head) : 0;
+  }
+
+  bool Empty() const { return Size() == 0; }
+
+  // blocking operation, returns less than n if the ring is closed
+  size_t Write(size_t n, const T* p) { return WriteImpl(n, p); }
+
+  // same as Write(), but moves the items out of p
+  size_t WriteMove(size_t n, T* p) { return WriteImpl(n, p); }
+
+  // non-blocking, moves out of p only the items that fit in the ring now
+  size_t TryWriteMove(size_t n, T* p) { return WriteImpl(n, p, false); }
+
+  // blocking operation, returns less than n only if the ring is closed and
+  // empty, or if once is set and some items have been read
+  size_t Read(size_t n, T* p, bool once) {
+    size_t finished = 0;
+    while (finished < n) {
+      uint64_t pos = 0;
+      size_t m = ClaimRead(n - finished, &pos);
+      if (m == 0) {
+        if (!WaitForRead()) {
+          break;
+        }
+        continue;
+      }
+      for (size_t i = 0; i < m; ++i) {
+        Cell& cell = cells_[(pos + i) & mask_];
+        WaitForSeq(cell, pos + i + 1);
+        p[finished + i] = std::move(cell.value);
+        cell.seq.store(pos + i + mask_ + 1, std::memory_order_release);
+      }
+      finished += m;
+      NotifyWaiters(full_waiters_, &full_cond_);
+      if (once) {
+        break;
+      }
+    }
+    return finished;
+  }
+
+ private:
+  static constexpr int kSpinCount = 128;
+
+  struct Cell {
+    std::atomic<uint64_t> seq;
+    T value;
+  };
+
+  static void Assign(T* dst, const T& src) { *dst = src; }
+
+  static void Assign(T* dst, T& src) { *dst = std::move(src); }  // NOLINT
+
+  template <class P>
+  size_t WriteImpl(size_t n, P p, bool wait = true) {
+    size_t finished = 0;
+    while (finished < n) {
+      if (Closed()) {
+        break;
+      }
+      uint64_t pos = 0;
+      size_t m = ClaimWrite(n - finished, &pos);
+      if (m == 0) {
+        if (!wait || !WaitForWrite()) {
+          break;
+        }
+        continue;
+      }
+      for (size_t i = 0; i < m; ++i) {
+        Cell& cell = cells_[(pos + i) & mask_];
+        WaitForSeq(cell, pos + i);
+        Assign(&cell.value, p[finished + i]);
+        cell.seq.store(pos + i + 1, std::memory_order_release);
+      }
+      finished += m;
+      NotifyWaiters(empty_waiters_, &empty_cond_);
+    }
+    return finished;
+  }
+
+  size_t ClaimWrite(size_t n, uint64_t* pos) {
+    uint64_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      uint64_t head = dequeue_pos_.load(std::memory_order_acquire);
+      if (tail < head) {
+        // the tail has been loaded before the consumers passed it
+        tail = enqueue_pos_.load(std::memory_order_relaxed);
+        continue;
+      }
+      size_t used = static_cast<size_t>(tail - head);
+      if (used >= capacity_) {
+        return 0;
+      }
+      size_t m = (std::min)(n, capacity_ - used);
+      if (enqueue_pos_.compare_exchange_weak(
+              tail, tail + m, std::memory_order_seq_cst)) {
+        *pos = tail;
+        return m;
+      }
+    }
+  }
+
+  size_t ClaimRead(size_t n, uint64_t* pos) {
+    uint64_t head = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      uint64_t tail = enqueue_pos_.load(std::memory_order_acquire);
+      if (tail <= head) {
+        return 0;
+      }
+      size_t m = (std::min)(n, static_cast<size_t>(tail - head));
+      if (dequeue_pos_.compare_exchange_weak(
+              head, head + m, std::memory_order_seq_cst)) {
+        *pos = head;
+        return m;
+      }
+    }
+  }
+
+  // A claimed cell may still be filled or drained by the thread that claimed
+  // its previous round, which is already running, so spin until it is done.
+  static void WaitForSeq(const Cell& cell, uint64_t seq) {
+    int spin = 0;
+    while (cell.seq.load(std::memory_order_acquire) != seq) {
+      if (++spin > kSpinCount) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  bool FullForWrite() const { return Size() >= capacity_; }
+
+  // returns false if the ring is closed
+  bool WaitForWrite() {
+    for (int i = 0; i < kSpinCount; ++i) {
+      if (Closed()) {
+        return false;
+      }
+      if (!FullForWrite()) {
+        return true;
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    full_waiters_.fetch_add(1, std::memory_order_seq_cst);
+    while (FullForWrite() && !Closed()) {
+      full_cond_.wait(lock);
+    }
+    full_waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return !Closed();
+  }
+
+  // returns false if the ring is closed and empty
+  bool WaitForRead() {
+    for (int i = 0; i < kSpinCount; ++i) {
+      if (!Empty()) {
+        return true;
+      }
+      if (Closed()) {
+        return !Empty();
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    empty_waiters_.fetch_add(1, std::memory_order_seq_cst);
+    while (Empty() && !Closed()) {
+      empty_cond_.wait(lock);
+    }
+    empty_waiters_.fetch_sub(1, std::memory_order_relaxed);
+    return !Empty();
+  }
+
+  // The waiters check the positions after registering themselves under the
+  // mutex, and the fence orders the position update of this thread before
+  // the load of the waiter count, so either the waiter sees the update or
+  // this thread sees the waiter.
+  void NotifyWaiters(const std::atomic<int>& waiters,
+                     std::condition_variable* cond) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cond->notify_all();
+    }
+  }
+
+  const size_t capacity_;
+  size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+  alignas(64) std::atomic<uint64_t> dequeue_pos_{0};
+  alignas(64) std::atomic<bool> closed_{false};
+  std::atomic<int> empty_waiters_{0};
+  std::atomic<int> full_waiters_{0};
+  std::mutex mutex_;
+  std::condition_variable empty_cond_;
+  std::condition_variable full_cond_;
+};
+
 template <class T>
 class ChannelObject {
  public:
@@ -45,8 +284,26 @@ class ChannelObject {
     capacity_ = (std::min)(MaxCapacity(), capacity);
   }
 
+  // If lock_free is set, the items are kept in a ChannelRing of the capacity
+  // instead of a deque behind the mutex. A lock-free channel is bounded, its
+  // capacity is at least 1 and GetData() is always empty.
+  ChannelObject(size_t capacity, bool lock_free) : ChannelObject(capacity) {
+    if (lock_free) {
+      ring_.reset(new ChannelRing<T>(capacity_));
+      capacity_ = ring_->Capacity();
+    }
+  }
+
+  bool LockFree() const { return ring_ != nullptr; }
+
   const std::deque<T>& GetData() const { return data_; }
   void Clear() {
+    if (ring_ != nullptr) {
+      T val;
+      while (!ring_->Empty() && ring_->Read(1, &val, true) != 0) {
+      }
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     data_.clear();
     data_.shrink_to_fit();
@@ -56,7 +313,10 @@ class ChannelObject {
     return capacity_;  // atomic
   }
 
+  // The capacity of a lock-free channel is fixed when it is made, its
+  // readers and writers do not take mutex_ so the ring can not be swapped.
   void SetCapacity(size_t x) {  // capacity can be zero
+    CHECK(ring_ == nullptr) << "can not resize a lock-free channel";
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = std::min(MaxCapacity(), x);
     Notify();
@@ -75,16 +335,25 @@ class ChannelObject {
   template <class U>
   void InheritFrom(const std::shared_ptr<ChannelObject<U>>& other) {
     std::lock_guard<std::mutex> lock(mutex_);
-    capacity_ = other->Capacity();
+    if (ring_ == nullptr) {
+      capacity_ = other->Capacity();
+    }
     block_size_ = other->BlockSize();
   }
 
   bool Closed() {
+    if (ring_ != nullptr) {
+      return ring_->Closed();
+    }
     return closed_;  // atomic
   }
 
   // open channel, then data can be write() to channel
   void Open() {
+    if (ring_ != nullptr) {
+      ring_->SetClosed(false);
+      return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = false;
     Notify();
@@ -92,17 +361,27 @@ class ChannelObject {
 
   // close channel, then no more data can be write() to channel
   void Close() {
+    if (ring_ != nullptr) {
+      ring_->SetClosed(true);
+      return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = true;
     Notify();
   }
 
   size_t Size() {
+    if (ring_ != nullptr) {
+      return ring_->Size();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
   bool Empty() {
+    if (ring_ != nullptr) {
+      return ring_->Empty();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -116,6 +395,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_ != nullptr) {
+      return ring_->Read(n, p, false);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -135,6 +417,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_ != nullptr) {
+      return ring_->Write(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -146,12 +431,34 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_ != nullptr) {
+      return ring_->WriteMove(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
     return finished;
   }
 
+  // non-blocking operation, moves out of p only the items that fit in the
+  // channel now, returns the number of them
+  size_t TryWriteMove(size_t n, T* p) {
+    if (n == 0) {
+      return 0;
+    }
+    if (ring_ != nullptr) {
+      return ring_->TryWriteMove(n, p);
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_ || FullUnlocked()) {
+      return 0;
+    }
+    size_t room = capacity_ + reading_count_ - data_.size();
+    size_t finished = WriteMove((std::min)(n, room), p, lock);
+    Notify();
+    return finished;
+  }
+
   // read data of block size from channel to vector
   size_t Read(std::vector<T>& p) {  // NOLINT
     p.resize(block_size_);
@@ -164,6 +471,11 @@ class ChannelObject {
     if (size == 0) {
       return 0;
     }
+    if (ring_ != nullptr) {
+      p.resize(size);
+      p.resize(ring_->Read(size, &p[0], true));
+      return p.size();
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     p.resize(size);
     size_t finished = Read(size, &p[0], lock, true);
@@ -205,6 +517,7 @@ class ChannelObject {
   int full_waiters_ = 0;
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
+  std::unique_ptr<ChannelRing<T>> ring_;
 
   static constexpr size_t MaxCapacity() {
     return (std::numeric_limits<size_t>::max)() / 2;
@@ -314,6 +627,13 @@ Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)()) {
   return std::make_shared<ChannelObject<T>>(capacity);
 }
 
+// The channel is bounded by capacity and passes items through a ChannelRing,
+// which scales better when many threads read and write the channel at once.
+template <class T>
+Channel<T> MakeLockFreeChannel(size_t capacity) {
+  return std::make_shared<ChannelObject<T>>(capacity, true);
+}
+
 template <class T, class U>
 Channel<T> MakeChannel(const Channel<U>& other) {
   CHECK(other != nullptr) << "channel can not be NULL";
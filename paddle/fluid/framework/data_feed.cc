@@ -289,8 +289,12 @@ void PrivateQueueDataFeed<T>::SetQueueSize(int queue_size) {
       platform::errors::InvalidArgument(
           "Queue size %d is illegal in PrivateQueueDataFeed.", queue_size));
   queue_size_ = queue_size;
-  queue_ = paddle::framework::MakeChannel<T>();
-  queue_->SetCapacity(queue_size);
+  if (FLAGS_enable_lock_free_data_feed_queue) {
+    queue_ = paddle::framework::MakeLockFreeChannel<T>(queue_size);
+  } else {
+    queue_ = paddle::framework::MakeChannel<T>();
+    queue_->SetCapacity(queue_size);
+  }
 }
 
 template <typename T>
@@ -386,6 +390,51 @@ bool InMemoryDataFeed<T>::Start() {
   return true;
 }
 
+static void AppendUint64Feasigns(const Record& instance,
+                                 std::vector<uint64_t>* keys) {
+  for (auto& item : instance.uint64_feasigns_) {
+    keys->push_back(item.sign().uint64_feasign_);
+  }
+}
+
+static void AppendUint64Feasigns(const SlotRecord& instance,
+                                 std::vector<uint64_t>* keys) {
+  auto& values = instance->slot_uint64_feasigns_.slot_values;
+  keys->insert(keys->end(), values.begin(), values.end());
+}
+
+template <typename T>
+void InMemoryDataFeed<T>::RunNextBatchKeysCallback(const T* ins_vec,
+                                                   int num) {
+  if (!next_batch_keys_callback_ || num <= 0) {
+    return;
+  }
+  std::vector<uint64_t> keys;
+  for (int i = 0; i < num; ++i) {
+    AppendUint64Feasigns(ins_vec[i], &keys);
+  }
+  if (!keys.empty()) {
+    next_batch_keys_callback_(keys);
+  }
+}
+
+template <typename T>
+void InMemoryDataFeed<T>::ReadBatch(std::vector<T>* ins_vec) {
+  int index = 0;
+  T instance;
+  ins_vec->clear();
+  ins_vec->reserve(this->default_batch_size_);
+  while (index < this->default_batch_size_) {
+    if (output_channel_->Size() == 0) {
+      break;
+    }
+    output_channel_->Get(instance);
+    ins_vec->push_back(instance);
+    ++index;
+    consume_channel_->Put(std::move(instance));
+  }
+}
+
 template <typename T>
 int InMemoryDataFeed<T>::Next() {
 #ifdef _LINUX
@@ -396,20 +445,24 @@ int InMemoryDataFeed<T>::Next() {
     VLOG(3) << "output_channel_ size=" << output_channel_->Size()
             << ", consume_channel_ size=" << consume_channel_->Size()
             << ", thread_id=" << thread_id_;
-    int index = 0;
-    T instance;
     std::vector<T> ins_vec;
-    ins_vec.reserve(this->default_batch_size_);
-    while (index < this->default_batch_size_) {
-      if (output_channel_->Size() == 0) {
-        break;
-      }
-      output_channel_->Get(instance);
-      ins_vec.push_back(instance);
-      ++index;
-      consume_channel_->Put(std::move(instance));
+    if (next_batch_keys_callback_) {
+      // read one batch ahead and hand its keys to the callback
+      if (!next_ins_vec_ready_) {
+        ReadBatch(&next_ins_vec_);
+        next_ins_vec_ready_ = true;
+      }
+      ins_vec.swap(next_ins_vec_);
+      ReadBatch(&next_ins_vec_);
+      RunNextBatchKeysCallback(next_ins_vec_.data(),
+                               static_cast<int>(next_ins_vec_.size()));
+    } else {
+      ReadBatch(&ins_vec);
+    }
+    this->batch_size_ = static_cast<int>(ins_vec.size());
+    if (this->batch_size_ == 0) {
+      next_ins_vec_ready_ = false;
     }
-    this->batch_size_ = index;
     VLOG(3) << "batch_size_=" << this->batch_size_
             << ", thread_id=" << thread_id_;
     if (this->batch_size_ != 0) {
@@ -432,6 +485,11 @@ int InMemoryDataFeed<T>::Next() {
     this->batch_size_ = batch.second;
     VLOG(3) << "batch_size_=" << this->batch_size_
             << ", thread_id=" << thread_id_;
+    // the records are in memory, so the next batch is not read ahead
+    if (offset_index_ < batch_offsets_.size()) {
+      auto& next_batch = batch_offsets_[offset_index_];
+      RunNextBatchKeysCallback(&records_[next_batch.first], next_batch.second);
+    }
     if (this->batch_size_ != 0) {
       PutToFeedVec(&records_[batch.first], this->batch_size_);
     } else {
@@ -511,6 +569,12 @@ void InMemoryDataFeed<T>::SetCurrentPhase(int current_phase) {
   current_phase_ = current_phase;
 }
 
+template <typename T>
+void InMemoryDataFeed<T>::SetNextBatchKeysCallback(
+    std::function<void(const std::vector<uint64_t>&)> callback) {
+  next_batch_keys_callback_ = std::move(callback);
+}
+
 template <typename T>
 void InMemoryDataFeed<T>::SetParseInsId(bool parse_ins_id) {
   parse_ins_id_ = parse_ins_id;
@@ -618,6 +682,57 @@ void InMemoryDataFeed<T>::LoadIntoMemoryFromSo() {
 #endif
 }
 
+template <typename T>
+void InMemoryDataFeed<T>::OpenColumnarFile(
+    const std::string& filename,
+    const std::vector<std::string>& slot_types,
+    ColumnarRecordReader* reader) {
+  std::string pipe_command = paddle::string::erase_spaces(pipe_command_);
+  if (fs_select_internal(filename) == 0 &&
+      (pipe_command.empty() || pipe_command == "cat")) {
+    this->fp_.reset();
+    reader->OpenFile(filename);
+  } else {
+    int err_no = 0;
+    this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
+    PADDLE_ENFORCE_NOT_NULL(
+        this->fp_,
+        platform::errors::Unavailable("Failed to open columnar file %s.",
+                                      filename));
+    reader->OpenStream(this->fp_.get(), filename);
+  }
+
+  const auto& slots = reader->slots();
+  PADDLE_ENFORCE_EQ(slots.size(),
+                    all_slots_.size(),
+                    platform::errors::InvalidArgument(
+                        "The columnar file %s has %d slots, but %d slots are "
+                        "set in data_feed_desc.",
+                        filename,
+                        slots.size(),
+                        all_slots_.size()));
+  for (size_t i = 0; i < slots.size(); ++i) {
+    PADDLE_ENFORCE_EQ(
+        slots[i].name == all_slots_[i] && slots[i].type == slot_types[i][0],
+        true,
+        platform::errors::InvalidArgument(
+            "The %d-th slot of columnar file %s is %s(%c), but %s(%s) is set "
+            "in data_feed_desc.",
+            i,
+            filename,
+            slots[i].name,
+            slots[i].type,
+            all_slots_[i],
+            slot_types[i]));
+  }
+  if (parse_ins_id_ || parse_logkey_) {
+    PADDLE_ENFORCE_EQ(reader->has_ins_id(),
+                      true,
+                      platform::errors::InvalidArgument(
+                          "The columnar file %s has no ins id.", filename));
+  }
+}
+
 // explicit instantiation
 template class InMemoryDataFeed<Record>;
 
@@ -1103,6 +1218,109 @@ void MultiSlotInMemoryDataFeed::Init(
   so_parser_name_ = data_feed_desc.so_parser_name();
   finish_init_ = true;
   input_type_ = data_feed_desc.input_type();
+  columnar_input_ = data_feed_desc.data_format() == "columnar";
+}
+
+void MultiSlotInMemoryDataFeed::LoadIntoMemory() {
+  if (columnar_input_) {
+    LoadIntoMemoryByColumnar();
+  } else {
+    InMemoryDataFeed<Record>::LoadIntoMemory();
+  }
+}
+
+void MultiSlotInMemoryDataFeed::LoadIntoMemoryByColumnar() {
+#ifdef _LINUX
+  PADDLE_ENFORCE_EQ(parse_content_ || parse_uid_,
+                    false,
+                    platform::errors::Unimplemented(
+                        "Content and uid are not stored in columnar files."));
+  VLOG(3) << "LoadIntoMemoryByColumnar() begin, thread_id=" << thread_id_;
+  std::string filename;
+  ColumnarRecordReader reader;
+  ColumnarBlock block;
+  while (this->PickOneFile(&filename)) {
+    VLOG(3) << "PickOneFile, filename=" << filename
+            << ", thread_id=" << thread_id_;
+    platform::Timer timeline;
+    timeline.Start();
+    OpenColumnarFile(filename, all_slots_type_, &reader);
+    paddle::framework::ChannelWriter<Record> writer(input_channel_);
+    int lines = 0;
+    while (reader.NextBlock(&block)) {
+      for (uint32_t i = 0; i < block.record_num(); ++i) {
+        Record instance;
+        if (ParseOneColumnarInstance(block, i, &instance)) {
+          writer << std::move(instance);
+          ++lines;
+        }
+      }
+    }
+    reader.Close();
+    STAT_ADD(STAT_total_feasign_num_in_mem, fea_num_);
+    {
+      std::lock_guard<std::mutex> flock(*mutex_for_fea_num_);
+      *total_fea_num_ += fea_num_;
+      fea_num_ = 0;
+    }
+    writer.Flush();
+    timeline.Pause();
+    VLOG(3) << "LoadIntoMemoryByColumnar() read all records, file=" << filename
+            << ", lines=" << lines << ", cost time=" << timeline.ElapsedSec()
+            << " seconds, thread_id=" << thread_id_;
+  }
+  VLOG(3) << "LoadIntoMemoryByColumnar() end, thread_id=" << thread_id_;
+#endif
+}
+
+bool MultiSlotInMemoryDataFeed::ParseOneColumnarInstance(
+    const ColumnarBlock& block, uint32_t idx, Record* instance) {
+  if (parse_logkey_) {
+    std::string log_key = block.ins_id(idx);
+    GetMsgFromLogKey(
+        log_key, &instance->search_id, &instance->cmatch, &instance->rank);
+    instance->ins_id_ = std::move(log_key);
+  } else if (parse_ins_id_) {
+    instance->ins_id_ = block.ins_id(idx);
+  }
+  for (size_t i = 0; i < use_slots_index_.size(); ++i) {
+    int use_idx = use_slots_index_[i];
+    if (use_idx == -1) {
+      continue;
+    }
+    bool dense = use_slots_is_dense_[use_idx];
+    uint32_t begin = block.offsets(i)[idx];
+    uint32_t end = block.offsets(i)[idx + 1];
+    if (all_slots_type_[i][0] == 'f') {  // float
+      const float* values = block.float_values(i);
+      for (uint32_t j = begin; j < end; ++j) {
+        // if float feasign is equal to zero, ignore it
+        // except when slot is dense
+        if (fabs(values[j]) < 1e-6 && !dense) {
+          continue;
+        }
+        FeatureFeasign f;
+        f.float_feasign_ = values[j];
+        instance->float_feasigns_.emplace_back(f, use_idx);
+      }
+    } else if (all_slots_type_[i][0] == 'u') {  // uint64
+      const uint64_t* values = block.uint64_values(i);
+      for (uint32_t j = begin; j < end; ++j) {
+        // if uint64 feasign is equal to zero, ignore it
+        // except when slot is dense
+        if (values[j] == 0 && !dense) {
+          continue;
+        }
+        FeatureFeasign f;
+        f.uint64_feasign_ = values[j];
+        instance->uint64_feasigns_.emplace_back(f, use_idx);
+      }
+    }
+  }
+  instance->float_feasigns_.shrink_to_fit();
+  instance->uint64_feasigns_.shrink_to_fit();
+  fea_num_ += instance->uint64_feasigns_.size();
+  return true;
 }
 
 void MultiSlotInMemoryDataFeed::GetMsgFromLogKey(const std::string& log_key,
@@ -2126,6 +2344,7 @@ void SlotRecordInMemoryDataFeed::Init(const DataFeedDesc& data_feed_desc) {
   } else {
     so_parser_name_.clear();
   }
+  columnar_input_ = data_feed_desc.data_format() == "columnar";
 #if defined(PADDLE_WITH_GPU_GRAPH) && defined(PADDLE_WITH_HETERPS)
   gpu_graph_data_generator_.SetConfig(data_feed_desc);
 #endif
@@ -2152,7 +2371,9 @@ void SlotRecordInMemoryDataFeed::InitGraphTrainResource() {
 
 void SlotRecordInMemoryDataFeed::LoadIntoMemory() {
   VLOG(3) << "SlotRecord LoadIntoMemory() begin, thread_id=" << thread_id_;
-  if (!so_parser_name_.empty()) {
+  if (columnar_input_) {
+    LoadIntoMemoryByColumnar();
+  } else if (!so_parser_name_.empty()) {
     LoadIntoMemoryByLib();
   } else {
     LoadIntoMemoryByCommand();
@@ -2401,6 +2622,69 @@ void SlotRecordInMemoryDataFeed::LoadIntoMemoryByCommand() {
 #endif
 }
 
+void SlotRecordInMemoryDataFeed::LoadIntoMemoryByColumnar() {
+#ifdef _LINUX
+  std::vector<std::string> slot_types;
+  for (auto& info : all_slots_info_) {
+    slot_types.push_back(info.type);
+  }
+  std::default_random_engine random_engine(std::random_device{}());
+  std::uniform_real_distribution<float> uniform_distribution(0.0f, 1.0f);
+  bool need_sample = std::abs(sample_rate_ - 1.0f) >= 1e-5f;
+
+  std::string filename;
+  ColumnarRecordReader reader;
+  ColumnarBlock block;
+  while (this->PickOneFile(&filename)) {
+    VLOG(3) << "PickOneFile, filename=" << filename
+            << ", thread_id=" << thread_id_;
+    int lines = 0;
+    std::vector<SlotRecord> record_vec;
+    platform::Timer timeline;
+    timeline.Start();
+    OpenColumnarFile(filename, slot_types, &reader);
+    SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
+    int offset = 0;
+
+    while (reader.NextBlock(&block)) {
+      for (uint32_t i = 0; i < block.record_num(); ++i) {
+        if (need_sample &&
+            uniform_distribution(random_engine) >= sample_rate_) {
+          continue;
+        }
+        if (!ParseOneColumnarInstance(block, i, &record_vec[offset])) {
+          continue;
+        }
+        ++lines;
+        if (++offset >= OBJPOOL_BLOCK_SIZE) {
+          input_channel_->Write(std::move(record_vec));
+          record_vec.clear();
+          SlotRecordPool().get(&record_vec, OBJPOOL_BLOCK_SIZE);
+          offset = 0;
+        }
+      }
+    }
+    reader.Close();
+    if (offset > 0) {
+      input_channel_->WriteMove(offset, &record_vec[0]);
+      if (offset < OBJPOOL_BLOCK_SIZE) {
+        SlotRecordPool().put(&record_vec[offset],
+                             (OBJPOOL_BLOCK_SIZE - offset));
+      }
+    } else {
+      SlotRecordPool().put(&record_vec);
+    }
+    record_vec.clear();
+    record_vec.shrink_to_fit();
+    timeline.Pause();
+    VLOG(3) << "LoadIntoMemoryByColumnar() read all records, file=" << filename
+            << ", lines=" << lines << ", cost time=" << timeline.ElapsedSec()
+            << " seconds, thread_id=" << thread_id_;
+  }
+  VLOG(3) << "LoadIntoMemoryByColumnar() end, thread_id=" << thread_id_;
+#endif
+}
+
 static void parser_log_key(const std::string& log_key,
                            uint64_t* search_id,
                            uint32_t* cmatch,
@@ -2511,6 +2795,62 @@ bool SlotRecordInMemoryDataFeed::ParseOneInstance(const std::string& line,
   return (uint64_total_slot_num > 0);
 }
 
+bool SlotRecordInMemoryDataFeed::ParseOneColumnarInstance(
+    const ColumnarBlock& block, uint32_t idx, SlotRecord* ins) {
+  SlotRecord& rec = (*ins);
+  if (parse_logkey_) {
+    std::string log_key = block.ins_id(idx);
+    parser_log_key(log_key, &rec->search_id, &rec->cmatch, &rec->rank);
+    rec->ins_id_ = std::move(log_key);
+  } else if (parse_ins_id_) {
+    rec->ins_id_ = block.ins_id(idx);
+  }
+
+  // Copy the values of the used slots straight into the record, the layout
+  // is the same as what add_slot_feasigns builds from the text path.
+  auto& uint64_feasigns = rec->slot_uint64_feasigns_;
+  auto& float_feasigns = rec->slot_float_feasigns_;
+  uint64_feasigns.slot_values.clear();
+  uint64_feasigns.slot_offsets.resize(uint64_use_slot_size_ + 1);
+  float_feasigns.slot_values.clear();
+  float_feasigns.slot_offsets.resize(float_use_slot_size_ + 1);
+  for (size_t i = 0; i < all_slots_info_.size(); ++i) {
+    const AllSlotInfo& info = all_slots_info_[i];
+    if (info.used_idx == -1) {
+      continue;
+    }
+    uint32_t begin = block.offsets(i)[idx];
+    uint32_t end = block.offsets(i)[idx + 1];
+    if (info.type[0] == 'f') {  // float
+      auto& values = float_feasigns.slot_values;
+      float_feasigns.slot_offsets[info.slot_value_idx] =
+          static_cast<uint32_t>(values.size());
+      const float* slot_values = block.float_values(i);
+      if (used_slots_info_[info.used_idx].dense) {
+        values.insert(values.end(), slot_values + begin, slot_values + end);
+      } else {
+        for (uint32_t j = begin; j < end; ++j) {
+          if (fabs(slot_values[j]) >= 1e-6) {
+            values.push_back(slot_values[j]);
+          }
+        }
+      }
+    } else if (info.type[0] == 'u') {  // uint64
+      auto& values = uint64_feasigns.slot_values;
+      uint64_feasigns.slot_offsets[info.slot_value_idx] =
+          static_cast<uint32_t>(values.size());
+      const uint64_t* slot_values = block.uint64_values(i);
+      values.insert(values.end(), slot_values + begin, slot_values + end);
+    }
+  }
+  uint64_feasigns.slot_offsets[uint64_use_slot_size_] =
+      static_cast<uint32_t>(uint64_feasigns.slot_values.size());
+  float_feasigns.slot_offsets[float_use_slot_size_] =
+      static_cast<uint32_t>(float_feasigns.slot_values.size());
+
+  return !uint64_feasigns.slot_values.empty();
+}
+
 void SlotRecordInMemoryDataFeed::AssignFeedVar(const Scope& scope) {
   CheckInit();
 #if defined(PADDLE_WITH_CUDA) && defined(PADDLE_WITH_HETERPS)
@@ -2780,6 +3120,11 @@ int SlotRecordInMemoryDataFeed::Next() {
     this->batch_size_ = batch.second;
     VLOG(3) << "batch_size_=" << this->batch_size_
             << ", thread_id=" << thread_id_;
+    // the records are in memory, so the next batch is not read ahead
+    if (offset_index_ < batch_offsets_.size()) {
+      auto& next_batch = batch_offsets_[offset_index_];
+      RunNextBatchKeysCallback(&records_[next_batch.first], next_batch.second);
+    }
     if (this->batch_size_ != 0) {
       PutToFeedVec(&records_[batch.first], this->batch_size_);
     } else {
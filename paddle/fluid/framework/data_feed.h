@@ -20,6 +20,7 @@ limitations under the License. */
 #endif
 
 #include <fstream>
+#include <functional>
 #include <future>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
@@ -35,6 +36,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/archive.h"
 #include "paddle/fluid/framework/blocking_queue.h"
 #include "paddle/fluid/framework/channel.h"
+#include "paddle/fluid/framework/data_feed_columnar.h"
 #include "paddle/fluid/framework/data_feed.pb.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/framework/lod_tensor.h"
@@ -52,6 +54,8 @@ limitations under the License. */
 
 COMMON_DECLARE_int32(record_pool_max_size);
 COMMON_DECLARE_int32(slotpool_thread_num);
+COMMON_DECLARE_int32(slotpool_lock_free_channel_capacity);
+COMMON_DECLARE_bool(enable_lock_free_data_feed_queue);
 COMMON_DECLARE_bool(enable_slotpool_wait_release);
 COMMON_DECLARE_bool(enable_slotrecord_reset_shrink);
 
@@ -266,7 +270,12 @@ class SlotObjPool {
  public:
   SlotObjPool()
       : max_capacity_(FLAGS_record_pool_max_size), alloc_(free_slotrecord) {
-    ins_chan_ = MakeChannel<SlotRecord>();
+    if (FLAGS_slotpool_lock_free_channel_capacity > 0) {
+      ins_chan_ = MakeLockFreeChannel<SlotRecord>(
+          FLAGS_slotpool_lock_free_channel_capacity);
+    } else {
+      ins_chan_ = MakeChannel<SlotRecord>();
+    }
     ins_chan_->SetBlockSize(OBJPOOL_BLOCK_SIZE);
     for (int i = 0; i < FLAGS_slotpool_thread_num; ++i) {
       threads_.push_back(std::thread([this]() { run(); }));
@@ -314,7 +323,16 @@ class SlotObjPool {
     input->clear();
   }
   void put(SlotRecord* input, size_t size) {
-    CHECK(ins_chan_->WriteMove(size, input) == size);
+    // The release path must not block on a bounded channel, the records
+    // that do not fit are freed here instead of being pooled.
+    size_t finished = ins_chan_->TryWriteMove(size, input);
+    if (finished == size) {
+      return;
+    }
+    count_ -= size - finished;
+    for (size_t i = finished; i < size; ++i) {
+      free_slotrecord(input[i]);
+    }
   }
   void run(void) {
     std::vector<SlotRecord> input;
@@ -1197,6 +1215,11 @@ class DataFeed {
   virtual void SetParseLogKey(bool parse_logkey UNUSED) {}
   virtual void SetEnablePvMerge(bool enable_pv_merge UNUSED) {}
   virtual void SetCurrentPhase(int current_phase UNUSED) {}
+  // If set, the data feed reads one batch ahead and calls the callback with
+  // the uint64 feasigns of that batch, so that their values can be
+  // prefetched while the current batch is trained.
+  virtual void SetNextBatchKeysCallback(
+      std::function<void(const std::vector<uint64_t>&)> callback UNUSED) {}
 #if defined(PADDLE_WITH_GPU_GRAPH) && defined(PADDLE_WITH_HETERPS)
   virtual void InitGraphResource() {}
   virtual void InitGraphTrainResource() {}
@@ -1405,6 +1428,8 @@ class DataFeed {
 
   // The input type of pipe reader, 0 for one sample, 1 for one batch
   int input_type_;
+  // Whether the files are in the binary columnar format instead of text
+  bool columnar_input_ = false;
   int gpu_graph_mode_ = 0;
 #if defined(PADDLE_WITH_GPU_GRAPH) && defined(PADDLE_WITH_HETERPS)
   GraphDataGenerator gpu_graph_data_generator_;
@@ -1477,6 +1502,8 @@ class InMemoryDataFeed : public DataFeed {
   virtual void SetParseLogKey(bool parse_logkey);
   virtual void SetEnablePvMerge(bool enable_pv_merge);
   virtual void SetCurrentPhase(int current_phase);
+  virtual void SetNextBatchKeysCallback(
+      std::function<void(const std::vector<uint64_t>&)> callback);
   virtual void LoadIntoMemory();
   virtual void LoadIntoMemoryFromSo();
   virtual void SetRecord(T* records) { records_ = records; }
@@ -1499,6 +1526,19 @@ class InMemoryDataFeed : public DataFeed {
   }
   virtual void PutToFeedVec(const std::vector<T>& ins_vec) = 0;
   virtual void PutToFeedVec(const T* ins_vec, int num) = 0;
+  // Read up to default_batch_size_ instances from output_channel_.
+  void ReadBatch(std::vector<T>* ins_vec);
+  // Hand the uint64 feasigns of the next batch to next_batch_keys_callback_
+  // if it is set and there are any.
+  void RunNextBatchKeysCallback(const T* ins_vec, int num);
+
+  // Open a file of the columnar format. Local files are mapped if there is no
+  // pipe command other than cat, the others are read through the pipe
+  // command. slot_types are the types of all_slots_, which should match the
+  // slots of the file.
+  void OpenColumnarFile(const std::string& filename,
+                        const std::vector<std::string>& slot_types,
+                        ColumnarRecordReader* reader);
 
   std::vector<std::vector<float>> batch_float_feasigns_;
   std::vector<std::vector<uint64_t>> batch_uint64_feasigns_;
@@ -1527,6 +1567,11 @@ class InMemoryDataFeed : public DataFeed {
   uint64_t offset_index_ = 0;
   bool enable_heterps_ = false;
   T* records_ = nullptr;
+
+  std::function<void(const std::vector<uint64_t>&)> next_batch_keys_callback_;
+  // the batch read ahead when next_batch_keys_callback_ is set
+  std::vector<T> next_ins_vec_;
+  bool next_ins_vec_ready_ = false;
 };
 
 // This class define the data type of instance(ins_vec) in MultiSlotDataFeed
@@ -1870,9 +1915,14 @@ class MultiSlotInMemoryDataFeed : public InMemoryDataFeed<Record> {
   MultiSlotInMemoryDataFeed() {}
   virtual ~MultiSlotInMemoryDataFeed() {}
   virtual void Init(const DataFeedDesc& data_feed_desc);
+  virtual void LoadIntoMemory();
   // void SetRecord(Record* records) { records_ = records; }
 
  protected:
+  virtual void LoadIntoMemoryByColumnar();
+  bool ParseOneColumnarInstance(const ColumnarBlock& block,
+                                uint32_t idx,
+                                Record* instance);
   virtual bool ParseOneInstance(Record* instance);
   virtual bool ParseOneInstanceFromPipe(Record* instance);
   virtual void ParseOneInstanceFromSo(const char* str UNUSED,
@@ -1913,10 +1963,14 @@ class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
   virtual void LoadIntoMemoryByLib(void);
   virtual void LoadIntoMemoryByLine(void);
   virtual void LoadIntoMemoryByFile(void);
+  virtual void LoadIntoMemoryByColumnar(void);
   void SetInputChannel(void* channel) override {
     input_channel_ = static_cast<ChannelObject<SlotRecord>*>(channel);
   }
   bool ParseOneInstance(const std::string& line, SlotRecord* rec);
+  bool ParseOneColumnarInstance(const ColumnarBlock& block,
+                                uint32_t idx,
+                                SlotRecord* rec);
   void PutToFeedVec(const SlotRecord* ins_vec, int num) override;
   void AssignFeedVar(const Scope& scope) override;
   std::vector<std::string> GetInputVarNames() override {
@@ -0,0 +1,521 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/data_feed_columnar.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+inline size_t PadTo8(size_t size) {
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+template <typename T>
+void AppendPod(std::vector<char>* buf, const T* data, size_t num) {
+  size_t bytes = num * sizeof(T);
+  size_t pos = buf->size();
+  buf->resize(PadTo8(pos + bytes));
+  if (bytes > 0) {
+    std::memcpy(buf->data() + pos, data, bytes);
+  }
+}
+
+size_t SlotValueSize(const ColumnarSlot& slot) {
+  return slot.type == 'f' ? sizeof(float) : sizeof(uint64_t);
+}
+
+void WriteOrDie(FILE* fp, const void* data, size_t size) {
+  PADDLE_ENFORCE_EQ(
+      fwrite(data, 1, size, fp),
+      size,
+      platform::errors::Unavailable("Failed to write %d bytes of columnar "
+                                    "records.",
+                                    size));
+}
+
+}  // namespace
+
+ColumnarRecordWriter::ColumnarRecordWriter(
+    FILE* fp,
+    const std::vector<ColumnarSlot>& slots,
+    bool has_ins_id,
+    bool compress,
+    uint32_t block_records)
+    : fp_(fp),
+      slots_(slots),
+      has_ins_id_(has_ins_id),
+      compress_(compress),
+      block_records_(std::max(block_records, 1U)),
+      slot_offsets_(slots.size()),
+      slot_values_(slots.size()) {
+  PADDLE_ENFORCE_NOT_NULL(fp_,
+                          platform::errors::InvalidArgument(
+                              "The output file of ColumnarRecordWriter is "
+                              "NULL."));
+  std::vector<char> header;
+  ColumnarFileHeader file_header;
+  file_header.magic = kColumnarFileMagic;
+  file_header.version = kColumnarVersion;
+  file_header.slot_num = static_cast<uint32_t>(slots_.size());
+  file_header.flags = has_ins_id_ ? kColumnarHasInsId : 0;
+  AppendPod(&header, &file_header, 1);
+  for (auto& slot : slots_) {
+    PADDLE_ENFORCE_EQ(
+        slot.type == 'u' || slot.type == 'f',
+        true,
+        platform::errors::InvalidArgument(
+            "Slot %s has type %c, only u(int64) and f(loat) are supported.",
+            slot.name,
+            slot.type));
+    // type, reserved, name length, name
+    char meta[4] = {slot.type, 0, 0, 0};
+    uint16_t name_len = static_cast<uint16_t>(slot.name.size());
+    std::memcpy(meta + 2, &name_len, sizeof(name_len));
+    size_t pos = header.size();
+    header.resize(pos + sizeof(meta) + name_len);
+    std::memcpy(header.data() + pos, meta, sizeof(meta));
+    std::memcpy(header.data() + pos + sizeof(meta), slot.name.data(), name_len);
+  }
+  header.resize(PadTo8(header.size()));
+  WriteOrDie(fp_, header.data(), header.size());
+
+  ins_id_offsets_.push_back(0);
+  for (auto& offsets : slot_offsets_) {
+    offsets.push_back(0);
+  }
+}
+
+ColumnarRecordWriter::~ColumnarRecordWriter() {
+  if (pending_num_ > 0) {
+    LOG(WARNING) << "ColumnarRecordWriter is destructed with " << pending_num_
+                 << " records not flushed, write them now.";
+    WriteBlock();
+  }
+}
+
+void ColumnarRecordWriter::Append(
+    const std::string& ins_id,
+    const std::vector<std::vector<uint64_t>>& uint64_feasigns,
+    const std::vector<std::vector<float>>& float_feasigns) {
+  if (has_ins_id_) {
+    ins_id_bytes_.append(ins_id);
+    ins_id_offsets_.push_back(static_cast<uint32_t>(ins_id_bytes_.size()));
+  }
+  size_t uint64_idx = 0;
+  size_t float_idx = 0;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    auto& values = slot_values_[i];
+    size_t pos = values.size();
+    if (slots_[i].type == 'u') {
+      PADDLE_ENFORCE_LT(uint64_idx,
+                        uint64_feasigns.size(),
+                        platform::errors::InvalidArgument(
+                            "Too few uint64 slots in the record."));
+      auto& fea = uint64_feasigns[uint64_idx++];
+      values.resize(pos + fea.size() * sizeof(uint64_t));
+      if (!fea.empty()) {
+        std::memcpy(
+            values.data() + pos, fea.data(), fea.size() * sizeof(uint64_t));
+      }
+    } else {
+      PADDLE_ENFORCE_LT(float_idx,
+                        float_feasigns.size(),
+                        platform::errors::InvalidArgument(
+                            "Too few float slots in the record."));
+      auto& fea = float_feasigns[float_idx++];
+      values.resize(pos + fea.size() * sizeof(float));
+      if (!fea.empty()) {
+        std::memcpy(
+            values.data() + pos, fea.data(), fea.size() * sizeof(float));
+      }
+    }
+    slot_offsets_[i].push_back(
+        static_cast<uint32_t>(values.size() / SlotValueSize(slots_[i])));
+  }
+  ++pending_num_;
+  ++record_num_;
+  if (pending_num_ >= block_records_) {
+    WriteBlock();
+  }
+}
+
+void ColumnarRecordWriter::Flush() {
+  if (pending_num_ > 0) {
+    WriteBlock();
+  }
+  fflush(fp_);
+}
+
+void ColumnarRecordWriter::WriteBlock() {
+  payload_.clear();
+  if (has_ins_id_) {
+    AppendPod(&payload_, ins_id_offsets_.data(), ins_id_offsets_.size());
+    AppendPod(&payload_, ins_id_bytes_.data(), ins_id_bytes_.size());
+  }
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    AppendPod(&payload_, slot_offsets_[i].data(), slot_offsets_[i].size());
+    AppendPod(&payload_, slot_values_[i].data(), slot_values_[i].size());
+  }
+
+  ColumnarBlockHeader block_header;
+  block_header.magic = kColumnarBlockMagic;
+  block_header.record_num = pending_num_;
+  block_header.compression = kColumnarNoCompression;
+  block_header.reserved = 0;
+  block_header.raw_size = payload_.size();
+  const char* stored = payload_.data();
+  size_t stored_size = payload_.size();
+  if (compress_) {
+    uLongf compressed_size = compressBound(payload_.size());
+    compressed_.resize(PadTo8(compressed_size));
+    int ret = compress2(reinterpret_cast<Bytef*>(compressed_.data()),
+                        &compressed_size,
+                        reinterpret_cast<const Bytef*>(payload_.data()),
+                        payload_.size(),
+                        Z_BEST_SPEED);
+    PADDLE_ENFORCE_EQ(ret,
+                      Z_OK,
+                      platform::errors::External(
+                          "Failed to compress columnar block, zlib error %d.",
+                          ret));
+    // keep the raw payload if compression does not pay off
+    if (compressed_size < payload_.size()) {
+      block_header.compression = kColumnarZlibCompression;
+      stored = compressed_.data();
+      stored_size = PadTo8(compressed_size);
+      std::memset(compressed_.data() + compressed_size,
+                  0,
+                  stored_size - compressed_size);
+    }
+  }
+  block_header.stored_size = stored_size;
+  WriteOrDie(fp_, &block_header, sizeof(block_header));
+  WriteOrDie(fp_, stored, stored_size);
+
+  pending_num_ = 0;
+  ins_id_offsets_.resize(1);
+  ins_id_bytes_.clear();
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    slot_offsets_[i].resize(1);
+    slot_values_[i].clear();
+  }
+}
+
+ColumnarRecordReader::~ColumnarRecordReader() { Close(); }
+
+void ColumnarRecordReader::OpenFile(const std::string& path) {
+  Close();
+  name_ = path;
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(
+      fd,
+      0,
+      platform::errors::NotFound("Failed to open columnar file %s.", path));
+  struct stat st;
+  PADDLE_ENFORCE_EQ(
+      fstat(fd, &st),
+      0,
+      platform::errors::Unavailable("Failed to stat columnar file %s.", path));
+  if (st.st_size > 0) {
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    PADDLE_ENFORCE_NE(
+        data,
+        MAP_FAILED,
+        platform::errors::Unavailable("Failed to mmap columnar file %s.",
+                                      path));
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    mmap_data_ = reinterpret_cast<const char*>(data);
+    mmap_size_ = st.st_size;
+  }
+  close(fd);
+  mmap_pos_ = 0;
+  ReadHeader();
+#else
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Mapping columnar file is not supported on Windows."));
+#endif
+}
+
+void ColumnarRecordReader::OpenStream(FILE* fp, const std::string& name) {
+  Close();
+  PADDLE_ENFORCE_NOT_NULL(
+      fp,
+      platform::errors::InvalidArgument("The stream of %s is NULL.", name));
+  name_ = name;
+  fp_ = fp;
+  ReadHeader();
+}
+
+void ColumnarRecordReader::Close() {
+#ifndef _WIN32
+  if (mmap_data_ != nullptr) {
+    munmap(const_cast<char*>(mmap_data_), mmap_size_);
+  }
+#endif
+  mmap_data_ = nullptr;
+  mmap_size_ = 0;
+  mmap_pos_ = 0;
+  fp_ = nullptr;
+  slots_.clear();
+  has_ins_id_ = false;
+}
+
+const char* ColumnarRecordReader::Read(size_t size, bool allow_eof) {
+  if (mmap_data_ != nullptr || fp_ == nullptr) {
+    if (mmap_pos_ == mmap_size_ && allow_eof) {
+      return nullptr;
+    }
+    PADDLE_ENFORCE_LE(mmap_pos_ + size,
+                      mmap_size_,
+                      platform::errors::InvalidArgument(
+                          "Columnar file %s is truncated.", name_));
+    const char* data = mmap_data_ + mmap_pos_;
+    mmap_pos_ += size;
+    return data;
+  }
+  read_buffer_.resize(std::max(read_buffer_.size(), size));
+  size_t read_size = fread(read_buffer_.data(), 1, size, fp_);
+  if (read_size == 0 && allow_eof) {
+    return nullptr;
+  }
+  PADDLE_ENFORCE_EQ(read_size,
+                    size,
+                    platform::errors::InvalidArgument(
+                        "Columnar file %s is truncated.", name_));
+  return read_buffer_.data();
+}
+
+void ColumnarRecordReader::ReadHeader() {
+  const char* data = Read(sizeof(ColumnarFileHeader), false);
+  ColumnarFileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  PADDLE_ENFORCE_EQ(header.magic,
+                    kColumnarFileMagic,
+                    platform::errors::InvalidArgument(
+                        "%s is not a columnar record file.", name_));
+  PADDLE_ENFORCE_EQ(header.version,
+                    kColumnarVersion,
+                    platform::errors::InvalidArgument(
+                        "Unsupported columnar version %d of %s.",
+                        header.version,
+                        name_));
+  has_ins_id_ = (header.flags & kColumnarHasInsId) != 0;
+  size_t header_size = sizeof(ColumnarFileHeader);
+  slots_.resize(header.slot_num);
+  for (auto& slot : slots_) {
+    char meta[4];
+    std::memcpy(meta, Read(sizeof(meta), false), sizeof(meta));
+    uint16_t name_len = 0;
+    std::memcpy(&name_len, meta + 2, sizeof(name_len));
+    slot.type = meta[0];
+    slot.name.assign(Read(name_len, false), name_len);
+    header_size += sizeof(meta) + name_len;
+  }
+  size_t padding = PadTo8(header_size) - header_size;
+  if (padding > 0) {
+    Read(padding, false);
+  }
+}
+
+bool ColumnarRecordReader::NextBlock(ColumnarBlock* block) {
+  const char* data = Read(sizeof(ColumnarBlockHeader), true);
+  if (data == nullptr) {
+    return false;
+  }
+  ColumnarBlockHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  PADDLE_ENFORCE_EQ(header.magic,
+                    kColumnarBlockMagic,
+                    platform::errors::InvalidArgument(
+                        "Corrupted block in columnar file %s.", name_));
+  const char* stored = Read(header.stored_size, false);
+  const char* payload = stored;
+  if (header.compression == kColumnarZlibCompression) {
+    raw_buffer_.resize(header.raw_size);
+    uLongf raw_size = header.raw_size;
+    int ret = uncompress(reinterpret_cast<Bytef*>(raw_buffer_.data()),
+                         &raw_size,
+                         reinterpret_cast<const Bytef*>(stored),
+                         header.stored_size);
+    PADDLE_ENFORCE_EQ(ret == Z_OK && raw_size == header.raw_size,
+                      true,
+                      platform::errors::InvalidArgument(
+                          "Failed to uncompress block of columnar file %s, "
+                          "zlib error %d.",
+                          name_,
+                          ret));
+    payload = raw_buffer_.data();
+  } else {
+    PADDLE_ENFORCE_EQ(header.compression,
+                      kColumnarNoCompression,
+                      platform::errors::InvalidArgument(
+                          "Unknown compression %d in columnar file %s.",
+                          header.compression,
+                          name_));
+  }
+  DecodePayload(payload, header.raw_size, header.record_num, block);
+  return true;
+}
+
+void ColumnarRecordReader::DecodePayload(const char* payload,
+                                         size_t size,
+                                         uint32_t record_num,
+                                         ColumnarBlock* block) const {
+  size_t pos = 0;
+  size_t offsets_bytes = PadTo8((record_num + 1) * sizeof(uint32_t));
+  auto check = [&](size_t bytes) {
+    PADDLE_ENFORCE_LE(pos + bytes,
+                      size,
+                      platform::errors::InvalidArgument(
+                          "Corrupted block in columnar file %s.", name_));
+  };
+
+  block->record_num_ = record_num;
+  block->ins_id_offsets_ = nullptr;
+  block->ins_id_bytes_ = nullptr;
+  if (has_ins_id_) {
+    check(offsets_bytes);
+    block->ins_id_offsets_ = reinterpret_cast<const uint32_t*>(payload + pos);
+    pos += offsets_bytes;
+    size_t bytes = PadTo8(block->ins_id_offsets_[record_num]);
+    check(bytes);
+    block->ins_id_bytes_ = payload + pos;
+    pos += bytes;
+  }
+  block->slot_offsets_.resize(slots_.size());
+  block->slot_values_.resize(slots_.size());
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    check(offsets_bytes);
+    const uint32_t* offsets = reinterpret_cast<const uint32_t*>(payload + pos);
+    pos += offsets_bytes;
+    size_t bytes = PadTo8(offsets[record_num] * SlotValueSize(slots_[i]));
+    check(bytes);
+    block->slot_offsets_[i] = offsets;
+    block->slot_values_[i] = payload + pos;
+    pos += bytes;
+  }
+}
+
+int64_t ConvertSlotTextToColumnar(const std::string& text_path,
+                                  const std::string& columnar_path,
+                                  const std::vector<ColumnarSlot>& slots,
+                                  bool has_ins_id,
+                                  bool compress) {
+  std::ifstream fin(text_path);
+  PADDLE_ENFORCE_EQ(
+      fin.good(),
+      true,
+      platform::errors::NotFound("Cannot open text file %s.", text_path));
+  std::unique_ptr<FILE, int (*)(FILE*)> fout(
+      fopen(columnar_path.c_str(), "wb"), &fclose);
+  PADDLE_ENFORCE_NOT_NULL(fout.get(),
+                          platform::errors::Unavailable(
+                              "Cannot open columnar file %s.", columnar_path));
+
+  ColumnarRecordWriter writer(fout.get(), slots, has_ins_id, compress);
+  std::vector<std::vector<uint64_t>> uint64_feasigns;
+  std::vector<std::vector<float>> float_feasigns;
+  for (auto& slot : slots) {
+    if (slot.type == 'u') {
+      uint64_feasigns.emplace_back();
+    } else {
+      float_feasigns.emplace_back();
+    }
+  }
+
+  std::string line;
+  std::string ins_id;
+  int64_t line_no = 0;
+  while (std::getline(fin, line)) {
+    ++line_no;
+    if (line.empty()) {
+      continue;
+    }
+    const char* str = line.c_str();
+    char* endptr = const_cast<char*>(str);
+    if (has_ins_id) {
+      int num = static_cast<int>(strtol(str, &endptr, 10));
+      PADDLE_ENFORCE_EQ(num,
+                        1,
+                        platform::errors::InvalidArgument(
+                            "Line %d of %s does not start with an ins id.",
+                            line_no,
+                            text_path));
+      while (*endptr == ' ') {
+        ++endptr;
+      }
+      const char* begin = endptr;
+      while (*endptr != ' ' && *endptr != '\0') {
+        ++endptr;
+      }
+      ins_id.assign(begin, endptr - begin);
+    }
+    size_t uint64_idx = 0;
+    size_t float_idx = 0;
+    for (auto& slot : slots) {
+      char* numptr = endptr;
+      int num = static_cast<int>(strtol(numptr, &endptr, 10));
+      PADDLE_ENFORCE_EQ(
+          num > 0 && endptr != numptr,
+          true,
+          platform::errors::InvalidArgument(
+              "Bad feasign number of slot %s at line %d of %s.",
+              slot.name,
+              line_no,
+              text_path));
+      if (slot.type == 'u') {
+        auto& fea = uint64_feasigns[uint64_idx++];
+        fea.clear();
+        for (int j = 0; j < num; ++j) {
+          fea.push_back(static_cast<uint64_t>(strtoull(endptr, &endptr, 10)));
+        }
+      } else {
+        auto& fea = float_feasigns[float_idx++];
+        fea.clear();
+        for (int j = 0; j < num; ++j) {
+          fea.push_back(strtof(endptr, &endptr));
+        }
+      }
+    }
+    writer.Append(ins_id, uint64_feasigns, float_feasigns);
+  }
+  writer.Flush();
+  VLOG(1) << "Convert " << writer.record_num() << " records from " << text_path
+          << " to " << columnar_path;
+  return static_cast<int64_t>(writer.record_num());
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,207 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// A binary columnar layout of slot records, so that InMemoryDataFeed can load
+// instances without tokenizing text lines.
+//
+// file   := FileHeader slot_table block*
+// block  := BlockHeader payload (zlib compressed if compression is set)
+// payload:= [ins_id_offsets ins_id_bytes] (slot_offsets slot_values)*
+//
+// ins_id_offsets and slot_offsets are uint32 prefix sums with record_num + 1
+// entries, slot_values are packed uint64 feasigns or floats according to the
+// slot type. Every section and every block is padded to 8 bytes, so that the
+// values of an uncompressed block can be read in place from a mmaped file.
+constexpr uint32_t kColumnarFileMagic = 0x52434450;   // "PDCR"
+constexpr uint32_t kColumnarBlockMagic = 0x4B4C4250;  // "PBLK"
+constexpr uint32_t kColumnarVersion = 1;
+constexpr uint32_t kColumnarHasInsId = 1;
+constexpr uint32_t kColumnarNoCompression = 0;
+constexpr uint32_t kColumnarZlibCompression = 1;
+
+struct ColumnarFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slot_num;
+  uint32_t flags;
+};
+
+struct ColumnarBlockHeader {
+  uint32_t magic;
+  uint32_t record_num;
+  uint32_t compression;
+  uint32_t reserved;
+  uint64_t raw_size;
+  uint64_t stored_size;
+};
+
+struct ColumnarSlot {
+  std::string name;
+  // 'u' for uint64 feasigns, 'f' for float values
+  char type;
+};
+
+// A decoded block, the pointers refer to either the mmaped file or the buffer
+// of ColumnarRecordReader, and are valid until the next call of NextBlock.
+class ColumnarBlock {
+ public:
+  uint32_t record_num() const { return record_num_; }
+
+  bool has_ins_id() const { return ins_id_offsets_ != nullptr; }
+
+  std::string ins_id(uint32_t record) const {
+    return std::string(ins_id_bytes_ + ins_id_offsets_[record],
+                       ins_id_offsets_[record + 1] - ins_id_offsets_[record]);
+  }
+
+  // offsets(slot)[record] .. offsets(slot)[record + 1] are the values of the
+  // record in the slot.
+  const uint32_t* offsets(size_t slot) const { return slot_offsets_[slot]; }
+
+  const uint64_t* uint64_values(size_t slot) const {
+    return reinterpret_cast<const uint64_t*>(slot_values_[slot]);
+  }
+
+  const float* float_values(size_t slot) const {
+    return reinterpret_cast<const float*>(slot_values_[slot]);
+  }
+
+ private:
+  friend class ColumnarRecordReader;
+
+  uint32_t record_num_{0};
+  const uint32_t* ins_id_offsets_{nullptr};
+  const char* ins_id_bytes_{nullptr};
+  std::vector<const uint32_t*> slot_offsets_;
+  std::vector<const char*> slot_values_;
+};
+
+class ColumnarRecordWriter {
+ public:
+  static constexpr uint32_t kDefaultBlockRecords = 8192;
+
+  // The writer does not own fp.
+  ColumnarRecordWriter(FILE* fp,
+                       const std::vector<ColumnarSlot>& slots,
+                       bool has_ins_id,
+                       bool compress,
+                       uint32_t block_records = kDefaultBlockRecords);
+
+  ~ColumnarRecordWriter();
+
+  ColumnarRecordWriter(const ColumnarRecordWriter&) = delete;
+
+  ColumnarRecordWriter& operator=(const ColumnarRecordWriter&) = delete;
+
+  // uint64_feasigns and float_feasigns hold the values of the uint64 slots and
+  // the float slots in the order of slots respectively.
+  void Append(const std::string& ins_id,
+              const std::vector<std::vector<uint64_t>>& uint64_feasigns,
+              const std::vector<std::vector<float>>& float_feasigns);
+
+  // Write the pending records and flush fp.
+  void Flush();
+
+  uint64_t record_num() const { return record_num_; }
+
+ private:
+  void WriteBlock();
+
+  FILE* fp_;
+  std::vector<ColumnarSlot> slots_;
+  bool has_ins_id_;
+  bool compress_;
+  uint32_t block_records_;
+  uint64_t record_num_{0};
+
+  // pending records of the current block
+  uint32_t pending_num_{0};
+  std::vector<uint32_t> ins_id_offsets_;
+  std::string ins_id_bytes_;
+  std::vector<std::vector<uint32_t>> slot_offsets_;
+  std::vector<std::vector<char>> slot_values_;
+  std::vector<char> payload_;
+  std::vector<char> compressed_;
+};
+
+class ColumnarRecordReader {
+ public:
+  ColumnarRecordReader() = default;
+
+  ~ColumnarRecordReader();
+
+  ColumnarRecordReader(const ColumnarRecordReader&) = delete;
+
+  ColumnarRecordReader& operator=(const ColumnarRecordReader&) = delete;
+
+  // Map a local file read-only, uncompressed blocks are not copied.
+  void OpenFile(const std::string& path);
+
+  // Read from a stream, e.g. the output of a pipe command, in large chunks.
+  // The reader does not own fp.
+  void OpenStream(FILE* fp, const std::string& name);
+
+  void Close();
+
+  const std::vector<ColumnarSlot>& slots() const { return slots_; }
+
+  bool has_ins_id() const { return has_ins_id_; }
+
+  // Returns false at the end of file.
+  bool NextBlock(ColumnarBlock* block);
+
+ private:
+  void ReadHeader();
+
+  // Returns a pointer to the next size bytes, nullptr at the end of file.
+  const char* Read(size_t size, bool allow_eof);
+
+  void DecodePayload(const char* payload,
+                     size_t size,
+                     uint32_t record_num,
+                     ColumnarBlock* block) const;
+
+  std::string name_;
+  const char* mmap_data_{nullptr};
+  size_t mmap_size_{0};
+  size_t mmap_pos_{0};
+  FILE* fp_{nullptr};
+  std::vector<char> read_buffer_;
+  std::vector<char> raw_buffer_;
+
+  std::vector<ColumnarSlot> slots_;
+  bool has_ins_id_{false};
+};
+
+// Convert a text file of the slot format used by the MultiSlot data feeds
+// ("[1 ins_id] num v1 ... vn num v1 ... vn ...", one slot after another in
+// the order of slots) into the columnar format. Returns the number of records.
+int64_t ConvertSlotTextToColumnar(const std::string& text_path,
+                                  const std::string& columnar_path,
+                                  const std::vector<ColumnarSlot>& slots,
+                                  bool has_ins_id,
+                                  bool compress);
+
+}  // namespace framework
+}  // namespace paddle
@@ -433,6 +433,8 @@ class DownpourLiteWorker : public HogwildWorker {
   void CopySparseTable();
   void CopyDenseTable();
   void CopyDenseVars();
+  // Checks the prefetch requests that are done, or waits for all of them.
+  void CheckPrefetchSparseStatus(bool wait_all);
 
   DownpourWorkerParameter param_;
   // copy table
@@ -449,6 +451,9 @@ class DownpourLiteWorker : public HogwildWorker {
   std::map<uint64_t, std::vector<std::string>> sparse_value_names_;
   // adjust ins weight
   AdjustInsWeightConfig adjust_ins_weight_config_;
+  // the prefetch requests of the next batches, see
+  // FLAGS_ps_prefetch_sparse_table_id
+  std::vector<::std::future<int32_t>> prefetch_sparse_status_;
   // check nan and inf during training
   std::vector<std::string> check_nan_var_names_;
   bool need_to_push_sparse_;
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #if defined(PADDLE_WITH_PSCORE)
+#include "paddle/common/flags.h"
 #include "paddle/fluid/framework/device_worker.h"
 #include "paddle/fluid/framework/fleet/metrics.h"
 #include "paddle/fluid/operators/isfinite_op.h"
@@ -28,6 +29,14 @@ class Variable;
 }  // namespace framework
 }  // namespace paddle
 
+PHI_DEFINE_EXPORTED_int64(
+    ps_prefetch_sparse_table_id,
+    -1,
+    "If >= 0, the uint64 feasigns of the next batch are sent to this sparse "
+    "table to be prefetched while the current batch is trained. It only "
+    "helps tables that support prefetch, such as SSDSparseTable. Default -1, "
+    "no prefetch.");
+
 #if defined _WIN32 || defined __APPLE__
 #else
 #define _LINUX
@@ -442,6 +451,15 @@ inline void AddAucMonitor(const Scope* scope, const platform::Place& place) {
 void DownpourLiteWorker::TrainFiles() {
   VLOG(3) << "Begin to train files";
   platform::SetNumThreads(1);
+  if (FLAGS_ps_prefetch_sparse_table_id >= 0) {
+    uint64_t table_id =
+        static_cast<uint64_t>(FLAGS_ps_prefetch_sparse_table_id);
+    // the data feed calls it from Next() on this thread
+    device_reader_->SetNextBatchKeysCallback(
+        [this, table_id](const std::vector<uint64_t>& keys) {
+          fleet_ptr_->PrefetchSparse(table_id, keys, &prefetch_sparse_status_);
+        });
+  }
   device_reader_->Start();
   int batch_cnt = 0;
   int cur_batch;
@@ -572,8 +590,10 @@ void DownpourLiteWorker::TrainFiles() {
 
     PrintFetchVars();
     thread_scope_->DropKids();
+    CheckPrefetchSparseStatus(false);
     ++batch_cnt;
   }
+  CheckPrefetchSparseStatus(true);
   if (need_dump_field_ || need_dump_param_) {
     writer_.Flush();
   }
@@ -584,6 +604,22 @@ void DownpourLiteWorker::TrainFiles() {
   }
 }
 
+void DownpourLiteWorker::CheckPrefetchSparseStatus(bool wait_all) {
+  auto iter = prefetch_sparse_status_.begin();
+  while (iter != prefetch_sparse_status_.end()) {
+    if (!wait_all && iter->wait_for(std::chrono::seconds(0)) !=
+                         std::future_status::ready) {
+      ++iter;
+      continue;
+    }
+    if (iter->get() != 0) {
+      LOG(WARNING) << "prefetch sparse table "
+                   << FLAGS_ps_prefetch_sparse_table_id << " failed";
+    }
+    iter = prefetch_sparse_status_.erase(iter);
+  }
+}
+
 }  // end namespace framework
 }  // end namespace paddle
 #endif
@@ -0,0 +1,247 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/io/mmap_params.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/platform/enforce.h"
+#ifndef _WIN32
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#endif
+
+namespace paddle {
+namespace framework {
+
+#ifndef _WIN32
+MappedParamsReader::MappedParamsReader(const std::string& filename)
+    : file_(memory::allocation::MappedFile::Open(filename)) {}
+
+bool MappedParamsReader::Eof() const { return offset_ >= file_->size(); }
+
+const std::string& MappedParamsReader::filename() const {
+  return file_->filename();
+}
+
+const char* MappedParamsReader::Consume(size_t size) {
+  PADDLE_ENFORCE_LE(
+      size,
+      file_->size() - offset_,
+      platform::errors::Unavailable(
+          "An error occurred while loading model parameters from %s, the "
+          "file ends at %d but %d more bytes are expected at %d. Please "
+          "check whether the model file is complete or damaged.",
+          file_->filename(),
+          file_->size(),
+          size,
+          offset_));
+  const char* ptr = file_->data() + offset_;
+  offset_ += size;
+  return ptr;
+}
+
+bool MappedParamsReader::ReadTensor(phi::DenseTensor* tensor) {
+  uint32_t version = 0;
+  // the 1st field, uint32_t version for DenseTensor
+  memcpy(&version, Consume(sizeof(version)), sizeof(version));
+  PADDLE_ENFORCE_EQ(
+      version,
+      0U,
+      platform::errors::InvalidArgument(
+          "Deserialize to tensor failed, maybe the loaded file is "
+          "not a paddle model(expected file format: 0, but %u found).",
+          version));
+  // the 2nd field, LoD information
+  uint64_t lod_level = 0;
+  memcpy(&lod_level, Consume(sizeof(lod_level)), sizeof(lod_level));
+  auto& lod = *tensor->mutable_lod();
+  lod.resize(lod_level);
+  for (uint64_t i = 0; i < lod_level; ++i) {
+    uint64_t size = 0;
+    memcpy(&size, Consume(sizeof(size)), sizeof(size));
+    std::vector<size_t> level(size / sizeof(size_t));
+    memcpy(level.data(), Consume(size), size);
+    lod[i] = level;
+  }
+  // the 3rd field, Tensor
+  memcpy(&version, Consume(sizeof(version)), sizeof(version));
+  PADDLE_ENFORCE_EQ(
+      version,
+      0U,
+      platform::errors::InvalidArgument(
+          "tensor version %u is not supported, Only version 0 is supported",
+          version));
+  int32_t desc_size = -1;
+  memcpy(&desc_size, Consume(sizeof(desc_size)), sizeof(desc_size));
+  PADDLE_ENFORCE_GE(desc_size,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "phi::DenseTensor desc size should >= 0"));
+  proto::VarType::TensorDesc desc;
+  PADDLE_ENFORCE_EQ(desc.ParseFromArray(Consume(desc_size), desc_size),
+                    true,
+                    platform::errors::InvalidArgument(
+                        "Cannot parse tensor desc"));
+
+  std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+  auto dtype = framework::TransToPhiDataType(desc.data_type());
+  size_t offset = offset_;
+  tensor->clear();
+  tensor->Resize(common::make_ddim(dims));
+  size_t size = tensor->numel() * framework::SizeOfType(desc.data_type());
+  const char* data = Consume(size);
+  if (size > 0 &&
+      reinterpret_cast<uintptr_t>(data) % kMmapParamsAlignment == 0) {
+    tensor->ResetHolderWithType(
+        std::make_shared<memory::allocation::MappedFileAllocation>(
+            file_, offset, size),
+        dtype);
+    return true;
+  }
+  memcpy(tensor->mutable_data(platform::CPUPlace(), dtype), data, size);
+  return false;
+}
+#endif
+
+size_t AlignCombinedParamsFile(const std::string& src_filename,
+                               const std::string& dst_filename,
+                               size_t alignment) {
+  PADDLE_ENFORCE_GT(alignment,
+                    0UL,
+                    platform::errors::InvalidArgument(
+                        "The alignment should be greater than 0."));
+  PADDLE_ENFORCE_NE(src_filename,
+                    dst_filename,
+                    platform::errors::InvalidArgument(
+                        "The params file %s can not be aligned in place.",
+                        src_filename));
+  std::ifstream fin(src_filename, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin),
+                    true,
+                    platform::errors::Unavailable(
+                        "Cannot open %s to load variables.", src_filename));
+  std::ofstream fout(dst_filename, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fout),
+                    true,
+                    platform::errors::Unavailable(
+                        "Cannot open %s to save variables.", dst_filename));
+
+  auto copy = [&](size_t size, const char* what) {
+    char buf[64 << 10];
+    while (size > 0) {
+      size_t n = std::min(size, sizeof(buf));
+      fin.read(buf, static_cast<std::streamsize>(n));
+      PADDLE_ENFORCE_EQ(
+          static_cast<size_t>(fin.gcount()),
+          n,
+          platform::errors::Unavailable(
+              "Failed to read %s from %s, please check whether the model "
+              "file is complete or damaged.",
+              what,
+              src_filename));
+      fout.write(buf, static_cast<std::streamsize>(n));
+      size -= n;
+    }
+  };
+  auto read = [&](void* dst, size_t size, const char* what) {
+    fin.read(static_cast<char*>(dst), static_cast<std::streamsize>(size));
+    PADDLE_ENFORCE_EQ(
+        static_cast<size_t>(fin.gcount()),
+        size,
+        platform::errors::Unavailable(
+            "Failed to read %s from %s, please check whether the model file "
+            "is complete or damaged.",
+            what,
+            src_filename));
+  };
+
+  size_t tensor_num = 0;
+  while (fin.peek() != EOF) {
+    uint32_t version = 0;
+    read(&version, sizeof(version), "the version of DenseTensor");
+    PADDLE_ENFORCE_EQ(version,
+                      0U,
+                      platform::errors::InvalidArgument(
+                          "The params file %s contains a variable other than "
+                          "DenseTensor, which can not be aligned.",
+                          src_filename));
+    uint64_t lod_level = 0;
+    read(&lod_level, sizeof(lod_level), "the lod level");
+    fout.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    fout.write(reinterpret_cast<const char*>(&lod_level), sizeof(lod_level));
+    for (uint64_t i = 0; i < lod_level; ++i) {
+      uint64_t size = 0;
+      read(&size, sizeof(size), "the lod size");
+      fout.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      copy(size, "the lod");
+    }
+
+    read(&version, sizeof(version), "the version of tensor");
+    PADDLE_ENFORCE_EQ(version,
+                      0U,
+                      platform::errors::InvalidArgument(
+                          "tensor version %u is not supported, Only version 0 "
+                          "is supported",
+                          version));
+    int32_t desc_size = -1;
+    read(&desc_size, sizeof(desc_size), "the tensor desc size");
+    PADDLE_ENFORCE_GE(desc_size,
+                      0,
+                      platform::errors::InvalidArgument(
+                          "phi::DenseTensor desc size should >= 0"));
+    std::string desc_str(desc_size, '\0');
+    read(&desc_str[0], desc_size, "the tensor desc");
+    proto::VarType::TensorDesc desc;
+    PADDLE_ENFORCE_EQ(desc.ParseFromString(desc_str),
+                      true,
+                      platform::errors::InvalidArgument(
+                          "Cannot parse tensor desc"));
+
+    // pad the desc until the data following it is aligned
+    size_t desc_offset = static_cast<size_t>(fout.tellp()) + sizeof(version) +
+                         sizeof(desc_size);
+    desc.clear_padding();
+    size_t padding = 0;
+    while ((desc_offset + desc.ByteSizeLong()) % alignment != 0) {
+      desc.set_padding(std::string(padding++, '\0'));
+    }
+    desc_str = desc.SerializeAsString();
+    desc_size = static_cast<int32_t>(desc_str.size());
+    fout.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    fout.write(reinterpret_cast<const char*>(&desc_size), sizeof(desc_size));
+    fout.write(desc_str.data(), desc_size);
+
+    int64_t numel = 1;
+    for (auto dim : desc.dims()) {
+      numel *= dim;
+    }
+    copy(numel * framework::SizeOfType(desc.data_type()), "the tensor data");
+    ++tensor_num;
+  }
+  fout.close();
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fout),
+                    true,
+                    platform::errors::Unavailable(
+                        "Failed to write variables to %s.", dst_filename));
+  VLOG(3) << "aligned " << tensor_num << " tensors of " << src_filename
+          << " to " << alignment << " bytes in " << dst_filename;
+  return tensor_num;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,67 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "paddle/phi/core/dense_tensor.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+class MappedFile;
+}  // namespace allocation
+}  // namespace memory
+
+namespace framework {
+
+// The tensor data in a params file is aliased instead of copied only if it
+// starts at a multiple of kMmapParamsAlignment in the file.
+constexpr size_t kMmapParamsAlignment = 64;
+
+#ifndef _WIN32
+// Reads the DenseTensors written by save_combine from a memory mapped params
+// file. The data of an aligned tensor is not copied, the tensor holds the
+// mapped region and keeps the file mapped, so that the processes loading the
+// same file share the pages. See MappedFile for the write semantics.
+class MappedParamsReader {
+ public:
+  explicit MappedParamsReader(const std::string& filename);
+
+  // Deserialize the next tensor in the format of DeserializeFromStream.
+  // Returns true if the tensor aliases the file.
+  bool ReadTensor(phi::DenseTensor* tensor);
+
+  bool Eof() const;
+
+  const std::string& filename() const;
+
+ private:
+  const char* Consume(size_t size);
+
+  std::shared_ptr<memory::allocation::MappedFile> file_;
+  size_t offset_{0};
+};
+#endif
+
+// Rewrite a params file written by save_combine, padding the desc of every
+// tensor so that its data starts at a multiple of alignment in the file. The
+// output can be loaded by the usual loaders as well. Params files containing
+// vocabularies are not supported. Returns the number of tensors.
+size_t AlignCombinedParamsFile(const std::string& src_filename,
+                               const std::string& dst_filename,
+                               size_t alignment = kMmapParamsAlignment);
+
+}  // namespace framework
+}  // namespace paddle
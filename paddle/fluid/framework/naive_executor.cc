@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/naive_executor.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -21,7 +22,9 @@
 
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/static_arena_planner.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/platform/denormal.h"
 #ifdef PADDLE_WITH_DNNL
 #include "paddle/fluid/platform/mkldnn_helper.h"
@@ -150,6 +153,9 @@ void NaiveExecutor::Run() {
 #ifdef PADDLE_WITH_NVTX
   platform::CudaNvtxRangePop();
 #endif
+  if (!arena_vars_.empty()) {
+    UpdateArenaPlan();
+  }
 }
 
 void NaiveExecutor::CreateVariables(const ProgramDesc &desc,
@@ -273,6 +279,153 @@ void NaiveExecutor::MakeReusePlan(
   }
 }
 
+namespace {
+
+// A block of the static arena, holds the arena until the tensor placed in it
+// takes another holder.
+class ArenaAllocation : public phi::Allocation {
+ public:
+  ArenaAllocation(const std::shared_ptr<phi::Allocation> &arena,
+                  size_t offset,
+                  size_t size)
+      : phi::Allocation(static_cast<uint8_t *>(arena->ptr()) + offset,
+                        size,
+                        arena->place()),
+        arena_(arena) {}
+
+ private:
+  std::shared_ptr<phi::Allocation> arena_;
+};
+
+}  // namespace
+
+void NaiveExecutor::MakeArenaPlan(const std::vector<std::string> &arena_vars) {
+  std::unordered_set<std::string> candidates(arena_vars.begin(),
+                                             arena_vars.end());
+  std::unordered_map<std::string, size_t> var_index;
+  // read before written by the ops, e.g. the inputs
+  std::unordered_set<std::string> external_vars;
+  arena_vars_.clear();
+  for (int i = 0; i < static_cast<int>(ops_.size()); ++i) {
+    auto &op = ops_[i];
+    for (auto &name : op->InputVars()) {
+      if (!candidates.count(name)) continue;
+      auto it = var_index.find(name);
+      if (it == var_index.end()) {
+        external_vars.insert(name);
+      } else {
+        arena_vars_[it->second].end = i;
+      }
+    }
+    for (auto &name : op->OutputVars(true)) {
+      if (!candidates.count(name) || external_vars.count(name)) continue;
+      auto it = var_index.find(name);
+      if (it != var_index.end()) {
+        arena_vars_[it->second].end = i;
+        continue;
+      }
+      auto *var = scope_->FindVar(name);
+      if (var && var->IsType<phi::DenseTensor>()) {
+        var_index.emplace(name, arena_vars_.size());
+        arena_vars_.push_back({var->GetMutable<phi::DenseTensor>(), i, i});
+      }
+    }
+  }
+  arena_buckets_.clear();
+  arena_slots_.clear();
+  arena_size_ = 0;
+  arena_oversized_runs_ = 0;
+  VLOG(3) << "NaiveExecutor places " << arena_vars_.size()
+          << " tensors in the static arena";
+}
+
+void NaiveExecutor::SetArenaBucket(uint64_t bucket) {
+  if (arena_vars_.empty() || bucket == arena_bucket_) return;
+  arena_bucket_ = bucket;
+  auto it = arena_buckets_.find(bucket);
+  // a new bucket is planned after its first run
+  if (it == arena_buckets_.end() || arena_slots_.empty()) return;
+  // grows the arena before a run that outgrows it, the arena is only shrunk
+  // by UpdateArenaPlan
+  for (size_t i = 0; i < arena_vars_.size(); ++i) {
+    if (it->second.sizes[i] > arena_slots_[i]) {
+      ReplanArena();
+      return;
+    }
+  }
+}
+
+void NaiveExecutor::UpdateArenaPlan() {
+  auto &bucket = arena_buckets_[arena_bucket_];
+  bucket.sizes.resize(arena_vars_.size(), 0);
+  bool grown = false;
+  bool replan = arena_slots_.empty();
+  for (size_t i = 0; i < arena_vars_.size(); ++i) {
+    auto *tensor = arena_vars_[i].tensor;
+    if (!tensor->initialized()) continue;
+    size_t bytes = tensor->numel() * phi::SizeOf(tensor->dtype());
+    if (bytes > bucket.sizes[i]) {
+      bucket.sizes[i] = bytes;
+      grown = true;
+    }
+    replan = replan || bucket.sizes[i] > arena_slots_[i];
+  }
+  if (grown) {
+    std::vector<ArenaBlock> blocks;
+    bucket.arena_size = PlanArenaBlocks(bucket.sizes, &blocks);
+  }
+  // An arena more than twice the size the bucket needs is only shrunk after
+  // kArenaShrinkRuns runs in a row that need less, so that the runs which
+  // alternate between the buckets keep the arena of the largest one.
+  if (!replan && arena_size_ > 2 * bucket.arena_size) {
+    replan = ++arena_oversized_runs_ >= kArenaShrinkRuns;
+  } else {
+    arena_oversized_runs_ = 0;
+  }
+  if (replan) {
+    ReplanArena();
+  }
+}
+
+size_t NaiveExecutor::PlanArenaBlocks(const std::vector<size_t> &sizes,
+                                      std::vector<ArenaBlock> *blocks) const {
+  blocks->clear();
+  blocks->reserve(arena_vars_.size());
+  for (size_t i = 0; i < arena_vars_.size(); ++i) {
+    blocks->push_back({sizes[i], arena_vars_[i].begin, arena_vars_[i].end, 0});
+  }
+  return PlanStaticArena(blocks);
+}
+
+void NaiveExecutor::ReplanArena() {
+  auto &bucket = arena_buckets_[arena_bucket_];
+  bucket.sizes.resize(arena_vars_.size(), 0);
+  std::vector<ArenaBlock> blocks;
+  arena_size_ = bucket.arena_size = PlanArenaBlocks(bucket.sizes, &blocks);
+  arena_slots_ = bucket.sizes;
+  arena_oversized_runs_ = 0;
+  size_t tensor_bytes = 0;
+  for (size_t size : bucket.sizes) {
+    tensor_bytes += size;
+  }
+
+  // the old arena is released once no tensor holds a block of it
+  std::shared_ptr<phi::Allocation> arena;
+  if (arena_size_ > 0) {
+    arena = memory::AllocShared(place_, arena_size_);
+  }
+  for (size_t i = 0; i < arena_vars_.size(); ++i) {
+    if (blocks[i].size == 0) continue;
+    auto *tensor = arena_vars_[i].tensor;
+    tensor->clear();
+    tensor->ResetHolder(std::make_shared<ArenaAllocation>(
+        arena, blocks[i].offset, blocks[i].size));
+  }
+  LOG(INFO) << "NaiveExecutor plans a static arena of "
+            << (arena_size_ >> 20) << " MB for " << arena_vars_.size()
+            << " tensors of " << (tensor_bytes >> 20) << " MB in total";
+}
+
 NaiveExecutor::~NaiveExecutor() {
 #ifdef PADDLE_WITH_DNNL
   // Clear mkl-dnn cache,
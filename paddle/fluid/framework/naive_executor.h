@@ -23,6 +23,7 @@
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/static_arena_planner.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -88,6 +89,20 @@ class NaiveExecutor {
   void MakeReusePlan(
       const std::unordered_map<std::string, std::string>& reuse_table);
 
+  // Instead of the reuse plan, places the tensors of arena_vars written by
+  // the ops at planned offsets of one arena, so that the runs of the same
+  // input shapes do not allocate them. The sizes of the tensors are recorded
+  // by the runs, the arena is planned again after a run that outgrows it.
+  void MakeArenaPlan(const std::vector<std::string>& arena_vars);
+
+  // Sets the bucket of the input shapes of the next run. The arena is planned
+  // again for the recorded sizes of a known bucket that do not fit it, and
+  // after kArenaShrinkRuns runs in a row whose buckets need less than half of
+  // it.
+  void SetArenaBucket(uint64_t bucket);
+
+  static constexpr int kArenaShrinkRuns = 16;
+
   void ResetTrtOps(int num);
 
   void CloneLiteEngine(int num, void* stream);
@@ -97,6 +112,11 @@ class NaiveExecutor {
 
  private:
   void CreateOps(const ProgramDesc& desc, int block_id);
+  void UpdateArenaPlan();
+  void ReplanArena();
+  // returns the size of the arena of the tensors of sizes
+  size_t PlanArenaBlocks(const std::vector<size_t>& sizes,
+                         std::vector<ArenaBlock>* blocks) const;
 
  private:
   const platform::Place place_;
@@ -112,6 +132,24 @@ class NaiveExecutor {
       reuse_cache_;
   std::vector<phi::DenseTensor*> cluster_buffer_;
 
+  // The tensors of the static arena, written first by the op of index begin
+  // and used last by the op of index end.
+  struct ArenaVar {
+    phi::DenseTensor* tensor;
+    int begin;
+    int end;
+  };
+  struct ArenaBucket {
+    std::vector<size_t> sizes;  // the largest bytes of the tensors
+    size_t arena_size{0};       // the size of the arena planned for sizes
+  };
+  std::vector<ArenaVar> arena_vars_;
+  std::unordered_map<uint64_t, ArenaBucket> arena_buckets_;
+  uint64_t arena_bucket_{0};
+  std::vector<size_t> arena_slots_;  // the planned bytes of the tensors
+  size_t arena_size_{0};
+  int arena_oversized_runs_{0};
+
   std::unique_ptr<framework::InterpreterCore> interpreter_core_;
 };
 
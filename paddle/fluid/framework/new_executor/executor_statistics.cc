@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/executor_statistics.h"
 
+#include <atomic>
 #include <fstream>
 #include <functional>
 #include <map>
@@ -38,6 +39,12 @@ PADDLE_DEFINE_EXPORTED_string(static_executor_perfstat_filepath,
 namespace paddle {
 namespace framework {
 
+namespace {
+std::atomic<uint64_t> host_executed_tasks{0};
+std::atomic<uint64_t> host_stolen_tasks{0};
+std::atomic<uint64_t> host_idle_waits{0};
+}  // namespace
+
 class StatisticsEngine {
  public:
   int Apply(const platform::NodeTrees& trees);
@@ -611,6 +618,19 @@ void StatisticsEngine::Log(const std::string& filepath) {
                                    evt_stat.count,
                                    evt_stat.normalization_time);
   }
+  WorkQueueStats host_stats = GetHostSchedulerStatistics();
+  if (host_stats.executed_tasks > 0) {
+    ofs << platform::string_format(std::string(R"JSON(
+  {
+    "statistical item" : "HostScheduler",
+    "executed tasks" : %llu,
+    "stolen tasks" : %llu,
+    "idle waits" : %llu
+  },)JSON"),
+                                   host_stats.executed_tasks,
+                                   host_stats.stolen_tasks,
+                                   host_stats.idle_waits);
+  }
   ofs.seekp(-1, std::ios_base::end);
   ofs << "]";
   if (ofs) {
@@ -619,6 +639,21 @@ void StatisticsEngine::Log(const std::string& filepath) {
   ofs.close();
 }
 
+void AddHostSchedulerStatistics(const WorkQueueStats& stats) {
+  host_executed_tasks.fetch_add(stats.executed_tasks,
+                                std::memory_order_relaxed);
+  host_stolen_tasks.fetch_add(stats.stolen_tasks, std::memory_order_relaxed);
+  host_idle_waits.fetch_add(stats.idle_waits, std::memory_order_relaxed);
+}
+
+WorkQueueStats GetHostSchedulerStatistics() {
+  WorkQueueStats stats;
+  stats.executed_tasks = host_executed_tasks.load(std::memory_order_relaxed);
+  stats.stolen_tasks = host_stolen_tasks.load(std::memory_order_relaxed);
+  stats.idle_waits = host_idle_waits.load(std::memory_order_relaxed);
+  return stats;
+}
+
 void StaticGraphExecutorPerfStatistics(
     std::shared_ptr<const platform::NodeTrees> profiling_data) {
   if (FLAGS_static_executor_perfstat_filepath.empty()) {
@@ -16,6 +16,7 @@
 
 #include <memory>
 
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
 #include "paddle/fluid/platform/profiler/event_node.h"
 
 namespace paddle {
@@ -24,5 +25,11 @@ namespace framework {
 void StaticGraphExecutorPerfStatistics(
     std::shared_ptr<const platform::NodeTrees> profiling_data);
 
+// Accumulate the counters of the priority stealing host work queues, they are
+// reported along with the other statistics.
+void AddHostSchedulerStatistics(const WorkQueueStats& stats);
+
+WorkQueueStats GetHostSchedulerStatistics();
+
 }  // namespace framework
 }  // namespace paddle
@@ -133,8 +133,11 @@ PhiKernelInstruction::PhiKernelInstruction(
   auto kernel_key = op_attributes.at("kernel_key")
                         .dyn_cast<paddle::dialect::KernelAttribute>()
                         .data();
-  auto kernel_result = phi::KernelFactory::Instance().SelectKernelOrThrowError(
-      kernel_name, kernel_key);
+  // the same kernels are selected again and again when the programs are
+  // rebuilt, e.g. for new shapes
+  static thread_local phi::KernelSelectionCache kernel_selection_cache(1024);
+  auto kernel_result = kernel_selection_cache.Select(
+      phi::KernelFactory::Instance().GetKernelNameId(kernel_name), kernel_key);
   phi_kernel_ = new phi::Kernel(kernel_result.kernel);
   PADDLE_ENFORCE_EQ(
       phi_kernel_->IsValid(), true, "not found kernel for [%s]", kernel_name);
@@ -23,6 +23,7 @@
 #include "paddle/phi/backends/xpu/xpu_info.h"
 
 PD_DECLARE_bool(new_executor_serial_run);
+PD_DECLARE_bool(new_executor_use_priority_stealing);
 
 namespace paddle {
 namespace framework {
@@ -49,6 +50,12 @@ inline std::tuple<int, int> GetThreadPoolConfig(const phi::Place& place,
   if (platform::is_cpu_place(place)) {
     num_device_threads = 0;
     num_host_threads = 4;
+    // With priority stealing, start from all the processors and let the
+    // interpreter shrink the pool to the parallelism of the program.
+    processor_count = static_cast<int>(std::thread::hardware_concurrency());
+    if (FLAGS_new_executor_use_priority_stealing && processor_count > 0) {
+      num_host_threads = processor_count;
+    }
   } else {
     processor_count = static_cast<int>(std::thread::hardware_concurrency());
     if (processor_count) {
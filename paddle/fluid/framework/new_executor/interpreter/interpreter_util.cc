@@ -53,6 +53,7 @@ COMMON_DECLARE_bool(use_mkldnn);
 COMMON_DECLARE_bool(check_nan_inf);
 COMMON_DECLARE_string(static_runtime_data_save_path);
 COMMON_DECLARE_bool(save_static_runtime_data);
+PD_DECLARE_bool(new_executor_use_priority_stealing);
 
 namespace paddle {
 namespace framework {
@@ -103,6 +104,8 @@ const std::vector<WorkQueueOptions> ConstructWorkQueueOptions(
                              /*track_task*/ false,
                              /*detached*/ true,
                              /*events_waiter*/ waiter);
+  group_options.back().priority_scheduling =
+      FLAGS_new_executor_use_priority_stealing;
   // for launch device Kernel
   group_options.emplace_back(/*name*/ "DeviceKernelLaunch",
                              /*num_threads*/ device_num_threads,
@@ -129,6 +132,125 @@ void AsyncWorkQueue::AddTask(const OpFuncType& op_func_type,
   queue_group_->AddTask(op_func_type == OpFuncType::kGpuAsync, std::move(fn));
 }
 
+void AsyncWorkQueue::AddTask(const OpFuncType& op_func_type,
+                             SchedulingPriority priority,
+                             std::function<void()> fn) {
+  queue_group_->AddTaskWithPriority(
+      op_func_type == OpFuncType::kGpuAsync, priority, std::move(fn));
+}
+
+WorkQueueStats AsyncWorkQueue::CollectHostQueueStats() {
+  std::lock_guard<std::mutex> guard(collected_host_stats_mutex_);
+  WorkQueueStats total = queue_group_->QueueStats(0);
+  WorkQueueStats delta;
+  delta.executed_tasks =
+      total.executed_tasks - collected_host_stats_.executed_tasks;
+  delta.stolen_tasks = total.stolen_tasks - collected_host_stats_.stolen_tasks;
+  delta.idle_waits = total.idle_waits - collected_host_stats_.idle_waits;
+  collected_host_stats_ = total;
+  return delta;
+}
+
+std::vector<SchedulingPriority> BuildCriticalPathRanks(
+    const std::map<size_t, std::set<size_t>>& downstream_map,
+    const std::vector<SchedulingPriority>& scheduling_priorities,
+    size_t* max_parallelism) {
+  size_t instr_num = scheduling_priorities.size();
+  std::vector<size_t> in_degree(instr_num, 0);
+  for (auto& item : downstream_map) {
+    for (size_t next_id : item.second) {
+      ++in_degree[next_id];
+    }
+  }
+
+  // topological order, level is the longest distance from a root
+  std::vector<size_t> topo_order;
+  std::vector<size_t> level(instr_num, 0);
+  topo_order.reserve(instr_num);
+  for (size_t id = 0; id < instr_num; ++id) {
+    if (in_degree[id] == 0) {
+      topo_order.push_back(id);
+    }
+  }
+  for (size_t i = 0; i < topo_order.size(); ++i) {
+    size_t id = topo_order[i];
+    auto iter = downstream_map.find(id);
+    if (iter == downstream_map.end()) {
+      continue;
+    }
+    for (size_t next_id : iter->second) {
+      level[next_id] = std::max(level[next_id], level[id] + 1);
+      if (--in_degree[next_id] == 0) {
+        topo_order.push_back(next_id);
+      }
+    }
+  }
+  PADDLE_ENFORCE_EQ(topo_order.size(),
+                    instr_num,
+                    platform::errors::PreconditionNotMet(
+                        "The dependency graph of instructions has a cycle."));
+
+  std::vector<size_t> path_length(instr_num, 1);
+  for (auto it = topo_order.rbegin(); it != topo_order.rend(); ++it) {
+    auto iter = downstream_map.find(*it);
+    if (iter == downstream_map.end()) {
+      continue;
+    }
+    for (size_t next_id : iter->second) {
+      path_length[*it] = std::max(path_length[*it], path_length[next_id] + 1);
+    }
+  }
+
+  std::vector<size_t> level_width(instr_num + 1, 0);
+  size_t width = instr_num > 0 ? 1 : 0;
+  for (size_t id = 0; id < instr_num; ++id) {
+    width = std::max(width, ++level_width[level[id]]);
+  }
+  if (max_parallelism != nullptr) {
+    *max_parallelism = width;
+  }
+
+  std::vector<size_t> order(instr_num);
+  for (size_t id = 0; id < instr_num; ++id) {
+    order[id] = id;
+  }
+  std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    if (scheduling_priorities[lhs] != scheduling_priorities[rhs]) {
+      return scheduling_priorities[lhs] < scheduling_priorities[rhs];
+    }
+    if (path_length[lhs] != path_length[rhs]) {
+      return path_length[lhs] > path_length[rhs];
+    }
+    return lhs < rhs;
+  });
+  std::vector<SchedulingPriority> ranks(instr_num);
+  for (size_t i = 0; i < instr_num; ++i) {
+    ranks[order[i]] = static_cast<SchedulingPriority>(i);
+  }
+  return ranks;
+}
+
+std::vector<size_t> OrderByCriticalPathRanks(
+    const std::set<size_t>& instr_ids,
+    const std::vector<SchedulingPriority>& ranks) {
+  std::vector<size_t> ordered_ids(instr_ids.begin(), instr_ids.end());
+  if (!ranks.empty()) {
+    std::sort(ordered_ids.begin(),
+              ordered_ids.end(),
+              [&ranks](size_t lhs, size_t rhs) {
+                return ranks[lhs] < ranks[rhs];
+              });
+  }
+  return ordered_ids;
+}
+
+bool TraceRunForInference(const ExecutionConfig& execution_config,
+                          const platform::Place& place) {
+  return execution_config.used_for_inference &&
+         !(FLAGS_new_executor_use_priority_stealing &&
+           platform::is_cpu_place(place));
+}
+
 bool IsCommunicationOp(const OperatorBase* op) {
   const std::string& op_name = op->Type();
   const std::set<std::string> special_comm_op_set = {
@@ -18,6 +18,8 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -55,17 +57,51 @@ class AsyncWorkQueue {
 
   void AddTask(const OpFuncType& op_func_type, std::function<void()> fn);
 
+  // A lower priority value runs earlier, only takes effect on host tasks when
+  // FLAGS_new_executor_use_priority_stealing is set.
+  void AddTask(const OpFuncType& op_func_type,
+               SchedulingPriority priority,
+               std::function<void()> fn);
+
   void Cancel() { queue_group_->Cancel(); }
 
   size_t QueueNumThreads(size_t idx) {
     return queue_group_->QueueNumThreads(idx);
   }
 
+  // Scheduling statistics of the host queue since the last call.
+  WorkQueueStats CollectHostQueueStats();
+
  private:
   size_t host_num_thread_;
   std::unique_ptr<WorkQueueGroup> queue_group_;
+  // the workqueue can be shared by the interpreters of a program
+  std::mutex collected_host_stats_mutex_;
+  WorkQueueStats collected_host_stats_;
 };
 
+// Assign every instruction a globally consistent scheduling rank, a lower rank
+// runs earlier. Instructions are ordered by scheduling_priority first, then by
+// the length of the longest dependency chain behind them (the critical path),
+// then by id. max_parallelism is set to the largest number of instructions on
+// the same dependency level, which bounds the useful number of host threads.
+std::vector<SchedulingPriority> BuildCriticalPathRanks(
+    const std::map<size_t, std::set<size_t>>& downstream_map,
+    const std::vector<SchedulingPriority>& scheduling_priorities,
+    size_t* max_parallelism);
+
+// Return instr_ids ordered by ranks, or in their original order if ranks is
+// empty.
+std::vector<size_t> OrderByCriticalPathRanks(
+    const std::set<size_t>& instr_ids,
+    const std::vector<SchedulingPriority>& ranks);
+
+// Whether an inference program runs its instructions in the trace order on the
+// calling thread. CPU inference with FLAGS_new_executor_use_priority_stealing
+// runs them on the priority stealing host workqueue instead.
+bool TraceRunForInference(const ExecutionConfig& execution_config,
+                          const platform::Place& place);
+
 bool IsCommunicationOp(const OperatorBase* op);
 
 bool IsCommunicationOp(const Instruction& instr);
@@ -34,6 +34,12 @@ PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope,
                             true,
                             "Use local_scope in new executor(especially used "
                             "in UT), can turn off for better performance");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_use_priority_stealing,
+    false,
+    "Run host tasks of the new executor in a work-stealing thread pool "
+    "ordered by the critical path of the program, and size the host thread "
+    "pool by the parallelism of the program instead of a fixed number.");
 
 namespace paddle {
 namespace framework {
@@ -21,6 +21,7 @@
 
 #include "paddle/fluid/framework/details/nan_inf_utils.h"
 #include "paddle/fluid/framework/details/share_tensor_buffer_functor.h"
+#include "paddle/fluid/framework/new_executor/executor_statistics.h"
 #include "paddle/fluid/framework/new_executor/interpreter/interpreter_util.h"
 #include "paddle/fluid/framework/new_executor/interpreter/static_build.h"
 #include "paddle/fluid/framework/operator.h"
@@ -126,6 +127,9 @@ PirInterpreter::PirInterpreter(const platform::Place& place,
   execution_config_.Log(/*log_level=*/8);
 
   ir_instruction_scheduling_priority_less = [this](size_t lhs, size_t rhs) {
+    if (!critical_path_ranks_.empty()) {
+      return critical_path_ranks_[lhs] > critical_path_ranks_[rhs];
+    }
     SchedulingPriority lhs_scheduling_priority =
         vec_instruction_base_[lhs]->GetSchedulingPriority();
     SchedulingPriority rhs_scheduling_priority =
@@ -188,6 +192,9 @@ PirInterpreter::PirInterpreter(
   execution_config_.Log(/*log_level=*/8);
 
   ir_instruction_scheduling_priority_less = [this](size_t lhs, size_t rhs) {
+    if (!critical_path_ranks_.empty()) {
+      return critical_path_ranks_[lhs] > critical_path_ranks_[rhs];
+    }
     SchedulingPriority lhs_scheduling_priority =
         vec_instruction_base_[lhs]->GetSchedulingPriority();
     SchedulingPriority rhs_scheduling_priority =
@@ -327,14 +334,22 @@ bool PirInterpreter::IsSharedResultsBuild() const {
 
 std::shared_ptr<interpreter::AsyncWorkQueue> PirInterpreter::GetWorkQueue() {
   if (async_work_queue_ == nullptr) {
+    size_t host_num_threads = execution_config_.host_num_threads;
+    if (max_parallelism_ > 0 && host_num_threads > max_parallelism_) {
+      // more host threads than the program can keep busy only add stealing
+      // and wakeup overhead
+      host_num_threads = max_parallelism_;
+    }
     async_work_queue_ = std::make_shared<interpreter::AsyncWorkQueue>(
-        execution_config_.host_num_threads,
-        execution_config_.device_num_threads,
-        nullptr);
+        host_num_threads, execution_config_.device_num_threads, nullptr);
   }
   return async_work_queue_;
 }
 
+SchedulingPriority PirInterpreter::CriticalPathRank(size_t instr_id) const {
+  return critical_path_ranks_.empty() ? 0 : critical_path_ranks_[instr_id];
+}
+
 void PirInterpreter::PrepareForCUDAGraphCapture() {
   if (!FLAGS_new_executor_use_cuda_graph) return;
 #ifdef PADDLE_WITH_CUDA
@@ -913,6 +928,18 @@ void PirInterpreter::BuildInstructionDependences() {
   }
   auto downstream_map = ir_dependency_builder_.Build(instructions_ptr);
 
+  if (FLAGS_new_executor_use_priority_stealing) {
+    std::vector<SchedulingPriority> scheduling_priorities;
+    scheduling_priorities.reserve(instr_num);
+    for (auto& instr : vec_instruction_base_) {
+      scheduling_priorities.push_back(instr->GetSchedulingPriority());
+    }
+    critical_path_ranks_ = interpreter::BuildCriticalPathRanks(
+        downstream_map, scheduling_priorities, &max_parallelism_);
+    VLOG(4) << "Build critical path ranks for " << instr_num
+            << " instructions, max parallelism: " << max_parallelism_;
+  }
+
   for (size_t instr_id = 0; instr_id < instr_num; ++instr_id) {
     InstructionBase* cur_instr = vec_instruction_base_[instr_id].get();
     const std::set<size_t>& next_instr_ids = downstream_map[instr_id];
@@ -932,8 +959,10 @@ void PirInterpreter::BuildInstructionDependences() {
           }
         }
       } else {
+        // keep the most urgent successor in the same thread
         bool has_instr_in_same_thread = false;
-        for (size_t next_instr_id : next_instr_ids) {
+        for (size_t next_instr_id : interpreter::OrderByCriticalPathRanks(
+                 next_instr_ids, critical_path_ranks_)) {
           if (!has_instr_in_same_thread &&
               vec_instruction_base_[next_instr_id]->KernelType() !=
                   OpFuncType::kGpuAsync) {
@@ -1331,7 +1360,7 @@ paddle::framework::FetchList PirInterpreter::Run(
     VLOG(4) << "Done PreAnalysis";
 
     if (FLAGS_enable_pir_in_executor_trace_run || onednn_op_num_ ||
-        execution_config_.used_for_inference ||
+        interpreter::TraceRunForInference(execution_config_, place_) ||
         ((execution_config_.used_for_jit || execution_config_.used_for_cinn) &&
          (sync_op_num_ == 0))) {
       LOG_FIRST_N(INFO, 1) << "pir interpreter is running by trace mode ...";
@@ -1352,7 +1381,7 @@ paddle::framework::FetchList PirInterpreter::Run(
     }
 #endif
     if (FLAGS_enable_pir_in_executor_trace_run || onednn_op_num_ ||
-        execution_config_.used_for_inference ||
+        interpreter::TraceRunForInference(execution_config_, place_) ||
         ((execution_config_.used_for_jit || execution_config_.used_for_cinn) &&
          (sync_op_num_ == 0))) {
       TraceRunImpl();
@@ -1422,7 +1451,7 @@ FetchList PirInterpreter::Run(const std::vector<std::string>& feed_names,
 
     // Run
     if (FLAGS_enable_pir_in_executor_trace_run || onednn_op_num_ ||
-        execution_config_.used_for_inference ||
+        interpreter::TraceRunForInference(execution_config_, place_) ||
         ((execution_config_.used_for_jit || execution_config_.used_for_cinn) &&
          (sync_op_num_ == 0))) {
       LOG_FIRST_N(INFO, 1) << "pir interpreter is running by trace mode ...";
@@ -1443,7 +1472,7 @@ FetchList PirInterpreter::Run(const std::vector<std::string>& feed_names,
     }
 #endif
     if (FLAGS_enable_pir_in_executor_trace_run || onednn_op_num_ ||
-        execution_config_.used_for_inference ||
+        interpreter::TraceRunForInference(execution_config_, place_) ||
         ((execution_config_.used_for_jit || execution_config_.used_for_cinn) &&
          (sync_op_num_ == 0))) {
       TraceRunImpl();
@@ -1588,6 +1617,7 @@ void PirInterpreter::MultiThreadRunInstructionList(
         RunInstructionBaseAsync(i);
       } else {
         async_work_queue_->AddTask(vec_instr.at(i)->KernelType(),
+                                   CriticalPathRank(i),
                                    [this, i] { RunInstructionBaseAsync(i); });
       }
     }
@@ -1627,6 +1657,14 @@ void PirInterpreter::MultiThreadRunInstructionList(
   VLOG(1) << "main_thread_blocker_(" << &main_thread_blocker_
           << ") got event_name: " << event_name;
 
+  if (FLAGS_new_executor_use_priority_stealing) {
+    WorkQueueStats stats = async_work_queue_->CollectHostQueueStats();
+    VLOG(4) << "Host scheduler executed " << stats.executed_tasks
+            << " tasks, stolen " << stats.stolen_tasks << " tasks, idle "
+            << stats.idle_waits << " times";
+    AddHostSchedulerStatistics(stats);
+  }
+
   cancel_log = true;
   if (logged_times.valid()) {
     VLOG(1) << "Logged deps for " << logged_times.get() << " times";
@@ -1655,7 +1693,8 @@ void PirInterpreter::RunInstructionBaseAsync(size_t instr_id) {
   // NOTE(Ruibiao): Due to the uncertain order in multi-threading asynchronous
   // scheduling, the priority order involved cross-thread scheduling is not
   // guaranteed. Only Ops scheduled by the same AddTask call have the guarantee
-  // of priority order.
+  // of priority order, unless FLAGS_new_executor_use_priority_stealing is set
+  // and the host workqueue orders all the tasks by critical path ranks.
   SchedulingQueue ready_ops(ir_instruction_scheduling_priority_less);
   ready_ops.push(instr_id);
   while (!ready_ops.empty()) {
@@ -1700,6 +1739,7 @@ void PirInterpreter::RunNextInstructions(InstructionBase* instr,
     if (IsReady(next_instr_id)) {
       async_work_queue_->AddTask(
           vec_instruction_base_[next_instr_id]->KernelType(),
+          CriticalPathRank(next_instr_id),
           [this, next_instr_id]() { RunInstructionBaseAsync(next_instr_id); });
     }
   }
@@ -146,6 +146,7 @@ class PirInterpreter : public InterpreterBaseImpl {
 
   // workqueue
   std::shared_ptr<interpreter::AsyncWorkQueue> GetWorkQueue();
+  SchedulingPriority CriticalPathRank(size_t instr_id) const;
 
   // scope
   bool HasLocalScope() const;
@@ -253,6 +254,11 @@ class PirInterpreter : public InterpreterBaseImpl {
 
   InstructionSchedulingPriorityLess ir_instruction_scheduling_priority_less;
 
+  // only built with FLAGS_new_executor_use_priority_stealing, see
+  // interpreter::BuildCriticalPathRanks
+  std::vector<SchedulingPriority> critical_path_ranks_;
+  size_t max_parallelism_{0};
+
   const ::pir::Block* ir_block_{nullptr};
 
   std::unordered_map<::pir::Block*, PirInterpreter*> sub_blocks_;  // Not owned
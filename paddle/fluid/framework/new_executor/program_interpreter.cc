@@ -17,6 +17,7 @@
 #include "paddle/fluid/framework/details/nan_inf_utils.h"
 #include "paddle/fluid/framework/details/share_tensor_buffer_functor.h"
 #include "paddle/fluid/framework/io/save_load_tensor.h"
+#include "paddle/fluid/framework/new_executor/executor_statistics.h"
 #include "paddle/fluid/framework/new_executor/interpreter/interpreter_util.h"
 #include "paddle/fluid/framework/new_executor/interpreter/static_build.h"
 #include "paddle/fluid/framework/operator.h"
@@ -82,6 +83,9 @@ ProgramInterpreter::ProgramInterpreter(const platform::Place& place,
                   interpreter::BlockCanBeStaticBuilt(block);
 
   instruction_scheduling_priority_less = [this](size_t lhs, size_t rhs) {
+    if (!critical_path_ranks_.empty()) {
+      return critical_path_ranks_[lhs] > critical_path_ranks_[rhs];
+    }
     SchedulingPriority lhs_scheduling_priority =
         vec_instruction_[lhs].GetSchedulingPriority();
     SchedulingPriority rhs_scheduling_priority =
@@ -120,7 +124,8 @@ void ProgramInterpreter::RunImpl() {
 
   interpreter::ResetAtomicGuard guard(&deps_, &refs_);
 
-  if (is_in_op_profiling_mode_ || execution_config_.used_for_inference ||
+  if (is_in_op_profiling_mode_ ||
+      interpreter::TraceRunForInference(execution_config_, place_) ||
       ((execution_config_.used_for_jit || execution_config_.used_for_cinn) &&
        (sync_op_num_ == 0))) {
     VLOG(4) << "Tracing Instruction List";
@@ -384,14 +389,22 @@ bool ProgramInterpreter::BuildInplaceCheckVarIsOnlyInput(
 std::shared_ptr<interpreter::AsyncWorkQueue>
 ProgramInterpreter::GetWorkQueue() {
   if (async_work_queue_ == nullptr) {
+    size_t host_num_threads = execution_config_.host_num_threads;
+    if (max_parallelism_ > 0 && host_num_threads > max_parallelism_) {
+      // more host threads than the program can keep busy only add stealing
+      // and wakeup overhead
+      host_num_threads = max_parallelism_;
+    }
     async_work_queue_ = std::make_shared<interpreter::AsyncWorkQueue>(
-        execution_config_.host_num_threads,
-        execution_config_.device_num_threads,
-        nullptr);
+        host_num_threads, execution_config_.device_num_threads, nullptr);
   }
   return async_work_queue_;
 }
 
+SchedulingPriority ProgramInterpreter::CriticalPathRank(size_t instr_id) const {
+  return critical_path_ranks_.empty() ? 0 : critical_path_ranks_[instr_id];
+}
+
 const interpreter::DependencyBuilder& ProgramInterpreter::GetDependencyBuilder()
     const {
   return dependency_builder_;
@@ -612,6 +625,18 @@ void ProgramInterpreter::BuildOperatorDependences() {
 
   auto downstream_map = dependency_builder_.Build(vec_instruction_);
 
+  if (FLAGS_new_executor_use_priority_stealing) {
+    std::vector<SchedulingPriority> scheduling_priorities;
+    scheduling_priorities.reserve(instr_num);
+    for (const Instruction& instr : vec_instruction_) {
+      scheduling_priorities.push_back(instr.GetSchedulingPriority());
+    }
+    critical_path_ranks_ = interpreter::BuildCriticalPathRanks(
+        downstream_map, scheduling_priorities, &max_parallelism_);
+    VLOG(4) << "Build critical path ranks for " << instr_num
+            << " instructions, max parallelism: " << max_parallelism_;
+  }
+
   for (size_t instr_id = 0; instr_id < instr_num; ++instr_id) {
     Instruction& cur_instr = vec_instruction_[instr_id];
     const std::set<size_t>& next_instr_ids = downstream_map[instr_id];
@@ -631,8 +656,10 @@ void ProgramInterpreter::BuildOperatorDependences() {
           }
         }
       } else {
+        // keep the most urgent successor in the same thread
         bool has_instr_in_same_thread = false;
-        for (size_t next_instr_id : next_instr_ids) {
+        for (size_t next_instr_id : interpreter::OrderByCriticalPathRanks(
+                 next_instr_ids, critical_path_ranks_)) {
           if (!has_instr_in_same_thread &&
               vec_instruction_[next_instr_id].KernelType() !=
                   OpFuncType::kGpuAsync) {
@@ -1253,6 +1280,7 @@ void ProgramInterpreter::ExecuteInstructionList(
         RunInstructionAsync(i);
       } else {
         async_work_queue_->AddTask(vec_instr.at(i).KernelType(),
+                                   CriticalPathRank(i),
                                    [this, i] { RunInstructionAsync(i); });
       }
     }
@@ -1292,6 +1320,14 @@ void ProgramInterpreter::ExecuteInstructionList(
   VLOG(1) << "main_thread_blocker_(" << &main_thread_blocker_
           << ") got event_name: " << event_name;
 
+  if (FLAGS_new_executor_use_priority_stealing) {
+    WorkQueueStats stats = async_work_queue_->CollectHostQueueStats();
+    VLOG(4) << "Host scheduler executed " << stats.executed_tasks
+            << " tasks, stolen " << stats.stolen_tasks << " tasks, idle "
+            << stats.idle_waits << " times";
+    AddHostSchedulerStatistics(stats);
+  }
+
   cancel_log = true;
   if (logged_times.valid()) {
     VLOG(1) << "Logged deps for " << logged_times.get() << " times";
@@ -1331,6 +1367,7 @@ void ProgramInterpreter::RunNextInstructions(
     if (IsReady(next_instr_id)) {
       async_work_queue_->AddTask(
           vec_instruction_[next_instr_id].KernelType(),
+          CriticalPathRank(next_instr_id),
           [this, next_instr_id]() { RunInstructionAsync(next_instr_id); });
     }
   }
@@ -1346,7 +1383,8 @@ void ProgramInterpreter::RunInstructionAsync(size_t instr_id) {
   // NOTE(Ruibiao): Due to the uncertain order in multi-threading asynchronous
   // scheduling, the priority order involved cross-thread scheduling is not
   // guaranteed. Only Ops scheduled by the same AddTask call have the guarantee
-  // of priority order.
+  // of priority order, unless FLAGS_new_executor_use_priority_stealing is set
+  // and the host workqueue orders all the tasks by critical path ranks.
   SchedulingQueue ready_ops(instruction_scheduling_priority_less);
   ready_ops.push(instr_id);
   while (!ready_ops.empty()) {
@@ -166,6 +166,7 @@ class ProgramInterpreter : public InterpreterBaseImpl {
 
   // workqueue
   std::shared_ptr<interpreter::AsyncWorkQueue> GetWorkQueue();
+  SchedulingPriority CriticalPathRank(size_t instr_id) const;
 
   // scope
   bool HasLocalScope() const;
@@ -236,6 +237,11 @@ class ProgramInterpreter : public InterpreterBaseImpl {
 
   InstructionSchedulingPriorityLess instruction_scheduling_priority_less;
 
+  // only built with FLAGS_new_executor_use_priority_stealing, see
+  // interpreter::BuildCriticalPathRanks
+  std::vector<SchedulingPriority> critical_path_ranks_;
+  size_t max_parallelism_{0};
+
   std::vector<HookFunc> output_hookfuncs_;
   std::vector<HookFunc> input_hookfuncs_;
 
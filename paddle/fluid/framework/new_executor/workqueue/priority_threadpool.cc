@@ -0,0 +1,236 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/workqueue/priority_threadpool.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/os_info.h"
+#include "paddle/fluid/platform/profiler/event_tracing.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+struct PerThread {
+  const PriorityThreadPool* pool{nullptr};
+  int thread_id{-1};
+};
+
+PerThread* GetPerThread() {
+  static thread_local PerThread per_thread;
+  return &per_thread;
+}
+
+}  // namespace
+
+PriorityThreadPool::PriorityThreadPool(const std::string& name,
+                                       int num_threads,
+                                       bool allow_spinning)
+    : name_(name),
+      num_threads_(num_threads),
+      allow_spinning_(allow_spinning),
+      ec_(num_threads),
+      workers_(new WorkerData[num_threads]) {
+  PADDLE_ENFORCE_GT(num_threads,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "PriorityThreadPool needs at least one thread."));
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_[i].thread.reset(
+        new StlThreadEnvironment::EnvThread([this, i]() { WorkerLoop(i); }));
+  }
+}
+
+PriorityThreadPool::~PriorityThreadPool() {
+  done_ = true;
+  ec_.Notify(true);
+  // Join threads explicitly before the queues are destroyed.
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_[i].thread.reset();
+  }
+}
+
+void PriorityThreadPool::AddTask(std::function<void()> fn, int64_t priority) {
+  // kNoTask marks an empty queue, clamp so that the task stays visible
+  priority = std::min(priority, kNoTask - 1);
+  Task task{priority,
+            next_seq_.fetch_add(1, std::memory_order_relaxed),
+            std::move(fn)};
+  int thread_id = CurrentThreadId();
+  if (thread_id < 0) {
+    // A free-standing thread, spread the tasks over all queues.
+    thread_id = static_cast<int>(
+        next_queue_.fetch_add(1, std::memory_order_relaxed) % num_threads_);
+  }
+  Push(thread_id, std::move(task));
+  ec_.Notify(false);
+}
+
+void PriorityThreadPool::Cancel() {
+  cancelled_ = true;
+  done_ = true;
+  ec_.Notify(true);
+}
+
+void PriorityThreadPool::WaitThreadsExit() {
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_[i].thread->WaitExit();
+  }
+}
+
+WorkQueueStats PriorityThreadPool::GetStats() const {
+  WorkQueueStats stats;
+  for (int i = 0; i < num_threads_; ++i) {
+    const WorkerData& worker = workers_[i];
+    stats.executed_tasks +=
+        worker.executed_tasks.load(std::memory_order_relaxed);
+    stats.stolen_tasks += worker.stolen_tasks.load(std::memory_order_relaxed);
+    stats.idle_waits += worker.idle_waits.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+void PriorityThreadPool::Push(int thread_id, Task task) {
+  WorkerData& worker = workers_[thread_id];
+  std::lock_guard<std::mutex> guard(worker.mu);
+  worker.heap.emplace_back(std::move(task));
+  std::push_heap(worker.heap.begin(), worker.heap.end(), TaskRunsLater());
+  worker.head_priority.store(worker.heap.front().priority,
+                             std::memory_order_release);
+}
+
+bool PriorityThreadPool::TryPop(int thread_id, Task* task) {
+  WorkerData& worker = workers_[thread_id];
+  std::lock_guard<std::mutex> guard(worker.mu);
+  if (worker.heap.empty()) {
+    return false;
+  }
+  std::pop_heap(worker.heap.begin(), worker.heap.end(), TaskRunsLater());
+  *task = std::move(worker.heap.back());
+  worker.heap.pop_back();
+  worker.head_priority.store(
+      worker.heap.empty() ? kNoTask : worker.heap.front().priority,
+      std::memory_order_release);
+  return true;
+}
+
+bool PriorityThreadPool::PopBest(int thread_id, Task* task) {
+  // The peek is racy, a failed pop just falls back to the next candidate.
+  for (int retry = 0; retry < num_threads_; ++retry) {
+    int victim = thread_id;
+    int64_t best = workers_[thread_id].head_priority.load(
+        std::memory_order_acquire);
+    for (int i = 1; i < num_threads_; ++i) {
+      int idx = (thread_id + i) % num_threads_;
+      int64_t priority =
+          workers_[idx].head_priority.load(std::memory_order_acquire);
+      if (priority < best) {
+        best = priority;
+        victim = idx;
+      }
+    }
+    if (best == kNoTask) {
+      return false;
+    }
+    if (!TryPop(victim, task)) {
+      continue;
+    }
+    if (victim != thread_id) {
+      workers_[thread_id].stolen_tasks.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+  return false;
+}
+
+bool PriorityThreadPool::HasTask() const {
+  for (int i = 0; i < num_threads_; ++i) {
+    std::lock_guard<std::mutex> guard(workers_[i].mu);
+    if (!workers_[i].heap.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int PriorityThreadPool::CurrentThreadId() const {
+  const PerThread* pt = GetPerThread();
+  return pt->pool == this ? pt->thread_id : -1;
+}
+
+void PriorityThreadPool::WorkerLoop(int thread_id) {
+  std::string thr_name = name_ + "_thread_" + std::to_string(thread_id);
+  VLOG(1) << thr_name << " started ";
+  platform::SetCurrentThreadName(thr_name);
+  PerThread* pt = GetPerThread();
+  pt->pool = this;
+  pt->thread_id = thread_id;
+  EventCount::Waiter* waiter = ec_.GetWaiter(thread_id);
+  const int spin_count =
+      allow_spinning_ && num_threads_ > 0 ? 5000 / num_threads_ : 0;
+  WorkerData& worker = workers_[thread_id];
+
+  while (!cancelled_) {
+    Task task;
+    bool found = PopBest(thread_id, &task);
+    for (int i = 0; i < spin_count && !found; ++i) {
+      if (cancelled_.load(std::memory_order_relaxed)) {
+        return;
+      }
+      found = PopBest(thread_id, &task);
+    }
+    if (!found) {
+      if (!WaitForWork(waiter, thread_id)) {
+        return;
+      }
+      continue;
+    }
+    task.fn();
+    worker.executed_tasks.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool PriorityThreadPool::WaitForWork(EventCount::Waiter* waiter,
+                                     int thread_id) {
+  ec_.Prewait();
+  if (cancelled_) {
+    ec_.CancelWait();
+    return false;
+  }
+  // Reliable emptiness check after Prewait, see EventCount.
+  if (HasTask()) {
+    ec_.CancelWait();
+    return true;
+  }
+  // Tasks are only added by the running tasks after the pool starts
+  // destructing, and those go to the queue of the adding worker itself, so an
+  // empty pool is a stable termination state.
+  if (done_) {
+    ec_.CancelWait();
+    ec_.Notify(true);
+    return false;
+  }
+  workers_[thread_id].idle_waits.fetch_add(1, std::memory_order_relaxed);
+  platform::RecordEvent record(
+      "WaitForWork", platform::TracerEventType::UserDefined, 10);
+  ec_.CommitWait(waiter);
+  return true;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,120 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/workqueue/event_count.h"
+#include "paddle/fluid/framework/new_executor/workqueue/thread_environment.h"
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
+
+namespace paddle {
+namespace framework {
+
+// A thread pool in which every worker owns a priority queue of tasks.
+// A lower priority value means the task should run earlier, tasks with the
+// same priority run in FIFO order. Before running a task, a worker peeks the
+// head of all queues and takes the most urgent one, so idle workers steal
+// from their peers and the pool as a whole follows one consistent priority
+// order instead of the per-queue order of NonblockingThreadPool.
+class PriorityThreadPool {
+ public:
+  PriorityThreadPool(const std::string& name,
+                     int num_threads,
+                     bool allow_spinning);
+
+  ~PriorityThreadPool();
+
+  PriorityThreadPool(const PriorityThreadPool&) = delete;
+
+  PriorityThreadPool& operator=(const PriorityThreadPool&) = delete;
+
+  void AddTask(std::function<void()> fn, int64_t priority);
+
+  void Cancel();
+
+  void WaitThreadsExit();
+
+  size_t NumThreads() const { return num_threads_; }
+
+  WorkQueueStats GetStats() const;
+
+ private:
+  static constexpr int64_t kNoTask = std::numeric_limits<int64_t>::max();
+
+  struct Task {
+    int64_t priority;
+    uint64_t seq;
+    std::function<void()> fn;
+  };
+
+  // std heap algorithms build a max-heap, so "less" means "runs later"
+  struct TaskRunsLater {
+    bool operator()(const Task& lhs, const Task& rhs) const {
+      if (lhs.priority != rhs.priority) {
+        return lhs.priority > rhs.priority;
+      }
+      return lhs.seq > rhs.seq;
+    }
+  };
+
+  // Align to 128 byte boundary to prevent false sharing between workers.
+  struct alignas(128) WorkerData {
+    std::unique_ptr<StlThreadEnvironment::EnvThread> thread;
+    std::mutex mu;
+    std::vector<Task> heap;
+    // priority of the head of heap, read by other workers without locking
+    std::atomic<int64_t> head_priority{kNoTask};
+    std::atomic<uint64_t> executed_tasks{0};
+    std::atomic<uint64_t> stolen_tasks{0};
+    std::atomic<uint64_t> idle_waits{0};
+  };
+
+  void WorkerLoop(int thread_id);
+
+  void Push(int thread_id, Task task);
+
+  bool TryPop(int thread_id, Task* task);
+
+  // Pop the most urgent task among all queues, prefer the own queue of
+  // thread_id when priorities tie.
+  bool PopBest(int thread_id, Task* task);
+
+  bool HasTask() const;
+
+  bool WaitForWork(EventCount::Waiter* waiter, int thread_id);
+
+  int CurrentThreadId() const;
+
+  const std::string name_;
+  const int num_threads_;
+  const bool allow_spinning_;
+  std::atomic<bool> done_{false};
+  std::atomic<bool> cancelled_{false};
+  std::atomic<uint64_t> next_seq_{0};
+  std::atomic<uint64_t> next_queue_{0};
+  EventCount ec_;
+  std::unique_ptr<WorkerData[]> workers_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -7,6 +7,7 @@
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
 
 #include "paddle/fluid/framework/new_executor/workqueue/nonblocking_threadpool.h"
+#include "paddle/fluid/framework/new_executor/workqueue/priority_threadpool.h"
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue_utils.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
@@ -29,6 +30,12 @@ void WorkQueueOptions::Validate() const {
       false,
       platform::errors::InvalidArgument("WorkQueueOptions.allow_spinning must "
                                         "be true when always_spinning is set"));
+  PADDLE_ENFORCE_EQ(
+      priority_scheduling == true && always_spinning == true,
+      false,
+      platform::errors::InvalidArgument(
+          "WorkQueueOptions.always_spinning is not supported when "
+          "priority_scheduling is set"));
 }
 
 namespace {
@@ -98,15 +105,26 @@ class WorkQueueGroupImpl : public WorkQueueGroup {
 
   void AddTask(size_t queue_idx, std::function<void()> fn) override;
 
+  void AddTaskWithPriority(size_t queue_idx,
+                           int64_t priority,
+                           std::function<void()> fn) override;
+
   size_t QueueNumThreads(size_t queue_idx) const override;
 
   size_t QueueGroupNumThreads() const override;
 
+  WorkQueueStats QueueStats(size_t queue_idx) const override;
+
   void Cancel() override;
 
  private:
+  std::function<void()> WrapTask(size_t queue_idx, std::function<void()> fn);
+
   std::vector<NonblockingThreadPool*> queues_;
   NonblockingThreadPool* queues_storage_;
+  // queues created with WorkQueueOptions.priority_scheduling, the
+  // corresponding entries in queues_ are nullptr
+  std::vector<std::unique_ptr<PriorityThreadPool>> priority_queues_;
   TaskTracker* tracker_;
   std::shared_ptr<EventsWaiter::EventNotifier> empty_notifier_;
   std::shared_ptr<EventsWaiter::EventNotifier> destruct_notifier_;
@@ -119,6 +137,7 @@ WorkQueueGroupImpl::WorkQueueGroupImpl(
       tracker_(nullptr) {
   size_t num_queues = queues_options_.size();
   queues_.resize(num_queues);
+  priority_queues_.resize(num_queues);
   void* buffer = malloc(sizeof(NonblockingThreadPool) * num_queues);  // NOLINT
   queues_storage_ = reinterpret_cast<NonblockingThreadPool*>(buffer);
 
@@ -139,6 +158,14 @@ WorkQueueGroupImpl::WorkQueueGroupImpl(
       destruct_notifier_ =
           options.events_waiter->RegisterEvent(kQueueDestructEvent);
     }
+    if (options.priority_scheduling) {
+      queues_[idx] = nullptr;
+      priority_queues_[idx] = std::make_unique<PriorityThreadPool>(
+          options.name,
+          static_cast<int>(options.num_threads),
+          options.allow_spinning);
+      continue;
+    }
     queues_[idx] = new (&queues_storage_[idx])
         NonblockingThreadPool(options.name,
                               static_cast<int>(options.num_threads),
@@ -153,6 +180,7 @@ WorkQueueGroupImpl::~WorkQueueGroupImpl() {
       queue->~NonblockingThreadPool();
     }
   }
+  priority_queues_.clear();
   if (tracker_ != nullptr) {
     tracker_->~TaskTracker();
     AlignedFree(tracker_);
@@ -163,24 +191,45 @@ WorkQueueGroupImpl::~WorkQueueGroupImpl() {
   }
 }
 
-void WorkQueueGroupImpl::AddTask(size_t queue_idx, std::function<void()> fn) {
-  platform::RecordEvent record("WorkQueue::AddTask",
-                               platform::TracerEventType::UserDefined,
-                               10 /*level*/);
+std::function<void()> WorkQueueGroupImpl::WrapTask(size_t queue_idx,
+                                                  std::function<void()> fn) {
   assert(queue_idx < queues_.size());
-  PADDLE_ENFORCE_NOT_NULL(
-      queues_.at(queue_idx),
+  PADDLE_ENFORCE_EQ(
+      queues_.at(queue_idx) != nullptr ||
+          priority_queues_.at(queue_idx) != nullptr,
+      true,
       platform::errors::NotFound("Workqueue of index %d is not initialized.",
                                  queue_idx));
   if (queues_options_.at(queue_idx).track_task) {
     fn = [task = std::move(fn),
           raii = CounterGuard<TaskTracker>(tracker_)]() mutable { task(); };
   }
-  queues_[queue_idx]->AddTask(std::move(fn));
+  return fn;
+}
+
+void WorkQueueGroupImpl::AddTask(size_t queue_idx, std::function<void()> fn) {
+  AddTaskWithPriority(queue_idx, 0, std::move(fn));
+}
+
+void WorkQueueGroupImpl::AddTaskWithPriority(size_t queue_idx,
+                                             int64_t priority,
+                                             std::function<void()> fn) {
+  platform::RecordEvent record("WorkQueue::AddTask",
+                               platform::TracerEventType::UserDefined,
+                               10 /*level*/);
+  fn = WrapTask(queue_idx, std::move(fn));
+  if (priority_queues_[queue_idx]) {
+    priority_queues_[queue_idx]->AddTask(std::move(fn), priority);
+  } else {
+    queues_[queue_idx]->AddTask(std::move(fn));
+  }
 }
 
 size_t WorkQueueGroupImpl::QueueNumThreads(size_t queue_idx) const {
   assert(queue_idx < queues_.size());
+  if (priority_queues_.at(queue_idx)) {
+    return priority_queues_.at(queue_idx)->NumThreads();
+  }
   if (!queues_.at(queue_idx)) {
     return 0;
   }
@@ -189,23 +238,41 @@ size_t WorkQueueGroupImpl::QueueNumThreads(size_t queue_idx) const {
 
 size_t WorkQueueGroupImpl::QueueGroupNumThreads() const {
   size_t total_num = 0;
-  for (auto queue : queues_) {
-    total_num += queue->NumThreads();
+  for (size_t idx = 0; idx < queues_.size(); ++idx) {
+    total_num += QueueNumThreads(idx);
   }
   return total_num;
 }
 
+WorkQueueStats WorkQueueGroupImpl::QueueStats(size_t queue_idx) const {
+  assert(queue_idx < queues_.size());
+  if (!priority_queues_.at(queue_idx)) {
+    return WorkQueueStats();
+  }
+  return priority_queues_.at(queue_idx)->GetStats();
+}
+
 void WorkQueueGroupImpl::Cancel() {
   for (auto queue : queues_) {
     if (queue) {
       queue->Cancel();
     }
   }
+  for (auto& queue : priority_queues_) {
+    if (queue) {
+      queue->Cancel();
+    }
+  }
   for (auto queue : queues_) {
     if (queue) {
       queue->WaitThreadsExit();
     }
   }
+  for (auto& queue : priority_queues_) {
+    if (queue) {
+      queue->WaitThreadsExit();
+    }
+  }
 }
 
 }  // namespace
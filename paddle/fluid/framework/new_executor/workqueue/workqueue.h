@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <future>
 #include <memory>
@@ -54,6 +55,14 @@ class FakeCopyable {
 
 class EventsWaiter;
 
+struct WorkQueueStats {
+  uint64_t executed_tasks{0};
+  // tasks popped from the queue of another worker
+  uint64_t stolen_tasks{0};
+  // times a worker found no task and went to sleep
+  uint64_t idle_waits{0};
+};
+
 struct WorkQueueOptions {
   WorkQueueOptions(const std::string& name,
                    size_t num_threads,
@@ -102,6 +111,10 @@ struct WorkQueueOptions {
   // false and set events_waiter.
   bool detached{true};
   EventsWaiter* events_waiter{nullptr};  // not owned
+  // Run tasks in the order of the priority given to AddTaskWithPriority,
+  // idle threads steal the most urgent task from the others. Only supported
+  // by WorkQueueGroup.
+  bool priority_scheduling{false};
 };
 
 class WorkQueue {
@@ -155,6 +168,14 @@ class WorkQueueGroup {
 
   virtual void AddTask(size_t queue_idx, std::function<void()> fn) = 0;
 
+  // A lower priority value runs earlier. The priority is ignored unless the
+  // queue is created with WorkQueueOptions.priority_scheduling.
+  virtual void AddTaskWithPriority(size_t queue_idx,
+                                   int64_t priority,
+                                   std::function<void()> fn) {
+    AddTask(queue_idx, std::move(fn));
+  }
+
   // Higher cost than AddTask
   template <typename F, typename... Args>
   std::future<typename std::result_of<F(Args...)>::type> AddAwaitableTask(
@@ -178,6 +199,11 @@ class WorkQueueGroup {
 
   virtual size_t QueueGroupNumThreads() const = 0;
 
+  // Scheduling statistics, only collected for priority scheduling queues.
+  virtual WorkQueueStats QueueStats(size_t queue_idx) const {
+    return WorkQueueStats();
+  }
+
   virtual void Cancel() = 0;
 
  protected:
@@ -0,0 +1,80 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/static_arena_planner.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace paddle {
+namespace framework {
+
+size_t PlanStaticArena(std::vector<ArenaBlock>* blocks, size_t alignment) {
+  auto& all = *blocks;
+  auto aligned = [alignment](size_t size) {
+    return (size + alignment - 1) / alignment * alignment;
+  };
+  std::vector<size_t> order(all.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&all](size_t a, size_t b) {
+    return all[a].size > all[b].size;
+  });
+
+  size_t arena_size = 0;
+  std::vector<size_t> placed;  // by offset
+  std::vector<size_t> live;
+  for (size_t idx : order) {
+    auto& block = all[idx];
+    block.offset = 0;
+    if (block.size == 0) {
+      continue;
+    }
+    size_t size = aligned(block.size);
+    live.clear();
+    for (size_t other : placed) {
+      if (all[other].begin <= block.end && block.begin <= all[other].end) {
+        live.push_back(other);
+      }
+    }
+    // the smallest gap that fits, the blocks of live are sorted by offset
+    bool found = false;
+    size_t best_gap = 0;
+    size_t gap_begin = 0;
+    for (size_t other : live) {
+      size_t offset = all[other].offset;
+      if (offset >= gap_begin + size &&
+          (!found || offset - gap_begin < best_gap)) {
+        found = true;
+        best_gap = offset - gap_begin;
+        block.offset = gap_begin;
+      }
+      gap_begin = std::max(gap_begin, offset + aligned(all[other].size));
+    }
+    if (!found) {
+      block.offset = gap_begin;
+    }
+    arena_size = std::max(arena_size, block.offset + size);
+    placed.insert(std::upper_bound(placed.begin(),
+                                   placed.end(),
+                                   idx,
+                                   [&all](size_t a, size_t b) {
+                                     return all[a].offset < all[b].offset;
+                                   }),
+                  idx);
+  }
+  return arena_size;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,45 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// The offsets of the blocks are aligned to it, enough for every device.
+constexpr size_t kStaticArenaAlignment = 256;
+
+// A tensor placed in a static arena, live from the op of index begin to the
+// op of index end, both included.
+struct ArenaBlock {
+  size_t size;
+  int begin;
+  int end;
+  size_t offset;  // set by PlanStaticArena
+};
+
+// Places the blocks in one arena so that the blocks of overlapping lifetimes
+// do not overlap in memory, and returns the size of the arena.
+//
+// The blocks are placed greedy by size: from the largest one, each block
+// takes the smallest gap between the placed blocks of overlapping lifetimes
+// that fits it, or the end of them. The blocks of size 0 are not placed.
+size_t PlanStaticArena(std::vector<ArenaBlock>* blocks,
+                       size_t alignment = kStaticArenaAlignment);
+
+}  // namespace framework
+}  // namespace paddle
@@ -21,6 +21,7 @@
 
 #include "glog/logging.h"
 #include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/static_arena_planner.h"
 #include "paddle/fluid/inference/analysis/pass_result_info.h"
 #include "paddle/fluid/platform/enforce.h"
 
@@ -281,6 +282,33 @@ void MemoryOptimizePass::RunImpl(Argument* argument) {
   pass_res_info->Set(
       argument->root_predictor_id(), "memory_optimize_pass", node2cluster);
 
+  // With the static arena, the executor places the tensors at the offsets of
+  // one arena planned for the sizes of the runs instead of the clusters.
+  if (argument->memory_optim_static_arena_valid() &&
+      argument->memory_optim_static_arena()) {
+    std::vector<std::string> arena_vars;
+    std::vector<framework::ArenaBlock> blocks;
+    size_t cluster_bytes = 0;
+    for (auto& item : lifecycles) {
+      if (!space_table.count(item.first)) continue;
+      arena_vars.push_back(item.first);
+      blocks.push_back({space_table.at(item.first),
+                        item.second.first,
+                        item.second.second,
+                        0});
+    }
+    for (auto& cluster : cluster_size) {
+      cluster_bytes += cluster.second;
+    }
+    size_t arena_bytes = framework::PlanStaticArena(&blocks);
+    LOG(INFO) << "Memory of the tensors at batch size 1: reuse clusters "
+              << cluster_bytes << " bytes, static arena " << arena_bytes
+              << " bytes";
+    pass_res_info->Set(argument->root_predictor_id(),
+                       "memory_optimize_pass_arena",
+                       arena_vars);
+  }
+
   return;
 }
 
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <tuple>
@@ -455,6 +456,11 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(enable_low_precision_io_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(memory_optim_static_arena_);
+  CP_MEMBER(shape_buckets_);
+  CP_MEMBER(shape_bucket_axis_);
+  CP_MEMBER(shape_bucket_inputs_);
+  CP_MEMBER(shape_bucket_outputs_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -1129,6 +1135,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << trt_dla_core_;
 
   ss << enable_memory_optim_;
+  ss << memory_optim_static_arena_;
   ss << trt_engine_memory_sharing_;
 
   ss << use_mkldnn_;
@@ -1239,6 +1246,47 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableMemoryOptimStaticArena(bool x) {
+  memory_optim_static_arena_ = x;
+  if (x) {
+    enable_memory_optim_ = true;
+  }
+  Update();
+}
+
+bool AnalysisConfig::memory_optim_static_arena() const {
+  return memory_optim_static_arena_;
+}
+
+void AnalysisConfig::EnableShapeBucketing(
+    const std::vector<int64_t> &buckets,
+    int axis,
+    const std::vector<std::string> &input_names,
+    const std::vector<std::string> &output_names) {
+  PADDLE_ENFORCE_GE(axis,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The axis of the shape bucketing must be "
+                        "non-negative, but received %d.",
+                        axis));
+  for (auto bucket : buckets) {
+    PADDLE_ENFORCE_GT(bucket,
+                      0,
+                      platform::errors::InvalidArgument(
+                          "The buckets of the shape bucketing must be "
+                          "positive, but received %d.",
+                          bucket));
+  }
+  shape_buckets_ = buckets;
+  std::sort(shape_buckets_.begin(), shape_buckets_.end());
+  shape_buckets_.erase(
+      std::unique(shape_buckets_.begin(), shape_buckets_.end()),
+      shape_buckets_.end());
+  shape_bucket_axis_ = axis;
+  shape_bucket_inputs_ = input_names;
+  shape_bucket_outputs_ = output_names;
+}
+
 bool AnalysisConfig::trt_engine_memory_sharing() const {
   return trt_engine_memory_sharing_;
 }
@@ -1472,6 +1520,16 @@ std::string AnalysisConfig::Summary() {
   os.InsertRow({"ir_optim", enable_ir_optim_ ? "true" : "false"});
   os.InsertRow({"ir_debug", ir_debug_ ? "true" : "false"});
   os.InsertRow({"memory_optim", enable_memory_optim_ ? "true" : "false"});
+  os.InsertRow({"memory_optim_static_arena",
+                memory_optim_static_arena_ ? "true" : "false"});
+  if (!shape_buckets_.empty()) {
+    std::string buckets;
+    for (auto bucket : shape_buckets_) {
+      buckets += (buckets.empty() ? "" : ", ") + std::to_string(bucket);
+    }
+    os.InsertRow({"shape_buckets", buckets});
+    os.InsertRow({"shape_bucket_axis", std::to_string(shape_bucket_axis_)});
+  }
   os.InsertRow({"enable_profile", with_profile_ ? "true" : "false"});
   os.InsertRow({"enable_log", with_glog_info_ ? "true" : "false"});
   os.InsertRow({"collect_shape_range_info",
@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <memory>
 #include <set>
@@ -65,6 +66,7 @@
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/enforce.h"
 #include "paddle/phi/core/generator.h"
+#include "paddle/phi/core/scope_guard.h"
 #include "paddle/phi/kernels/funcs/data_type_transform.h"
 #include "paddle/utils/string/split.h"
 
@@ -360,6 +362,29 @@ bool PaddleTensorToDenseTensor(const PaddleTensor &pt,
   t->set_lod(lod);
   return true;
 }
+
+// Copies src to dst on CPU, the dim axis is cut or padded with zeros to the
+// one of dst, the other dims of them are equal.
+void CopyAlongAxis(const phi::DenseTensor &src,
+                   int axis,
+                   phi::DenseTensor *dst) {
+  auto dims = src.dims();
+  int64_t outer = common::product(common::slice_ddim(dims, 0, axis));
+  size_t inner =
+      common::product(common::slice_ddim(dims, axis + 1, dims.size())) *
+      phi::SizeOf(src.dtype());
+  size_t src_row = dims[axis] * inner;
+  size_t dst_row = dst->dims()[axis] * inner;
+  size_t copied = std::min(src_row, dst_row);
+  auto *src_data = static_cast<const uint8_t *>(src.data());
+  auto *dst_data = static_cast<uint8_t *>(dst->data());
+  for (int64_t i = 0; i < outer; ++i) {
+    std::memcpy(dst_data + i * dst_row, src_data + i * src_row, copied);
+    if (dst_row > copied) {
+      std::memset(dst_data + i * dst_row + copied, 0, dst_row - copied);
+    }
+  }
+}
 }  // namespace
 
 AnalysisPredictor::AnalysisPredictor(const AnalysisConfig &config)
@@ -430,6 +455,7 @@ bool AnalysisPredictor::Init(
 
   // Get the feed_target_names and fetch_target_names
   PrepareFeedFetch();
+  PrepareShapeBucketVars();
 
   // Prepare executor, create local variables.
   if (!PrepareExecutor()) {
@@ -914,10 +940,16 @@ bool AnalysisPredictor::PrepareExecutor() {
   if (config_.enable_memory_optim_) {
     auto *pass_res_info =
         inference::analysis::PassResultInfoForRuntime::Instance();
-    auto reuse_table =
-        pass_res_info->Get<std::unordered_map<std::string, std::string>>(
-            root_predictor_id_, "memory_optimize_pass");
-    executor_->MakeReusePlan(reuse_table);
+    if (config_.memory_optim_static_arena_) {
+      auto arena_vars = pass_res_info->Get<std::vector<std::string>>(
+          root_predictor_id_, "memory_optimize_pass_arena");
+      executor_->MakeArenaPlan(arena_vars);
+    } else {
+      auto reuse_table =
+          pass_res_info->Get<std::unordered_map<std::string, std::string>>(
+              root_predictor_id_, "memory_optimize_pass");
+      executor_->MakeReusePlan(reuse_table);
+    }
   }
 
   return true;
@@ -1315,6 +1347,7 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
   } else {
     // Run the inference program
     // if share variables, we need not create variables
+    SetArenaBucket();
     executor_->Run();
   }
 
@@ -1388,6 +1421,7 @@ bool AnalysisPredictor::Run(const std::vector<paddle::Tensor> &inputs,
   } else {
     // Run the inference program
     // if share variables, we need not create variables
+    SetArenaBucket();
     executor_->Run();
   }
 
@@ -1583,6 +1617,7 @@ void AnalysisPredictor::PrepareArgument() {
   argument_->SetGPUDeviceId(config_.gpu_device_id());
   argument_->SetEnableIrOptim(config_.enable_ir_optim_);
   argument_->SetEnableMemoryOptim(config_.enable_memory_optim());
+  argument_->SetMemoryOptimStaticArena(config_.memory_optim_static_arena());
   argument_->SetModelFromMemory(config_.model_from_memory_);
   // Analyze inference_program
   argument_->SetPredictorID(predictor_id_);
@@ -2332,6 +2367,9 @@ bool AnalysisPredictor::ZeroCopyRun(bool switch_stream) {
     paddle::platform::DeviceContextPool::SetDeviceContexts(&device_contexts_);
   }
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  // the user inputs are given back even if the run throws
+  DEFINE_PADDLE_SCOPE_GUARD([this] { RestoreShapeBucketInputs(); });
+  PadInputsToShapeBucket();
 #ifdef PADDLE_WITH_DNNL
   if (config_.use_mkldnn_) {
     std::vector<std::vector<int>> shape_vector;
@@ -2384,9 +2422,11 @@ bool AnalysisPredictor::ZeroCopyRun(bool switch_stream) {
   if (config_.new_executor_enabled()) {
     executor_->RunInterpreterCore({}, false, switch_stream);
   } else {
+    SetArenaBucket();
     executor_->Run();
   }
   inference::DisplayMemoryInfo(place_, "after run");
+  SliceOutputsFromShapeBucket();
 
 #ifdef PADDLE_WITH_XPU
   if (config_.use_xpu_ && !config_.use_lite_ && infer_xpu_ctx != nullptr) {
@@ -2459,6 +2499,168 @@ bool AnalysisPredictor::ExpRunWithExternalStream(const gpuStream_t stream) {
 }
 #endif
 
+void AnalysisPredictor::SetArenaBucket() {
+  if (!config_.enable_memory_optim_ || !config_.memory_optim_static_arena_) {
+    return;
+  }
+  // the dims are rounded up to powers of 2, so that the close shapes share
+  // the arena planned for the larger ones
+  uint64_t bucket = 0;
+  auto *scope = executor_->GetScope();
+  for (auto &item : feed_names_) {
+    auto *var = scope->FindVar(item.first);
+    if (!var || !var->IsType<phi::DenseTensor>()) continue;
+    auto dims = var->Get<phi::DenseTensor>().dims();
+    for (int i = 0; i < dims.size(); ++i) {
+      uint64_t dim = 1;
+      while (static_cast<int64_t>(dim) < dims[i]) dim <<= 1;
+      // a shape bucket keeps its own arena
+      if (shape_bucket_ > 0 && i == config_.shape_bucket_axis_ &&
+          dims[i] == shape_bucket_) {
+        dim = shape_bucket_;
+      }
+      bucket = bucket * 1000003 + dim;
+    }
+    bucket = bucket * 1000003 + dims.size();
+  }
+  executor_->SetArenaBucket(bucket);
+}
+
+void AnalysisPredictor::PadInputsToShapeBucket() {
+  shape_bucket_ = 0;
+  if (!config_.shape_bucketing_enabled()) return;
+  const int axis = config_.shape_bucket_axis_;
+  auto *scope = executor_->GetScope();
+  std::vector<std::pair<std::string, phi::DenseTensor *>> inputs;
+  int64_t len = 0;
+  for (auto &item : feed_names_) {
+    if (!shape_bucket_inputs_.count(item.first)) continue;
+    auto *var = scope->FindVar(item.first);
+    if (!var || !var->IsType<phi::DenseTensor>()) continue;
+    auto *tensor = var->GetMutable<phi::DenseTensor>();
+    if (!tensor->initialized() || tensor->dims().size() <= axis ||
+        !tensor->lod().empty()) {
+      continue;
+    }
+    if (!platform::is_cpu_place(tensor->place())) {
+      LOG_FIRST_N(WARNING, 1)
+          << "The shape bucketing pads the inputs on CPU only, the runs of "
+             "the input "
+          << item.first << " on " << tensor->place() << " are not padded.";
+      return;
+    }
+    inputs.emplace_back(item.first, tensor);
+    len = std::max(len, tensor->dims()[axis]);
+  }
+  if (inputs.empty()) return;
+
+  const auto &buckets = config_.shape_buckets();
+  auto it = std::lower_bound(buckets.begin(), buckets.end(), len);
+  if (it == buckets.end()) {
+    ++shape_bucket_hits_[-1];
+    return;
+  }
+  ++shape_bucket_hits_[*it];
+  shape_bucket_len_ = len;
+  shape_bucket_ = *it;
+  VLOG(3) << "ZeroCopyRun pads the length " << len << " to the bucket "
+          << shape_bucket_;
+
+  for (auto &input : inputs) {
+    auto *tensor = input.second;
+    if (tensor->dims()[axis] == shape_bucket_) continue;
+    auto &padded = shape_bucket_padded_[input.first];
+    auto dims = tensor->dims();
+    dims[axis] = shape_bucket_;
+    padded.Resize(dims);
+    padded.mutable_data(platform::CPUPlace(), tensor->dtype());
+    CopyAlongAxis(*tensor, axis, &padded);
+    shape_bucket_user_inputs_.emplace_back(tensor, *tensor);
+    *tensor = padded;
+  }
+  // the outputs are written to their padded tensors of the last run rather
+  // than to the smaller sliced ones
+  for (auto &item : idx2fetches_) {
+    auto padded = shape_bucket_padded_.find(item.second);
+    auto *var = scope->FindVar(item.second);
+    if (padded == shape_bucket_padded_.end() || !var ||
+        !var->IsType<phi::DenseTensor>()) {
+      continue;
+    }
+    *var->GetMutable<phi::DenseTensor>() = padded->second;
+  }
+}
+
+void AnalysisPredictor::RestoreShapeBucketInputs() {
+  for (auto &input : shape_bucket_user_inputs_) {
+    *input.first = input.second;
+  }
+  shape_bucket_user_inputs_.clear();
+}
+
+void AnalysisPredictor::SliceOutputsFromShapeBucket() {
+  RestoreShapeBucketInputs();
+  if (shape_bucket_ == 0 || shape_bucket_ == shape_bucket_len_) return;
+  const int axis = config_.shape_bucket_axis_;
+  auto *scope = executor_->GetScope();
+  for (auto &item : idx2fetches_) {
+    if (!shape_bucket_outputs_.count(item.second)) continue;
+    auto *var = scope->FindVar(item.second);
+    if (!var || !var->IsType<phi::DenseTensor>()) continue;
+    auto *tensor = var->GetMutable<phi::DenseTensor>();
+    if (!tensor->initialized() || tensor->dims().size() <= axis ||
+        tensor->dims()[axis] != shape_bucket_ ||
+        !platform::is_cpu_place(tensor->place())) {
+      continue;
+    }
+    shape_bucket_padded_[item.second] = *tensor;
+    auto &sliced = shape_bucket_sliced_[item.second];
+    auto dims = tensor->dims();
+    dims[axis] = shape_bucket_len_;
+    sliced.Resize(dims);
+    sliced.mutable_data(platform::CPUPlace(), tensor->dtype());
+    CopyAlongAxis(*tensor, axis, &sliced);
+    *tensor = sliced;
+  }
+}
+
+void AnalysisPredictor::PrepareShapeBucketVars() {
+  shape_bucket_inputs_.clear();
+  shape_bucket_outputs_.clear();
+  if (!config_.shape_bucketing_enabled()) return;
+  // an input or output whose dim axis is fixed in the model is never padded
+  // or sliced, even if it happens to equal the length of the run
+  const int axis = config_.shape_bucket_axis_;
+  auto &block = inference_program_->Block(0);
+  auto dynamic_along_axis = [&](const std::string &name) {
+    auto *var_desc = block.FindVar(name);
+    if (!var_desc) return false;
+    auto shape = var_desc->GetShape();
+    return static_cast<int>(shape.size()) > axis && shape[axis] < 0;
+  };
+
+  const auto &input_names = config_.shape_bucket_inputs_;
+  if (!input_names.empty()) {
+    shape_bucket_inputs_.insert(input_names.begin(), input_names.end());
+  } else {
+    for (auto &item : feed_names_) {
+      if (dynamic_along_axis(item.first)) {
+        shape_bucket_inputs_.insert(item.first);
+      }
+    }
+  }
+  const auto &output_names = config_.shape_bucket_outputs_;
+  if (!output_names.empty()) {
+    shape_bucket_outputs_.insert(output_names.begin(), output_names.end());
+  } else {
+    for (auto &item : idx2fetches_) {
+      if (dynamic_along_axis(item.second)) {
+        shape_bucket_outputs_.insert(item.second);
+      }
+    }
+  }
+}
+
 void AnalysisPredictor::HookCollectShapeRangeInfo() {
   if (config_.new_executor_enabled()) {
     LOG_FIRST_N(WARNING, 1)
@@ -3305,6 +3507,11 @@ void Predictor::ClearIntermediateTensor() {
 
 uint64_t Predictor::TryShrinkMemory() { return predictor_->TryShrinkMemory(); }
 
+std::map<int64_t, uint64_t> Predictor::GetShapeBucketHits() {
+  auto *pred = dynamic_cast<paddle::AnalysisPredictor *>(predictor_.get());
+  return pred ? pred->GetShapeBucketHits() : std::map<int64_t, uint64_t>();
+}
+
 void Predictor::RegisterOutputHook(const OutputTensorHookFunc &hookfunc) {
   predictor_->RegisterOutputHook(hookfunc);
 }
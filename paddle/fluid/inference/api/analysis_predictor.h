@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -268,6 +269,17 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   uint64_t TryShrinkMemory() override;
 
+  ///
+  /// \brief Get the runs of ZeroCopyRun of every bucket of the shape
+  /// bucketing, the runs longer than the largest bucket are counted under
+  /// the key -1.
+  ///
+  /// \return The runs of the buckets.
+  ///
+  std::map<int64_t, uint64_t> GetShapeBucketHits() const {
+    return shape_bucket_hits_;
+  }
+
   ///
   /// \brief Get the argument used by predictor
   ///
@@ -491,6 +503,20 @@ class AnalysisPredictor : public PaddlePredictor {
  private:
   void StatisticShapeRangeInfo();
   void HookCollectShapeRangeInfo();
+  // Sets the bucket of the input shapes of the run for the static arena of
+  // the memory optimize.
+  void SetArenaBucket();
+  // Pads the inputs of the run to the shape bucket of the config, and gives
+  // the outputs their padded tensors of the last run of a bucket.
+  void PadInputsToShapeBucket();
+  // Gives the inputs padded by PadInputsToShapeBucket back to the user.
+  void RestoreShapeBucketInputs();
+  // Slices the outputs of the run back from the shape bucket and gives the
+  // inputs back.
+  void SliceOutputsFromShapeBucket();
+  // Picks the inputs to pad and the outputs to slice from the config, or from
+  // the model if the config names none.
+  void PrepareShapeBucketVars();
   void InitPlace();
   void InitDeviceContexts();
   void InitResourceManager(void *stream);
@@ -600,6 +626,22 @@ class AnalysisPredictor : public PaddlePredictor {
   std::map<phi::Place, std::shared_future<std::unique_ptr<phi::DeviceContext>>>
       device_contexts_;
 
+  // The shape bucketing of ZeroCopyRun: the length and the bucket of the
+  // run, the bucket is 0 if the run is not padded.
+  int64_t shape_bucket_len_{0};
+  int64_t shape_bucket_{0};
+  std::map<int64_t, uint64_t> shape_bucket_hits_;
+  // The padded tensors of the inputs and the outputs, and the sliced ones of
+  // the outputs, kept so that the runs of a bucket do not allocate them.
+  std::map<std::string, phi::DenseTensor> shape_bucket_padded_;
+  std::map<std::string, phi::DenseTensor> shape_bucket_sliced_;
+  // The inputs padded to the bucket and the outputs sliced back from it.
+  std::set<std::string> shape_bucket_inputs_;
+  std::set<std::string> shape_bucket_outputs_;
+  // The input tensors given by the user during a padded run.
+  std::vector<std::pair<phi::DenseTensor *, phi::DenseTensor>>
+      shape_bucket_user_inputs_;
+
 #if defined(PADDLE_WITH_DISTRIBUTE) && defined(PADDLE_WITH_PSCORE)
   // fleet executor related
   distributed::FleetExecutorDesc executor_desc_;
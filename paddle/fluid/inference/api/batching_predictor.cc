@@ -0,0 +1,554 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle_infer {
+namespace services {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename T>
+struct HostCopier {
+  static void FromHost(Tensor* tensor, const void* data) {
+    tensor->CopyFromCpu(static_cast<const T*>(data));
+  }
+  static void ToHost(Tensor* tensor, void* data) {
+    tensor->CopyToCpu(static_cast<T*>(data));
+  }
+};
+
+template <template <typename> class Functor, typename... Args>
+void VisitDataType(DataType dtype, Args... args) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      return Functor<float>::Run(args...);
+    case DataType::FLOAT64:
+      return Functor<double>::Run(args...);
+    case DataType::INT64:
+      return Functor<int64_t>::Run(args...);
+    case DataType::INT32:
+      return Functor<int32_t>::Run(args...);
+    case DataType::UINT8:
+      return Functor<uint8_t>::Run(args...);
+    case DataType::INT8:
+      return Functor<int8_t>::Run(args...);
+    case DataType::FLOAT16:
+      return Functor<phi::dtype::float16>::Run(args...);
+    case DataType::BFLOAT16:
+      return Functor<phi::dtype::bfloat16>::Run(args...);
+    case DataType::BOOL:
+      return Functor<bool>::Run(args...);
+    default:
+      PADDLE_THROW(paddle::platform::errors::Unimplemented(
+          "The data type %d is not supported by BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+template <typename T>
+struct CopyFromHostFunctor {
+  static void Run(Tensor* tensor, const void* data) {
+    HostCopier<T>::FromHost(tensor, data);
+  }
+};
+
+template <typename T>
+struct CopyToHostFunctor {
+  static void Run(Tensor* tensor, void* data) {
+    HostCopier<T>::ToHost(tensor, data);
+  }
+};
+
+int64_t Numel(const std::vector<int>& shape) {
+  int64_t numel = 1;
+  for (int dim : shape) {
+    numel *= dim;
+  }
+  return numel;
+}
+
+int64_t ElapsedUs(Clock::time_point start, Clock::time_point end) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+      .count();
+}
+
+// Latencies are counted in buckets of a quarter of a power of two.
+constexpr int kLatencyBucketsPerPow2 = 4;
+constexpr int kLatencyBucketNum = 40 * kLatencyBucketsPerPow2;
+
+int LatencyBucket(int64_t us) {
+  if (us <= 1) {
+    return 0;
+  }
+  int bucket = static_cast<int>(std::log2(static_cast<double>(us)) *
+                                kLatencyBucketsPerPow2);
+  return std::min(bucket, kLatencyBucketNum - 1);
+}
+
+double LatencyBucketUpperBound(int bucket) {
+  return std::exp2(static_cast<double>(bucket + 1) / kLatencyBucketsPerPow2);
+}
+
+// Checks the options before the predictor pool is created from them.
+const BatchingOptions& CheckOptions(const BatchingOptions& options) {
+  PADDLE_ENFORCE_GT(options.num_predictors,
+                    0UL,
+                    paddle::platform::errors::InvalidArgument(
+                        "The number of predictors should be greater than 0, "
+                        "but received %d.",
+                        options.num_predictors));
+  PADDLE_ENFORCE_GT(options.max_batch_size,
+                    0,
+                    paddle::platform::errors::InvalidArgument(
+                        "The max batch size should be greater than 0, but "
+                        "received %d.",
+                        options.max_batch_size));
+  PADDLE_ENFORCE_GE(options.max_wait_us,
+                    0,
+                    paddle::platform::errors::InvalidArgument(
+                        "The max wait time should not be negative, but "
+                        "received %d.",
+                        options.max_wait_us));
+  return options;
+}
+
+}  // namespace
+
+class BatchingPredictor::Impl {
+ public:
+  Impl(const Config& config, const BatchingOptions& options)
+      : options_(CheckOptions(options)),
+        pool_(config, options.num_predictors) {
+    input_names_ = pool_.Retrieve(0)->GetInputNames();
+    output_names_ = pool_.Retrieve(0)->GetOutputNames();
+    stats_start_ = Clock::now();
+    for (size_t i = 0; i < options.num_predictors; ++i) {
+      workers_.emplace_back([this, i]() { WorkerLoop(pool_.Retrieve(i)); });
+    }
+  }
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  bool Run(const std::vector<paddle::PaddleTensor>& inputs,
+           std::vector<paddle::PaddleTensor>* outputs) {
+    PADDLE_ENFORCE_NOT_NULL(outputs,
+                            paddle::platform::errors::InvalidArgument(
+                                "The outputs should not be nullptr."));
+    Request request;
+    request.outputs = outputs;
+    Prepare(inputs, &request);
+    std::future<bool> done = request.done.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_) {
+        return false;
+      }
+      queue_.push_back(&request);
+    }
+    cond_.notify_all();
+    return done.get();
+  }
+
+  const std::vector<std::string>& input_names() const { return input_names_; }
+
+  const std::vector<std::string>& output_names() const {
+    return output_names_;
+  }
+
+  BatchingStats GetStats() const {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    BatchingStats stats;
+    stats.request_num = request_num_;
+    stats.failed_request_num = failed_request_num_;
+    stats.batch_num = batch_num_;
+    stats.sample_num = sample_num_;
+    if (batch_num_ > 0) {
+      stats.avg_batch_size = static_cast<double>(sample_num_) / batch_num_;
+      stats.avg_run_us = static_cast<double>(total_run_us_) / batch_num_;
+    }
+    if (request_num_ > 0) {
+      stats.avg_queue_us = static_cast<double>(total_queue_us_) / request_num_;
+      stats.avg_latency_us =
+          static_cast<double>(total_latency_us_) / request_num_;
+      stats.p50_latency_us = LatencyPercentile(0.5);
+      stats.p99_latency_us = LatencyPercentile(0.99);
+      stats.max_latency_us = static_cast<double>(max_latency_us_);
+    }
+    double seconds =
+        static_cast<double>(ElapsedUs(stats_start_, Clock::now())) / 1e6;
+    if (seconds > 0) {
+      stats.throughput = static_cast<double>(sample_num_) / seconds;
+    }
+    return stats;
+  }
+
+  void ResetStats() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    request_num_ = 0;
+    failed_request_num_ = 0;
+    batch_num_ = 0;
+    sample_num_ = 0;
+    total_queue_us_ = 0;
+    total_run_us_ = 0;
+    total_latency_us_ = 0;
+    max_latency_us_ = 0;
+    std::fill(latency_buckets_.begin(), latency_buckets_.end(), 0);
+    stats_start_ = Clock::now();
+  }
+
+ private:
+  struct Request {
+    // inputs in the order of input_names_
+    std::vector<const paddle::PaddleTensor*> inputs;
+    std::vector<paddle::PaddleTensor>* outputs;
+    int batch_size{0};
+    // the data types and the dimensions except the first of the inputs,
+    // requests can be batched together only if their signatures are equal
+    std::vector<int> signature;
+    Clock::time_point submit_time;
+    std::promise<bool> done;
+  };
+
+  void Prepare(const std::vector<paddle::PaddleTensor>& inputs,
+               Request* request) const {
+    PADDLE_ENFORCE_EQ(inputs.size(),
+                      input_names_.size(),
+                      paddle::platform::errors::InvalidArgument(
+                          "The model has %d inputs, but %d are given.",
+                          input_names_.size(),
+                          inputs.size()));
+    request->inputs.resize(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      size_t idx = i;
+      if (!inputs[i].name.empty()) {
+        auto it = std::find(
+            input_names_.begin(), input_names_.end(), inputs[i].name);
+        PADDLE_ENFORCE_NE(it,
+                          input_names_.end(),
+                          paddle::platform::errors::InvalidArgument(
+                              "The model has no input named %s.",
+                              inputs[i].name));
+        idx = it - input_names_.begin();
+      }
+      request->inputs[idx] = &inputs[i];
+    }
+    for (size_t i = 0; i < request->inputs.size(); ++i) {
+      const auto* input = request->inputs[i];
+      PADDLE_ENFORCE_NOT_NULL(input,
+                              paddle::platform::errors::InvalidArgument(
+                                  "The input %s is not given.",
+                                  input_names_[i]));
+      PADDLE_ENFORCE_EQ(input->lod.empty(),
+                        true,
+                        paddle::platform::errors::InvalidArgument(
+                            "The input %s has lod, which can not be batched.",
+                            input_names_[i]));
+      PADDLE_ENFORCE_GT(input->shape.size(),
+                        0UL,
+                        paddle::platform::errors::InvalidArgument(
+                            "The input %s should have the batch dimension.",
+                            input_names_[i]));
+      PADDLE_ENFORCE_EQ(
+          input->data.length(),
+          Numel(input->shape) * GetNumBytesOfDataType(input->dtype),
+          paddle::platform::errors::InvalidArgument(
+              "The data size of input %s does not match its shape.",
+              input_names_[i]));
+      if (i == 0) {
+        request->batch_size = input->shape[0];
+        PADDLE_ENFORCE_GT(request->batch_size,
+                          0,
+                          paddle::platform::errors::InvalidArgument(
+                              "The input %s should have at least one sample, "
+                              "but its batch dimension is %d.",
+                              input_names_[i],
+                              request->batch_size));
+      }
+      PADDLE_ENFORCE_EQ(input->shape[0],
+                        request->batch_size,
+                        paddle::platform::errors::InvalidArgument(
+                            "The inputs of a request should have the same "
+                            "batch size, but input %s has %d samples while "
+                            "input %s has %d.",
+                            input_names_[i],
+                            input->shape[0],
+                            input_names_[0],
+                            request->batch_size));
+      request->signature.push_back(static_cast<int>(input->dtype));
+      request->signature.push_back(static_cast<int>(input->shape.size()));
+      request->signature.insert(request->signature.end(),
+                                input->shape.begin() + 1,
+                                input->shape.end());
+    }
+    request->submit_time = Clock::now();
+  }
+
+  // The number of pending samples which can be batched with front.
+  int CompatibleSamples(const Request& front) const {
+    int samples = 0;
+    for (const Request* request : queue_) {
+      if (request->signature == front.signature) {
+        samples += request->batch_size;
+        if (samples >= options_.max_batch_size) {
+          break;
+        }
+      }
+    }
+    return samples;
+  }
+
+  // Take the front request and the following compatible requests up to
+  // max_batch_size samples out of the queue.
+  void TakeBatch(std::vector<Request*>* batch) {
+    Request* front = queue_.front();
+    queue_.pop_front();
+    batch->push_back(front);
+    int samples = front->batch_size;
+    for (auto it = queue_.begin(); it != queue_.end();) {
+      if (samples >= options_.max_batch_size) {
+        break;
+      }
+      Request* request = *it;
+      if (request->signature == front->signature &&
+          samples + request->batch_size <= options_.max_batch_size) {
+        batch->push_back(request);
+        samples += request->batch_size;
+        it = queue_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void WorkerLoop(Predictor* predictor) {
+    std::vector<Request*> batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      if (queue_.empty()) {
+        if (stop_) {
+          return;
+        }
+        cond_.wait(lock);
+        continue;
+      }
+      const Request& front = *queue_.front();
+      auto deadline =
+          front.submit_time + std::chrono::microseconds(options_.max_wait_us);
+      if (!stop_ && Clock::now() < deadline &&
+          CompatibleSamples(front) < options_.max_batch_size) {
+        cond_.wait_until(lock, deadline);
+        continue;
+      }
+      TakeBatch(&batch);
+      lock.unlock();
+      RunBatch(predictor, batch);
+      batch.clear();
+      lock.lock();
+    }
+  }
+
+  void RunBatch(Predictor* predictor, const std::vector<Request*>& batch) {
+    auto start_time = Clock::now();
+    int batch_size = 0;
+    for (const Request* request : batch) {
+      batch_size += request->batch_size;
+    }
+    bool success = true;
+    try {
+      for (size_t i = 0; i < input_names_.size(); ++i) {
+        const auto* first = batch[0]->inputs[i];
+        std::vector<int> shape = first->shape;
+        shape[0] = batch_size;
+        auto handle = predictor->GetInputHandle(input_names_[i]);
+        handle->Reshape(shape);
+        if (batch.size() == 1) {
+          VisitDataType<CopyFromHostFunctor>(
+              first->dtype, handle.get(), first->data.data());
+          continue;
+        }
+        input_buffer_.resize(Numel(shape) *
+                             GetNumBytesOfDataType(first->dtype));
+        char* dst = input_buffer_.data();
+        for (const Request* request : batch) {
+          const auto& data = request->inputs[i]->data;
+          memcpy(dst, data.data(), data.length());
+          dst += data.length();
+        }
+        VisitDataType<CopyFromHostFunctor>(
+            first->dtype, handle.get(), input_buffer_.data());
+      }
+      success = predictor->Run();
+      for (size_t i = 0; success && i < output_names_.size(); ++i) {
+        auto handle = predictor->GetOutputHandle(output_names_[i]);
+        std::vector<int> shape = handle->shape();
+        DataType dtype = handle->type();
+        size_t bytes = Numel(shape) * GetNumBytesOfDataType(dtype);
+        output_buffer_.resize(bytes);
+        VisitDataType<CopyToHostFunctor>(
+            dtype, handle.get(), output_buffer_.data());
+        bool split = !shape.empty() && shape[0] == batch_size;
+        size_t offset = 0;
+        for (Request* request : batch) {
+          auto& outputs = *request->outputs;
+          outputs.resize(output_names_.size());
+          auto& output = outputs[i];
+          output.name = output_names_[i];
+          output.dtype = dtype;
+          output.lod.clear();
+          output.shape = shape;
+          size_t size = bytes;
+          if (split) {
+            output.shape[0] = request->batch_size;
+            size = bytes / batch_size * request->batch_size;
+          }
+          output.data.Resize(size);
+          memcpy(output.data.data(), output_buffer_.data() + offset, size);
+          if (split) {
+            offset += size;
+          }
+        }
+      }
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "BatchingPredictor failed to run a batch of "
+                 << batch.size() << " requests: " << e.what();
+      success = false;
+    }
+    auto end_time = Clock::now();
+    RecordBatch(batch, batch_size, success, start_time, end_time);
+    for (Request* request : batch) {
+      request->done.set_value(success);
+    }
+  }
+
+  void RecordBatch(const std::vector<Request*>& batch,
+                   int batch_size,
+                   bool success,
+                   Clock::time_point start_time,
+                   Clock::time_point end_time) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++batch_num_;
+    sample_num_ += batch_size;
+    total_run_us_ += ElapsedUs(start_time, end_time);
+    for (const Request* request : batch) {
+      int64_t latency_us = ElapsedUs(request->submit_time, end_time);
+      ++request_num_;
+      if (!success) {
+        ++failed_request_num_;
+      }
+      total_queue_us_ += ElapsedUs(request->submit_time, start_time);
+      total_latency_us_ += latency_us;
+      max_latency_us_ = std::max(max_latency_us_, latency_us);
+      ++latency_buckets_[LatencyBucket(latency_us)];
+    }
+  }
+
+  double LatencyPercentile(double percentile) const {
+    uint64_t target =
+        static_cast<uint64_t>(std::ceil(percentile * request_num_));
+    uint64_t count = 0;
+    for (int i = 0; i < kLatencyBucketNum; ++i) {
+      count += latency_buckets_[i];
+      if (count >= target) {
+        return std::min(LatencyBucketUpperBound(i),
+                        static_cast<double>(max_latency_us_));
+      }
+    }
+    return static_cast<double>(max_latency_us_);
+  }
+
+  const BatchingOptions options_;
+  PredictorPool pool_;
+  std::vector<std::string> input_names_;
+  std::vector<std::string> output_names_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Request*> queue_;
+  bool stop_{false};
+  std::vector<std::thread> workers_;
+
+  // staging buffers of the worker threads
+  static thread_local std::vector<char> input_buffer_;
+  static thread_local std::vector<char> output_buffer_;
+
+  mutable std::mutex stats_mutex_;
+  Clock::time_point stats_start_;
+  uint64_t request_num_{0};
+  uint64_t failed_request_num_{0};
+  uint64_t batch_num_{0};
+  uint64_t sample_num_{0};
+  int64_t total_queue_us_{0};
+  int64_t total_run_us_{0};
+  int64_t total_latency_us_{0};
+  int64_t max_latency_us_{0};
+  std::vector<uint64_t> latency_buckets_ =
+      std::vector<uint64_t>(kLatencyBucketNum, 0);
+};
+
+thread_local std::vector<char> BatchingPredictor::Impl::input_buffer_;
+thread_local std::vector<char> BatchingPredictor::Impl::output_buffer_;
+
+BatchingPredictor::BatchingPredictor(const Config& config,
+                                     const BatchingOptions& options)
+    : impl_(new Impl(config, options)) {}
+
+BatchingPredictor::~BatchingPredictor() = default;
+
+bool BatchingPredictor::Run(const std::vector<paddle::PaddleTensor>& inputs,
+                            std::vector<paddle::PaddleTensor>* outputs) {
+  return impl_->Run(inputs, outputs);
+}
+
+std::vector<std::string> BatchingPredictor::GetInputNames() {
+  return impl_->input_names();
+}
+
+std::vector<std::string> BatchingPredictor::GetOutputNames() {
+  return impl_->output_names();
+}
+
+BatchingStats BatchingPredictor::GetStats() const { return impl_->GetStats(); }
+
+void BatchingPredictor::ResetStats() { impl_->ResetStats(); }
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -1097,6 +1097,57 @@ struct PD_INFER_DECL AnalysisConfig {
   /// \return bool Whether the memory optimization is activated.
   ///
   bool enable_memory_optim() const;
+  ///
+  /// \brief Turn on memory optimize with a static arena: instead of sharing
+  /// the buffers of the tensors of disjoint lifetimes, the executor places
+  /// the tensors at the offsets of one arena planned for the sizes of the
+  /// runs, so that the runs of known input shapes allocate nothing. It
+  /// enables the memory optimize as well.
+  ///
+  /// \param x Whether to enable the static arena.
+  ///
+  void EnableMemoryOptimStaticArena(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the memory optimize plans a
+  /// static arena.
+  ///
+  /// \return bool Whether the static arena is activated.
+  ///
+  bool memory_optim_static_arena() const;
+
+  ///
+  /// \brief Turn on the shape bucketing of the inputs of ZeroCopyRun, e.g.
+  /// of the sequence lengths of NLP models. The dim axis of the inputs is
+  /// padded with zeros up to the smallest bucket not less than the longest
+  /// of them, and the dim axis of the outputs is sliced back, so that the
+  /// runs of a bucket share the shapes, the buffers and the memory plan of
+  /// the predictor. The inputs longer than the largest bucket run unpadded.
+  /// The model must ignore the zeros padded, e.g. by the attention mask. Only
+  /// the inputs on CPU are padded.
+  ///
+  /// \param buckets The lengths of the buckets.
+  /// \param axis The dim of the inputs and outputs to bucket.
+  /// \param input_names The inputs to pad, the inputs whose dim axis is
+  /// variable in the model if empty.
+  /// \param output_names The outputs to slice, the outputs whose dim axis is
+  /// variable in the model if empty.
+  ///
+  void EnableShapeBucketing(const std::vector<int64_t>& buckets,
+                            int axis = 1,
+                            const std::vector<std::string>& input_names = {},
+                            const std::vector<std::string>& output_names = {});
+  ///
+  /// \brief A boolean state telling whether the shape bucketing is turned on.
+  ///
+  /// \return bool Whether the shape bucketing is turned on.
+  ///
+  bool shape_bucketing_enabled() const { return !shape_buckets_.empty(); }
+  ///
+  /// \brief Get the lengths of the buckets of the shape bucketing, sorted.
+  ///
+  /// \return const std::vector<int64_t>& The lengths of the buckets.
+  ///
+  const std::vector<int64_t>& shape_buckets() const { return shape_buckets_; }
 
   ///
   /// \brief Turn on profiling report.
@@ -1299,6 +1350,13 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  bool memory_optim_static_arena_{false};
+
+  // shape bucketing related.
+  std::vector<int64_t> shape_buckets_;
+  int shape_bucket_axis_{1};
+  std::vector<std::string> shape_bucket_inputs_;
+  std::vector<std::string> shape_bucket_outputs_;
   bool trt_engine_memory_sharing_{true};
   int trt_engine_memory_sharing_identifier_{0};
 
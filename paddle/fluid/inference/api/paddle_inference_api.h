@@ -190,6 +190,14 @@ class PD_INFER_DECL Predictor {
   ///
   uint64_t TryShrinkMemory();
 
+  ///
+  /// \brief Get the runs of every bucket of the shape bucketing of the config,
+  /// the runs longer than the largest bucket are counted under the key -1.
+  ///
+  /// \return The runs of the buckets.
+  ///
+  std::map<int64_t, uint64_t> GetShapeBucketHits();
+
   ///
   /// \brief Register a output hook function to operate the intermediate tensor
   /// of op output. when using this function, memory reuse should be turned off.
@@ -273,6 +281,95 @@ class PD_INFER_DECL PredictorPool {
   std::shared_ptr<Predictor> main_pred_;
   std::vector<std::unique_ptr<Predictor>> preds_;
 };
+
+///
+/// \brief Options of BatchingPredictor.
+///
+struct PD_INFER_DECL BatchingOptions {
+  /// The number of predictors in the pool, each is run by a worker thread.
+  /// It should be at least 1.
+  size_t num_predictors{1};
+  /// The max number of samples coalesced into one run. A request larger than
+  /// it is run alone.
+  int max_batch_size{32};
+  /// The max time in microseconds a request waits for others to fill a
+  /// batch before the batch is run anyway.
+  int64_t max_wait_us{1000};
+};
+
+///
+/// \brief Counters of BatchingPredictor since it is created or the stats are
+/// reset. The times are in microseconds.
+///
+struct PD_INFER_DECL BatchingStats {
+  uint64_t request_num{0};
+  uint64_t failed_request_num{0};
+  uint64_t batch_num{0};
+  uint64_t sample_num{0};
+  double avg_batch_size{0};
+  /// From the submission of a request to the start of its batch.
+  double avg_queue_us{0};
+  /// The run of a batch, including the copies of inputs and outputs.
+  double avg_run_us{0};
+  double avg_latency_us{0};
+  double p50_latency_us{0};
+  double p99_latency_us{0};
+  double max_latency_us{0};
+  /// Samples per second.
+  double throughput{0};
+};
+
+///
+/// \class BatchingPredictor
+///
+/// \brief BatchingPredictor serves concurrent requests of a few samples with
+/// the predictors of a PredictorPool. The pending requests of the same input
+/// shapes are coalesced along the batch dimension, i.e. the first dimension
+/// of every input, into one run of up to max_batch_size samples. A batch is
+/// run as soon as it is full, or when its oldest request has waited for
+/// max_wait_us, so the batch size adapts to the load. The outputs whose first
+/// dimension is the batch size are split back to the requests, the others are
+/// copied to every request of the batch.
+///
+/// \code{cpp}
+///   services::BatchingPredictor predictor(config, options);
+///   // in every serving thread
+///   std::vector<paddle::PaddleTensor> inputs, outputs;
+///   ...
+///   predictor.Run(inputs, &outputs);
+/// \endcode
+///
+class PD_INFER_DECL BatchingPredictor {
+ public:
+  BatchingPredictor(const Config& config, const BatchingOptions& options);
+
+  ~BatchingPredictor();
+
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+
+  /// \brief Run a request and wait for its outputs, thread safe.
+  ///
+  /// \param[in] inputs The inputs on host, matched to the inputs of the model
+  /// by name, or by position if the names are empty. They should not have lod
+  /// and should have the same first dimension.
+  /// \param[out] outputs The outputs in the order of GetOutputNames().
+  /// \return Whether the run succeeded.
+  bool Run(const std::vector<paddle::PaddleTensor>& inputs,
+           std::vector<paddle::PaddleTensor>* outputs);
+
+  std::vector<std::string> GetInputNames();
+
+  std::vector<std::string> GetOutputNames();
+
+  BatchingStats GetStats() const;
+
+  void ResetStats();
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl_;
+};
 }  // namespace services
 
 }  // namespace paddle_infer
@@ -24,6 +24,7 @@
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
 #include "paddle/fluid/memory/allocation/stat_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_caching_allocator.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
@@ -84,6 +85,24 @@ PADDLE_DEFINE_EXPORTED_bool(use_virtual_memory_auto_growth,
                             false,
                             "Use VirtualMemoryAutoGrowthBestFitAllocator.");
 
+PADDLE_DEFINE_EXPORTED_bool(
+    use_thread_caching_cpu_allocator,
+    false,
+    "Whether to use ThreadCachingAllocator over AutoGrowthBestFitAllocator "
+    "for CPU memory, only available for auto_growth strategy. Small "
+    "allocations are served from per-thread size-class caches.");
+
+PADDLE_DEFINE_EXPORTED_uint64(
+    thread_caching_cpu_max_cached_size_in_kb,
+    1024,
+    "Allocations larger than this size bypass the thread caches of "
+    "ThreadCachingAllocator.");
+
+PADDLE_DEFINE_EXPORTED_uint64(
+    thread_caching_cpu_cache_size_in_kb,
+    4096,
+    "The maximum bytes cached by each thread in ThreadCachingAllocator.");
+
 // NOTE(Ruibiao): This FLAGS is just to be compatible with
 // the old single-stream CUDA allocator. It will be removed
 // after StreamSafeCudaAllocator has been fully tested.
@@ -222,7 +241,11 @@ class AllocatorFacadePrivate {
       }
 
       case AllocatorStrategy::kAutoGrowth: {
-        InitNaiveBestFitCPUAllocator();
+        if (FLAGS_use_thread_caching_cpu_allocator) {
+          InitThreadCachingCPUAllocator();
+        } else {
+          InitNaiveBestFitCPUAllocator();
+        }
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
         allow_free_idle_chunk_ = allow_free_idle_chunk;
         for (int dev_id = 0; dev_id < platform::GetGPUDeviceCount(); ++dev_id) {
@@ -790,6 +813,25 @@ class AllocatorFacadePrivate {
 #endif
   }
 
+  void InitThreadCachingCPUAllocator() {
+    // NOTE: CPUAllocator calls posix_memalign for each allocation, so cache
+    // chunks of it in an AutoGrowthBestFitAllocator, and put the thread
+    // caches in front to keep most allocations off the lock of the latter.
+    constexpr size_t kDefaultCPUChunkSize = 16 << 20;
+    size_t chunk_size = FLAGS_auto_growth_chunk_size_in_mb > 0
+                            ? FLAGS_auto_growth_chunk_size_in_mb << 20
+                            : kDefaultCPUChunkSize;
+    auto auto_growth_allocator = std::make_shared<AutoGrowthBestFitAllocator>(
+        std::make_shared<CPUAllocator>(),
+        ThreadCachingAllocator::kMinClassBytes,
+        chunk_size);
+    allocators_[platform::CPUPlace()] =
+        std::make_shared<ThreadCachingAllocator>(
+            auto_growth_allocator,
+            FLAGS_thread_caching_cpu_max_cached_size_in_kb << 10,
+            FLAGS_thread_caching_cpu_cache_size_in_kb << 10);
+  }
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   void InitNaiveBestFitCUDAPinnedAllocator() {
     if (FLAGS_use_auto_growth_pinned_allocator) {
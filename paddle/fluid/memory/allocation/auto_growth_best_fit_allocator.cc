@@ -18,6 +18,7 @@
 #include <mutex>  // NOLINT
 
 #include "paddle/fluid/memory/allocation/aligned_allocator.h"
+#include "paddle/fluid/memory/stats.h"
 #include "paddle/fluid/platform/flags.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
 
@@ -61,6 +62,20 @@ AutoGrowthBestFitAllocator::AutoGrowthBestFitAllocator(
   VLOG(4) << "chunk_size_:" << chunk_size_;
 }
 
+std::unique_lock<SpinLock> AutoGrowthBestFitAllocator::LockSpinLock() {
+  // the counters are host memory stats, so the device allocators skip them
+  if (!on_cpu_place_.load(std::memory_order_relaxed)) {
+    return std::unique_lock<SpinLock>(spinlock_);
+  }
+  std::unique_lock<SpinLock> guard(spinlock_, std::try_to_lock);
+  if (!guard.owns_lock()) {
+    HOST_MEMORY_COUNTER_UPDATE(AllocatorLockContention, 1);
+    guard.lock();
+  }
+  HOST_MEMORY_COUNTER_UPDATE(AllocatorLockAcquire, 1);
+  return guard;
+}
+
 phi::Allocation *AutoGrowthBestFitAllocator::AllocateImpl(
     size_t unaligned_size) {
   platform::RecordEvent record("AutoGrowthBestFitAllocator::Allocate",
@@ -69,7 +84,7 @@ phi::Allocation *AutoGrowthBestFitAllocator::AllocateImpl(
   size_t size = AlignedSize(unaligned_size, alignment_);
   VLOG(10) << "Allocate " << unaligned_size << " bytes, aligned to " << size;
 
-  std::lock_guard<SpinLock> guard(spinlock_);
+  auto guard = LockSpinLock();
   auto iter = free_blocks_.lower_bound(std::make_pair(size, nullptr));
   BlockIt block_it;
   if (iter != free_blocks_.end()) {
@@ -108,6 +123,10 @@ phi::Allocation *AutoGrowthBestFitAllocator::AllocateImpl(
     }
 
     auto *chunk = &(*chunks_.rbegin());
+    if (chunks_.size() == 1) {
+      on_cpu_place_.store(platform::is_cpu_place(chunk->allocation_->place()),
+                          std::memory_order_relaxed);
+    }
     realloc_size = chunk->allocation_->size();
     uint8_t *p = reinterpret_cast<uint8_t *>(chunk->allocation_->ptr());
     auto &blocks = chunk->blocks_;
@@ -134,7 +153,7 @@ void AutoGrowthBestFitAllocator::FreeImpl(phi::Allocation *allocation) {
                                9 /*level*/);
   VLOG(10) << "Free " << allocation->size()
            << " bytes, ptr = " << allocation->ptr();
-  std::lock_guard<SpinLock> guard(spinlock_);
+  auto guard = LockSpinLock();
   auto block_it = static_cast<BlockAllocation *>(allocation)->block_it_;
   auto &blocks = block_it->chunk_->blocks_;
 
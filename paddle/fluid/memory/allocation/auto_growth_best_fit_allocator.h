@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <list>
 #include <map>
 #include <memory>
@@ -48,6 +49,9 @@ class AutoGrowthBestFitAllocator : public Allocator {
   }
 
  private:
+  // Acquires spinlock_, recording the acquisition and whether it contended
+  // if the chunks are on CPU.
+  std::unique_lock<SpinLock> LockSpinLock();
   uint64_t FreeIdleChunks();
   void Trace() const;
 
@@ -100,6 +104,9 @@ class AutoGrowthBestFitAllocator : public Allocator {
   size_t total_free_times_;
   size_t total_free_size_;
 
+  // whether the chunks are on CPU, known after the first chunk
+  std::atomic<bool> on_cpu_place_{false};
+
   SpinLock spinlock_;
 };
 
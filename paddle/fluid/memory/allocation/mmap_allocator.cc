@@ -18,7 +18,10 @@
 
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <cstdlib>
+#include <cstring>
 
 #include <atomic>
 #include <random>
@@ -394,6 +397,47 @@ void MemoryMapAllocationPool::Clear() {
 
 MemoryMapAllocationPool::~MemoryMapAllocationPool() { Clear(); }  // NOLINT
 
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string &filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(fd,
+                    -1,
+                    platform::errors::Unavailable(
+                        "Open file %s failed: %s.", filename, strerror(errno)));
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    int err = errno;
+    ::close(fd);
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Stat file %s failed: %s.", filename, strerror(err)));
+  }
+  size_t size = static_cast<size_t>(file_stat.st_size);
+  char *data = nullptr;
+  if (size > 0) {
+    // PROT_WRITE with MAP_PRIVATE allows the owner of an aliased tensor to
+    // modify it in place, e.g. by the fuse passes, without touching the file.
+    void *ptr =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED) {
+      int err = errno;
+      ::close(fd);
+      PADDLE_THROW(platform::errors::Unavailable(
+          "Memory map file %s failed: %s.", filename, strerror(err)));
+    }
+    data = static_cast<char *>(ptr);
+  }
+  // the mapping stays valid after the file is closed
+  ::close(fd);
+  VLOG(4) << "map file " << filename << " of " << size << " bytes";
+  return std::shared_ptr<MappedFile>(new MappedFile(filename, data, size));
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr && munmap(data_, size_) != 0) {
+    LOG(WARNING) << "munmap file " << filename_ << " failed: "
+                 << strerror(errno);
+  }
+}
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
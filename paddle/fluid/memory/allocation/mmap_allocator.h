@@ -221,6 +221,49 @@ class MemoryMapAllocationPool {
   std::mutex mtx_;
 };
 
+// A private mapping of a whole regular file. The pages are shared with the
+// page cache, hence with other processes mapping the same file, until they
+// are written, and a written page is copied for this process only.
+class MappedFile {
+ public:
+  static std::shared_ptr<MappedFile> Open(const std::string &filename);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  char *data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+  const std::string &filename() const { return filename_; }
+
+ private:
+  MappedFile(std::string filename, char *data, size_t size)
+      : filename_(std::move(filename)), data_(data), size_(size) {}
+
+  std::string filename_;
+  char *data_;
+  size_t size_;
+};
+
+// An allocation aliasing a region of a MappedFile, which keeps the file
+// mapped as long as the allocation lives.
+class MappedFileAllocation : public Allocation {
+ public:
+  MappedFileAllocation(std::shared_ptr<MappedFile> file,
+                       size_t offset,
+                       size_t size)
+      : Allocation(file->data() + offset, size, platform::CPUPlace()),
+        file_(std::move(file)) {}
+
+  const std::shared_ptr<MappedFile> &file() const { return file_; }
+
+ private:
+  std::shared_ptr<MappedFile> file_;
+};
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
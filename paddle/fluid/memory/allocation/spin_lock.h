@@ -55,6 +55,11 @@ class SpinLock {
     }
   }
 
+  bool try_lock() {
+    return !mlock_.load(std::memory_order_relaxed) &&
+           !mlock_.exchange(true, std::memory_order_acquire);
+  }
+
   void unlock() { mlock_.store(false, std::memory_order_release); }
 
   DISABLE_COPY_AND_ASSIGN(SpinLock);
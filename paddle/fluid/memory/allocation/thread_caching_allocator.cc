@@ -0,0 +1,400 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_caching_allocator.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "glog/logging.h"
+#include "paddle/fluid/memory/stats.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+namespace {
+
+constexpr size_t kNotCached = static_cast<size_t>(-1);
+// A batch moved between a thread cache and a central list holds about
+// kBatchBytes, and a central list keeps at most kCentralBatches batches.
+constexpr size_t kBatchBytes = 64 << 10;
+constexpr size_t kMaxBatchSize = 32;
+constexpr size_t kCentralBatches = 8;
+// The first 4 classes are multiples of kMinClassBytes (2^6).
+constexpr size_t kMinClassShift = 6;
+constexpr size_t kSmallClasses = 4;
+
+std::atomic<uint64_t> next_allocator_id{0};
+
+// Set when the ThreadCacheHolder of the current thread is destructed, the
+// allocations freed after that (e.g., by other thread local objects) bypass
+// the thread cache.
+thread_local bool thread_cache_destructed = false;
+
+class ThreadCachedAllocation : public Allocation {
+ public:
+  ThreadCachedAllocation(DecoratedAllocationPtr underlying_allocation,
+                         size_t size_class)
+      : Allocation(underlying_allocation->ptr(),
+                   underlying_allocation->base_ptr(),
+                   underlying_allocation->size(),
+                   underlying_allocation->place()),
+        underlying_allocation_(std::move(underlying_allocation)),
+        size_class_(size_class) {}
+
+  size_t size_class() const { return size_class_; }
+
+ private:
+  DecoratedAllocationPtr underlying_allocation_;
+  size_t size_class_;
+};
+
+}  // namespace
+
+struct ThreadCachingAllocator::ThreadCache {
+  SpinLock lock;
+  // nullptr once the owner allocator is destructed
+  ThreadCachingAllocator* owner{nullptr};
+  // true once the thread exits and the cache is drained
+  bool retired{false};
+  size_t cached_bytes{0};
+  std::vector<std::vector<phi::Allocation*>> bins;
+};
+
+// Holds the caches of the current thread, one for each allocator, and drains
+// them into the central lists of their owners when the thread exits.
+class ThreadCachingAllocator::ThreadCacheHolder {
+ public:
+  ThreadCacheHolder() = default;
+
+  ~ThreadCacheHolder() {
+    thread_cache_destructed = true;
+    for (auto& item : caches_) {
+      ThreadCache* cache = item.second.get();
+      std::lock_guard<SpinLock> guard(cache->lock);
+      if (cache->owner != nullptr) {
+        cache->owner->FlushAll(cache);
+      }
+      cache->retired = true;
+    }
+  }
+
+  ThreadCache* Find(uint64_t allocator_id) {
+    if (last_id_ == allocator_id) {
+      return last_cache_;
+    }
+    for (auto& item : caches_) {
+      if (item.first == allocator_id) {
+        last_id_ = allocator_id;
+        last_cache_ = item.second.get();
+        return last_cache_;
+      }
+    }
+    return nullptr;
+  }
+
+  void Add(uint64_t allocator_id, std::shared_ptr<ThreadCache> cache) {
+    last_id_ = allocator_id;
+    last_cache_ = cache.get();
+    caches_.emplace_back(allocator_id, std::move(cache));
+  }
+
+ private:
+  // Allocator ids are never reused, the caches of destructed allocators
+  // stay here until the thread exits, and are empty.
+  std::vector<std::pair<uint64_t, std::shared_ptr<ThreadCache>>> caches_;
+  uint64_t last_id_{kNotCached};
+  ThreadCache* last_cache_{nullptr};
+};
+
+ThreadCachingAllocator::ThreadCachingAllocator(
+    std::shared_ptr<Allocator> underlying_allocator,
+    size_t max_cached_size,
+    size_t max_thread_cache_bytes)
+    : underlying_allocator_(std::move(underlying_allocator)),
+      max_cached_size_(max_cached_size),
+      max_thread_cache_bytes_(max_thread_cache_bytes),
+      num_classes_(SizeClassIndex(max_cached_size) + 1),
+      id_(next_allocator_id.fetch_add(1)),
+      central_lists_(new CentralList[num_classes_]) {
+  PADDLE_ENFORCE_NOT_NULL(
+      underlying_allocator_,
+      platform::errors::InvalidArgument(
+          "Underlying allocator of ThreadCachingAllocator is NULL"));
+  batch_sizes_.reserve(num_classes_);
+  for (size_t i = 0; i < num_classes_; ++i) {
+    batch_sizes_.emplace_back(
+        std::min(std::max(kBatchBytes / SizeClassBytes(i), size_t(1)),
+                 kMaxBatchSize));
+  }
+  VLOG(4) << "Create ThreadCachingAllocator with " << num_classes_
+          << " size classes, max_cached_size: " << max_cached_size_
+          << ", max_thread_cache_bytes: " << max_thread_cache_bytes_;
+}
+
+ThreadCachingAllocator::~ThreadCachingAllocator() {
+  {
+    std::lock_guard<std::mutex> guard(caches_mtx_);
+    for (auto& cache : caches_) {
+      std::lock_guard<SpinLock> cache_guard(cache->lock);
+      for (auto& bin : cache->bins) {
+        for (auto* allocation : bin) {
+          delete allocation;
+        }
+        bin.clear();
+      }
+      cache->cached_bytes = 0;
+      cache->owner = nullptr;
+    }
+    caches_.clear();
+  }
+  for (size_t i = 0; i < num_classes_; ++i) {
+    for (auto* allocation : central_lists_[i].allocations) {
+      delete allocation;
+    }
+  }
+}
+
+size_t ThreadCachingAllocator::SizeClassIndex(size_t size) {
+  if (size <= (kSmallClasses << kMinClassShift)) {
+    return (std::max(size, size_t(1)) + kMinClassBytes - 1) / kMinClassBytes -
+           1;
+  }
+  // 2^shift < size <= 2^(shift + 1), split into 4 classes
+  size_t shift = kMinClassShift + 2;
+  while (((size - 1) >> (shift + 1)) != 0) {
+    ++shift;
+  }
+  size_t step = size_t(1) << (shift - 2);
+  size_t k = (size - (size_t(1) << shift) + step - 1) / step;
+  return kSmallClasses + (shift - kMinClassShift - 2) * 4 + (k - 1);
+}
+
+size_t ThreadCachingAllocator::SizeClassBytes(size_t index) {
+  if (index < kSmallClasses) {
+    return (index + 1) << kMinClassShift;
+  }
+  size_t shift = kMinClassShift + 2 + (index - kSmallClasses) / 4;
+  size_t k = (index - kSmallClasses) % 4 + 1;
+  return (size_t(1) << shift) + k * (size_t(1) << (shift - 2));
+}
+
+size_t ThreadCachingAllocator::CachedBytes() const {
+  size_t bytes = central_bytes_.load();
+  std::lock_guard<std::mutex> guard(caches_mtx_);
+  for (auto& cache : caches_) {
+    std::lock_guard<SpinLock> cache_guard(cache->lock);
+    bytes += cache->cached_bytes;
+  }
+  return bytes;
+}
+
+ThreadCachingAllocator::ThreadCache* ThreadCachingAllocator::GetThreadCache() {
+  if (thread_cache_destructed) {
+    return nullptr;
+  }
+  static thread_local ThreadCacheHolder holder;
+  ThreadCache* cache = holder.Find(id_);
+  if (cache != nullptr) {
+    return cache;
+  }
+
+  auto new_cache = std::make_shared<ThreadCache>();
+  new_cache->owner = this;
+  new_cache->bins.resize(num_classes_);
+  {
+    std::lock_guard<std::mutex> guard(caches_mtx_);
+    // drop the caches of exited threads
+    caches_.erase(std::remove_if(caches_.begin(),
+                                 caches_.end(),
+                                 [](const std::shared_ptr<ThreadCache>& c) {
+                                   std::lock_guard<SpinLock> g(c->lock);
+                                   return c->retired;
+                                 }),
+                  caches_.end());
+    caches_.emplace_back(new_cache);
+  }
+  cache = new_cache.get();
+  holder.Add(id_, std::move(new_cache));
+  return cache;
+}
+
+std::unique_lock<std::mutex> ThreadCachingAllocator::LockCentral(
+    CentralList* list, bool record_stats) {
+  std::unique_lock<std::mutex> guard(list->mtx, std::try_to_lock);
+  if (!guard.owns_lock()) {
+    if (record_stats) {
+      HOST_MEMORY_COUNTER_UPDATE(AllocatorLockContention, 1);
+    }
+    guard.lock();
+  }
+  if (record_stats) {
+    HOST_MEMORY_COUNTER_UPDATE(AllocatorLockAcquire, 1);
+  }
+  return guard;
+}
+
+phi::Allocation* ThreadCachingAllocator::AllocateImpl(size_t size) {
+  if (size > max_cached_size_) {
+    return new ThreadCachedAllocation(
+        static_unique_ptr_cast<Allocation>(
+            underlying_allocator_->Allocate(size)),
+        kNotCached);
+  }
+
+  size_t index = SizeClassIndex(size);
+  size_t class_bytes = SizeClassBytes(index);
+  ThreadCache* cache = GetThreadCache();
+  if (cache != nullptr) {
+    std::lock_guard<SpinLock> guard(cache->lock);
+    auto& bin = cache->bins[index];
+    if (!bin.empty()) {
+      HOST_MEMORY_COUNTER_UPDATE(ThreadCacheHit, 1);
+      phi::Allocation* allocation = bin.back();
+      bin.pop_back();
+      cache->cached_bytes -= class_bytes;
+      return allocation;
+    }
+
+    HOST_MEMORY_COUNTER_UPDATE(ThreadCacheMiss, 1);
+    // Refill the bin with a batch from the central list.
+    CentralList* list = &central_lists_[index];
+    auto central_guard = LockCentral(list, true);
+    size_t count = std::min(BatchSize(index), list->allocations.size());
+    if (count > 0) {
+      bin.insert(bin.end(),
+                 list->allocations.end() - count,
+                 list->allocations.end());
+      list->allocations.resize(list->allocations.size() - count);
+      central_bytes_ -= static_cast<int64_t>(count * class_bytes);
+      central_guard.unlock();
+
+      phi::Allocation* allocation = bin.back();
+      bin.pop_back();
+      cache->cached_bytes += (count - 1) * class_bytes;
+      return allocation;
+    }
+  }
+
+  return new ThreadCachedAllocation(
+      static_unique_ptr_cast<Allocation>(
+          underlying_allocator_->Allocate(class_bytes)),
+      index);
+}
+
+void ThreadCachingAllocator::FreeImpl(phi::Allocation* allocation) {
+  size_t index =
+      static_cast<ThreadCachedAllocation*>(allocation)->size_class();
+  if (index == kNotCached) {
+    delete allocation;
+    return;
+  }
+
+  ThreadCache* cache = GetThreadCache();
+  if (cache == nullptr) {
+    delete allocation;
+    return;
+  }
+  std::lock_guard<SpinLock> guard(cache->lock);
+  auto& bin = cache->bins[index];
+  bin.emplace_back(allocation);
+  cache->cached_bytes += SizeClassBytes(index);
+  if (bin.size() > 2 * BatchSize(index)) {
+    FlushToCentral(cache, index, BatchSize(index), true);
+  }
+  if (cache->cached_bytes > max_thread_cache_bytes_) {
+    // Over the bound, return half of the cached allocations, larger classes
+    // first.
+    for (size_t i = num_classes_; i > 0; --i) {
+      if (cache->cached_bytes <= max_thread_cache_bytes_ / 2) {
+        break;
+      }
+      FlushToCentral(cache, i - 1, (cache->bins[i - 1].size() + 1) / 2, true);
+    }
+  }
+}
+
+void ThreadCachingAllocator::FlushToCentral(ThreadCache* cache,
+                                            size_t index,
+                                            size_t count,
+                                            bool record_stats) {
+  auto& bin = cache->bins[index];
+  count = std::min(count, bin.size());
+  if (count == 0) {
+    return;
+  }
+  if (record_stats) {
+    HOST_MEMORY_COUNTER_UPDATE(ThreadCacheFlush, 1);
+  }
+
+  size_t class_bytes = SizeClassBytes(index);
+  size_t begin = bin.size() - count;
+  size_t moved = 0;
+  {
+    CentralList* list = &central_lists_[index];
+    auto central_guard = LockCentral(list, record_stats);
+    size_t capacity = kCentralBatches * BatchSize(index);
+    if (list->allocations.size() < capacity) {
+      moved = std::min(count, capacity - list->allocations.size());
+      list->allocations.insert(list->allocations.end(),
+                               bin.begin() + begin,
+                               bin.begin() + begin + moved);
+      central_bytes_ += static_cast<int64_t>(moved * class_bytes);
+    }
+  }
+  // The central list is full, return the rest to the underlying allocator.
+  for (size_t i = begin + moved; i < bin.size(); ++i) {
+    delete bin[i];
+  }
+  bin.resize(begin);
+  cache->cached_bytes -= count * class_bytes;
+}
+
+void ThreadCachingAllocator::FlushAll(ThreadCache* cache) {
+  for (size_t i = 0; i < num_classes_; ++i) {
+    FlushToCentral(cache, i, cache->bins[i].size(), false);
+  }
+}
+
+uint64_t ThreadCachingAllocator::ReleaseImpl(const platform::Place& place) {
+  {
+    std::lock_guard<std::mutex> guard(caches_mtx_);
+    for (auto& cache : caches_) {
+      std::lock_guard<SpinLock> cache_guard(cache->lock);
+      FlushAll(cache.get());
+    }
+  }
+  uint64_t released_size = 0;
+  for (size_t i = 0; i < num_classes_; ++i) {
+    std::vector<phi::Allocation*> allocations;
+    {
+      std::lock_guard<std::mutex> guard(central_lists_[i].mtx);
+      allocations.swap(central_lists_[i].allocations);
+    }
+    size_t bytes = allocations.size() * SizeClassBytes(i);
+    central_bytes_ -= static_cast<int64_t>(bytes);
+    released_size += bytes;
+    for (auto* allocation : allocations) {
+      delete allocation;
+    }
+  }
+  VLOG(10) << "ThreadCachingAllocator returns " << released_size
+           << " bytes to the underlying allocator";
+  return underlying_allocator_->Release(place);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,111 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/memory/allocation/spin_lock.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// ThreadCachingAllocator is a front-end of a shared allocator (usually an
+// AutoGrowthBestFitAllocator on CPU). Small requests are rounded up to a size
+// class and served from a cache owned by the calling thread, so that the hot
+// path does not touch the lock of the shared allocator. When a thread cache
+// grows over its bound, half of a bin is moved to a central list in one batch,
+// and the central lists return the overflow to the underlying allocator.
+// Requests larger than max_cached_size go to the underlying allocator
+// directly.
+class ThreadCachingAllocator : public Allocator {
+ public:
+  static constexpr size_t kMinClassBytes = 64;
+
+  ThreadCachingAllocator(std::shared_ptr<Allocator> underlying_allocator,
+                         size_t max_cached_size,
+                         size_t max_thread_cache_bytes);
+
+  ~ThreadCachingAllocator() override;
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  // Size classes are multiples of kMinClassBytes up to 4 * kMinClassBytes,
+  // then 4 classes per power of two.
+  static size_t SizeClassIndex(size_t size);
+
+  static size_t SizeClassBytes(size_t index);
+
+  // Bytes held by the thread caches and the central lists.
+  size_t CachedBytes() const;
+
+ protected:
+  phi::Allocation* AllocateImpl(size_t size) override;
+
+  void FreeImpl(phi::Allocation* allocation) override;
+
+  uint64_t ReleaseImpl(const platform::Place& place) override;
+
+ private:
+  struct ThreadCache;
+  class ThreadCacheHolder;
+
+  // Align to 64 byte boundary to prevent false sharing between classes.
+  struct alignas(64) CentralList {
+    std::mutex mtx;
+    std::vector<phi::Allocation*> allocations;
+  };
+
+  // Returns nullptr if the thread is exiting.
+  ThreadCache* GetThreadCache();
+
+  // The counters are not recorded on the thread exit path, since the thread
+  // local data of the counters may have been destructed there.
+  std::unique_lock<std::mutex> LockCentral(CentralList* list,
+                                           bool record_stats);
+
+  // Move count allocations of bin index from the cache to the central list,
+  // the cache should be locked by the caller.
+  void FlushToCentral(ThreadCache* cache,
+                      size_t index,
+                      size_t count,
+                      bool record_stats);
+
+  // Move all allocations of the cache to the central lists.
+  void FlushAll(ThreadCache* cache);
+
+  size_t BatchSize(size_t index) const { return batch_sizes_[index]; }
+
+  const std::shared_ptr<Allocator> underlying_allocator_;
+  const size_t max_cached_size_;
+  const size_t max_thread_cache_bytes_;
+  const size_t num_classes_;
+  const uint64_t id_;
+  std::vector<size_t> batch_sizes_;
+  std::unique_ptr<CentralList[]> central_lists_;
+  std::atomic<int64_t> central_bytes_{0};
+
+  mutable std::mutex caches_mtx_;
+  std::vector<std::shared_ptr<ThreadCache>> caches_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -162,12 +162,22 @@ void LogDeviceMemoryStats(const platform::Place& place,
   StatRegistry::GetInstance()->Register( \
       "Host" #item, 0, Stat<HostMemoryStat##item##0>::GetInstance());
 
+#define HOST_MEMORY_COUNTER_REGISTER(item) \
+  StatRegistry::GetInstance()->Register(   \
+      "Host" #item, 0, Counter<HostMemoryStat##item##0>::GetInstance());
+
 int RegisterAllStats() {
   DEVICE_MEMORY_STAT_REGISTER(Allocated);
   DEVICE_MEMORY_STAT_REGISTER(Reserved);
 
   HOST_MEMORY_STAT_REGISTER(Allocated);
   HOST_MEMORY_STAT_REGISTER(Reserved);
+
+  HOST_MEMORY_COUNTER_REGISTER(ThreadCacheHit);
+  HOST_MEMORY_COUNTER_REGISTER(ThreadCacheMiss);
+  HOST_MEMORY_COUNTER_REGISTER(ThreadCacheFlush);
+  HOST_MEMORY_COUNTER_REGISTER(AllocatorLockAcquire);
+  HOST_MEMORY_COUNTER_REGISTER(AllocatorLockContention);
   return 0;
 }
 
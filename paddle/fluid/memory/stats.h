@@ -16,7 +16,9 @@ limitations under the License. */
 
 #include <atomic>
 #include <map>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/errors.h"
@@ -116,6 +118,69 @@ class Stat : public StatBase {
   std::atomic<int64_t> peak_value_{0};
 };
 
+// Counter is a monotonic STAT whose Update only touches a thread local
+// value, it is cheap enough to be bumped on every allocation. A thread folds
+// its value into retired_value_ when it exits, so the current value (the
+// retired value plus the values of the live threads) never goes backwards.
+// The peak value equals to the current value.
+template <typename ThreadLocalStatType>
+class Counter : public StatBase {
+ public:
+  static Counter* GetInstance() {
+    static Counter instance;
+    return &instance;
+  }
+
+  int64_t GetCurrentValue() override {
+    std::lock_guard<std::mutex> guard(mutex_);
+    int64_t current_value = retired_value_;
+    for (auto* thread_value : thread_values_) {
+      current_value += thread_value->value.load(std::memory_order_relaxed);
+    }
+    return current_value;
+  }
+
+  int64_t GetPeakValue() override { return GetCurrentValue(); }
+
+  void Update(int64_t increment) override {
+    // Only the owner thread writes its value, a plain load and store is
+    // enough and avoids a locked read-modify-write on the hot path.
+    std::atomic<int64_t>& value = LocalValue().value;
+    value.store(value.load(std::memory_order_relaxed) + increment,
+                std::memory_order_relaxed);
+  }
+
+ private:
+  struct ThreadValue {
+    std::atomic<int64_t> value{0};
+    ThreadValue() { GetInstance()->Register(this); }
+    ~ThreadValue() { GetInstance()->Retire(this); }
+  };
+
+  Counter() {}
+  ~Counter() {}
+
+  static ThreadValue& LocalValue() {
+    static thread_local ThreadValue thread_value;
+    return thread_value;
+  }
+
+  void Register(ThreadValue* thread_value) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    thread_values_.insert(thread_value);
+  }
+
+  void Retire(ThreadValue* thread_value) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    retired_value_ += thread_value->value.load(std::memory_order_relaxed);
+    thread_values_.erase(thread_value);
+  }
+
+  std::mutex mutex_;
+  int64_t retired_value_{0};
+  std::unordered_set<ThreadValue*> thread_values_;
+};
+
 // xxxMemoryStatCurrentValue, xxxMemoryStatPeakValue and xxxMemoryStatUpdate
 // support to operate STAT values by a string, however, they has worse
 // performance than the macro function xxx_MEMORY_STAT_CURRENT_VALUE,
@@ -199,6 +264,11 @@ void LogDeviceMemoryStats(const platform::Place& place,
 #define HOST_MEMORY_STAT_UPDATE(item, id, increment) \
   HOST_MEMORY_STAT_FUNC(item, id, Update, increment)
 
+#define HOST_MEMORY_COUNTER_UPDATE(item, increment)           \
+  paddle::memory::Counter<                                    \
+      paddle::memory::HostMemoryStat##item##0>::GetInstance() \
+      ->Update(increment)
+
 #define DEVICE_MEMORY_STAT_DECLARE_WITH_ID(item, id) \
   struct DeviceMemoryStat##item##id : public ThreadLocalStatBase {}
 
@@ -231,5 +301,13 @@ DEVICE_MEMORY_STAT_DECLARE(Reserved);
 HOST_MEMORY_STAT_DECLARE(Allocated);
 HOST_MEMORY_STAT_DECLARE(Reserved);
 
+// Counters of ThreadCachingAllocator and the allocator locks, read them by
+// HostMemoryStatCurrentValue
+HOST_MEMORY_STAT_DECLARE(ThreadCacheHit);
+HOST_MEMORY_STAT_DECLARE(ThreadCacheMiss);
+HOST_MEMORY_STAT_DECLARE(ThreadCacheFlush);
+HOST_MEMORY_STAT_DECLARE(AllocatorLockAcquire);
+HOST_MEMORY_STAT_DECLARE(AllocatorLockContention);
+
 }  // namespace memory
 }  // namespace paddle
@@ -21,11 +21,14 @@ limitations under the License. */
 #include "paddle/fluid/framework/convert_utils.h"
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
+#include "paddle/fluid/framework/io/mmap_params.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/string_array.h"
 #include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/platform/device_context.h"
 
+COMMON_DECLARE_bool(load_combine_use_mmap);
+
 namespace paddle {
 namespace operators {
 template <typename T, typename DeviceContext>
@@ -45,6 +48,14 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "it to be greater than 0.",
                           out_var_names.size()));
     if (!model_from_memory) {
+#ifndef _WIN32
+      if (FLAGS_load_combine_use_mmap && platform::is_cpu_place(place) &&
+          !HasVocab(ctx)) {
+        LoadParamsFromMappedFile(
+            ctx, place, filename, load_as_fp16, out_var_names);
+        return;
+      }
+#endif
       std::ifstream fin(filename, std::ios::binary);
       PADDLE_ENFORCE_EQ(
           static_cast<bool>(fin),
@@ -67,6 +78,75 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
     }
   }
 
+  bool HasVocab(const framework::ExecutionContext &context) const {
+    for (auto *var : context.MultiOutputVar("Out")) {
+      if (var != nullptr && var->IsType<framework::Vocab>()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+#ifndef _WIN32
+  void LoadParamsFromMappedFile(
+      const framework::ExecutionContext &context,
+      const platform::Place &place,
+      const std::string &filename,
+      bool load_as_fp16,
+      const std::vector<std::string> &out_var_names) const {
+    framework::MappedParamsReader reader(filename);
+    auto out_vars = context.MultiOutputVar("Out");
+    size_t aliased_num = 0;
+    for (size_t i = 0; i < out_var_names.size(); i++) {
+      VLOG(4) << "loading tensor: " << out_var_names[i];
+      PADDLE_ENFORCE_NOT_NULL(
+          out_vars[i],
+          platform::errors::InvalidArgument(
+              "The variable %s to be loaded cannot be found.",
+              out_var_names[i]));
+      auto *tensor = out_vars[i]->GetMutable<phi::DenseTensor>();
+      if (reader.ReadTensor(tensor)) {
+        ++aliased_num;
+      }
+      CastToFP16IfNeeded(place, load_as_fp16, out_vars[i]);
+    }
+    PADDLE_ENFORCE_EQ(reader.Eof(),
+                      true,
+                      platform::errors::Unavailable(
+                          "Not allowed to load partial data via "
+                          "load_combine_op, please use load_op instead."));
+    VLOG(3) << "mapped " << aliased_num << " of " << out_var_names.size()
+            << " tensors from " << filename << ", the others are copied";
+  }
+#endif
+
+  void CastToFP16IfNeeded(const platform::Place &place,
+                          bool load_as_fp16,
+                          framework::Variable *out_var) const {
+    auto *tensor = out_var->GetMutable<phi::DenseTensor>();
+    auto in_dtype = tensor->dtype();
+    auto out_dtype = load_as_fp16 ? phi::DataType::FLOAT16 : in_dtype;
+
+    if (in_dtype != out_dtype) {
+      // convert to float16 tensor
+      auto in_kernel_type =
+          phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, in_dtype);
+      auto out_kernel_type =
+          phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, out_dtype);
+      phi::DenseTensor fp16_tensor;
+      // copy LoD info to the new tensor
+      fp16_tensor.set_lod(tensor->lod());
+      framework::TransDataType(
+          in_kernel_type, out_kernel_type, *tensor, &fp16_tensor);
+
+      // reset output tensor
+      out_var->Clear();
+      tensor = out_var->GetMutable<phi::DenseTensor>();
+      tensor->set_lod(fp16_tensor.lod());
+      tensor->ShareDataWith(fp16_tensor);
+    }
+  }
+
   void LoadParamsFromBuffer(
       const framework::ExecutionContext &context,
       const platform::Place &place,
@@ -116,27 +196,7 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
         // Get data from fin to tensor
         paddle::framework::DeserializeFromStream(*buffer, tensor, dev_ctx);
 
-        auto in_dtype = tensor->dtype();
-        auto out_dtype = load_as_fp16 ? phi::DataType::FLOAT16 : in_dtype;
-
-        if (in_dtype != out_dtype) {
-          // convert to float16 tensor
-          auto in_kernel_type =
-              phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, in_dtype);
-          auto out_kernel_type =
-              phi::KernelKey(place, phi::DataLayout::ALL_LAYOUT, out_dtype);
-          phi::DenseTensor fp16_tensor;
-          // copy LoD info to the new tensor
-          fp16_tensor.set_lod(tensor->lod());
-          framework::TransDataType(
-              in_kernel_type, out_kernel_type, *tensor, &fp16_tensor);
-
-          // reset output tensor
-          out_vars[i]->Clear();
-          tensor = out_vars[i]->GetMutable<phi::DenseTensor>();
-          tensor->set_lod(fp16_tensor.lod());
-          tensor->ShareDataWith(fp16_tensor);
-        }
+        CastToFP16IfNeeded(place, load_as_fp16, out_vars[i]);
       }
     }
     buffer->peek();
@@ -29,6 +29,7 @@ limitations under the License. */
 #include "google/protobuf/text_format.h"
 #include "paddle/fluid/framework/async_executor.h"
 #include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_feed_columnar.h"
 #include "paddle/fluid/framework/data_feed.pb.h"
 #include "paddle/fluid/framework/data_set.h"
 #include "paddle/fluid/framework/dataset_factory.h"
@@ -395,6 +396,36 @@ void BindDataset(py::module *m) {
                     bool>())
       .def("_start", &IterableDatasetWrapper::Start)
       .def("_next", &IterableDatasetWrapper::Next);
+
+  m->def(
+      "convert_slot_text_to_columnar",
+      [](const std::string &text_path,
+         const std::string &columnar_path,
+         const std::vector<std::string> &slot_names,
+         const std::vector<std::string> &slot_types,
+         bool has_ins_id,
+         bool compress) {
+        PADDLE_ENFORCE_EQ(slot_names.size(),
+                          slot_types.size(),
+                          platform::errors::InvalidArgument(
+                              "The size of slot_names(%d) and slot_types(%d) "
+                              "should be equal.",
+                              slot_names.size(),
+                              slot_types.size()));
+        std::vector<framework::ColumnarSlot> slots;
+        for (size_t i = 0; i < slot_names.size(); ++i) {
+          slots.push_back({slot_names[i], slot_types[i][0]});
+        }
+        return framework::ConvertSlotTextToColumnar(
+            text_path, columnar_path, slots, has_ins_id, compress);
+      },
+      py::arg("text_path"),
+      py::arg("columnar_path"),
+      py::arg("slot_names"),
+      py::arg("slot_types"),
+      py::arg("has_ins_id") = false,
+      py::arg("compress") = false,
+      py::call_guard<py::gil_scoped_release>());
 }
 
 }  // namespace pybind
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/pybind/io.h"
 
+#include "paddle/fluid/framework/io/mmap_params.h"
 #include "paddle/fluid/framework/io/save_load_tensor.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/selected_rows_utils.h"
@@ -26,6 +27,18 @@ namespace paddle {
 namespace pybind {
 
 void BindIO(pybind11::module *m) {
+  m->def("align_combined_params_file",
+         &paddle::framework::AlignCombinedParamsFile,
+         py::arg("src_file_name"),
+         py::arg("dst_file_name"),
+         py::arg("alignment") = paddle::framework::kMmapParamsAlignment,
+         R"DOC(
+         Rewrite a params file saved by save_combine, so that the data of
+         every tensor is aligned in the file and can be memory mapped by
+         load_combine when FLAGS_load_combine_use_mmap is set. Returns the
+         number of tensors.
+         )DOC");
+
   m->def("save_lod_tensor",
          [](const phi::DenseTensor &tensor, const std::string &str_file_name) {
            std::ofstream fout(str_file_name, std::ios::binary);
@@ -1185,7 +1185,7 @@ PYBIND11_MODULE(libpaddle, m) {
   // unloaded. We need manually clear symbols(may contain plugins' symbols)
   // stored in this static instance to avoid illegal memory access.
   m.def("clear_kernel_factory",
-        []() { phi::KernelFactory::Instance().kernels().clear(); });
+        []() { phi::KernelFactory::Instance().ClearKernels(); });
   m.def("clear_device_manager", []() {
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
     platform::XCCLCommContext::Release();
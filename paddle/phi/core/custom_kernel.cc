@@ -39,12 +39,14 @@ void CustomKernelMap::RegisterCustomKernels() {
     LOG(INFO) << "No custom kernel info found in loaded lib(s).";
     return;
   }
-  auto& kernels = KernelFactory::Instance().kernels();
+  auto& factory = KernelFactory::Instance();
+  const auto& kernels = factory.kernels();
   for (auto& pair : kernels_) {
     for (auto& info_pair : pair.second) {
+      auto iter = kernels.find(pair.first);
       PADDLE_ENFORCE_EQ(
-          kernels[pair.first].find(info_pair.first),
-          kernels[pair.first].end(),
+          iter != kernels.end() && iter->second.count(info_pair.first) != 0,
+          false,
           phi::errors::AlreadyExists(
               "The kernel [%s:%s] has been already existed "
               "in Paddle, please contribute PR if it is necessary "
@@ -53,7 +55,7 @@ void CustomKernelMap::RegisterCustomKernels() {
               pair.first,
               info_pair.first));
 
-      kernels[pair.first][info_pair.first] = info_pair.second;
+      factory.AddKernel(pair.first, info_pair.first, info_pair.second);
 
       VLOG(3) << "Successed in registering kernel [" << pair.first << ":"
               << info_pair.first
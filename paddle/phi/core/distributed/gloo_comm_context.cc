@@ -136,6 +136,33 @@ void GlooCommContext::Scatter(phi::DenseTensor* out_tensor,
   gloo::scatter(opts);
 }
 
+void GlooCommContext::ReduceScatter(phi::DenseTensor* out_tensor,
+                                    const phi::DenseTensor& in_tensor,
+                                    int reduce_type,
+                                    uint32_t tag) {
+  RingReduceScatterOptions opts(gloo_context_);
+  opts.setTag(tag);
+  const auto& dtype = in_tensor.dtype();
+  GENERATE_FUNC(dtype, SetInput, &opts, in_tensor);
+  GENERATE_FUNC(dtype, SetOutput, &opts, out_tensor);
+  GENERATE_FUNC(dtype, SetReduceFunc, &opts, reduce_type);
+  ring_reduce_scatter(&opts);
+}
+
+void GlooCommContext::AllToAll(phi::DenseTensor* out_tensor,
+                               const phi::DenseTensor& in_tensor,
+                               const std::vector<int64_t>& out_numel_each_rank,
+                               const std::vector<int64_t>& in_numel_each_rank,
+                               uint32_t tag) {
+  AllToAllvOptions opts(gloo_context_);
+  opts.setTag(tag);
+  const auto& dtype = in_tensor.dtype();
+  GENERATE_FUNC(dtype, SetInput, &opts, in_tensor);
+  GENERATE_FUNC(dtype, SetOutput, &opts, out_tensor);
+  opts.setElements(out_numel_each_rank, in_numel_each_rank);
+  all_to_all_v(&opts);
+}
+
 void GlooCommContext::Barrier() {
   gloo::BarrierOptions opts(gloo_context_);
   gloo::barrier(opts);
@@ -18,6 +18,7 @@
 #include <gloo/transport/tcp/device.h>
 
 #include <memory>
+#include <vector>
 
 #include "paddle/common/macros.h"
 #include "paddle/phi/core/distributed/comm_context.h"
@@ -64,6 +65,22 @@ class GlooCommContext final : public CommContext {
                int size,
                uint32_t tag = 0);
 
+  // Ring reduce scatter, out_tensor receives the reduced numel / size
+  // elements of in_tensor that belong to this rank.
+  void ReduceScatter(phi::DenseTensor* out_tensor,
+                     const phi::DenseTensor& in_tensor,
+                     int reduce_type,
+                     uint32_t tag = 0);
+
+  // Sends in_numel_each_rank[i] elements of in_tensor to rank i and receives
+  // out_numel_each_rank[i] elements of out_tensor from rank i, both in the
+  // order of the ranks.
+  void AllToAll(phi::DenseTensor* out_tensor,
+                const phi::DenseTensor& in_tensor,
+                const std::vector<int64_t>& out_numel_each_rank,
+                const std::vector<int64_t>& in_numel_each_rank,
+                uint32_t tag = 0);
+
   void Barrier();
 
   void Send(const phi::DenseTensor& in_tensor, int dst, uint32_t tag = 0);
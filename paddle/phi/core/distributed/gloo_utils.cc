@@ -106,5 +106,131 @@ void send_recv(SendRecvOptions* opts) {
   }
 }
 
+void ring_reduce_scatter(RingReduceScatterOptions* opts) {
+  const auto& context = opts->context;
+  const int rank = context->rank;
+  const int size = context->size;
+  PADDLE_ENFORCE_EQ(
+      opts->in_elements,
+      opts->out_elements * size,
+      phi::errors::InvalidArgument(
+          "The input of reduce scatter must have %d times the elements of "
+          "the output, but got %d input elements and %d output elements.",
+          size,
+          opts->in_elements,
+          opts->out_elements));
+  const size_t bytes = opts->out_elements * opts->element_size;
+  char* in = static_cast<char*>(opts->in);
+  if (bytes == 0) {
+    return;
+  }
+  if (size == 1) {
+    std::memcpy(opts->out, in, bytes);
+    return;
+  }
+
+  // At step i, the partial result of block (rank - i - 1) is sent to the
+  // right neighbor, and the partial result of block (rank - i - 2) received
+  // from the left one is reduced with the local input. After size - 1 steps
+  // the block of this rank has been reduced by all the ranks. Two partial
+  // buffers alternate so that the one being sent is never written.
+  std::vector<char> buffer(3 * bytes);
+  char* partial = buffer.data();
+  char* recv = buffer.data() + 2 * bytes;
+  auto in_buffer = context->createUnboundBuffer(in, size * bytes);
+  auto partial_buffer = context->createUnboundBuffer(partial, 2 * bytes);
+  auto recv_buffer = context->createUnboundBuffer(recv, bytes);
+  const int left = (rank + size - 1) % size;
+  const int right = (rank + 1) % size;
+  const auto slot = gloo::Slot::build(kReduceScatterSlotPrefix, opts->tag);
+  for (int step = 0; step < size - 1; ++step) {
+    int send_block = (rank - step - 1 + 2 * size) % size;
+    int recv_block = (rank - step - 2 + 2 * size) % size;
+    auto* send_buffer = step == 0 ? in_buffer.get() : partial_buffer.get();
+    size_t send_offset =
+        step == 0 ? send_block * bytes : ((step - 1) % 2) * bytes;
+    send_buffer->send(right, slot, send_offset, bytes);
+    recv_buffer->recv(left, slot, 0, bytes);
+    recv_buffer->waitRecv(opts->timeout);
+    void* result = step == size - 2 ? opts->out : partial + (step % 2) * bytes;
+    opts->reduce(result, in + recv_block * bytes, recv, opts->out_elements);
+    send_buffer->waitSend(opts->timeout);
+  }
+}
+
+void all_to_all_v(AllToAllvOptions* opts) {
+  const auto& context = opts->context;
+  const int rank = context->rank;
+  const int size = context->size;
+  PADDLE_ENFORCE_EQ(
+      opts->in_elements.size() == static_cast<size_t>(size) &&
+          opts->out_elements.size() == static_cast<size_t>(size),
+      true,
+      phi::errors::InvalidArgument(
+          "The element counts of all to all must have %d entries, but got "
+          "%d for the input and %d for the output.",
+          size,
+          opts->in_elements.size(),
+          opts->out_elements.size()));
+  PADDLE_ENFORCE_EQ(
+      opts->in_elements[rank],
+      opts->out_elements[rank],
+      phi::errors::InvalidArgument(
+          "Rank %d of all to all sends %d elements to itself but receives %d.",
+          rank,
+          opts->in_elements[rank],
+          opts->out_elements[rank]));
+
+  const size_t element_size = opts->element_size;
+  std::vector<size_t> in_offsets(size, 0), out_offsets(size, 0);
+  for (int i = 1; i < size; ++i) {
+    in_offsets[i] = in_offsets[i - 1] + opts->in_elements[i - 1] * element_size;
+    out_offsets[i] =
+        out_offsets[i - 1] + opts->out_elements[i - 1] * element_size;
+  }
+  PADDLE_ENFORCE_LE(
+      in_offsets[size - 1] + opts->in_elements[size - 1] * element_size,
+      opts->in->size,
+      phi::errors::InvalidArgument(
+          "The input of all to all is smaller than the elements to send."));
+  PADDLE_ENFORCE_LE(
+      out_offsets[size - 1] + opts->out_elements[size - 1] * element_size,
+      opts->out->size,
+      phi::errors::InvalidArgument(
+          "The output of all to all is smaller than the elements to receive."));
+
+  // Step i sends to rank + i and receives from rank - i, so that every rank
+  // talks to a different peer at the same time. Empty blocks are skipped on
+  // both sides, as an unbound buffer takes 0 bytes as the rest of it.
+  const auto slot = gloo::Slot::build(kAllToAllSlotPrefix, opts->tag);
+  int send_num = 0, recv_num = 0;
+  for (int i = 1; i < size; ++i) {
+    int send_rank = (rank + i) % size;
+    int recv_rank = (rank + size - i) % size;
+    size_t send_bytes = opts->in_elements[send_rank] * element_size;
+    size_t recv_bytes = opts->out_elements[recv_rank] * element_size;
+    if (send_bytes > 0) {
+      opts->in->send(send_rank, slot, in_offsets[send_rank], send_bytes);
+      ++send_num;
+    }
+    if (recv_bytes > 0) {
+      opts->out->recv(recv_rank, slot, out_offsets[recv_rank], recv_bytes);
+      ++recv_num;
+    }
+  }
+  size_t self_bytes = opts->in_elements[rank] * element_size;
+  if (self_bytes > 0) {
+    std::memcpy(static_cast<char*>(opts->out->ptr) + out_offsets[rank],
+                static_cast<char*>(opts->in->ptr) + in_offsets[rank],
+                self_bytes);
+  }
+  for (int i = 0; i < send_num; ++i) {
+    opts->in->waitSend(opts->timeout);
+  }
+  for (int i = 0; i < recv_num; ++i) {
+    opts->out->waitRecv(opts->timeout);
+  }
+}
+
 }  // namespace distributed
 }  // namespace phi
@@ -22,6 +22,7 @@
 #include <climits>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "glog/logging.h"
 
@@ -208,5 +209,93 @@ class SendRecvOptions {
 
 void send_recv(SendRecvOptions* opts);
 
+// After the prefixes of the collectives of gloo and kSendRecvSlotPrefix.
+constexpr uint8_t kReduceScatterSlotPrefix = 0x10;
+constexpr uint8_t kAllToAllSlotPrefix = 0x11;
+
+// Options of the ring reduce scatter on the unbound buffers of gloo. The
+// input holds size blocks of the output elements, block i is reduced to the
+// output of rank i.
+class RingReduceScatterOptions {
+ public:
+  using ReduceFunction = void (*)(void*, const void*, const void*, size_t);
+
+  explicit RingReduceScatterOptions(
+      const std::shared_ptr<gloo::Context>& context)
+      : context(context), timeout(context->getTimeout()) {}
+
+  template <typename T>
+  void setInput(T* ptr, size_t elements) {
+    this->in = ptr;
+    this->in_elements = elements;
+    this->element_size = sizeof(T);
+  }
+
+  template <typename T>
+  void setOutput(T* ptr, size_t elements) {
+    this->out = ptr;
+    this->out_elements = elements;
+  }
+
+  void setReduceFunction(ReduceFunction fn) { this->reduce = fn; }
+
+  void setTag(uint32_t tag) { this->tag = tag; }
+
+ protected:
+  std::shared_ptr<gloo::Context> context;
+  void* in = nullptr;
+  void* out = nullptr;
+  size_t in_elements = 0;
+  size_t out_elements = 0;
+  size_t element_size = 0;
+  ReduceFunction reduce = nullptr;
+  uint32_t tag = 0;
+  std::chrono::milliseconds timeout;
+
+  friend void ring_reduce_scatter(RingReduceScatterOptions*);
+};
+
+void ring_reduce_scatter(RingReduceScatterOptions* opts);
+
+// Options of all to all with the element counts of every peer.
+class AllToAllvOptions {
+ public:
+  explicit AllToAllvOptions(const std::shared_ptr<gloo::Context>& context)
+      : context(context), timeout(context->getTimeout()) {}
+
+  template <typename T>
+  void setInput(T* ptr, size_t elements) {
+    this->in = context->createUnboundBuffer(ptr, elements * sizeof(T));
+    this->element_size = sizeof(T);
+  }
+
+  template <typename T>
+  void setOutput(T* ptr, size_t elements) {
+    this->out = context->createUnboundBuffer(ptr, elements * sizeof(T));
+  }
+
+  void setElements(const std::vector<int64_t>& out_elements,
+                   const std::vector<int64_t>& in_elements) {
+    this->out_elements = out_elements;
+    this->in_elements = in_elements;
+  }
+
+  void setTag(uint32_t tag) { this->tag = tag; }
+
+ protected:
+  std::shared_ptr<gloo::Context> context;
+  std::unique_ptr<gloo::transport::UnboundBuffer> in;
+  std::unique_ptr<gloo::transport::UnboundBuffer> out;
+  size_t element_size = 0;
+  std::vector<int64_t> out_elements;
+  std::vector<int64_t> in_elements;
+  uint32_t tag = 0;
+  std::chrono::milliseconds timeout;
+
+  friend void all_to_all_v(AllToAllvOptions*);
+};
+
+void all_to_all_v(AllToAllvOptions* opts);
+
 }  // namespace distributed
 }  // namespace phi
@@ -60,6 +60,29 @@ KernelFactory& KernelFactory::Instance() {
   return g_op_kernel_factory;
 }
 
+KernelNameId KernelFactory::GetKernelNameId(const std::string& kernel_name) {
+  std::lock_guard<std::mutex> guard(kernel_names_mutex_);
+  auto iter = kernel_name_ids_.find(kernel_name);
+  if (iter != kernel_name_ids_.end()) {
+    return iter->second;
+  }
+  auto id = static_cast<KernelNameId>(kernel_names_.size());
+  kernel_names_.push_back(kernel_name);
+  kernel_name_ids_.emplace(kernel_name, id);
+  return id;
+}
+
+const std::string& KernelFactory::GetKernelName(
+    KernelNameId kernel_name_id) const {
+  std::lock_guard<std::mutex> guard(kernel_names_mutex_);
+  PADDLE_ENFORCE_LT(
+      kernel_name_id,
+      kernel_names_.size(),
+      phi::errors::InvalidArgument("The kernel name id %d is not interned.",
+                                   kernel_name_id));
+  return kernel_names_[kernel_name_id];
+}
+
 bool KernelFactory::HasCompatiblePhiKernel(const std::string& op_type) const {
   if (deprecated_op_names.find(op_type) == deprecated_op_names.end()) {
     if (phi::OpUtilsMap::Instance().Contains(op_type) ||
@@ -342,6 +365,45 @@ KernelResult KernelFactory::SelectKernelOrThrowError(
   return {kernel_iter->second, false, false};
 }
 
+KernelSelectionCache::KernelSelectionCache(size_t capacity) {
+  size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  entries_.resize(size);
+  mask_ = size - 1;
+}
+
+KernelResult KernelSelectionCache::Select(KernelNameId kernel_name_id,
+                                          const KernelKey& kernel_key,
+                                          bool use_strided_kernel) {
+  auto& factory = KernelFactory::Instance();
+  uint64_t kernels_version = factory.kernels_version();
+  // the flags read by SelectKernelOrThrowError
+  uint32_t options = (FLAGS_use_stride_kernel && use_strided_kernel) |
+                     (FLAGS_enable_api_kernel_fallback << 1) |
+                     (FLAGS_run_kp_kernel << 2);
+  uint32_t hash = kernel_key.hash_value() ^ (kernel_name_id * 0x9e3779b9U);
+  Entry& entry = entries_[(hash ^ (hash >> 16)) & mask_];
+  if (entry.kernels_version == kernels_version &&
+      entry.kernel_name_id == kernel_name_id && entry.options == options &&
+      entry.kernel_key == kernel_key) {
+    ++hits_;
+    return {*entry.kernel, entry.has_fallback_cpu, entry.is_stride_kernel};
+  }
+  ++misses_;
+  auto result = factory.SelectKernelOrThrowError(
+      factory.GetKernelName(kernel_name_id), kernel_key, use_strided_kernel);
+  entry.kernels_version = kernels_version;
+  entry.kernel_name_id = kernel_name_id;
+  entry.options = options;
+  entry.kernel_key = kernel_key;
+  entry.kernel = &result.kernel;
+  entry.has_fallback_cpu = result.has_fallback_cpu;
+  entry.is_stride_kernel = result.is_stride_kernel;
+  return result;
+}
+
 const KernelArgsDef& KernelFactory::GetFirstKernelArgsDef(
     const std::string& kernel_name) const {
   auto iter = kernels_.find(kernel_name);
@@ -525,7 +587,7 @@ std::string KernelSelectionErrorMessage(const std::string& kernel_name,
   std::unordered_set<std::string> dtype_set;
 
   // Record all kernel information of kernel_name
-  for (auto const& iter : KernelFactory::Instance().kernels()[kernel_name]) {
+  for (auto const& iter : KernelFactory::Instance().kernels().at(kernel_name)) {
     KernelKey kernel_key = iter.first;
     if (kernel_key.backend() == target_key.backend()) {
       support_backend = true;
@@ -14,10 +14,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include "paddle/common/layout.h"
 #include "paddle/phi/common/backend.h"
 #include "paddle/phi/common/data_type.h"
@@ -296,6 +300,9 @@ using KernelKeyMap = paddle::flat_hash_map<KernelKey, Kernel, KernelKey::Hash>;
 
 using KernelNameMap = paddle::flat_hash_map<std::string, KernelKeyMap>;
 
+// The id of an interned kernel name, see KernelFactory::GetKernelNameId.
+using KernelNameId = uint32_t;
+
 struct KernelResult {
   KernelResult(const Kernel& kernel, bool fallback_cpu, bool is_stride_kernel)
       : kernel(kernel),
@@ -317,7 +324,34 @@ class KernelFactory {
  public:
   static KernelFactory& Instance();
 
-  KernelNameMap& kernels() { return kernels_; }
+  const KernelNameMap& kernels() const { return kernels_; }
+
+  // Register or replace a kernel. The kernels version is bumped after the
+  // map has changed, so KernelSelectionCache never keeps a Kernel pointer
+  // selected before the change.
+  void AddKernel(const std::string& kernel_name,
+                 const KernelKey& kernel_key,
+                 const Kernel& kernel) {
+    kernels_[kernel_name][kernel_key] = kernel;
+    kernels_version_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void ClearKernels() {
+    kernels_.clear();
+    kernels_version_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Increased whenever the registered kernels may change.
+  uint64_t kernels_version() const {
+    return kernels_version_.load(std::memory_order_relaxed);
+  }
+
+  // Intern the kernel name, so that the kernel can be selected by the id
+  // through a KernelSelectionCache without hashing the name. The id of a name
+  // never changes, and the kernel needs not be registered yet.
+  KernelNameId GetKernelNameId(const std::string& kernel_name);
+
+  const std::string& GetKernelName(KernelNameId kernel_name_id) const;
 
   bool HasCompatiblePhiKernel(const std::string& op_type) const;
 
@@ -352,11 +386,55 @@ class KernelFactory {
   KernelFactory() = default;
 
   KernelNameMap kernels_;
+  std::atomic<uint64_t> kernels_version_{1};
+
+  mutable std::mutex kernel_names_mutex_;
+  std::unordered_map<std::string, KernelNameId> kernel_name_ids_;
+  // deque keeps the references returned by GetKernelName valid
+  std::deque<std::string> kernel_names_;
 
   // Get the low precision kernel list of current module.
   std::map<const std::string, OpCount> low_precision_kernels_;
 };
 
+/**
+ * A direct mapped cache of the results of SelectKernelOrThrowError, keyed by
+ * the interned kernel name and the kernel key. It is meant to be a thread
+ * local object at a call site selecting kernels repeatedly, e.g. the generated
+ * APIs, to skip hashing the kernel name and the fallback logic. It is not
+ * thread safe. The cached results are dropped once the registered kernels or
+ * the flags affecting the selection change.
+ */
+class KernelSelectionCache {
+ public:
+  // The capacity is rounded up to a power of 2.
+  explicit KernelSelectionCache(size_t capacity = 4);
+
+  KernelResult Select(KernelNameId kernel_name_id,
+                      const KernelKey& kernel_key,
+                      bool use_strided_kernel = false);
+
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+
+ private:
+  struct Entry {
+    // 0 marks an empty entry, kernels_version starts from 1
+    uint64_t kernels_version{0};
+    KernelNameId kernel_name_id{0};
+    uint32_t options{0};
+    KernelKey kernel_key;
+    const Kernel* kernel{nullptr};
+    bool has_fallback_cpu{false};
+    bool is_stride_kernel{false};
+  };
+
+  std::vector<Entry> entries_;
+  size_t mask_;
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+};
+
 inline std::ostream& operator<<(std::ostream& os, const KernelKey& kernel_key) {
   os << "(" << kernel_key.backend() << ", " << kernel_key.layout() << ", "
      << kernel_key.dtype() << ")";
@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "paddle/phi/kernels/fused_adam_kernel.h"
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "paddle/phi/core/kernel_registry.h"
@@ -20,9 +22,22 @@
 
 #include "paddle/phi/kernels/adam_kernel.h"
 #include "paddle/phi/kernels/adamw_kernel.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
 
 namespace phi {
 
+// The elements of a chunk when the attr chunk_size is not positive.
+static constexpr int64_t kFusedAdamDefaultChunkSize = 4096;
+
+// A range of the elements of a parameter, the parameters are flattened to
+// the chunks so that the threads share the update of many small parameters
+// as well as of a large one.
+struct FusedAdamChunk {
+  size_t idx;
+  int64_t offset;
+  int64_t numel;
+};
+
 static paddle::optional<DenseTensor> TensorPtrToOptionalTensor(
     const paddle::optional<std::vector<const DenseTensor*>>& t, size_t idx) {
   return t ? paddle::optional<DenseTensor>(*(t.get()[idx])) : paddle::none;
@@ -96,61 +111,176 @@ void FusedAdamKernel(
                         beta2_pows.size(),
                         params_num));
 
+  bool skip_update_ = false;
+  if (skip_update.is_initialized()) {
+    PADDLE_ENFORCE_EQ(
+        skip_update->numel(),
+        1,
+        errors::InvalidArgument("Input(SkipUpdate) size must be 1, but get %d",
+                                skip_update->numel()));
+    std::vector<bool> skip_update_vec;
+    phi::TensorToVector(*skip_update, dev_ctx, &skip_update_vec);
+    skip_update_ = skip_update_vec[0];
+  }
+  // skip_update=true, the kernels of a parameter copy the inputs to the
+  // outputs
+  if (skip_update_) {
+    for (size_t idx = 0; idx < params_num; idx++) {
+      auto master_params_tmp = TensorPtrToOptionalTensor(master_params, idx);
+      if (!use_adamw) {
+        AdamDenseKernel<T, Context>(
+            dev_ctx,
+            *params[idx],
+            *grads[idx],
+            learning_rate,
+            *moments1[idx],
+            *moments2[idx],
+            *beta1_pows[idx],
+            *beta2_pows[idx],
+            master_params_tmp,
+            skip_update,
+            beta1,
+            beta2,
+            epsilon,
+            false,
+            1000,
+            multi_precision,
+            use_global_beta_pow,
+            params_out[idx],
+            moments1_out[idx],
+            moments2_out[idx],
+            beta1_pows_out[idx],
+            beta2_pows_out[idx],
+            master_params_out.empty() ? nullptr : master_params_out[idx]);
+      } else {
+        AdamwDenseKernel<T, Context>(
+            dev_ctx,
+            *params[idx],
+            *grads[idx],
+            learning_rate,
+            *moments1[idx],
+            *moments2[idx],
+            *beta1_pows[idx],
+            *beta2_pows[idx],
+            master_params_tmp,
+            skip_update,
+            beta1,
+            beta2,
+            epsilon,
+            1.0,
+            weight_decay,
+            use_adamw,
+            false,
+            1000,
+            multi_precision,
+            use_global_beta_pow,
+            params_out[idx],
+            moments1_out[idx],
+            moments2_out[idx],
+            beta1_pows_out[idx],
+            beta2_pows_out[idx],
+            master_params_out.empty() ? nullptr : master_params_out[idx]);
+      }
+    }
+    return;
+  }
+
+  T beta1_ = beta1.to<T>();
+  T beta2_ = beta2.to<T>();
+  T epsilon_ = epsilon.to<T>();
+  T coeff_ = static_cast<T>(weight_decay);
+  T lr = learning_rate.data<T>()[0];
+
+  // The bias corrected learning rate and epsilon of every parameter, the
+  // outputs are allocated here as Alloc may not be called by the threads.
+  std::vector<T> lrs(params_num);
+  std::vector<T> epss(params_num);
+  std::vector<FusedAdamChunk> chunks;
+  const int64_t chunk_numel =
+      chunk_size > 0 ? chunk_size : kFusedAdamDefaultChunkSize;
   for (size_t idx = 0; idx < params_num; idx++) {
-    auto master_params_tmp = TensorPtrToOptionalTensor(master_params, idx);
-    if (!use_adamw) {
-      AdamDenseKernel<T, Context>(
-          dev_ctx,
-          *params[idx],
-          *grads[idx],
-          learning_rate,
-          *moments1[idx],
-          *moments2[idx],
-          *beta1_pows[idx],
-          *beta2_pows[idx],
-          master_params_tmp,
-          skip_update,
-          beta1,
-          beta2,
-          epsilon,
-          false,
-          1000,
-          multi_precision,
-          use_global_beta_pow,
-          params_out[idx],
-          moments1_out[idx],
-          moments2_out[idx],
-          beta1_pows_out[idx],
-          beta2_pows_out[idx],
-          master_params_out.empty() ? nullptr : master_params_out[idx]);
+    PADDLE_ENFORCE_EQ(
+        beta1_pows_out[idx]->numel(),
+        1,
+        errors::InvalidArgument("beta1 pow output size should be 1, but "
+                                "received value is:%d.",
+                                beta1_pows_out[idx]->numel()));
+    PADDLE_ENFORCE_EQ(
+        beta2_pows_out[idx]->numel(),
+        1,
+        errors::InvalidArgument("beta2 pow output size should be 1, but "
+                                "received value is:%d.",
+                                beta2_pows_out[idx]->numel()));
+    T beta1_p = beta1_pows[idx]->data<T>()[0];
+    T beta2_p = beta2_pows[idx]->data<T>()[0];
+    if (!use_global_beta_pow) {
+      dev_ctx.template Alloc<T>(beta1_pows_out[idx])[0] = beta1_ * beta1_p;
+      dev_ctx.template Alloc<T>(beta2_pows_out[idx])[0] = beta2_ * beta2_p;
+    }
+    lrs[idx] = lr * (sqrt(1 - beta2_p) / (1 - beta1_p));
+    epss[idx] = epsilon_ * sqrt(1 - beta2_p);
+
+    dev_ctx.template Alloc<T>(params_out[idx]);
+    dev_ctx.template Alloc<T>(moments1_out[idx]);
+    dev_ctx.template Alloc<T>(moments2_out[idx]);
+
+    int64_t numel = params[idx]->numel();
+    for (int64_t offset = 0; offset < numel; offset += chunk_numel) {
+      chunks.push_back({idx, offset, std::min(chunk_numel, numel - offset)});
+    }
+  }
+
+  auto adam =
+      phi::jit::KernelFuncs<phi::jit::AdamTuple<T>, phi::CPUPlace>::Cache().At(
+          phi::jit::adam_attr_t(beta1_, beta2_));
+  auto adamw =
+      phi::jit::KernelFuncs<phi::jit::AdamWTuple<T>, phi::CPUPlace>::Cache().At(
+          1);
+
+  int64_t chunks_num = static_cast<int64_t>(chunks.size());
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t i = 0; i < chunks_num; ++i) {
+    const FusedAdamChunk& chunk = chunks[i];
+    const size_t idx = chunk.idx;
+    const int64_t offset = chunk.offset;
+    const T* grad_ptr = grads[idx]->data<T>() + offset;
+    const T* mom1_ptr = moments1[idx]->data<T>() + offset;
+    const T* mom2_ptr = moments2[idx]->data<T>() + offset;
+    const T* param_ptr = params[idx]->data<T>() + offset;
+    T* mom1_out_ptr = moments1_out[idx]->data<T>() + offset;
+    T* mom2_out_ptr = moments2_out[idx]->data<T>() + offset;
+    T* param_out_ptr = params_out[idx]->data<T>() + offset;
+    if (use_adamw) {
+      adamw(beta1_,
+            beta2_,
+            -lrs[idx],
+            epss[idx],
+            lr,
+            static_cast<T>(1.0),
+            coeff_,
+            chunk.numel,
+            grad_ptr,
+            mom1_ptr,
+            mom2_ptr,
+            param_ptr,
+            mom1_out_ptr,
+            mom2_out_ptr,
+            param_out_ptr);
     } else {
-      AdamwDenseKernel<T, Context>(
-          dev_ctx,
-          *params[idx],
-          *grads[idx],
-          learning_rate,
-          *moments1[idx],
-          *moments2[idx],
-          *beta1_pows[idx],
-          *beta2_pows[idx],
-          master_params_tmp,
-          skip_update,
-          beta1,
-          beta2,
-          epsilon,
-          1.0,
-          weight_decay,
-          use_adamw,
-          false,
-          1000,
-          multi_precision,
-          use_global_beta_pow,
-          params_out[idx],
-          moments1_out[idx],
-          moments2_out[idx],
-          beta1_pows_out[idx],
-          beta2_pows_out[idx],
-          master_params_out.empty() ? nullptr : master_params_out[idx]);
+      adam(beta1_,
+           beta2_,
+           -lrs[idx],
+           epss[idx],
+           chunk.numel,
+           grad_ptr,
+           mom1_ptr,
+           mom2_ptr,
+           param_ptr,
+           mom1_out_ptr,
+           mom2_out_ptr,
+           param_out_ptr);
     }
   }
 }
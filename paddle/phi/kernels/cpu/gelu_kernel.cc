@@ -16,15 +16,21 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "glog/logging.h"
 
+#include "paddle/common/flags.h"
 #include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
 #include "paddle/phi/kernels/funcs/blas/blas_impl.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
+
+COMMON_DECLARE_bool(use_jit_softmax_gelu);
 
 namespace phi {
 
@@ -93,6 +99,16 @@ void GeluKernel(const Context& dev_ctx,
                 bool approximate,
                 DenseTensor* out) {
   dev_ctx.template Alloc<T>(out);
+  if (std::is_same<T, float>::value && FLAGS_use_jit_softmax_gelu &&
+      x.numel() <= std::numeric_limits<int>::max() &&
+      phi::backends::cpu::MayIUse(phi::backends::cpu::avx)) {
+    // the jit kernel is generated once per approximate for all the sizes
+    auto gelu = phi::jit::KernelFuncs<phi::jit::GeluTuple<T>,
+                                      phi::CPUPlace>::Cache()
+                    .At(approximate);
+    gelu(x.data<T>(), out->data<T>(), static_cast<int>(x.numel()), approximate);
+    return;
+  }
   auto eigen_out = EigenVector<T>::Flatten(*out);
   auto eigen_x = EigenVector<T>::Flatten(x);
   auto& dev = *dev_ctx.eigen_device();
@@ -0,0 +1,123 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/llm_int8_linear_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/cpu_weight_only_gemm.h"
+
+namespace phi {
+
+// LLM.int8(): the columns of x holding a value larger than threshold are
+// multiplied in float with the dequantized weight, the other ones are
+// quantized per row to int8 and multiplied with the int8 weight in int32.
+// The weight is [n, k] as quantized by weight_quantize with algo llm.int8,
+// weight_scale is max(|w|) / 127 per output channel.
+template <typename T, typename Context>
+void LLMInt8LinearKernel(const Context& dev_ctx,
+                         const DenseTensor& x,
+                         const DenseTensor& weight,
+                         const paddle::optional<DenseTensor>& bias,
+                         const DenseTensor& weight_scale,
+                         const float threshold,
+                         DenseTensor* out) {
+  T* out_data = dev_ctx.template Alloc<T>(out);
+  const auto w_dims = weight.dims();
+  int n = w_dims[0];
+  int k = w_dims[1];
+  int m = x.numel() / k;
+  if (m == 0) return;
+  const T* x_data = x.data<T>();
+  const int8_t* w_data = weight.data<int8_t>();
+
+  // the scale is float as the GPU kernel takes, or of the type of x as
+  // weight_quantize writes
+  std::vector<float> w_scale(n);
+  if (weight_scale.dtype() == phi::DataType::FLOAT32) {
+    std::copy_n(weight_scale.data<float>(), n, w_scale.begin());
+  } else {
+    std::copy_n(weight_scale.data<T>(), n, w_scale.begin());
+  }
+
+  std::vector<int> outliers;
+  std::vector<bool> is_outlier(k, false);
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    int col = i % k;
+    if (!is_outlier[col] &&
+        std::fabs(static_cast<float>(x_data[i])) > threshold) {
+      is_outlier[col] = true;
+    }
+  }
+  for (int c = 0; c < k; ++c) {
+    if (is_outlier[c]) outliers.push_back(c);
+  }
+
+  // int8 x and the range of each row without the outliers
+  std::vector<int8_t> x_int8(static_cast<size_t>(m) * k);
+  std::vector<float> row_range(m);
+  for (int i = 0; i < m; ++i) {
+    const T* row = x_data + static_cast<int64_t>(i) * k;
+    float range = 0;
+    for (int c = 0; c < k; ++c) {
+      if (!is_outlier[c]) {
+        range = std::max(range, std::fabs(static_cast<float>(row[c])));
+      }
+    }
+    row_range[i] = range;
+    float inv = range > 0 ? 127.0f / range : 0;
+    int8_t* q = x_int8.data() + static_cast<int64_t>(i) * k;
+    for (int c = 0; c < k; ++c) {
+      float v = std::round(static_cast<float>(row[c]) * inv);
+      v = std::min(127.0f, std::max(-127.0f, v));
+      q[c] = is_outlier[c] ? 0 : static_cast<int8_t>(v);
+    }
+  }
+
+  const T* bias_data = bias ? bias.get().data<T>() : nullptr;
+  auto dot_int8 = funcs::GetDotInt8();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int j = 0; j < n; ++j) {
+    const int8_t* w_row = w_data + static_cast<int64_t>(j) * k;
+    for (int i = 0; i < m; ++i) {
+      int32_t acc =
+          dot_int8(x_int8.data() + static_cast<int64_t>(i) * k, w_row, k);
+      float v = acc * row_range[i] / 127.0f * w_scale[j];
+      const T* row = x_data + static_cast<int64_t>(i) * k;
+      for (int c : outliers) {
+        v += static_cast<float>(row[c]) * w_row[c] * w_scale[j];
+      }
+      if (bias_data) {
+        v += static_cast<float>(bias_data[j]);
+      }
+      out_data[static_cast<int64_t>(i) * n + j] = static_cast<T>(v);
+    }
+  }
+}
+
+}  // namespace phi
+
+PD_REGISTER_KERNEL(llm_int8_linear,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::LLMInt8LinearKernel,
+                   float,
+                   phi::dtype::float16,
+                   phi::dtype::bfloat16) {}
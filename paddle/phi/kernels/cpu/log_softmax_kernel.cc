@@ -14,13 +14,18 @@
 
 #include "paddle/phi/kernels/log_softmax_kernel.h"
 
+#include "paddle/common/flags.h"
 #include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/kernels/funcs/axis_utils.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
+COMMON_DECLARE_bool(use_jit_softmax_gelu);
+
 namespace phi {
 
 template <typename T,
@@ -58,6 +63,17 @@ struct LogSoftmaxFunctor {
     const int num_classes = logits.dimension(kClassDim);
     const int num_remain = num_classes / axis_dim;
 
+    if (num_remain == 1 && std::is_same<T, float>::value &&
+        FLAGS_use_jit_softmax_gelu &&
+        phi::backends::cpu::MayIUse(phi::backends::cpu::avx)) {
+      // axis == -1, the jit kernel computes a row in three passes over it
+      auto compute = phi::jit::KernelFuncs<phi::jit::LogSoftmaxTuple<T>,
+                                           phi::CPUPlace>::Cache()
+                         .At(num_classes);
+      compute(X->data<T>(), Y->data<T>(), num_classes, batch_size);
+      return;
+    }
+
     Eigen::DSizes<int, 1> along_axis(kAxisDim);
     Eigen::DSizes<int, 2> batch_classes(batch_size, num_classes);
     Eigen::DSizes<int, 2> batch_by_one(batch_size, 1);
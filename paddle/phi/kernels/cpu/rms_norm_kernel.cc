@@ -0,0 +1,115 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/rms_norm_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+namespace phi {
+
+template <typename T, typename Context>
+void RmsNormKernel(const Context& dev_ctx,
+                   const DenseTensor& x,
+                   const paddle::optional<DenseTensor>& bias,
+                   const paddle::optional<DenseTensor>& residual,
+                   const DenseTensor& norm_weight,
+                   const paddle::optional<DenseTensor>& norm_bias,
+                   const float epsilon,
+                   const int begin_norm_axis,
+                   const float quant_scale,
+                   const int quant_round_type,
+                   const float quant_max_bound,
+                   const float quant_min_bound,
+                   DenseTensor* out,
+                   DenseTensor* residual_out) {
+  int64_t rows = 1;
+  int64_t cols = 1;
+  for (int i = 0; i < begin_norm_axis; i++) {
+    rows *= x.dims()[i];
+  }
+  for (int i = begin_norm_axis; i < x.dims().size(); i++) {
+    cols *= x.dims()[i];
+  }
+
+  const T* x_data = x.data<T>();
+  const T* norm_weight_data = norm_weight.data<T>();
+  const T* norm_bias_data = norm_bias ? norm_bias.get().data<T>() : nullptr;
+  const T* residual_data = residual ? residual.get().data<T>() : nullptr;
+  const T* bias_data = bias ? bias.get().data<T>() : nullptr;
+  T* residual_out_data =
+      residual ? dev_ctx.template Alloc<T>(residual_out) : nullptr;
+  T* out_data = nullptr;
+  int8_t* quant_out_data = nullptr;
+  if (quant_scale <= 0.0f) {
+    out_data = dev_ctx.template Alloc<T>(out);
+  } else {
+    quant_out_data = dev_ctx.template Alloc<int8_t>(out);
+  }
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < rows; ++i) {
+    std::vector<float> row(cols);
+    const T* x_row = x_data + i * cols;
+    // RMSNorm(x + bias + residual), the sum is the residual_out
+    for (int64_t j = 0; j < cols; ++j) {
+      row[j] = static_cast<float>(x_row[j]);
+    }
+    if (residual_data) {
+      const T* residual_row = residual_data + i * cols;
+      for (int64_t j = 0; j < cols; ++j) {
+        row[j] += static_cast<float>(residual_row[j]);
+        if (bias_data) {
+          row[j] += static_cast<float>(bias_data[j]);
+        }
+        residual_out_data[i * cols + j] = static_cast<T>(row[j]);
+      }
+    }
+    float square_sum = 0;
+    for (int64_t j = 0; j < cols; ++j) {
+      square_sum += row[j] * row[j];
+    }
+    float inv_rms = 1.0f / std::sqrt(square_sum / cols + epsilon);
+    for (int64_t j = 0; j < cols; ++j) {
+      float v = row[j] * inv_rms * static_cast<float>(norm_weight_data[j]);
+      if (norm_bias_data) {
+        v += static_cast<float>(norm_bias_data[j]);
+      }
+      if (out_data) {
+        out_data[i * cols + j] = static_cast<T>(v);
+        continue;
+      }
+      float q = quant_max_bound * quant_scale * v;
+      q = quant_round_type == 0 ? std::rint(q) : std::round(q);
+      q = std::min(quant_max_bound, std::max(quant_min_bound, q));
+      quant_out_data[i * cols + j] = static_cast<int8_t>(q);
+    }
+  }
+}
+
+}  // namespace phi
+
+PD_REGISTER_KERNEL(rms_norm,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::RmsNormKernel,
+                   float,
+                   phi::dtype::float16,
+                   phi::dtype::bfloat16) {}
@@ -0,0 +1,110 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/top_p_sampling_kernel.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/generator.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+namespace phi {
+
+// The candidates sorted first, the sort goes on to the whole vocabulary only
+// for the rows whose top candidates do not reach the sampled probability.
+constexpr int kTopPSortFirst = 64;
+
+template <typename T, typename Context>
+void TopPSamplingKernel(const Context& dev_ctx,
+                        const DenseTensor& x,
+                        const DenseTensor& ps,
+                        const paddle::optional<DenseTensor>& threshold,
+                        int random_seed,
+                        DenseTensor* out,
+                        DenseTensor* ids) {
+  const auto& in_dims = x.dims();
+  int bs = in_dims[0];
+  int vocab_size = in_dims[1];
+  T* out_data = dev_ctx.template Alloc<T>(out);
+  int64_t* ids_data = dev_ctx.template Alloc<int64_t>(ids);
+  const T* x_data = x.data<T>();
+  const T* ps_data = ps.data<T>();
+  const T* threshold_data = threshold ? threshold->data<T>() : nullptr;
+
+  std::shared_ptr<std::mt19937_64> engine;
+  if (random_seed == -1) {
+    engine = dev_ctx.GetGenerator()->GetCPUEngine();
+  } else {
+    engine = std::make_shared<std::mt19937_64>(random_seed);
+  }
+  std::uniform_real_distribution<float> dist(0, 1);
+
+  std::vector<int> index(vocab_size);
+  for (int i = 0; i < bs; ++i) {
+    const T* probs = x_data + static_cast<int64_t>(i) * vocab_size;
+    float rand_top_p = dist(*engine) * static_cast<float>(ps_data[i]);
+    float threshold_now =
+        threshold_data ? static_cast<float>(threshold_data[i]) : 0.f;
+    auto greater = [probs](int a, int b) {
+      float pa = static_cast<float>(probs[a]);
+      float pb = static_cast<float>(probs[b]);
+      return pa > pb || (pa == pb && a < b);
+    };
+    std::iota(index.begin(), index.end(), 0);
+    int sorted = std::min(kTopPSortFirst, vocab_size);
+    std::partial_sort(
+        index.begin(), index.begin() + sorted, index.end(), greater);
+
+    int picked = -1;
+    float sum_prob = 0;
+    for (int j = 0; j < vocab_size; ++j) {
+      if (j == sorted) {
+        std::sort(index.begin() + sorted, index.end(), greater);
+        sorted = vocab_size;
+      }
+      sum_prob += static_cast<float>(probs[index[j]]);
+      if (sum_prob >= rand_top_p) {
+        picked = j;
+        break;
+      }
+    }
+    // the rounding of the sum may miss rand_top_p close to 1
+    if (picked < 0) {
+      picked = vocab_size - 1;
+    }
+    // don't sample the low score tokens, as the GPU kernel
+    while (picked > 0 &&
+           static_cast<float>(probs[index[picked]]) < threshold_now) {
+      --picked;
+    }
+    ids_data[i] = index[picked];
+    out_data[i] = probs[index[picked]];
+  }
+}
+
+}  // namespace phi
+
+PD_REGISTER_KERNEL(top_p_sampling,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::TopPSamplingKernel,
+                   float,
+                   phi::dtype::float16,
+                   phi::dtype::bfloat16) {
+  kernel->OutputAt(1).SetDataType(phi::DataType::INT64);
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/weight_only_linear_kernel.h"
+
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/cpu_weight_only_gemm.h"
+
+namespace phi {
+
+template <typename T, typename Context>
+void WeightOnlyLinearKernel(const Context& dev_ctx,
+                            const DenseTensor& x,
+                            const DenseTensor& weight,
+                            const paddle::optional<DenseTensor>& bias,
+                            const DenseTensor& weight_scale,
+                            const std::string& weight_dtype,
+                            const int32_t arch,
+                            const int32_t group_size,
+                            DenseTensor* out) {
+  PADDLE_ENFORCE_EQ(
+      arch,
+      0,
+      phi::errors::InvalidArgument(
+          "The CPU kernel of weight_only_linear takes the weight quantized by "
+          "weight_quantize with arch 0, but got arch %d.",
+          arch));
+  T* out_data = dev_ctx.template Alloc<T>(out);
+  const auto w_dims = weight.dims();
+  int n = group_size > 0 ? weight_scale.dims()[1] : weight_scale.dims()[0];
+  int k = w_dims[1];
+  int m = x.numel() / k;
+  if (m == 0) return;
+
+  const T* x_data = x.data<T>();
+  std::vector<float> x_float(x_data, x_data + x.numel());
+  const T* scale_data = weight_scale.data<T>();
+  std::vector<float> scale(scale_data, scale_data + weight_scale.numel());
+  std::vector<float> out_float(static_cast<size_t>(m) * n);
+
+  if (weight_dtype == "int8") {
+    funcs::WeightOnlyGemm<8>(dev_ctx,
+                             x_float.data(),
+                             weight.data<int8_t>(),
+                             scale.data(),
+                             m,
+                             n,
+                             k,
+                             group_size,
+                             out_float.data());
+  } else if (weight_dtype == "int4") {
+    funcs::WeightOnlyGemm<4>(dev_ctx,
+                             x_float.data(),
+                             weight.data<int8_t>(),
+                             scale.data(),
+                             m,
+                             n,
+                             k,
+                             group_size,
+                             out_float.data());
+  } else {
+    PADDLE_THROW(phi::errors::InvalidArgument(
+        "The weight_dtype must be int8 or int4, but got %s.", weight_dtype));
+  }
+
+  const T* bias_data = bias ? bias.get().data<T>() : nullptr;
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      float v = out_float[static_cast<size_t>(i) * n + j];
+      if (bias_data) {
+        v += static_cast<float>(bias_data[j]);
+      }
+      out_data[static_cast<size_t>(i) * n + j] = static_cast<T>(v);
+    }
+  }
+}
+
+}  // namespace phi
+
+PD_REGISTER_KERNEL(weight_only_linear,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::WeightOnlyLinearKernel,
+                   float,
+                   phi::dtype::float16,
+                   phi::dtype::bfloat16) {}
@@ -31,10 +31,11 @@ void quant_compute(const DeviceContext& dev_ctx,
                    const int32_t arch,
                    const int32_t group_size) {
   PADDLE_ENFORCE_EQ(
-      ((arch == 80) || (arch == 86) || (arch == 75) || (arch == 70)),
+      ((arch == 80) || (arch == 86) || (arch == 75) || (arch == 70) ||
+       (arch == 0)),
       true,
       phi::errors::InvalidArgument(
-          "Currently, arch only support 70, 75, 80, 86."));
+          "Currently, arch only support 0 (the CPU kernels), 70, 75, 80, 86."));
 
   const auto x_dims = x.dims();
   PADDLE_ENFORCE_EQ(
@@ -53,7 +54,7 @@ void quant_compute(const DeviceContext& dev_ctx,
   DenseTensor x_int(out->type());
 
   if ((arch == 80) || (arch == 75) || (arch == 86) || (arch == 89) ||
-      (arch == 90)) {
+      (arch == 90) || (arch == 0)) {
     x_int.Resize({static_cast<int64_t>(m), static_cast<int64_t>(n)});
   } else {
     // phi::Copy may change tensor meta info, here we transpose the quanted
@@ -91,7 +92,9 @@ void quant_compute(const DeviceContext& dev_ctx,
     funcs::Transpose<DeviceContext, int8_t, 2> trans;
     trans(dev_ctx, x_int, out, axis);
   } else {
-    if (arch == 70) {
+    if (arch == 0) {
+      pack_weight_for_cpu<bits>(out_data, x_int_data, m, n);
+    } else if (arch == 70) {
       // Note(Zhengzekang): In sm70, we only need RowMajor layout, just add bias
       // to make it unsigned.
       add_bias_and_interleave_inplace<bits>(x_int_data, num);
@@ -142,5 +145,6 @@ PD_REGISTER_KERNEL(weight_quantize,
                    CPU,
                    ALL_LAYOUT,
                    phi::WeightQuantizeKernel,
+                   float,
                    phi::dtype::float16,
                    phi::dtype::bfloat16) {}
@@ -0,0 +1,98 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/funcs/cpu_weight_only_gemm.h"
+
+#include "paddle/phi/backends/cpu/cpu_info.h"
+
+// The AVX2 and AVX512 VNNI versions are compiled for their instructions by
+// the target attributes, whatever the flags of the build, and only called
+// when MayIUse finds them on the CPU.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PADDLE_WITH_INT8_DOT_DISPATCH
+#endif
+
+namespace phi {
+namespace funcs {
+
+#ifdef PADDLE_WITH_INT8_DOT_DISPATCH
+
+// vpmaddwd of the int8 widened to int16 sums the products of 16 pairs into 8
+// int32, exactly.
+__attribute__((target("avx2"))) static int32_t DotInt8AVX2(const int8_t* x,
+                                                            const int8_t* y,
+                                                            int k) {
+  __m256i acc = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 16 <= k; i += 16) {
+    __m256i vx = _mm256_cvtepi8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+    __m256i vy = _mm256_cvtepi8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i)));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(vx, vy));
+  }
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc),
+                              _mm256_extracti128_si256(acc, 1));
+  sum = _mm_hadd_epi32(sum, sum);
+  sum = _mm_hadd_epi32(sum, sum);
+  int32_t res = _mm_cvtsi128_si32(sum);
+  for (; i < k; ++i) {
+    res += static_cast<int32_t>(x[i]) * static_cast<int32_t>(y[i]);
+  }
+  return res;
+}
+
+// vpdpbusd multiplies unsigned by signed int8, so x is offset by 128 into
+// uint8 and 128 * sum(y) is taken off again, the sum by vpdpbusd of ones.
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) static int32_t
+DotInt8AVX512VNNI(const int8_t* x, const int8_t* y, int k) {
+  const __m512i offset = _mm512_set1_epi8(static_cast<char>(0x80));
+  const __m512i ones = _mm512_set1_epi8(1);
+  __m512i acc = _mm512_setzero_si512();
+  __m512i y_sum = _mm512_setzero_si512();
+  int i = 0;
+  for (; i + 64 <= k; i += 64) {
+    __m512i vx = _mm512_xor_si512(_mm512_loadu_si512(x + i), offset);
+    __m512i vy = _mm512_loadu_si512(y + i);
+    acc = _mm512_dpbusd_epi32(acc, vx, vy);
+    y_sum = _mm512_dpbusd_epi32(y_sum, ones, vy);
+  }
+  int32_t res = _mm512_reduce_add_epi32(acc) -
+                128 * _mm512_reduce_add_epi32(y_sum);
+  for (; i < k; ++i) {
+    res += static_cast<int32_t>(x[i]) * static_cast<int32_t>(y[i]);
+  }
+  return res;
+}
+
+#endif
+
+DotInt8Func GetDotInt8() {
+  static DotInt8Func func = []() -> DotInt8Func {
+#ifdef PADDLE_WITH_INT8_DOT_DISPATCH
+    if (backends::cpu::MayIUse(backends::cpu::avx512_core_vnni)) {
+      return DotInt8AVX512VNNI;
+    }
+    if (backends::cpu::MayIUse(backends::cpu::avx2)) {
+      return DotInt8AVX2;
+    }
+#endif
+    return DotInt8;
+  }();
+  return func;
+}
+
+}  // namespace funcs
+}  // namespace phi
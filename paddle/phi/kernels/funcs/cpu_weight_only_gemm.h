@@ -0,0 +1,186 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
+
+namespace phi {
+namespace funcs {
+
+// The GEMMs of the CPU kernels of weight_only_linear and llm_int8_linear. The
+// weight is row-major [n, k] as packed by pack_weight_for_cpu, so that an
+// output channel reads a contiguous row of int8, or of int4 pairs.
+
+// The rows of up to kWeightOnlyGemvMaxM inputs, e.g. the decode steps of a
+// batch, share the dequantized weight rows, the larger inputs dequantize
+// blocks of kWeightOnlyGemmBlockN rows for a BLAS GEMM.
+constexpr int kWeightOnlyGemvMaxM = 8;
+constexpr int kWeightOnlyGemmBlockN = 64;
+
+// Dequantizes the row j of the weight to out[k]. scale is [n] per channel or
+// [ceil(k / group_size), n] per group.
+template <int quant_bit>
+inline void DequantWeightRow(const int8_t* weight,
+                             const float* scale,
+                             int j,
+                             int n,
+                             int k,
+                             int group_size,
+                             float* out) {
+  if (quant_bit == 8) {
+    const int8_t* row = weight + static_cast<int64_t>(j) * k;
+    for (int i = 0; i < k; ++i) {
+      out[i] = static_cast<float>(row[i]);
+    }
+  } else {
+    const int8_t* row = weight + static_cast<int64_t>(j) * (k / 2);
+    for (int i = 0; i < k / 2; ++i) {
+      out[2 * i] = static_cast<float>(static_cast<int8_t>(row[i] << 4) >> 4);
+      out[2 * i + 1] = static_cast<float>(row[i] >> 4);
+    }
+  }
+  if (group_size <= 0) {
+    float s = scale[j];
+    for (int i = 0; i < k; ++i) {
+      out[i] *= s;
+    }
+    return;
+  }
+  for (int g = 0; g * group_size < k; ++g) {
+    float s = scale[static_cast<int64_t>(g) * n + j];
+    int end = std::min(k, (g + 1) * group_size);
+    for (int i = g * group_size; i < end; ++i) {
+      out[i] *= s;
+    }
+  }
+}
+
+inline float DotFloat(const float* x, const float* y, int k) {
+  // 8 partial sums break the dependency chain of the adds and let the
+  // compiler keep a vector of them
+  float sum[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int i = 0;
+  for (; i + 8 <= k; i += 8) {
+    for (int l = 0; l < 8; ++l) {
+      sum[l] += x[i + l] * y[i + l];
+    }
+  }
+  float res = 0;
+  for (; i < k; ++i) {
+    res += x[i] * y[i];
+  }
+  for (int l = 0; l < 8; ++l) {
+    res += sum[l];
+  }
+  return res;
+}
+
+// out[m, n] = x[m, k] * dequant(weight)^T.
+template <int quant_bit>
+void WeightOnlyGemm(const CPUContext& dev_ctx,
+                    const float* x,
+                    const int8_t* weight,
+                    const float* scale,
+                    int m,
+                    int n,
+                    int k,
+                    int group_size,
+                    float* out) {
+  int block_num = (n + kWeightOnlyGemmBlockN - 1) / kWeightOnlyGemmBlockN;
+  if (m <= kWeightOnlyGemvMaxM) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int b = 0; b < block_num; ++b) {
+      std::vector<float> w(k);
+      int end = std::min(n, (b + 1) * kWeightOnlyGemmBlockN);
+      for (int j = b * kWeightOnlyGemmBlockN; j < end; ++j) {
+        DequantWeightRow<quant_bit>(
+            weight, scale, j, n, k, group_size, w.data());
+        for (int r = 0; r < m; ++r) {
+          out[static_cast<int64_t>(r) * n + j] =
+              DotFloat(x + static_cast<int64_t>(r) * k, w.data(), k);
+        }
+      }
+    }
+    return;
+  }
+  auto blas = GetBlas<CPUContext, float>(dev_ctx);
+  std::vector<float> w(static_cast<size_t>(kWeightOnlyGemmBlockN) * k);
+  for (int b = 0; b < block_num; ++b) {
+    int begin = b * kWeightOnlyGemmBlockN;
+    int rows = std::min(n - begin, kWeightOnlyGemmBlockN);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int j = 0; j < rows; ++j) {
+      DequantWeightRow<quant_bit>(weight,
+                                  scale,
+                                  begin + j,
+                                  n,
+                                  k,
+                                  group_size,
+                                  w.data() + static_cast<int64_t>(j) * k);
+    }
+    blas.GEMM(false,
+              true,
+              m,
+              rows,
+              k,
+              1.0f,
+              x,
+              k,
+              w.data(),
+              k,
+              0.0f,
+              out + begin,
+              n);
+  }
+}
+
+// The int32 dot product of the int8 vectors, the widening multiply-adds of
+// the int8 pairs are what VNNI and vpmaddwd do.
+inline int32_t DotInt8(const int8_t* x, const int8_t* y, int k) {
+  int32_t sum[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int i = 0;
+  for (; i + 8 <= k; i += 8) {
+    for (int l = 0; l < 8; ++l) {
+      sum[l] += static_cast<int16_t>(x[i + l]) * static_cast<int16_t>(y[i + l]);
+    }
+  }
+  int32_t res = 0;
+  for (; i < k; ++i) {
+    res += static_cast<int32_t>(x[i]) * static_cast<int32_t>(y[i]);
+  }
+  for (int l = 0; l < 8; ++l) {
+    res += sum[l];
+  }
+  return res;
+}
+
+using DotInt8Func = int32_t (*)(const int8_t* x, const int8_t* y, int k);
+
+// The DotInt8 of the widest instructions of the CPU, AVX512 VNNI, AVX2 or the
+// portable one above. It is looked up once, call it out of the loops.
+DotInt8Func GetDotInt8();
+
+}  // namespace funcs
+}  // namespace phi
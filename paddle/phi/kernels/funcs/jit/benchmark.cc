@@ -18,16 +18,20 @@
 #include "glog/logging.h"
 #include "paddle/common/flags.h"
 #include "paddle/phi/api/profiler/device_tracer.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/enforce.h"
 #include "paddle/phi/kernels/funcs/jit/kernels.h"
+#include "paddle/phi/kernels/funcs/softmax.h"
 
 PD_DEFINE_int32(burning, 10, "Burning times.");
 PD_DEFINE_int32(repeat, 3000, "Repeat times.");
 PD_DEFINE_int32(max_size, 1000, "The Max size would be tested.");
 PD_DEFINE_string(filter, "", "The Benchmark name would be run.");  // NOLINT
 
+COMMON_DECLARE_bool(use_jit_softmax_gelu);
+
 class BenchJITKernel {
  public:
   BenchJITKernel() = default;
@@ -71,8 +75,8 @@ void RUN_ALL_BENCHMARK() {
 template <typename T>
 void RandomVec(const int n,
                T* a,
-               const T lower = static_cast<T>(-20.f),
-               const T upper = static_cast<T>(20.f),
+               const double lower = -20.0,
+               const double upper = 20.0,
                unsigned int seed = 100) {
   std::mt19937 rng(seed);
   std::uniform_real_distribution<double> uniform_dist(0, 1);
@@ -383,7 +387,7 @@ void BenchKernelMatMul() {
 template <typename KernelTuple, typename PlaceType>
 void BenchKernelLayerNorm() {
   using T = typename KernelTuple::data_type;
-  const T epsilon = 9.99999975e-06;
+  const float epsilon = 9.99999975e-06;
   for (int n : {1, 2, 10}) {
     for (int x_dim_0 : {1, 9, 17, 50}) {
       int left = n * x_dim_0;
@@ -472,6 +476,77 @@ void BenchKernelVBroadcast() {
   }
 }
 
+// the rows of the attention scores of BERT and of a classifier
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelXYNB() {
+  using T = typename KernelTuple::data_type;
+  for (int n : {64, 128, 384, 512, 1000}) {
+    for (int bs : {1, 16, 128}) {
+      phi::DenseTensor x, y;
+      x.Resize({bs * n});
+      y.Resize({bs * n});
+      T* x_data = x.mutable_data<T>(PlaceType());
+      T* y_data = y.mutable_data<T>(PlaceType());
+      RandomVec<T>(bs * n, x_data);
+      BenchAllImpls<KernelTuple, PlaceType>(n, x.data<T>(), y_data, n, bs);
+    }
+  }
+}
+
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelGelu() {
+  using T = typename KernelTuple::data_type;
+  std::vector<int> sizes = TestSizes();
+  sizes.push_back(128 * 3072);  // the FFN of BERT base, 128 tokens
+  for (int approximate : {0, 1}) {
+    for (int d : sizes) {
+      phi::DenseTensor x, y;
+      x.Resize({d});
+      y.Resize({d});
+      T* x_data = x.mutable_data<T>(PlaceType());
+      T* y_data = y.mutable_data<T>(PlaceType());
+      RandomVec<T>(d, x_data, -5.0, 5.0);
+      BenchAllImpls<KernelTuple, PlaceType>(
+          approximate, x.data<T>(), y_data, d, approximate);
+    }
+  }
+}
+
+// SoftmaxFunctor on the same rows with and without the jit kernel, i.e. the
+// vec_* loop it replaces when FLAGS_use_jit_softmax_gelu is set.
+void BenchSoftmaxFunctor() {
+  phi::CPUContext ctx;
+  phi::funcs::SoftmaxFunctor<phi::CPUContext, float> softmax;
+  bool use_jit = FLAGS_use_jit_softmax_gelu;
+  for (int n : {64, 128, 384, 512, 1000}) {
+    for (int bs : {1, 16, 128}) {
+      phi::DenseTensor x, y;
+      x.Resize({bs, n});
+      y.Resize({bs, n});
+      float* x_data = x.mutable_data<float>(phi::CPUPlace());
+      y.mutable_data<float>(phi::CPUPlace());
+      RandomVec<float>(bs * n, x_data);
+      std::ostringstream loginfos;
+      loginfos << "SoftmaxFunctor " << bs << "x" << n << ": ";
+      for (bool jit : {false, true}) {
+        FLAGS_use_jit_softmax_gelu = jit;
+        for (int i = 0; i < FLAGS_burning; ++i) {
+          softmax(ctx, n, &x, &y);
+        }
+        double start = static_cast<double>(phi::PosixInNsec()) * 1e-3;
+        for (int i = 0; i < FLAGS_repeat; ++i) {
+          softmax(ctx, n, &x, &y);
+        }
+        double end = static_cast<double>(phi::PosixInNsec()) * 1e-3;
+        loginfos << (jit ? "jit" : "vec") << " takes "
+                 << (end - start) / FLAGS_repeat << " us; ";
+      }
+      LOG(INFO) << loginfos.str();
+    }
+  }
+  FLAGS_use_jit_softmax_gelu = use_jit;
+}
+
 #define BenchKernelVMul BenchKernelXYZN
 #define BenchKernelVAdd BenchKernelXYZN
 #define BenchKernelVAddRelu BenchKernelXYZN
@@ -488,6 +563,9 @@ void BenchKernelVBroadcast() {
 #define BenchKernelVTanh BenchKernelXYN
 #define BenchKernelVCopy BenchKernelXYN
 
+#define BenchKernelSoftmax BenchKernelXYNB
+#define BenchKernelLogSoftmax BenchKernelXYNB
+
 #define BenchKernelLSTMCtHt BenchKernelLSTM
 #define BenchKernelLSTMC1H1 BenchKernelLSTM
 
@@ -521,6 +599,11 @@ BENCH_FP32_CPU(VSigmoid);
 BENCH_FP32_CPU(VTanh);
 BENCH_FP32_CPU(VCopy);
 
+BENCH_FP32_CPU(Softmax);
+BENCH_FP32_CPU(LogSoftmax);
+BENCH_FP32_CPU(Gelu);
+BENCH_JITKERNEL(SoftmaxFunctor, FP32, CPU) { BenchSoftmaxFunctor(); }
+
 // LSTM
 BENCH_FP32_CPU(LSTMCtHt);
 BENCH_FP32_CPU(LSTMC1H1);
@@ -539,13 +622,42 @@ BENCH_FP32_CPU(MatMul);
 BENCH_FP32_CPU(Sgd);
 BENCH_FP32_CPU(VBroadcast);
 
+// The kernels of bfloat16 and float16, compared with the FP32 ones by the
+// same --filter.
+#define BENCH_BF16_CPU(name)                                               \
+  BENCH_JITKERNEL(name, BF16, CPU) {                                       \
+    BenchKernel##name<jit::name##Tuple<phi::dtype::bfloat16>, CPUPlace>(); \
+  }
+
+#define BENCH_FP16_CPU(name)                                              \
+  BENCH_JITKERNEL(name, FP16, CPU) {                                      \
+    BenchKernel##name<jit::name##Tuple<phi::dtype::float16>, CPUPlace>(); \
+  }
+
+#define BENCH_HALF_CPU(name) \
+  BENCH_BF16_CPU(name);      \
+  BENCH_FP16_CPU(name)
+
+BENCH_HALF_CPU(VMul);
+BENCH_HALF_CPU(VAdd);
+BENCH_HALF_CPU(VAddRelu);
+BENCH_HALF_CPU(VSub);
+BENCH_HALF_CPU(VRelu);
+BENCH_HALF_CPU(VExp);
+BENCH_HALF_CPU(VSigmoid);
+BENCH_HALF_CPU(VTanh);
+BENCH_HALF_CPU(LayerNorm);
+BENCH_HALF_CPU(EmbSeqPool);
+BENCH_HALF_CPU(MatMul);
+
 // Benchmark all jit kernels including jitcode, mkl and refer.
 // To use this tool, run command: ./benchmark [options...]
 // Options:
 //     --burning: the burning time before count
 //     --repeat: the repeat times
 //     --max_size: the max size would be tested
-//     --filter: the bench name would be run
+//     --filter: the bench name would be run, e.g. --filter=VMul runs VMul of
+//               FP32, BF16 and FP16
 int main(int argc, char* argv[]) {
   paddle::flags::ParseCommandLineFlags(&argc, &argv);
   google::InitGoogleLogging(argv[0]);
@@ -14,6 +14,7 @@
 
 #include "paddle/phi/kernels/funcs/jit/gen/act.h"
 #include <array>
+#include <limits>
 
 #include "paddle/phi/backends/cpu/cpu_info.h"
 #include "paddle/phi/kernels/funcs/jit/registry.h"
@@ -39,7 +40,18 @@ const float ALIGN32_BEG exp_float_consts[] ALIGN32_END = {  // NOLINT
     REPEAT_8TIMES(CEPHES_EXP_P5),
     REPEAT_8TIMES(EXP_MAX_INPUT),
     REPEAT_8TIMES(SIGMOID_THRESHOLD_MAX),
-    REPEAT_8TIMES(SIGMOID_THRESHOLD_MIN)};
+    REPEAT_8TIMES(SIGMOID_THRESHOLD_MIN),
+    REPEAT_8TIMES(GELU_TANH_C0),
+    REPEAT_8TIMES(GELU_TANH_C1),
+    REPEAT_8TIMES(GELU_SQRT1_2),
+    REPEAT_8TIMES(ERF_P),
+    REPEAT_8TIMES(ERF_A1),
+    REPEAT_8TIMES(ERF_A2),
+    REPEAT_8TIMES(ERF_A3),
+    REPEAT_8TIMES(ERF_A4),
+    REPEAT_8TIMES(ERF_A5),
+    REPEAT_8TIMES(SOFTMAX_CLIP),
+    REPEAT_8TIMES(std::numeric_limits<float>::lowest())};
 
 const int ALIGN32_BEG exp_int_0x7f[] ALIGN32_END = {  // NOLINT
     REPEAT_8TIMES(0x7f)};                             // NOLINT
@@ -80,6 +92,77 @@ void VActJitCode::genCode() {
   ret();
 }
 
+template <typename T>
+void VActHalfJitCode<T>::compute(int mask_idx) {
+  load_ps<T>(ymm_src, param1, mask_idx);
+  act<ymm_t>(ymm_dst, ymm_src, type_);
+  store_ps<T>(param2, ymm_dst, mask_idx);
+}
+
+template <typename T>
+void VActHalfJitCode<T>::genCode() {
+  const int block_size = sizeof(T) * YMM_FLOAT_BLOCK;
+  const int num_blocks = num_ / YMM_FLOAT_BLOCK;
+  const int rest = num_ % YMM_FLOAT_BLOCK;
+  if (num_blocks > 0) {
+    Label l_next_block;
+    mov(reg_num_blocks, num_blocks);
+    L(l_next_block);
+    compute(0);
+    add(param1, block_size);
+    add(param2, block_size);
+    dec(reg_num_blocks);
+    jnz(l_next_block, T_NEAR);
+  }
+  if (rest > 0) {
+    set_lane_mask(1, rest, reg_mask);
+    compute(1);
+  }
+  vzeroupper();
+  ret();
+}
+
+template <typename JMM>
+void VGeluJitCode::compute(JMM& dst, JMM& src) {
+  if (approximate_) {
+    gelu_tanh_jmm<JMM>(dst, src);
+  } else {
+    gelu_jmm<JMM>(dst, src);
+  }
+}
+
+void VGeluJitCode::genCode() {
+  Label l_next_block, l_rest, l_next_rest, l_end;
+  mov(reg_num_blocks.cvt32(), param3);
+  mov(reg_rest, reg_num_blocks);
+  shr(reg_num_blocks, 3);
+  and_(reg_rest, YMM_FLOAT_BLOCK - 1);
+  test(reg_num_blocks, reg_num_blocks);
+  jz(l_rest, T_NEAR);
+  L(l_next_block);
+  vmovups(ymm_src, ptr[param1]);
+  compute<ymm_t>(ymm_dst, ymm_src);
+  vmovups(ptr[param2], ymm_dst);
+  add(param1, sizeof(float) * YMM_FLOAT_BLOCK);
+  add(param2, sizeof(float) * YMM_FLOAT_BLOCK);
+  dec(reg_num_blocks);
+  jnz(l_next_block, T_NEAR);
+  L(l_rest);
+  test(reg_rest, reg_rest);
+  jz(l_end, T_NEAR);
+  L(l_next_rest);
+  vmovss(xmm_src, ptr[param1]);
+  compute<xmm_t>(xmm_dst, xmm_src);
+  vmovss(ptr[param2], xmm_dst);
+  add(param1, sizeof(float));
+  add(param2, sizeof(float));
+  dec(reg_rest);
+  jnz(l_next_rest, T_NEAR);
+  L(l_end);
+  vzeroupper();
+  ret();
+}
+
 #define DECLARE_ACT_CREATOR(name)                                            \
   class name##Creator : public JitCodeCreator<int> {                         \
    public:                                                                   \
@@ -147,7 +230,42 @@ size_t VTanhCreator::CodeSize(const int& d) const {
   return 96 + (d / YMM_FLOAT_BLOCK + 3) * 84 * 8;
 }
 
+#define DECLARE_ACT_HALF_CREATOR(name, op_type, insts)                       \
+  template <typename T>                                                      \
+  class name##HalfCreator : public JitCodeCreator<int, T> {                  \
+   public:                                                                   \
+    bool CanBeUsed(const int& attr) const override {                         \
+      return MayIUseHalf<T>();                                               \
+    }                                                                        \
+    size_t CodeSize(const int& d) const override {                           \
+      return 96 + 2 * insts * 8;                                             \
+    }                                                                        \
+    std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override { \
+      return make_unique<VActHalfJitCode<T>>(attr, op_type, CodeSize(attr)); \
+    }                                                                        \
+  }
+
+DECLARE_ACT_HALF_CREATOR(VRelu, operand_type::RELU, 8);
+DECLARE_ACT_HALF_CREATOR(VExp, operand_type::EXP, 74);
+DECLARE_ACT_HALF_CREATOR(VSigmoid, operand_type::SIGMOID, 86);
+DECLARE_ACT_HALF_CREATOR(VTanh, operand_type::TANH, 88);
+
+class VGeluCreator : public JitCodeCreator<int> {
+ public:
+  bool CanBeUsed(const int& attr) const override {
+    return phi::backends::cpu::MayIUse(phi::backends::cpu::avx);
+  }
+  size_t CodeSize(const int& attr) const override {
+    // the instructions of a block of ymm and of a float
+    return 96 + 2 * 120 * 8;
+  }
+  std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override {
+    return make_unique<VGeluJitCode>(attr, CodeSize(attr));
+  }
+};
+
 #undef DECLARE_ACT_CREATOR
+#undef DECLARE_ACT_HALF_CREATOR
 
 }  // namespace gen
 }  // namespace jit
@@ -155,9 +273,22 @@ size_t VTanhCreator::CodeSize(const int& d) const {
 
 namespace gen = phi::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kVRelu, gen::VReluCreator);
+REGISTER_JITKERNEL_GEN(kVRelu,
+                       gen::VReluCreator,
+                       gen::VReluHalfCreator<phi::dtype::bfloat16>,
+                       gen::VReluHalfCreator<phi::dtype::float16>);
 REGISTER_JITKERNEL_GEN(kVSquare, gen::VSquareCreator);
 REGISTER_JITKERNEL_GEN(kVIdentity, gen::VIdentityCreator);
-REGISTER_JITKERNEL_GEN(kVExp, gen::VExpCreator);
-REGISTER_JITKERNEL_GEN(kVSigmoid, gen::VSigmoidCreator);
-REGISTER_JITKERNEL_GEN(kVTanh, gen::VTanhCreator);
+REGISTER_JITKERNEL_GEN(kVExp,
+                       gen::VExpCreator,
+                       gen::VExpHalfCreator<phi::dtype::bfloat16>,
+                       gen::VExpHalfCreator<phi::dtype::float16>);
+REGISTER_JITKERNEL_GEN(kVSigmoid,
+                       gen::VSigmoidCreator,
+                       gen::VSigmoidHalfCreator<phi::dtype::bfloat16>,
+                       gen::VSigmoidHalfCreator<phi::dtype::float16>);
+REGISTER_JITKERNEL_GEN(kVTanh,
+                       gen::VTanhCreator,
+                       gen::VTanhHalfCreator<phi::dtype::bfloat16>,
+                       gen::VTanhHalfCreator<phi::dtype::float16>);
+REGISTER_JITKERNEL_GEN(kGelu, gen::VGeluCreator);
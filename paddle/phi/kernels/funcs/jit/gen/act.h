@@ -40,6 +40,19 @@ extern int g_tmp_mem[];
 #define CEPHES_EXP_P4 1.6666665459E-1
 #define CEPHES_EXP_P5 5.0000001201E-1
 
+#define GELU_TANH_C0 0.79788456080286535588f  // sqrt(2 / pi)
+#define GELU_TANH_C1 0.044715f
+#define GELU_SQRT1_2 0.70710678118654752440f
+// erf(x) = 1 - t * (A1 + t * (A2 + ...)) * exp(-x * x), t = 1 / (1 + P * x)
+// for x >= 0, by Abramowitz and Stegun 7.1.26 of the error less than 1.5e-7
+#define ERF_P 0.3275911f
+#define ERF_A1 0.254829592f
+#define ERF_A2 -0.284496736f
+#define ERF_A3 1.421413741f
+#define ERF_A4 -1.453152027f
+#define ERF_A5 1.061405429f
+#define SOFTMAX_CLIP -64.f
+
 #define REPEAT_8TIMES(val) val, val, val, val, val, val, val, val
 
 #define OFFSET_EXP_ONE 0 * YMM_FLOAT_BLOCK * sizeof(float)
@@ -59,6 +72,14 @@ extern int g_tmp_mem[];
 #define OFFSET_EXP_MAX_INPUT 14 * YMM_FLOAT_BLOCK * sizeof(float)
 #define OFFSET_SIGMOID_MAX 15 * YMM_FLOAT_BLOCK * sizeof(float)
 #define OFFSET_SIGMOID_MIN 16 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_GELU_TANH_C0 17 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_GELU_TANH_C1 18 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_GELU_SQRT1_2 19 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_ERF_P 20 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_ERF_A1 21 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_ERF_A5 25 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_SOFTMAX_CLIP 26 * YMM_FLOAT_BLOCK * sizeof(float)
+#define OFFSET_FLOAT_LOWEST 27 * YMM_FLOAT_BLOCK * sizeof(float)
 
 class VActFunc : public JitCode {
  public:
@@ -232,6 +253,91 @@ class VActFunc : public JitCode {
     pop(reg_ptr_global);
   }
 
+  // compute GELU of tanh with ymm, xmm, with 8~10 besides the ones of TANH
+  template <typename JMM>
+  void gelu_tanh_jmm(JMM& dst,  // NOLINT
+                     JMM& src,  // NOLINT
+                     int x_idx = 8,
+                     int inner_idx = 9,
+                     int tmp_idx = 10) {
+    // y = 0.5 * x * (1 + tanh(C0 * (x + C1 * x^3)))
+    JMM jmm_x = JMM(x_idx);
+    JMM jmm_inner = JMM(inner_idx);
+    JMM jmm_tmp = JMM(tmp_idx);
+    reg64_t reg_ptr_global = rax;
+    push(reg_ptr_global);
+    vmovaps(jmm_x, src);
+    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
+    vmulps(jmm_inner, jmm_x, jmm_x);
+    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_GELU_TANH_C1]);
+    vmulps(jmm_inner, jmm_inner, jmm_tmp);
+    vmulps(jmm_inner, jmm_inner, jmm_x);
+    vaddps(jmm_inner, jmm_inner, jmm_x);
+    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_GELU_TANH_C0]);
+    vmulps(jmm_inner, jmm_inner, jmm_tmp);
+    tanh_jmm<JMM>(dst, jmm_inner, 11, 12, 13, 14, 15);
+    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    vaddps(dst, dst, jmm_tmp);
+    vmulps(dst, dst, jmm_x);
+    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_0P5]);
+    vmulps(dst, dst, jmm_tmp);
+    pop(reg_ptr_global);
+  }
+
+  // compute GELU of erf with ymm, xmm, with 8~10 besides the ones of EXP
+  template <typename JMM>
+  void gelu_jmm(JMM& dst,  // NOLINT
+                JMM& src,  // NOLINT
+                int x_idx = 8,
+                int a_idx = 9,
+                int t_idx = 10) {
+    // y = 0.5 * x * (1 + erf(x / sqrt(2))), with a = |x / sqrt(2)| and
+    // e = 1 - erf(a), 1 + erf(x / sqrt(2)) is e if x < 0 otherwise 2 - e
+    JMM jmm_x = JMM(x_idx);
+    JMM jmm_a = JMM(a_idx);
+    JMM jmm_t = JMM(t_idx);
+    JMM jmm_zero = JMM(14);
+    JMM jmm_tmp = JMM(15);
+    reg64_t reg_ptr_global = rax;
+    push(reg_ptr_global);
+    vmovaps(jmm_x, src);
+    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
+    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_GELU_SQRT1_2]);
+    vmulps(jmm_a, jmm_x, jmm_tmp);
+    vxorps(jmm_zero, jmm_zero, jmm_zero);
+    vsubps(jmm_tmp, jmm_zero, jmm_a);
+    vmaxps(jmm_a, jmm_a, jmm_tmp);
+    // dst = exp(-a * a)
+    vmulps(jmm_t, jmm_a, jmm_a);
+    vsubps(jmm_t, jmm_zero, jmm_t);
+    exp_jmm<JMM>(dst, jmm_t, 11, 12, 13, 14, 15);
+    // t = 1 / (1 + P * a)
+    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_ERF_P]);
+    vmulps(jmm_t, jmm_a, jmm_tmp);
+    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    vaddps(jmm_t, jmm_t, jmm_tmp);
+    vdivps(jmm_t, jmm_tmp, jmm_t);
+    // e = t * (A1 + t * (A2 + t * (A3 + t * (A4 + t * A5)))) * dst
+    vmovaps(jmm_a, ptr[reg_ptr_global + OFFSET_ERF_A5]);
+    for (size_t i = OFFSET_ERF_A5; i > OFFSET_ERF_A1;) {
+      i -= YMM_FLOAT_BLOCK * sizeof(float);
+      vmulps(jmm_a, jmm_a, jmm_t);
+      vmovaps(jmm_tmp, ptr[reg_ptr_global + i]);  // A4~A1
+      vaddps(jmm_a, jmm_a, jmm_tmp);
+    }
+    vmulps(jmm_a, jmm_a, jmm_t);
+    vmulps(jmm_a, jmm_a, dst);
+    vmovaps(dst, ptr[reg_ptr_global + OFFSET_EXP_TWO]);
+    vsubps(dst, dst, jmm_a);
+    vxorps(jmm_zero, jmm_zero, jmm_zero);
+    vcmpltps(jmm_t, jmm_x, jmm_zero);
+    vblendvps(dst, dst, jmm_a, jmm_t);
+    vmulps(dst, dst, jmm_x);
+    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_0P5]);
+    vmulps(dst, dst, jmm_tmp);
+    pop(reg_ptr_global);
+  }
+
   // compute IDENTITY with ymm, xmm
   template <typename JMM>
   void identity_jmm(JMM& dst, JMM& src, int zero_idx) {  // NOLINT
@@ -329,6 +435,94 @@ class VActJitCode : public VActFunc {
   ymm_t ymm_dst = ymm_t(1);
 };
 
+// activation of bfloat16 or float16, which loops over the blocks of ymm and
+// ends with a masked block
+template <typename T>
+class VActHalfJitCode : public VActFunc {
+ public:
+  explicit VActHalfJitCode(int d,
+                           operand_type type,
+                           size_t code_size,
+                           void* code_ptr = nullptr)
+      : VActFunc(code_size, code_ptr), num_(d), type_(type) {
+    if (!(type_ == operand_type::RELU || type_ == operand_type::EXP ||
+          type_ == operand_type::SIGMOID || type_ == operand_type::TANH)) {
+      PADDLE_THROW(phi::errors::Unimplemented(
+          "Do not support operand type code: %d.", type));
+    }
+    this->genCode();
+  }
+
+  std::string name() const override {
+    std::string base = "VActHalfJitCode" + DataTypeSuffix<T>();
+    switch (type_) {
+      case operand_type::RELU:
+        base += "_Relu";
+        break;
+      case operand_type::EXP:
+        base += "_Exp";
+        break;
+      case operand_type::SIGMOID:
+        base += "_Sigmoid";
+        break;
+      case operand_type::TANH:
+        base += "_Tanh";
+        break;
+      default:
+        break;
+    }
+    return base;
+  }
+  void genCode() override;
+
+ protected:
+  void compute(int mask_idx);
+
+  int num_;
+  operand_type type_;
+  reg64_t param1{abi_param1};
+  reg64_t param2{abi_param2};
+  reg64_t reg_num_blocks{r8};
+  reg32_t reg_mask{r9d};
+
+  ymm_t ymm_src = ymm_t(0);
+  ymm_t ymm_dst = ymm_t(1);
+};
+
+// GELU of tanh if approximate otherwise of erf, which loops over n at
+// runtime, so that one code serves all the sizes
+class VGeluJitCode : public VActFunc {
+ public:
+  explicit VGeluJitCode(int approximate,
+                        size_t code_size,
+                        void* code_ptr = nullptr)
+      : VActFunc(code_size, code_ptr), approximate_(approximate) {
+    this->genCode();
+  }
+
+  std::string name() const override {
+    return approximate_ ? "VGeluJitCode_Tanh" : "VGeluJitCode_Erf";
+  }
+  void genCode() override;
+
+ protected:
+  template <typename JMM>
+  void compute(JMM& dst, JMM& src);  // NOLINT
+
+  int approximate_;
+  reg64_t param1{abi_param1};
+  reg64_t param2{abi_param2};
+  reg32_t param3{abi_param3};
+  reg64_t reg_num_blocks{r8};
+  reg64_t reg_rest{r9};
+
+  xmm_t xmm_src = xmm_t(0);
+  ymm_t ymm_src = ymm_t(0);
+
+  xmm_t xmm_dst = xmm_t(1);
+  ymm_t ymm_dst = ymm_t(1);
+};
+
 #define DECLARE_ACT_JITCODE(name, op_type)                                    \
   class name##JitCode : public VActJitCode {                                  \
    public:                                                                    \
@@ -110,6 +110,52 @@ void VXXJitCode::genCode() {
   ret();
 }
 
+template <typename T>
+void VXXHalfJitCode<T>::compute(int mask_idx) {
+  load_ps<T>(zmm_src1, param1, mask_idx);
+  load_ps<T>(zmm_src2, param2, mask_idx);
+  if (type_ == operand_type::MUL) {
+    vmulps(zmm_dst, zmm_src1, zmm_src2);
+  } else if (type_ == operand_type::ADD) {
+    vaddps(zmm_dst, zmm_src1, zmm_src2);
+  } else if (type_ == operand_type::SUB) {
+    vsubps(zmm_dst, zmm_src1, zmm_src2);
+  }
+  if (with_relu_) {
+    vmaxps(zmm_dst, zmm_zero, zmm_dst);
+  }
+  store_ps<T>(param3, zmm_dst, mask_idx);
+}
+
+template <typename T>
+void VXXHalfJitCode<T>::genCode() {
+  // the code does not depend on d but the number of blocks, so that it keeps
+  // small for the large d
+  const int block_size = sizeof(T) * ZMM_FLOAT_BLOCK;
+  const int num_blocks = num_ / ZMM_FLOAT_BLOCK;
+  const int rest = num_ % ZMM_FLOAT_BLOCK;
+  if (with_relu_) {
+    vxorps(zmm_zero, zmm_zero, zmm_zero);
+  }
+  if (num_blocks > 0) {
+    Label l_next_block;
+    mov(reg_num_blocks, num_blocks);
+    L(l_next_block);
+    compute(0);
+    add(param1, block_size);
+    add(param2, block_size);
+    add(param3, block_size);
+    dec(reg_num_blocks);
+    jnz(l_next_block, T_NEAR);
+  }
+  if (rest > 0) {
+    set_lane_mask(1, rest, reg_mask);
+    compute(1);
+  }
+  vzeroupper();
+  ret();
+}
+
 #define DECLARE_BLAS_CREATOR(name)                                           \
   class name##Creator : public JitCodeCreator<int> {                         \
    public:                                                                   \
@@ -132,7 +178,27 @@ DECLARE_BLAS_CREATOR(VAddRelu);
 DECLARE_BLAS_CREATOR(VScal);
 DECLARE_BLAS_CREATOR(VAddBias);
 
+#define DECLARE_BLAS_HALF_CREATOR(name, op_type, with_relu)                  \
+  template <typename T>                                                      \
+  class name##HalfCreator : public JitCodeCreator<int, T> {                  \
+   public:                                                                   \
+    bool CanBeUsed(const int& attr) const override {                         \
+      return MayIUseHalf<T>();                                               \
+    }                                                                        \
+    size_t CodeSize(const int& d) const override { return 96 + 32 * 8; }     \
+    std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override { \
+      return make_unique<VXXHalfJitCode<T>>(                                 \
+          attr, op_type, with_relu, CodeSize(attr));                         \
+    }                                                                        \
+  }
+
+DECLARE_BLAS_HALF_CREATOR(VMul, operand_type::MUL, false);
+DECLARE_BLAS_HALF_CREATOR(VAdd, operand_type::ADD, false);
+DECLARE_BLAS_HALF_CREATOR(VSub, operand_type::SUB, false);
+DECLARE_BLAS_HALF_CREATOR(VAddRelu, operand_type::ADD, true);
+
 #undef DECLARE_BLAS_CREATOR
+#undef DECLARE_BLAS_HALF_CREATOR
 
 }  // namespace gen
 }  // namespace jit
@@ -140,9 +206,21 @@ DECLARE_BLAS_CREATOR(VAddBias);
 
 namespace gen = phi::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kVMul, gen::VMulCreator);
-REGISTER_JITKERNEL_GEN(kVAdd, gen::VAddCreator);
-REGISTER_JITKERNEL_GEN(kVSub, gen::VSubCreator);
-REGISTER_JITKERNEL_GEN(kVAddRelu, gen::VAddReluCreator);
+REGISTER_JITKERNEL_GEN(kVMul,
+                       gen::VMulCreator,
+                       gen::VMulHalfCreator<phi::dtype::bfloat16>,
+                       gen::VMulHalfCreator<phi::dtype::float16>);
+REGISTER_JITKERNEL_GEN(kVAdd,
+                       gen::VAddCreator,
+                       gen::VAddHalfCreator<phi::dtype::bfloat16>,
+                       gen::VAddHalfCreator<phi::dtype::float16>);
+REGISTER_JITKERNEL_GEN(kVSub,
+                       gen::VSubCreator,
+                       gen::VSubHalfCreator<phi::dtype::bfloat16>,
+                       gen::VSubHalfCreator<phi::dtype::float16>);
+REGISTER_JITKERNEL_GEN(kVAddRelu,
+                       gen::VAddReluCreator,
+                       gen::VAddReluHalfCreator<phi::dtype::bfloat16>,
+                       gen::VAddReluHalfCreator<phi::dtype::float16>);
 REGISTER_JITKERNEL_GEN(kVScal, gen::VScalCreator);
 REGISTER_JITKERNEL_GEN(kVAddBias, gen::VAddBiasCreator);
@@ -91,6 +91,61 @@ class VXXJitCode : public JitCode {
   ymm_t ymm_zero = ymm_t(3);
 };
 
+// function: vec = Operand(vec, vec) (maybe with relu) of bfloat16 or float16,
+// which loops over the blocks of zmm and ends with a masked block
+template <typename T>
+class VXXHalfJitCode : public JitCode {
+ public:
+  explicit VXXHalfJitCode(int d,
+                          operand_type type,
+                          bool with_relu,
+                          size_t code_size = 256 * 1024,
+                          void* code_ptr = nullptr)
+      : JitCode(code_size, code_ptr),
+        num_(d),
+        type_(type),
+        with_relu_(with_relu) {
+    if (!(type_ == operand_type::MUL || type_ == operand_type::ADD ||
+          type_ == operand_type::SUB)) {
+      PADDLE_THROW(phi::errors::Unimplemented(
+          "Do not support operand type code: %d.", type));
+    }
+    this->genCode();
+  }
+
+  std::string name() const override {
+    std::string base = "VXXHalfJitCode" + DataTypeSuffix<T>();
+    if (type_ == operand_type::MUL) {
+      base += "_Mul";
+    } else if (type_ == operand_type::ADD) {
+      base += "_Add";
+    } else if (type_ == operand_type::SUB) {
+      base += "_SUB";
+    }
+    base += (with_relu_ ? "_Relu" : "");
+    base += "_D" + std::to_string(num_);
+    return base;
+  }
+  void genCode() override;
+
+ private:
+  void compute(int mask_idx);
+
+  int num_;
+  operand_type type_;
+  bool with_relu_;
+  reg64_t param1{abi_param1};
+  reg64_t param2{abi_param2};
+  reg64_t param3{abi_param3};
+  reg64_t reg_num_blocks{r8};
+  reg32_t reg_mask{r9d};
+
+  zmm_t zmm_src1 = zmm_t(0);
+  zmm_t zmm_src2 = zmm_t(1);
+  zmm_t zmm_dst = zmm_t(2);
+  zmm_t zmm_zero = zmm_t(3);
+};
+
 #define DECLARE_BLAS_JITCODE(name, op_type, scalar_idx, with_relu)             \
   class name##JitCode : public VXXJitCode {                                    \
    public:                                                                     \
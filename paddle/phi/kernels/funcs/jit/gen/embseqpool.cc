@@ -24,13 +24,14 @@ namespace phi {
 namespace jit {
 namespace gen {
 
-void EmbSeqPoolJitCode::genCode() {
+template <typename T>
+void EmbSeqPoolJitCode<T>::genCode() {
   preCode();
   constexpr int block = YMM_FLOAT_BLOCK;
   constexpr int max_num_regs = 8;
   const int num_block = tbl_w_ / block;
   const int num_groups = num_block / max_num_regs;
-  const size_t block_size = sizeof(float) * block;
+  const size_t block_size = sizeof(T) * block;
   std::vector<int> groups(num_groups, max_num_regs);
   int rest_num_regs = num_block % max_num_regs;
   if (rest_num_regs > 0) {
@@ -46,7 +47,7 @@ void EmbSeqPoolJitCode::genCode() {
   mov(rax, sizeof(int64_t));
   mul(reg_idx_width_in_byte);
   mov(reg_idx_width_in_byte, rax);
-  const size_t tbl_width_in_byte = sizeof(float) * tbl_w_;
+  const size_t tbl_width_in_byte = sizeof(T) * tbl_w_;
   int acc_num_regs = 0;
   for (int num_regs : groups) {
     Label l_next_idx_w, l_next_idx_h, l_save_now;
@@ -66,7 +67,7 @@ void EmbSeqPoolJitCode::genCode() {
       add(reg_ptr_tbl_i, param_tbl);  // reg is ptr_i now
       size_t w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-        vmovups(ymm_t(reg_i + num_regs), ptr[reg_ptr_tbl_i + w_offset]);
+        load_ps<T>(ymm_t(reg_i + num_regs), reg_ptr_tbl_i + w_offset);
         w_offset += block_size;
       }
       add(reg_ptr_idx_i, reg_idx_width_in_byte);
@@ -91,7 +92,7 @@ void EmbSeqPoolJitCode::genCode() {
         add(reg_ptr_tbl_i, param_tbl);
         size_t w_offset = 0;
         for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-          vmovups(ymm_t(reg_i), ptr[reg_ptr_tbl_i + w_offset]);
+          load_ps<T>(ymm_t(reg_i), reg_ptr_tbl_i + w_offset);
           vaddps(
               ymm_t(reg_i + num_regs), ymm_t(reg_i + num_regs), ymm_t(reg_i));
           w_offset += block_size;
@@ -104,7 +105,7 @@ void EmbSeqPoolJitCode::genCode() {
       // avg or sqrt here, if needed
       w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-        vmovups(ptr[reg_ptr_dst_i + w_offset], ymm_t(reg_i + num_regs));
+        store_ps<T>(reg_ptr_dst_i + w_offset, ymm_t(reg_i + num_regs));
         w_offset += block_size;
       }
       add(reg_ptr_dst_i, tbl_width_in_byte);
@@ -119,11 +120,14 @@ void EmbSeqPoolJitCode::genCode() {
   postCode();
 }
 
-class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t> {
+template <typename T>
+class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t, T> {
  public:
   bool CanBeUsed(const emb_seq_pool_attr_t& attr) const override {
-    return phi::backends::cpu::MayIUse(phi::backends::cpu::avx) &&
-           attr.table_width % YMM_FLOAT_BLOCK == 0;
+    bool isa = std::is_same<T, float>::value
+                   ? phi::backends::cpu::MayIUse(phi::backends::cpu::avx)
+                   : MayIUseHalf<T>();
+    return isa && attr.table_width % YMM_FLOAT_BLOCK == 0;
   }
   size_t CodeSize(const emb_seq_pool_attr_t& attr) const override {
     return 96 + (attr.table_width / YMM_FLOAT_BLOCK) * 96 * 8;
@@ -160,7 +164,7 @@ class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t> {
                           "The attribute out_width of EmbSeqPool should be "
                           "larger than 0. But it is %d.",
                           attr.out_width));
-    return make_unique<EmbSeqPoolJitCode>(attr, CodeSize(attr));
+    return make_unique<EmbSeqPoolJitCode<T>>(attr, CodeSize(attr));
   }
 };
 
@@ -170,4 +174,7 @@ class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t> {
 
 namespace gen = phi::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kEmbSeqPool, gen::EmbSeqPoolCreator);
+REGISTER_JITKERNEL_GEN(kEmbSeqPool,
+                       gen::EmbSeqPoolCreator<float>,
+                       gen::EmbSeqPoolCreator<phi::dtype::bfloat16>,
+                       gen::EmbSeqPoolCreator<phi::dtype::float16>);
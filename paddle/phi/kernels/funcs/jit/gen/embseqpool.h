@@ -24,6 +24,9 @@ namespace phi {
 namespace jit {
 namespace gen {
 
+// T is float, bfloat16 or float16, the rows of bfloat16 and float16 are
+// summed in fp32.
+template <typename T>
 class EmbSeqPoolJitCode : public JitCode {
  public:
   explicit EmbSeqPoolJitCode(const emb_seq_pool_attr_t& attr,
@@ -39,7 +42,7 @@ class EmbSeqPoolJitCode : public JitCode {
   }
 
   std::string name() const override {
-    std::string base = "EmbSeqPoolJitCode";
+    std::string base = "EmbSeqPoolJitCode" + DataTypeSuffix<T>();
     if (type_ == SeqPoolType::kSum) {
       base += "_Sum";
     } else if (type_ == SeqPoolType::kAvg) {
@@ -64,6 +64,31 @@ typedef enum {
   IDENTITY
 } operand_type;
 
+// The jit codes of bfloat16 and float16 load the values as fp32 and round the
+// results by vcvtneps2bf16 and vcvtps2ph, which need AVX512_BF16 and the
+// AVX512 masks and conversions of 16 bits.
+template <typename T>
+inline bool MayIUseHalf() {
+  using phi::backends::cpu::MayIUse;
+  if (std::is_same<T, phi::dtype::bfloat16>::value) {
+    return MayIUse(phi::backends::cpu::avx512_core) &&
+           MayIUse(phi::backends::cpu::avx512_bf16);
+  }
+  return std::is_same<T, phi::dtype::float16>::value &&
+         MayIUse(phi::backends::cpu::avx512_core);
+}
+
+// The suffix of the names of the jit codes of T.
+template <typename T>
+inline std::string DataTypeSuffix() {
+  if (std::is_same<T, phi::dtype::bfloat16>::value) {
+    return "_BF16";
+  } else if (std::is_same<T, phi::dtype::float16>::value) {
+    return "_FP16";
+  }
+  return "";
+}
+
 #define DECLARE_JIT_CODE(codename) \
   std::string name() const override { return #codename; }
 
@@ -101,6 +126,62 @@ class JitCode : public GenBase, public Xbyak::CodeGenerator {
     }
     ret();
   }
+  // The lower half of a ymm or zmm.
+  Xbyak::Xmm half_of(const Xbyak::Ymm& x) { return Xbyak::Xmm(x.getIdx()); }
+  Xbyak::Ymm half_of(const Xbyak::Zmm& x) { return Xbyak::Ymm(x.getIdx()); }
+
+  // Sets the opmask of mask_idx to the lowest n lanes.
+  void set_lane_mask(int mask_idx, int n, const Xbyak::Reg32& tmp) {
+    mov(tmp, (1 << n) - 1);
+    kmovw(Xbyak::Opmask(mask_idx), tmp);
+  }
+
+  // Loads the values of T at addr to dst as fp32. With the opmask of
+  // mask_idx, the masked lanes are loaded and the others are zeroed.
+  template <typename T, typename JMM>
+  void load_ps(const JMM& dst, const Xbyak::RegExp& addr, int mask_idx = 0) {
+    JMM x = mask_idx > 0 ? dst | Xbyak::Opmask(mask_idx) | T_z : dst;
+    if (std::is_same<T, phi::dtype::bfloat16>::value) {
+      vpmovzxwd(x, ptr[addr]);
+      vpslld(dst, dst, 16);
+    } else if (std::is_same<T, phi::dtype::float16>::value) {
+      vcvtph2ps(x, ptr[addr]);
+    } else {
+      vmovups(x, ptr[addr]);
+    }
+  }
+
+  // Broadcasts the value of T at addr to dst as fp32.
+  template <typename T, typename JMM>
+  void broadcast_ps(const JMM& dst, const Xbyak::RegExp& addr) {
+    if (std::is_same<T, phi::dtype::bfloat16>::value) {
+      vpbroadcastw(dst, ptr[addr]);
+      vpslld(dst, dst, 16);
+    } else if (std::is_same<T, phi::dtype::float16>::value) {
+      vpbroadcastw(half_of(dst), ptr[addr]);
+      vcvtph2ps(dst, half_of(dst));
+    } else {
+      vbroadcastss(dst, ptr[addr]);
+    }
+  }
+
+  // Stores the fp32 of src to addr as T, rounded to the nearest even. Only
+  // the masked lanes are stored with the opmask of mask_idx. The bfloat16
+  // are converted in place, so src is clobbered.
+  template <typename T, typename JMM>
+  void store_ps(const Xbyak::RegExp& addr, const JMM& src, int mask_idx = 0) {
+    Xbyak::Address dst =
+        mask_idx > 0 ? ptr[addr] | Xbyak::Opmask(mask_idx) : ptr[addr];
+    if (std::is_same<T, phi::dtype::bfloat16>::value) {
+      vcvtneps2bf16(half_of(src), src);
+      vmovdqu16(dst, half_of(src));
+    } else if (std::is_same<T, phi::dtype::float16>::value) {
+      vcvtps2ph(dst, src, 0);
+    } else {
+      vmovups(dst, src);
+    }
+  }
+
   void L(const char* label) { Xbyak::CodeGenerator::L(label); }
   void L(Xbyak::Label& label) { Xbyak::CodeGenerator::L(label); }  // NOLINT
   // Enhanced vector extension
@@ -23,7 +23,8 @@ namespace phi {
 namespace jit {
 namespace gen {
 
-void MatMulJitCode::genCode() {
+template <typename T>
+void MatMulJitCode<T>::genCode() {
   preCode();
   int block, rest;
   const auto groups = packed_groups(n_, k_, &block, &rest);
@@ -34,7 +35,7 @@ void MatMulJitCode::genCode() {
                                    "be larger than 0. But it is %d.",
                                    groups.front()));
 
-  const int block_len = sizeof(float) * block;  // NOLINT
+  const int block_len = sizeof(T) * block;  // NOLINT
   const int x_reg_idx = (block == ZMM_FLOAT_BLOCK ? 32 : 16) - 1;
   const int w_reg_idx = x_reg_idx - 1;
   // from packed mov(reg_ptr_wgt, ptr[param_attr + offsetof(matmul_attr_t,
@@ -50,7 +51,7 @@ void MatMulJitCode::genCode() {
     }
     for (int k = 0; k < k_; ++k) {
       wgt_offset = wgt_offset_tmp;
-      vbroadcastss(zmm_t(x_reg_idx), ptr[param_x + x_offset]);
+      broadcast_ps<T>(zmm_t(x_reg_idx), param_x + x_offset);
       // clean
       if (k == 0) {
         for (int i = 0; i < groups[g]; ++i) {
@@ -58,8 +59,8 @@ void MatMulJitCode::genCode() {
         }
       }
       for (int i = 0; i < groups[g]; ++i) {
-        vmovups(zmm_t(w_reg_idx),
-                ptr[reg_ptr_wgt + wgt_offset + k * n_ * sizeof(float)]);
+        load_ps<T>(zmm_t(w_reg_idx),
+                   reg_ptr_wgt + wgt_offset + k * n_ * sizeof(T));
         vfmadd231ps(zmm_t(i), zmm_t(w_reg_idx), zmm_t(x_reg_idx));
         wgt_offset += block_len;
       }
@@ -70,14 +71,15 @@ void MatMulJitCode::genCode() {
           if (rest != 0 && g == groups.size() - 1 && i == groups[g] - 1) {
             break;
           }
-          vmovups(ptr[param_z + z_offset + i * block_len], zmm_t(i));
+          store_ps<T>(param_z + z_offset + i * block_len, zmm_t(i));
         }
       }
-      x_offset += sizeof(float);
+      x_offset += sizeof(T);
     }
     z_offset += block_len * groups[g];
   }
 
+  // rest is 0 for 16 bits
   if (rest != 0) {
     // below should refine with mask
     int reg_idx = groups.back() - 1;
@@ -106,19 +108,24 @@ void MatMulJitCode::genCode() {
   postCode();
 }
 
-class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
+template <typename T>
+class MatMulCreator : public JitCodeCreator<matmul_attr_t, T> {
  public:
   bool CanBeUsed(const matmul_attr_t& attr) const override {
-    return attr.m == 1 &&
-           phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f) &&
-           attr.n % ZMM_FLOAT_BLOCK == 0 && attr.k < 512;
+    bool isa = std::is_same<T, float>::value
+                   ? phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f)
+                   : MayIUseHalf<T>();
+    return attr.m == 1 && isa && attr.n % ZMM_FLOAT_BLOCK == 0 &&
+           attr.k < 512;
   }
   size_t CodeSize(const matmul_attr_t& attr) const override {
     int block = YMM_FLOAT_BLOCK;
     if (phi::backends::cpu::MayIUse(phi::backends::cpu::avx512f)) {
       block = ZMM_FLOAT_BLOCK;
     }
-    return 96 + 4 * attr.k * (attr.n / block + 1) * 8;
+    // the loads and stores of 16 bits take two instructions
+    int insts = std::is_same<T, float>::value ? 4 : 6;
+    return 96 + insts * attr.k * (attr.n / block + 1) * 8;
   }
   std::unique_ptr<GenBase> CreateJitCode(
       const matmul_attr_t& attr) const override {
@@ -143,7 +150,7 @@ class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
             "The attribute k (second matrix's col) of MatMul should "
             "be larger than 0. But it is %d.",
             attr.k));
-    return make_unique<MatMulJitCode>(attr, CodeSize(attr));
+    return make_unique<MatMulJitCode<T>>(attr, CodeSize(attr));
   }
 };
 
@@ -153,4 +160,7 @@ class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
 
 namespace gen = phi::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kMatMul, gen::MatMulCreator);
+REGISTER_JITKERNEL_GEN(kMatMul,
+                       gen::MatMulCreator<float>,
+                       gen::MatMulCreator<phi::dtype::bfloat16>,
+                       gen::MatMulCreator<phi::dtype::float16>);
@@ -27,6 +27,9 @@ namespace phi {
 namespace jit {
 namespace gen {
 
+// T is float, bfloat16 or float16, the values of bfloat16 and float16 are
+// computed in fp32 and n should be a multiple of ZMM_FLOAT_BLOCK.
+template <typename T>
 class MatMulJitCode : public JitCode {
  public:
   explicit MatMulJitCode(const matmul_attr_t& attr,
@@ -39,11 +42,19 @@ class MatMulJitCode : public JitCode {
         phi::errors::Unimplemented("Jitcode of matmul only support m==1 (first "
                                    "matrix's row) now. But m is %d.",
                                    m_));
+    PADDLE_ENFORCE_EQ(
+        std::is_same<T, float>::value || n_ % ZMM_FLOAT_BLOCK == 0,
+        true,
+        phi::errors::Unimplemented(
+            "Jitcode of matmul of 16 bits only support n (second matrix's "
+            "col) of multiple of %d. But n is %d.",
+            ZMM_FLOAT_BLOCK,
+            n_));
     this->genCode();
   }
 
   std::string name() const override {
-    std::string base = "MatMulJitCode";
+    std::string base = "MatMulJitCode" + DataTypeSuffix<T>();
     base = base + "_M" + std::to_string(m_) + "_N" + std::to_string(n_) + "_K" +
            std::to_string(k_);
     return base;
@@ -0,0 +1,191 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/jit/gen/softmax.h"
+
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/kernels/funcs/jit/registry.h"
+
+namespace phi {
+namespace jit {
+namespace gen {
+
+void SoftmaxJitCode::for_each_block(const std::function<void()>& body) {
+  const int num_blocks = num_ / YMM_FLOAT_BLOCK;
+  if (num_blocks == 0) {
+    return;
+  }
+  Label l_next_block;
+  mov(reg_ptr_x, param_x);
+  mov(reg_ptr_y, param_y);
+  mov(reg_num_blocks, num_blocks);
+  L(l_next_block);
+  body();
+  add(reg_ptr_x, sizeof(float) * YMM_FLOAT_BLOCK);
+  add(reg_ptr_y, sizeof(float) * YMM_FLOAT_BLOCK);
+  dec(reg_num_blocks);
+  jnz(l_next_block, T_NEAR);
+}
+
+void SoftmaxJitCode::reduce(const ymm_t& ymm, bool is_max) {
+  xmm_t xmm = xmm_t(ymm.getIdx());
+  auto op = [&](const xmm_t& tmp) {
+    if (is_max) {
+      vmaxps(xmm, xmm, tmp);
+    } else {
+      vaddps(xmm, xmm, tmp);
+    }
+  };
+  vextractf128(xmm_tmp, ymm, 1);
+  op(xmm_tmp);
+  vpermilps(xmm_tmp, xmm, 0x4e);
+  op(xmm_tmp);
+  vpermilps(xmm_tmp, xmm, 0xb1);
+  op(xmm_tmp);
+}
+
+void SoftmaxJitCode::broadcast(const ymm_t& ymm) {
+  xmm_t xmm = xmm_t(ymm.getIdx());
+  vpermilps(xmm, xmm, 0);
+  vinsertf128(ymm, ymm, xmm, 1);
+}
+
+void SoftmaxJitCode::load_shifted(const ymm_t& src, const Xbyak::Address& x) {
+  vmovups(src, x);
+  vsubps(src, src, ymm_max);
+  vmaxps(src, src, ymm_clip);
+}
+
+void SoftmaxJitCode::load_shifted(const xmm_t& src, const Xbyak::Address& x) {
+  vmovss(src, x);
+  vsubss(src, src, xmm_max);
+  vmaxss(src, src, xmm_clip);
+}
+
+void SoftmaxJitCode::genCode() {
+  const int rest_offset = num_ / YMM_FLOAT_BLOCK * YMM_FLOAT_BLOCK;
+  const int rest = num_ % YMM_FLOAT_BLOCK;
+  Label l_next_row, l_end;
+  mov(reg_bs.cvt32(), param_bs);
+  test(reg_bs, reg_bs);
+  jz(l_end, T_NEAR);
+  mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
+  vmovaps(ymm_clip, ptr[reg_ptr_global + OFFSET_SOFTMAX_CLIP]);
+  L(l_next_row);
+
+  // max of the row
+  vmovaps(ymm_max, ptr[reg_ptr_global + OFFSET_FLOAT_LOWEST]);
+  for_each_block([&] { vmaxps(ymm_max, ymm_max, ptr[reg_ptr_x]); });
+  reduce(ymm_max, true);
+  for (int i = 0; i < rest; ++i) {
+    vmaxss(xmm_max, xmm_max, ptr[param_x + (rest_offset + i) * sizeof(float)]);
+  }
+  broadcast(ymm_max);
+
+  // y = exp(x - max) if not log, and the sum of them
+  vxorps(ymm_sum, ymm_sum, ymm_sum);
+  for_each_block([&] {
+    load_shifted(ymm_src, ptr[reg_ptr_x]);
+    exp_jmm<ymm_t>(ymm_dst, ymm_src, 11, 12, 13, 14, 15);
+    vaddps(ymm_sum, ymm_sum, ymm_dst);
+    if (!is_log_) {
+      vmovups(ptr[reg_ptr_y], ymm_dst);
+    }
+  });
+  reduce(ymm_sum, false);
+  for (int i = 0; i < rest; ++i) {
+    const size_t offset = (rest_offset + i) * sizeof(float);
+    load_shifted(xmm_src, ptr[param_x + offset]);
+    exp_jmm<xmm_t>(xmm_dst, xmm_src, 11, 12, 13, 14, 15);
+    vaddss(xmm_sum, xmm_sum, xmm_dst);
+    if (!is_log_) {
+      vmovss(ptr[param_y + offset], xmm_dst);
+    }
+  }
+
+  if (is_log_) {
+    // y = x - max - log(sum), log(sum) = ln2 * log2(sum) by x87
+    sub(rsp, 8);
+    vmovss(ptr[rsp], xmm_sum);
+    fldln2();
+    fld(dword[rsp]);
+    fyl2x();
+    fstp(dword[rsp]);
+    vmovss(xmm_sum, ptr[rsp]);
+    add(rsp, 8);
+    broadcast(ymm_sum);
+    for_each_block([&] {
+      load_shifted(ymm_src, ptr[reg_ptr_x]);
+      vsubps(ymm_dst, ymm_src, ymm_sum);
+      vmovups(ptr[reg_ptr_y], ymm_dst);
+    });
+    for (int i = 0; i < rest; ++i) {
+      const size_t offset = (rest_offset + i) * sizeof(float);
+      load_shifted(xmm_src, ptr[param_x + offset]);
+      vsubss(xmm_dst, xmm_src, xmm_sum);
+      vmovss(ptr[param_y + offset], xmm_dst);
+    }
+  } else {
+    // y = y / sum
+    vmovss(xmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    vdivss(xmm_sum, xmm_tmp, xmm_sum);
+    broadcast(ymm_sum);
+    for_each_block([&] {
+      vmulps(ymm_dst, ymm_sum, ptr[reg_ptr_y]);
+      vmovups(ptr[reg_ptr_y], ymm_dst);
+    });
+    for (int i = 0; i < rest; ++i) {
+      const size_t offset = (rest_offset + i) * sizeof(float);
+      vmulss(xmm_dst, xmm_sum, ptr[param_y + offset]);
+      vmovss(ptr[param_y + offset], xmm_dst);
+    }
+  }
+
+  add(param_x, num_ * sizeof(float));
+  add(param_y, num_ * sizeof(float));
+  dec(reg_bs);
+  jnz(l_next_row, T_NEAR);
+  L(l_end);
+  vzeroupper();
+  ret();
+}
+
+#define DECLARE_SOFTMAX_CREATOR(name, is_log)                                  \
+  class name##Creator : public JitCodeCreator<int> {                           \
+   public:                                                                     \
+    bool CanBeUsed(const int& attr) const override {                           \
+      return phi::backends::cpu::MayIUse(phi::backends::cpu::avx) && attr > 0; \
+    }                                                                          \
+    size_t CodeSize(const int& d) const override {                             \
+      /* exp takes about 70 instructions, once per block and per rest */       \
+      return 96 + (d % YMM_FLOAT_BLOCK + 3) * 90 * 8;                          \
+    }                                                                          \
+    std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override {   \
+      return make_unique<SoftmaxJitCode>(attr, is_log, CodeSize(attr));        \
+    }                                                                          \
+  }
+
+DECLARE_SOFTMAX_CREATOR(Softmax, false);
+DECLARE_SOFTMAX_CREATOR(LogSoftmax, true);
+
+#undef DECLARE_SOFTMAX_CREATOR
+
+}  // namespace gen
+}  // namespace jit
+}  // namespace phi
+
+namespace gen = phi::jit::gen;
+
+REGISTER_JITKERNEL_GEN(kSoftmax, gen::SoftmaxCreator);
+REGISTER_JITKERNEL_GEN(kLogSoftmax, gen::LogSoftmaxCreator);
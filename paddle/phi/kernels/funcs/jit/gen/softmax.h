@@ -0,0 +1,85 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "glog/logging.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/kernels/funcs/jit/gen/act.h"
+
+namespace phi {
+namespace jit {
+namespace gen {
+
+// The softmax or log softmax of bs rows of n. Each row takes three passes:
+// the max, the sum of exp(x - max) and the scaling or the shift by log(sum).
+// As SoftmaxFunctor, x - max is clipped at -64 before exp.
+class SoftmaxJitCode : public VActFunc {
+ public:
+  explicit SoftmaxJitCode(int n,
+                          bool is_log,
+                          size_t code_size,
+                          void* code_ptr = nullptr)
+      : VActFunc(code_size, code_ptr), num_(n), is_log_(is_log) {
+    this->genCode();
+  }
+
+  std::string name() const override {
+    std::string base = is_log_ ? "LogSoftmaxJitCode" : "SoftmaxJitCode";
+    return base + "_N" + std::to_string(num_);
+  }
+  void genCode() override;
+
+ private:
+  // runs body on the blocks of ymm of the row at reg_ptr_x and reg_ptr_y
+  void for_each_block(const std::function<void()>& body);
+  // reduces the lanes of ymm to the lowest one by max or add
+  void reduce(const ymm_t& ymm, bool is_max);
+  // broadcasts the lowest lane of ymm to all the lanes
+  void broadcast(const ymm_t& ymm);
+  // loads x - max clipped at -64 to src
+  void load_shifted(const ymm_t& src, const Xbyak::Address& x);
+  void load_shifted(const xmm_t& src, const Xbyak::Address& x);
+
+  int num_;
+  bool is_log_;
+  reg64_t param_x{abi_param1};
+  reg64_t param_y{abi_param2};
+  reg32_t param_bs{abi_param4};
+
+  reg64_t reg_ptr_global{rdx};
+  reg64_t reg_num_blocks{r8};
+  reg64_t reg_ptr_x{r9};
+  reg64_t reg_ptr_y{r10};
+  reg64_t reg_bs{r11};
+
+  xmm_t xmm_src = xmm_t(0);
+  ymm_t ymm_src = ymm_t(0);
+  xmm_t xmm_dst = xmm_t(1);
+  ymm_t ymm_dst = ymm_t(1);
+  xmm_t xmm_max = xmm_t(2);
+  ymm_t ymm_max = ymm_t(2);
+  xmm_t xmm_sum = xmm_t(3);
+  ymm_t ymm_sum = ymm_t(3);
+  xmm_t xmm_clip = xmm_t(4);
+  ymm_t ymm_clip = ymm_t(4);
+  xmm_t xmm_tmp = xmm_t(5);
+};
+
+}  // namespace gen
+}  // namespace jit
+}  // namespace phi
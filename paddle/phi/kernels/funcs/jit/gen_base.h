@@ -64,7 +64,9 @@ class GenCreator {
   virtual ~GenCreator() = default;
 };
 
-template <typename Attr>
+// T is the data type of the code, the codes of the same attr but of different
+// data types are created by different creators.
+template <typename Attr, typename T = float>
 class JitCodeCreator : public GenCreator {
  public:
   virtual ~JitCodeCreator() = default;
@@ -52,9 +52,12 @@ const char* to_string(KernelType kt) {
     ONE_CASE(kGRUH1);
     ONE_CASE(kGRUHtPart1);
     ONE_CASE(kGRUHtPart2);
+    ONE_CASE(kGelu);
     ONE_CASE(kCRFDecoding);
     ONE_CASE(kLayerNorm);
+    ONE_CASE(kLogSoftmax);
     ONE_CASE(kSeqPool);
+    ONE_CASE(kSoftmax);
     ONE_CASE(kMatMul);
     ONE_CASE(kAdam);
     ONE_CASE(kAdamW);
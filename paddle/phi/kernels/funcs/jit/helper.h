@@ -34,15 +34,18 @@ namespace jit {
 
 class GenBase;
 
+// The jit codes are generated for float, bfloat16 and float16 on CPU.
 template <typename KernelTuple, typename PlaceType>
 inline typename std::enable_if<
-    std::is_same<typename KernelTuple::data_type, float>::value &&
+    (std::is_same<typename KernelTuple::data_type, float>::value ||
+     IsHalfType<typename KernelTuple::data_type>::value) &&
         std::is_same<PlaceType, phi::CPUPlace>::value,
     const Kernel*>::type
 GetJitCode(const typename KernelTuple::attr_type& attr) {
+  using T = typename KernelTuple::data_type;
   using Attr = typename KernelTuple::attr_type;
   int64_t key = JitCodeKey<Attr>(attr);
-  auto& codes = JitCodePool<KernelTuple::kernel_type>::Instance();
+  auto& codes = JitCodePool<KernelTuple::kernel_type, T>::Instance();
   if (codes.Has(key)) {
     return codes.AllKernels().at(key).get();
   }
@@ -55,7 +58,7 @@ GetJitCode(const typename KernelTuple::attr_type& attr) {
   if (iter != creator_map.end()) {
     auto& creators = iter->second;
     for (auto& cur : creators) {
-      auto i = dynamic_cast<const JitCodeCreator<Attr>*>(cur.get());
+      auto i = dynamic_cast<const JitCodeCreator<Attr, T>*>(cur.get());
       if (i && i->CanBeUsed(attr)) {
         auto p = i->CreateJitCode(attr);
         if (p) {
@@ -71,7 +74,8 @@ GetJitCode(const typename KernelTuple::attr_type& attr) {
 
 template <typename KernelTuple, typename PlaceType>
 inline typename std::enable_if<
-    !std::is_same<typename KernelTuple::data_type, float>::value ||
+    (!std::is_same<typename KernelTuple::data_type, float>::value &&
+     !IsHalfType<typename KernelTuple::data_type>::value) ||
         !std::is_same<PlaceType, phi::CPUPlace>::value,
     const Kernel*>::type
 GetJitCode(const typename KernelTuple::attr_type& attr UNUSED) {
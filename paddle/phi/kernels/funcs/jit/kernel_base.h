@@ -14,8 +14,12 @@
 
 #pragma once
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 #include "paddle/common/macros.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
 #include "paddle/phi/kernels/funcs/jit/macro.h"
 
 namespace phi {
@@ -31,11 +35,14 @@ typedef enum {
   kGRUH1,
   kGRUHtPart1,
   kGRUHtPart2,
+  kGelu,
   kLSTMCtHt,
   kLSTMC1H1,
   kLayerNorm,
+  kLogSoftmax,
   kMatMul,
   kSeqPool,
+  kSoftmax,
   kVAdd,
   kVAddBias,
   kVAddRelu,
@@ -96,6 +103,14 @@ struct XRNSTuple {
   typedef void (*func_type)(const T*, T*, int, int);
 };
 
+// x, y, n, bs: bs rows of n
+template <typename T>
+struct XYNBTuple {
+  typedef T data_type;
+  typedef int attr_type;
+  typedef void (*func_type)(const T*, T*, int, int);
+};
+
 #define DECLARE_KERNELTUPLE(kernel_tuple, type)        \
   template <typename T>                                \
   struct type##Tuple : public kernel_tuple<T> {        \
@@ -119,6 +134,9 @@ DECLARE_KERNELTUPLE(XYNTuple, VSigmoid);
 DECLARE_KERNELTUPLE(XYNTuple, VTanh);
 DECLARE_KERNELTUPLE(XYNTuple, VCopy);
 
+DECLARE_KERNELTUPLE(XYNBTuple, Softmax);
+DECLARE_KERNELTUPLE(XYNBTuple, LogSoftmax);
+
 typedef struct {
   void* gates;  // gates: x_ch, x_ih, x_fh, x_oh
   const void* ct_1;
@@ -191,6 +209,16 @@ struct VBroadcastTuple {
   typedef void (*func_type)(const T*, T*, int64_t, int64_t);
 };
 
+// x, y, n, approximate. The attr is approximate rather than n, the code
+// loops over n at runtime so that one code serves all the sizes.
+template <typename T>
+struct GeluTuple {
+  static constexpr KernelType kernel_type = kGelu;
+  typedef T data_type;
+  typedef int attr_type;
+  typedef void (*func_type)(const T*, T*, int, int);
+};
+
 typedef struct seq_pool_attr_s {
   int h, w;  // h should always be the first one
   SeqPoolType type;
@@ -334,6 +362,57 @@ struct LayerNormTuple {
       T*, T*, T*, T*, const T*, const T*, int, const float, int);
 };
 
+// The kernels of bfloat16 and float16 compute in fp32 and round the results
+// to the nearest even once, as vcvtneps2bf16 and vcvtps2ph do.
+template <typename T>
+struct IsHalfType
+    : std::integral_constant<bool,
+                             std::is_same<T, phi::dtype::bfloat16>::value ||
+                                 std::is_same<T, phi::dtype::float16>::value> {
+};
+
+template <typename T>
+inline T RoundToHalf(float v);
+
+template <>
+inline phi::dtype::bfloat16 RoundToHalf<phi::dtype::bfloat16>(float v) {
+  uint32_t u;
+  std::memcpy(&u, &v, sizeof(u));
+  if ((u & 0x7fffffff) > 0x7f800000) {
+    u |= 0x00400000;  // quiet NaN
+  } else if ((u & 0x7f800000) == 0) {
+    u &= 0x80000000;  // denormal is zero as vcvtneps2bf16
+  } else {
+    u += 0x7fff + ((u >> 16) & 1);
+  }
+  return phi::dtype::raw_uint16_to_bfloat16(static_cast<uint16_t>(u >> 16));
+}
+
+template <>
+inline phi::dtype::float16 RoundToHalf<phi::dtype::float16>(float v) {
+  uint32_t u;
+  std::memcpy(&u, &v, sizeof(u));
+  uint32_t sign = (u >> 16) & 0x8000;
+  uint32_t abs = u & 0x7fffffff;
+  uint32_t h;
+  if (abs >= 0x7f800000) {
+    h = abs > 0x7f800000 ? 0x7e00 : 0x7c00;  // NaN or inf
+  } else if (abs >= 0x477ff000) {
+    h = 0x7c00;  // rounds to inf
+  } else if (abs < 0x38800000) {
+    // subnormal, the addition of 0.5 rounds the mantissa to the nearest even
+    float f;
+    std::memcpy(&f, &abs, sizeof(f));
+    f += 0.5f;
+    std::memcpy(&h, &f, sizeof(h));
+    h -= 0x3f000000;
+  } else {
+    abs += 0xc8000fff + ((abs >> 13) & 1);
+    h = abs >> 13;
+  }
+  return phi::dtype::raw_uint16_to_float16(static_cast<uint16_t>(h | sign));
+}
+
 // Just for adding to kernel pool without template
 class Kernel {
  public:
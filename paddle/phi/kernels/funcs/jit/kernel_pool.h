@@ -33,7 +33,7 @@ struct KernelKey;
 
 extern std::map<size_t, std::shared_ptr<void>>& GetJITCodesMap();
 
-template <KernelType KT>
+template <KernelType KT, typename T = float>
 class JitCodePool {
   typedef std::unique_ptr<GenBase> GenBasePtr;
   typedef std::unordered_map<int64_t, GenBasePtr> JitCodeMap;
@@ -42,14 +42,14 @@ class JitCodePool {
   JitCodePool() = default;
   static JitCodePool& Instance() {
     auto& jit_codes_map = GetJITCodesMap();
-    auto key = typeid(JitCodePool<KT>).hash_code();
+    auto key = typeid(JitCodePool<KT, T>).hash_code();
     auto iter = jit_codes_map.find(key);
     if (iter != jit_codes_map.end()) {
-      return *(JitCodePool<KT>*)(iter->second.get());
+      return *(JitCodePool<KT, T>*)(iter->second.get());
     } else {
-      std::shared_ptr<void> cache = std::make_shared<JitCodePool<KT>>();
+      std::shared_ptr<void> cache = std::make_shared<JitCodePool<KT, T>>();
       jit_codes_map.emplace(key, cache);
-      return *(JitCodePool<KT>*)(cache.get());
+      return *(JitCodePool<KT, T>*)(cache.get());
     }
   }
 
@@ -190,4 +190,9 @@ bool LayerNormKernel::CanBeUsed(const int& d) const {
 
 namespace intrinsic = phi::jit::more::intrinsic;
 
-REGISTER_JITKERNEL_MORE(kLayerNorm, intrinsic, intrinsic::LayerNormKernel);
+REGISTER_JITKERNEL_MORE(
+    kLayerNorm,
+    intrinsic,
+    intrinsic::LayerNormKernel,
+    intrinsic::LayerNormHalfKernel<phi::dtype::bfloat16>,
+    intrinsic::LayerNormHalfKernel<phi::dtype::float16>);
@@ -16,7 +16,9 @@
 
 #include <type_traits>
 
+#include "paddle/phi/backends/cpu/cpu_info.h"
 #include "paddle/phi/kernels/funcs/jit/kernel_base.h"
+#include "paddle/phi/kernels/funcs/jit/refer/refer.h"
 
 namespace phi {
 namespace jit {
@@ -41,6 +43,20 @@ class LayerNormKernel : public KernelMore<LayerNormTuple<float>> {
   const char* ImplType() const override { return "Intrinsic"; }
 };
 
+// bfloat16 and float16 are converted to fp32, normalized by LayerNorm and
+// rounded back once.
+template <typename T>
+class LayerNormHalfKernel : public KernelMore<LayerNormTuple<T>> {
+ public:
+  LayerNormHalfKernel() { this->func = refer::LayerNormHalf<T, LayerNorm>; }
+  bool CanBeUsed(
+      const typename LayerNormTuple<T>::attr_type& d) const override {
+    return phi::backends::cpu::MayIUse(phi::backends::cpu::avx) &&
+           d >= YMM_FLOAT_BLOCK;
+  }
+  const char* ImplType() const override { return "Intrinsic"; }
+};
+
 }  // namespace intrinsic
 }  // namespace more
 }  // namespace jit
@@ -22,21 +22,32 @@ namespace refer = phi::jit::refer;
   REGISTER_JITKERNEL_REFER(         \
       k##func, refer::func##Kernel<float>, refer::func##Kernel<double>)
 
-REGISTER_REFER_KERNEL(VMul);
-REGISTER_REFER_KERNEL(VAdd);
-REGISTER_REFER_KERNEL(VAddRelu);
-REGISTER_REFER_KERNEL(VSub);
+#define REGISTER_REFER_KERNEL_WITH_HALF(func)                             \
+  REGISTER_JITKERNEL_REFER(k##func,                                       \
+                           refer::func##Kernel<float>,                    \
+                           refer::func##Kernel<double>,                   \
+                           refer::func##HalfKernel<phi::dtype::bfloat16>, \
+                           refer::func##HalfKernel<phi::dtype::float16>)
+
+REGISTER_REFER_KERNEL_WITH_HALF(VMul);
+REGISTER_REFER_KERNEL_WITH_HALF(VAdd);
+REGISTER_REFER_KERNEL_WITH_HALF(VAddRelu);
+REGISTER_REFER_KERNEL_WITH_HALF(VSub);
 
 REGISTER_REFER_KERNEL(VScal);
 REGISTER_REFER_KERNEL(VAddBias);
 
-REGISTER_REFER_KERNEL(VRelu);
+REGISTER_REFER_KERNEL_WITH_HALF(VRelu);
 REGISTER_REFER_KERNEL(VCopy);
 REGISTER_REFER_KERNEL(VIdentity);
 REGISTER_REFER_KERNEL(VSquare);
-REGISTER_REFER_KERNEL(VExp);
-REGISTER_REFER_KERNEL(VSigmoid);
-REGISTER_REFER_KERNEL(VTanh);
+REGISTER_REFER_KERNEL_WITH_HALF(VExp);
+REGISTER_REFER_KERNEL_WITH_HALF(VSigmoid);
+REGISTER_REFER_KERNEL_WITH_HALF(VTanh);
+
+REGISTER_REFER_KERNEL(Softmax);
+REGISTER_REFER_KERNEL(LogSoftmax);
+REGISTER_REFER_KERNEL(Gelu);
 
 REGISTER_REFER_KERNEL(LSTMCtHt);
 REGISTER_REFER_KERNEL(LSTMC1H1);
@@ -46,13 +57,14 @@ REGISTER_REFER_KERNEL(GRUHtPart1);
 REGISTER_REFER_KERNEL(GRUHtPart2);
 
 REGISTER_REFER_KERNEL(CRFDecoding);
-REGISTER_REFER_KERNEL(LayerNorm);
+REGISTER_REFER_KERNEL_WITH_HALF(LayerNorm);
 REGISTER_REFER_KERNEL(SeqPool);
-REGISTER_REFER_KERNEL(MatMul);
-REGISTER_REFER_KERNEL(EmbSeqPool);
+REGISTER_REFER_KERNEL_WITH_HALF(MatMul);
+REGISTER_REFER_KERNEL_WITH_HALF(EmbSeqPool);
 REGISTER_REFER_KERNEL(Adam);
 REGISTER_REFER_KERNEL(AdamW);
 REGISTER_REFER_KERNEL(Sgd);
 REGISTER_REFER_KERNEL(VBroadcast);
 
 #undef REGISTER_REFER_KERNEL
+#undef REGISTER_REFER_KERNEL_WITH_HALF
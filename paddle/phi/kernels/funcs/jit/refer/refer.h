@@ -14,9 +14,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <string>
+#include <vector>
 
 #include "paddle/phi/core/enforce.h"
 #include "paddle/phi/kernels/funcs/jit/helper.h"
@@ -135,6 +137,70 @@ void VTanh(const T* x, T* y, int n) {
   }
 }
 
+// The softmax of bs rows of n. As SoftmaxFunctor, x - max is clipped at -64
+// before exp.
+template <typename T>
+void Softmax(const T* x, T* y, int n, int bs) {
+  for (int i = 0; i < bs; ++i) {
+    T max = x[0];
+    for (int j = 1; j < n; ++j) {
+      max = std::max(max, x[j]);
+    }
+    T sum = 0;
+    for (int j = 0; j < n; ++j) {
+      y[j] = std::exp(std::max(x[j] - max, static_cast<T>(-64)));
+      sum += y[j];
+    }
+    T scale = static_cast<T>(1) / sum;
+    for (int j = 0; j < n; ++j) {
+      y[j] *= scale;
+    }
+    x += n;
+    y += n;
+  }
+}
+
+// y = clip(x - max) - log(sum(exp(clip(x - max)))) of bs rows of n
+template <typename T>
+void LogSoftmax(const T* x, T* y, int n, int bs) {
+  for (int i = 0; i < bs; ++i) {
+    T max = x[0];
+    for (int j = 1; j < n; ++j) {
+      max = std::max(max, x[j]);
+    }
+    T sum = 0;
+    for (int j = 0; j < n; ++j) {
+      sum += std::exp(std::max(x[j] - max, static_cast<T>(-64)));
+    }
+    T log_sum = std::log(sum);
+    for (int j = 0; j < n; ++j) {
+      y[j] = std::max(x[j] - max, static_cast<T>(-64)) - log_sum;
+    }
+    x += n;
+    y += n;
+  }
+}
+
+// y = 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3))) if
+// approximate, otherwise y = 0.5 * x * (1 + erf(x / sqrt(2)))
+template <typename T>
+void Gelu(const T* x, T* y, int n, int approximate) {
+  const T half = static_cast<T>(0.5);
+  if (approximate) {
+    const T sqrt_2_pi = static_cast<T>(0.79788456080286535588);
+    const T coeff = static_cast<T>(0.044715);
+    for (int i = 0; i < n; ++i) {
+      T inner = sqrt_2_pi * (x[i] + coeff * x[i] * x[i] * x[i]);
+      y[i] = half * x[i] * (static_cast<T>(1) + std::tanh(inner));
+    }
+  } else {
+    const T sqrt1_2 = static_cast<T>(0.70710678118654752440);
+    for (int i = 0; i < n; ++i) {
+      y[i] = half * x[i] * (static_cast<T>(1) + std::erf(x[i] * sqrt1_2));
+    }
+  }
+}
+
 template <typename T>
 void (*getActFunc(KernelType type))(const T*, T*, int) {  // NOLINT
   if (type == kVSigmoid) {
@@ -562,6 +628,101 @@ void AdamW(T beta1,
   }
 }
 
+// The refer codes of bfloat16 and float16 convert the inputs to fp32, call
+// the fp32 refer code Func and round the outputs once.
+template <typename T>
+void RoundToHalf(const float* x, T* y, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    y[i] = jit::RoundToHalf<T>(x[i]);
+  }
+}
+
+template <typename T, typename XYZNTuple<float>::func_type Func>
+void XYZNHalf(const T* x, const T* y, T* z, int n) {
+  std::vector<float> xf(x, x + n), yf(y, y + n), zf(n);
+  Func(xf.data(), yf.data(), zf.data(), n);
+  RoundToHalf(zf.data(), z, n);
+}
+
+template <typename T, typename XYNTuple<float>::func_type Func>
+void XYNHalf(const T* x, T* y, int n) {
+  std::vector<float> xf(x, x + n), yf(n);
+  Func(xf.data(), yf.data(), n);
+  RoundToHalf(yf.data(), y, n);
+}
+
+template <typename T, typename LayerNormTuple<float>::func_type Func>
+void LayerNormHalf(T* x,
+                   T* out,
+                   T* mean,
+                   T* var,
+                   const T* scale,
+                   const T* bias,
+                   int height,
+                   const float epsilon,
+                   int right) {
+  int64_t numel = static_cast<int64_t>(height) * right;
+  std::vector<float> xf(x, x + numel), outf(numel), meanf(height),
+      varf(height);
+  std::vector<float> scalef, biasf;
+  if (scale) {
+    scalef.assign(scale, scale + right);
+  }
+  if (bias) {
+    biasf.assign(bias, bias + right);
+  }
+  Func(xf.data(),
+       outf.data(),
+       meanf.data(),
+       varf.data(),
+       scale ? scalef.data() : nullptr,
+       bias ? biasf.data() : nullptr,
+       height,
+       epsilon,
+       right);
+  RoundToHalf(outf.data(), out, numel);
+  RoundToHalf(meanf.data(), mean, height);
+  RoundToHalf(varf.data(), var, height);
+}
+
+template <typename T, typename MatMulTuple<float>::func_type Func>
+void MatMulHalf(const T* A, const T* B, T* C, const matmul_attr_t* attr) {
+  int64_t M = attr->m, N = attr->n, K = attr->k;
+  std::vector<float> af(A, A + M * K), bf(B, B + K * N), cf(M * N);
+  Func(af.data(), bf.data(), cf.data(), attr);
+  RoundToHalf(cf.data(), C, M * N);
+}
+
+// Gathers the rows of idx in fp32, so that the rows are summed in fp32.
+template <typename T, typename EmbSeqPoolTuple<float>::func_type Func>
+void EmbSeqPoolHalf(const T* table,
+                    const int64_t* idx,
+                    T* out,
+                    const emb_seq_pool_attr_t* attr) {
+  int64_t num = attr->index_height * attr->index_width;
+  int64_t width = attr->table_width;
+  std::vector<float> rows(num * width), outf(attr->out_width);
+  std::vector<int64_t> row_idx(num);
+  for (int64_t i = 0; i < num; ++i) {
+    PADDLE_ENFORCE_EQ(
+        idx[i] >= 0 && idx[i] < attr->table_height,
+        true,
+        phi::errors::InvalidArgument(
+            "The %dth of idx of EmbSeqPool is %d, which should be in [0, %d).",
+            i,
+            idx[i],
+            attr->table_height));
+    std::copy(table + idx[i] * width,
+              table + (idx[i] + 1) * width,
+              rows.begin() + i * width);
+    row_idx[i] = i;
+  }
+  emb_seq_pool_attr_t rows_attr = *attr;
+  rows_attr.table_height = num;
+  Func(rows.data(), row_idx.data(), outf.data(), &rows_attr);
+  RoundToHalf(outf.data(), out, attr->out_width);
+}
+
 #define DECLARE_REFER_KERNEL(name)                          \
   template <typename T>                                     \
   class name##Kernel : public ReferKernel<name##Tuple<T>> { \
@@ -588,6 +749,11 @@ DECLARE_REFER_KERNEL(VTanh);
 DECLARE_REFER_KERNEL(VSquare);
 DECLARE_REFER_KERNEL(VCopy);
 
+// x, y, n, bs or approximate
+DECLARE_REFER_KERNEL(Softmax);
+DECLARE_REFER_KERNEL(LogSoftmax);
+DECLARE_REFER_KERNEL(Gelu);
+
 // lstm_t*, const lstm_attr_t*
 DECLARE_REFER_KERNEL(LSTMCtHt);
 DECLARE_REFER_KERNEL(LSTMC1H1);
@@ -608,7 +774,28 @@ DECLARE_REFER_KERNEL(AdamW);
 DECLARE_REFER_KERNEL(Sgd);
 DECLARE_REFER_KERNEL(VBroadcast);
 
+// the kernels of bfloat16 and float16
+#define DECLARE_REFER_HALF_KERNEL(name, wrapper)                 \
+  template <typename T>                                          \
+  class name##HalfKernel : public ReferKernel<name##Tuple<T>> {  \
+   public:                                                       \
+    name##HalfKernel() { this->func = wrapper<T, name<float>>; } \
+  }
+
+DECLARE_REFER_HALF_KERNEL(VMul, XYZNHalf);
+DECLARE_REFER_HALF_KERNEL(VAdd, XYZNHalf);
+DECLARE_REFER_HALF_KERNEL(VAddRelu, XYZNHalf);
+DECLARE_REFER_HALF_KERNEL(VSub, XYZNHalf);
+DECLARE_REFER_HALF_KERNEL(VRelu, XYNHalf);
+DECLARE_REFER_HALF_KERNEL(VExp, XYNHalf);
+DECLARE_REFER_HALF_KERNEL(VSigmoid, XYNHalf);
+DECLARE_REFER_HALF_KERNEL(VTanh, XYNHalf);
+DECLARE_REFER_HALF_KERNEL(LayerNorm, LayerNormHalf);
+DECLARE_REFER_HALF_KERNEL(MatMul, MatMulHalf);
+DECLARE_REFER_HALF_KERNEL(EmbSeqPool, EmbSeqPoolHalf);
+
 #undef DECLARE_REFER_KERNEL
+#undef DECLARE_REFER_HALF_KERNEL
 
 }  // namespace refer
 }  // namespace jit
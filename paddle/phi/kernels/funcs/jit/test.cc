@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include <array>
+#include <cmath>
 #include <iostream>
 #include <random>
 
@@ -29,8 +30,8 @@ PD_DEFINE_double(acc, 1e-5, "Test accuracy threshold.");
 template <typename T>
 void RandomVec(const int n,
                T* a,
-               const T lower = static_cast<T>(-2.f),
-               const T upper = static_cast<T>(2.f)) {
+               const double lower = -2.0,
+               const double upper = 2.0) {
   static unsigned int seed = 100;
   std::mt19937 rng(seed++);
   std::uniform_real_distribution<double> uniform_dist(0, 1);
@@ -41,7 +42,19 @@ void RandomVec(const int n,
 
 template <typename T>
 void ExpectEQ(const T* target, const T* refer, size_t n) {
-  if (std::is_floating_point<T>::value) {
+  if (phi::jit::IsHalfType<T>::value) {
+    // the fp32 results of the kernels differ slightly, and may be rounded to
+    // the adjacent values of 16 bits
+    const float eps =
+        std::is_same<T, phi::dtype::bfloat16>::value ? 1.f / 128 : 1.f / 1024;
+    for (size_t i = 0; i < n; ++i) {
+      float ref = static_cast<float>(refer[i]);
+      EXPECT_NEAR(static_cast<float>(target[i]),
+                  ref,
+                  std::fabs(ref) * eps + FLAGS_acc)
+          << " at index : " << i;
+    }
+  } else if (std::is_floating_point<T>::value) {
     for (size_t i = 0; i < n; ++i) {
       EXPECT_NEAR(target[i], refer[i], FLAGS_acc) << " at index : " << i;
     }
@@ -391,7 +404,7 @@ template <typename KernelTuple, typename PlaceType>
 void TestKernelLayerNorm() {
   using T = typename KernelTuple::data_type;
   VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
-  const T epsilon = 9.99999975e-06;
+  const float epsilon = 9.99999975e-06;
   for (int n : {1, 2, 10}) {
     for (int x_dim_0 : {1, 9, 17, 50}) {
       int left = n * x_dim_0;
@@ -657,7 +670,7 @@ void TestKernelMatMul() {
   // export KMP_DETERMINISTIC_REDUCTION=yes would make the result deterministic
   FLAGS_acc = 1e-3;
   for (int m : {1, 2, 3, 4}) {
-    for (int n : {1, 2, 3, 4}) {
+    for (int n : {1, 2, 3, 4, 16}) {
       for (int k : TestSizes()) {
         auto ref = jit::GetReferFunc<KernelTuple>();
         EXPECT_TRUE(ref != nullptr);
@@ -1053,13 +1066,83 @@ void TestKernelVBroadcast() {
   }
 }
 
+template <typename KernelTuple, typename PlaceType>
+void TestKernelXYNB() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  for (int n : TestSizes()) {
+    for (int bs : {1, 2, 7}) {
+      auto ref = jit::GetReferFunc<KernelTuple>();
+      EXPECT_TRUE(ref != nullptr);
+      std::vector<T> x(n * bs), yref(n * bs);
+      RandomVec<T>(n * bs, x.data(), -5.0, 5.0);
+      ref(x.data(), yref.data(), n, bs);
+
+      auto verifier = [](const typename KernelTuple::func_type tgt,
+                         const std::vector<T>& x,
+                         const std::vector<T>& yref,
+                         const int bs) {
+        EXPECT_TRUE(tgt != nullptr);
+        EXPECT_EQ(yref.size(), x.size());
+        const int n = yref.size() / bs;
+        std::vector<T> ytgt(yref.size());
+        T* ytgt_data = ytgt.data();
+        // test normal
+        tgt(x.data(), ytgt_data, n, bs);
+        ExpectEQ<T>(ytgt_data, yref.data(), yref.size());
+        // test inplace x
+        std::copy(x.begin(), x.end(), ytgt.begin());
+        tgt(ytgt_data, ytgt_data, n, bs);
+        ExpectEQ<T>(ytgt_data, yref.data(), yref.size());
+      };
+      TestAllImpls<KernelTuple, PlaceType>(n, verifier, x, yref, bs);
+    }
+  }
+}
+
+template <typename KernelTuple, typename PlaceType>
+void TestKernelGelu() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  for (int approximate : {0, 1}) {
+    // the kernel of an approximate serves all the sizes
+    for (int d : TestSizes()) {
+      auto ref = jit::GetReferFunc<KernelTuple>();
+      EXPECT_TRUE(ref != nullptr);
+      std::vector<T> x(d), yref(d);
+      RandomVec<T>(d, x.data(), -5.0, 5.0);
+      ref(x.data(), yref.data(), d, approximate);
+
+      auto verifier = [](const typename KernelTuple::func_type tgt,
+                         const std::vector<T>& x,
+                         const std::vector<T>& yref,
+                         const int approximate) {
+        EXPECT_TRUE(tgt != nullptr);
+        EXPECT_EQ(yref.size(), x.size());
+        const int d = yref.size();
+        std::vector<T> ytgt(d);
+        T* ytgt_data = ytgt.data();
+        // test normal
+        tgt(x.data(), ytgt_data, d, approximate);
+        ExpectEQ<T>(ytgt_data, yref.data(), d);
+        // test inplace x
+        std::copy(x.begin(), x.end(), ytgt.begin());
+        tgt(ytgt_data, ytgt_data, d, approximate);
+        ExpectEQ<T>(ytgt_data, yref.data(), d);
+      };
+      TestAllImpls<KernelTuple, PlaceType>(
+          approximate, verifier, x, yref, approximate);
+    }
+  }
+}
+
 // test pool
 TEST(JITKernel_pool, jitcreator) {
   const auto& jitcreators = jit::JitCodeCreatorPool::Instance().AllCreators();
 #if defined(_WIN32) || defined(__APPLE__) || defined(__OSX__)
   EXPECT_EQ(jitcreators.size(), 0UL);
 #else
-  EXPECT_EQ(jitcreators.size(), 24UL);
+  EXPECT_EQ(jitcreators.size(), 27UL);
 #endif
 }
 
@@ -1076,6 +1159,25 @@ TEST(JITKernel_pool, jitpool) {
 #endif
 }
 
+TEST(JITKernel_pool, jitpool_half) {
+  // the jitcodes of different data types are kept apart
+  using bf16 = phi::dtype::bfloat16;
+  const auto& kers = jit::JitCodePool<jit::kVAdd>().Instance().AllKernels();
+  const auto& bf16_kers =
+      jit::JitCodePool<jit::kVAdd, bf16>().Instance().AllKernels();
+  size_t num = kers.size();
+  jit::GetAllCandidateKernels<jit::VAddTuple<bf16>, CPUPlace>(5);
+  EXPECT_EQ(kers.size(), num);
+#if defined(_WIN32) || defined(__APPLE__) || defined(__OSX__)
+  EXPECT_EQ(bf16_kers.size(), 0UL);
+#else
+  bool has_bf16 =
+      phi::backends::cpu::MayIUse(phi::backends::cpu::avx512_core) &&
+      phi::backends::cpu::MayIUse(phi::backends::cpu::avx512_bf16);
+  EXPECT_EQ(bf16_kers.size(), has_bf16 ? 1UL : 0UL);
+#endif
+}
+
 TEST(JITKernel_pool, more) {
   const auto& kers = jit::KernelPool::Instance().AllKernels();
   size_t target_num = 7;
@@ -1093,7 +1195,7 @@ TEST(JITKernel_pool, more) {
 
 TEST(JITKernel_pool, refer) {
   const auto& kers = jit::ReferKernelPool::Instance().AllKernels();
-  EXPECT_EQ(kers.size(), 27UL);
+  EXPECT_EQ(kers.size(), 30UL);
 }
 
 // test helper
@@ -1269,6 +1371,23 @@ TEST(JITKernel_helper, attr) {
 }
 
 // test keys
+TEST(JITKernel_helper, round_to_half) {
+  using bf16 = phi::dtype::bfloat16;
+  using fp16 = phi::dtype::float16;
+  // ties to even
+  EXPECT_EQ(jit::RoundToHalf<bf16>(1.00390625f).x, 0x3f80);
+  EXPECT_EQ(jit::RoundToHalf<bf16>(1.01171875f).x, 0x3f82);
+  EXPECT_EQ(jit::RoundToHalf<fp16>(2049.f).x, 0x6800);
+  EXPECT_EQ(jit::RoundToHalf<fp16>(2051.f).x, 0x6802);
+  // overflow, subnormal and NaN
+  EXPECT_EQ(jit::RoundToHalf<fp16>(65520.f).x, 0x7c00);
+  EXPECT_EQ(jit::RoundToHalf<fp16>(65519.f).x, 0x7bff);
+  EXPECT_EQ(jit::RoundToHalf<fp16>(-1.5e-5f).x, 0x80fc);
+  EXPECT_EQ(jit::RoundToHalf<bf16>(1e-40f).x, 0);
+  EXPECT_EQ(jit::RoundToHalf<bf16>(NAN).x, 0x7fc0);
+  EXPECT_EQ(jit::RoundToHalf<fp16>(NAN).x, 0x7e00);
+}
+
 TEST(JITKernel_key, int) {
   EXPECT_TRUE(jit::JitCodeKey<int>(2) == jit::JitCodeKey<int>(2));
   EXPECT_TRUE(jit::JitCodeKey<int>(2) == jit::JitCodeKey<int64_t>(2));
@@ -1426,6 +1545,9 @@ TEST(JITKernel_key, sgd) {
 #define TestKernelVTanh TestKernelXYN
 #define TestKernelVCopy TestKernelXYN
 
+#define TestKernelSoftmax TestKernelXYNB
+#define TestKernelLogSoftmax TestKernelXYNB
+
 #define TestKernelLSTMCtHt TestKernelLSTM
 #define TestKernelLSTMC1H1 TestKernelLSTM
 
@@ -1455,6 +1577,10 @@ TEST_CPU_KERNEL(VSigmoid);
 TEST_CPU_KERNEL(VTanh);
 TEST_CPU_KERNEL(VCopy);
 
+TEST_CPU_KERNEL(Softmax);
+TEST_CPU_KERNEL(LogSoftmax);
+TEST_CPU_KERNEL(Gelu);
+
 TEST_CPU_KERNEL(LSTMCtHt);
 TEST_CPU_KERNEL(LSTMC1H1);
 
@@ -1472,3 +1598,23 @@ TEST_CPU_KERNEL(Adam);
 TEST_CPU_KERNEL(AdamW);
 TEST_CPU_KERNEL(Sgd);
 TEST_CPU_KERNEL(VBroadcast);
+
+#define TEST_CPU_HALF_KERNEL(kernel_type)                                  \
+  TEST(JITKernel_half, kernel_type) {                                      \
+    TestKernel##kernel_type<jit::kernel_type##Tuple<phi::dtype::bfloat16>, \
+                            CPUPlace>();                                   \
+    TestKernel##kernel_type<jit::kernel_type##Tuple<phi::dtype::float16>,  \
+                            CPUPlace>();                                   \
+  }
+
+TEST_CPU_HALF_KERNEL(VMul);
+TEST_CPU_HALF_KERNEL(VAdd);
+TEST_CPU_HALF_KERNEL(VAddRelu);
+TEST_CPU_HALF_KERNEL(VSub);
+TEST_CPU_HALF_KERNEL(VRelu);
+TEST_CPU_HALF_KERNEL(VExp);
+TEST_CPU_HALF_KERNEL(VSigmoid);
+TEST_CPU_HALF_KERNEL(VTanh);
+TEST_CPU_HALF_KERNEL(LayerNorm);
+TEST_CPU_HALF_KERNEL(EmbSeqPool);
+TEST_CPU_HALF_KERNEL(MatMul);
@@ -14,12 +14,31 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/funcs/softmax.h"
 
+#include "paddle/common/flags.h"
 #include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
 #include "paddle/phi/kernels/funcs/softmax_impl.h"
 
+COMMON_DECLARE_bool(use_jit_softmax_gelu);
+
 namespace phi {
 namespace funcs {
 
+bool SoftmaxRowsByJit(const float* in_data,
+                      float* out_data,
+                      int num_classes,
+                      int batch_size) {
+  if (!FLAGS_use_jit_softmax_gelu) {
+    return false;
+  }
+  // one pass of the jit kernel per row for the max, exp, sum and scale
+  auto softmax = phi::jit::KernelFuncs<phi::jit::SoftmaxTuple<float>,
+                                       phi::CPUPlace>::Cache()
+                     .At(num_classes);
+  softmax(in_data, out_data, num_classes, batch_size);
+  return true;
+}
+
 template class SoftmaxFunctor<phi::CPUContext, float>;
 template class SoftmaxFunctor<phi::CPUContext, double>;
 template class SoftmaxGradFunctor<phi::CPUContext, float>;
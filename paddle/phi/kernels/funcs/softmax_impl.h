@@ -226,6 +226,23 @@ void SoftmaxFunctor<DeviceContext, T, Enable>::operator()(
   SoftmaxEigen<DeviceContext, T>()(context, axis_dim, X, Y);
 }
 
+// Computes the softmax of batch_size rows of num_classes by the jit kernel
+// and returns true when FLAGS_use_jit_softmax_gelu is set. Only float has a
+// jit kernel, defined in softmax.cc, so the jit headers stay out of the GPU
+// sources that include this file.
+template <typename T>
+inline bool SoftmaxRowsByJit(const T* in_data UNUSED,
+                             T* out_data UNUSED,
+                             int num_classes UNUSED,
+                             int batch_size UNUSED) {
+  return false;
+}
+
+bool SoftmaxRowsByJit(const float* in_data,
+                      float* out_data,
+                      int num_classes,
+                      int batch_size);
+
 template <class DeviceContext>
 using enable_if_CPU = typename std::enable_if<
     std::is_same<DeviceContext, phi::CPUContext>::value>::type;
@@ -249,6 +266,9 @@ class SoftmaxFunctor<DeviceContext, T, enable_if_CPU<DeviceContext>> {
         phi::backends::cpu::MayIUse(phi::backends::cpu::avx)) {
       const T* in_data = X->data<T>();
       T* out_data = Y->data<T>();
+      if (SoftmaxRowsByJit(in_data, out_data, num_classes, batch_size)) {
+        return;
+      }
       for (int bs = 0; bs < batch_size; ++bs) {
         T max_val = *std::max_element(in_data, in_data + num_classes);
         max_val *= static_cast<T>(-1);
@@ -0,0 +1,639 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/visit_type.h"
+
+namespace phi {
+namespace funcs {
+namespace sparse {
+namespace detail {
+
+// Below this number of multiply-adds a sparse op runs on the calling thread.
+constexpr int64_t kSparseMinParallelWork = 1 << 15;
+// The rows are split into more partitions than threads, so that the dynamic
+// schedule can still balance the partitions whose rows are slower.
+constexpr int kSparsePartitionsPerThread = 4;
+
+inline int64_t GetBatchSize(const DDim& dims) {
+  int64_t batch_size = 1;
+  for (int i = 0; i < dims.size() - 2; ++i) {
+    batch_size *= dims[i];
+  }
+  return batch_size;
+}
+
+/*
+ * The CSR matrices of a batch with their rows stacked, batch b holds the
+ * stacked rows [b * rows, (b + 1) * rows), and the non zeros of the stacked
+ * row r are [offsets[r], offsets[r + 1]). The indices and values point to
+ * the tensor if it is already in this layout, and to the buffers otherwise.
+ */
+template <typename T, typename IntT>
+struct CpuCsrMatrix {
+  CpuCsrMatrix() = default;
+  CpuCsrMatrix(const CpuCsrMatrix&) = delete;
+  CpuCsrMatrix& operator=(const CpuCsrMatrix&) = delete;
+
+  int64_t nnz() const { return offsets.back(); }
+
+  int64_t batch_size = 1;
+  int64_t rows = 0;
+  int64_t cols = 0;
+  std::vector<int64_t> offsets;
+  const IntT* col_index = nullptr;
+  const T* values = nullptr;
+
+  std::vector<IntT> col_buffer;
+  std::vector<T> value_buffer;
+};
+
+template <typename T, typename IntT>
+void MakeCpuCsrMatrix(const SparseCsrTensor& x, CpuCsrMatrix<T, IntT>* mat) {
+  const DDim& dims = x.dims();
+  PADDLE_ENFORCE_GE(
+      dims.size(),
+      2,
+      phi::errors::InvalidArgument("the dim size of SparseCsrTensor must be "
+                                   "greater than or equal to 2."));
+  mat->batch_size = GetBatchSize(dims);
+  mat->rows = dims[dims.size() - 2];
+  mat->cols = dims[dims.size() - 1];
+  PADDLE_ENFORCE_EQ(x.crows().numel(),
+                    mat->batch_size * (mat->rows + 1),
+                    phi::errors::PreconditionNotMet(
+                        "the length of SparseCsrTensor crows is not right."));
+
+  // the crows of every batch start from 0
+  const IntT* crows = x.crows().data<IntT>();
+  mat->offsets.resize(mat->batch_size * mat->rows + 1);
+  int64_t batch_offset = 0;
+  for (int64_t b = 0; b < mat->batch_size; ++b) {
+    const IntT* batch_crows = crows + b * (mat->rows + 1);
+    for (int64_t i = 0; i < mat->rows; ++i) {
+      mat->offsets[b * mat->rows + i] = batch_offset + batch_crows[i];
+    }
+    batch_offset += batch_crows[mat->rows];
+  }
+  mat->offsets.back() = batch_offset;
+  PADDLE_ENFORCE_EQ(batch_offset,
+                    x.nnz(),
+                    phi::errors::PreconditionNotMet(
+                        "the crows of SparseCsrTensor do not match its nnz."));
+  mat->col_index = x.cols().data<IntT>();
+  mat->values = x.values().data<T>();
+}
+
+template <typename T, typename IntT>
+void MakeCpuCsrMatrix(const SparseCooTensor& x, CpuCsrMatrix<T, IntT>* mat) {
+  const DDim& dims = x.dims();
+  const int ndims = dims.size();
+  PADDLE_ENFORCE_GE(
+      ndims,
+      2,
+      phi::errors::InvalidArgument("the dim size of SparseCooTensor must be "
+                                   "greater than or equal to 2."));
+  PADDLE_ENFORCE_EQ(x.sparse_dim(),
+                    ndims,
+                    phi::errors::InvalidArgument(
+                        "the sparse dim of SparseCooTensor must be equal to "
+                        "its dim size, but received %d and %d.",
+                        x.sparse_dim(),
+                        ndims));
+  mat->batch_size = GetBatchSize(dims);
+  mat->rows = dims[ndims - 2];
+  mat->cols = dims[ndims - 1];
+
+  // counting sort the non zeros by their stacked rows, which keeps the order
+  // of a coalesced tensor and does not require the tensor to be coalesced
+  const int64_t nnz = x.nnz();
+  const IntT* indices = x.indices().data<IntT>();
+  const T* values = x.values().data<T>();
+  std::vector<int64_t> stacked_rows(nnz);
+  mat->offsets.assign(mat->batch_size * mat->rows + 1, 0);
+  for (int64_t i = 0; i < nnz; ++i) {
+    int64_t batch = 0;
+    for (int d = 0; d < ndims - 2; ++d) {
+      batch = batch * dims[d] + indices[d * nnz + i];
+    }
+    stacked_rows[i] = batch * mat->rows + indices[(ndims - 2) * nnz + i];
+    ++mat->offsets[stacked_rows[i] + 1];
+  }
+  for (size_t r = 1; r < mat->offsets.size(); ++r) {
+    mat->offsets[r] += mat->offsets[r - 1];
+  }
+  std::vector<int64_t> next(mat->offsets.begin(), mat->offsets.end() - 1);
+  mat->col_buffer.resize(nnz);
+  mat->value_buffer.resize(nnz);
+  const IntT* cols = indices + (ndims - 1) * nnz;
+  for (int64_t i = 0; i < nnz; ++i) {
+    int64_t pos = next[stacked_rows[i]]++;
+    mat->col_buffer[pos] = cols[i];
+    mat->value_buffer[pos] = values[i];
+  }
+  mat->col_index = mat->col_buffer.data();
+  mat->values = mat->value_buffer.data();
+}
+
+// Transpose every matrix of the batch, that is, convert it to CSC.
+template <typename T, typename IntT>
+void TransposeCpuCsrMatrix(const CpuCsrMatrix<T, IntT>& x,
+                           CpuCsrMatrix<T, IntT>* out) {
+  out->batch_size = x.batch_size;
+  out->rows = x.cols;
+  out->cols = x.rows;
+  out->offsets.assign(out->batch_size * out->rows + 1, 0);
+  for (int64_t r = 0; r < x.batch_size * x.rows; ++r) {
+    int64_t batch_row = r / x.rows * out->rows;
+    for (int64_t k = x.offsets[r]; k < x.offsets[r + 1]; ++k) {
+      ++out->offsets[batch_row + x.col_index[k] + 1];
+    }
+  }
+  for (size_t r = 1; r < out->offsets.size(); ++r) {
+    out->offsets[r] += out->offsets[r - 1];
+  }
+  std::vector<int64_t> next(out->offsets.begin(), out->offsets.end() - 1);
+  out->col_buffer.resize(x.nnz());
+  out->value_buffer.resize(x.nnz());
+  for (int64_t r = 0; r < x.batch_size * x.rows; ++r) {
+    int64_t batch_row = r / x.rows * out->rows;
+    for (int64_t k = x.offsets[r]; k < x.offsets[r + 1]; ++k) {
+      int64_t pos = next[batch_row + x.col_index[k]]++;
+      out->col_buffer[pos] = static_cast<IntT>(r % x.rows);
+      out->value_buffer[pos] = x.values[k];
+    }
+  }
+  out->col_index = out->col_buffer.data();
+  out->values = out->value_buffer.data();
+}
+
+/*
+ * Split the rows into num_parts ranges of about the same cost, where a row
+ * costs its non zeros plus one. Partitioning by cost instead of by row count
+ * keeps a few long rows of a skewed matrix from serializing the op on one
+ * thread. Returns the num_parts + 1 bounds of the ranges.
+ */
+inline std::vector<int64_t> PartitionRowsByNnz(
+    const std::vector<int64_t>& offsets, int num_parts) {
+  const int64_t num_rows = static_cast<int64_t>(offsets.size()) - 1;
+  const int64_t total_cost = offsets[num_rows] + num_rows;
+  std::vector<int64_t> bounds(num_parts + 1, num_rows);
+  bounds[0] = 0;
+  for (int p = 1; p < num_parts; ++p) {
+    int64_t target = total_cost * p / num_parts;
+    // the first row whose cost before it reaches the target
+    int64_t lo = bounds[p - 1];
+    int64_t hi = num_rows;
+    while (lo < hi) {
+      int64_t mid = lo + (hi - lo) / 2;
+      if (offsets[mid] + mid < target) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    bounds[p] = lo;
+  }
+  return bounds;
+}
+
+// Calls func(row_begin, row_end) on the partitions of the rows, in parallel
+// when the ops are enough to pay for the threads. work_per_nnz is the
+// multiply-adds of one non zero.
+template <typename Func>
+void ForEachRowPartition(const std::vector<int64_t>& offsets,
+                         int64_t work_per_nnz,
+                         Func func) {
+  const int64_t num_rows = static_cast<int64_t>(offsets.size()) - 1;
+  int num_threads = 1;
+#ifdef PADDLE_WITH_MKLML
+  if ((offsets.back() + num_rows) * std::max<int64_t>(work_per_nnz, 1) >=
+      kSparseMinParallelWork) {
+    num_threads = omp_get_max_threads();
+  }
+#endif
+  if (num_threads <= 1 || num_rows <= 1) {
+    func(0, num_rows);
+    return;
+  }
+  const int num_parts = num_threads * kSparsePartitionsPerThread;
+  std::vector<int64_t> bounds = PartitionRowsByNnz(offsets, num_parts);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads)
+#endif
+  for (int p = 0; p < num_parts; ++p) {
+    if (bounds[p] < bounds[p + 1]) {
+      func(bounds[p], bounds[p + 1]);
+    }
+  }
+}
+
+template <typename T>
+inline void ScaleRow(int64_t n, T beta, T* y) {
+  if (beta == static_cast<T>(0)) {
+    // as BLAS, y is not read when beta is 0, it may be uninitialized
+    std::fill(y, y + n, static_cast<T>(0));
+  } else if (beta != static_cast<T>(1)) {
+    for (int64_t i = 0; i < n; ++i) {
+      y[i] *= beta;
+    }
+  }
+}
+
+template <typename T>
+inline void AxpyRow(int64_t n, T alpha, const T* x, T* y) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp simd
+#endif
+  for (int64_t i = 0; i < n; ++i) {
+    y[i] += alpha * x[i];
+  }
+}
+
+template <typename T>
+inline T DotRow(int64_t n, const T* x, const T* y) {
+  T sum = static_cast<T>(0);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp simd reduction(+ : sum)
+#endif
+  for (int64_t i = 0; i < n; ++i) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+
+// Transpose the last two dims of a batch of row major [rows, cols] matrices.
+template <typename T>
+void TransposeBatch(
+    const T* x, int64_t batch_size, int64_t rows, int64_t cols, T* out) {
+  constexpr int64_t kBlock = 32;
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const T* x_batch = x + b * rows * cols;
+    T* out_batch = out + b * rows * cols;
+    for (int64_t i0 = 0; i0 < rows; i0 += kBlock) {
+      for (int64_t j0 = 0; j0 < cols; j0 += kBlock) {
+        int64_t i_end = std::min(i0 + kBlock, rows);
+        int64_t j_end = std::min(j0 + kBlock, cols);
+        for (int64_t i = i0; i < i_end; ++i) {
+          for (int64_t j = j0; j < j_end; ++j) {
+            out_batch[j * rows + i] = x_batch[i * cols + j];
+          }
+        }
+      }
+    }
+  }
+}
+
+inline DataType GetIndexType(const SparseCsrTensor& x) {
+  return x.crows().dtype();
+}
+
+inline DataType GetIndexType(const SparseCooTensor& x) {
+  return x.indices().dtype();
+}
+
+template <typename T, typename IntT, typename TensorType>
+void CpuSpmm(bool transa,
+             bool transb,
+             T alpha,
+             const TensorType& mat_a,
+             const phi::DenseTensor& mat_b,
+             T beta,
+             phi::DenseTensor* mat_out) {
+  CpuCsrMatrix<T, IntT> a;
+  CpuCsrMatrix<T, IntT> a_trans;
+  MakeCpuCsrMatrix(mat_a, &a);
+  const CpuCsrMatrix<T, IntT>* lhs = &a;
+  if (transa) {
+    TransposeCpuCsrMatrix(a, &a_trans);
+    lhs = &a_trans;
+  }
+  const int64_t m = lhs->rows;
+  const int64_t k = lhs->cols;
+  const int64_t n = mat_out->dims()[mat_out->dims().size() - 1];
+  PADDLE_ENFORCE_EQ(mat_b.numel(),
+                    lhs->batch_size * k * n,
+                    phi::errors::PreconditionNotMet(
+                        "The shape of the dense matrix [%s] does not match the "
+                        "sparse matrix [%s] in SPMM.",
+                        mat_b.dims(),
+                        mat_a.dims()));
+  PADDLE_ENFORCE_EQ(mat_out->numel(),
+                    lhs->batch_size * m * n,
+                    phi::errors::PreconditionNotMet(
+                        "The shape of the output [%s] does not match the "
+                        "sparse matrix [%s] in SPMM.",
+                        mat_out->dims(),
+                        mat_a.dims()));
+
+  const T* b_data = mat_b.data<T>();
+  std::vector<T> b_trans;
+  if (transb) {
+    b_trans.resize(mat_b.numel());
+    TransposeBatch(b_data, lhs->batch_size, n, k, b_trans.data());
+    b_data = b_trans.data();
+  }
+  T* out_data = mat_out->data<T>();
+  ForEachRowPartition(lhs->offsets, n, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; ++r) {
+      T* out_row = out_data + r * n;
+      const T* b_batch = b_data + r / m * k * n;
+      ScaleRow(n, beta, out_row);
+      for (int64_t i = lhs->offsets[r]; i < lhs->offsets[r + 1]; ++i) {
+        AxpyRow(n,
+                alpha * lhs->values[i],
+                b_batch + static_cast<int64_t>(lhs->col_index[i]) * n,
+                out_row);
+      }
+    }
+  });
+}
+
+template <typename T, typename IntT, typename TensorType>
+void CpuSpmv(bool transa,
+             T alpha,
+             const TensorType& mat_a,
+             const phi::DenseTensor& vec_x,
+             T beta,
+             phi::DenseTensor* vec_out) {
+  CpuCsrMatrix<T, IntT> a;
+  CpuCsrMatrix<T, IntT> a_trans;
+  MakeCpuCsrMatrix(mat_a, &a);
+  const CpuCsrMatrix<T, IntT>* lhs = &a;
+  if (transa) {
+    TransposeCpuCsrMatrix(a, &a_trans);
+    lhs = &a_trans;
+  }
+  const int64_t m = lhs->rows;
+  const int64_t k = lhs->cols;
+  PADDLE_ENFORCE_EQ(vec_x.numel(),
+                    lhs->batch_size * k,
+                    phi::errors::PreconditionNotMet(
+                        "The shape of the vector [%s] does not match the "
+                        "sparse matrix [%s] in SPMV.",
+                        vec_x.dims(),
+                        mat_a.dims()));
+  PADDLE_ENFORCE_EQ(vec_out->numel(),
+                    lhs->batch_size * m,
+                    phi::errors::PreconditionNotMet(
+                        "The shape of the output [%s] does not match the "
+                        "sparse matrix [%s] in SPMV.",
+                        vec_out->dims(),
+                        mat_a.dims()));
+
+  const T* x_data = vec_x.data<T>();
+  T* out_data = vec_out->data<T>();
+  ForEachRowPartition(lhs->offsets, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; ++r) {
+      const T* x_batch = x_data + r / m * k;
+      T sum = static_cast<T>(0);
+      for (int64_t i = lhs->offsets[r]; i < lhs->offsets[r + 1]; ++i) {
+        sum += lhs->values[i] * x_batch[lhs->col_index[i]];
+      }
+      out_data[r] = beta == static_cast<T>(0)
+                        ? alpha * sum
+                        : alpha * sum + beta * out_data[r];
+    }
+  });
+}
+
+/*
+ * Prepare the dense inputs of SDDMM as row major op(A) [batch, m, k] and
+ * op(B)' [batch, n, k], so that every output is the dot of two rows.
+ */
+template <typename T>
+void PrepareSddmmInputs(bool transa,
+                        bool transb,
+                        const phi::DenseTensor& mat_a,
+                        const phi::DenseTensor& mat_b,
+                        int64_t batch_size,
+                        int64_t m,
+                        int64_t n,
+                        int64_t* k,
+                        const T** a_data,
+                        const T** b_data,
+                        std::vector<T>* a_trans,
+                        std::vector<T>* b_trans) {
+  *k = mat_a.numel() / std::max<int64_t>(batch_size * m, 1);
+  PADDLE_ENFORCE_EQ(mat_a.numel(),
+                    batch_size * m * (*k),
+                    phi::errors::PreconditionNotMet(
+                        "The shape of the dense matrix [%s] does not match the "
+                        "output in SDDMM.",
+                        mat_a.dims()));
+  PADDLE_ENFORCE_EQ(mat_b.numel(),
+                    batch_size * (*k) * n,
+                    phi::errors::PreconditionNotMet(
+                        "The shape of the dense matrix [%s] does not match the "
+                        "output in SDDMM.",
+                        mat_b.dims()));
+  *a_data = mat_a.data<T>();
+  if (transa) {
+    a_trans->resize(mat_a.numel());
+    TransposeBatch(*a_data, batch_size, *k, m, a_trans->data());
+    *a_data = a_trans->data();
+  }
+  *b_data = mat_b.data<T>();
+  if (!transb) {
+    b_trans->resize(mat_b.numel());
+    TransposeBatch(*b_data, batch_size, *k, n, b_trans->data());
+    *b_data = b_trans->data();
+  }
+}
+
+template <typename T, typename IntT>
+void CpuSddmm(bool transa,
+              bool transb,
+              T alpha,
+              const phi::DenseTensor& mat_a,
+              const phi::DenseTensor& mat_b,
+              T beta,
+              SparseCsrTensor* mat_out) {
+  CpuCsrMatrix<T, IntT> mask;
+  MakeCpuCsrMatrix(*mat_out, &mask);
+  const int64_t m = mask.rows;
+  const int64_t n = mask.cols;
+  int64_t k = 0;
+  const T* a_data = nullptr;
+  const T* b_data = nullptr;
+  std::vector<T> a_trans, b_trans;
+  PrepareSddmmInputs(transa,
+                     transb,
+                     mat_a,
+                     mat_b,
+                     mask.batch_size,
+                     m,
+                     n,
+                     &k,
+                     &a_data,
+                     &b_data,
+                     &a_trans,
+                     &b_trans);
+
+  // the non zeros of CSR are in the order of the tensor
+  T* out_values = mat_out->mutable_values()->data<T>();
+  ForEachRowPartition(mask.offsets, k, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; ++r) {
+      const T* a_row = a_data + r * k;
+      const T* b_batch = b_data + r / m * n * k;
+      for (int64_t i = mask.offsets[r]; i < mask.offsets[r + 1]; ++i) {
+        T dot = DotRow(
+            k, a_row, b_batch + static_cast<int64_t>(mask.col_index[i]) * k);
+        out_values[i] = beta == static_cast<T>(0)
+                            ? alpha * dot
+                            : alpha * dot + beta * out_values[i];
+      }
+    }
+  });
+}
+
+template <typename T, typename IntT>
+void CpuSddmm(bool transa,
+              bool transb,
+              T alpha,
+              const phi::DenseTensor& mat_a,
+              const phi::DenseTensor& mat_b,
+              T beta,
+              SparseCooTensor* mat_out) {
+  const DDim& dims = mat_out->dims();
+  const int ndims = dims.size();
+  PADDLE_ENFORCE_EQ(mat_out->sparse_dim(),
+                    ndims,
+                    phi::errors::InvalidArgument(
+                        "the sparse dim of SparseCooTensor must be equal to "
+                        "its dim size, but received %d and %d.",
+                        mat_out->sparse_dim(),
+                        ndims));
+  const int64_t batch_size = GetBatchSize(dims);
+  const int64_t m = dims[ndims - 2];
+  const int64_t n = dims[ndims - 1];
+  int64_t k = 0;
+  const T* a_data = nullptr;
+  const T* b_data = nullptr;
+  std::vector<T> a_trans, b_trans;
+  PrepareSddmmInputs(transa,
+                     transb,
+                     mat_a,
+                     mat_b,
+                     batch_size,
+                     m,
+                     n,
+                     &k,
+                     &a_data,
+                     &b_data,
+                     &a_trans,
+                     &b_trans);
+
+  // every non zero is computed alone, so the order of the indices is free
+  const int64_t nnz = mat_out->nnz();
+  const IntT* indices = mat_out->indices().data<IntT>();
+  T* out_values = mat_out->mutable_values()->data<T>();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (nnz * k >= kSparseMinParallelWork)
+#endif
+  for (int64_t i = 0; i < nnz; ++i) {
+    int64_t batch = 0;
+    for (int d = 0; d < ndims - 2; ++d) {
+      batch = batch * dims[d] + indices[d * nnz + i];
+    }
+    int64_t row = indices[(ndims - 2) * nnz + i];
+    int64_t col = indices[(ndims - 1) * nnz + i];
+    T dot = DotRow(k,
+                   a_data + (batch * m + row) * k,
+                   b_data + (batch * n + col) * k);
+    out_values[i] = beta == static_cast<T>(0)
+                        ? alpha * dot
+                        : alpha * dot + beta * out_values[i];
+  }
+}
+
+}  // namespace detail
+
+/************* SPARSE*DENSE->DENSE MATMUL ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMM(bool transa,
+                                       bool transb,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& mat_b,
+                                       T beta,
+                                       phi::DenseTensor* mat_out) const {
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      detail::GetIndexType(mat_a), "SparseBlas<CPUContext>::SPMM", ([&] {
+        detail::CpuSpmm<T, data_t>(
+            transa, transb, alpha, mat_a, mat_b, beta, mat_out);
+      }));
+}
+
+/************* SPARSE*DENSE->DENSE MV ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMV(bool transa,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& vec_x,
+                                       T beta,
+                                       phi::DenseTensor* vec_out) const {
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      detail::GetIndexType(mat_a), "SparseBlas<CPUContext>::SPMV", ([&] {
+        detail::CpuSpmv<T, data_t>(transa, alpha, mat_a, vec_x, beta, vec_out);
+      }));
+}
+
+/************* DENSE*DENSE->SPARSE MATMUL ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SDDMM(bool transa,
+                                        bool transb,
+                                        T alpha,
+                                        const phi::DenseTensor& mat_a,
+                                        const phi::DenseTensor& mat_b,
+                                        T beta,
+                                        TensorType* mat_out) const {
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      detail::GetIndexType(*mat_out), "SparseBlas<CPUContext>::SDDMM", ([&] {
+        detail::CpuSddmm<T, data_t>(
+            transa, transb, alpha, mat_a, mat_b, beta, mat_out);
+      }));
+}
+
+/************* SPARSE*SPARSE->SPARSE MATMUL ************/
+template <>
+template <typename T>
+void SparseBlas<phi::CPUContext>::SPGEMM(
+    bool transa UNUSED,
+    bool transb UNUSED,
+    T alpha UNUSED,
+    const SparseCsrTensor& mat_a UNUSED,
+    const SparseCsrTensor& mat_b UNUSED,
+    T beta UNUSED,
+    SparseCsrTensor* mat_out UNUSED) const {
+  PADDLE_THROW(phi::errors::Unimplemented(
+      "SPGEMM of SparseCsrTensor is not supported on CPU now."));
+}
+
+}  // namespace sparse
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,452 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+namespace phi {
+namespace fusion {
+
+// The attention of block_multihead_attention on CPU. As the GPU kernel, a
+// step takes the tokens of the sequences in the batch, unpadded to
+// [token_num, 3, num_head, dim_head]: a sequence of seq_lens_encoder > 0
+// is prefilled, a sequence of seq_lens_decoder > 0 decodes a token, so that
+// the sequences of any length are batched together.
+//
+// The cache is paged: the k and v of the position pos of the sequence bi
+// are the row pos % block_size of the page block_tables[bi][pos /
+// block_size] of key_cache and value_cache, [max_block_num, num_head,
+// block_size, dim_head]. The pages are given to the sequences by the
+// caller, so that the memory of the cache follows the actual lengths.
+//
+// The k and v of the step are written to the pages first, then the queries
+// of a head attend to them page by page with an online softmax. The
+// queries of a prefill are taken in tiles of kBlhaQueryTile rows, each page
+// is converted to float once per tile and stays in the cache while the
+// rows of the tile read it.
+constexpr int kBlhaQueryTile = 16;
+
+struct BlhaSeqInfo {
+  bool is_prefill;
+  int token_start;  // the index in qkv of the first token of the step
+  int q_len;        // the tokens of the step
+  int start_pos;    // the position of the first token of the step
+};
+
+template <typename T>
+inline void BlhaRotaryPair(T* left, T* right, float cos_v, float sin_v) {
+  float l = static_cast<float>(*left);
+  float r = static_cast<float>(*right);
+  *left = static_cast<T>(l * cos_v - r * sin_v);
+  *right = static_cast<T>(r * cos_v + l * sin_v);
+}
+
+// Applies the rotary embedding to the head vec at pos. The prefill reads
+// the cos and sin of rope_emb [2, 1, rope_len, 1, dim_head / 2], or
+// [2, 1, rope_len, 1, dim_head] for the neox style, the decoding of the
+// non-neox style computes them as the GPU kernel does.
+template <typename T>
+void BlhaApplyRotary(const float* rope_emb,
+                     int64_t rope_len,
+                     int pos,
+                     int dim_head,
+                     bool use_neox_style,
+                     bool is_prefill,
+                     T* vec) {
+  int half = dim_head / 2;
+  if (use_neox_style) {
+    const float* cos_emb = rope_emb + pos * dim_head;
+    const float* sin_emb = rope_emb + rope_len * dim_head + pos * dim_head;
+    for (int i = 0; i < half; ++i) {
+      BlhaRotaryPair(&vec[i], &vec[i + half], cos_emb[i], sin_emb[i]);
+    }
+    return;
+  }
+  for (int i = 0; i < half; ++i) {
+    float cos_v, sin_v;
+    if (is_prefill) {
+      cos_v = rope_emb[pos * half + i];
+      sin_v = rope_emb[rope_len * half + pos * half + i];
+    } else {
+      float inv_freq = pos / std::pow(10000.0f, 2.0f * i / dim_head);
+      cos_v = std::cos(inv_freq);
+      sin_v = std::sin(inv_freq);
+    }
+    BlhaRotaryPair(&vec[2 * i], &vec[2 * i + 1], cos_v, sin_v);
+  }
+}
+
+// The rows of a query tile of a head, q pre-scaled by 1 / sqrt(dim_head).
+// The row r attends to the positions [0, kv_end[r]) with the additive mask
+// mask[r] of the positions, if given.
+template <typename T>
+void BlhaAttendTile(const T* k_cache,
+                    const T* v_cache,
+                    const int* block_table,
+                    int hi,
+                    int num_head,
+                    int block_size,
+                    int dim_head,
+                    int rows,
+                    const float* q,
+                    const int* kv_end,
+                    const T* const* mask,
+                    float* out) {
+  int max_end = *std::max_element(kv_end, kv_end + rows);
+  std::vector<float> k_page(static_cast<size_t>(block_size) * dim_head);
+  std::vector<float> v_page(k_page.size());
+  std::vector<float> score(block_size);
+  std::vector<float> row_max(rows, -FLT_MAX);
+  std::vector<float> row_sum(rows, 0.0f);
+  std::fill(out, out + rows * dim_head, 0.0f);
+
+  for (int page_start = 0; page_start < max_end; page_start += block_size) {
+    int page_len = std::min(block_size, max_end - page_start);
+    int64_t page_offset =
+        (static_cast<int64_t>(block_table[page_start / block_size]) *
+             num_head +
+         hi) *
+        block_size * dim_head;
+    for (int i = 0; i < page_len * dim_head; ++i) {
+      k_page[i] = static_cast<float>(k_cache[page_offset + i]);
+      v_page[i] = static_cast<float>(v_cache[page_offset + i]);
+    }
+    for (int r = 0; r < rows; ++r) {
+      int len = std::min(page_len, kv_end[r] - page_start);
+      if (len <= 0) {
+        continue;
+      }
+      const float* q_row = q + r * dim_head;
+      float page_max = -FLT_MAX;
+      for (int j = 0; j < len; ++j) {
+        const float* k_row = k_page.data() + j * dim_head;
+        float s = 0;
+        for (int d = 0; d < dim_head; ++d) {
+          s += q_row[d] * k_row[d];
+        }
+        if (mask) {
+          s += static_cast<float>(mask[r][page_start + j]);
+        }
+        score[j] = s;
+        page_max = std::max(page_max, s);
+      }
+      // rescale what the row has summed to the new max
+      float new_max = std::max(row_max[r], page_max);
+      float rescale = std::exp(row_max[r] - new_max);
+      row_max[r] = new_max;
+      float* out_row = out + r * dim_head;
+      row_sum[r] *= rescale;
+      for (int d = 0; d < dim_head; ++d) {
+        out_row[d] *= rescale;
+      }
+      for (int j = 0; j < len; ++j) {
+        float p = std::exp(score[j] - new_max);
+        row_sum[r] += p;
+        const float* v_row = v_page.data() + j * dim_head;
+        for (int d = 0; d < dim_head; ++d) {
+          out_row[d] += p * v_row[d];
+        }
+      }
+    }
+  }
+  for (int r = 0; r < rows; ++r) {
+    float inv_sum = row_sum[r] > 0 ? 1.0f / row_sum[r] : 0.0f;
+    for (int d = 0; d < dim_head; ++d) {
+      out[r * dim_head + d] *= inv_sum;
+    }
+  }
+}
+
+template <typename T, typename Context>
+void BlockMultiheadAttentionKernel(
+    const Context& dev_ctx,
+    const DenseTensor& qkv,
+    const DenseTensor& key_cache,
+    const DenseTensor& value_cache,
+    const DenseTensor& seq_lens_encoder,
+    const DenseTensor& seq_lens_decoder,
+    const DenseTensor& seq_lens_this_time,
+    const DenseTensor& padding_offsets,
+    const DenseTensor& cum_offsets,
+    const DenseTensor& cu_seqlens_q,
+    const DenseTensor& cu_seqlens_k,
+    const DenseTensor& block_tables,
+    const paddle::optional<DenseTensor>& pre_key_cache,
+    const paddle::optional<DenseTensor>& pre_value_cache,
+    const paddle::optional<DenseTensor>& rope_emb,
+    const paddle::optional<DenseTensor>& mask,
+    const paddle::optional<DenseTensor>& tgt_mask,
+    const paddle::optional<DenseTensor>& cache_k_quant_scales,
+    const paddle::optional<DenseTensor>& cache_v_quant_scales,
+    const paddle::optional<DenseTensor>& cache_k_dequant_scales,
+    const paddle::optional<DenseTensor>& cache_v_dequant_scales,
+    const paddle::optional<DenseTensor>& qkv_out_scale,
+    const paddle::optional<DenseTensor>& qkv_bias,
+    const paddle::optional<DenseTensor>& out_shift,
+    const paddle::optional<DenseTensor>& out_smooth,
+    int max_seq_len,
+    int block_size,
+    bool use_neox_style,
+    const bool dynamic_cachekv_quant,
+    const int quant_round_type,
+    const float quant_max_bound,
+    const float quant_min_bound,
+    const float out_scale,
+    const std::string& compute_dtype,
+    DenseTensor* fmha_out,
+    DenseTensor* qkv_out,
+    DenseTensor* key_cache_out,
+    DenseTensor* value_cache_out) {
+  PADDLE_ENFORCE_EQ(
+      pre_key_cache.get_ptr() == nullptr &&
+          cache_k_quant_scales.get_ptr() == nullptr &&
+          qkv_out_scale.get_ptr() == nullptr,
+      true,
+      phi::errors::Unimplemented(
+          "The CPU kernel of block_multihead_attention does not support "
+          "pre_key_cache, the int8 cache and the dequantization of "
+          "qkv_out_scale."));
+
+  const int token_num = qkv.dims()[0];
+  const int num_head = key_cache.dims()[1];
+  const int dim_head = key_cache.dims()[3];
+  const int bsz = cum_offsets.dims()[0];
+  const int max_block_per_seq = block_tables.dims()[1];
+  const int64_t hidden = static_cast<int64_t>(num_head) * dim_head;
+  const float inv_sqrt_dh = 1.0f / std::sqrt(static_cast<float>(dim_head));
+
+  T* qkv_data = dev_ctx.template Alloc<T>(qkv_out);
+  if (qkv_data != qkv.data<T>()) {
+    std::memcpy(qkv_data, qkv.data<T>(), qkv.numel() * sizeof(T));
+  }
+  T* k_cache = dev_ctx.template Alloc<T>(key_cache_out);
+  if (k_cache != key_cache.data<T>()) {
+    std::memcpy(k_cache, key_cache.data<T>(), key_cache.numel() * sizeof(T));
+  }
+  T* v_cache = dev_ctx.template Alloc<T>(value_cache_out);
+  if (v_cache != value_cache.data<T>()) {
+    std::memcpy(
+        v_cache, value_cache.data<T>(), value_cache.numel() * sizeof(T));
+  }
+  T* out_data = nullptr;
+  int8_t* quant_out_data = nullptr;
+  if (out_scale > 0) {
+    quant_out_data = dev_ctx.template Alloc<int8_t>(fmha_out);
+    std::memset(quant_out_data, 0, fmha_out->numel());
+  } else {
+    out_data = dev_ctx.template Alloc<T>(fmha_out);
+    std::fill(out_data, out_data + fmha_out->numel(), static_cast<T>(0));
+  }
+
+  const int* enc_lens = seq_lens_encoder.data<int>();
+  const int* dec_lens = seq_lens_decoder.data<int>();
+  const int* this_time_lens = seq_lens_this_time.data<int>();
+  const int* padding_offsets_data = padding_offsets.data<int>();
+  const int* cum_offsets_data = cum_offsets.data<int>();
+  const int* block_tables_data = block_tables.data<int>();
+  const float* rope_data = rope_emb ? rope_emb->data<float>() : nullptr;
+  int64_t rope_len = rope_emb ? rope_emb->dims()[2] : 0;
+
+  std::vector<BlhaSeqInfo> seqs(bsz);
+  for (int bi = 0; bi < bsz; ++bi) {
+    BlhaSeqInfo& seq = seqs[bi];
+    seq.is_prefill = enc_lens[bi] > 0;
+    seq.token_start = bi * max_seq_len - cum_offsets_data[bi];
+    seq.start_pos = seq.is_prefill ? 0 : dec_lens[bi];
+    seq.q_len = seq.is_prefill || dec_lens[bi] > 0 ? this_time_lens[bi] : 0;
+  }
+
+  // 1. the bias, the rotary embedding and the k and v of the step to the
+  // pages, as the GPU kernel the qkv_out of the prefill holds the rotated
+  // q and k
+  std::vector<float> q_buf(static_cast<size_t>(token_num) * hidden);
+  const T* bias_data = qkv_bias ? qkv_bias->data<T>() : nullptr;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int ti = 0; ti < token_num; ++ti) {
+    T* token = qkv_data + ti * 3 * hidden;
+    if (bias_data) {
+      for (int64_t c = 0; c < 3 * hidden; ++c) {
+        token[c] = static_cast<T>(static_cast<float>(token[c]) +
+                                  static_cast<float>(bias_data[c]));
+      }
+    }
+    int ori_token = ti + padding_offsets_data[ti];
+    int bi = ori_token / max_seq_len;
+    const BlhaSeqInfo& seq = seqs[bi];
+    if (seq.q_len == 0) {
+      continue;
+    }
+    int pos = seq.is_prefill ? ori_token % max_seq_len : seq.start_pos;
+    const int* block_table = block_tables_data + bi * max_block_per_seq;
+    int64_t cache_offset =
+        (static_cast<int64_t>(block_table[pos / block_size]) * num_head *
+             block_size +
+         pos % block_size) *
+        dim_head;
+    std::vector<T> q(dim_head), k(dim_head);
+    for (int hi = 0; hi < num_head; ++hi) {
+      T* q_head = token + hi * dim_head;
+      T* k_head = token + hidden + hi * dim_head;
+      const T* v_head = token + 2 * hidden + hi * dim_head;
+      // the decoding rotates a copy, qkv_out keeps the q and k of the input
+      if (!seq.is_prefill) {
+        std::copy_n(q_head, dim_head, q.begin());
+        std::copy_n(k_head, dim_head, k.begin());
+        q_head = q.data();
+        k_head = k.data();
+      }
+      if (rope_data) {
+        BlhaApplyRotary(rope_data,
+                        rope_len,
+                        pos,
+                        dim_head,
+                        use_neox_style,
+                        seq.is_prefill,
+                        q_head);
+        BlhaApplyRotary(rope_data,
+                        rope_len,
+                        pos,
+                        dim_head,
+                        use_neox_style,
+                        seq.is_prefill,
+                        k_head);
+      }
+      int64_t head_offset = cache_offset + hi * block_size * dim_head;
+      std::copy_n(k_head, dim_head, k_cache + head_offset);
+      std::copy_n(v_head, dim_head, v_cache + head_offset);
+      float* q_out = q_buf.data() + ti * hidden + hi * dim_head;
+      for (int d = 0; d < dim_head; ++d) {
+        q_out[d] = static_cast<float>(q_head[d]) * inv_sqrt_dh;
+      }
+    }
+  }
+
+  // 2. the attention, by the tiles of the queries of a head of a sequence
+  struct Task {
+    int bi;
+    int hi;
+    int row_start;
+  };
+  std::vector<Task> tasks;
+  for (int bi = 0; bi < bsz; ++bi) {
+    for (int hi = 0; hi < num_head; ++hi) {
+      for (int r = 0; r < seqs[bi].q_len; r += kBlhaQueryTile) {
+        tasks.push_back({bi, hi, r});
+      }
+    }
+  }
+  const T* mask_data = mask ? mask->data<T>() : nullptr;
+  const T* tgt_mask_data = tgt_mask ? tgt_mask->data<T>() : nullptr;
+  const T* shift_data = out_shift ? out_shift->data<T>() : nullptr;
+  const T* smooth_data = out_smooth ? out_smooth->data<T>() : nullptr;
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (size_t task_id = 0; task_id < tasks.size(); ++task_id) {
+    const Task& task = tasks[task_id];
+    const BlhaSeqInfo& seq = seqs[task.bi];
+    int rows = std::min(kBlhaQueryTile, seq.q_len - task.row_start);
+    std::vector<float> q(static_cast<size_t>(rows) * dim_head);
+    std::vector<float> res(q.size());
+    std::vector<int> kv_end(rows);
+    std::vector<const T*> mask_rows(rows);
+    bool has_mask = false;
+    for (int r = 0; r < rows; ++r) {
+      int row = task.row_start + r;
+      int ti = seq.token_start + row;
+      std::copy_n(q_buf.data() + ti * hidden + task.hi * dim_head,
+                  dim_head,
+                  q.data() + r * dim_head);
+      // causal but for a prefill of an explicit mask, as flash attention
+      kv_end[r] = seq.start_pos + row + 1;
+      if (seq.is_prefill && mask_data) {
+        // mask [bsz, 1 or num_head, max_q_len, max_k_len]
+        const auto& dims = mask->dims();
+        int mask_hi = dims[1] == 1 ? 0 : task.hi;
+        kv_end[r] = seq.q_len;
+        mask_rows[r] =
+            mask_data +
+            ((static_cast<int64_t>(task.bi) * dims[1] + mask_hi) * dims[2] +
+             row) *
+                dims[3];
+        has_mask = true;
+      } else if (!seq.is_prefill && tgt_mask_data) {
+        // tgt_mask [bsz, 1 or num_head, 1, mask_length]
+        const auto& dims = tgt_mask->dims();
+        int mask_hi = dims[1] == 1 ? 0 : task.hi;
+        mask_rows[r] =
+            tgt_mask_data +
+            (static_cast<int64_t>(task.bi) * dims[1] + mask_hi) * dims[3];
+        has_mask = true;
+      }
+    }
+    BlhaAttendTile(k_cache,
+                   v_cache,
+                   block_tables_data + task.bi * max_block_per_seq,
+                   task.hi,
+                   num_head,
+                   block_size,
+                   dim_head,
+                   rows,
+                   q.data(),
+                   kv_end.data(),
+                   has_mask ? mask_rows.data() : nullptr,
+                   res.data());
+
+    for (int r = 0; r < rows; ++r) {
+      int64_t out_offset =
+          (seq.token_start + task.row_start + r) * hidden + task.hi * dim_head;
+      for (int d = 0; d < dim_head; ++d) {
+        float v = res[r * dim_head + d];
+        if (out_data) {
+          out_data[out_offset + d] = static_cast<T>(v);
+          continue;
+        }
+        int64_t col = task.hi * dim_head + d;
+        if (shift_data && smooth_data) {
+          v = (v + static_cast<float>(shift_data[col])) *
+              static_cast<float>(smooth_data[col]);
+        }
+        float quant_value = quant_max_bound * out_scale * v;
+        quant_value = quant_round_type == 0 ? std::rint(quant_value)
+                                            : std::round(quant_value);
+        quant_value =
+            std::min(quant_max_bound, std::max(quant_min_bound, quant_value));
+        quant_out_data[out_offset + d] = static_cast<int8_t>(quant_value);
+      }
+    }
+  }
+}
+
+}  // namespace fusion
+}  // namespace phi
+
+PD_REGISTER_KERNEL(block_multihead_attention,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::fusion::BlockMultiheadAttentionKernel,
+                   float,
+                   phi::dtype::float16,
+                   phi::dtype::bfloat16) {}
@@ -0,0 +1,186 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+namespace phi {
+namespace fusion {
+
+// Rotates the heads of a [batch_size, seq_len, num_heads, head_dim] input as
+// the GPU kernel, with the sin and cos of a position shared by the heads. The
+// positions of the batch are rotated in parallel.
+template <typename T>
+void FusedRopeCPU(const T* in,
+                  const T* sin_data,
+                  const T* cos_data,
+                  const int64_t* position_ids_data,
+                  bool use_neox_rotary_style,
+                  int64_t batch_size,
+                  int64_t seq_len,
+                  int64_t num_heads,
+                  int64_t head_dim,
+                  T* out) {
+  int64_t half = head_dim / 2;
+  // the inverse frequencies of the dims, when sin and cos are not given
+  std::vector<float> inv_freq;
+  if (!sin_data) {
+    inv_freq.resize(head_dim);
+    for (int64_t i = 0; i < head_dim; ++i) {
+      float idx = static_cast<float>(i / 2 * 2);
+      inv_freq[i] = 1.0f / std::pow(10000.0f, idx / head_dim);
+    }
+  }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t bs = 0; bs < batch_size * seq_len; ++bs) {
+    int64_t s = bs % seq_len;
+    int64_t pos = position_ids_data ? position_ids_data[bs] : s;
+    std::vector<float> sin_value(head_dim);
+    std::vector<float> cos_value(head_dim);
+    for (int64_t i = 0; i < head_dim; ++i) {
+      if (sin_data) {
+        sin_value[i] = static_cast<float>(sin_data[pos * head_dim + i]);
+        cos_value[i] = static_cast<float>(cos_data[pos * head_dim + i]);
+      } else {
+        float value = s * inv_freq[i];
+        sin_value[i] = std::sin(value);
+        cos_value[i] = std::cos(value);
+      }
+    }
+    int64_t offset = bs * num_heads * head_dim;
+    for (int64_t h = 0; h < num_heads; ++h) {
+      const T* x = in + offset + h * head_dim;
+      T* y = out + offset + h * head_dim;
+      if (use_neox_rotary_style) {
+        // rotate every two
+        for (int64_t i = 0; i < head_dim; i += 2) {
+          float x0 = static_cast<float>(x[i]);
+          float x1 = static_cast<float>(x[i + 1]);
+          y[i] = static_cast<T>(cos_value[i] * x0 - sin_value[i] * x1);
+          y[i + 1] =
+              static_cast<T>(sin_value[i + 1] * x0 + cos_value[i + 1] * x1);
+        }
+      } else {
+        // rotate half
+        for (int64_t i = 0; i < half; ++i) {
+          float x0 = static_cast<float>(x[i]);
+          float x1 = static_cast<float>(x[i + half]);
+          y[i] = static_cast<T>(cos_value[i] * x0 - sin_value[i] * x1);
+          y[i + half] = static_cast<T>(cos_value[i + half] * x1 +
+                                       sin_value[i + half] * x0);
+        }
+      }
+    }
+  }
+}
+
+template <typename T, typename Context>
+void FusedRopeKernel(const Context& dev_ctx,
+                     const DenseTensor& q,
+                     const paddle::optional<DenseTensor>& k,
+                     const paddle::optional<DenseTensor>& v,
+                     const paddle::optional<DenseTensor>& sin,
+                     const paddle::optional<DenseTensor>& cos,
+                     const paddle::optional<DenseTensor>& position_ids,
+                     bool use_neox_rotary_style,
+                     DenseTensor* out_q,
+                     DenseTensor* out_k,
+                     DenseTensor* out_v) {
+  if (q.numel() <= 0) return;
+
+  // q.shape: [batch_size, seq_len, num_heads, head_dim]
+  auto batch_size = q.dims()[0];
+  auto seq_len = q.dims()[1];
+  auto head_dim = q.dims()[3];
+  PADDLE_ENFORCE_EQ(head_dim % 2,
+                    0,
+                    phi::errors::InvalidArgument(
+                        "The head_dim of input must be a multiple of 2."));
+
+  const T* sin_data = nullptr;
+  const T* cos_data = nullptr;
+  const int64_t* position_ids_data = nullptr;
+  if (sin.get_ptr() && cos.get_ptr()) {
+    PADDLE_ENFORCE_EQ(sin->dims(),
+                      cos->dims(),
+                      phi::errors::InvalidArgument(
+                          "The dims of sin and cos must be the same. But "
+                          "received sin's dims is {%s}, cos's dims is {%s}.",
+                          sin->dims(),
+                          cos->dims()));
+    auto sin_dims = sin->dims();
+    int dims_size = sin_dims.size();
+    PADDLE_ENFORCE_EQ(
+        (dims_size == 2 || dims_size == 4),
+        true,
+        phi::errors::InvalidArgument("The dims of sin and cos is expected to "
+                                     "be 2 or 4, but received %d.",
+                                     dims_size));
+    int sin_seq_len_dim = dims_size == 4 ? 1 : 0;
+    PADDLE_ENFORCE_EQ(
+        (sin_dims[dims_size - 1] == head_dim &&
+         sin_dims[sin_seq_len_dim] >= seq_len),
+        true,
+        phi::errors::InvalidArgument(
+            "The seq_len of sin and cos must be greater than or equal to "
+            "this of q. The head_dim of sin and cos must be the same as this "
+            "of q. But received sin's shape is {%s}, q's shape is {%s}.",
+            sin_dims,
+            q.dims()));
+    sin_data = sin->data<T>();
+    cos_data = cos->data<T>();
+    if (position_ids) {
+      position_ids_data = position_ids->data<int64_t>();
+    }
+  }
+
+  // k and v may have less heads than q, e.g. of grouped query attention
+  auto rope = [&](const DenseTensor& x, DenseTensor* out) {
+    FusedRopeCPU<T>(x.data<T>(),
+                    sin_data,
+                    cos_data,
+                    position_ids_data,
+                    use_neox_rotary_style,
+                    batch_size,
+                    seq_len,
+                    x.dims()[2],
+                    head_dim,
+                    dev_ctx.template Alloc<T>(out));
+  };
+  rope(q, out_q);
+  if (k) {
+    rope(*k, out_k);
+  }
+  if (v) {
+    rope(*v, out_v);
+  }
+}
+
+}  // namespace fusion
+}  // namespace phi
+
+PD_REGISTER_KERNEL(fused_rotary_position_embedding,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::fusion::FusedRopeKernel,
+                   float,
+                   double,
+                   phi::dtype::float16,
+                   phi::dtype::bfloat16) {}
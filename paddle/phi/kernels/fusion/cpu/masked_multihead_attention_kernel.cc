@@ -0,0 +1,331 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+namespace phi {
+namespace fusion {
+
+// The decoding step of the attention on CPU, with the cache_kv of the GPU
+// kernel, i.e. [2, cache_bsz, kv_num_head, max_seq_len, dim_head] where the
+// cache of k is stored as [dim_head / x, max_seq_len, x] per head, x the
+// number of elements in 16 bytes. A score is the sum of the products of the
+// x-element rows of a time step, so the cache of k is read in order as the
+// cache of v.
+
+// Applies the rotary embedding of rotary_emb [2, bsz, 1, 1, dim_head] of the
+// batch bi to vec, as the GPU kernel.
+inline void MMHAApplyRotary(const float* rotary_emb,
+                            int bsz,
+                            int bi,
+                            int dim_head,
+                            int rotary_emb_dims,
+                            bool use_neox_rotary_style,
+                            float* vec) {
+  const float* cos_emb = rotary_emb + bi * dim_head;
+  const float* sin_emb = rotary_emb + bsz * dim_head + bi * dim_head;
+  if (!use_neox_rotary_style) {
+    for (int d = 0; d < dim_head; d += 2) {
+      float x = vec[d];
+      float y = vec[d + 1];
+      vec[d] = x * cos_emb[d] - y * sin_emb[d];
+      vec[d + 1] = y * cos_emb[d + 1] + x * sin_emb[d + 1];
+    }
+    return;
+  }
+  int last_dim = dim_head / rotary_emb_dims;
+  int half_lastdim = last_dim / 2;
+  std::vector<float> ori(vec, vec + dim_head);
+  for (int d = 0; d < dim_head; ++d) {
+    int pos = d % last_dim;
+    int right = d - pos + (pos + half_lastdim) % last_dim;
+    float alpha = pos < half_lastdim ? -1.0f : 1.0f;
+    vec[d] = ori[d] * cos_emb[d] + alpha * ori[right] * sin_emb[d];
+  }
+}
+
+// Loads the head of x [bsz, num_head + 2 * kv_num_head, dim_head] at
+// offset in a batch, with the bias of the same offset if given.
+template <typename T>
+void MMHALoadQKV(const T* x,
+                 const T* bias,
+                 int64_t offset,
+                 int dim_head,
+                 float* out) {
+  for (int d = 0; d < dim_head; ++d) {
+    out[d] = static_cast<float>(x[offset + d]);
+    if (bias) {
+      out[d] += static_cast<float>(bias[offset + d]);
+    }
+  }
+}
+
+template <typename T, typename Context>
+void MMHAKernel(const Context& dev_ctx,
+                const DenseTensor& x,
+                const DenseTensor& cache_kv,
+                const paddle::optional<DenseTensor>& bias,
+                const paddle::optional<DenseTensor>& src_mask,
+                const paddle::optional<DenseTensor>& cum_offsets,
+                const paddle::optional<DenseTensor>& sequence_lengths,
+                const paddle::optional<DenseTensor>& rotary_tensor,
+                const paddle::optional<DenseTensor>& beam_cache_offset,
+                const paddle::optional<DenseTensor>& qkv_out_scale,
+                const paddle::optional<DenseTensor>& out_shift,
+                const paddle::optional<DenseTensor>& out_smooth,
+                int seq_len,
+                int rotary_emb_dims,
+                const bool use_neox_rotary_style,
+                const std::string& compute_dtype,
+                const float out_scale,
+                const int quant_round_type,
+                const float quant_max_bound,
+                const float quant_min_bound,
+                DenseTensor* out,
+                DenseTensor* cache_kv_out,
+                DenseTensor* beam_cache_offset_out) {
+  PADDLE_ENFORCE_EQ(
+      beam_cache_offset.get_ptr() == nullptr &&
+          qkv_out_scale.get_ptr() == nullptr,
+      true,
+      phi::errors::Unimplemented("The CPU kernel of masked_multihead_attention "
+                                 "does not support beam_cache_offset and the "
+                                 "dequantization of qkv_out_scale."));
+
+  const auto& x_dims = x.dims();
+  int bsz = x_dims[0];
+  int max_seq_len = cache_kv.dims()[3];
+  int dim_head = cache_kv.dims()[4];
+  int kv_num_head = cache_kv.dims()[2];
+  int cache_bsz = cache_kv.dims()[1];
+  // this num_head means query's head
+  int num_head = x_dims[x_dims.size() - 1] / dim_head - 2 * kv_num_head;
+  int num_head_per_group = num_head / kv_num_head;
+  int qkv_num_head = num_head + 2 * kv_num_head;
+  float inv_sqrt_dh = 1.0f / std::sqrt(static_cast<float>(dim_head));
+  constexpr int kElts16B = 16 / sizeof(T);
+  PADDLE_ENFORCE_EQ(
+      dim_head % kElts16B,
+      0,
+      phi::errors::InvalidArgument(
+          "The dim_head of masked_multihead_attention must be a multiple of "
+          "%d, but received %d.",
+          kElts16B,
+          dim_head));
+
+  int timestep = max_seq_len;
+  int mask_length = 0;
+  bool mask_broadcast_num_heads = true;
+  const T* mask_data = nullptr;
+  if (src_mask) {
+    if (src_mask->dims()[1] == num_head) {
+      mask_broadcast_num_heads = false;
+    } else if (src_mask->dims()[1] != 1) {
+      PADDLE_THROW(errors::InvalidArgument(
+          "Unknow dimension for attn_mask, the num_head(2nd) "
+          "dimension is invalid, it should be 1 or num_head(%d), "
+          "but got %d",
+          num_head,
+          src_mask->dims()[1]));
+    }
+    mask_data = src_mask->data<T>();
+    mask_length = src_mask->dims()[3];
+    timestep = mask_length - 1;
+  }
+  const int* sequence_lengths_data =
+      sequence_lengths ? sequence_lengths->data<int>() : nullptr;
+  const int* cum_offsets_data =
+      cum_offsets ? cum_offsets->data<int>() : nullptr;
+  const float* rotary_emb =
+      rotary_emb_dims > 0 ? rotary_tensor->data<float>() : nullptr;
+  const T* x_data = x.data<T>();
+  const T* bias_data = bias ? bias->data<T>() : nullptr;
+  const T* shift_data = out_shift ? out_shift->data<T>() : nullptr;
+  const T* smooth_data = out_smooth ? out_smooth->data<T>() : nullptr;
+
+  T* cache_k = dev_ctx.template Alloc<T>(cache_kv_out);
+  if (cache_k != cache_kv.data<T>()) {
+    std::memcpy(cache_k, cache_kv.data<T>(), cache_kv.numel() * sizeof(T));
+  }
+  int64_t head_cache_size = static_cast<int64_t>(max_seq_len) * dim_head;
+  T* cache_v = cache_k + cache_bsz * kv_num_head * head_cache_size;
+  T* out_data = nullptr;
+  int8_t* quant_out_data = nullptr;
+  if (out_scale > 0) {
+    quant_out_data = dev_ctx.template Alloc<int8_t>(out);
+  } else {
+    out_data = dev_ctx.template Alloc<T>(out);
+  }
+
+  auto act_time_step = [&](int bi) {
+    return sequence_lengths_data ? sequence_lengths_data[bi] : timestep;
+  };
+
+  // appends the k and v of the step to the cache, once per kv head
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int bhi = 0; bhi < bsz * kv_num_head; ++bhi) {
+    int bi = bhi / kv_num_head;
+    int hi = bhi % kv_num_head;
+    int t = act_time_step(bi);
+    if (t < 0) {
+      continue;
+    }
+    std::vector<float> kv(dim_head);
+    int64_t base = static_cast<int64_t>(bi) * qkv_num_head * dim_head;
+    MMHALoadQKV(x_data + base,
+                bias_data,
+                (num_head + hi) * dim_head,
+                dim_head,
+                kv.data());
+    if (rotary_emb) {
+      MMHAApplyRotary(rotary_emb,
+                      bsz,
+                      bi,
+                      dim_head,
+                      rotary_emb_dims,
+                      use_neox_rotary_style,
+                      kv.data());
+    }
+    T* k_head = cache_k + bhi * head_cache_size;
+    for (int d = 0; d < dim_head; ++d) {
+      k_head[(d / kElts16B) * max_seq_len * kElts16B + t * kElts16B +
+             d % kElts16B] = static_cast<T>(kv[d]);
+    }
+    MMHALoadQKV(x_data + base,
+                bias_data,
+                (num_head + kv_num_head + hi) * dim_head,
+                dim_head,
+                kv.data());
+    T* v_step = cache_v + bhi * head_cache_size + t * dim_head;
+    for (int d = 0; d < dim_head; ++d) {
+      v_step[d] = static_cast<T>(kv[d]);
+    }
+  }
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int bhi = 0; bhi < bsz * num_head; ++bhi) {
+    int bi = bhi / num_head;
+    int hi = bhi % num_head;
+    int t = act_time_step(bi);
+    if (t < 0) {
+      continue;
+    }
+    int kv_bhi = bi * kv_num_head + hi / num_head_per_group;
+    std::vector<float> q(dim_head);
+    std::vector<float> qk(t + 1, 0.0f);
+    std::vector<float> res(dim_head, 0.0f);
+    int64_t base = static_cast<int64_t>(bi) * qkv_num_head * dim_head;
+    MMHALoadQKV(x_data + base,
+                bias_data,
+                hi * dim_head,
+                dim_head,
+                q.data());
+    if (rotary_emb) {
+      MMHAApplyRotary(rotary_emb,
+                      bsz,
+                      bi,
+                      dim_head,
+                      rotary_emb_dims,
+                      use_neox_rotary_style,
+                      q.data());
+    }
+
+    const T* k_head = cache_k + kv_bhi * head_cache_size;
+    for (int co = 0; co < dim_head / kElts16B; ++co) {
+      const T* k_chunk = k_head + co * max_seq_len * kElts16B;
+      const float* q_chunk = q.data() + co * kElts16B;
+      for (int ti = 0; ti <= t; ++ti) {
+        float sum = 0;
+        for (int ci = 0; ci < kElts16B; ++ci) {
+          sum += q_chunk[ci] * static_cast<float>(k_chunk[ti * kElts16B + ci]);
+        }
+        qk[ti] += sum;
+      }
+    }
+    const T* mask_row =
+        mask_data ? mask_data + (mask_broadcast_num_heads ? bi : bhi) *
+                                    static_cast<int64_t>(mask_length)
+                  : nullptr;
+    float qk_max = -FLT_MAX;
+    for (int ti = 0; ti <= t; ++ti) {
+      qk[ti] *= inv_sqrt_dh;
+      if (mask_row) {
+        qk[ti] += static_cast<float>(mask_row[ti]);
+      }
+      qk_max = std::max(qk_max, qk[ti]);
+    }
+    float sum = 0;
+    for (int ti = 0; ti <= t; ++ti) {
+      qk[ti] = std::exp(qk[ti] - qk_max);
+      sum += qk[ti];
+    }
+    float inv_sum = 1.0f / (sum + 1.e-6f);
+
+    const T* v_head = cache_v + kv_bhi * head_cache_size;
+    for (int ti = 0; ti <= t; ++ti) {
+      float p = qk[ti] * inv_sum;
+      const T* v_step = v_head + ti * dim_head;
+      for (int d = 0; d < dim_head; ++d) {
+        res[d] += p * static_cast<float>(v_step[d]);
+      }
+    }
+
+    int64_t out_offset = static_cast<int64_t>(bhi) * dim_head;
+    if (cum_offsets_data) {
+      int ti = bi * seq_len - cum_offsets_data[bi];
+      out_offset = (static_cast<int64_t>(ti) * num_head + hi) * dim_head;
+    }
+    for (int d = 0; d < dim_head; ++d) {
+      float v = res[d];
+      if (shift_data) {
+        v = (v + static_cast<float>(shift_data[hi * dim_head + d])) *
+            static_cast<float>(smooth_data[hi * dim_head + d]);
+      }
+      if (out_data) {
+        out_data[out_offset + d] = static_cast<T>(v);
+        continue;
+      }
+      float quant_value = quant_max_bound * out_scale * v;
+      quant_value = quant_round_type == 0 ? std::rint(quant_value)
+                                          : std::round(quant_value);
+      quant_value =
+          std::min(quant_max_bound, std::max(quant_min_bound, quant_value));
+      quant_out_data[out_offset + d] = static_cast<int8_t>(quant_value);
+    }
+  }
+}
+
+}  // namespace fusion
+}  // namespace phi
+
+PD_REGISTER_KERNEL(masked_multihead_attention,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::fusion::MMHAKernel,
+                   float,
+                   phi::dtype::float16,
+                   phi::dtype::bfloat16) {}
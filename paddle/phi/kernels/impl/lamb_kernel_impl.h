@@ -12,8 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #pragma once
+#include <algorithm>
+#include <vector>
+
 #include "glog/logging.h"
 
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/kernels/full_kernel.h"
@@ -21,6 +25,85 @@
 
 namespace phi {
 
+// The elements of a chunk of the CPU loops of lamb.
+constexpr int64_t kLambCPUChunkSize = 4096;
+
+// Runs functor(i) for i in [0, numel), the CPU runs the chunks of the
+// elements in parallel rather than one loop as ForRange.
+template <typename Context, typename Functor>
+void LambForRange(const Context& dev_ctx,
+                  int64_t numel,
+                  const Functor& functor) {
+  phi::funcs::ForRange<Context> for_range(dev_ctx, numel);
+  for_range(functor);
+}
+
+template <typename Functor>
+void LambForRange(const phi::CPUContext& dev_ctx UNUSED,
+                  int64_t numel,
+                  const Functor& functor) {
+  int64_t chunks_num = (numel + kLambCPUChunkSize - 1) / kLambCPUChunkSize;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t c = 0; c < chunks_num; ++c) {
+    int64_t end = std::min(numel, (c + 1) * kLambCPUChunkSize);
+    for (int64_t i = c * kLambCPUChunkSize; i < end; ++i) {
+      functor(static_cast<size_t>(i));
+    }
+  }
+}
+
+// The squared L2 norms of the param and of the trust ratio div. The CPU
+// computes both in one parallel pass, the partial sums of the chunks are
+// added in order so that the result does not depend on the threads.
+template <typename MT, typename Context>
+void LambSquaredL2Norms(const Context& dev_ctx,
+                        const MT* param,
+                        const MT* trust_ratio_div,
+                        MT* param_norm,
+                        MT* trust_ratio_div_norm,
+                        int64_t numel) {
+  memory_utils::Buffer buffer(dev_ctx.GetPlace());
+  phi::funcs::SquaredL2Norm(dev_ctx, param, param_norm, numel, &buffer);
+  phi::funcs::SquaredL2Norm(
+      dev_ctx, trust_ratio_div, trust_ratio_div_norm, numel, &buffer);
+}
+
+template <typename MT>
+void LambSquaredL2Norms(const phi::CPUContext& dev_ctx UNUSED,
+                        const MT* param,
+                        const MT* trust_ratio_div,
+                        MT* param_norm,
+                        MT* trust_ratio_div_norm,
+                        int64_t numel) {
+  int64_t chunks_num = (numel + kLambCPUChunkSize - 1) / kLambCPUChunkSize;
+  std::vector<MT> param_sums(chunks_num);
+  std::vector<MT> trust_ratio_div_sums(chunks_num);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t c = 0; c < chunks_num; ++c) {
+    int64_t end = std::min(numel, (c + 1) * kLambCPUChunkSize);
+    MT p_sum = static_cast<MT>(0);
+    MT t_sum = static_cast<MT>(0);
+    for (int64_t i = c * kLambCPUChunkSize; i < end; ++i) {
+      p_sum += param[i] * param[i];
+      t_sum += trust_ratio_div[i] * trust_ratio_div[i];
+    }
+    param_sums[c] = p_sum;
+    trust_ratio_div_sums[c] = t_sum;
+  }
+  MT p_norm = static_cast<MT>(0);
+  MT t_norm = static_cast<MT>(0);
+  for (int64_t c = 0; c < chunks_num; ++c) {
+    p_norm += param_sums[c];
+    t_norm += trust_ratio_div_sums[c];
+  }
+  *param_norm = p_norm;
+  *trust_ratio_div_norm = t_norm;
+}
+
 template <typename T, typename MT, typename Context, bool IsMultiPrecision>
 void ComputeImpl(const Context& dev_ctx,
                  const DenseTensor& param,
@@ -167,7 +250,6 @@ void ComputeImpl(const Context& dev_ctx,
   auto beta2 = static_cast<MT>(beta2_f);
   auto epsilon = static_cast<MT>(epsilon_f);
   auto numel = param.numel();
-  phi::funcs::ForRange<Context> for_range(dev_ctx, numel);
   DenseTensor trust_ratio_div;
   trust_ratio_div.Resize(param.dims());
   auto* trust_ratio_div_ptr = dev_ctx.template Alloc<MT>(&trust_ratio_div);
@@ -203,7 +285,7 @@ void ComputeImpl(const Context& dev_ctx,
         static_cast<const MT*>(IsMultiPrecision ? master_param_ptr : param_ptr),
         trust_ratio_div_ptr,
         skip_update_flag);
-    for_range(moment_update_functor);
+    LambForRange(dev_ctx, numel, moment_update_functor);
     MT* beta1_pow_out_data = dev_ctx.template HostAlloc<MT>(beta1_pow_out);
     beta1_pow_out_data[0] = beta1 * beta1_pow.template data<MT>()[0];
     MT* beta2_pow_out_data = dev_ctx.template HostAlloc<MT>(beta2_pow_out);
@@ -229,7 +311,7 @@ void ComputeImpl(const Context& dev_ctx,
         static_cast<const MT*>(IsMultiPrecision ? master_param_ptr : param_ptr),
         trust_ratio_div_ptr,
         skip_update_flag);
-    for_range(moment_update_functor);
+    LambForRange(dev_ctx, numel, moment_update_functor);
   }
 
   // Same from here
@@ -260,16 +342,13 @@ void ComputeImpl(const Context& dev_ctx,
   // TODO(zengjinle): remove the following Eigen operations when
   // *skip_update == true.
   if (weight_decay > static_cast<MT>(0) || always_adapt) {
-    memory_utils::Buffer buffer(dev_ctx.GetPlace());
-    phi::funcs::SquaredL2Norm(
-        dev_ctx,
-        reinterpret_cast<const MT*>(IsMultiPrecision ? master_param_ptr
-                                                     : param_ptr),
-        p_norm_ptr,
-        numel,
-        &buffer);
-    phi::funcs::SquaredL2Norm(
-        dev_ctx, trust_ratio_div_ptr, trust_ratio_div_norm_ptr, numel, &buffer);
+    LambSquaredL2Norms(dev_ctx,
+                       reinterpret_cast<const MT*>(
+                           IsMultiPrecision ? master_param_ptr : param_ptr),
+                       trust_ratio_div_ptr,
+                       p_norm_ptr,
+                       trust_ratio_div_norm_ptr,
+                       numel);
   }
 
   if (VLOG_IS_ON(1)) {
@@ -302,7 +381,7 @@ void ComputeImpl(const Context& dev_ctx,
                                        beta1,                                 \
                                        beta2);                                \
     }                                                                         \
-    for_range(param_update_functor);                                          \
+    LambForRange(dev_ctx, numel, param_update_functor);                       \
   } while (0)
 
   if (should_update_beta_pow_later) {
@@ -14,6 +14,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "glog/logging.h"
 
 #include "paddle/common/hostdevice.h"
@@ -85,6 +89,81 @@ struct MergedMomentumKernelParam
   }
 };
 
+// The elements of a chunk of MergedMomentumCPUCompute.
+constexpr int64_t kMergedMomentumCPUChunkSize = 4096;
+
+// The CPU update of all the parameters of merged_momentum. The parameters
+// are flattened to the chunks of at most kMergedMomentumCPUChunkSize
+// elements, which the threads update in parallel, so that the many small
+// parameters of a model do not run one after another on a single thread.
+// The grads are scaled by rescale_grad as in DenseMomentumFunctor.
+template <typename T, typename MT, typename MPType>
+void MergedMomentumCPUCompute(
+    const std::vector<DenseTensor *> &params_out,
+    const std::vector<const DenseTensor *> &grads,
+    const std::vector<DenseTensor *> &velocities_out,
+    const std::vector<const DenseTensor *> &lrs,
+    const std::vector<DenseTensor *> &master_params_out,
+    MT mu,
+    bool use_nesterov,
+    const std::vector<std::string> &regularization_methods,
+    const std::vector<float> &regularization_coeffs,
+    MT rescale_grad) {
+  struct Chunk {
+    size_t idx;
+    int64_t offset;
+    int64_t numel;
+  };
+  size_t n = params_out.size();
+  std::vector<Chunk> chunks;
+  for (size_t idx = 0; idx < n; ++idx) {
+    int64_t numel = params_out[idx]->numel();
+    for (int64_t offset = 0; offset < numel;
+         offset += kMergedMomentumCPUChunkSize) {
+      chunks.push_back(
+          {idx, offset, std::min(kMergedMomentumCPUChunkSize, numel - offset)});
+    }
+  }
+
+  int64_t chunks_num = static_cast<int64_t>(chunks.size());
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t c = 0; c < chunks_num; ++c) {
+    const size_t idx = chunks[c].idx;
+    const int64_t offset = chunks[c].offset;
+    const int64_t numel = chunks[c].numel;
+    const MT lr = static_cast<MT>(
+        (lrs.size() > 1 ? lrs[idx] : lrs[0])->template data<MPType>()[0]);
+    const bool l2_decay = regularization_methods.size() > 0 &&
+                          regularization_methods[idx] == "l2_decay";
+    const MT coeff = regularization_coeffs.size() > 0
+                         ? static_cast<MT>(regularization_coeffs[idx])
+                         : static_cast<MT>(0);
+    T *param = params_out[idx]->template data<T>() + offset;
+    const T *grad = grads[idx]->template data<T>() + offset;
+    MT *velocity = velocities_out[idx]->template data<MT>() + offset;
+    MT *master_param =
+        master_params_out.empty()
+            ? nullptr
+            : master_params_out[idx]->template data<MT>() + offset;
+    for (int64_t i = 0; i < numel; ++i) {
+      MT p = master_param ? master_param[i] : static_cast<MT>(param[i]);
+      MT g = static_cast<MT>(grad[i]) * rescale_grad;
+      if (l2_decay) {
+        g += coeff * p;
+      }
+      MT v = velocity[i] * mu + g;
+      p = use_nesterov ? p - (g + v * mu) * lr : p - lr * v;
+      velocity[i] = v;
+      param[i] = static_cast<T>(p);
+      if (master_param) {
+        master_param[i] = p;
+      }
+    }
+  }
+}
+
 template <typename MT, typename Context, typename MPType, typename T>
 void MergedMomentumInnerCompute(
     const Context &ctx,
@@ -229,6 +308,21 @@ void MergedMomentumInnerCompute(
           << ",  regularization_coeffs.size(): "
           << regularization_coeffs.size();
 
+  if (ctx.GetPlace().GetType() == phi::AllocationType::CPU) {
+    MergedMomentumCPUCompute<T, MT, MPType>(params_out,
+                                            grads,
+                                            velocities_out,
+                                            lrs,
+                                            master_params_out,
+                                            static_cast<MT>(mu),
+                                            use_nesterov,
+                                            regularization_methods,
+                                            regularization_coeffs,
+                                            static_cast<MT>(rescale_grad));
+    VLOG(10) << "Launch MergedMomentum cpu kernel.";
+    return;
+  }
+
   if (lrs.size() == 1 && use_nesterov == false &&
       regularization_methods.size() == 0) {
 #define PADDLE_LAUNCH_MERGED_MOMENTUM_KERNEL(kMultiPrecision)              \
@@ -284,20 +378,7 @@ void MergedMomentumInnerCompute(
           multi_precision ? master_params_opt.get()[idx]->data<MT>() : nullptr;
       MT *master_out_data =
           multi_precision ? master_params_out[idx]->data<MT>() : nullptr;
-      if (ctx.GetPlace().GetType() == phi::AllocationType::CPU) {
-        phi::CPUDenseMomentumFunctor<MT> functor;
-        functor(params[idx],
-                grads[idx],
-                velocities[idx],
-                lr_temp,
-                static_cast<MT>(mu),
-                use_nesterov,
-                regularization_flag,
-                regularization_coeff,
-                params_out[idx],
-                velocities_out[idx]);
-        VLOG(10) << "Launch MergedMomentum cpu kernel.";
-      } else if (ctx.GetPlace().GetType() == phi::AllocationType::GPU) {
+      if (ctx.GetPlace().GetType() == phi::AllocationType::GPU) {
         phi::funcs::ForRange<Context> for_range(
             static_cast<const Context &>(ctx), params[idx]->numel());
         const auto grad_type = grads[idx]->dtype();
@@ -172,6 +172,38 @@ void group_wise_quant(int8_t* output,
   }
 }
 
+// Packs the quantized weight of [k, n], written by per_channel_quant or
+// group_wise_quant, to the layout of the CPU kernel of weight_only_linear:
+// row-major [n, k], so that an output channel reads a contiguous row. An int4
+// row packs two adjacent k in a byte, the lower k in the lower 4 bits.
+template <int quant_bit>
+void pack_weight_for_cpu(int8_t* packed_tensor,
+                         const int8_t* quantized_tensor,
+                         size_t k,
+                         size_t n) {
+  if (quant_bit == 8) {
+    for (size_t i = 0; i < k; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        packed_tensor[j * k + i] = quantized_tensor[i * n + j];
+      }
+    }
+    return;
+  }
+  const size_t in_row_bytes = n / 2;
+  const size_t out_row_bytes = k / 2;
+  for (size_t i = 0; i < k; i += 2) {
+    for (size_t j = 0; j < n; ++j) {
+      int8_t lo = quantized_tensor[i * in_row_bytes + j / 2];
+      int8_t hi = quantized_tensor[(i + 1) * in_row_bytes + j / 2];
+      // the double shift sign-extends the lower int4
+      lo = j % 2 == 0 ? static_cast<int8_t>(lo << 4) >> 4 : lo >> 4;
+      hi = j % 2 == 0 ? static_cast<int8_t>(hi << 4) >> 4 : hi >> 4;
+      packed_tensor[j * out_row_bytes + i / 2] =
+          static_cast<int8_t>((lo & 0x0F) | ((hi & 0x0F) << 4));
+    }
+  }
+}
+
 template <int quant_bit = 8>
 void add_bias_and_interleave_inplace(int8_t* tensor_ptr, size_t num_elts) {
   const size_t num_bytes = num_elts * quant_bit / 8;
@@ -16,30 +16,101 @@ limitations under the License. */
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/core/visit_type.h"
+#include "paddle/phi/kernels/funcs/sparse/sparse_blas.h"
+#include "paddle/phi/kernels/sparse/empty_kernel.h"
 
 namespace phi {
 namespace sparse {
 
+template <typename T, typename IntT>
+void MvCooGradCPUKernel(const T* dout,
+                        const T* vec,
+                        const IntT* dx_indices,
+                        T* dx_values,
+                        int64_t nnz) {
+  for (int64_t idx = 0; idx < nnz; ++idx) {
+    IntT i = dx_indices[idx];
+    IntT j = dx_indices[idx + nnz];
+    dx_values[idx] = dout[i] * vec[j];
+  }
+}
+
+template <typename T, typename IntT>
+void MvCsrGradCPUKernel(const T* dout,
+                        const T* vec,
+                        const IntT* dx_crows,
+                        const IntT* dx_cols,
+                        T* dx_values,
+                        int64_t row_number) {
+  for (int64_t i = 0; i < row_number; ++i) {
+    for (IntT k = dx_crows[i]; k < dx_crows[i + 1]; ++k) {
+      dx_values[k] = dout[i] * vec[dx_cols[k]];
+    }
+  }
+}
+
 template <typename T, typename Context>
-void MvCooGradKernel(const Context& dev_ctx UNUSED,
-                     const SparseCooTensor& x UNUSED,
-                     const DenseTensor& vec UNUSED,
-                     const DenseTensor& dout UNUSED,
-                     SparseCooTensor* dx UNUSED,
-                     DenseTensor* dvec UNUSED) {
-  PADDLE_THROW(phi::errors::Unimplemented(
-      "Not support CPU backward kernel of 'sparse.mv' now."));
+void MvCooGradKernel(const Context& dev_ctx,
+                     const SparseCooTensor& x,
+                     const DenseTensor& vec,
+                     const DenseTensor& dout,
+                     SparseCooTensor* dx,
+                     DenseTensor* dvec) {
+  // dx{SparseCoo} = dout{Dense} * vec'{Dense}
+  if (dx) {
+    // InferMeta of SparseCooTensor 'dx', CreateLikeInferMeta
+    EmptyLikeCooKernel<T, Context>(dev_ctx, x, dx);
+    PD_VISIT_BASE_INTEGRAL_TYPES(
+        dx->indices().dtype(), "MvCooGradKernel", ([&] {
+          MvCooGradCPUKernel<T, data_t>(dout.data<T>(),
+                                        vec.data<T>(),
+                                        dx->indices().data<data_t>(),
+                                        dx->mutable_values()->data<T>(),
+                                        dx->nnz());
+        }));
+  }
+
+  // dvec{Dense} = x'{SparseCoo} * dout{Dense}
+  if (dvec) {
+    // InferMeta of DenseTensor 'dvec'
+    dvec->Resize(vec.dims());
+    dev_ctx.template Alloc<T>(dvec);
+    auto sparse_blas = phi::funcs::sparse::GetSparseBlas<Context, T>(dev_ctx);
+    sparse_blas.SPMV(true, static_cast<T>(1), x, dout, static_cast<T>(0), dvec);
+  }
 }
 
 template <typename T, typename Context>
-void MvCsrGradKernel(const Context& dev_ctx UNUSED,
-                     const SparseCsrTensor& x UNUSED,
-                     const DenseTensor& vec UNUSED,
-                     const DenseTensor& dout UNUSED,
-                     SparseCsrTensor* dx UNUSED,
-                     DenseTensor* dvec UNUSED) {
-  PADDLE_THROW(phi::errors::Unimplemented(
-      "Not support CPU backward kernel of 'sparse.mv' now."));
+void MvCsrGradKernel(const Context& dev_ctx,
+                     const SparseCsrTensor& x,
+                     const DenseTensor& vec,
+                     const DenseTensor& dout,
+                     SparseCsrTensor* dx,
+                     DenseTensor* dvec) {
+  // dx{SparseCsr} = dout{Dense} * vec'{Dense}
+  if (dx) {
+    // InferMeta of SparseCsrTensor 'dx', CreateLikeInferMeta
+    EmptyLikeCsrKernel<T, Context>(dev_ctx, x, dx);
+    PD_VISIT_BASE_INTEGRAL_TYPES(
+        dx->crows().dtype(), "MvCsrGradKernel", ([&] {
+          MvCsrGradCPUKernel<T, data_t>(dout.data<T>(),
+                                        vec.data<T>(),
+                                        dx->crows().data<data_t>(),
+                                        dx->cols().data<data_t>(),
+                                        dx->mutable_values()->data<T>(),
+                                        dx->dims()[0]);
+        }));
+  }
+
+  // dvec{Dense} = x'{SparseCsr} * dout{Dense}
+  if (dvec) {
+    // InferMeta of DenseTensor 'dvec'
+    dvec->Resize(vec.dims());
+    dev_ctx.template Alloc<T>(dvec);
+    auto sparse_blas = phi::funcs::sparse::GetSparseBlas<Context, T>(dev_ctx);
+    sparse_blas.SPMV(true, static_cast<T>(1), x, dout, static_cast<T>(0), dvec);
+  }
 }
 
 }  // namespace sparse
@@ -144,6 +144,55 @@ class DatasetBase:
     def _set_input_type(self, input_type):
         self.proto_desc.input_type = input_type
 
+    def _set_data_format(self, data_format):
+        """
+        Set the format of the input files, "text" or "columnar". Columnar
+        files are written by ``_convert_to_columnar`` and are loaded without
+        text parsing.
+
+        Examples:
+            .. code-block:: python
+
+                >>> import paddle
+                >>> dataset = paddle.distributed.fleet.DatasetBase()
+                >>> dataset._set_data_format("columnar")
+
+        Args:
+            data_format(str): "text" or "columnar"
+        """
+        if data_format not in ("text", "columnar"):
+            raise ValueError(
+                f"data_format should be 'text' or 'columnar', but got {data_format}"
+            )
+        self.proto_desc.data_format = data_format
+
+    def _convert_to_columnar(
+        self, text_path, columnar_path, has_ins_id=False, compress=False
+    ):
+        """
+        Convert a local text file of the slot format into the columnar format
+        with the slots set by use_var, so that it can be loaded with
+        ``_set_data_format("columnar")``. The pipe command is not applied.
+
+        Args:
+            text_path(str): path of the text file
+            columnar_path(str): path of the columnar file to write
+            has_ins_id(bool): whether every line starts with an ins id or a log key. default is False.
+            compress(bool): whether to compress the blocks with zlib. default is False.
+
+        Returns:
+            int: the number of converted records
+        """
+        slots = self.proto_desc.multi_slot_desc.slots
+        return core.convert_slot_text_to_columnar(
+            text_path,
+            columnar_path,
+            [slot.name for slot in slots],
+            [slot.type for slot in slots],
+            has_ins_id,
+            compress,
+        )
+
     def _set_uid_slot(self, uid_slot):
         """
         Set user slot name.
@@ -540,6 +589,7 @@ class InMemoryDataset(DatasetBase):
             download_cmd(str): customized download command. default is "cat"
             data_feed_type(str): data feed type used in c++ code. default is "MultiSlotInMemoryDataFeed".
             queue_num(int): Dataset output queue num, training threads get data from queues. default is -1, which is set same as thread number in c++.
+            data_format(str): format of the input files, "text" or "columnar". default is "text".
 
         Examples:
             .. code-block:: python
@@ -592,6 +642,7 @@ class InMemoryDataset(DatasetBase):
         fs_ugi = kwargs.get("fs_ugi", "")
         pipe_command = kwargs.get("pipe_command", "cat")
         download_cmd = kwargs.get("download_cmd", "cat")
+        data_format = kwargs.get("data_format", "text")
 
         if self.use_ps_gpu:
             data_feed_type = "SlotRecordInMemoryDataFeed"
@@ -609,6 +660,7 @@ class InMemoryDataset(DatasetBase):
             fs_ugi=fs_ugi,
             download_cmd=download_cmd,
         )
+        self._set_data_format(data_format)
 
         if kwargs.get("queue_num", -1) > 0:
             queue_num = kwargs.get("queue_num", -1)
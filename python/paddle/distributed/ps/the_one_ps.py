@@ -767,6 +767,12 @@ class SparseTable(Table):
             table_proto.enable_revert = usr_table_proto.enable_revert
         if usr_table_proto.HasField("shard_merge_rate"):
             table_proto.shard_merge_rate = usr_table_proto.shard_merge_rate
+        if usr_table_proto.HasField("save_binary"):
+            table_proto.save_binary = usr_table_proto.save_binary
+        if usr_table_proto.HasField("push_compress"):
+            table_proto.push_compress.ParseFromString(
+                usr_table_proto.push_compress.SerializeToString()
+            )
 
         if usr_table_proto.accessor.ByteSize() == 0:
             warnings.warn(
@@ -854,6 +860,17 @@ class DenseTable(Table):
         table_proto.accessor.embedx_dim = 1
 
         self.common.table_name = "MergedDense"
+        # the dense tables take push_compress from the sparse_table_configs
+        # entry named MergedDense, if any
+        for usr_table_proto in self.context[
+            "user_defined_strategy"
+        ].sparse_table_configs:
+            if usr_table_proto.table_name == self.common.table_name:
+                if usr_table_proto.HasField("push_compress"):
+                    table_proto.push_compress.ParseFromString(
+                        usr_table_proto.push_compress.SerializeToString()
+                    )
+                break
         self.common.parse_by_optimizer(ctx, self.context)
         self.common.parse_entry(
             self.common.table_name, ctx.program_id(), self.context
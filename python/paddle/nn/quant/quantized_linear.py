@@ -13,6 +13,7 @@
 # limitations under the License.
 
 from paddle import _C_ops, version
+from paddle.base import core
 from paddle.base.data_feeder import check_dtype
 from paddle.base.framework import convert_np_dtype_to_dtype_
 from paddle.device.cuda import get_device_capability
@@ -24,6 +25,9 @@ from paddle.framework import (
 
 
 def _get_arch_info():
+    # arch 0 stands for the CPU kernels
+    if not core.is_compiled_with_cuda():
+        return 0
     # Get SMVersion from device.
     cuda_version = version.cuda()
     if cuda_version is not None and cuda_version != 'False':
@@ -44,7 +48,7 @@ def weight_quantize(x, algo="weight_only_int8", arch=None, group_size=-1):
         x (Tensor): The input Tensor to be quantized, the data type is float16 or bfloat16.
         algo (str): The algo that is x will be apply, must be one of 'weight_only_int8',
             'weight_only_int4' and 'llm.int8', default: 'weight_only_int8'.
-        arch (int): The compute arch for target device. For example, A100 is 80, v100 is 70, if you do not assign arch, we will get arch from your device, default: None.
+        arch (int): The compute arch for target device. For example, A100 is 80, v100 is 70, 0 is the CPU, whose weight is laid out for the CPU kernels. If you do not assign arch, we will get arch from your device, or 0 if Paddle is not compiled with CUDA, default: None.
         group_size (int): The group size for weight quantization. -1 stands for default per-channel mode. Currently only support 64 or 128.
 
     Returns:
@@ -69,8 +73,8 @@ def weight_quantize(x, algo="weight_only_int8", arch=None, group_size=-1):
         arch = _get_arch_info()
 
     assert (
-        arch == 70 or arch == 80 or arch == 86 or arch == 75
-    ), f"Currently weight_quantize only support SM70/75/80/86. but got {arch} "
+        arch == 0 or arch == 70 or arch == 80 or arch == 86 or arch == 75
+    ), f"Currently weight_quantize only support CPU(0) and SM70/75/80/86. but got {arch} "
 
     assert (
         group_size == -1 or group_size == 64 or group_size == 128
@@ -169,7 +173,7 @@ def weight_only_linear(
             be performed. Otherwise, The bias is added to the matrix multiplication result.
         weight_scale (Tensor|None): The input scale Tensor Provided to weight for dequantization. Its rank must be 1.
         weight_dtype(str): The dtype of  weight Tensor, must be one of 'int8', 'int4', Defaulted to 'int8'.
-        arch (int): The compute arch for target device. For example, A100 is 80, v100 is 70, if you do not assign arch, we will get arch from your device, default: None.
+        arch (int): The compute arch for target device. For example, A100 is 80, v100 is 70, 0 is the CPU, whose weight is laid out for the CPU kernels. If you do not assign arch, we will get arch from your device, or 0 if Paddle is not compiled with CUDA, default: None.
         group_size (int): The group size for weight quantization. -1 stands for default per-channel mode. Currently only support 64 or 128.
     Returns:
         Tensor: the output Tensor, the data type is the same as that of x.
@@ -194,8 +198,8 @@ def weight_only_linear(
         arch = _get_arch_info()
 
     assert (
-        arch == 70 or arch == 80 or arch == 86 or arch == 75
-    ), f"Currently weight_quantize only support SM70/75/80/86. but got {arch} "
+        arch == 0 or arch == 70 or arch == 80 or arch == 86 or arch == 75
+    ), f"Currently weight_quantize only support CPU(0) and SM70/75/80/86. but got {arch} "
     assert (
         group_size == -1 or group_size == 64 or group_size == 128
     ), f"Currently weight_quantize only support group size of -1, 64 or 128. but got {group_size} "
@@ -40,6 +40,8 @@ class TestProcessGroupFp32(unittest.TestCase):
         store = paddle.base.core.TCPStore(
             "127.0.0.1", 6272, is_master, nranks, 30
         )
+        # split large allreduce across extra gloo contexts
+        paddle.set_flags({"FLAGS_gloo_allreduce_channels": 2})
         pg = paddle.base.core.ProcessGroupGloo.create(store, rank, nranks)
 
         # test allreduce sum
@@ -228,6 +230,62 @@ class TestProcessGroupFp32(unittest.TestCase):
         test_gather(pg.size() - 1)
         print("test gather api ok\n")
 
+        # test reduce_scatter
+        nranks = pg.size()
+        in_shape = list(self.shape)
+        in_shape[0] *= nranks
+        # every rank generates the inputs of all the ranks by the same seed
+        inputs = [
+            np.random.random(in_shape).astype(self.dtype)
+            for _ in range(nranks)
+        ]
+        tensor_in = paddle.to_tensor(inputs[pg.rank()])
+        tensor_out = paddle.zeros(self.shape, self.dtype)
+        task = pg.reduce_scatter_tensor(
+            tensor_out, tensor_in, core.ReduceOp.SUM, True
+        )
+        task.wait()
+        block = self.shape[0]
+        sum_result = sum(inputs)[pg.rank() * block : (pg.rank() + 1) * block]
+        np.testing.assert_allclose(tensor_out.numpy(), sum_result, rtol=1e-5)
+        print("test reduce_scatter api ok\n")
+
+        # test all_to_all with uneven splits, rank i sends i + j + 1 rows to
+        # rank j
+        row = [5]
+
+        def make_rows(src, dst):
+            return np.full([src + dst + 1, *row], src * 10 + dst, self.dtype)
+
+        in_sizes = [pg.rank() + j + 1 for j in range(nranks)]
+        out_sizes = [j + pg.rank() + 1 for j in range(nranks)]
+        tensor_in = paddle.to_tensor(
+            np.concatenate([make_rows(pg.rank(), j) for j in range(nranks)])
+        )
+        tensor_out = paddle.zeros([sum(out_sizes), *row], self.dtype)
+        task = pg.all_to_all_single(
+            tensor_out, tensor_in, out_sizes, in_sizes, True
+        )
+        task.wait()
+        expected = np.concatenate(
+            [make_rows(j, pg.rank()) for j in range(nranks)]
+        )
+        np.testing.assert_array_equal(tensor_out.numpy(), expected)
+        print("test all_to_all api ok\n")
+
+        # test allreduce of a tensor larger than a segment, which is split
+        # across the gloo channels
+        big_shape = [1 << 20, 3]
+        inputs = [
+            np.random.random(big_shape).astype(self.dtype)
+            for _ in range(nranks)
+        ]
+        tensor_big = paddle.to_tensor(inputs[pg.rank()])
+        task = pg.all_reduce(tensor_big, core.ReduceOp.SUM, False)
+        task.wait()
+        np.testing.assert_allclose(tensor_big.numpy(), sum(inputs), rtol=1e-5)
+        print("test segmented allreduce api ok\n")
+
 
 if __name__ == "__main__":
     unittest.main()
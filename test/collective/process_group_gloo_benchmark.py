@@ -0,0 +1,129 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Benchmarks the collectives of ProcessGroupGloo between local processes
+over TCP loopback, e.g.
+
+    python process_group_gloo_benchmark.py --nranks 4 --channels 4
+
+AllReduce is measured on a group without channels, which runs one gloo op per
+call, and on a group with --channels channels, which splits the tensors
+larger than --segment_size bytes.
+"""
+
+import argparse
+import multiprocessing
+import os
+import time
+
+import numpy as np
+
+
+def run_collective(fn, iters):
+    fn()
+    start = time.perf_counter()
+    for _ in range(iters):
+        fn()
+    return (time.perf_counter() - start) / iters
+
+
+def worker(rank, args, results):
+    os.environ["GLOO_SOCKET_IFNAME"] = "lo"
+    import paddle
+    from paddle.base import core
+
+    paddle.device.set_device("cpu")
+    nranks = args.nranks
+    store = core.TCPStore("127.0.0.1", args.port, rank == 0, nranks, 60)
+    paddle.set_flags({"FLAGS_gloo_allreduce_channels": 0})
+    pg_single = core.ProcessGroupGloo.create(store, rank, nranks, 0)
+    paddle.set_flags(
+        {
+            "FLAGS_gloo_allreduce_channels": args.channels,
+            "FLAGS_gloo_allreduce_segment_size": args.segment_size,
+        }
+    )
+    pg_channels = core.ProcessGroupGloo.create(store, rank, nranks, 1)
+
+    for size_mb in args.sizes:
+        numel = (size_mb << 20) // 4
+        numel -= numel % nranks
+        x = paddle.to_tensor(np.random.random([numel]).astype("float32"))
+        out = paddle.zeros([numel // nranks], "float32")
+        a2a_out = paddle.zeros([numel], "float32")
+        sizes = [numel // nranks] * nranks
+
+        times = {
+            "allreduce": run_collective(
+                lambda: pg_single.all_reduce(
+                    x, core.ReduceOp.SUM, True
+                ).wait(),
+                args.iters,
+            ),
+            "allreduce_channels": run_collective(
+                lambda: pg_channels.all_reduce(
+                    x, core.ReduceOp.SUM, True
+                ).wait(),
+                args.iters,
+            ),
+            "reduce_scatter": run_collective(
+                lambda: pg_channels.reduce_scatter_tensor(
+                    out, x, core.ReduceOp.SUM, True
+                ).wait(),
+                args.iters,
+            ),
+            "all_to_all": run_collective(
+                lambda: pg_channels.all_to_all_single(
+                    a2a_out, x, sizes, sizes, True
+                ).wait(),
+                args.iters,
+            ),
+        }
+        if rank == 0:
+            results.append((size_mb, times))
+    pg_channels.barrier().wait()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--nranks", type=int, default=4)
+    parser.add_argument("--channels", type=int, default=4)
+    parser.add_argument("--segment_size", type=int, default=4 << 20)
+    parser.add_argument("--sizes", type=int, nargs="+", default=[1, 16, 64])
+    parser.add_argument("--iters", type=int, default=10)
+    parser.add_argument("--port", type=int, default=6279)
+    args = parser.parse_args()
+
+    ctx = multiprocessing.get_context("spawn")
+    manager = ctx.Manager()
+    results = manager.list()
+    procs = [
+        ctx.Process(target=worker, args=(rank, args, results))
+        for rank in range(args.nranks)
+    ]
+    for p in procs:
+        p.start()
+    for p in procs:
+        p.join()
+
+    print(
+        f"{args.nranks} ranks, {args.channels} channels, "
+        f"segment {args.segment_size} bytes, ms per call"
+    )
+    for size_mb, times in results:
+        line = ", ".join(f"{k} {v * 1000:.2f}" for k, v in times.items())
+        print(f"{size_mb} MB: {line}")
+
+
+if __name__ == "__main__":
+    main()
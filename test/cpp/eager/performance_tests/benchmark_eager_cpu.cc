@@ -17,6 +17,7 @@
 #include <paddle/fluid/framework/op_registry.h>
 
 #include <chrono>
+#include <random>
 
 #include "gtest/gtest.h"
 #include "paddle/common/flags.h"
@@ -33,6 +34,8 @@
 
 #include "paddle/phi/core/kernel_registry.h"
 
+COMMON_DECLARE_int32(eager_backward_threads);
+
 using namespace egr;            // NOLINT
 using namespace egr_utils_api;  // NOLINT
 
@@ -245,3 +248,70 @@ TEST(Benchmark, EagerIntermediateMLPCPU) {
     }
   }
 }
+
+static paddle::Tensor CreateRandomTensor(const paddle::framework::DDim& ddim,
+                                         std::mt19937* gen) {
+  paddle::Tensor tensor =
+      eager_test::CreateTensorWithValue(ddim,
+                                        paddle::platform::CPUPlace(),
+                                        phi::DataType::FLOAT32,
+                                        phi::DataLayout::NCHW,
+                                        0.0,
+                                        true);
+  std::uniform_real_distribution<float> dist(-0.1, 0.1);
+  auto* dense = static_cast<phi::DenseTensor*>(tensor.impl().get());
+  float* data = dense->data<float>();
+  for (int64_t i = 0; i < dense->numel(); i++) {
+    data[i] = dist(*gen);
+  }
+  return tensor;
+}
+
+static std::vector<float> GetGrad(const paddle::Tensor& tensor) {
+  AutogradMeta* meta = EagerUtils::unsafe_autograd_meta(tensor);
+  auto grad_dense =
+      std::dynamic_pointer_cast<phi::DenseTensor>(meta->Grad().impl());
+  const float* data = grad_dense->data<float>();
+  return std::vector<float>(data, data + grad_dense->numel());
+}
+
+// Runs the backward of independent towers by the sequential executor and by
+// FLAGS_eager_backward_threads threads, the grads must be the same.
+TEST(Benchmark, EagerParallelBackwardCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+
+  auto tracer = std::make_shared<paddle::imperative::Tracer>();
+  paddle::imperative::SetCurrentTracer(tracer);
+
+  const size_t towers = 8, depth = 20;
+  std::vector<std::vector<float>> expected_grads;
+  for (int threads : {0, 4}) {
+    FLAGS_eager_backward_threads = threads;
+    std::mt19937 gen(0);
+    paddle::framework::DDim ddim = common::make_ddim({128, 128});
+    std::vector<paddle::Tensor> Xs;
+    for (size_t i = 0; i < towers; i++) {
+      Xs.emplace_back(CreateRandomTensor(ddim, &gen));
+      RetainGradForTensor(Xs.back());
+    }
+    paddle::Tensor W = CreateRandomTensor(ddim, &gen);
+    RetainGradForTensor(W);
+
+    double elapsed_time_ms = benchmark_eager_towers(Xs, W, depth);
+    std::cout << "Backward threads: " << threads
+              << ", Duration: " << elapsed_time_ms << " ms" << std::endl;
+
+    std::vector<std::vector<float>> grads;
+    for (const auto& X : Xs) {
+      grads.emplace_back(GetGrad(X));
+    }
+    grads.emplace_back(GetGrad(W));
+    if (expected_grads.empty()) {
+      expected_grads = std::move(grads);
+    } else {
+      ASSERT_EQ(grads, expected_grads);
+    }
+  }
+  FLAGS_eager_backward_threads = 0;
+}
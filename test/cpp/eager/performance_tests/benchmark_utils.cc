@@ -14,6 +14,7 @@
 
 #include "test/cpp/eager/performance_tests/benchmark_utils.h"
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <set>
@@ -152,6 +153,28 @@ void benchmark_eager_intermediate_mlp(const paddle::Tensor& X,
   }
 }
 
+/* -------------------------- */
+/* ---- Eager Towers ---- */
+/* -------------------------- */
+double benchmark_eager_towers(const std::vector<paddle::Tensor>& Xs,
+                              const paddle::Tensor& W,
+                              size_t depth) {
+  paddle::Tensor Out;
+  for (size_t i = 0; i < Xs.size(); i++) {
+    paddle::Tensor input0 = Xs[i];
+    for (size_t j = 0; j < depth; j++) {
+      input0 = matmul_ad_func(input0, W, false, false);
+    }
+    Out = i == 0 ? input0 : add_ad_func(Out, input0);
+  }
+
+  std::vector<paddle::Tensor> target_tensors = {Out};
+  auto t_start = std::chrono::high_resolution_clock::now();
+  Backward(target_tensors, {});
+  auto t_end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::milli>(t_end - t_start).count();
+}
+
 }  // namespace egr
 
 namespace paddle {
@@ -65,6 +65,13 @@ void benchmark_eager_intermediate_mlp(const paddle::Tensor& X,
                                       const std::vector<paddle::Tensor>& Bs,
                                       bool accuracy_check = false);
 
+/* ---- Eager Towers ---- */
+// Out = Sum(Xs[i] x W x ... x W), with depth matmuls of W per tower. Returns
+// the duration of the backward in ms.
+double benchmark_eager_towers(const std::vector<paddle::Tensor>& Xs,
+                              const paddle::Tensor& W,
+                              size_t depth);
+
 }  // namespace egr
 
 namespace paddle {
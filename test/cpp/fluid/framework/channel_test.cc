@@ -0,0 +1,214 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/channel.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(Channel, lock_free_read_write) {
+  auto chan = MakeLockFreeChannel<int>(5);
+  ASSERT_TRUE(chan->LockFree());
+  ASSERT_EQ(chan->Capacity(), 5UL);
+  ASSERT_TRUE(chan->Empty());
+
+  std::vector<int> input = {1, 2, 3, 4};
+  ASSERT_EQ(chan->Write(input), 4UL);
+  ASSERT_EQ(chan->Size(), 4UL);
+
+  std::vector<int> output;
+  ASSERT_EQ(chan->ReadOnce(output, 3), 3UL);
+  ASSERT_EQ(output, std::vector<int>({1, 2, 3}));
+
+  chan->Put(5);
+  chan->Close();
+  ASSERT_TRUE(chan->Closed());
+  ASSERT_FALSE(chan->Put(6));
+
+  // the remaining items can still be read after closed
+  ASSERT_EQ(chan->ReadAll(output), 2UL);
+  ASSERT_EQ(output, std::vector<int>({4, 5}));
+  int val = 0;
+  ASSERT_FALSE(chan->Get(val));
+
+  chan->Open();
+  ASSERT_TRUE(chan->Put(7));
+  ASSERT_TRUE(chan->Get(val));
+  ASSERT_EQ(val, 7);
+}
+
+TEST(Channel, lock_free_move_only) {
+  auto chan = MakeLockFreeChannel<std::unique_ptr<int>>(4);
+  std::vector<std::unique_ptr<int>> input;
+  for (int i = 0; i < 3; ++i) {
+    input.emplace_back(new int(i));
+  }
+  ASSERT_EQ(chan->WriteMove(input.size(), &input[0]), 3UL);
+  ASSERT_EQ(input[0], nullptr);
+  std::unique_ptr<int> val;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(chan->Get(val));
+    ASSERT_EQ(*val, i);
+  }
+}
+
+TEST(Channel, try_write_move) {
+  for (auto chan : {MakeLockFreeChannel<int>(2), MakeChannel<int>(2)}) {
+    std::vector<int> input = {1, 2, 3};
+    // only the items that fit are written, the rest stay in the input
+    ASSERT_EQ(chan->TryWriteMove(input.size(), &input[0]), 2UL);
+    ASSERT_EQ(input[2], 3);
+    ASSERT_EQ(chan->TryWriteMove(1, &input[2]), 0UL);
+    int val = 0;
+    ASSERT_TRUE(chan->Get(val));
+    ASSERT_EQ(val, 1);
+    ASSERT_EQ(chan->TryWriteMove(1, &input[2]), 1UL);
+    chan->Close();
+    ASSERT_EQ(chan->TryWriteMove(1, &input[0]), 0UL);
+  }
+}
+
+TEST(Channel, lock_free_blocking) {
+  auto chan = MakeLockFreeChannel<int>(2);
+  std::atomic<int> written{0};
+  std::thread writer([&]() {
+    for (int i = 0; i < 4; ++i) {
+      chan->Put(i);
+      ++written;
+    }
+  });
+  // the writer is blocked once the channel is full
+  while (written < 2) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_EQ(written, 2);
+  int val = 0;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(chan->Get(val));
+    ASSERT_EQ(val, i);
+  }
+  writer.join();
+
+  // a blocked reader is woken up by Close()
+  std::thread reader([&]() { ASSERT_FALSE(chan->Get(val)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  chan->Close();
+  reader.join();
+}
+
+template <class MakeFunc>
+static double RunChannel(MakeFunc make_channel,
+                         int producer_num,
+                         int consumer_num,
+                         int item_num) {
+  Channel<int64_t> chan = make_channel();
+  chan->SetBlockSize(64);
+  std::atomic<int64_t> sum{0};
+  std::atomic<int64_t> count{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < consumer_num; ++c) {
+    consumers.emplace_back([&]() {
+      ChannelReader<int64_t> reader(chan.get());
+      int64_t val = 0;
+      int64_t local_sum = 0;
+      int64_t local_count = 0;
+      while (reader >> val) {
+        local_sum += val;
+        ++local_count;
+      }
+      sum += local_sum;
+      count += local_count;
+    });
+  }
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producer_num; ++p) {
+    producers.emplace_back([&, p]() {
+      ChannelWriter<int64_t> writer(chan.get());
+      for (int64_t i = p; i < item_num; i += producer_num) {
+        writer << i;
+      }
+      writer.Flush();
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  chan->Close();
+  for (auto& t : consumers) {
+    t.join();
+  }
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  EXPECT_EQ(count, item_num);
+  EXPECT_EQ(sum, static_cast<int64_t>(item_num) * (item_num - 1) / 2);
+  return ms;
+}
+
+TEST(Channel, mpmc) {
+  for (int threads : {1, 4}) {
+    RunChannel([]() { return MakeLockFreeChannel<int64_t>(100); },
+               threads,
+               threads,
+               100000);
+    RunChannel(
+        []() {
+          auto chan = MakeChannel<int64_t>();
+          chan->SetCapacity(100);
+          return chan;
+        },
+        threads,
+        threads,
+        100000);
+  }
+}
+
+// Compare the lock-free channel with the mutex channel of the same capacity
+// when many threads write and read small blocks.
+TEST(Channel, benchmark) {
+  const int item_num = 2000000;
+  const size_t capacity = 4096;
+  int threads = static_cast<int>(
+      (std::max)(std::thread::hardware_concurrency() / 2, 2U));
+  double mutex_ms = RunChannel(
+      [&]() {
+        auto chan = MakeChannel<int64_t>();
+        chan->SetCapacity(capacity);
+        return chan;
+      },
+      threads,
+      threads,
+      item_num);
+  double lock_free_ms =
+      RunChannel([&]() { return MakeLockFreeChannel<int64_t>(capacity); },
+                 threads,
+                 threads,
+                 item_num);
+  LOG(INFO) << item_num << " items with " << threads
+            << " producers and consumers, mutex channel: " << mutex_ms
+            << " ms, lock-free channel: " << lock_free_ms << " ms";
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -41,8 +41,11 @@ TEST(NaiveExecutor, Basic) {
   add->SetOutput("Out", {"c"});
 
   auto place = platform::CPUPlace();
+  Scope scope;
+  auto* sub_scope = &scope.NewScope();
   NaiveExecutor exe(place);
-  exe.Prepare(nullptr, program, 0, false);
+  exe.CreateVariables(program, 0, false, sub_scope);
+  exe.Prepare(sub_scope, program, 0);
   auto* a_tensor = exe.FindTensor("a");
   auto* b_tensor = exe.FindTensor("b");
   auto* c_tensor = exe.FindTensor("c");
@@ -67,6 +70,77 @@ TEST(NaiveExecutor, Basic) {
   }
 }
 
+// Two adds whose outputs are placed in the static arena. The runs alternate
+// between the input shapes of two buckets, once both are planned the arena
+// serves them without allocating the tensors again.
+TEST(NaiveExecutor, StaticArenaBuckets) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  for (auto name : {"a", "b", "c", "d"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  auto* add = main_block->AppendOp();
+  add->SetType("elementwise_add");
+  add->SetInput("X", {"a"});
+  add->SetInput("Y", {"b"});
+  add->SetOutput("Out", {"c"});
+  add = main_block->AppendOp();
+  add->SetType("elementwise_add");
+  add->SetInput("X", {"c"});
+  add->SetInput("Y", {"b"});
+  add->SetOutput("Out", {"d"});
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  auto* sub_scope = &scope.NewScope();
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, sub_scope);
+  exe.Prepare(sub_scope, program, 0);
+  exe.MakeArenaPlan({"c", "d"});
+  auto* c_tensor = exe.FindTensor("c");
+  auto* d_tensor = exe.FindTensor("d");
+
+  auto run = [&](uint64_t bucket, int rows) {
+    for (auto name : {"a", "b"}) {
+      auto* tensor = exe.FindTensor(name);
+      tensor->Resize({rows, 4});
+      std::fill_n(tensor->mutable_data<float>(place), rows * 4, 1.0f);
+    }
+    exe.SetArenaBucket(bucket);
+    exe.Run();
+    const float* d_data = d_tensor->data<float>();
+    for (int i = 0; i < rows * 4; i++) {
+      ASSERT_FLOAT_EQ(d_data[i], 3.0f);
+    }
+  };
+
+  // the first run of each bucket plans the arena for it
+  run(1, 1);
+  run(2, 256);
+  auto c_holder = c_tensor->Holder();
+  auto d_holder = d_tensor->Holder();
+  ASSERT_GE(c_holder->size(), 256 * 4 * sizeof(float));
+  // c and d are live together in the second add
+  ASSERT_NE(c_holder->ptr(), d_holder->ptr());
+  for (int i = 0; i < 2 * NaiveExecutor::kArenaShrinkRuns; ++i) {
+    run(1 + i % 2, i % 2 ? 256 : 1);
+    ASSERT_EQ(c_tensor->Holder(), c_holder);
+    ASSERT_EQ(d_tensor->Holder(), d_holder);
+  }
+
+  // the small bucket alone shrinks the arena, then the large one grows it
+  // before its run
+  for (int i = 0; i < NaiveExecutor::kArenaShrinkRuns; ++i) {
+    run(1, 1);
+  }
+  ASSERT_LT(c_tensor->Holder()->size(), c_holder->size());
+  run(2, 256);
+  c_holder = c_tensor->Holder();
+  ASSERT_GE(c_holder->size(), 256 * 4 * sizeof(float));
+  run(2, 256);
+  ASSERT_EQ(c_tensor->Holder(), c_holder);
+}
+
 }  // namespace framework
 }  // namespace paddle
 
@@ -15,7 +15,9 @@
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
 
 #include <atomic>
+#include <chrono>
 #include <thread>
+#include <vector>
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -204,3 +206,65 @@ TEST(WorkQueue, TestWorkQueueGroup) {
   queue_group.reset();
   waiter_thread.join();
 }
+
+TEST(WorkQueue, TestPriorityWorkQueueGroup) {
+  using paddle::framework::CreateWorkQueueGroup;
+  using paddle::framework::EventsWaiter;
+  using paddle::framework::WorkQueueGroup;
+  using paddle::framework::WorkQueueOptions;
+  using paddle::framework::WorkQueueStats;
+  EventsWaiter events_waiter;
+  WorkQueueOptions sq_options(/*name*/ "SingleThreadedPriorityQueue",
+                              /*num_threads*/ 1,
+                              /*allow_spinning*/ true,
+                              /*always_spinning*/ false,
+                              /*track_task*/ true,
+                              /*detached*/ true,
+                              &events_waiter);
+  sq_options.priority_scheduling = true;
+  WorkQueueOptions mq_options(/*name*/ "MultiThreadedPriorityQueue",
+                              /*num_threads*/ 4,
+                              /*allow_spinning*/ true,
+                              /*always_spinning*/ false,
+                              /*track_task*/ true,
+                              /*detached*/ true,
+                              &events_waiter);
+  mq_options.priority_scheduling = true;
+  auto queue_group = CreateWorkQueueGroup({sq_options, mq_options});
+  EXPECT_EQ(queue_group->QueueNumThreads(0), 1u);
+  EXPECT_EQ(queue_group->QueueNumThreads(1), 4u);
+  EXPECT_EQ(queue_group->QueueGroupNumThreads(), 5u);
+
+  // Block the single worker, then the pending tasks run in priority order.
+  std::promise<void> gate;
+  std::shared_future<void> gate_future = gate.get_future().share();
+  queue_group->AddTaskWithPriority(0, -1, [gate_future]() {
+    gate_future.wait();
+  });
+  std::vector<int64_t> order;
+  for (int64_t priority : {5, 3, 9, 1, 3, 7}) {
+    queue_group->AddTaskWithPriority(
+        0, priority, [&order, priority]() { order.push_back(priority); });
+  }
+  gate.set_value();
+  events_waiter.WaitEvent();
+  EXPECT_EQ(order, std::vector<int64_t>({1, 3, 3, 5, 7, 9}));
+
+  // Tasks added by a worker can be stolen by the other workers.
+  constexpr unsigned kTaskNum = 1000;
+  std::atomic<unsigned> counter{0};
+  queue_group->AddTaskWithPriority(1, 0, [&]() {
+    for (unsigned i = 0; i < kTaskNum; ++i) {
+      queue_group->AddTaskWithPriority(1, i, [&counter]() {
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+        ++counter;
+      });
+    }
+  });
+  events_waiter.WaitEvent();
+  EXPECT_EQ(counter.load(), kTaskNum);
+  WorkQueueStats stats = queue_group->QueueStats(1);
+  EXPECT_GE(stats.executed_tasks, kTaskNum);
+  EXPECT_GT(stats.stolen_tasks, 0u);
+  queue_group->Cancel();
+}
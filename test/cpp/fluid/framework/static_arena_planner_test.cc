@@ -0,0 +1,93 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/static_arena_planner.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(StaticArenaPlanner, chain) {
+  // a -> b -> c -> d, every tensor is read by the next op only
+  std::vector<ArenaBlock> blocks = {
+      {1000, 0, 1, 0}, {500, 1, 2, 0}, {1000, 2, 3, 0}, {300, 3, 4, 0}};
+  size_t arena_size = PlanStaticArena(&blocks, 256);
+  // c takes the place of a once it is dead
+  EXPECT_EQ(blocks[0].offset, blocks[2].offset);
+  EXPECT_EQ(arena_size, 1024UL + 512UL);
+  EXPECT_EQ(blocks[1].offset, 1024UL);
+  EXPECT_EQ(blocks[3].offset, 1024UL);
+}
+
+TEST(StaticArenaPlanner, best_fit) {
+  // once a and c are dead, e takes the gap of c between b and d rather than
+  // the larger one of a
+  std::vector<ArenaBlock> blocks = {{1024, 0, 0, 0},
+                                    {256, 0, 3, 0},
+                                    {256, 0, 0, 0},
+                                    {256, 0, 3, 0},
+                                    {200, 1, 3, 0},
+                                    {0, 0, 3, 0}};
+  size_t arena_size = PlanStaticArena(&blocks, 256);
+  EXPECT_EQ(arena_size, 1024UL + 768UL);
+  EXPECT_EQ(blocks[2].offset, 1280UL);
+  EXPECT_EQ(blocks[4].offset, blocks[2].offset);
+  EXPECT_EQ(blocks[5].offset, 0UL);
+}
+
+TEST(StaticArenaPlanner, random) {
+  std::mt19937 gen(0);
+  for (int round = 0; round < 100; ++round) {
+    std::vector<ArenaBlock> blocks(gen() % 100);
+    for (auto& block : blocks) {
+      block.size = gen() % 10000;
+      block.begin = gen() % 50;
+      block.end = block.begin + gen() % 10;
+    }
+    size_t arena_size = PlanStaticArena(&blocks, 64);
+    // at least the largest sum of the live blocks of an op
+    size_t max_live = 0;
+    for (int op = 0; op < 60; ++op) {
+      size_t live = 0;
+      for (auto& block : blocks) {
+        if (block.begin <= op && op <= block.end) {
+          live += (block.size + 63) / 64 * 64;
+        }
+      }
+      max_live = std::max(max_live, live);
+    }
+    EXPECT_GE(arena_size, max_live);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      ASSERT_EQ(blocks[i].offset % 64, 0UL);
+      ASSERT_LE(blocks[i].offset + blocks[i].size, arena_size);
+      for (size_t j = i + 1; j < blocks.size(); ++j) {
+        const auto& a = blocks[i];
+        const auto& b = blocks[j];
+        if (a.size == 0 || b.size == 0 || a.end < b.begin || b.end < a.begin) {
+          continue;
+        }
+        ASSERT_TRUE(a.offset + a.size <= b.offset ||
+                    b.offset + b.size <= a.offset);
+      }
+    }
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
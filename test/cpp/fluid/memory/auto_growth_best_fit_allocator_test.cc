@@ -15,9 +15,12 @@
 #include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
 
 #include <cstdlib>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/memory/allocation/aligned_allocator.h"
+#include "paddle/fluid/memory/stats.h"
 
 PD_DECLARE_bool(free_idle_chunk);
 PD_DECLARE_bool(free_when_no_cache_hit);
@@ -27,10 +30,14 @@ namespace memory {
 namespace allocation {
 
 class RecordedAllocator : public Allocator {
+ public:
+  RecordedAllocator() = default;
+  explicit RecordedAllocator(const platform::Place &place) : place_(place) {}
+
  protected:
   phi::Allocation *AllocateImpl(size_t size) override {
     allocated_size_ += size;
-    return new Allocation(malloc(size), size, platform::CPUPlace());  // NOLINT
+    return new Allocation(malloc(size), size, place_);  // NOLINT
   }
 
   void FreeImpl(phi::Allocation *allocation) override {
@@ -43,6 +50,7 @@ class RecordedAllocator : public Allocator {
   size_t AllocatedSize() const { return allocated_size_; }
 
  private:
+  platform::Place place_{platform::CPUPlace()};
   size_t allocated_size_{0};
 };
 
@@ -171,6 +179,54 @@ TEST(test_auto_growth_allocator, test_free_when_no_cache_hit) {
   TestFreeWhenNoCacheHit(true);
 }
 
+TEST(test_auto_growth_allocator, test_lock_counters) {
+  auto recorded_allocator = std::make_shared<RecordedAllocator>();
+  auto ag_allocator =
+      std::make_shared<AutoGrowthBestFitAllocator>(recorded_allocator, 256);
+  // the allocator knows its place after its first chunk
+  ag_allocator->Allocate(1024);
+
+  int64_t acquire = HostMemoryStatCurrentValue("AllocatorLockAcquire", 0);
+  int64_t contention =
+      HostMemoryStatCurrentValue("AllocatorLockContention", 0);
+  constexpr int kThreads = 4;
+  constexpr int kIters = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&ag_allocator]() {
+      for (int i = 0; i < kIters; ++i) {
+        ag_allocator->Allocate(1024);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // Every Allocate and Free takes the lock once, and the values of the
+  // exited threads are kept.
+  ASSERT_GE(HostMemoryStatCurrentValue("AllocatorLockAcquire", 0),
+            acquire + 2 * kThreads * kIters);
+  ASSERT_GE(HostMemoryStatCurrentValue("AllocatorLockContention", 0),
+            contention);
+  ASSERT_LE(HostMemoryStatCurrentValue("AllocatorLockContention", 0) -
+                contention,
+            HostMemoryStatCurrentValue("AllocatorLockAcquire", 0) - acquire);
+}
+
+TEST(test_auto_growth_allocator, test_lock_counters_of_device_place) {
+  auto recorded_allocator =
+      std::make_shared<RecordedAllocator>(platform::CUDAPlace(0));
+  auto ag_allocator =
+      std::make_shared<AutoGrowthBestFitAllocator>(recorded_allocator, 256);
+
+  int64_t acquire = HostMemoryStatCurrentValue("AllocatorLockAcquire", 0);
+  for (int i = 0; i < 100; ++i) {
+    ag_allocator->Allocate(1024);
+  }
+  // the locks of a device allocator are not host stats
+  ASSERT_EQ(HostMemoryStatCurrentValue("AllocatorLockAcquire", 0), acquire);
+}
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
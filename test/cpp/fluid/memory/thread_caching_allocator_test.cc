@@ -0,0 +1,165 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_caching_allocator.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/stats.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+class CountedAllocator : public Allocator {
+ public:
+  bool IsAllocThreadSafe() const override { return true; }
+
+  int64_t AllocatedSize() const { return allocated_size_; }
+
+  int64_t AllocateTimes() const { return allocate_times_; }
+
+ protected:
+  phi::Allocation *AllocateImpl(size_t size) override {
+    allocated_size_ += static_cast<int64_t>(size);
+    ++allocate_times_;
+    return new Allocation(malloc(size), size, platform::CPUPlace());  // NOLINT
+  }
+
+  void FreeImpl(phi::Allocation *allocation) override {
+    allocated_size_ -= static_cast<int64_t>(allocation->size());
+    free(allocation->ptr());  // NOLINT
+    delete allocation;
+  }
+
+ private:
+  std::atomic<int64_t> allocated_size_{0};
+  std::atomic<int64_t> allocate_times_{0};
+};
+
+TEST(ThreadCachingAllocator, size_class) {
+  size_t max_size = 4 << 20;
+  size_t num_classes = ThreadCachingAllocator::SizeClassIndex(max_size) + 1;
+  size_t prev_bytes = 0;
+  for (size_t i = 0; i < num_classes; ++i) {
+    size_t bytes = ThreadCachingAllocator::SizeClassBytes(i);
+    ASSERT_GT(bytes, prev_bytes);
+    ASSERT_EQ(bytes % ThreadCachingAllocator::kMinClassBytes, 0UL);
+    ASSERT_EQ(ThreadCachingAllocator::SizeClassIndex(bytes), i);
+    ASSERT_EQ(ThreadCachingAllocator::SizeClassIndex(prev_bytes + 1), i);
+    // the internal fragmentation is at most 25%
+    ASSERT_LE(bytes, (prev_bytes + 1) * 5 / 4 + 64);
+    prev_bytes = bytes;
+  }
+  ASSERT_EQ(ThreadCachingAllocator::SizeClassIndex(0), 0UL);
+}
+
+TEST(ThreadCachingAllocator, reuse_in_thread) {
+  auto underlying_allocator = std::make_shared<CountedAllocator>();
+  auto allocator = std::make_shared<ThreadCachingAllocator>(
+      underlying_allocator, 1 << 20, 1 << 20);
+
+  int64_t hit = HostMemoryStatCurrentValue("ThreadCacheHit", 0);
+  auto allocation = allocator->Allocate(1000);
+  ASSERT_GE(allocation->size(), 1000UL);
+  void *ptr = allocation->ptr();
+  allocation.reset();
+  ASSERT_EQ(underlying_allocator->AllocateTimes(), 1);
+
+  allocation = allocator->Allocate(1020);
+  ASSERT_EQ(allocation->ptr(), ptr);
+  ASSERT_EQ(underlying_allocator->AllocateTimes(), 1);
+  ASSERT_EQ(HostMemoryStatCurrentValue("ThreadCacheHit", 0), hit + 1);
+  allocation.reset();
+
+  // large allocations are not cached
+  allocation = allocator->Allocate(2 << 20);
+  allocation.reset();
+  ASSERT_EQ(underlying_allocator->AllocatedSize(),
+            static_cast<int64_t>(allocator->CachedBytes()));
+
+  allocator->Release(platform::CPUPlace());
+  ASSERT_EQ(allocator->CachedBytes(), 0UL);
+  ASSERT_EQ(underlying_allocator->AllocatedSize(), 0);
+}
+
+TEST(ThreadCachingAllocator, bounded_thread_cache) {
+  auto underlying_allocator = std::make_shared<CountedAllocator>();
+  size_t max_thread_cache_bytes = 64 << 10;
+  auto allocator = std::make_shared<ThreadCachingAllocator>(
+      underlying_allocator, 1 << 20, max_thread_cache_bytes);
+
+  int64_t flush = HostMemoryStatCurrentValue("ThreadCacheFlush", 0);
+  std::vector<AllocationPtr> allocations;
+  for (size_t i = 0; i < 1024; ++i) {
+    allocations.emplace_back(allocator->Allocate(4096));
+  }
+  allocations.clear();
+  ASSERT_GT(HostMemoryStatCurrentValue("ThreadCacheFlush", 0), flush);
+  // The rest is either in the central lists or returned to the underlying
+  // allocator.
+  ASSERT_LE(allocator->CachedBytes(),
+            static_cast<size_t>(underlying_allocator->AllocatedSize()));
+  ASSERT_LT(underlying_allocator->AllocatedSize(), 1024 * 4096);
+
+  allocator.reset();
+  ASSERT_EQ(underlying_allocator->AllocatedSize(), 0);
+}
+
+TEST(ThreadCachingAllocator, multi_thread) {
+  auto underlying_allocator = std::make_shared<CountedAllocator>();
+  auto allocator = std::make_shared<ThreadCachingAllocator>(
+      underlying_allocator, 1 << 20, 1 << 20);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&allocator, t]() {
+      std::vector<AllocationPtr> allocations;
+      for (int i = 0; i < 2000; ++i) {
+        size_t size = ((i * 7 + t) % 64 + 1) * 100;
+        allocations.emplace_back(allocator->Allocate(size));
+        memset(allocations.back()->ptr(), t, size);
+        if (allocations.size() > 16) {
+          allocations.erase(allocations.begin());
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // the caches of exited threads are drained into the central lists
+  ASSERT_EQ(static_cast<int64_t>(allocator->CachedBytes()),
+            underlying_allocator->AllocatedSize());
+  allocator->Release(platform::CPUPlace());
+  ASSERT_EQ(underlying_allocator->AllocatedSize(), 0);
+}
+
+TEST(ThreadCachingAllocator, counter_survives_thread_exit) {
+  int64_t hit = HostMemoryStatCurrentValue("ThreadCacheHit", 0);
+  std::thread thread([]() { HostMemoryStatUpdate("ThreadCacheHit", 0, 3); });
+  thread.join();
+  // the value of the exited thread is folded into the counter
+  ASSERT_EQ(HostMemoryStatCurrentValue("ThreadCacheHit", 0), hit + 3);
+  HostMemoryStatUpdate("ThreadCacheHit", 0, 2);
+  ASSERT_EQ(HostMemoryStatCurrentValue("ThreadCacheHit", 0), hit + 5);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -17,11 +17,19 @@ limitations under the License. */
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/io/mmap_params.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/float16.h"
 #include "paddle/phi/core/kernel_registry.h"
 
+#ifndef _WIN32
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#endif
+
+COMMON_DECLARE_bool(load_combine_use_mmap);
+
 USE_OP_ITSELF(save_combine);
 USE_OP_ITSELF(load_combine);
 PD_DECLARE_KERNEL(save_combine_tensor, CPU, ALL_LAYOUT);
@@ -373,3 +381,71 @@ TEST(SaveLoadTestWithCombineOp, CPU) {
     }
   }
 }
+
+#ifndef _WIN32
+// Save tensors, align the params file and load both the original and the
+// aligned file with load_combine mapping the file.
+TEST(LoadCombineMmapOp, CPU) {
+  paddle::framework::Scope scope;
+  paddle::platform::CPUPlace place;
+
+  std::vector<std::string> names = {"test_var1", "test_var2", "test_var3"};
+  std::vector<std::vector<int>> lods = {{0, 1, 10}, {0, 3, 20}, {0, 7}};
+  std::vector<int> rows = {10, 20, 7};
+  std::vector<int> cols = {3, 50, 1};
+  std::vector<float*> expects;
+  std::vector<paddle::framework::LoD> expect_lods(names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    expects.push_back(CreateForSaveCombineOp<float, float>(
+        rows[i], cols[i], lods[i], names[i], place, &scope, &expect_lods[i]));
+  }
+
+  std::string filename = "check_tensor_mmap.ls";
+  std::string aligned_filename = "check_tensor_mmap_aligned.ls";
+  paddle::framework::AttributeMap attrs;
+  attrs.insert({"file_path", filename});
+  auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", names}}, {}, attrs);
+  save_combine_op->Run(scope, place);
+  EXPECT_EQ(paddle::framework::AlignCombinedParamsFile(filename,
+                                                       aligned_filename),
+            names.size());
+
+  FLAGS_load_combine_use_mmap = true;
+  for (auto& file : {filename, aligned_filename}) {
+    std::vector<std::string> out_names;
+    for (auto& name : names) {
+      out_names.push_back(name + "_" + file);
+      GeneratePlaceholderBeforeLoad(out_names.back(), &scope);
+    }
+    paddle::framework::AttributeMap load_attrs;
+    load_attrs.insert({"file_path", file});
+    auto load_combine_op = paddle::framework::OpRegistry::CreateOp(
+        "load_combine", {}, {{"Out", out_names}}, load_attrs);
+    load_combine_op->Run(scope, place);
+
+    for (size_t i = 0; i < names.size(); ++i) {
+      auto* target =
+          scope.FindVar(out_names[i])->GetMutable<phi::DenseTensor>();
+      paddle::framework::LoD actual_lod;
+      float* actual = GetValuesAfterLoadCombineOp<float>(
+          target, scope, &actual_lod);
+      CheckValues<float, float>(expects[i],
+                                actual,
+                                expect_lods[i],
+                                actual_lod,
+                                rows[i] * cols[i]);
+      bool mapped =
+          dynamic_cast<paddle::memory::allocation::MappedFileAllocation*>(
+              target->Holder().get()) != nullptr;
+      // all the tensors of the aligned file alias the mapping
+      if (file == aligned_filename) {
+        EXPECT_TRUE(mapped);
+      }
+    }
+  }
+  FLAGS_load_combine_use_mmap = false;
+  remove(filename.c_str());
+  remove(aligned_filename.c_str());
+}
+#endif
@@ -20,6 +20,9 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <fstream>
+#include <functional>
+#include <numeric>
 #include <thread>  // NOLINT
 
 #include "paddle/fluid/framework/ir/pass.h"
@@ -475,6 +478,190 @@ TEST(Predictor, Run) {
   predictor->TryShrinkMemory();
 }
 
+// Runs the word2vec model of the batch size on the same ids by the
+// predictor, and returns the output.
+std::vector<float> RunWord2vec(Predictor* predictor, int batch_size) {
+  for (auto& name : predictor->GetInputNames()) {
+    auto input = predictor->GetInputHandle(name);
+    std::vector<int64_t> ids(batch_size);
+    for (int i = 0; i < batch_size; i++) {
+      ids[i] = i;
+    }
+    input->Reshape({batch_size, 1});
+    input->CopyFromCpu(ids.data());
+  }
+  predictor->Run();
+  auto out = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  auto shape = out->shape();
+  EXPECT_EQ(shape[0], batch_size);
+  std::vector<float> out_data(std::accumulate(
+      shape.begin(), shape.end(), 1, std::multiplies<int>()));
+  out->CopyToCpu(out_data.data());
+  return out_data;
+}
+
+TEST(Predictor, ShapeBucketing) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  auto predictor = CreatePredictor(config);
+  config.EnableShapeBucketing({8, 16}, 0);
+  ASSERT_TRUE(config.shape_bucketing_enabled());
+  auto bucketed = CreatePredictor(config);
+
+  // the batch of 4 is padded to 8 and the output is sliced back
+  for (int batch_size : {4, 8, 11, 4, 20}) {
+    auto expected = RunWord2vec(predictor.get(), batch_size);
+    auto out = RunWord2vec(bucketed.get(), batch_size);
+    ASSERT_EQ(out.size(), expected.size());
+    for (size_t i = 0; i < out.size(); i++) {
+      EXPECT_NEAR(out[i], expected[i], 1e-5);
+    }
+  }
+  auto hits = bucketed->GetShapeBucketHits();
+  ASSERT_EQ(hits.size(), 3UL);
+  EXPECT_EQ(hits[8], 3UL);
+  EXPECT_EQ(hits[16], 1UL);
+  EXPECT_EQ(hits[-1], 1UL);
+  EXPECT_TRUE(predictor->GetShapeBucketHits().empty());
+}
+
+TEST(Predictor, ShapeBucketingOutputNames) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  // no output is named, so the output keeps the padded length
+  config.EnableShapeBucketing({8}, 0, {}, {"not_an_output"});
+  auto predictor = CreatePredictor(config);
+  std::vector<int64_t> ids(4);
+  std::iota(ids.begin(), ids.end(), 0);
+  for (auto& name : predictor->GetInputNames()) {
+    auto input = predictor->GetInputHandle(name);
+    input->Reshape({4, 1});
+    input->CopyFromCpu(ids.data());
+  }
+  predictor->Run();
+  // the inputs are given back to the user unpadded
+  for (auto& name : predictor->GetInputNames()) {
+    EXPECT_EQ(predictor->GetInputHandle(name)->shape()[0], 4);
+  }
+  auto out = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  EXPECT_EQ(out->shape()[0], 8);
+}
+
+// Writes to dir a model of the inputs x and y of [2, -1] and z of [2, 3],
+// whose outputs are x + y and z + z.
+void SaveShapeBucketingAxis1Model(const std::string& dir) {
+  using paddle::framework::proto::VarType;
+  paddle::framework::proto::ProgramDesc program;
+  program.mutable_version()->set_version(0);
+  auto* block = program.add_blocks();
+  block->set_idx(0);
+  block->set_parent_idx(-1);
+  auto add_var = [&](const std::string& name,
+                     VarType::Type type,
+                     const std::vector<int64_t>& dims) {
+    auto* var = block->add_vars();
+    var->set_name(name);
+    var->mutable_type()->set_type(type);
+    if (type == VarType::LOD_TENSOR) {
+      auto* tensor =
+          var->mutable_type()->mutable_lod_tensor()->mutable_tensor();
+      tensor->set_data_type(VarType::FP32);
+      for (auto dim : dims) {
+        tensor->add_dims(dim);
+      }
+    } else {
+      var->set_persistable(true);
+    }
+  };
+  auto add_op = [&](const std::string& type,
+                    const std::vector<std::pair<std::string, std::string>>& in,
+                    const std::pair<std::string, std::string>& out,
+                    int col) {
+    auto* op = block->add_ops();
+    op->set_type(type);
+    for (auto& item : in) {
+      auto* var = op->add_inputs();
+      var->set_parameter(item.first);
+      var->add_arguments(item.second);
+    }
+    auto* var = op->add_outputs();
+    var->set_parameter(out.first);
+    var->add_arguments(out.second);
+    if (col >= 0) {
+      auto* attr = op->add_attrs();
+      attr->set_name("col");
+      attr->set_type(paddle::framework::proto::AttrType::INT);
+      attr->set_i(col);
+    }
+  };
+  add_var("feed", VarType::FEED_MINIBATCH, {});
+  add_var("fetch", VarType::FETCH_LIST, {});
+  add_var("x", VarType::LOD_TENSOR, {2, -1});
+  add_var("y", VarType::LOD_TENSOR, {2, -1});
+  add_var("z", VarType::LOD_TENSOR, {2, 3});
+  add_var("x_y", VarType::LOD_TENSOR, {2, -1});
+  add_var("z_z", VarType::LOD_TENSOR, {2, 3});
+  add_op("feed", {{"X", "feed"}}, {"Out", "x"}, 0);
+  add_op("feed", {{"X", "feed"}}, {"Out", "y"}, 1);
+  add_op("feed", {{"X", "feed"}}, {"Out", "z"}, 2);
+  add_op("elementwise_add", {{"X", "x"}, {"Y", "y"}}, {"Out", "x_y"}, -1);
+  add_op("elementwise_add", {{"X", "z"}, {"Y", "z"}}, {"Out", "z_z"}, -1);
+  add_op("fetch", {{"X", "x_y"}}, {"Out", "fetch"}, 0);
+  add_op("fetch", {{"X", "z_z"}}, {"Out", "fetch"}, 1);
+
+  MKDIR(dir.c_str());
+  std::ofstream fout(dir + "/__model__", std::ios::out | std::ios::binary);
+  fout << program.SerializeAsString();
+}
+
+// The bucket of the axis 1 is taken by the variable inputs only, the fixed z
+// of the length 3 is neither padded to the bucket 4 nor counted in the length
+// of the run.
+TEST(Predictor, ShapeBucketingAxis1) {
+  std::string dir = "shape_bucketing_axis1_model";
+  SaveShapeBucketingAxis1Model(dir);
+  Config config;
+  config.SetModel(dir);
+  config.SwitchIrOptim(false);
+  config.EnableShapeBucketing({4, 8}, 1);
+  auto predictor = CreatePredictor(config);
+
+  std::vector<float> z_data(6);
+  std::iota(z_data.begin(), z_data.end(), 0.f);
+  for (int len : {2, 4, 3}) {
+    std::vector<float> x_data(2 * len);
+    std::iota(x_data.begin(), x_data.end(), 1.f);
+    for (auto& name : {"x", "y"}) {
+      auto input = predictor->GetInputHandle(name);
+      input->Reshape({2, len});
+      input->CopyFromCpu(x_data.data());
+    }
+    auto z = predictor->GetInputHandle("z");
+    z->Reshape({2, 3});
+    z->CopyFromCpu(z_data.data());
+    ASSERT_TRUE(predictor->Run());
+
+    auto x_y = predictor->GetOutputHandle("x_y");
+    ASSERT_EQ(x_y->shape(), std::vector<int>({2, len}));
+    std::vector<float> x_y_data(2 * len);
+    x_y->CopyToCpu(x_y_data.data());
+    for (int i = 0; i < 2 * len; i++) {
+      EXPECT_EQ(x_y_data[i], 2 * x_data[i]);
+    }
+    auto z_z = predictor->GetOutputHandle("z_z");
+    ASSERT_EQ(z_z->shape(), std::vector<int>({2, 3}));
+    std::vector<float> z_z_data(6);
+    z_z->CopyToCpu(z_z_data.data());
+    for (int i = 0; i < 6; i++) {
+      EXPECT_EQ(z_z_data[i], 2 * z_data[i]);
+    }
+    EXPECT_EQ(z->shape(), std::vector<int>({2, 3}));
+  }
+  auto hits = predictor->GetShapeBucketHits();
+  ASSERT_EQ(hits.size(), 1UL);
+  EXPECT_EQ(hits[4], 3UL);
+}
+
 TEST(Predictor, EnableONNXRuntime) {
   Config config;
   config.SetModel(FLAGS_dirname);
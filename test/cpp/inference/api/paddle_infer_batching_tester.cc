@@ -0,0 +1,212 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <thread>
+
+#include "paddle/common/flags.h"
+#include "test/cpp/inference/api/tester_helper.h"
+
+PD_DEFINE_int32(batching_client_num, 8, "The number of client threads.");
+PD_DEFINE_int32(batching_request_num,
+                16,
+                "The number of requests of every client.");
+
+namespace paddle_infer {
+
+static Config GetBatchingConfig() {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.DisableGpu();
+  config.SetCpuMathLibraryNumThreads(1);
+  return config;
+}
+
+static const std::vector<int> kSampleShape = {3, 224, 224};
+
+static int SampleNumel() {
+  return std::accumulate(
+      kSampleShape.begin(), kSampleShape.end(), 1, std::multiplies<int>());
+}
+
+static paddle::PaddleTensor MakeRequest(int batch_size, int seed) {
+  paddle::PaddleTensor tensor;
+  tensor.shape = {batch_size};
+  tensor.shape.insert(
+      tensor.shape.end(), kSampleShape.begin(), kSampleShape.end());
+  tensor.dtype = paddle::PaddleDType::FLOAT32;
+  tensor.data.Resize(batch_size * SampleNumel() * sizeof(float));
+  float* data = static_cast<float*>(tensor.data.data());
+  for (int i = 0; i < batch_size * SampleNumel(); ++i) {
+    data[i] = static_cast<float>((i + seed) % 255) / 255.f;
+  }
+  return tensor;
+}
+
+static std::vector<float> RunDirectly(Predictor* predictor,
+                                      const paddle::PaddleTensor& input) {
+  auto input_t = predictor->GetInputHandle(predictor->GetInputNames()[0]);
+  input_t->Reshape(input.shape);
+  input_t->CopyFromCpu(static_cast<const float*>(input.data.data()));
+  predictor->Run();
+  auto output_t = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  std::vector<int> output_shape = output_t->shape();
+  std::vector<float> output(std::accumulate(output_shape.begin(),
+                                            output_shape.end(),
+                                            1,
+                                            std::multiplies<int>()));
+  output_t->CopyToCpu(output.data());
+  return output;
+}
+
+TEST(BatchingPredictor, outputs) {
+  Config config = GetBatchingConfig();
+  auto predictor = CreatePredictor(config);
+
+  services::BatchingOptions options;
+  options.num_predictors = 2;
+  options.max_batch_size = 4;
+  options.max_wait_us = 20000;
+  services::BatchingPredictor batching(config, options);
+  ASSERT_EQ(batching.GetInputNames(), predictor->GetInputNames());
+  ASSERT_EQ(batching.GetOutputNames(), predictor->GetOutputNames());
+
+  // requests of different sizes are coalesced, and the outputs of every
+  // request are the same as running it alone
+  const std::vector<int> batch_sizes = {1, 2, 1, 3, 1};
+  std::vector<std::vector<paddle::PaddleTensor>> outputs(batch_sizes.size());
+  std::vector<std::thread> clients;
+  for (size_t i = 0; i < batch_sizes.size(); ++i) {
+    clients.emplace_back([&, i]() {
+      auto input = MakeRequest(batch_sizes[i], i);
+      ASSERT_TRUE(batching.Run({input}, &outputs[i]));
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  for (size_t i = 0; i < batch_sizes.size(); ++i) {
+    auto expected =
+        RunDirectly(predictor.get(), MakeRequest(batch_sizes[i], i));
+    ASSERT_EQ(outputs[i].size(), batching.GetOutputNames().size());
+    ASSERT_EQ(outputs[i][0].shape[0], batch_sizes[i]);
+    ASSERT_EQ(outputs[i][0].data.length(), expected.size() * sizeof(float));
+    const float* data = static_cast<const float*>(outputs[i][0].data.data());
+    for (size_t k = 0; k < expected.size(); ++k) {
+      EXPECT_NEAR(data[k], expected[k], 1e-4);
+    }
+  }
+
+  auto stats = batching.GetStats();
+  EXPECT_EQ(stats.request_num, batch_sizes.size());
+  EXPECT_EQ(stats.failed_request_num, 0UL);
+  EXPECT_EQ(stats.sample_num, 8UL);
+  EXPECT_LT(stats.batch_num, stats.request_num);
+  batching.ResetStats();
+  EXPECT_EQ(batching.GetStats().request_num, 0UL);
+}
+
+TEST(BatchingPredictor, bad_inputs) {
+  Config config = GetBatchingConfig();
+  services::BatchingPredictor batching(config, services::BatchingOptions());
+  std::vector<paddle::PaddleTensor> outputs;
+
+  auto input = MakeRequest(1, 0);
+  input.name = "not_an_input";
+  EXPECT_ANY_THROW(batching.Run({input}, &outputs));
+
+  input = MakeRequest(1, 0);
+  input.data.Resize(input.data.length() / 2);
+  EXPECT_ANY_THROW(batching.Run({input}, &outputs));
+
+  // a request without samples is rejected rather than batched
+  EXPECT_ANY_THROW(batching.Run({MakeRequest(0, 0)}, &outputs));
+  // the predictor still serves the requests after the rejected ones
+  EXPECT_TRUE(batching.Run({MakeRequest(1, 0)}, &outputs));
+}
+
+TEST(BatchingPredictor, bad_options) {
+  Config config = GetBatchingConfig();
+  services::BatchingOptions options;
+  options.num_predictors = 0;
+  EXPECT_ANY_THROW(services::BatchingPredictor(config, options));
+
+  options.num_predictors = 1;
+  options.max_batch_size = 0;
+  EXPECT_ANY_THROW(services::BatchingPredictor(config, options));
+}
+
+// A closed loop load generator: every client sends single sample requests
+// one after another. Compare a pool without batching with a pool of the same
+// size which batches the concurrent requests.
+static services::BatchingStats RunLoad(
+    const services::BatchingOptions& options) {
+  services::BatchingPredictor batching(GetBatchingConfig(), options);
+  // warm up
+  std::vector<paddle::PaddleTensor> outputs;
+  batching.Run({MakeRequest(1, 0)}, &outputs);
+  batching.ResetStats();
+
+  std::vector<std::thread> clients;
+  for (int c = 0; c < FLAGS_batching_client_num; ++c) {
+    clients.emplace_back([&, c]() {
+      std::vector<paddle::PaddleTensor> outputs;
+      for (int i = 0; i < FLAGS_batching_request_num; ++i) {
+        batching.Run({MakeRequest(1, c * FLAGS_batching_request_num + i)},
+                     &outputs);
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  return batching.GetStats();
+}
+
+static void LogStats(const std::string& name,
+                     const services::BatchingStats& stats) {
+  LOG(INFO) << name << ": " << stats.request_num << " requests in "
+            << stats.batch_num << " batches, avg batch size "
+            << stats.avg_batch_size << ", latency avg/p50/p99/max "
+            << stats.avg_latency_us << "/" << stats.p50_latency_us << "/"
+            << stats.p99_latency_us << "/" << stats.max_latency_us
+            << " us, avg queue " << stats.avg_queue_us << " us, avg run "
+            << stats.avg_run_us << " us, throughput " << stats.throughput
+            << " samples/s";
+}
+
+TEST(BatchingPredictor, benchmark) {
+  services::BatchingOptions options;
+  options.num_predictors = 2;
+  options.max_batch_size = 1;
+  auto unbatched = RunLoad(options);
+  LogStats("unbatched", unbatched);
+
+  options.max_batch_size = 8;
+  options.max_wait_us = 2000;
+  auto batched = RunLoad(options);
+  LogStats("batched", batched);
+
+  uint64_t total = FLAGS_batching_client_num * FLAGS_batching_request_num;
+  EXPECT_EQ(unbatched.request_num, total);
+  EXPECT_EQ(batched.request_num, total);
+  EXPECT_EQ(unbatched.batch_num, total);
+  EXPECT_EQ(batched.failed_request_num, 0UL);
+}
+
+}  // namespace paddle_infer
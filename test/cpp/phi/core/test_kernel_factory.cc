@@ -48,6 +48,48 @@ TEST(KernelFactory, SelectedKernelMap) {
   }
 }
 
+TEST(KernelFactory, KernelNameId) {
+  auto& factory = phi::KernelFactory::Instance();
+  auto scale_id = factory.GetKernelNameId("scale");
+  EXPECT_EQ(factory.GetKernelNameId("scale"), scale_id);
+  EXPECT_NE(factory.GetKernelNameId("scale_sr"), scale_id);
+  EXPECT_EQ(factory.GetKernelName(scale_id), "scale");
+}
+
+TEST(KernelSelectionCache, Select) {
+  auto& factory = phi::KernelFactory::Instance();
+  auto scale_id = factory.GetKernelNameId("scale");
+  phi::KernelKey fp32_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  phi::KernelKey fp64_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT64);
+  phi::KernelSelectionCache cache;
+
+  auto result = cache.Select(scale_id, fp32_key);
+  auto expected = factory.SelectKernelOrThrowError("scale", fp32_key);
+  EXPECT_EQ(&result.kernel, &expected.kernel);
+  EXPECT_EQ(cache.misses(), 1UL);
+  EXPECT_EQ(&cache.Select(scale_id, fp32_key).kernel, &expected.kernel);
+  EXPECT_EQ(cache.hits(), 1UL);
+
+  EXPECT_EQ(&cache.Select(scale_id, fp64_key).kernel,
+            &factory.SelectKernelOrThrowError("scale", fp64_key).kernel);
+  EXPECT_EQ(cache.misses(), 2UL);
+
+  // the cached kernels are dropped once the kernels change
+  auto version = factory.kernels_version();
+  factory.AddKernel("kernel_selection_cache_test", fp32_key, expected.kernel);
+  EXPECT_GT(factory.kernels_version(), version);
+  cache.Select(scale_id, fp32_key);
+  EXPECT_EQ(cache.misses(), 3UL);
+
+  // errors are not cached
+  auto missing_id = factory.GetKernelNameId("kernel_not_registered");
+  EXPECT_ANY_THROW(cache.Select(missing_id, fp32_key));
+  EXPECT_ANY_THROW(cache.Select(missing_id, fp32_key));
+  EXPECT_EQ(cache.hits(), 1UL);
+}
+
 template <typename T, typename Context>
 void TestKernel(const Context& dev_ctx,
                 const DenseTensor& x,
@@ -0,0 +1,61 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "paddle/phi/core/kernel_factory.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "test/cpp/phi/core/timer.h"
+
+PD_DECLARE_KERNEL(scale, CPU, ALL_LAYOUT);
+
+namespace phi {
+namespace tests {
+
+// Compare the cost of selecting a kernel by name with selecting it through
+// the cache, as done by the generated APIs.
+TEST(KernelSelectionCache, Benchmark) {
+  const size_t cycles = 1000000;
+  auto& factory = phi::KernelFactory::Instance();
+  phi::KernelKey key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  const phi::Kernel* by_name = nullptr;
+  const phi::Kernel* cached = nullptr;
+  Timer timer;
+
+  timer.tic();
+  for (size_t i = 0; i < cycles; ++i) {
+    by_name = &factory.SelectKernelOrThrowError("scale", key, true).kernel;
+  }
+  double t1 = timer.toc();
+
+  auto scale_id = factory.GetKernelNameId("scale");
+  phi::KernelSelectionCache cache;
+  timer.tic();
+  for (size_t i = 0; i < cycles; ++i) {
+    cached = &cache.Select(scale_id, key, true).kernel;
+  }
+  double t2 = timer.toc();
+
+  EXPECT_EQ(cached, by_name);
+  EXPECT_EQ(cache.misses(), 1UL);
+  EXPECT_EQ(cache.hits(), cycles - 1);
+
+  LOG(INFO) << "The cost of selecting the kernel by name is " << t1 << "ms.";
+  LOG(INFO) << "The cost of selecting the kernel by cache is " << t2 << "ms.";
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,749 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/dynload/port.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/llm_int8_linear_kernel.h"
+#include "paddle/phi/kernels/rms_norm_kernel.h"
+#include "paddle/phi/kernels/top_p_sampling_kernel.h"
+#include "paddle/phi/kernels/weight_only_linear_kernel.h"
+#include "paddle/phi/kernels/weight_quantize_kernel.h"
+
+namespace phi {
+namespace fusion {
+
+// fusion kernels have no header, the CPU kernel is instantiated by its
+// registration
+template <typename T, typename Context>
+void MMHAKernel(const Context& dev_ctx,
+                const DenseTensor& x,
+                const DenseTensor& cache_kv,
+                const paddle::optional<DenseTensor>& bias,
+                const paddle::optional<DenseTensor>& src_mask,
+                const paddle::optional<DenseTensor>& cum_offsets,
+                const paddle::optional<DenseTensor>& sequence_lengths,
+                const paddle::optional<DenseTensor>& rotary_tensor,
+                const paddle::optional<DenseTensor>& beam_cache_offset,
+                const paddle::optional<DenseTensor>& qkv_out_scale,
+                const paddle::optional<DenseTensor>& out_shift,
+                const paddle::optional<DenseTensor>& out_smooth,
+                int seq_len,
+                int rotary_emb_dims,
+                const bool use_neox_rotary_style,
+                const std::string& compute_dtype,
+                const float out_scale,
+                const int quant_round_type,
+                const float quant_max_bound,
+                const float quant_min_bound,
+                DenseTensor* out,
+                DenseTensor* cache_kv_out,
+                DenseTensor* beam_cache_offset_out);
+
+template <typename T, typename Context>
+void BlockMultiheadAttentionKernel(
+    const Context& dev_ctx,
+    const DenseTensor& qkv,
+    const DenseTensor& key_cache,
+    const DenseTensor& value_cache,
+    const DenseTensor& seq_lens_encoder,
+    const DenseTensor& seq_lens_decoder,
+    const DenseTensor& seq_lens_this_time,
+    const DenseTensor& padding_offsets,
+    const DenseTensor& cum_offsets,
+    const DenseTensor& cu_seqlens_q,
+    const DenseTensor& cu_seqlens_k,
+    const DenseTensor& block_tables,
+    const paddle::optional<DenseTensor>& pre_key_cache,
+    const paddle::optional<DenseTensor>& pre_value_cache,
+    const paddle::optional<DenseTensor>& rope_emb,
+    const paddle::optional<DenseTensor>& mask,
+    const paddle::optional<DenseTensor>& tgt_mask,
+    const paddle::optional<DenseTensor>& cache_k_quant_scales,
+    const paddle::optional<DenseTensor>& cache_v_quant_scales,
+    const paddle::optional<DenseTensor>& cache_k_dequant_scales,
+    const paddle::optional<DenseTensor>& cache_v_dequant_scales,
+    const paddle::optional<DenseTensor>& qkv_out_scale,
+    const paddle::optional<DenseTensor>& qkv_bias,
+    const paddle::optional<DenseTensor>& out_shift,
+    const paddle::optional<DenseTensor>& out_smooth,
+    int max_seq_len,
+    int block_size,
+    bool use_neox_style,
+    const bool dynamic_cachekv_quant,
+    const int quant_round_type,
+    const float quant_max_bound,
+    const float quant_min_bound,
+    const float out_scale,
+    const std::string& compute_dtype,
+    DenseTensor* fmha_out,
+    DenseTensor* qkv_out,
+    DenseTensor* key_cache_out,
+    DenseTensor* value_cache_out);
+
+template <typename T, typename Context>
+void FusedRopeKernel(const Context& dev_ctx,
+                     const DenseTensor& q,
+                     const paddle::optional<DenseTensor>& k,
+                     const paddle::optional<DenseTensor>& v,
+                     const paddle::optional<DenseTensor>& sin,
+                     const paddle::optional<DenseTensor>& cos,
+                     const paddle::optional<DenseTensor>& position_ids,
+                     bool use_neox_rotary_style,
+                     DenseTensor* out_q,
+                     DenseTensor* out_k,
+                     DenseTensor* out_v);
+
+}  // namespace fusion
+
+namespace tests {
+
+inline double GetCurrentUS() {
+  struct timeval time;
+  gettimeofday(&time, nullptr);
+  return 1e+6 * time.tv_sec + time.tv_usec;  // NOLINT
+}
+
+const CPUContext& GetCPUContext() {
+  return *static_cast<CPUContext*>(
+      DeviceContextPool::Instance().Get(CPUPlace()));
+}
+
+template <typename T = float>
+DenseTensor MakeTensor(const std::vector<int64_t>& dims) {
+  DenseTensor t;
+  t.Resize(common::make_ddim(dims));
+  GetCPUContext().template Alloc<T>(&t);
+  return t;
+}
+
+DenseTensor RandomTensor(const std::vector<int64_t>& dims,
+                         float low,
+                         float high,
+                         std::mt19937* engine) {
+  DenseTensor t = MakeTensor(dims);
+  std::uniform_real_distribution<float> dist(low, high);
+  for (int64_t i = 0; i < t.numel(); ++i) {
+    t.data<float>()[i] = dist(*engine);
+  }
+  return t;
+}
+
+// x [m, k] * w [k, n] with the weight quantized by weight_quantize of arch 0,
+// each product is off by at most half a step of the scale of its channel.
+void CheckWeightOnlyLinear(const std::string& algo, int m, int k, int n) {
+  const auto& dev_ctx = GetCPUContext();
+  std::mt19937 engine(2024);
+  DenseTensor x = RandomTensor({m, k}, -1, 1, &engine);
+  DenseTensor w = RandomTensor({k, n}, -1, 1, &engine);
+  DenseTensor bias = RandomTensor({n}, -1, 1, &engine);
+  bool int4 = algo == "weight_only_int4";
+  DenseTensor qw = MakeTensor<int8_t>({int4 ? n / 2 : n, k});
+  DenseTensor scale = MakeTensor({n});
+  WeightQuantizeKernel<float, CPUContext>(
+      dev_ctx, w, algo, 0, -1, &qw, &scale);
+
+  DenseTensor out = MakeTensor({m, n});
+  WeightOnlyLinearKernel<float, CPUContext>(dev_ctx,
+                                            x,
+                                            qw,
+                                            bias,
+                                            scale,
+                                            int4 ? "int4" : "int8",
+                                            0,
+                                            -1,
+                                            &out);
+  for (int i = 0; i < m; ++i) {
+    float x_abs_sum = 0;
+    for (int c = 0; c < k; ++c) {
+      x_abs_sum += std::fabs(x.data<float>()[i * k + c]);
+    }
+    for (int j = 0; j < n; ++j) {
+      float ref = bias.data<float>()[j];
+      for (int c = 0; c < k; ++c) {
+        ref += x.data<float>()[i * k + c] * w.data<float>()[c * n + j];
+      }
+      float tol = x_abs_sum * scale.data<float>()[j] * 0.5f + 1e-3f;
+      ASSERT_NEAR(out.data<float>()[i * n + j], ref, tol)
+          << algo << " m " << m << " at " << i << ", " << j;
+    }
+  }
+}
+
+TEST(CPU_LLM_KERNELS, weight_only_linear) {
+  // the decode path and the blocked GEMM path
+  for (int m : {1, 4, 16}) {
+    CheckWeightOnlyLinear("weight_only_int8", m, 128, 192);
+    CheckWeightOnlyLinear("weight_only_int4", m, 128, 192);
+  }
+}
+
+TEST(CPU_LLM_KERNELS, llm_int8_linear) {
+  const auto& dev_ctx = GetCPUContext();
+  const int m = 3, k = 128, n = 64;
+  const float threshold = 6.0f;
+  std::mt19937 engine(2024);
+  DenseTensor x = RandomTensor({m, k}, -1, 1, &engine);
+  // an outlier column
+  x.data<float>()[5] = 20.0f;
+  DenseTensor w = RandomTensor({k, n}, -1, 1, &engine);
+  DenseTensor qw = MakeTensor<int8_t>({n, k});
+  DenseTensor scale = MakeTensor({n});
+  WeightQuantizeKernel<float, CPUContext>(
+      dev_ctx, w, "llm.int8", 0, -1, &qw, &scale);
+
+  DenseTensor out = MakeTensor({m, n});
+  LLMInt8LinearKernel<float, CPUContext>(
+      dev_ctx, x, qw, paddle::none, scale, threshold, &out);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      float ref = 0;
+      float x_abs_sum = 0;
+      for (int c = 0; c < k; ++c) {
+        float xv = x.data<float>()[i * k + c];
+        ref += xv * w.data<float>()[c * n + j];
+        x_abs_sum += std::fabs(xv);
+      }
+      // the steps of the weight and of the row of x, which is in [-1, 1]
+      // but for the outlier
+      float tol = x_abs_sum * scale.data<float>()[j] * 0.5f +
+                  k * 0.5f / 127 + 1e-3f;
+      ASSERT_NEAR(out.data<float>()[i * n + j], ref, tol);
+    }
+  }
+}
+
+TEST(CPU_LLM_KERNELS, rms_norm) {
+  const auto& dev_ctx = GetCPUContext();
+  const int rows = 4, cols = 64;
+  std::mt19937 engine(2024);
+  DenseTensor x = RandomTensor({rows, cols}, -1, 1, &engine);
+  DenseTensor residual = RandomTensor({rows, cols}, -1, 1, &engine);
+  DenseTensor weight = RandomTensor({cols}, 0, 2, &engine);
+  DenseTensor out = MakeTensor({rows, cols});
+  DenseTensor residual_out = MakeTensor({rows, cols});
+  RmsNormKernel<float, CPUContext>(dev_ctx,
+                                   x,
+                                   paddle::none,
+                                   residual,
+                                   weight,
+                                   paddle::none,
+                                   1e-6f,
+                                   1,
+                                   -1,
+                                   0,
+                                   0,
+                                   0,
+                                   &out,
+                                   &residual_out);
+  for (int i = 0; i < rows; ++i) {
+    std::vector<float> s(cols);
+    float square_sum = 0;
+    for (int j = 0; j < cols; ++j) {
+      s[j] = x.data<float>()[i * cols + j] +
+             residual.data<float>()[i * cols + j];
+      square_sum += s[j] * s[j];
+    }
+    float inv_rms = 1.0f / std::sqrt(square_sum / cols + 1e-6f);
+    for (int j = 0; j < cols; ++j) {
+      ASSERT_NEAR(residual_out.data<float>()[i * cols + j], s[j], 1e-6);
+      ASSERT_NEAR(out.data<float>()[i * cols + j],
+                  s[j] * inv_rms * weight.data<float>()[j],
+                  1e-5);
+    }
+  }
+}
+
+TEST(CPU_LLM_KERNELS, top_p_sampling) {
+  const auto& dev_ctx = GetCPUContext();
+  const int bs = 2, vocab = 1000;
+  std::mt19937 engine(2024);
+  DenseTensor x = RandomTensor({bs, vocab}, 0, 1, &engine);
+  for (int b = 0; b < bs; ++b) {
+    float* probs = x.data<float>() + b * vocab;
+    float sum = 0;
+    for (int i = 0; i < vocab; ++i) sum += probs[i];
+    for (int i = 0; i < vocab; ++i) probs[i] /= sum;
+  }
+  // a tiny p always samples the max, the top 1 of p 1 takes the whole sort
+  DenseTensor ps = MakeTensor({bs, 1});
+  ps.data<float>()[0] = 1e-8f;
+  ps.data<float>()[1] = 1.0f;
+  DenseTensor out = MakeTensor({bs, 1});
+  DenseTensor ids = MakeTensor<int64_t>({bs, 1});
+  TopPSamplingKernel<float, CPUContext>(
+      dev_ctx, x, ps, paddle::none, 1, &out, &ids);
+  const float* probs = x.data<float>();
+  int64_t argmax = std::max_element(probs, probs + vocab) - probs;
+  ASSERT_EQ(ids.data<int64_t>()[0], argmax);
+  ASSERT_EQ(out.data<float>()[0], probs[argmax]);
+  int64_t id = ids.data<int64_t>()[1];
+  ASSERT_TRUE(id >= 0 && id < vocab);
+  ASSERT_EQ(out.data<float>()[1], probs[vocab + id]);
+}
+
+// The rotation of the dim i of the head x at the position pos, of the angles
+// of pos / 10000^(2j / head_dim) when the sin and cos are not given.
+float RopeRef(const float* x,
+              const float* sin_data,
+              const float* cos_data,
+              int64_t pos,
+              int head_dim,
+              bool use_neox_rotary_style,
+              int i) {
+  float sin_value, cos_value;
+  if (sin_data) {
+    sin_value = sin_data[pos * head_dim + i];
+    cos_value = cos_data[pos * head_dim + i];
+  } else {
+    float idx = static_cast<float>(i / 2 * 2);
+    float angle = pos / std::pow(10000.0f, idx / head_dim);
+    sin_value = std::sin(angle);
+    cos_value = std::cos(angle);
+  }
+  if (use_neox_rotary_style) {
+    return i % 2 == 0 ? cos_value * x[i] - sin_value * x[i + 1]
+                      : sin_value * x[i - 1] + cos_value * x[i];
+  }
+  int half = head_dim / 2;
+  return i < half ? cos_value * x[i] - sin_value * x[i + half]
+                  : cos_value * x[i] + sin_value * x[i - half];
+}
+
+// q of 4 heads and k of 2, of both rotary styles, with the angles computed by
+// the kernel and with a table of sin and cos looked up by position ids.
+TEST(CPU_LLM_KERNELS, fused_rope) {
+  const auto& dev_ctx = GetCPUContext();
+  const int bsz = 2, seq_len = 5, num_head = 4, kv_num_head = 2;
+  const int head_dim = 16, max_pos = 8;
+  std::mt19937 engine(2024);
+  DenseTensor q =
+      RandomTensor({bsz, seq_len, num_head, head_dim}, -1, 1, &engine);
+  DenseTensor k =
+      RandomTensor({bsz, seq_len, kv_num_head, head_dim}, -1, 1, &engine);
+  DenseTensor sin = RandomTensor({max_pos, head_dim}, -1, 1, &engine);
+  DenseTensor cos = RandomTensor({max_pos, head_dim}, -1, 1, &engine);
+  DenseTensor position_ids = MakeTensor<int64_t>({bsz, seq_len});
+  for (int i = 0; i < bsz * seq_len; ++i) {
+    position_ids.data<int64_t>()[i] = (i * 3) % max_pos;
+  }
+
+  for (bool use_table : {false, true}) {
+    for (bool use_neox_rotary_style : {false, true}) {
+      DenseTensor out_q = MakeTensor({bsz, seq_len, num_head, head_dim});
+      DenseTensor out_k = MakeTensor({bsz, seq_len, kv_num_head, head_dim});
+      paddle::optional<DenseTensor> sin_opt, cos_opt, position_ids_opt;
+      if (use_table) {
+        sin_opt = sin;
+        cos_opt = cos;
+        position_ids_opt = position_ids;
+      }
+      fusion::FusedRopeKernel<float, CPUContext>(dev_ctx,
+                                                 q,
+                                                 k,
+                                                 paddle::none,
+                                                 sin_opt,
+                                                 cos_opt,
+                                                 position_ids_opt,
+                                                 use_neox_rotary_style,
+                                                 &out_q,
+                                                 &out_k,
+                                                 nullptr);
+      auto check = [&](const DenseTensor& x, const DenseTensor& out, int h) {
+        for (int bs = 0; bs < bsz * seq_len; ++bs) {
+          int64_t pos =
+              use_table ? position_ids.data<int64_t>()[bs] : bs % seq_len;
+          for (int hi = 0; hi < h; ++hi) {
+            const float* head = x.data<float>() + (bs * h + hi) * head_dim;
+            for (int i = 0; i < head_dim; ++i) {
+              float ref = RopeRef(head,
+                                  use_table ? sin.data<float>() : nullptr,
+                                  use_table ? cos.data<float>() : nullptr,
+                                  pos,
+                                  head_dim,
+                                  use_neox_rotary_style,
+                                  i);
+              ASSERT_NEAR(
+                  out.data<float>()[(bs * h + hi) * head_dim + i], ref, 1e-5)
+                  << "table " << use_table << ", neox "
+                  << use_neox_rotary_style << " at " << bs << ", " << hi;
+            }
+          }
+        }
+      };
+      check(q, out_q, num_head);
+      check(k, out_k, kv_num_head);
+    }
+  }
+}
+
+// The index of the time step t, dim d of a head in the k cache.
+int64_t CacheKIndex(int max_seq_len, int t, int d) {
+  constexpr int x = 16 / sizeof(float);
+  return (d / x) * max_seq_len * x + t * x + d % x;
+}
+
+TEST(CPU_LLM_KERNELS, masked_multihead_attention) {
+  const auto& dev_ctx = GetCPUContext();
+  const int bsz = 2, num_head = 4, kv_num_head = 2, dim_head = 32;
+  const int max_seq_len = 16;
+  const int qkv_num_head = num_head + 2 * kv_num_head;
+  std::mt19937 engine(2024);
+  DenseTensor x = RandomTensor({bsz, qkv_num_head * dim_head}, -1, 1, &engine);
+  DenseTensor cache_kv = RandomTensor(
+      {2, bsz, kv_num_head, max_seq_len, dim_head}, -1, 1, &engine);
+  DenseTensor sequence_lengths = MakeTensor<int>({bsz});
+  sequence_lengths.data<int>()[0] = 5;
+  sequence_lengths.data<int>()[1] = 0;
+  // the cache before the step, of [bsz, kv_num_head, max_seq_len, dim_head]
+  std::vector<float> k_ref(bsz * kv_num_head * max_seq_len * dim_head);
+  std::vector<float> v_ref(k_ref.size());
+  int64_t head_cache_size = max_seq_len * dim_head;
+  const float* cache_data = cache_kv.data<float>();
+  for (int bh = 0; bh < bsz * kv_num_head; ++bh) {
+    for (int t = 0; t < max_seq_len; ++t) {
+      for (int d = 0; d < dim_head; ++d) {
+        k_ref[bh * head_cache_size + t * dim_head + d] =
+            cache_data[bh * head_cache_size + CacheKIndex(max_seq_len, t, d)];
+        v_ref[bh * head_cache_size + t * dim_head + d] =
+            cache_data[k_ref.size() + bh * head_cache_size + t * dim_head + d];
+      }
+    }
+  }
+
+  DenseTensor out = MakeTensor({bsz, num_head * dim_head});
+  fusion::MMHAKernel<float, CPUContext>(dev_ctx,
+                                        x,
+                                        cache_kv,
+                                        paddle::none,
+                                        paddle::none,
+                                        paddle::none,
+                                        sequence_lengths,
+                                        paddle::none,
+                                        paddle::none,
+                                        paddle::none,
+                                        paddle::none,
+                                        paddle::none,
+                                        1,
+                                        0,
+                                        false,
+                                        "default",
+                                        -1,
+                                        1,
+                                        127,
+                                        -127,
+                                        &out,
+                                        &cache_kv,
+                                        nullptr);
+
+  for (int bi = 0; bi < bsz; ++bi) {
+    int t = sequence_lengths.data<int>()[bi];
+    const float* qkv = x.data<float>() + bi * qkv_num_head * dim_head;
+    for (int kh = 0; kh < kv_num_head; ++kh) {
+      int64_t bh = bi * kv_num_head + kh;
+      for (int d = 0; d < dim_head; ++d) {
+        k_ref[bh * head_cache_size + t * dim_head + d] =
+            qkv[(num_head + kh) * dim_head + d];
+        v_ref[bh * head_cache_size + t * dim_head + d] =
+            qkv[(num_head + kv_num_head + kh) * dim_head + d];
+        ASSERT_EQ(
+            cache_data[bh * head_cache_size + CacheKIndex(max_seq_len, t, d)],
+            k_ref[bh * head_cache_size + t * dim_head + d]);
+      }
+    }
+    for (int hi = 0; hi < num_head; ++hi) {
+      int64_t bh = bi * kv_num_head + hi / (num_head / kv_num_head);
+      const float* q = qkv + hi * dim_head;
+      std::vector<float> p(t + 1);
+      float max_p = -1e30f;
+      for (int ti = 0; ti <= t; ++ti) {
+        float dot = 0;
+        for (int d = 0; d < dim_head; ++d) {
+          dot += q[d] * k_ref[bh * head_cache_size + ti * dim_head + d];
+        }
+        p[ti] = dot / std::sqrt(static_cast<float>(dim_head));
+        max_p = std::max(max_p, p[ti]);
+      }
+      float sum = 0;
+      for (int ti = 0; ti <= t; ++ti) {
+        p[ti] = std::exp(p[ti] - max_p);
+        sum += p[ti];
+      }
+      for (int d = 0; d < dim_head; ++d) {
+        float ref = 0;
+        for (int ti = 0; ti <= t; ++ti) {
+          ref += p[ti] / sum * v_ref[bh * head_cache_size + ti * dim_head + d];
+        }
+        ASSERT_NEAR(
+            out.data<float>()[(bi * num_head + hi) * dim_head + d], ref, 1e-4);
+      }
+    }
+  }
+}
+
+// A prefill of 5 tokens batched with the decoding of a sequence of 6 cached
+// tokens, on pages of 4 tokens given out of order.
+TEST(CPU_LLM_KERNELS, block_multihead_attention) {
+  const auto& dev_ctx = GetCPUContext();
+  const int bsz = 2, num_head = 2, dim_head = 16, block_size = 4;
+  const int max_seq_len = 16, max_block_per_seq = 4, num_blocks = 8;
+  const int hidden = num_head * dim_head;
+  const std::vector<int> lens = {5, 7};  // the lengths after the step
+  const int token_num = 6;
+  std::mt19937 engine(2024);
+  DenseTensor qkv = RandomTensor({token_num, 3 * hidden}, -1, 1, &engine);
+  DenseTensor key_cache = RandomTensor(
+      {num_blocks, num_head, block_size, dim_head}, -1, 1, &engine);
+  DenseTensor value_cache = RandomTensor(
+      {num_blocks, num_head, block_size, dim_head}, -1, 1, &engine);
+  auto int_tensor = [](const std::vector<int>& values,
+                       const std::vector<int64_t>& dims) {
+    DenseTensor t = MakeTensor<int>(dims);
+    std::copy(values.begin(), values.end(), t.data<int>());
+    return t;
+  };
+  DenseTensor seq_lens_encoder = int_tensor({5, 0}, {bsz, 1});
+  DenseTensor seq_lens_decoder = int_tensor({0, 6}, {bsz, 1});
+  DenseTensor seq_lens_this_time = int_tensor({5, 1}, {bsz, 1});
+  DenseTensor padding_offsets = int_tensor({0, 0, 0, 0, 0, 11}, {token_num});
+  DenseTensor cum_offsets = int_tensor({0, 11}, {bsz});
+  DenseTensor cu_seqlens = int_tensor({0, 5, 6}, {bsz + 1});
+  DenseTensor block_tables =
+      int_tensor({5, 2, -1, -1, 7, 0, -1, -1}, {bsz, max_block_per_seq});
+  // the cache of the decoding sequence before the step
+  std::vector<float> k_ref(bsz * num_head * max_seq_len * dim_head);
+  std::vector<float> v_ref(k_ref.size());
+  auto cache_index = [&](int bi, int hi, int pos) {
+    int block = block_tables.data<int>()[bi * max_block_per_seq +
+                                         pos / block_size];
+    return ((block * num_head + hi) * block_size + pos % block_size) *
+           dim_head;
+  };
+  auto ref_index = [&](int bi, int hi, int pos) {
+    return ((bi * num_head + hi) * max_seq_len + pos) * dim_head;
+  };
+  for (int hi = 0; hi < num_head; ++hi) {
+    for (int pos = 0; pos < 6; ++pos) {
+      std::copy_n(key_cache.data<float>() + cache_index(1, hi, pos),
+                  dim_head,
+                  k_ref.begin() + ref_index(1, hi, pos));
+      std::copy_n(value_cache.data<float>() + cache_index(1, hi, pos),
+                  dim_head,
+                  v_ref.begin() + ref_index(1, hi, pos));
+    }
+  }
+  std::vector<float> qkv_in(qkv.data<float>(),
+                            qkv.data<float>() + qkv.numel());
+  const int token_start[] = {0, 5};
+  const int start_pos[] = {0, 6};
+  for (int bi = 0; bi < bsz; ++bi) {
+    for (int t = 0; t < lens[bi] - start_pos[bi]; ++t) {
+      const float* token = qkv_in.data() + (token_start[bi] + t) * 3 * hidden;
+      for (int hi = 0; hi < num_head; ++hi) {
+        std::copy_n(token + hidden + hi * dim_head,
+                    dim_head,
+                    k_ref.begin() + ref_index(bi, hi, start_pos[bi] + t));
+        std::copy_n(token + 2 * hidden + hi * dim_head,
+                    dim_head,
+                    v_ref.begin() + ref_index(bi, hi, start_pos[bi] + t));
+      }
+    }
+  }
+
+  DenseTensor fmha_out = MakeTensor({token_num, hidden});
+  fusion::BlockMultiheadAttentionKernel<float, CPUContext>(dev_ctx,
+                                                           qkv,
+                                                           key_cache,
+                                                           value_cache,
+                                                           seq_lens_encoder,
+                                                           seq_lens_decoder,
+                                                           seq_lens_this_time,
+                                                           padding_offsets,
+                                                           cum_offsets,
+                                                           cu_seqlens,
+                                                           cu_seqlens,
+                                                           block_tables,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           paddle::none,
+                                                           max_seq_len,
+                                                           block_size,
+                                                           false,
+                                                           false,
+                                                           1,
+                                                           127,
+                                                           -127,
+                                                           -1,
+                                                           "default",
+                                                           &fmha_out,
+                                                           &qkv,
+                                                           &key_cache,
+                                                           &value_cache);
+
+  for (int bi = 0; bi < bsz; ++bi) {
+    for (int t = 0; t < lens[bi] - start_pos[bi]; ++t) {
+      int pos = start_pos[bi] + t;
+      int ti = token_start[bi] + t;
+      for (int hi = 0; hi < num_head; ++hi) {
+        ASSERT_EQ(key_cache.data<float>()[cache_index(bi, hi, pos)],
+                  k_ref[ref_index(bi, hi, pos)]);
+        const float* q = qkv_in.data() + ti * 3 * hidden + hi * dim_head;
+        // causal attention to the positions [0, pos]
+        std::vector<float> p(pos + 1);
+        float max_p = -1e30f;
+        for (int j = 0; j <= pos; ++j) {
+          float dot = 0;
+          for (int d = 0; d < dim_head; ++d) {
+            dot += q[d] * k_ref[ref_index(bi, hi, j) + d];
+          }
+          p[j] = dot / std::sqrt(static_cast<float>(dim_head));
+          max_p = std::max(max_p, p[j]);
+        }
+        float sum = 0;
+        for (int j = 0; j <= pos; ++j) {
+          p[j] = std::exp(p[j] - max_p);
+          sum += p[j];
+        }
+        for (int d = 0; d < dim_head; ++d) {
+          float ref = 0;
+          for (int j = 0; j <= pos; ++j) {
+            ref += p[j] / sum * v_ref[ref_index(bi, hi, j) + d];
+          }
+          ASSERT_NEAR(fmha_out.data<float>()[ti * hidden + hi * dim_head + d],
+                      ref,
+                      1e-4);
+        }
+      }
+    }
+  }
+}
+
+// A decoding step of a layer of a small LLaMA on CPU, with the weights of
+// weight_only_int8 and a cache of 256 steps.
+TEST(CPU_LLM_KERNELS, benchmark_decode_step) {
+  const auto& dev_ctx = GetCPUContext();
+  const int bsz = 1, hidden = 1024, num_head = 16, dim_head = 64;
+  const int ffn_hidden = 2816, max_seq_len = 512, step = 256, repeat = 20;
+  std::mt19937 engine(2024);
+  auto quant_weight = [&](int k, int n, DenseTensor* qw, DenseTensor* scale) {
+    DenseTensor w = RandomTensor({k, n}, -0.05f, 0.05f, &engine);
+    *qw = MakeTensor<int8_t>({n, k});
+    *scale = MakeTensor({n});
+    WeightQuantizeKernel<float, CPUContext>(
+        dev_ctx, w, "weight_only_int8", 0, -1, qw, scale);
+  };
+  DenseTensor qkv_w, qkv_scale, o_w, o_scale, ffn1_w, ffn1_scale, ffn2_w,
+      ffn2_scale;
+  quant_weight(hidden, 3 * hidden, &qkv_w, &qkv_scale);
+  quant_weight(hidden, hidden, &o_w, &o_scale);
+  quant_weight(hidden, ffn_hidden, &ffn1_w, &ffn1_scale);
+  quant_weight(ffn_hidden, hidden, &ffn2_w, &ffn2_scale);
+  DenseTensor norm_w = RandomTensor({hidden}, 0.5f, 1.5f, &engine);
+  DenseTensor cache_kv = RandomTensor(
+      {2, bsz, num_head, max_seq_len, dim_head}, -1, 1, &engine);
+  DenseTensor sequence_lengths = MakeTensor<int>({bsz});
+  sequence_lengths.data<int>()[0] = step;
+
+  DenseTensor x = RandomTensor({bsz, hidden}, -1, 1, &engine);
+  DenseTensor norm_out = MakeTensor({bsz, hidden});
+  DenseTensor qkv = MakeTensor({bsz, 3 * hidden});
+  DenseTensor attn = MakeTensor({bsz, hidden});
+  DenseTensor o = MakeTensor({bsz, hidden});
+  DenseTensor ffn1 = MakeTensor({bsz, ffn_hidden});
+  DenseTensor ffn2 = MakeTensor({bsz, hidden});
+  auto linear = [&](const DenseTensor& in,
+                    const DenseTensor& w,
+                    const DenseTensor& scale,
+                    DenseTensor* out) {
+    WeightOnlyLinearKernel<float, CPUContext>(
+        dev_ctx, in, w, paddle::none, scale, "int8", 0, -1, out);
+  };
+  auto decode_step = [&]() {
+    RmsNormKernel<float, CPUContext>(dev_ctx,
+                                     x,
+                                     paddle::none,
+                                     paddle::none,
+                                     norm_w,
+                                     paddle::none,
+                                     1e-6f,
+                                     1,
+                                     -1,
+                                     0,
+                                     0,
+                                     0,
+                                     &norm_out,
+                                     nullptr);
+    linear(norm_out, qkv_w, qkv_scale, &qkv);
+    fusion::MMHAKernel<float, CPUContext>(dev_ctx,
+                                          qkv,
+                                          cache_kv,
+                                          paddle::none,
+                                          paddle::none,
+                                          paddle::none,
+                                          sequence_lengths,
+                                          paddle::none,
+                                          paddle::none,
+                                          paddle::none,
+                                          paddle::none,
+                                          paddle::none,
+                                          1,
+                                          0,
+                                          false,
+                                          "default",
+                                          -1,
+                                          1,
+                                          127,
+                                          -127,
+                                          &attn,
+                                          &cache_kv,
+                                          nullptr);
+    linear(attn, o_w, o_scale, &o);
+    linear(o, ffn1_w, ffn1_scale, &ffn1);
+    linear(ffn1, ffn2_w, ffn2_scale, &ffn2);
+  };
+
+  decode_step();
+  double start = GetCurrentUS();
+  for (int i = 0; i < repeat; ++i) {
+    decode_step();
+  }
+  double step_us = (GetCurrentUS() - start) / repeat;
+  int64_t weight_bytes =
+      qkv_w.numel() + o_w.numel() + ffn1_w.numel() + ffn2_w.numel();
+  LOG(INFO) << "decode step of hidden " << hidden << ", step " << step << ": "
+            << step_us << " us, "
+            << weight_bytes / step_us / 1e3 << " GB/s of weights";
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,408 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/dynload/port.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/adam_kernel.h"
+#include "paddle/phi/kernels/adamw_kernel.h"
+#include "paddle/phi/kernels/fused_adam_kernel.h"
+#include "paddle/phi/kernels/lamb_kernel.h"
+#include "paddle/phi/kernels/merged_momentum_kernel.h"
+
+namespace phi {
+namespace tests {
+
+inline double GetCurrentUS() {
+  struct timeval time;
+  gettimeofday(&time, nullptr);
+  return 1e+6 * time.tv_sec + time.tv_usec;  // NOLINT
+}
+
+const CPUContext& GetCPUContext() {
+  return *static_cast<CPUContext*>(
+      DeviceContextPool::Instance().Get(CPUPlace()));
+}
+
+DenseTensor MakeTensor(int64_t numel) {
+  DenseTensor t;
+  t.Resize(common::make_ddim({numel}));
+  GetCPUContext().Alloc<float>(&t);
+  return t;
+}
+
+DenseTensor RandomTensor(int64_t numel,
+                         float low,
+                         float high,
+                         std::mt19937* engine) {
+  DenseTensor t = MakeTensor(numel);
+  std::uniform_real_distribution<float> dist(low, high);
+  for (int64_t i = 0; i < numel; ++i) {
+    t.data<float>()[i] = dist(*engine);
+  }
+  return t;
+}
+
+DenseTensor FullTensor(int64_t numel, float value) {
+  DenseTensor t = MakeTensor(numel);
+  for (int64_t i = 0; i < numel; ++i) {
+    t.data<float>()[i] = value;
+  }
+  return t;
+}
+
+std::vector<const DenseTensor*> ConstPtrs(const std::vector<DenseTensor>& ts) {
+  std::vector<const DenseTensor*> ptrs;
+  for (auto& t : ts) {
+    ptrs.push_back(&t);
+  }
+  return ptrs;
+}
+
+std::vector<DenseTensor*> Ptrs(std::vector<DenseTensor>* ts) {
+  std::vector<DenseTensor*> ptrs;
+  for (auto& t : *ts) {
+    ptrs.push_back(&t);
+  }
+  return ptrs;
+}
+
+void ExpectNear(const DenseTensor& x, const DenseTensor& y, float eps) {
+  ASSERT_EQ(x.numel(), y.numel());
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    ASSERT_NEAR(x.data<float>()[i], y.data<float>()[i], eps) << "at " << i;
+  }
+}
+
+// The states of the parameters of a model of many small parameters and a
+// few large ones.
+struct OptimizerStates {
+  OptimizerStates(const std::vector<int64_t>& sizes, std::mt19937* engine) {
+    for (int64_t size : sizes) {
+      params.push_back(RandomTensor(size, -1, 1, engine));
+      grads.push_back(RandomTensor(size, -1, 1, engine));
+      moments1.push_back(RandomTensor(size, -0.1f, 0.1f, engine));
+      moments2.push_back(RandomTensor(size, 0, 0.1f, engine));
+      beta1_pows.push_back(FullTensor(1, 0.9f * 0.9f));
+      beta2_pows.push_back(FullTensor(1, 0.999f * 0.999f));
+    }
+  }
+
+  std::vector<DenseTensor> params;
+  std::vector<DenseTensor> grads;
+  std::vector<DenseTensor> moments1;
+  std::vector<DenseTensor> moments2;
+  std::vector<DenseTensor> beta1_pows;
+  std::vector<DenseTensor> beta2_pows;
+};
+
+std::vector<int64_t> ModelSizes(int small_num, int64_t small_size) {
+  std::vector<int64_t> sizes(small_num, small_size);
+  sizes.push_back(1);
+  sizes.push_back(100003);
+  sizes.push_back(4096);
+  return sizes;
+}
+
+void RunFusedAdam(OptimizerStates* s,
+                  const DenseTensor& lr,
+                  int chunk_size,
+                  bool use_adamw) {
+  FusedAdamKernel<float, CPUContext>(GetCPUContext(),
+                                     ConstPtrs(s->params),
+                                     ConstPtrs(s->grads),
+                                     lr,
+                                     ConstPtrs(s->moments1),
+                                     ConstPtrs(s->moments2),
+                                     ConstPtrs(s->beta1_pows),
+                                     ConstPtrs(s->beta2_pows),
+                                     paddle::none,
+                                     paddle::none,
+                                     0.9f,
+                                     0.999f,
+                                     1e-8f,
+                                     chunk_size,
+                                     0.01f,
+                                     use_adamw,
+                                     false,
+                                     false,
+                                     Ptrs(&s->params),
+                                     Ptrs(&s->moments1),
+                                     Ptrs(&s->moments2),
+                                     Ptrs(&s->beta1_pows),
+                                     Ptrs(&s->beta2_pows),
+                                     {});
+}
+
+// The update of the parameters one by one with adam or adamw.
+void RunAdamPerParam(OptimizerStates* s, const DenseTensor& lr, bool adamw) {
+  for (size_t i = 0; i < s->params.size(); ++i) {
+    if (adamw) {
+      AdamwDenseKernel<float, CPUContext>(GetCPUContext(),
+                                          s->params[i],
+                                          s->grads[i],
+                                          lr,
+                                          s->moments1[i],
+                                          s->moments2[i],
+                                          s->beta1_pows[i],
+                                          s->beta2_pows[i],
+                                          paddle::none,
+                                          paddle::none,
+                                          0.9f,
+                                          0.999f,
+                                          1e-8f,
+                                          1.0f,
+                                          0.01f,
+                                          true,
+                                          false,
+                                          1000,
+                                          false,
+                                          false,
+                                          &s->params[i],
+                                          &s->moments1[i],
+                                          &s->moments2[i],
+                                          &s->beta1_pows[i],
+                                          &s->beta2_pows[i],
+                                          nullptr);
+    } else {
+      AdamDenseKernel<float, CPUContext>(GetCPUContext(),
+                                         s->params[i],
+                                         s->grads[i],
+                                         lr,
+                                         s->moments1[i],
+                                         s->moments2[i],
+                                         s->beta1_pows[i],
+                                         s->beta2_pows[i],
+                                         paddle::none,
+                                         paddle::none,
+                                         0.9f,
+                                         0.999f,
+                                         1e-8f,
+                                         false,
+                                         1000,
+                                         false,
+                                         false,
+                                         &s->params[i],
+                                         &s->moments1[i],
+                                         &s->moments2[i],
+                                         &s->beta1_pows[i],
+                                         &s->beta2_pows[i],
+                                         nullptr);
+    }
+  }
+}
+
+void CheckFusedAdam(bool use_adamw) {
+  std::mt19937 engine(2024);
+  auto sizes = ModelSizes(37, 300);
+  OptimizerStates fused(sizes, &engine);
+  engine.seed(2024);
+  OptimizerStates ref(sizes, &engine);
+  DenseTensor lr = FullTensor(1, 1e-3f);
+  // a chunk size which splits the parameters unevenly
+  for (int step = 0; step < 3; ++step) {
+    RunFusedAdam(&fused, lr, 1000, use_adamw);
+    RunAdamPerParam(&ref, lr, use_adamw);
+  }
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    ExpectNear(fused.params[i], ref.params[i], 1e-6f);
+    ExpectNear(fused.moments1[i], ref.moments1[i], 1e-6f);
+    ExpectNear(fused.moments2[i], ref.moments2[i], 1e-6f);
+    ExpectNear(fused.beta1_pows[i], ref.beta1_pows[i], 1e-7f);
+    ExpectNear(fused.beta2_pows[i], ref.beta2_pows[i], 1e-7f);
+  }
+}
+
+TEST(CPU_OPTIMIZER_KERNELS, fused_adam) { CheckFusedAdam(false); }
+
+TEST(CPU_OPTIMIZER_KERNELS, fused_adamw) { CheckFusedAdam(true); }
+
+TEST(CPU_OPTIMIZER_KERNELS, merged_momentum) {
+  std::mt19937 engine(2024);
+  auto sizes = ModelSizes(21, 5000);
+  size_t n = sizes.size();
+  const float mu = 0.9f, rescale_grad = 0.5f;
+  for (bool use_nesterov : {false, true}) {
+    OptimizerStates s(sizes, &engine);
+    std::vector<DenseTensor> velocities;
+    std::vector<DenseTensor> lrs;
+    std::vector<std::string> methods;
+    std::vector<float> coeffs;
+    for (size_t i = 0; i < n; ++i) {
+      velocities.push_back(RandomTensor(sizes[i], -0.1f, 0.1f, &engine));
+      lrs.push_back(FullTensor(1, 0.01f * (i % 3 + 1)));
+      methods.push_back(i % 2 ? "l2_decay" : "");
+      coeffs.push_back(i % 2 ? 1e-2f : 0.0f);
+    }
+    // the expected outputs of momentum with rescale_grad
+    std::vector<std::vector<float>> params_ref(n), velocities_ref(n);
+    for (size_t i = 0; i < n; ++i) {
+      float lr = lrs[i].data<float>()[0];
+      for (int64_t j = 0; j < sizes[i]; ++j) {
+        float p = s.params[i].data<float>()[j];
+        float g = s.grads[i].data<float>()[j] * rescale_grad + coeffs[i] * p;
+        float v = velocities[i].data<float>()[j] * mu + g;
+        params_ref[i].push_back(use_nesterov ? p - (g + v * mu) * lr
+                                             : p - lr * v);
+        velocities_ref[i].push_back(v);
+      }
+    }
+
+    MergedMomentumKernel<float, CPUContext>(GetCPUContext(),
+                                            ConstPtrs(s.params),
+                                            ConstPtrs(s.grads),
+                                            ConstPtrs(velocities),
+                                            ConstPtrs(lrs),
+                                            paddle::none,
+                                            mu,
+                                            use_nesterov,
+                                            methods,
+                                            coeffs,
+                                            false,
+                                            rescale_grad,
+                                            Ptrs(&s.params),
+                                            Ptrs(&velocities),
+                                            {});
+    for (size_t i = 0; i < n; ++i) {
+      for (int64_t j = 0; j < sizes[i]; ++j) {
+        ASSERT_NEAR(s.params[i].data<float>()[j], params_ref[i][j], 1e-6f);
+        ASSERT_NEAR(
+            velocities[i].data<float>()[j], velocities_ref[i][j], 1e-6f);
+      }
+    }
+  }
+}
+
+TEST(CPU_OPTIMIZER_KERNELS, lamb) {
+  std::mt19937 engine(2024);
+  const int64_t numel = 100003;
+  const float beta1 = 0.9f, beta2 = 0.999f, epsilon = 1e-6f, decay = 0.01f;
+  OptimizerStates s({numel}, &engine);
+  DenseTensor lr = FullTensor(1, 1e-3f);
+  DenseTensor param_out = MakeTensor(numel);
+  DenseTensor moment1_out = MakeTensor(numel);
+  DenseTensor moment2_out = MakeTensor(numel);
+  DenseTensor beta1_pow_out = MakeTensor(1);
+  DenseTensor beta2_pow_out = MakeTensor(1);
+  LambKernel<float, CPUContext>(GetCPUContext(),
+                                s.params[0],
+                                s.grads[0],
+                                lr,
+                                s.moments1[0],
+                                s.moments2[0],
+                                s.beta1_pows[0],
+                                s.beta2_pows[0],
+                                paddle::none,
+                                paddle::none,
+                                decay,
+                                beta1,
+                                beta2,
+                                epsilon,
+                                false,
+                                false,
+                                &param_out,
+                                &moment1_out,
+                                &moment2_out,
+                                &beta1_pow_out,
+                                &beta2_pow_out,
+                                nullptr);
+
+  const float* p = s.params[0].data<float>();
+  const float* g = s.grads[0].data<float>();
+  float beta1_pow = s.beta1_pows[0].data<float>()[0];
+  float beta2_pow = s.beta2_pows[0].data<float>()[0];
+  std::vector<double> trust_ratio_div(numel);
+  double p_norm = 0, t_norm = 0;
+  for (int64_t i = 0; i < numel; ++i) {
+    double m1 = beta1 * s.moments1[0].data<float>()[i] + (1 - beta1) * g[i];
+    double m2 =
+        beta2 * s.moments2[0].data<float>()[i] + (1 - beta2) * g[i] * g[i];
+    ASSERT_NEAR(moment1_out.data<float>()[i], m1, 1e-6);
+    ASSERT_NEAR(moment2_out.data<float>()[i], m2, 1e-6);
+    trust_ratio_div[i] =
+        m1 / (1 - beta1_pow) / (std::sqrt(m2 / (1 - beta2_pow)) + epsilon) +
+        decay * p[i];
+    p_norm += static_cast<double>(p[i]) * p[i];
+    t_norm += trust_ratio_div[i] * trust_ratio_div[i];
+  }
+  double ratio = std::sqrt(p_norm) / std::sqrt(t_norm);
+  for (int64_t i = 0; i < numel; ++i) {
+    ASSERT_NEAR(param_out.data<float>()[i],
+                p[i] - 1e-3 * ratio * trust_ratio_div[i],
+                1e-5);
+  }
+  EXPECT_FLOAT_EQ(beta1_pow_out.data<float>()[0], beta1_pow * beta1);
+  EXPECT_FLOAT_EQ(beta2_pow_out.data<float>()[0], beta2_pow * beta2);
+}
+
+// One optimizer step of a model of 4000 small parameters, by fused_adam and
+// by adam one parameter after another.
+TEST(CPU_OPTIMIZER_KERNELS, benchmark_optimizer_step) {
+  std::mt19937 engine(2024);
+  const int repeat = 20;
+  auto sizes = ModelSizes(4000, 768);
+  int64_t numel = 0;
+  for (int64_t size : sizes) {
+    numel += size;
+  }
+  OptimizerStates s(sizes, &engine);
+  DenseTensor lr = FullTensor(1, 1e-3f);
+
+  auto benchmark = [&](const std::string& name,
+                       const std::function<void()>& step) {
+    step();
+    double start = GetCurrentUS();
+    for (int i = 0; i < repeat; ++i) {
+      step();
+    }
+    double step_us = (GetCurrentUS() - start) / repeat;
+    LOG(INFO) << name << " step of " << sizes.size() << " params, " << numel
+              << " elements: " << step_us << " us";
+  };
+  benchmark("adam per param", [&]() { RunAdamPerParam(&s, lr, false); });
+  benchmark("fused_adam", [&]() { RunFusedAdam(&s, lr, 65536, false); });
+  benchmark("adamw per param", [&]() { RunAdamPerParam(&s, lr, true); });
+  benchmark("fused_adamw", [&]() { RunFusedAdam(&s, lr, 65536, true); });
+
+  std::vector<DenseTensor> lrs = {lr};
+  benchmark("merged_momentum", [&]() {
+    MergedMomentumKernel<float, CPUContext>(GetCPUContext(),
+                                            ConstPtrs(s.params),
+                                            ConstPtrs(s.grads),
+                                            ConstPtrs(s.moments1),
+                                            ConstPtrs(lrs),
+                                            paddle::none,
+                                            0.9f,
+                                            false,
+                                            {},
+                                            {},
+                                            false,
+                                            1.0f,
+                                            Ptrs(&s.params),
+                                            Ptrs(&s.moments1),
+                                            {});
+  });
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,108 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Benchmarks the CPU kernels of sparse matmul, mv and addmm against the dense
+ones on the same matrix, e.g.
+
+    python sparse_matmul_benchmark.py --m 4096 --k 4096 --n 64 --density 0.01
+
+The sparse matrix has --density of non-zeros, and one row in every
+--dense_row_stride is dense, which is the skewed case the kernels balance
+their threads for. The sparse kernels use the OpenMP threads, set by
+OMP_NUM_THREADS. It is not a unittest, so it is not run by ctest.
+"""
+
+import argparse
+import time
+
+import numpy as np
+
+import paddle
+
+
+def run_op(fn, iters):
+    fn()
+    start = time.perf_counter()
+    for _ in range(iters):
+        fn()
+    return (time.perf_counter() - start) / iters
+
+
+def sparse_matrix(args):
+    m, k = args.m, args.k
+    np_x = np.random.rand(m, k) * (np.random.rand(m, k) < args.density)
+    if args.dense_row_stride > 0:
+        np_x[:: args.dense_row_stride] = np.random.rand(
+            len(range(0, m, args.dense_row_stride)), k
+        )
+    return np_x.astype("float32")
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--m", type=int, default=4096)
+    parser.add_argument("--k", type=int, default=4096)
+    parser.add_argument("--n", type=int, default=64)
+    parser.add_argument("--density", type=float, default=0.01)
+    parser.add_argument("--dense_row_stride", type=int, default=64)
+    parser.add_argument("--iters", type=int, default=20)
+    args = parser.parse_args()
+
+    paddle.device.set_device("cpu")
+    x = paddle.to_tensor(sparse_matrix(args))
+    csr_x = x.to_sparse_csr()
+    coo_x = x.to_sparse_coo(2)
+    y = paddle.rand([args.k, args.n])
+    vec = paddle.rand([args.k])
+    bias = paddle.rand([args.m, args.n])
+
+    cases = [
+        (
+            "spmm csr",
+            lambda: paddle.sparse.matmul(csr_x, y),
+            lambda: paddle.matmul(x, y),
+        ),
+        (
+            "spmm coo",
+            lambda: paddle.sparse.matmul(coo_x, y),
+            lambda: paddle.matmul(x, y),
+        ),
+        (
+            "spmv csr",
+            lambda: paddle.sparse.mv(csr_x, vec),
+            lambda: paddle.mv(x, vec),
+        ),
+        (
+            "addmm csr",
+            lambda: paddle.sparse.addmm(bias, csr_x, y, 0.5, 2.0),
+            lambda: paddle.addmm(bias, x, y, 0.5, 2.0),
+        ),
+    ]
+
+    nnz = csr_x.nnz()
+    print(
+        f"x: {args.m}x{args.k}, nnz {nnz} "
+        f"({nnz / (args.m * args.k):.2%}), y: {args.k}x{args.n}"
+    )
+    print(f"{'op':<12}{'sparse ms':>12}{'dense ms':>12}{'speedup':>10}")
+    for name, sparse_fn, dense_fn in cases:
+        sparse_s = run_op(sparse_fn, args.iters)
+        dense_s = run_op(dense_fn, args.iters)
+        print(
+            f"{name:<12}{sparse_s * 1e3:>12.3f}{dense_s * 1e3:>12.3f}"
+            f"{dense_s / sparse_s:>10.2f}"
+        )
+
+
+if __name__ == "__main__":
+    main()
@@ -101,5 +101,22 @@ class TestAddmm(unittest.TestCase):
         self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'csr')
 
 
+class TestAddmmCPU(TestAddmm):
+    def setUp(self):
+        self.place = paddle.get_device()
+        paddle.set_device('cpu')
+
+    def tearDown(self):
+        paddle.set_device(self.place)
+
+    def test_addmm_2d(self):
+        self.check_result([16, 10], [16, 12], [12, 10], 'coo')
+        self.check_result([16, 10], [16, 12], [12, 10], 'csr')
+
+    def test_addmm_3d(self):
+        self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'coo')
+        self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'csr')
+
+
 if __name__ == "__main__":
     unittest.main()